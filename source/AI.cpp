@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Command.h"
 #include "DistanceMap.h"
 #include "Flotsam.h"
+#include "GameData.h"
 #include "Government.h"
 #include "Hardpoint.h"
 #include "Mask.h"
@@ -25,22 +26,52 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Planet.h"
 #include "PlayerInfo.h"
 #include "Point.h"
+#include "Politics.h"
 #include "Preferences.h"
 #include "Random.h"
 #include "Ship.h"
 #include "ShipEvent.h"
 #include "StellarObject.h"
 #include "System.h"
+#include "ThreadPool.h"
 #include "Weapon.h"
 
 #include <algorithm>
 #include <cmath>
 #include <limits>
 #include <set>
+#include <tuple>
 
 using namespace std;
 
 namespace {
+	// The size of each grid cell used for finding the ships near a given point.
+	const double INDEX_CELL_SIZE = 1024.;
+	// Expensive decisions, like picking a new target, are only made for each
+	// ship once every this many steps (unless something urgent happens).
+	const int THINK_INTERVAL = 32;
+	// Ships in other systems than the player's cannot be seen, so they only
+	// decide what to do once every this many steps.
+	const int OFFSCREEN_INTERVAL = 4;
+
+	// Settings that are checked for every ship, every step.
+	const Preferences::Setting ESCORTS_EXPEND_AMMO("Escorts expend ammo");
+	const Preferences::Setting ESCORTS_FRUGAL("Escorts use ammo frugally");
+	const Preferences::Setting TURRETS_FOCUS_FIRE("Turrets focus fire");
+	const Preferences::Setting FIGHTERS_RETREAT("Damaged fighters retreat");
+	const Preferences::Setting AUTOMATIC_FIRING("Automatic firing");
+	const Preferences::Setting AUTOMATIC_AIMING("Automatic aiming");
+	
+	// Get the step on which the given ship should make its expensive decisions.
+	// This depends only on the ship itself, so ships entering or leaving the
+	// system do not shift the schedule of all the others.
+	int ThinkSlot(const Ship &ship)
+	{
+		uint64_t bits = reinterpret_cast<uintptr_t>(&ship);
+		bits = (bits ^ (bits >> 29)) * 0x9E3779B97F4A7C15ULL;
+		return static_cast<int>(bits >> 58) & (THINK_INTERVAL - 1);
+	}
+	
 	// If the player issues any of those commands, then any auto-pilot actions for the player get cancelled
 	const Command &AutopilotCancelCommands()
 	{
@@ -79,6 +110,35 @@ namespace {
 		return target.IsTargetable();
 	}
 	
+	// Find how many steps it will take a projectile moving at the given speed
+	// to reach a target with the given relative position and velocity, or NaN
+	// if it never will. This has no branches, so that the compiler can run it
+	// on a whole array of targets at once using SIMD instructions.
+	inline double Rendezvous(double px, double py, double vx, double vy, double vp)
+	{
+		// How many steps will it take this projectile
+		// to intersect the target?
+		// (p.x + v.x*t)^2 + (p.y + v.y*t)^2 = vp^2*t^2
+		// p.x^2 + 2*p.x*v.x*t + v.x^2*t^2
+		//    + p.y^2 + 2*p.y*v.y*t + v.y^2t^2
+		//    - vp^2*t^2 = 0
+		// (v.x^2 + v.y^2 - vp^2) * t^2
+		//    + (2 * (p.x * v.x + p.y * v.y)) * t
+		//    + (p.x^2 + p.y^2) = 0
+		double a = (vx * vx + vy * vy) - vp * vp;
+		double b = 2. * (px * vx + py * vy);
+		double c = px * px + py * py;
+		double discriminant = b * b - 4 * a * c;
+		double root = sqrt(max(discriminant, 0.));
+		
+		// The solutions are b +- discriminant.
+		// But it's not a solution if it's negative.
+		double r1 = (-b + root) / (2. * a);
+		double r2 = (-b - root) / (2. * a);
+		double result = (r1 >= 0. && r2 >= 0.) ? min(r1, r2) : max(r1, r2);
+		return (discriminant < 0. || result < 0.) ? numeric_limits<double>::quiet_NaN() : result;
+	}
+	
 	double AngleDiff(double a, double b)
 	{
 		a = abs(a - b);
@@ -209,7 +269,7 @@ namespace {
 	}
 	
 	// Wrapper for ship - target system uses.
-	bool ShouldRefuel(const Ship &ship, const System *to)
+	bool ShouldRefuel(const Ship &ship, const System *to, RouteCache &routes)
 	{
 		if(!to || ship.Fuel() == 1. || !ship.GetSystem()->HasFuelFor(ship))
 			return false;
@@ -223,7 +283,7 @@ namespace {
 		{
 			// If no direct jump route, or the target system has no
 			// fuel, perform a more elaborate refueling check.
-			return ShouldRefuel(ship, DistanceMap(ship, to), fuelCapacity);
+			return ShouldRefuel(ship, routes.Get(ship, to), fuelCapacity);
 		}
 	}
 	
@@ -253,12 +313,12 @@ namespace {
 	
 	// Set the ship's TargetStellar or TargetSystem in order to reach the
 	// next desired system. Will target a landable planet to refuel.
-	void SelectRoute(Ship &ship, const System *targetSystem)
+	void SelectRoute(Ship &ship, const System *targetSystem, RouteCache &routes)
 	{
 		const System *from = ship.GetSystem();
 		if(from == targetSystem || !targetSystem)
 			return;
-		const DistanceMap route(ship, targetSystem);
+		const DistanceMap &route = routes.Get(ship, targetSystem);
 		const bool needsRefuel = ShouldRefuel(ship, route);
 		const System *to = route.Route(from);
 		// The destination may be accessible by both jump and wormhole.
@@ -301,8 +361,8 @@ namespace {
 
 
 
-AI::AI(const List<Ship> &ships, const List<Minable> &minables, const List<Flotsam> &flotsam)
-	: ships(ships), minables(minables), flotsam(flotsam)
+AI::AI(const vector<shared_ptr<Ship>> &ships, const vector<shared_ptr<Minable>> &minables, const List<Flotsam> &flotsam, ThreadPool &workers)
+	: ships(ships), minables(minables), flotsam(flotsam), workers(workers)
 {
 }
 
@@ -338,8 +398,8 @@ void AI::IssueMoveTarget(const PlayerInfo &player, const Point &target, const Sy
 // Commands issued via the keyboard (mostly, to the flagship).
 void AI::UpdateKeys(PlayerInfo &player, Command &activeCommands)
 {
-	escortsUseAmmo = Preferences::Has("Escorts expend ammo");
-	escortsAreFrugal = Preferences::Has("Escorts use ammo frugally");
+	escortsUseAmmo = ESCORTS_EXPEND_AMMO.Has();
+	escortsAreFrugal = ESCORTS_FRUGAL.Has();
 	
 	autoPilot |= activeCommands;
 	if(activeCommands.Has(AutopilotCancelCommands()))
@@ -427,7 +487,7 @@ void AI::UpdateKeys(PlayerInfo &player, Command &activeCommands)
 
 
 
-void AI::UpdateEvents(const list<ShipEvent> &events)
+void AI::UpdateEvents(const vector<ShipEvent> &events)
 {
 	for(const ShipEvent &event : events)
 	{
@@ -435,6 +495,14 @@ void AI::UpdateEvents(const list<ShipEvent> &events)
 		if(!target)
 			continue;
 		
+		// A ship that is attacked should reconsider its target right away
+		// instead of waiting for its turn, and so should a ship that has
+		// just disabled or destroyed its target.
+		if(event.Type() & ShipEvent::PROVOKE)
+			State(*target).mustRethink = true;
+		if(event.Actor() && (event.Type() & (ShipEvent::DISABLE | ShipEvent::DESTROY)))
+			State(*event.Actor()).mustRethink = true;
+		
 		if(event.Actor())
 		{
 			actions[event.Actor()][target] |= event.Type();
@@ -471,14 +539,29 @@ void AI::Clean()
 	governmentActions.clear();
 	scanPermissions.clear();
 	playerActions.clear();
-	swarmCount.clear();
-	fenceCount.clear();
-	miningAngle.clear();
-	miningTime.clear();
-	appeasmentThreshold.clear();
-	shipStrength.clear();
+	// Forget everything about each ship except which ship has been asked to
+	// help it, and return the records that are now empty to the free list.
+	freeStates.clear();
+	for(size_t i = 0; i < shipStates.size(); ++i)
+	{
+		ShipState &state = shipStates[i];
+		if(state.helper.expired())
+		{
+			state = ShipState();
+			freeStates.push_back(i);
+		}
+		else
+		{
+			const Ship *ship = state.ship;
+			weak_ptr<Ship> helper = state.helper;
+			state = ShipState();
+			state.ship = ship;
+			state.helper = helper;
+		}
+	}
 	enemyStrength.clear();
 	allyStrength.clear();
+	tallyStrength.clear();
 }
 
 
@@ -487,7 +570,8 @@ void AI::Clean()
 // when the player lands, but not when they change systems.
 void AI::ClearOrders()
 {
-	helperList.clear();
+	for(ShipState &state : shipStates)
+		state.helper.reset();
 	orders.clear();
 }
 
@@ -502,30 +586,29 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 	CacheShipLists();
 	
 	// Update the counts of how long ships have been outside the "invisible fence."
-	// If a ship ceases to exist, this also ensures that it will be removed from
-	// the fence count map after a few seconds.
-	for(auto it = fenceCount.begin(); it != fenceCount.end(); )
-	{
-		it->second -= FENCE_DECAY;
-		if(it->second < 0)
-			it = fenceCount.erase(it);
-		else
-			++it;
-	}
+	// If a ship ceases to exist, this also ensures that its count will be
+	// cleared after a few seconds.
+	for(ShipState &state : shipStates)
+		if(state.fenceCount >= 0)
+		{
+			state.fenceCount -= FENCE_DECAY;
+			if(state.fenceCount < 0)
+				state.fenceCount = -1;
+		}
 	for(const auto &it : ships)
 		if(it->Position().Length() >= MAX_DISTANCE_FROM_CENTER)
 		{
-			int &value = fenceCount[&*it];
-			value = min(FENCE_MAX, value + FENCE_DECAY + 1);
+			int &value = State(*it).fenceCount;
+			value = min(FENCE_MAX, max(0, value) + FENCE_DECAY + 1);
 		}
 	
 	const Ship *flagship = player.Flagship();
-	step = (step + 1) & 31;
-	int targetTurn = 0;
+	PrefetchRoutes(flagship);
+	step = (step + 1) & (THINK_INTERVAL - 1);
 	int minerCount = 0;
 	const int maxMinerCount = minables.empty() ? 0 : 9;
-	bool opportunisticEscorts = !Preferences::Has("Turrets focus fire");
-	bool fightersRetreat = Preferences::Has("Damaged fighters retreat");
+	bool opportunisticEscorts = !TURRETS_FOCUS_FIRE.Has();
+	bool fightersRetreat = FIGHTERS_RETREAT.Has();
 	for(const auto &it : ships)
 	{
 		// Skip any carried fighters or drones that are somehow in the list.
@@ -546,6 +629,18 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 		bool isPresent = (it->GetSystem() == playerSystem);
 		bool isStranded = IsStranded(*it);
 		bool thisIsLaunching = (isPresent && HasDeployments(*it));
+		// NPCs in other systems keep following their previous commands in
+		// between the steps where they get to think. A partial turn would
+		// carry them past the heading they were aiming for, so drop it.
+		if(!isPresent && !it->IsYours()
+				&& (ThinkSlot(*it) & (OFFSCREEN_INTERVAL - 1)) != (step & (OFFSCREEN_INTERVAL - 1)))
+		{
+			Command command = it->Commands();
+			if(fabs(command.Turn()) < 1.)
+				command.SetTurn(0.);
+			it->SetCommands(command);
+			continue;
+		}
 		if(isStranded || it->IsDisabled())
 		{
 			// Derelicts never ask for help (only the player should repair them).
@@ -567,7 +662,7 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 				if(personality.IsAppeasing())
 				{
 					double health = .5 * it->Shields() + it->Hull();
-					double &threshold = appeasmentThreshold[it.get()];
+					double &threshold = State(*it).appeasementThreshold;
 					threshold = max((1. - health) + .1, threshold);
 				}
 				continue;
@@ -620,15 +715,18 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 		{
 			// Each ship only switches targets twice a second, so that it can
 			// focus on damaging one particular ship.
-			targetTurn = (targetTurn + 1) & 31;
-			if(targetTurn == step || !target || target->IsDestroyed() || (target->IsDisabled()
+			const ShipState *state = FindState(*it);
+			if(ThinkSlot(*it) == step || (state && state->mustRethink) || !target || target->IsDestroyed() || (target->IsDisabled()
 					&& personality.Disables()) || !target->IsTargetable())
 				it->SetTargetShip(FindTarget(*it));
 		}
+		// Turrets and weapons are taken care of once all ships have moved.
 		if(isPresent)
 		{
-			AimTurrets(*it, command, it->IsYours() ? opportunisticEscorts : personality.IsOpportunistic());
-			AutoFire(*it, command);
+			turretJobs.emplace_back();
+			turretJobs.back().ship = it.get();
+			turretJobs.back().opportunistic = it->IsYours() ? opportunisticEscorts : personality.IsOpportunistic();
+			turretJobs.back().previous = it->Commands();
 		}
 		
 		// If this ship is hyperspacing, or in the act of
@@ -652,7 +750,7 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 			if(personality.IsAppeasing() && it->Cargo().Used())
 			{
 				double health = .5 * it->Shields() + it->Hull();
-				double &threshold = appeasmentThreshold[it.get()];
+				double &threshold = State(*it).appeasementThreshold;
 				if(1. - health > threshold)
 				{
 					int toDump = 11 + (1. - health) * .5 * it->Cargo().Size();
@@ -741,7 +839,7 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 			// Miners with free cargo space and available mining time should mine. Mission NPCs
 			// should mine even if there are other miners or they have been mining a while.
 			if(it->Cargo().Free() >= 5 && IsArmed(*it) && (it->IsSpecial()
-					|| (++miningTime[&*it] < 3600 && ++minerCount < maxMinerCount)))
+					|| (++State(*it).miningTime < 3600 && ++minerCount < maxMinerCount)))
 			{
 				if(it->HasBays())
 				{
@@ -755,7 +853,7 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 			// Fighters and drones should assist their parent's mining operation if they cannot
 			// carry ore, and the asteroid is near enough that the parent can harvest the ore.
 			const shared_ptr<Minable> &minable = parent ? parent->GetTargetAsteroid() : nullptr;
-			if(it->CanBeCarried() && parent && miningTime[&*parent] < 3601 && minable
+			if(it->CanBeCarried() && parent && State(*parent).miningTime < 3601 && minable
 					&& minable->Position().Distance(parent->Position()) < 600.)
 			{
 				it->SetTargetAsteroid(minable);
@@ -780,17 +878,16 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 				// Find the possible parents for orphaned fighters and drones.
 				auto parentChoices = vector<shared_ptr<Ship>>{};
 				parentChoices.reserve(ships.size() * .1);
-				auto getParentFrom = [&it, &gov, &parentChoices](const list<shared_ptr<Ship>> otherShips) -> shared_ptr<Ship>
+				auto isNewParent = [&it, &gov, &parentChoices](const shared_ptr<Ship> &other) -> bool
 				{
-					for(const auto &other : otherShips)
-						if(other->GetGovernment() == gov && other->GetSystem() == it->GetSystem() && !other->CanBeCarried())
-						{
-							if(!other->IsDisabled() && other->CanCarry(*it.get()))
-								return other;
-							else
-								parentChoices.emplace_back(other);
-						}
-					return shared_ptr<Ship>();
+					if(other->GetGovernment() == gov && other->GetSystem() == it->GetSystem() && !other->CanBeCarried())
+					{
+						if(!other->IsDisabled() && other->CanCarry(*it.get()))
+							return true;
+						else
+							parentChoices.emplace_back(other);
+					}
+					return false;
 				};
 				// Mission ships should only pick amongst ships from the same mission.
 				auto missionIt = it->IsSpecial() && !it->IsYours()
@@ -804,13 +901,23 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 					auto &npcs = missionIt->NPCs();
 					for(const auto &npc : npcs)
 					{
-						newParent = getParentFrom(npc.Ships());
+						for(const auto &other : npc.Ships())
+							if(isNewParent(other))
+							{
+								newParent = other;
+								break;
+							}
 						if(newParent)
 							break;
 					}
 				}
 				else
-					newParent = getParentFrom(ships);
+					for(const auto &other : ships)
+						if(isNewParent(other))
+						{
+							newParent = other;
+							break;
+						}
 				
 				// If a new parent was found, then this carried ship should always reparent
 				// as a ship of its own government is in-system and has space to carry it.
@@ -941,6 +1048,22 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 		
 		it->SetCommands(command);
 	}
+	// Every ship has now had its chance to respond to last step's events.
+	for(ShipState &state : shipStates)
+		state.mustRethink = false;
+	
+	// Now, aim turrets and fire weapons for all the ships that are present.
+	// The slow part of that can be split up between all available threads,
+	// but anything random must be done in order, in this thread.
+	workers.ForEach(turretJobs.size(), [this](size_t i) { RunTurretJob(turretJobs[i]); });
+	for(TurretJob &job : turretJobs)
+	{
+		if(job.shouldSweep)
+			SweepTurrets(*job.ship, job.command);
+		job.command |= job.movement;
+		job.ship->SetCommands(job.command);
+	}
+	turretJobs.clear();
 }
 
 
@@ -970,11 +1093,8 @@ bool AI::CanPursue(const Ship &ship, const Ship &target) const
 		return true;
 	
 	// Check if the target is beyond the "invisible fence" for this system.
-	const auto fit = fenceCount.find(&target);
-	if(fit == fenceCount.end())
-		return true;
-	else
-		return (fit->second != FENCE_MAX);
+	const ShipState *state = FindState(target);
+	return (!state || state->fenceCount != FENCE_MAX);
 }
 
 
@@ -1034,7 +1154,7 @@ void AI::AskForHelp(Ship &ship, bool &isStranded, const Ship *flagship)
 		{
 			Ship *helper = canHelp[Random::Int(canHelp.size())];
 			helper->SetShipToAssist((&ship)->shared_from_this());
-			helperList[&ship] = helper->shared_from_this();
+			State(ship).helper = helper->shared_from_this();
 			isStranded = true;
 		}
 		else
@@ -1072,13 +1192,14 @@ bool AI::CanHelp(const Ship &ship, const Ship &helper, const bool needsFuel)
 bool AI::HasHelper(const Ship &ship, const bool needsFuel)
 {
 	// Do we have an existing ship that was asked to assist?
-	if(helperList.find(&ship) != helperList.end())
+	const ShipState *state = FindState(ship);
+	shared_ptr<Ship> helper = state ? state->helper.lock() : nullptr;
+	if(helper)
 	{
-		shared_ptr<Ship> helper = helperList[&ship].lock();
-		if(helper && helper->GetShipToAssist().get() == &ship && CanHelp(ship, *helper, needsFuel))
+		if(helper->GetShipToAssist().get() == &ship && CanHelp(ship, *helper, needsFuel))
 			return true;
 		else
-			helperList.erase(&ship);
+			State(ship).helper.reset();
 	}
 	
 	return false;
@@ -1145,9 +1266,9 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 	bool canPlunder = person.Plunders() && ship.Cargo().Free();
 	// Figure out how strong this ship is.
 	int64_t maxStrength = 0;
-	auto strengthIt = shipStrength.find(&ship);
-	if(!person.IsHeroic() && strengthIt != shipStrength.end())
-		maxStrength = 2 * strengthIt->second;
+	const ShipState *state = FindState(ship);
+	if(!person.IsHeroic() && state)
+		maxStrength = 2 * state->strength;
 	
 	// Get a list of all targetable, hostile ships in this system.
 	const auto enemies = GetShipsList(ship, true);
@@ -1167,19 +1288,19 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 		double range = (foe->Position() + 60. * foe->Velocity()).Distance(
 			ship.Position() + 60. * ship.Velocity());
 		// Prefer the previous target, or the parent's target, if they are nearby.
-		if(foe == oldTarget || foe == parentTarget)
+		if(foe == oldTarget.get() || foe == parentTarget.get())
 			range -= 500.;
 		
 		// Unless this ship is "heroic", it should not chase much stronger ships.
 		if(maxStrength && range > 1000. && !foe->IsDisabled())
 		{
-			const auto otherStrengthIt = shipStrength.find(foe.get());
-			if(otherStrengthIt != shipStrength.end() && otherStrengthIt->second > maxStrength)
+			const ShipState *foeState = FindState(*foe);
+			if(foeState && foeState->strength > maxStrength)
 				continue;
 		}
 		
 		// Ships which only disable never target already-disabled ships.
-		if((person.Disables() || (!person.IsNemesis() && foe != oldTarget))
+		if((person.Disables() || (!person.IsNemesis() && foe != oldTarget.get()))
 				&& foe->IsDisabled() && !canPlunder)
 			continue;
 		
@@ -1188,7 +1309,7 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 			range += 5000. * foe->IsDisabled();
 		// While those that do, do so only if no "live" enemies are nearby.
 		else
-			range += 2000. * (2 * foe->IsDisabled() - !Has(ship, foe, ShipEvent::BOARD));
+			range += 2000. * (2 * foe->IsDisabled() - !Has(ship, foe->shared_from_this(), ShipEvent::BOARD));
 		
 		// Prefer to go after armed targets, especially if you're not a pirate.
 		range += 1000. * (!IsArmed(*foe) * (1 + !person.Plunders()));
@@ -1202,7 +1323,7 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 		if((isPotentialNemesis && !hasNemesis) || range < closest)
 		{
 			closest = range;
-			target = foe;
+			target = foe->shared_from_this();
 			isDisabled = foe->IsDisabled();
 			hasNemesis = isPotentialNemesis;
 		}
@@ -1222,15 +1343,16 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 				if(it->GetGovernment() != gov)
 				{
 					// Scan friendly ships that are as-yet unscanned by this ship's government.
-					if((!cargoScan || Has(gov, it, ShipEvent::SCAN_CARGO))
-							&& (!outfitScan || Has(gov, it, ShipEvent::SCAN_OUTFITS)))
+					shared_ptr<Ship> other = it->shared_from_this();
+					if((!cargoScan || Has(gov, other, ShipEvent::SCAN_CARGO))
+							&& (!outfitScan || Has(gov, other, ShipEvent::SCAN_OUTFITS)))
 						continue;
 					
 					double range = it->Position().Distance(ship.Position());
 					if(range < closest)
 					{
 						closest = range;
-						target = it;
+						target = other;
 					}
 				}
 		}
@@ -1274,30 +1396,28 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 // Return a list of all targetable ships in the same system as the player that
 // match the desired hostility (i.e. enemy or non-enemy). Does not consider the
 // ship's current target, as its inclusion may or may not be desired.
-vector<shared_ptr<Ship>> AI::GetShipsList(const Ship &ship, bool targetEnemies, double maxRange) const
+FrameVector<Ship *> AI::GetShipsList(const Ship &ship, bool targetEnemies, double maxRange) const
 {
-	if(maxRange < 0.)
-		maxRange = numeric_limits<double>::infinity();
+	FrameVector<Ship *> targets;
 	
-	auto targets = vector<shared_ptr<Ship>>();
-	
-	// The cached lists are built each step based on the current ships in the player's system.
+	// The cached lists are built each step based on the current ships in the
+	// player's system, and only hold ships that are targetable and are not
+	// jumping out of the system.
 	const auto &rosters = targetEnemies ? enemyLists : allyLists;
 	
 	const auto it = rosters.find(ship.GetGovernment());
-	if(it != rosters.end() && !it->second.empty())
+	if(it != rosters.end())
 	{
-		targets.reserve(it->second.size());
+		it->second.Find(ship.Position(), maxRange, targets);
 		
 		const System *here = ship.GetSystem();
-		const Point &p = ship.Position();
-		for(const auto &target : it->second)
-			if(target->IsTargetable() && target->GetSystem() == here
-					&& !(target->IsHyperspacing() && target->Velocity().Length() > 10.)
-					&& p.Distance(target->Position()) < maxRange
-					&& (ship.IsYours() || !target->GetPersonality().IsMarked())
-					&& (target->IsYours() || !ship.GetPersonality().IsMarked()))
-				targets.emplace_back(target);
+		auto isExcluded = [&ship, here](const Ship *target) -> bool
+		{
+			return target->GetSystem() != here
+				|| (!ship.IsYours() && target->GetPersonality().IsMarked())
+				|| (!target->IsYours() && ship.GetPersonality().IsMarked());
+		};
+		targets.erase(remove_if(targets.begin(), targets.end(), isExcluded), targets.end());
 	}
 	
 	return targets;
@@ -1330,7 +1450,7 @@ bool AI::FollowOrders(Ship &ship, Command &command) const
 		// The desired position is in a different system. Find the best
 		// way to reach that system (via wormhole or jumping). This may
 		// result in the ship landing to refuel.
-		SelectRoute(ship, it->second.targetSystem);
+		SelectRoute(ship, it->second.targetSystem, routes);
 		
 		// Travel there even if your parent is not planning to travel.
 		if(ship.GetTargetSystem())
@@ -1446,7 +1566,7 @@ void AI::MoveIndependent(Ship &ship, Command &command) const
 		
 		vector<int> systemWeights;
 		int totalWeight = 0;
-		const set<const System *> &links = ship.Attributes().Get("jump drive")
+		const FlatSet<const System *> &links = ship.Attributes().Get("jump drive")
 			? origin->JumpNeighbors(ship.JumpRange()) : origin->Links();
 		if(jumps)
 		{
@@ -1492,7 +1612,7 @@ void AI::MoveIndependent(Ship &ship, Command &command) const
 			planets.push_back(&origin->Objects().front());
 		}
 		
-		set<const System *>::const_iterator it = links.begin();
+		FlatSet<const System *>::const_iterator it = links.begin();
 		int choice = Random::Int(totalWeight);
 		if(choice < systemTotalWeight)
 		{
@@ -1515,7 +1635,7 @@ void AI::MoveIndependent(Ship &ship, Command &command) const
 	// Choose the best method of reaching the target system, which may mean
 	// using a local wormhole rather than jumping. If this ship has chosen
 	// to land, this decision will not be altered.
-	SelectRoute(ship, ship.GetTargetSystem());
+	SelectRoute(ship, ship.GetTargetSystem(), routes);
 	
 	if(ship.GetTargetSystem())
 	{
@@ -1574,7 +1694,7 @@ void AI::MoveEscort(Ship &ship, Command &command) const
 		{
 			// Route to the parent ship's system and check whether
 			// the ship should land (refuel or wormhole) or jump.
-			SelectRoute(ship, parent.GetSystem());
+			SelectRoute(ship, parent.GetSystem(), routes);
 		}
 		
 		// Perform the action that this ship previously decided on.
@@ -1602,13 +1722,12 @@ void AI::MoveEscort(Ship &ship, Command &command) const
 	// If the parent is in-system and planning to jump, non-staying escorts should follow suit.
 	else if(parent.Commands().Has(Command::JUMP) && parent.GetTargetSystem() && !isStaying)
 	{
-		DistanceMap distance(ship, parent.GetTargetSystem());
-		const System *dest = distance.Route(ship.GetSystem());
+		const System *dest = routes.Get(ship, parent.GetTargetSystem()).Route(ship.GetSystem());
 		ship.SetTargetSystem(dest);
 		if(!dest)
 			// This ship has no route to the parent's destination system, so protect it until it jumps away.
 			KeepStation(ship, command, parent);
-		else if(ShouldRefuel(ship, dest))
+		else if(ShouldRefuel(ship, dest, routes))
 			Refuel(ship, command);
 		else if(!ship.JumpsRemaining())
 			// Return to the system center to maximize solar collection rate.
@@ -1706,7 +1825,7 @@ bool AI::ShouldDock(const Ship &ship, const Ship &parent, const System *playerSy
 	// If a carried ship has repair abilities, avoid having it get stuck oscillating between
 	// retreating and attacking when at exactly 25% health by adding hysteresis to the check.
 	double minHealth = RETREAT_HEALTH + .1 * !ship.Commands().Has(Command::DEPLOY);
-	if(ship.Health() < minHealth && (!ship.IsYours() || Preferences::Has("Damaged fighters retreat")))
+	if(ship.Health() < minHealth && (!ship.IsYours() || FIGHTERS_RETREAT.Has()))
 		return true;
 	
 	// TODO: Reboard if in need of ammo.
@@ -2220,9 +2339,9 @@ void AI::DoSwarming(Ship &ship, Command &command, shared_ptr<Ship> &target)
 		if(target)
 		{
 			// Allow another swarming ship to consider the target.
-			auto sit = swarmCount.find(target.get());
-			if(sit != swarmCount.end() && sit->second > 0)
-				--sit->second;
+			int &count = State(*target).swarmCount;
+			if(count > 0)
+				--count;
 			// Release the current target.
 			target.reset();
 			ship.SetTargetShip(target);
@@ -2234,20 +2353,21 @@ void AI::DoSwarming(Ship &ship, Command &command, shared_ptr<Ship> &target)
 		int lowestCount = 7;
 		// Consider swarming around non-hostile ships in the same system.
 		const auto others = GetShipsList(ship, false);
-		for(const shared_ptr<Ship> &other : others)
+		for(Ship *other : others)
 			if(!other->GetPersonality().IsSwarming())
 			{
 				// Prefer to swarm ships that are not already being heavily swarmed.
-				int count = swarmCount[other.get()] + Random::Int(4);
+				const ShipState *otherState = FindState(*other);
+				int count = (otherState ? otherState->swarmCount : 0) + Random::Int(4);
 				if(count < lowestCount)
 				{
-					target = other;
+					target = other->shared_from_this();
 					lowestCount = count;
 				}
 			}
 		ship.SetTargetShip(target);
 		if(target)
-			++swarmCount[target.get()];
+			++State(*target).swarmCount;
 	}
 	// If a friendly ship to flock with was not found, return to an available planet.
 	if(target)
@@ -2384,10 +2504,13 @@ void AI::DoMining(Ship &ship, Command &command)
 {
 	// This function is only called for ships that are in the player's system.
 	// Update the radius that the ship is searching for asteroids at.
-	bool isNew = !miningAngle.count(&ship);
-	Angle &angle = miningAngle[&ship];
-	if(isNew)
+	ShipState &state = State(ship);
+	Angle &angle = state.miningAngle;
+	if(!state.isMining)
+	{
 		angle = Angle::Random();
+		state.isMining = true;
+	}
 	angle += Angle::Random(1.) - Angle::Random(1.);
 	double miningRadius = ship.GetSystem()->AsteroidBelt() * pow(2., angle.Unit().X());
 	
@@ -2521,9 +2644,9 @@ bool AI::DoCloak(Ship &ship, Command &command)
 		// Otherwise, always cloak if you are in imminent danger.
 		static const double MAX_RANGE = 10000.;
 		double range = MAX_RANGE;
-		shared_ptr<const Ship> nearestEnemy;
+		const Ship *nearestEnemy = nullptr;
 		// Find the nearest targetable, in-system enemy that could attack this ship.
-		const auto enemies = GetShipsList(ship, true);
+		const auto enemies = GetShipsList(ship, true, MAX_RANGE);
 		for(const auto &foe : enemies)
 			if(!foe->IsDisabled())
 			{
@@ -2553,7 +2676,8 @@ bool AI::DoCloak(Ship &ship, Command &command)
 				// TODO: This could use an "Avoid" method, to account for other in-system hazards.
 				// Simple approximation: move equally away from both the system center and the
 				// nearest enemy, until the constrainment boundary is reached.
-				if(ship.GetPersonality().IsUnconstrained() || !fenceCount.count(&ship))
+				const ShipState *state = FindState(ship);
+				if(ship.GetPersonality().IsUnconstrained() || !state || state->fenceCount < 0)
 					safety = 2 * ship.Position().Unit() - nearestEnemy->Position().Unit();
 				else
 					safety = -ship.Position().Unit();
@@ -2707,9 +2831,19 @@ Point AI::TargetAim(const Ship &ship, const Body &target)
 
 // Aim the given ship's turrets.
 void AI::AimTurrets(const Ship &ship, Command &command, bool opportunistic) const
+{
+	if(!AimTurretsAtTargets(ship, command, opportunistic))
+		SweepTurrets(ship, command);
+}
+
+
+
+// Aim the given ship's turrets at whatever they can shoot at, unless they
+// have nothing to aim at and should sweep back and forth instead.
+bool AI::AimTurretsAtTargets(const Ship &ship, Command &command, bool opportunistic) const
 {
 	// First, get the set of potential hostile ships.
-	auto targets = vector<const Body *>();
+	auto targets = FrameVector<const Body *>();
 	const Ship *currentTarget = ship.GetTargetShip().get();
 	if(opportunistic || !currentTarget || !currentTarget->IsTargetable())
 	{
@@ -2720,17 +2854,17 @@ void AI::AimTurrets(const Ship &ship, Command &command, bool opportunistic) cons
 				maxRange = max(maxRange, weapon.GetOutfit()->Range());
 		// If this ship has no turrets, bail out.
 		if(!maxRange)
-			return;
+			return true;
 		// Extend the weapon range slightly to account for velocity differences.
 		maxRange *= 1.5;
 		
 		// Now, find all enemy ships within that radius.
 		auto enemies = GetShipsList(ship, true, maxRange);
-		// Convert the shared_ptr<Ship> into const Body *, to allow aiming turrets
+		// Convert the Ship pointers into const Body *, to allow aiming turrets
 		// at a targeted asteroid. Skip disabled ships, which pose no threat.
-		for(auto &&foe : enemies)
+		for(Ship *foe : enemies)
 			if(!foe->IsDisabled())
-				targets.emplace_back(foe.get());
+				targets.emplace_back(foe);
 		// Even if the ship's current target ship is beyond maxRange,
 		// or is already disabled, consider aiming at it.
 		if(currentTarget && currentTarget->IsTargetable()
@@ -2756,28 +2890,27 @@ void AI::AimTurrets(const Ship &ship, Command &command, bool opportunistic) cons
 				double offset = (hardpoint.HarmonizedAngle() - hardpoint.GetAngle()).Degrees();
 				command.SetAim(index, offset / hardpoint.GetOutfit()->TurretTurn());
 			}
-		return;
+		return true;
 	}
 	if(targets.empty())
+		return false;
+	
+	// Gather the targets' positions and velocities into separate arrays, so
+	// that each turret's intercept times for all of them can be found at once.
+	size_t count = targets.size();
+	FrameVector<double> targetX(count);
+	FrameVector<double> targetY(count);
+	FrameVector<double> targetVX(count);
+	FrameVector<double> targetVY(count);
+	FrameVector<double> times(count);
+	for(size_t i = 0; i < count; ++i)
 	{
-		for(const Hardpoint &hardpoint : ship.Weapons())
-			if(hardpoint.CanAim())
-			{
-				// Get the index of this weapon.
-				int index = &hardpoint - &ship.Weapons().front();
-				// First, check if this turret is currently in motion. If not,
-				// it only has a small chance of beginning to move.
-				double previous = ship.Commands().Aim(index);
-				if(!previous && (Random::Int(60)))
-					continue;
-				
-				Angle centerAngle = Angle(hardpoint.GetPoint());
-				double bias = (centerAngle - hardpoint.GetAngle()).Degrees() / 180.;
-				double acceleration = Random::Real() - Random::Real() + bias;
-				command.SetAim(index, previous + .1 * acceleration);
-			}
-		return;
+		targetX[i] = targets[i]->Position().X();
+		targetY[i] = targets[i]->Position().Y();
+		targetVX[i] = targets[i]->Velocity().X();
+		targetVY[i] = targets[i]->Velocity().Y();
 	}
+	
 	// Each hardpoint should aim at the target that it is "closest" to hitting.
 	for(const Hardpoint &hardpoint : ship.Weapons())
 		if(hardpoint.CanAim())
@@ -2791,41 +2924,57 @@ void AI::AimTurrets(const Ship &ship, Command &command, bool opportunistic) cons
 			// Get this projectile's average velocity.
 			const Weapon *weapon = hardpoint.GetOutfit();
 			double vp = weapon->WeightedVelocity() + .5 * weapon->RandomVelocity();
+			// Only take the ship's velocity into account if this weapon
+			// does not have its own acceleration.
+			Point shipVelocity = weapon->Acceleration() ? Point() : ship.Velocity();
+			
+			// Find out how long it would take for this projectile to reach each
+			// target. By the time this action is performed, the targets will
+			// have moved forward one time step.
+			const double startX = start.X();
+			const double startY = start.Y();
+			const double shipVX = shipVelocity.X();
+			const double shipVY = shipVelocity.Y();
+			for(size_t i = 0; i < count; ++i)
+			{
+				double vx = targetVX[i] - shipVX;
+				double vy = targetVY[i] - shipVY;
+				times[i] = Rendezvous(targetX[i] - startX + vx, targetY[i] - startY + vy, vx, vy, vp);
+			}
+			
 			// Loop through each body this hardpoint could shoot at. Find the
 			// one that is the "best" in terms of how many frames it will take
 			// to aim at it and for a projectile to hit it.
 			double bestScore = numeric_limits<double>::infinity();
 			double bestAngle = 0.;
-			for(const Body *target : targets)
+			for(size_t i = 0; i < count; ++i)
 			{
-				Point p = target->Position() - start;
-				Point v = target->Velocity();
-				// Only take the ship's velocity into account if this weapon
-				// does not have its own acceleration.
-				if(!weapon->Acceleration())
-					v -= ship.Velocity();
-				// By the time this action is performed, the target will
-				// have moved forward one time step.
-				p += v;
+				Point v = targets[i]->Velocity() - shipVelocity;
+				Point p = targets[i]->Position() - start + v;
 				
-				// Find out how long it would take for this projectile to reach the target.
-				double rendezvousTime = RendezvousTime(p, v, vp);
+				double rendezvousTime = times[i];
 				// If there is no intersection (i.e. the turret is not facing the target),
 				// consider this target "out-of-range" but still targetable.
 				if(std::isnan(rendezvousTime))
 					rendezvousTime = max(p.Length() / (vp ? vp : 1.), 2 * weapon->TotalLifetime());
 				
+				// All bodies within weapons range have the same basic
+				// weight. Outside that range, give them lower priority.
+				double rangePenalty = (180. / weapon->TurretTurn())
+					* max(0., rendezvousTime - weapon->TotalLifetime());
+				// Turning toward the target can only add to that, so skip any
+				// target that cannot beat the best one found so far.
+				if(rangePenalty >= bestScore)
+					continue;
+				
 				// Determine where the target will be at that point.
 				p += v * rendezvousTime;
 				
 				// Determine how much the turret must turn to face that vector.
 				double degrees = (Angle(p) - aim).Degrees();
 				double turnTime = fabs(degrees) / weapon->TurretTurn();
-				// All bodies within weapons range have the same basic
-				// weight. Outside that range, give them lower priority.
-				rendezvousTime = max(0., rendezvousTime - weapon->TotalLifetime());
 				// Always prefer targets that you are able to hit.
-				double score = turnTime + (180. / weapon->TurretTurn()) * rendezvousTime;
+				double score = turnTime + rangePenalty;
 				if(score < bestScore)
 				{
 					bestScore = score;
@@ -2839,6 +2988,31 @@ void AI::AimTurrets(const Ship &ship, Command &command, bool opportunistic) cons
 				command.SetAim(index, bestAngle / weapon->TurretTurn());
 			}
 		}
+	return true;
+}
+
+
+
+// Sweep opportunistic turrets back and forth at random, with the sweep
+// centered on the "outward-facing" angle.
+void AI::SweepTurrets(const Ship &ship, Command &command)
+{
+	for(const Hardpoint &hardpoint : ship.Weapons())
+		if(hardpoint.CanAim())
+		{
+			// Get the index of this weapon.
+			int index = &hardpoint - &ship.Weapons().front();
+			// First, check if this turret is currently in motion. If not,
+			// it only has a small chance of beginning to move.
+			double previous = ship.Commands().Aim(index);
+			if(!previous && (Random::Int(60)))
+				continue;
+			
+			Angle centerAngle = Angle(hardpoint.GetPoint());
+			double bias = (centerAngle - hardpoint.GetAngle()).Degrees() / 180.;
+			double acceleration = Random::Real() - Random::Real() + bias;
+			command.SetAim(index, previous + .1 * acceleration);
+		}
 }
 
 
@@ -2909,8 +3083,8 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 	// Consider the current target if it is not already considered (i.e. it
 	// is a friendly ship and this is a player ship ordered to attack it).
 	if(currentTarget && currentTarget->IsTargetable()
-			&& find(enemies.cbegin(), enemies.cend(), currentTarget) == enemies.cend())
-		enemies.push_back(currentTarget);
+			&& find(enemies.cbegin(), enemies.cend(), currentTarget.get()) == enemies.cend())
+		enemies.push_back(currentTarget.get());
 	
 	int index = -1;
 	for(const Hardpoint &hardpoint : ship.Weapons())
@@ -2993,7 +3167,7 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 		for(const auto &target : enemies)
 		{
 			// NPCs shoot ships that they just plundered.
-			bool hasBoarded = !ship.IsYours() && Has(ship, target, ShipEvent::BOARD);
+			bool hasBoarded = !ship.IsYours() && Has(ship, target->shared_from_this(), ShipEvent::BOARD);
 			if(target->IsDisabled() && (disables || (plunders && !hasBoarded)) && !disabledOverride)
 				continue;
 			
@@ -3017,7 +3191,7 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 			// Extrapolate over the lifetime of the projectile.
 			v *= lifetime;
 			
-			const Mask &mask = target->GetMask(step);
+			const Mask &mask = target->GetMask();
 			if(mask.Collide(-p, v, target->Facing()) < 1.)
 			{
 				command.SetFire(index);
@@ -3063,7 +3237,7 @@ void AI::AutoFire(const Ship &ship, Command &command, const Body &target) const
 		// Extrapolate over the lifetime of the projectile.
 		v *= lifetime;
 		
-		const Mask &mask = target.GetMask(step);
+		const Mask &mask = target.GetMask();
 		if(mask.Collide(-p, v, target.Facing()) < 1.)
 			command.SetFire(index);
 	}
@@ -3071,40 +3245,28 @@ void AI::AutoFire(const Ship &ship, Command &command, const Body &target) const
 
 
 
+// Aim the turrets and pick the weapons to fire for one ship. This may be called
+// for many ships in parallel, so it must only modify the given ship.
+void AI::RunTurretJob(TurretJob &job) const
+{
+	// The movement commands for this step have already been given to the ship,
+	// but its aim and fire decisions are based on what it was doing last step.
+	job.movement = job.ship->Commands();
+	job.ship->SetCommands(job.previous);
+	
+	job.shouldSweep = !AimTurretsAtTargets(*job.ship, job.command, job.opportunistic);
+	AutoFire(*job.ship, job.command);
+}
+
+
+
 // Get the amount of time it would take the given weapon to reach the given
 // target, assuming it can be fired in any direction (i.e. turreted). For
 // non-turreted weapons this can be used to calculate the ideal direction to
 // point the ship in.
 double AI::RendezvousTime(const Point &p, const Point &v, double vp)
 {
-	// How many steps will it take this projectile
-	// to intersect the target?
-	// (p.x + v.x*t)^2 + (p.y + v.y*t)^2 = vp^2*t^2
-	// p.x^2 + 2*p.x*v.x*t + v.x^2*t^2
-	//    + p.y^2 + 2*p.y*v.y*t + v.y^2t^2
-	//    - vp^2*t^2 = 0
-	// (v.x^2 + v.y^2 - vp^2) * t^2
-	//    + (2 * (p.x * v.x + p.y * v.y)) * t
-	//    + (p.x^2 + p.y^2) = 0
-	double a = v.Dot(v) - vp * vp;
-	double b = 2. * p.Dot(v);
-	double c = p.Dot(p);
-	double discriminant = b * b - 4 * a * c;
-	if(discriminant < 0.)
-		return numeric_limits<double>::quiet_NaN();
-
-	discriminant = sqrt(discriminant);
-
-	// The solutions are b +- discriminant.
-	// But it's not a solution if it's negative.
-	double r1 = (-b + discriminant) / (2. * a);
-	double r2 = (-b - discriminant) / (2. * a);
-	if(r1 >= 0. && r2 >= 0.)
-		return min(r1, r2);
-	else if(r1 >= 0. || r2 >= 0.)
-		return max(r1, r2);
-
-	return numeric_limits<double>::quiet_NaN();
+	return Rendezvous(p.X(), p.Y(), v.X(), v.Y(), vp);
 }
 
 
@@ -3462,8 +3624,8 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 		command |= Command::SCAN;
 	
 	const shared_ptr<const Ship> target = ship.GetTargetShip();
-	AimTurrets(ship, command, !Preferences::Has("Turrets focus fire"));
-	if(Preferences::Has("Automatic firing") && !ship.IsBoarding()
+	AimTurrets(ship, command, !TURRETS_FOCUS_FIRE.Has());
+	if(AUTOMATIC_FIRING.Has() && !ship.IsBoarding()
 			&& !(autoPilot | activeCommands).Has(Command::LAND | Command::JUMP | Command::BOARD)
 			&& (!target || target->GetGovernment()->IsEnemy()))
 		AutoFire(ship, command, false);
@@ -3508,8 +3670,8 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 			autoPilot = activeCommands;
 	}
 	bool shouldAutoAim = false;
-	if(Preferences::Has("Automatic aiming") && !command.Turn() && !ship.IsBoarding()
-			&& (Preferences::Has("Automatic firing") || activeCommands.Has(Command::PRIMARY))
+	if(AUTOMATIC_AIMING.Has() && !command.Turn() && !ship.IsBoarding()
+			&& (AUTOMATIC_FIRING.Has() || activeCommands.Has(Command::PRIMARY))
 			&& ((target && target->GetSystem() == ship.GetSystem() && target->IsTargetable())
 				|| ship.GetTargetAsteroid())
 			&& !autoPilot.Has(Command::LAND | Command::JUMP | Command::BOARD))
@@ -3608,7 +3770,7 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 	if(ship.HasBays() && HasDeployments(ship))
 	{
 		command |= Command::DEPLOY;
-		Deploy(ship, !Preferences::Has("Damaged fighters retreat"));
+		Deploy(ship, !FIGHTERS_RETREAT.Has());
 	}
 	if(isCloaking)
 		command |= Command::CLOAK;
@@ -3667,8 +3829,11 @@ bool AI::Has(const Ship &ship, const Government *government, int type) const
 
 void AI::UpdateStrengths(map<const Government *, int64_t> &strength, const System *playerSystem)
 {
-	// Tally the strength of a government by the cost of its present and able ships.
-	governmentRosters.clear();
+	// Tally the strength of a government by the cost of its present and able
+	// ships. The rosters are refilled in place, to reuse their memory, and
+	// any government that no longer has ships here is then removed.
+	for(auto &it : governmentRosters)
+		it.second.clear();
 	for(const auto &it : ships)
 		if(it->GetGovernment() && it->GetSystem() == playerSystem)
 		{
@@ -3676,26 +3841,41 @@ void AI::UpdateStrengths(map<const Government *, int64_t> &strength, const Syste
 			if(!it->IsDisabled())
 				strength[it->GetGovernment()] += it->Cost();
 		}
+	for(auto it = governmentRosters.begin(); it != governmentRosters.end(); )
+	{
+		if(it->second.empty())
+			it = governmentRosters.erase(it);
+		else
+			++it;
+	}
 	
-	// Strengths of enemies and allies are rebuilt every step.
-	enemyStrength.clear();
-	allyStrength.clear();
-	for(const auto &gov : strength)
+	// The strengths of each government's enemies and allies only change when
+	// a ship arrives, leaves, is destroyed, disabled, or captured, or when the
+	// governments' relationships change. Otherwise, last step's are still good.
+	uint64_t revision = GameData::GetPolitics().Revision();
+	if(strength != tallyStrength || revision != tallyRevision)
 	{
-		set<const Government *> allies;
-		for(const auto &enemy : strength)
-			if(enemy.first->IsEnemy(gov.first))
-			{
-				// "Know your enemies."
-				enemyStrength[gov.first] += enemy.second;
-				for(const auto &ally : strength)
-					if(ally.first->IsEnemy(enemy.first) && !allies.count(ally.first))
-					{
-						// "The enemy of my enemy is my friend."
-						allyStrength[gov.first] += ally.second;
-						allies.insert(ally.first);
-					}
-			}
+		tallyStrength = strength;
+		tallyRevision = revision;
+		enemyStrength.clear();
+		allyStrength.clear();
+		for(const auto &gov : strength)
+		{
+			set<const Government *> allies;
+			for(const auto &enemy : strength)
+				if(enemy.first->IsEnemy(gov.first))
+				{
+					// "Know your enemies."
+					enemyStrength[gov.first] += enemy.second;
+					for(const auto &ally : strength)
+						if(ally.first->IsEnemy(enemy.first) && !allies.count(ally.first))
+						{
+							// "The enemy of my enemy is my friend."
+							allyStrength[gov.first] += ally.second;
+							allies.insert(ally.first);
+						}
+				}
+		}
 	}
 	
 	// Ships with nearby allies consider their allies' strength as well as their own.
@@ -3711,7 +3891,7 @@ void AI::UpdateStrengths(map<const Government *, int64_t> &strength, const Syste
 		if(!gov || it->GetSystem() != playerSystem || it->IsDisabled() || Random::Int(60))
 			continue;
 		
-		int64_t &myStrength = shipStrength[it.get()];
+		int64_t &myStrength = State(*it).strength;
 		for(const auto &allies : governmentRosters)
 		{
 			// If this is not an allied government, its ships will not assist this ship when attacked.
@@ -3729,21 +3909,164 @@ void AI::UpdateStrengths(map<const Government *, int64_t> &strength, const Syste
 // Cache various lists of all targetable ships in the player's system for this Step.
 void AI::CacheShipLists()
 {
-	allyLists.clear();
-	enemyLists.clear();
+	// Reuse the indices from the previous step, to avoid reallocating them.
+	// Governments that are no longer present are removed.
+	for(auto it = allyLists.begin(); it != allyLists.end(); )
+	{
+		if(governmentRosters.count(it->first))
+			++it;
+		else
+		{
+			enemyLists.erase(it->first);
+			it = allyLists.erase(it);
+		}
+	}
+	
+	// Only ships that can be targeted, and that are not in the middle of
+	// jumping out of the system, belong in the lists.
+	map<const Government *, vector<Ship *>> targetable;
 	for(const auto &git : governmentRosters)
 	{
-		allyLists.emplace(git.first, vector<shared_ptr<Ship>>());
-		allyLists.at(git.first).reserve(ships.size());
-		enemyLists.emplace(git.first, vector<shared_ptr<Ship>>());
-		enemyLists.at(git.first).reserve(ships.size());
-		for(const auto &oit : governmentRosters)
+		vector<Ship *> &list = targetable[git.first];
+		for(const shared_ptr<Ship> &it : git.second)
+			if(it->IsTargetable() && !(it->IsHyperspacing() && it->Velocity().Length() > 10.))
+				list.push_back(it.get());
+	}
+	
+	for(const auto &git : governmentRosters)
+	{
+		ShipIndex &allies = allyLists[git.first];
+		ShipIndex &enemies = enemyLists[git.first];
+		allies.Clear();
+		enemies.Clear();
+		for(const auto &oit : targetable)
+		{
+			ShipIndex &index = git.first->IsEnemy(oit.first) ? enemies : allies;
+			for(Ship *ship : oit.second)
+				index.Add(ship);
+		}
+		allies.Finish();
+		enemies.Finish();
+	}
+}
+
+
+
+// Get the given ship's record, creating one if it does not have one yet.
+AI::ShipState &AI::State(const Ship &ship)
+{
+	size_t slot = ship.AISlot();
+	if(slot < shipStates.size() && shipStates[slot].ship == &ship)
+		return shipStates[slot];
+	
+	if(freeStates.empty())
+	{
+		slot = shipStates.size();
+		shipStates.emplace_back();
+	}
+	else
+	{
+		slot = freeStates.back();
+		freeStates.pop_back();
+	}
+	ship.SetAISlot(slot);
+	ShipState &state = shipStates[slot];
+	state.ship = &ship;
+	return state;
+}
+
+
+
+// Get the given ship's record, or null if it does not have one.
+const AI::ShipState *AI::FindState(const Ship &ship) const
+{
+	size_t slot = ship.AISlot();
+	if(slot < shipStates.size() && shipStates[slot].ship == &ship)
+		return &shipStates[slot];
+	return nullptr;
+}
+
+
+
+void AI::ShipIndex::Clear()
+{
+	ships.clear();
+	grid.clear();
+}
+
+
+
+void AI::ShipIndex::Add(Ship *ship)
+{
+	ships.push_back(ship);
+}
+
+
+
+// Finish adding ships, and sort them into the grid.
+void AI::ShipIndex::Finish()
+{
+	grid.resize(ships.size());
+	for(size_t i = 0; i < ships.size(); ++i)
+	{
+		grid[i].x = static_cast<int>(floor(ships[i]->Position().X() / INDEX_CELL_SIZE));
+		grid[i].y = static_cast<int>(floor(ships[i]->Position().Y() / INDEX_CELL_SIZE));
+		grid[i].index = i;
+	}
+	sort(grid.begin(), grid.end(), [](const Entry &a, const Entry &b) -> bool
+	{
+		return tie(a.y, a.x, a.index) < tie(b.y, b.x, b.index);
+	});
+}
+
+
+
+// Get all the ships within the given range of the given point, in the order
+// they were added. A negative range means there is no limit.
+void AI::ShipIndex::Find(const Point &center, double range, FrameVector<Ship *> &result) const
+{
+	result.clear();
+	if(range < 0.)
+	{
+		result.assign(ships.begin(), ships.end());
+		return;
+	}
+	
+	int minX = static_cast<int>(floor((center.X() - range) / INDEX_CELL_SIZE));
+	int minY = static_cast<int>(floor((center.Y() - range) / INDEX_CELL_SIZE));
+	int maxX = static_cast<int>(floor((center.X() + range) / INDEX_CELL_SIZE));
+	int maxY = static_cast<int>(floor((center.Y() + range) / INDEX_CELL_SIZE));
+	
+	// If the range covers more cells than there are ships, it is faster to just
+	// check every ship.
+	FrameVector<size_t> found;
+	if(static_cast<double>(maxX - minX + 1) * (maxY - minY + 1) > ships.size())
+	{
+		for(size_t i = 0; i < ships.size(); ++i)
+			if(center.Distance(ships[i]->Position()) < range)
+				found.push_back(i);
+	}
+	else
+	{
+		auto compare = [](const Entry &entry, const pair<int, int> &cell) -> bool
+		{
+			return make_pair(entry.y, entry.x) < cell;
+		};
+		for(int y = minY; y <= maxY; ++y)
 		{
-			auto &list = git.first->IsEnemy(oit.first)
-					? enemyLists[git.first] : allyLists[git.first];
-			list.insert(list.end(), oit.second.begin(), oit.second.end());
+			// The cells in each row of the grid are next to each other.
+			auto it = lower_bound(grid.begin(), grid.end(), make_pair(y, minX), compare);
+			for( ; it != grid.end() && it->y == y && it->x <= maxX; ++it)
+				if(center.Distance(ships[it->index]->Position()) < range)
+					found.push_back(it->index);
 		}
+		// Return the ships in the same order no matter which cells they are in.
+		sort(found.begin(), found.end());
 	}
+	
+	result.reserve(found.size());
+	for(size_t i : found)
+		result.push_back(ships[i]);
 }
 
 
@@ -3890,3 +4213,35 @@ void AI::UpdateOrders(const Ship &ship)
 		order.targetSystem = ship.GetSystem();
 	}
 }
+
+
+
+// Calculate the routes that ships are likely to ask for this step: to their
+// own target system, and to where their parent is or is going. Escorts of the
+// same parent usually share one route, so this is much less work than having
+// each ship find its own path.
+void AI::PrefetchRoutes(const Ship *flagship)
+{
+	vector<pair<const Ship *, const System *>> requests;
+	for(const auto &it : ships)
+	{
+		const System *system = it->GetSystem();
+		if(it.get() == flagship || !system)
+			continue;
+		
+		if(it->GetTargetSystem() && it->GetTargetSystem() != system)
+			requests.emplace_back(it.get(), it->GetTargetSystem());
+		auto oit = orders.find(it.get());
+		if(oit != orders.end() && oit->second.targetSystem && oit->second.targetSystem != system)
+			requests.emplace_back(it.get(), oit->second.targetSystem);
+		shared_ptr<const Ship> parent = it->GetParent();
+		if(parent)
+		{
+			if(parent->GetSystem() && parent->GetSystem() != system)
+				requests.emplace_back(it.get(), parent->GetSystem());
+			if(parent->GetTargetSystem() && parent->GetTargetSystem() != system)
+				requests.emplace_back(it.get(), parent->GetTargetSystem());
+		}
+	}
+	routes.Prefetch(requests, workers);
+}
@@ -13,8 +13,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef AI_H_
 #define AI_H_
 
+#include "Angle.h"
 #include "Command.h"
+#include "FrameArena.h"
 #include "Point.h"
+#include "RouteCache.h"
 
 #include <cstdint>
 #include <list>
@@ -22,7 +25,6 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <memory>
 #include <vector>
 
-class Angle;
 class AsteroidField;
 class Body;
 class Flotsam;
@@ -33,6 +35,7 @@ class Ship;
 class ShipEvent;
 class StellarObject;
 class System;
+class ThreadPool;
 
 
 
@@ -48,7 +51,7 @@ public:
 template <class Type>
 	using List = std::list<std::shared_ptr<Type>>;
 	// Constructor, giving the AI access to various object lists.
-	AI(const List<Ship> &ships, const List<Minable> &minables, const List<Flotsam> &flotsam);
+	AI(const std::vector<std::shared_ptr<Ship>> &ships, const std::vector<std::shared_ptr<Minable>> &minables, const List<Flotsam> &flotsam, ThreadPool &workers);
 	
 	// Fleet commands from the player.
 	void IssueShipTarget(const PlayerInfo &player, const std::shared_ptr<Ship> &target);
@@ -57,7 +60,7 @@ template <class Type>
 	void UpdateKeys(PlayerInfo &player, Command &clickCommands);
 	
 	// Allow the AI to track any events it is interested in.
-	void UpdateEvents(const std::list<ShipEvent> &events);
+	void UpdateEvents(const std::vector<ShipEvent> &events);
 	// Reset the AI's memory of events.
 	void Clean();
 	// Clear ship orders. This should be done when the player lands on a planet,
@@ -81,7 +84,7 @@ private:
 	// Pick a new target for the given ship.
 	std::shared_ptr<Ship> FindTarget(const Ship &ship) const;
 	// Obtain a list of ships matching the desired hostility.
-	std::vector<std::shared_ptr<Ship>> GetShipsList(const Ship &ship, bool targetEnemies, double maxRange = -1.) const;
+	FrameVector<Ship *> GetShipsList(const Ship &ship, bool targetEnemies, double maxRange = -1.) const;
 	
 	bool FollowOrders(Ship &ship, Command &command) const;
 	void MoveIndependent(Ship &ship, Command &command) const;
@@ -123,6 +126,13 @@ private:
 	static Point TargetAim(const Ship &ship, const Body &target);
 	// Aim the given ship's turrets.
 	void AimTurrets(const Ship &ship, Command &command, bool opportunistic = false) const;
+	// Aim the given ship's turrets at whatever they can shoot at. If there is
+	// nothing to aim at, and opportunistic turrets should instead sweep back
+	// and forth at random, this returns false without aiming them.
+	bool AimTurretsAtTargets(const Ship &ship, Command &command, bool opportunistic) const;
+	// Sweep the turrets back and forth at random, centered on the ship's
+	// "outward-facing" angle.
+	static void SweepTurrets(const Ship &ship, Command &command);
 	// Fire whichever of the given ship's weapons can hit a hostile target.
 	// Return a bitmask giving the weapons to fire.
 	void AutoFire(const Ship &ship, Command &command, bool secondary = true) const;
@@ -145,6 +155,8 @@ private:
 	// Functions to classify ships based on government and system.
 	void UpdateStrengths(std::map<const Government *, int64_t> &strength, const System *playerSystem);
 	void CacheShipLists();
+	// Calculate, all at once, the routes that ships are likely to need this step.
+	void PrefetchRoutes(const Ship *flagship);
 	
 	
 private:
@@ -176,13 +188,90 @@ private:
 	void UpdateOrders(const Ship &ship);
 	
 	
+private:
+	// Aiming turrets and picking weapons to fire only depend on the ship's own
+	// state and on where the other ships are, so once each ship's movement has
+	// been decided this can be done for all the ships at once.
+	class TurretJob {
+	public:
+		Ship *ship = nullptr;
+		bool opportunistic = false;
+		// The ship's commands from the previous step, and the movement commands
+		// that were decided on for this step.
+		Command previous;
+		Command movement;
+		// The turret aim and weapons to fire.
+		Command command;
+		bool shouldSweep = false;
+	};
+	void RunTurretJob(TurretJob &job) const;
+	
+	// What the AI remembers about one ship, other than the player's orders and
+	// the records of what it has done to other ships.
+	class ShipState {
+	public:
+		const Ship *ship = nullptr;
+		// The ship that has been asked to help this one.
+		std::weak_ptr<Ship> helper;
+		// How many ships are swarming around this one.
+		int swarmCount = 0;
+		// How long this ship has been outside the "invisible fence," or -1 if
+		// it has not been outside it recently.
+		int fenceCount = -1;
+		// Whether this ship should pick a new target this step instead of
+		// waiting for its regularly scheduled turn.
+		bool mustRethink = false;
+		// The direction a miner is circling its asteroid belt in, once it has
+		// started mining, and how long it has been mining.
+		bool isMining = false;
+		Angle miningAngle;
+		int miningTime = 0;
+		// How damaged an appeasing ship must get before it dumps more cargo.
+		double appeasementThreshold = 0.;
+		// This ship's estimate of the strength of its allies that are nearby.
+		int64_t strength = 0;
+	};
+	// Get the given ship's record, creating one if it does not have one yet.
+	ShipState &State(const Ship &ship);
+	// Get the given ship's record, or null if it does not have one.
+	const ShipState *FindState(const Ship &ship) const;
+	
+	// The targetable ships that one government considers to be its enemies (or
+	// its allies), sorted into grid cells so that the ones within a given range
+	// of a point can be found without checking every ship in the system.
+	class ShipIndex {
+	public:
+		void Clear();
+		void Add(Ship *ship);
+		// Finish adding ships, and sort them into the grid.
+		void Finish();
+		
+		// Get all the ships within the given range of the given point, in the
+		// order they were added. A negative range means there is no limit.
+		void Find(const Point &center, double range, FrameVector<Ship *> &result) const;
+		
+	private:
+		class Entry {
+		public:
+			int y;
+			int x;
+			size_t index;
+		};
+		
+		std::vector<Ship *> ships;
+		// The ships' indices, sorted by grid row and then by column.
+		std::vector<Entry> grid;
+	};
+	
+	
 private:
 	// Data from the game engine.
-	const List<Ship> &ships;
-	const List<Minable> &minables;
+	const std::vector<std::shared_ptr<Ship>> &ships;
+	const std::vector<std::shared_ptr<Minable>> &minables;
 	const List<Flotsam> &flotsam;
+	ThreadPool &workers;
 	
-	// The current step count for the AI, ranging from 0 to 30. Its value
+	// The current step count for the AI, ranging from 0 to 31. Its value
 	// helps limit how often certain actions occur (such as changing targets).
 	int step = 0;
 	
@@ -199,6 +288,12 @@ private:
 	// ordinary pointers instead of weak pointers.
 	std::map<const Ship *, Orders> orders;
 	
+	// Everything else the AI remembers about each ship is kept in one table,
+	// indexed by the slot that each ship stores. Records that are no longer
+	// in use are put on a free list to be reused.
+	std::vector<ShipState> shipStates;
+	std::vector<size_t> freeStates;
+	
 	// Records of what various AI ships and factions have done.
 	typedef std::owner_less<std::weak_ptr<const Ship>> Comp;
 	std::map<std::weak_ptr<const Ship>, std::map<std::weak_ptr<const Ship>, int, Comp>, Comp> actions;
@@ -206,20 +301,21 @@ private:
 	std::map<const Government *, std::map<std::weak_ptr<const Ship>, int, Comp>> governmentActions;
 	std::map<const Government *, bool> scanPermissions;
 	std::map<std::weak_ptr<const Ship>, int, Comp> playerActions;
-	std::map<const Ship *, std::weak_ptr<Ship>> helperList;
-	std::map<const Ship *, int> swarmCount;
-	std::map<const Ship *, int> fenceCount;
-	std::map<const Ship *, Angle> miningAngle;
-	std::map<const Ship *, int> miningTime;
-	std::map<const Ship *, double> appeasmentThreshold;
-	
-	std::map<const Ship *, int64_t> shipStrength;
 	
 	std::map<const Government *, int64_t> enemyStrength;
 	std::map<const Government *, int64_t> allyStrength;
+	// The strengths and political situation that the enemy and ally strengths
+	// were last calculated from.
+	std::map<const Government *, int64_t> tallyStrength;
+	uint64_t tallyRevision = 0;
 	std::map<const Government *, std::vector<std::shared_ptr<Ship>>> governmentRosters;
-	std::map<const Government *, std::vector<std::shared_ptr<Ship>>> enemyLists;
-	std::map<const Government *, std::vector<std::shared_ptr<Ship>>> allyLists;
+	std::map<const Government *, ShipIndex> enemyLists;
+	std::map<const Government *, ShipIndex> allyLists;
+	
+	std::vector<TurretJob> turretJobs;
+	
+	// Routes between systems, shared by all the ships that need the same one.
+	mutable RouteCache routes;
 };
 
 
@@ -26,11 +26,54 @@ namespace {
 	// Suppose you want to be able to turn 360 degrees in one second. Then you are
 	// turning 6 degrees per time step. If the Angle lookup is 2^16 steps, then 6
 	// degrees is 1092 steps, and your turn speed is accurate to +- 0.05%. That seems
-	// plenty accurate to me. At that step size, the lookup table is exactly 1 MB.
+	// plenty accurate to me.
 	const int32_t STEPS = 0x10000;
 	const int32_t MASK = STEPS - 1;
 	const double DEG_TO_STEP = STEPS / 360.;
 	const double STEP_TO_RAD = PI / (STEPS / 2);
+	
+	// A table with a unit vector for every step would take up 1 MB, which is
+	// far more than fits in the processor's cache. Instead, each angle is split
+	// into a coarse and a fine part, and the unit vectors for those two parts
+	// (which only take up 8 KB in all) are combined by rotating one by the other.
+	const int32_t FINE_BITS = 8;
+	const int32_t FINE_STEPS = 1 << FINE_BITS;
+	const int32_t FINE_MASK = FINE_STEPS - 1;
+	
+	// Calculate the unit vector for the given number of steps.
+	Point UnitVector(int32_t step)
+	{
+		double radians = step * STEP_TO_RAD;
+		// The graphics use the usual screen coordinate system, meaning that
+		// positive Y is down rather than up. Angles are clock angles, i.e.
+		// 0 is 12:00 and angles increase in the clockwise direction. So, an
+		// angle of 0 degrees is pointing in the direction (0, -1).
+		return Point(sin(radians), -cos(radians));
+	}
+	
+	class UnitTables {
+	public:
+		UnitTables();
+		
+		vector<Point> coarse;
+		vector<Point> fine;
+	};
+	
+	UnitTables::UnitTables()
+	{
+		coarse.reserve(STEPS / FINE_STEPS);
+		for(int32_t i = 0; i < STEPS; i += FINE_STEPS)
+			coarse.push_back(UnitVector(i));
+		fine.reserve(FINE_STEPS);
+		for(int32_t i = 0; i < FINE_STEPS; ++i)
+			fine.push_back(UnitVector(i));
+	}
+	
+	const UnitTables &Tables()
+	{
+		static const UnitTables tables;
+		return tables;
+	}
 }
 
 
@@ -128,22 +171,8 @@ Angle Angle::operator-() const
 // Get a unit vector in the direction of this angle.
 Point Angle::Unit() const
 {
-	// The very first time this is called, create a lookup table of unit vectors.
-	static vector<Point> cache;
-	if(cache.empty())
-	{
-		cache.reserve(STEPS);
-		for(int i = 0; i < STEPS; ++i)
-		{
-			double radians = i * STEP_TO_RAD;
-			// The graphics use the usual screen coordinate system, meaning that
-			// positive Y is down rather than up. Angles are clock angles, i.e.
-			// 0 is 12:00 and angles increase in the clockwise direction. So, an
-			// angle of 0 degrees is pointing in the direction (0, -1).
-			cache.emplace_back(sin(radians), -cos(radians));
-		}
-	}
-	return cache[angle];
+	const UnitTables &tables = Tables();
+	return RotateBy(tables.coarse[angle >> FINE_BITS], tables.fine[angle & FINE_MASK]);
 }
 
 
@@ -158,15 +187,11 @@ double Angle::Degrees() const
 }
 
 
-	
+
 // Return a point rotated by this angle around (0, 0).
 Point Angle::Rotate(const Point &point) const
 {
-	// If using the normal mathematical coordinate system, this would be easier.
-	// Since we're not, the math is a tiny bit less elegant:
-	Point unit = Unit();
-	return Point(-unit.Y() * point.X() - unit.X() * point.Y(),
-		-unit.Y() * point.Y() + unit.X() * point.X());
+	return RotateBy(Unit(), point);
 }
 
 
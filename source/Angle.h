@@ -53,18 +53,49 @@ public:
 	
 	// Return a point rotated by this angle around (0, 0).
 	Point Rotate(const Point &point) const;
+	// Rotate every point in the given range by this angle, and write the
+	// results to the given output. This only has to look up the unit vector
+	// once, so it is faster than rotating each point separately.
+	template <class InputIt, class OutputIt>
+	OutputIt Rotate(InputIt first, InputIt last, OutputIt result) const;
 	
 	
 private:
 	explicit Angle(int32_t angle);
 	
+	// Rotate the given point by the angle whose unit vector is given.
+	static Point RotateBy(const Point &unit, const Point &point);
+	
 	
 private:
 	// The angle is stored as an integer value between 0 and 2^16 - 1. This is
 	// so that any angle can be mapped to a unit vector (a very common operation)
-	// with just a single array lookup. It also means that "wrapping" angles
+	// with just two small table lookups. It also means that "wrapping" angles
 	// to the range of 0 to 360 degrees can be done via a bit mask.
 	int32_t angle;
 };
 
+
+
+template <class InputIt, class OutputIt>
+OutputIt Angle::Rotate(InputIt first, InputIt last, OutputIt result) const
+{
+	Point unit = Unit();
+	for( ; first != last; ++first, ++result)
+		*result = RotateBy(unit, *first);
+	return result;
+}
+
+
+
+inline Point Angle::RotateBy(const Point &unit, const Point &point)
+{
+	// If using the normal mathematical coordinate system, this would be easier.
+	// Since we're not, the math is a tiny bit less elegant:
+	return Point(-unit.Y() * point.X() - unit.X() * point.Y(),
+		-unit.Y() * point.Y() + unit.X() * point.X());
+}
+
+
+
 #endif
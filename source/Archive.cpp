@@ -0,0 +1,213 @@
+/* Archive.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Archive.h"
+
+#include "BinaryData.h"
+#include "File.h"
+#include "Files.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+	// The archive starts with this tag, the format version, and the size of the
+	// table of contents that follows them.
+	const string TAG = "ESPK";
+	const uint32_t VERSION = 1;
+	const size_t HEADER_SIZE = 16;
+	
+	// The directories in each source that are packed into its archive.
+	const string DIRECTORIES[] = {"data/", "images/", "sounds/"};
+	
+	// Check if the given path begins with the given prefix.
+	bool StartsWith(const string &path, const string &prefix)
+	{
+		return !path.compare(0, prefix.size(), prefix);
+	}
+}
+
+
+
+// Get the path of the archive for the given resource directory.
+string Archive::Path(const string &directory)
+{
+	return directory + "assets.pak";
+}
+
+
+
+// Pack all the data, images, and sounds in the given resource directory into
+// its archive. Return false if any of them could not be read or written.
+bool Archive::Write(string directory)
+{
+	if(directory.empty() || directory.back() != '/')
+		directory += '/';
+	
+	// Each list of files is sorted, and so are the directory names, so the
+	// table of contents will be in sorted order too.
+	vector<Files::Entry> files;
+	for(const string &name : DIRECTORIES)
+	{
+		vector<Files::Entry> list = Files::RecursiveListEntries(directory + name);
+		move(list.begin(), list.end(), back_inserter(files));
+	}
+	
+	// The file contents begin right after the table of contents, so figure out
+	// how big that will be first.
+	uint64_t offset = HEADER_SIZE + 4;
+	for(const Files::Entry &file : files)
+		offset += 4 + (file.path.size() - directory.size()) + 16;
+	
+	string toc;
+	BinaryData::Write32(files.size(), toc);
+	for(const Files::Entry &file : files)
+	{
+		BinaryData::WriteString(file.path.substr(directory.size()), toc);
+		BinaryData::Write64(offset, toc);
+		BinaryData::Write64(file.size, toc);
+		offset += file.size;
+	}
+	
+	string header = TAG;
+	BinaryData::Write32(VERSION, header);
+	BinaryData::Write64(toc.size(), header);
+	
+	File out(Path(directory), true);
+	if(!out)
+		return false;
+	Files::Write(out, header);
+	Files::Write(out, toc);
+	for(const Files::Entry &file : files)
+	{
+		// If a file changed size after it was listed, the table of contents
+		// would no longer be correct.
+		string contents = Files::Read(file.path);
+		if(contents.size() != file.size)
+			return false;
+		Files::Write(out, contents);
+	}
+	return !ferror(out);
+}
+
+
+
+// Map the archive at the given path into memory. If it does not exist or is
+// not a valid archive, it will be empty.
+Archive::Archive(const string &path)
+	: file(path)
+{
+	if(file.IsEmpty())
+		return;
+	timestamp = Files::Timestamp(path);
+	const char *data = file.Data();
+	size_t size = file.Size();
+	
+	// Check that this really is an archive, and read its table of contents.
+	string header(data, min(size, HEADER_SIZE));
+	size_t pos = TAG.size();
+	uint32_t version = 0;
+	uint64_t tocSize = 0;
+	if(header.compare(0, TAG.size(), TAG) || !BinaryData::Read32(header, pos, version) || version != VERSION
+			|| !BinaryData::Read64(header, pos, tocSize) || tocSize > size - HEADER_SIZE)
+		return;
+	
+	string toc(data + HEADER_SIZE, tocSize);
+	pos = 0;
+	uint32_t count = 0;
+	if(!BinaryData::Read32(toc, pos, count))
+		return;
+	// Each entry takes at least a string length and two 64-bit values, so a
+	// count that could not fit in the table of contents must be corrupt.
+	// Check it before allocating space for that many entries.
+	static const size_t MIN_ENTRY_SIZE = sizeof(uint32_t) + 2 * sizeof(uint64_t);
+	if(count > (tocSize - pos) / MIN_ENTRY_SIZE)
+		return;
+	
+	entries.resize(count);
+	for(Entry &entry : entries)
+	{
+		// If anything is out of place, treat the whole archive as invalid
+		// rather than reading the wrong data for some files.
+		if(!BinaryData::ReadString(toc, pos, entry.path) || !BinaryData::Read64(toc, pos, entry.offset)
+				|| !BinaryData::Read64(toc, pos, entry.size) || entry.offset > size || entry.size > size - entry.offset
+				|| (&entry != &entries.front() && !((&entry - 1)->path < entry.path)))
+		{
+			entries.clear();
+			return;
+		}
+	}
+}
+
+
+
+bool Archive::IsEmpty() const
+{
+	return entries.empty();
+}
+
+
+
+// Get the time the archive was modified, which is also treated as the time
+// that every file in it was modified.
+time_t Archive::Timestamp() const
+{
+	return timestamp;
+}
+
+
+
+// Find the file with the given relative path. If it exists, point the given
+// data at its contents and return true.
+bool Archive::Find(const string &path, const char *&data, size_t &size) const
+{
+	auto it = lower_bound(entries.begin(), entries.end(), path,
+		[](const Entry &entry, const string &path) { return entry.path < path; });
+	if(it == entries.end() || it->path != path)
+		return false;
+	
+	data = file.Data() + it->offset;
+	size = it->size;
+	return true;
+}
+
+
+
+// Check if the given relative path is a file or directory in this archive.
+bool Archive::Contains(const string &path) const
+{
+	if(path.empty())
+		return !entries.empty();
+	
+	auto it = lower_bound(entries.begin(), entries.end(), path,
+		[](const Entry &entry, const string &path) { return entry.path < path; });
+	if(it == entries.end() || !StartsWith(it->path, path))
+		return false;
+	
+	// Make sure this is not just a file whose name begins with the given name.
+	return it->path.size() == path.size() || path.back() == '/' || it->path[path.size()] == '/';
+}
+
+
+
+// Get all the entries whose paths begin with the given relative directory,
+// which must end in a slash.
+pair<Archive::const_iterator, Archive::const_iterator> Archive::List(const string &directory) const
+{
+	auto begin = lower_bound(entries.begin(), entries.end(), directory,
+		[](const Entry &entry, const string &path) { return entry.path < path; });
+	auto end = begin;
+	while(end != entries.end() && StartsWith(end->path, directory))
+		++end;
+	return make_pair(begin, end);
+}
@@ -0,0 +1,83 @@
+/* Archive.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ARCHIVE_H_
+#define ARCHIVE_H_
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+// Class representing a single file that holds all the data, images, and sounds
+// of the game or of a plugin, so that they can be read without opening tens of
+// thousands of separate files. The archive begins with a table of contents that
+// lists the path of each file (relative to the directory the archive is in) in
+// sorted order, and where its contents are. The whole archive is mapped into
+// memory, so reading a file from it does not take any system calls.
+class Archive {
+public:
+	class Entry {
+	public:
+		std::string path;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+	using const_iterator = std::vector<Entry>::const_iterator;
+	
+	
+public:
+	// Get the path of the archive for the given resource directory.
+	static std::string Path(const std::string &directory);
+	// Pack all the data, images, and sounds in the given resource directory into
+	// its archive. Return false if any of them could not be read or written.
+	static bool Write(std::string directory);
+	
+	// Map the archive at the given path into memory. If it does not exist or is
+	// not a valid archive, it will be empty.
+	explicit Archive(const std::string &path);
+	
+	// No copying this class.
+	Archive(const Archive &other) = delete;
+	Archive &operator=(const Archive &other) = delete;
+	
+	bool IsEmpty() const;
+	// Get the time the archive was modified, which is also treated as the time
+	// that every file in it was modified.
+	std::time_t Timestamp() const;
+	
+	// Find the file with the given relative path. If it exists, point the given
+	// data at its contents and return true.
+	bool Find(const std::string &path, const char *&data, size_t &size) const;
+	// Check if the given relative path is a file or directory in this archive.
+	bool Contains(const std::string &path) const;
+	// Get all the entries whose paths begin with the given relative directory,
+	// which must end in a slash.
+	std::pair<const_iterator, const_iterator> List(const std::string &directory) const;
+	
+	
+private:
+	std::vector<Entry> entries;
+	std::time_t timestamp = 0;
+	
+	MappedFile file;
+};
+
+
+
+#endif
@@ -104,6 +104,8 @@ void Armament::Add(const Outfit *outfit, int count)
 		streamReload[outfit] = 0;
 	else
 		streamReload.erase(outfit);
+	
+	FindActive();
 }
 
 
@@ -135,6 +137,8 @@ void Armament::ReloadAll()
 			if(outfit->IsStreamed())
 				streamReload[outfit] = 0;
 		}
+	
+	FindActive();
 }
 
 
@@ -155,6 +159,7 @@ void Armament::Swap(int first, int second)
 	const Outfit *outfit = hardpoints[first].GetOutfit();
 	hardpoints[first].Install(hardpoints[second].GetOutfit());
 	hardpoints[second].Install(outfit);
+	FindActive();
 }
 
 
@@ -213,7 +218,10 @@ void Armament::Fire(int index, Ship &ship, vector<Projectile> &projectiles, vect
 			it->second += it->first->Reload() * hardpoints[index].BurstRemaining();
 		}
 	}
+	bool wasIdle = hardpoints[index].IsIdle();
 	hardpoints[index].Fire(ship, projectiles, visuals);
+	if(wasIdle && !hardpoints[index].IsIdle())
+		active.push_back(index);
 }
 
 
@@ -223,7 +231,11 @@ bool Armament::FireAntiMissile(int index, Ship &ship, const Projectile &projecti
 	if(static_cast<unsigned>(index) >= hardpoints.size() || !hardpoints[index].IsReady())
 		return false;
 	
-	return hardpoints[index].FireAntiMissile(ship, projectile, visuals);
+	bool wasIdle = hardpoints[index].IsIdle();
+	bool killed = hardpoints[index].FireAntiMissile(ship, projectile, visuals);
+	if(wasIdle && !hardpoints[index].IsIdle())
+		active.push_back(index);
+	return killed;
 }
 
 
@@ -231,8 +243,20 @@ bool Armament::FireAntiMissile(int index, Ship &ship, const Projectile &projecti
 // Update the reload counters.
 void Armament::Step(const Ship &ship)
 {
-	for(Hardpoint &hardpoint : hardpoints)
+	// Only the weapons that have fired recently need to be updated. Once a
+	// weapon is idle again, stop updating it until it fires.
+	for(size_t i = 0; i < active.size(); )
+	{
+		Hardpoint &hardpoint = hardpoints[active[i]];
 		hardpoint.Step();
+		if(hardpoint.IsIdle())
+		{
+			active[i] = active.back();
+			active.pop_back();
+		}
+		else
+			++i;
+	}
 	
 	for(auto &it : streamReload)
 	{
@@ -242,3 +266,14 @@ void Armament::Step(const Ship &ship)
 		it.second = max(it.second, 1 - count);
 	}
 }
+
+
+
+// Find which hardpoints have reload counters that are still changing.
+void Armament::FindActive()
+{
+	active.clear();
+	for(unsigned i = 0; i < hardpoints.size(); ++i)
+		if(!hardpoints[i].IsIdle())
+			active.push_back(i);
+}
@@ -72,12 +72,20 @@ public:
 	void Step(const Ship &ship);
 	
 	
+private:
+	// Find which hardpoints have reload counters that are still changing.
+	void FindActive();
+	
+	
 private:
 	// Note: the Armament must be copied when an instance of a Ship is made, so
 	// it should not hold any pointers specific to one ship (including to
 	// elements of this Armament itself).
 	std::map<const Outfit *, int> streamReload;
 	std::vector<Hardpoint> hardpoints;
+	// The indices of the hardpoints that have fired recently, and so need their
+	// reload counters updated. All the others are idle.
+	std::vector<unsigned> active;
 };
 
 
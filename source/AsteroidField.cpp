@@ -47,6 +47,8 @@ void AsteroidField::Clear()
 {
 	asteroids.clear();
 	minables.clear();
+	asteroidSpeed = 0.;
+	minableSpeed = 0.;
 }
 
 
@@ -57,6 +59,7 @@ void AsteroidField::Add(const string &name, int count, double energy)
 	const Sprite *sprite = SpriteSet::Get("asteroid/" + name + "/spin");
 	for(int i = 0; i < count; ++i)
 		asteroids.emplace_back(sprite, energy);
+	asteroidSpeed = max(asteroidSpeed, energy);
 }
 
 
@@ -68,9 +71,10 @@ void AsteroidField::Add(const Minable *minable, int count, double energy, double
 		return;
 	
 	// Place copies of the given minable asteroid throughout the system.
+	minables.reserve(minables.size() + max(count, 0));
 	for(int i = 0; i < count; ++i)
 	{
-		minables.emplace_back(new Minable(*minable));
+		minables.push_back(make_shared<Minable>(*minable));
 		minables.back()->Place(energy, beltRadius);
 	}
 }
@@ -89,31 +93,81 @@ void AsteroidField::Step(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flo
 	asteroidCollisions.Finish();
 	
 	// Step through the minables. Since they are destructible, we may need to
-	// remove them from the list.
+	// remove them from the list. The survivors are shifted down to fill in any
+	// gaps, keeping their order.
 	minableCollisions.Clear(step);
-	auto it = minables.begin();
-	while(it != minables.end())
-	{
+	minableSpeed = 0.;
+	auto out = minables.begin();
+	for(auto it = minables.begin(); it != minables.end(); ++it)
 		if((*it)->Move(visuals, flotsam))
 		{
 			minableCollisions.Add(**it);
-			++it;
+			minableSpeed = max(minableSpeed, (*it)->Velocity().Length());
+			if(out != it)
+				*out = move(*it);
+			++out;
 		}
-		else
-			it = minables.erase(it);
-	}
+	minables.erase(out, minables.end());
 	minableCollisions.Finish();
 }
 
 
 
 // Draw the asteroids, centered on the given location.
-void AsteroidField::Draw(DrawList &draw, const Point &center, double zoom) const
+void AsteroidField::Draw(DrawList &draw, const Point &center, const Point &centerVelocity, double zoom) const
 {
-	for(const Asteroid &asteroid : asteroids)
-		asteroid.Draw(draw, center, zoom);
-	for(const shared_ptr<Minable> &minable : minables)
-		draw.Add(*minable);
+	// Only the asteroids in the collision set's cells that the screen covers
+	// need to be drawn. Allow for how far they have moved since being added to
+	// it, and for motion blur.
+	Point screenTopLeft = center + Screen::TopLeft() / zoom;
+	Point screenBottomRight = center + Screen::BottomRight() / zoom;
+	Point margin = Point(1., 1.) * (1.5 * asteroidSpeed + centerVelocity.Length());
+	Point topLeft = screenTopLeft - margin;
+	Point bottomRight = screenBottomRight + margin;
+	
+	// If the screen is bigger than the field repeats, just draw everything.
+	if(bottomRight.X() - topLeft.X() >= WRAP || bottomRight.Y() - topLeft.Y() >= WRAP)
+	{
+		for(const Asteroid &asteroid : asteroids)
+			asteroid.Draw(draw, center, zoom);
+	}
+	else
+	{
+		// The screen may overlap up to four copies of the field. Look up the
+		// part of it that falls in each one. An asteroid near the edge of the
+		// field is also stored in cells just beyond the edge, so also check the
+		// neighboring copies for those.
+		Point first(floor((topLeft.X() - CELL_SIZE) / WRAP), floor((topLeft.Y() - CELL_SIZE) / WRAP));
+		Point last(floor((bottomRight.X() + CELL_SIZE) / WRAP), floor((bottomRight.Y() + CELL_SIZE) / WRAP));
+		visible.clear();
+		for(double y = first.Y(); y <= last.Y(); ++y)
+			for(double x = first.X(); x <= last.X(); ++x)
+			{
+				Point offset = Point(x, y) * WRAP;
+				Point from(max(topLeft.X() - offset.X(), -1. * CELL_SIZE), max(topLeft.Y() - offset.Y(), -1. * CELL_SIZE));
+				Point to(min(bottomRight.X() - offset.X(), WRAP + CELL_SIZE), min(bottomRight.Y() - offset.Y(), WRAP + CELL_SIZE));
+				if(from.X() > to.X() || from.Y() > to.Y())
+					continue;
+				
+				asteroidCollisions.Rect(from, to, lookup);
+				visible.insert(visible.end(), lookup.begin(), lookup.end());
+			}
+		
+		// An asteroid near the edge of the field may be found in more than one
+		// copy of it, but each one only needs to be drawn once: Asteroid::Draw()
+		// draws every copy of it that is on screen. Sorting also keeps them in
+		// the same order they would be drawn in otherwise.
+		sort(visible.begin(), visible.end());
+		visible.erase(unique(visible.begin(), visible.end()), visible.end());
+		for(const Body *body : visible)
+			static_cast<const Asteroid *>(body)->Draw(draw, center, zoom);
+	}
+	
+	// The minables do not repeat, so they can be looked up directly.
+	margin = Point(1., 1.) * (minableSpeed + centerVelocity.Length());
+	minableCollisions.Rect(screenTopLeft - margin, screenBottomRight + margin, visible);
+	for(const Body *body : visible)
+		draw.Add(*body);
 }
 
 
@@ -165,7 +219,7 @@ Body *AsteroidField::Collide(const Projectile &projectile, double *closestHit)
 
 
 // Get the list of mainable asteroids.
-const list<shared_ptr<Minable>> &AsteroidField::Minables() const
+const vector<shared_ptr<Minable>> &AsteroidField::Minables() const
 {
 	return minables;
 }
@@ -206,16 +260,14 @@ void AsteroidField::Asteroid::Step()
 	angle += spin;
 	position += velocity;
 	
-	// Keep the position within the wrap square.
-	if(position.X() < 0.)
-		position = Point(position.X() + WRAP, position.Y());
-	else if(position.X() >= WRAP)
-		position = Point(position.X() - WRAP, position.Y());
-	
-	if(position.Y() < 0.)
-		position = Point(position.X(), position.Y() + WRAP);
-	else if(position.Y() >= WRAP)
-		position = Point(position.X(), position.Y() - WRAP);
+	// Keep the position within the wrap square. An asteroid never moves more
+	// than the width of the square in one step, so at most one wrap is needed.
+	// This is written without branches so the compiler can vectorize it.
+	double x = position.X();
+	double y = position.Y();
+	x += WRAP * ((x < 0.) - (x >= WRAP));
+	y += WRAP * ((y < 0.) - (y >= WRAP));
+	position = Point(x, y);
 }
 
 
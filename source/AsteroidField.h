@@ -52,14 +52,16 @@ public:
 	
 	// Move all the asteroids forward one time step, and populate the asteroid and minable collision sets.
 	void Step(std::vector<Visual> &visuals, std::list<std::shared_ptr<Flotsam>> &flotsam, int step);
-	// Draw the asteroid field, with the field of view centered on the given point.
-	void Draw(DrawList &draw, const Point &center, double zoom) const;
+	// Draw the asteroid field, with the field of view centered on the given
+	// point. Only the asteroids that might be on screen, allowing for motion
+	// blur relative to the given velocity, are added to the draw list.
+	void Draw(DrawList &draw, const Point &center, const Point &centerVelocity, double zoom) const;
 	// Check if the given projectile has hit any of the asteroids, using the information
 	// in the collision sets. If a collision occurs, returns a pointer to the hit body.
 	Body *Collide(const Projectile &projectile, double *closestHit);
 	
 	// Get the list of minable asteroids.
-	const std::list<std::shared_ptr<Minable>> &Minables() const;
+	const std::vector<std::shared_ptr<Minable>> &Minables() const;
 	
 	
 private:
@@ -80,10 +82,21 @@ private:
 	
 private:
 	std::vector<Asteroid> asteroids;
-	std::list<std::shared_ptr<Minable>> minables;
+	// The minables are kept in one contiguous array, which is compacted in place
+	// whenever any of them are destroyed.
+	std::vector<std::shared_ptr<Minable>> minables;
 	
 	CollisionSet asteroidCollisions;
 	CollisionSet minableCollisions;
+	// The fastest any of the asteroids or minables can move. The asteroid
+	// collision set holds each asteroid's position from before it last moved,
+	// so lookups based on it must allow for this much movement, and both must
+	// allow for the motion blur.
+	double asteroidSpeed = 0.;
+	double minableSpeed = 0.;
+	// The asteroids and minables that might be visible, found by Draw().
+	mutable std::vector<Body *> visible;
+	mutable std::vector<Body *> lookup;
 };
 
 
@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Files.h"
 #include "Music.h"
 #include "Point.h"
+#include "Profiler.h"
 #include "Random.h"
 #include "Sound.h"
 
@@ -27,7 +28,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <map>
 #include <mutex>
 #include <set>
@@ -44,7 +48,6 @@ namespace {
 	class QueueEntry {
 	public:
 		void Add(Point position);
-		void Add(const QueueEntry &other);
 		
 		Point sum;
 		double weight = 0.;
@@ -67,8 +70,67 @@ namespace {
 		unsigned source = 0;
 	};
 	
+	// Sounds that are requested by any thread are passed to the mixing thread
+	// through this lock-free ring buffer, so that the threads that play sounds
+	// never block each other or the mixing thread. Any number of threads may
+	// add requests, but only the mixing thread may take them out.
+	class RequestQueue {
+	public:
+		RequestQueue();
+		
+		// Add a request. If the queue is full, the request is dropped.
+		void Push(const Sound *sound, const Point &offset);
+		// Take the oldest request out of the queue, if there is one.
+		bool Pop(const Sound *&sound, Point &offset);
+		
+	private:
+		// Each slot's sequence number tells whether it is ready to be written
+		// to or read from for a given position in the queue.
+		class Slot {
+		public:
+			atomic<size_t> sequence;
+			const Sound *sound = nullptr;
+			Point offset;
+		};
+		
+		static const size_t CAPACITY = 4096;
+		Slot slots[CAPACITY];
+		atomic<size_t> tail;
+		size_t head = 0;
+	};
+	
+	// A sound file that is waiting to be loaded. Files with a higher priority
+	// are loaded first. Only the "required" ones, i.e. the ones that the game
+	// data refers to, must be loaded before the game can start.
+	class LoadRequest {
+	public:
+		Sound *sound = nullptr;
+		string name;
+		string path;
+		int priority = 0;
+		bool isRequired = false;
+	};
+	
+	// Load priorities: sounds that nothing refers to yet are loaded last, and
+	// sounds that were played before they were loaded are loaded next.
+	const int LAZY = 0;
+	const int REFERENCED = 1;
+	const int PREFETCHED = 2;
+	const int PLAYED = 3;
+	
 	// Thread entry point for loading the sound files.
 	void Load();
+	// If the given sound is still waiting to be loaded, raise its priority.
+	void Prioritize(const Sound *sound, int priority);
+	
+	// Thread entry point for mixing. Once Init() has started this thread, it is
+	// the only one that touches the sources and the music buffers, so the main
+	// loop never waits on OpenAL, and a slow frame does not starve the music.
+	void Mix();
+	// Start all the sounds that one frame asked for.
+	void StartSounds();
+	// Queue up new buffers for the music, if necessary.
+	void StreamMusic();
 	
 	
 	// Mutex to make sure different threads don't modify the audio at the same time.
@@ -78,14 +140,22 @@ namespace {
 	ALCdevice *device = nullptr;
 	ALCcontext *context = nullptr;
 	bool isInitialized = false;
-	double volume = .125;
+	atomic<double> volume(.125);
 	
-	// This queue keeps track of sounds that have been requested to play. Each
-	// added sound is "deferred" until the next audio position update to make
-	// sure that all sounds from a given frame start at the same time.
+	// Sounds that have been requested to play are collected here by the
+	// mixing thread until it reaches the end of the frame they were requested
+	// in, so that all the sounds from a given frame start at the same time.
+	// Step() marks the end of each frame with a request for no sound.
 	map<const Sound *, QueueEntry> queue;
-	map<const Sound *, QueueEntry> deferred;
-	thread::id mainThreadID;
+	RequestQueue deferred;
+	
+	// The mixing thread wakes up this often, which is the game's frame rate,
+	// and runs until Quit() tells it to stop.
+	const chrono::nanoseconds MIX_TICK(1000000000 / 60);
+	thread mixThread;
+	mutex mixMutex;
+	condition_variable mixCondition;
+	bool isMixing = false;
 	
 	// Sound resources that have been loaded from files.
 	map<string, Sound> sounds;
@@ -95,15 +165,33 @@ namespace {
 	vector<unsigned> recycledSources;
 	vector<unsigned> endingSources;
 	unsigned maxSources = 255;
-	
-	// Queue and thread for loading sound files in the background.
-	map<string, string> loadQueue;
-	thread loadThread;
+	// Never play more than this many sounds at once. If more are requested,
+	// only the loudest ones start playing.
+	const unsigned VOICE_BUDGET = 128;
+	// Sounds farther away than this (in OpenAL units, i.e. 500 pixels each)
+	// would be played at less than 5% volume, so they are skipped entirely.
+	const double AUDIBLE_RANGE = 20.;
+	// How many sounds were skipped since the last Step() for being out of range.
+	atomic<int> culledSounds(0);
+	// Random numbers for the mixing thread, which has its own stream so that
+	// the sounds it starts do not change the numbers that the game draws.
+	Random::Stream pitchVariation;
+	
+	// Queue and threads for loading sound files in the background, and how
+	// many of the required files have not been loaded yet.
+	map<const Sound *, LoadRequest> loadQueue;
+	vector<thread> loadThreads;
+	size_t requiredTotal = 0;
+	size_t requiredLeft = 0;
+	// Never use more than this many threads to load sounds.
+	const unsigned MAX_LOAD_THREADS = 4;
 	
 	// The current position of the "listener," i.e. the center of the screen.
 	Point listener;
 	
-	// MP3 streaming:
+	// MP3 streaming. The tracks are changed by the main thread and streamed
+	// by the mixing thread, so they are guarded by a mutex.
+	mutex musicMutex;
 	unsigned musicSource = 0;
 	const size_t MUSIC_BUFFERS = 3;
 	unsigned musicBuffers[MUSIC_BUFFERS];
@@ -115,7 +203,7 @@ namespace {
 
 
 
-// Begin loading sounds (in a separate thread).
+// Begin loading sounds (in separate threads).
 void Audio::Init(const vector<string> &sources)
 {
 	device = alcOpenDevice(nullptr);
@@ -128,41 +216,63 @@ void Audio::Init(const vector<string> &sources)
 	
 	// If we don't make it to this point, no audio will be played.
 	isInitialized = true;
-	mainThreadID = this_thread::get_id();
+	pitchVariation = Random::Stream(chrono::steady_clock::now().time_since_epoch().count());
 	
 	// The listener is looking "into" the screen. This orientation vector is
 	// used to determine what sounds should be in the right or left speaker.
 	ALfloat zero[3] = {0., 0., 0.};
 	ALfloat orientation[6] = {0., 0., -1., 0., 1., 0.};
 	
-	alListenerf(AL_GAIN, volume);
+	alListenerf(AL_GAIN, volume.load());
 	alListenerfv(AL_POSITION, zero);
 	alListenerfv(AL_VELOCITY, zero);
 	alListenerfv(AL_ORIENTATION, orientation);
 	alDistanceModel(AL_INVERSE_DISTANCE_CLAMPED);
 	alDopplerFactor(0.);
 	
-	// Get all the sound files in the game data and all plugins.
+	// Get all the sound files in the game data and all plugins. Any sound that
+	// the game data refers to already has an entry in the sound map.
+	unique_lock<mutex> lock(audioMutex);
 	for(const string &source : sources)
 	{
 		string root = source + "sounds/";
 		vector<string> files = Files::RecursiveList(root);
 		for(const string &path : files)
 		{
-			if(!path.compare(path.length() - 4, 4, ".wav"))
+			if(path.length() >= 4 && (!path.compare(path.length() - 4, 4, ".wav")
+					|| !path.compare(path.length() - 4, 4, ".ogg")))
 			{
 				// The "name" of the sound is its full path within the "sounds/"
-				// folder, without the ".wav" or "~.wav" suffix.
+				// folder, without the ".wav" or "~.wav" (or ".ogg") suffix.
 				size_t end = path.length() - 4;
 				if(path[end - 1] == '~')
 					--end;
-				loadQueue[path.substr(root.length(), end - root.length())] = path;
+				string name = path.substr(root.length(), end - root.length());
+				bool isReferenced = sounds.count(name);
+				// Ogg files that no sound effect refers to are music, which is
+				// streamed by the Music class instead.
+				if(!isReferenced && !path.compare(path.length() - 4, 4, ".ogg"))
+					continue;
+				
+				LoadRequest &request = loadQueue[&sounds[name]];
+				request.sound = &sounds[name];
+				request.name = name;
+				request.path = path;
+				request.priority = isReferenced ? REFERENCED : LAZY;
+				request.isRequired = isReferenced;
 			}
 		}
 	}
-	// Begin loading the files.
-	if(!loadQueue.empty())
-		loadThread = thread(&Load);
+	for(const auto &it : loadQueue)
+		requiredTotal += it.second.isRequired;
+	requiredLeft = requiredTotal;
+	
+	// Begin loading the files, spread over a small pool of threads.
+	unsigned threadCount = min(MAX_LOAD_THREADS, max(1u, thread::hardware_concurrency()));
+	threadCount = min<size_t>(threadCount, loadQueue.size());
+	lock.unlock();
+	for(unsigned i = 0; i < threadCount; ++i)
+		loadThreads.emplace_back(&Load);
 	
 	// Create the music-streaming threads.
 	currentTrack.reset(new Music());
@@ -177,6 +287,10 @@ void Audio::Init(const vector<string> &sources)
 	}
 	alSourceQueueBuffers(musicSource, MUSIC_BUFFERS, musicBuffers);
 	alSourcePlay(musicSource);
+	
+	// From here on, the mixing thread does everything else.
+	isMixing = true;
+	mixThread = thread(&Mix);
 }
 
 
@@ -186,12 +300,12 @@ double Audio::GetProgress()
 {
 	unique_lock<mutex> lock(audioMutex);
 	
-	if(loadQueue.empty())
+	// Sounds that the game data does not refer to do not need to be loaded
+	// yet. If they are played, they will be loaded then.
+	if(!requiredLeft)
 		return 1.;
 	
-	double done = sounds.size();
-	double total = done + loadQueue.size();
-	return done / total;
+	return 1. - static_cast<double>(requiredLeft) / requiredTotal;
 }
 
 
@@ -204,12 +318,11 @@ double Audio::Volume()
 
 
 
-// Set the volume (to a value between 0 and 1).
+// Set the volume (to a value between 0 and 1). The mixing thread passes it
+// on to OpenAL.
 void Audio::SetVolume(double level)
 {
 	volume = min(1., max(0., level));
-	if(isInitialized)
-		alListenerf(AL_GAIN, volume);
 }
 
 
@@ -224,19 +337,19 @@ const Sound *Audio::Get(const string &name)
 
 
 
-// Set the listener's position, and also update any sounds that have been
-// added but deferred because they were added from a thread other than the
-// main one (the one that called Init()).
+// Ask for the given sound to be loaded ahead of the others, because it is
+// likely to be played soon.
+void Audio::Prefetch(const Sound *sound)
+{
+	Prioritize(sound, PREFETCHED);
+}
+
+
+
+// Set the listener's position.
 void Audio::Update(const Point &listenerPosition)
 {
-	if(!isInitialized)
-		return;
-	
 	listener = listenerPosition;
-	
-	for(const auto &it : deferred)
-		queue[it.first].Add(it.second);
-	deferred.clear();
 }
 
 
@@ -253,18 +366,24 @@ void Audio::Play(const Sound *sound)
 // "listener". This will make it softer and change the left / right balance.
 void Audio::Play(const Sound *sound, const Point &position)
 {
-	if(!isInitialized || !sound || !sound->Buffer() || !volume)
+	if(!isInitialized || !sound || !volume)
 		return;
-	
-	// Place sounds from the main thread directly into the queue. They are from
-	// the UI, and the Engine may not be running right now to call Update().
-	if(this_thread::get_id() == mainThreadID)
-		queue[sound].Add(position - listener);
-	else
+	// If this sound has not been loaded yet, skip it this time but load it
+	// next, so that it will be ready the next time it is played.
+	if(!sound->Buffer())
 	{
-		unique_lock<mutex> lock(audioMutex);
-		deferred[sound].Add(position - listener);
+		Prioritize(sound, PLAYED);
+		return;
+	}
+	// Don't spend any time on sounds that are too far away to be heard.
+	Point offset = position - listener;
+	if((offset * .002).LengthSquared() > AUDIBLE_RANGE * AUDIBLE_RANGE)
+	{
+		++culledSounds;
+		return;
 	}
+	
+	deferred.Push(sound, offset);
 }
 
 
@@ -275,8 +394,9 @@ void Audio::PlayMusic(const string &name)
 	if(!isInitialized)
 		return;
 	
-	// Don't worry about thread safety here, since music will always be started
-	// by the main thread.
+	// Music is always started by the main thread, but it is streamed by the
+	// mixing thread.
+	lock_guard<mutex> lock(musicMutex);
 	musicFade = 65536;
 	swap(currentTrack, previousTrack);
 	// If the name is empty, it means to turn music off.
@@ -285,137 +405,12 @@ void Audio::PlayMusic(const string &name)
 
 
 
-// Begin playing all the sounds that have been added since the last time
-// this function was called.
+// Mark the end of this frame's sounds. The mixing thread starts them all
+// together, once it reaches this mark.
 void Audio::Step()
 {
-	if(!isInitialized)
-		return;
-	
-	vector<Source> newSources;
-	// For each sound that is looping, see if it is going to continue. For other
-	// sounds, check if they are done playing.
-	for(const Source &source : sources)
-	{
-		if(source.GetSound()->IsLooping())
-		{
-			auto it = queue.find(source.GetSound());
-			if(it != queue.end())
-			{
-				source.Move(it->second);
-				newSources.push_back(source);
-				queue.erase(it);
-			}
-			else
-			{
-				alSourcei(source.ID(), AL_LOOPING, false);
-				endingSources.push_back(source.ID());
-			}
-		}
-		else
-		{
-			// Non-looping sounds: check if they're done playing.
-			ALint state;
-			alGetSourcei(source.ID(), AL_SOURCE_STATE, &state);
-			if(state == AL_PLAYING)
-				newSources.push_back(source);
-			else
-				recycledSources.push_back(source.ID());
-		}
-	}
-	// These sources were looping and are now wrapping up a loop.
-	auto it = endingSources.begin();
-	while(it != endingSources.end())
-	{
-		ALint state;
-		alGetSourcei(*it, AL_SOURCE_STATE, &state);
-		if(state == AL_PLAYING)
-		{
-			// Fade out the sound. This avoids a clicking or rasping sound if a
-			// sound is cut off in the middle of its loop.
-			float gain = 1.f;
-			alGetSourcef(*it, AL_GAIN, &gain);
-			gain = max(0.f, gain - .05f);
-			alSourcef(*it, AL_GAIN, gain);
-			++it;
-		}
-		else
-		{
-			recycledSources.push_back(*it);
-			it = endingSources.erase(it);
-		}
-	}
-	newSources.swap(sources);
-	
-	// Now, what is left in the queue is sounds that want to play, and that do
-	// not correspond to an existing source.
-	for(const auto &it : queue)
-	{
-		// Use a recycled source if possible. Otherwise, create a new one.
-		unsigned source = 0;
-		if(recycledSources.empty())
-		{
-			if(sources.size() >= maxSources)
-				break;
-			
-			alGenSources(1, &source);
-			if(!source)
-			{
-				// If we just tried to generate a new source and OpenAL would
-				// not give us one, we've reached this system's limit for the
-				// number of concurrent sounds.
-				maxSources = sources.size();
-				break;
-			}
-		}
-		else
-		{
-			source = recycledSources.back();
-			recycledSources.pop_back();
-		}
-		// Begin playing this sound.
-		sources.emplace_back(it.first, source);
-		sources.back().Move(it.second);
-		alSourcePlay(source);
-	}
-	queue.clear();
-	
-	// Queue up new buffers for the music, if necessary.
-	int buffersDone = 0;
-	alGetSourcei(musicSource, AL_BUFFERS_PROCESSED, &buffersDone);
-	if(buffersDone)
-	{
-		unsigned buffer = 0;
-		alSourceUnqueueBuffers(musicSource, 1, &buffer);
-		
-		const vector<int16_t> &chunk = currentTrack->NextChunk();
-		
-		if(!musicFade)
-			alBufferData(buffer, AL_FORMAT_STEREO16, &chunk.front(), 2 * chunk.size(), 44100);
-		else
-		{
-			fadeBuffer.clear();
-			const vector<int16_t> &other = previousTrack->NextChunk();
-			for(size_t i = 0; i < chunk.size(); ++i)
-			{
-				// Blend the two tracks together.
-				fadeBuffer.push_back(
-					(musicFade * other[i] + (65536 - musicFade) * chunk[i]) / 65536);
-				
-				// Slowly fade into the new track.
-				if(musicFade)
-					--musicFade;
-			}
-			alBufferData(buffer, AL_FORMAT_STEREO16, &fadeBuffer.front(), 2 * fadeBuffer.size(), 44100);
-		}
-		
-		alSourceQueueBuffers(musicSource, 1, &buffer);
-		// Check if the source has stopped (i.e. because it ran out of buffers).
-		ALint state;
-		alGetSourcei(musicSource, AL_SOURCE_STATE, &state);
-		if(state != AL_PLAYING)
-			alSourcePlay(musicSource);
-	}
+	if(isInitialized)
+		deferred.Push(nullptr, Point());
 }
 
 
@@ -423,17 +418,26 @@ void Audio::Step()
 // Shut down the audio system (because we're about to quit).
 void Audio::Quit()
 {
+	// Stop the mixing thread, so that nothing else is using OpenAL.
+	if(mixThread.joinable())
+	{
+		{
+			lock_guard<mutex> lock(mixMutex);
+			isMixing = false;
+		}
+		mixCondition.notify_all();
+		mixThread.join();
+	}
+	
 	// First, check if sounds are still being loaded in a separate thread, and
 	// if so interrupt that thread and wait for it to quit.
 	unique_lock<mutex> lock(audioMutex);
-	if(!loadQueue.empty())
-		loadQueue.clear();
-	if(loadThread.joinable())
-	{
-		lock.unlock();
+	loadQueue.clear();
+	lock.unlock();
+	for(thread &loadThread : loadThreads)
 		loadThread.join();
-		lock.lock();
-	}
+	loadThreads.clear();
+	lock.lock();
 	
 	// Now, stop and delete any OpenAL sources that are playing.
 	for(const Source &source : sources)
@@ -488,6 +492,61 @@ void Audio::Quit()
 
 
 namespace {
+	RequestQueue::RequestQueue()
+		: tail(0)
+	{
+		for(size_t i = 0; i < CAPACITY; ++i)
+			slots[i].sequence.store(i, memory_order_relaxed);
+	}
+	
+	
+	
+	// Add a request. If the queue is full, the request is dropped.
+	void RequestQueue::Push(const Sound *sound, const Point &offset)
+	{
+		size_t position = tail.load(memory_order_relaxed);
+		Slot *slot = nullptr;
+		while(true)
+		{
+			slot = &slots[position % CAPACITY];
+			size_t sequence = slot->sequence.load(memory_order_acquire);
+			if(sequence == position)
+			{
+				// This slot is free. Claim it, unless another thread does first.
+				if(tail.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+					break;
+			}
+			// The slot still holds a request that has not been read yet, so
+			// the queue is full.
+			else if(sequence < position)
+				return;
+			else
+				position = tail.load(memory_order_relaxed);
+		}
+		slot->sound = sound;
+		slot->offset = offset;
+		slot->sequence.store(position + 1, memory_order_release);
+	}
+	
+	
+	
+	// Take the oldest request out of the queue, if there is one.
+	bool RequestQueue::Pop(const Sound *&sound, Point &offset)
+	{
+		Slot &slot = slots[head % CAPACITY];
+		if(slot.sequence.load(memory_order_acquire) != head + 1)
+			return false;
+		
+		sound = slot.sound;
+		offset = slot.offset;
+		// Mark this slot as free for the next time around the ring.
+		slot.sequence.store(head + CAPACITY, memory_order_release);
+		++head;
+		return true;
+	}
+	
+	
+	
 	// Add a new source to this queue entry. Sources are weighted based on their
 	// position, and multiple sources can be added together in the same entry.
 	void QueueEntry::Add(Point position)
@@ -503,15 +562,6 @@ namespace {
 	
 	
 	
-	// Combine two queue entries.
-	void QueueEntry::Add(const QueueEntry &other)
-	{
-		sum += other.sum;
-		weight += other.weight;
-	}
-	
-	
-	
 	// This is a wrapper for an OpenAL audio source.
 	Source::Source(const Sound *sound, unsigned source)
 		: sound(sound), source(source)
@@ -519,7 +569,7 @@ namespace {
 		// Give each source a small, random pitch variation. Otherwise, multiple
 		// instances of the same sound playing at slightly different times
 		// overlap and create a "grinding" interference sound.
-		alSourcef(source, AL_PITCH, 1. + (Random::Real() - Random::Real()) * .04);
+		alSourcef(source, AL_PITCH, 1. + (pitchVariation.Real() - pitchVariation.Real()) * .04);
 		alSourcef(source, AL_GAIN, 1.);
 		alSourcef(source, AL_REFERENCE_DISTANCE, 1.);
 		alSourcef(source, AL_ROLLOFF_FACTOR, 1.);
@@ -558,34 +608,244 @@ namespace {
 	
 	
 	
+	// Thread entry point for mixing.
+	void Mix()
+	{
+		double gain = volume;
+		auto next = chrono::steady_clock::now();
+		unique_lock<mutex> lock(mixMutex);
+		while(isMixing)
+		{
+			// Keep to a fixed schedule, but if this thread falls behind, do not
+			// try to make up for the ticks that it missed.
+			next = max(next + MIX_TICK, chrono::steady_clock::now());
+			if(mixCondition.wait_until(lock, next, []() { return !isMixing; }))
+				break;
+			lock.unlock();
+			
+			if(gain != volume)
+			{
+				gain = volume;
+				alListenerf(AL_GAIN, gain);
+			}
+			
+			// Collect the requested sounds. Each frame's sounds are started as
+			// soon as the end of that frame is reached, and any sounds from a
+			// frame that is still in progress wait for the next tick.
+			const Sound *sound = nullptr;
+			Point offset;
+			while(deferred.Pop(sound, offset))
+			{
+				if(sound)
+					queue[sound].Add(offset);
+				else
+					StartSounds();
+			}
+			StreamMusic();
+			
+			lock.lock();
+		}
+	}
+	
+	
+	
+	// Start all the sounds that one frame asked for.
+	void StartSounds()
+	{
+		vector<Source> newSources;
+		// For each sound that is looping, see if it is going to continue. For other
+		// sounds, check if they are done playing.
+		for(const Source &source : sources)
+		{
+			if(source.GetSound()->IsLooping())
+			{
+				auto it = queue.find(source.GetSound());
+				if(it != queue.end())
+				{
+					source.Move(it->second);
+					newSources.push_back(source);
+					queue.erase(it);
+				}
+				else
+				{
+					alSourcei(source.ID(), AL_LOOPING, false);
+					endingSources.push_back(source.ID());
+				}
+			}
+			else
+			{
+				// Non-looping sounds: check if they're done playing.
+				ALint state;
+				alGetSourcei(source.ID(), AL_SOURCE_STATE, &state);
+				if(state == AL_PLAYING)
+					newSources.push_back(source);
+				else
+					recycledSources.push_back(source.ID());
+			}
+		}
+		// These sources were looping and are now wrapping up a loop.
+		auto it = endingSources.begin();
+		while(it != endingSources.end())
+		{
+			ALint state;
+			alGetSourcei(*it, AL_SOURCE_STATE, &state);
+			if(state == AL_PLAYING)
+			{
+				// Fade out the sound. This avoids a clicking or rasping sound if a
+				// sound is cut off in the middle of its loop.
+				float gain = 1.f;
+				alGetSourcef(*it, AL_GAIN, &gain);
+				gain = max(0.f, gain - .05f);
+				alSourcef(*it, AL_GAIN, gain);
+				++it;
+			}
+			else
+			{
+				recycledSources.push_back(*it);
+				it = endingSources.erase(it);
+			}
+		}
+		newSources.swap(sources);
+		
+		// Now, what is left in the queue is sounds that want to play, and that do
+		// not correspond to an existing source. If there are not enough voices for
+		// all of them, start with the ones that are loudest (i.e. the nearest, or
+		// the ones that were requested the most times).
+		vector<pair<const Sound *, const QueueEntry *>> requests;
+		requests.reserve(queue.size());
+		for(const auto &it : queue)
+			requests.emplace_back(it.first, &it.second);
+		sort(requests.begin(), requests.end(),
+			[](const pair<const Sound *, const QueueEntry *> &a, const pair<const Sound *, const QueueEntry *> &b)
+			{
+				return a.second->weight > b.second->weight;
+			});
+		size_t started = 0;
+		for(const auto &it : requests)
+		{
+			if(sources.size() >= VOICE_BUDGET)
+				break;
+			// Use a recycled source if possible. Otherwise, create a new one.
+			unsigned source = 0;
+			if(recycledSources.empty())
+			{
+				if(sources.size() >= maxSources)
+					break;
+				
+				alGenSources(1, &source);
+				if(!source)
+				{
+					// If we just tried to generate a new source and OpenAL would
+					// not give us one, we've reached this system's limit for the
+					// number of concurrent sounds.
+					maxSources = sources.size();
+					break;
+				}
+			}
+			else
+			{
+				source = recycledSources.back();
+				recycledSources.pop_back();
+			}
+			// Begin playing this sound.
+			sources.emplace_back(it.first, source);
+			sources.back().Move(*it.second);
+			alSourcePlay(source);
+			++started;
+		}
+		queue.clear();
+		
+		// Report how many voices are in use, and how many sounds were skipped.
+		Profiler::SetCounter("Sound voices", sources.size() + endingSources.size());
+		Profiler::SetCounter("Sounds culled", culledSounds.exchange(0));
+		Profiler::SetCounter("Sounds over budget", requests.size() - started);
+	}
+	
+	
+	
+	// Queue up new buffers for the music, if necessary.
+	void StreamMusic()
+	{
+		lock_guard<mutex> lock(musicMutex);
+		int buffersDone = 0;
+		alGetSourcei(musicSource, AL_BUFFERS_PROCESSED, &buffersDone);
+		if(buffersDone)
+		{
+			unsigned buffer = 0;
+			alSourceUnqueueBuffers(musicSource, 1, &buffer);
+			
+			const vector<int16_t> &chunk = currentTrack->NextChunk();
+			
+			if(!musicFade)
+				alBufferData(buffer, AL_FORMAT_STEREO16, &chunk.front(), 2 * chunk.size(), 44100);
+			else
+			{
+				fadeBuffer.clear();
+				const vector<int16_t> &other = previousTrack->NextChunk();
+				for(size_t i = 0; i < chunk.size(); ++i)
+				{
+					// Blend the two tracks together.
+					fadeBuffer.push_back(
+						(musicFade * other[i] + (65536 - musicFade) * chunk[i]) / 65536);
+					
+					// Slowly fade into the new track.
+					if(musicFade)
+						--musicFade;
+				}
+				alBufferData(buffer, AL_FORMAT_STEREO16, &fadeBuffer.front(), 2 * fadeBuffer.size(), 44100);
+			}
+			
+			alSourceQueueBuffers(musicSource, 1, &buffer);
+			// Check if the source has stopped (i.e. because it ran out of buffers).
+			ALint state;
+			alGetSourcei(musicSource, AL_SOURCE_STATE, &state);
+			if(state != AL_PLAYING)
+				alSourcePlay(musicSource);
+		}
+	}
+	
+	
+	
 	// Thread entry point for loading sounds.
 	void Load()
 	{
-		string name;
-		string path;
-		Sound *sound;
+		LoadRequest request;
 		while(true)
 		{
 			{
 				unique_lock<mutex> lock(audioMutex);
-				// If this is not the first time through, remove the previous item
-				// in the queue. This is a signal that it has been loaded, so we
-				// must not remove it until after loading the file.
-				if(!path.empty() && !loadQueue.empty())
-					loadQueue.erase(loadQueue.begin());
+				// If this is not the first time through, the previous file is
+				// now done loading.
+				if(request.isRequired)
+					--requiredLeft;
 				if(loadQueue.empty())
 					return;
-				name = loadQueue.begin()->first;
-				path = loadQueue.begin()->second;
-
-				// Since we need to unlock the mutex below, create the map entry to
-				// avoid a race condition when accessing sounds' size.
-				sound = &sounds[name];
+				
+				// Take the highest priority file out of the queue. The queue is
+				// short enough that a linear search is fine.
+				auto next = loadQueue.begin();
+				for(auto it = loadQueue.begin(); it != loadQueue.end(); ++it)
+					if(it->second.priority > next->second.priority)
+						next = it;
+				request = next->second;
+				loadQueue.erase(next);
 			}
 			
 			// Unlock the mutex for the time-intensive part of the loop.
-			if(!sound->Load(path, name))
-				Files::LogError("Unable to load sound \"" + name + "\" from path: " + path);
+			Profiler::Scope profile("Load sound");
+			if(!request.sound->Load(request.path, request.name))
+				Files::LogError("Unable to load sound \"" + request.name + "\" from path: " + request.path);
 		}
 	}
+	
+	
+	
+	// If the given sound is still waiting to be loaded, raise its priority.
+	void Prioritize(const Sound *sound, int priority)
+	{
+		unique_lock<mutex> lock(audioMutex);
+		auto it = loadQueue.find(sound);
+		if(it != loadQueue.end())
+			it->second.priority = max(it->second.priority, priority);
+	}
 }
@@ -27,10 +27,12 @@ class Sound;
 // "source" at a certain position, and their volume and left / right balance is
 // adjusted based on how far they are from the observer. Sounds that are not
 // marked as looping will play once, then stop; looping sounds continue until
-// their source stops calling the "play" function for them.
+// their source stops calling the "play" function for them. The sounds are
+// started, and the music is streamed, by a separate mixing thread, so that the
+// main loop never has to wait for OpenAL.
 class Audio {
 public:
-	// Begin loading sounds (in a separate thread).
+	// Begin loading sounds (in separate threads).
 	static void Init(const std::vector<std::string> &sources);
 	
 	// Report the progress of loading sounds.
@@ -44,13 +46,15 @@ public:
 	// "sound/" folder, and without ~ if it's on the end, or the extension.
 	// Do not call this function until Progress() is 100%.
 	static const Sound *Get(const std::string &name);
+	// Ask for the given sound to be loaded ahead of the others, because it is
+	// likely to be played soon.
+	static void Prefetch(const Sound *sound);
 	
-	// Set the listener's position, and also update any sounds that have been
-	// added but deferred because they were added from a thread other than the
-	// main one (the one that called Init()).
+	// Set the listener's position.
 	static void Update(const Point &listenerPosition);
 	
-	// Play the given sound, at full volume.
+	// Play the given sound, at full volume. A sound that has not been loaded
+	// yet is skipped, but will be loaded before any others.
 	static void Play(const Sound *sound);
 	
 	// Play the given sound, as if it is at the given distance from the
@@ -60,8 +64,8 @@ public:
 	// Play the given music. An empty string means to play nothing.
 	static void PlayMusic(const std::string &name);
 	
-	// Begin playing all the sounds that have been added since the last time
-	// this function was called.
+	// Mark the end of a frame. All the sounds that have been added since the
+	// last time this function was called will begin playing together.
 	static void Step();
 	
 	// Shut down the audio system (because we're about to quit).
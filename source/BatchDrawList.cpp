@@ -17,18 +17,22 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Screen.h"
 #include "Sprite.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
 
 namespace {
-	void Push(vector<float> &v, const Point &pos, float s, float t, float frame)
+	// Each sprite takes up six vertices of five floats each.
+	const size_t SPRITE_SIZE = 30;
+	
+	void Push(float *&out, const Point &pos, float s, float t, float frame)
 	{
-		v.push_back(pos.X());
-		v.push_back(pos.Y());
-		v.push_back(s);
-		v.push_back(t);
-		v.push_back(frame);
+		Float2(pos).Store(out);
+		out[2] = s;
+		out[3] = t;
+		out[4] = frame;
+		out += 5;
 	}
 }
 
@@ -37,7 +41,20 @@ namespace {
 // Clear the list, also setting the global time step for animation.
 void BatchDrawList::Clear(int step, double zoom)
 {
-	data.clear();
+	for(auto it = data.begin(); it != data.end(); )
+	{
+		if(it->second.empty())
+		{
+			velocities.erase(it->first);
+			it = data.erase(it);
+		}
+		else
+		{
+			it->second.clear();
+			velocities[it->first].clear();
+			++it;
+		}
+	}
 	this->step = step;
 	this->zoom = zoom;
 	isHighDPI = (Screen::IsHighResolution() ? zoom > .5 : zoom > 1.);
@@ -45,9 +62,10 @@ void BatchDrawList::Clear(int step, double zoom)
 
 
 
-void BatchDrawList::SetCenter(const Point &center)
+void BatchDrawList::SetCenter(const Point &center, const Point &centerVelocity)
 {
 	this->center = center;
+	this->centerVelocity = centerVelocity;
 }
 
 
@@ -78,13 +96,71 @@ bool BatchDrawList::AddVisual(const Body &visual)
 
 
 
+// Add all the items from another list.
+void BatchDrawList::Append(const BatchDrawList &other)
+{
+	for(const auto &it : other.data)
+		if(!it.second.empty())
+		{
+			vector<float> &v = data[it.first];
+			v.insert(v.end(), it.second.begin(), it.second.end());
+			const vector<Float2> &otherVelocities = other.velocities.at(it.first);
+			vector<Float2> &velocity = velocities[it.first];
+			velocity.insert(velocity.end(), otherVelocities.begin(), otherVelocities.end());
+		}
+}
+
+
+
 // Draw all the items in this list.
-void BatchDrawList::Draw() const
+void BatchDrawList::Draw(double fraction) const
 {
+	// Upload the vertices for all the sprites at once, one sprite after another.
+	size_t size = 0;
+	for(const pair<const Sprite * const, vector<float>> &it : data)
+		size += it.second.size();
+	
 	BatchShader::Bind();
 	
-	for(const pair<const Sprite * const, vector<float>> &it : data)
-		BatchShader::Add(it.first, isHighDPI, it.second);
+	float *out = BatchShader::Map(size);
+	if(out)
+	{
+		float *next = out;
+		for(const pair<const Sprite * const, vector<float>> &it : data)
+		{
+			if(!fraction)
+			{
+				next = copy(it.second.begin(), it.second.end(), next);
+				continue;
+			}
+			
+			// Move all six vertices of each sprite by the same offset. (The
+			// mapped buffer is write-only, so this is done while copying.)
+			const float *in = it.second.data();
+			for(const Float2 &velocity : velocities.at(it.first))
+			{
+				float dx = velocity.X() * static_cast<float>(fraction);
+				float dy = velocity.Y() * static_cast<float>(fraction);
+				for(int i = 0; i < 6; ++i, in += 5, next += 5)
+				{
+					next[0] = in[0] + dx;
+					next[1] = in[1] + dy;
+					copy(in + 2, in + 5, next + 2);
+				}
+			}
+		}
+		
+		if(BatchShader::Unmap())
+		{
+			// Then draw each sprite's part of the data.
+			size_t first = 0;
+			for(const pair<const Sprite * const, vector<float>> &it : data)
+			{
+				BatchShader::Add(it.first, isHighDPI, first, it.second.size());
+				first += it.second.size();
+			}
+		}
+	}
 	
 	BatchShader::Unbind();
 }
@@ -121,6 +197,7 @@ bool BatchDrawList::Add(const Body &body, Point position, float clip)
 	
 	// Get the data vector for this particular sprite.
 	vector<float> &v = data[body.GetSprite()];
+	velocities[body.GetSprite()].emplace_back((body.Velocity() - centerVelocity) * zoom);
 	// The sprite frame is the same for every vertex.
 	float frame = body.GetFrame(step);
 	
@@ -141,13 +218,15 @@ bool BatchDrawList::Add(const Body &body, Point position, float clip)
 	Point bottomRight = bottomLeft + uw;
 	
 	// Push two copies of the first and last vertices to mark the break between
-	// the sprites.
-	Push(v, topLeft, 0.f, 1.f, frame);
-	Push(v, topLeft, 0.f, 1.f, frame);
-	Push(v, topRight, 1.f, 1.f, frame);
-	Push(v, bottomLeft, 0.f, 1.f - clip, frame);
-	Push(v, bottomRight, 1.f, 1.f - clip, frame);
-	Push(v, bottomRight, 1.f, 1.f - clip, frame);
+	// the sprites. Make room for all six vertices at once, then fill them in.
+	v.resize(v.size() + SPRITE_SIZE);
+	float *out = &v[v.size() - SPRITE_SIZE];
+	Push(out, topLeft, 0.f, 1.f, frame);
+	Push(out, topLeft, 0.f, 1.f, frame);
+	Push(out, topRight, 1.f, 1.f, frame);
+	Push(out, bottomLeft, 0.f, 1.f - clip, frame);
+	Push(out, bottomRight, 1.f, 1.f - clip, frame);
+	Push(out, bottomRight, 1.f, 1.f - clip, frame);
 	
 	return true;
 }
@@ -29,14 +29,19 @@ class BatchDrawList {
 public:
 	// Clear the list, also setting the global time step for animation.
 	void Clear(int step = 0, double zoom = 1.);
-	void SetCenter(const Point &center);
+	void SetCenter(const Point &center, const Point &centerVelocity = Point());
 	
 	// Add an unswizzled object based on the Body class.
 	bool Add(const Body &body, float clip = 1.f);
 	bool AddVisual(const Body &visual);
+	// Add all the items from another list that was built with the same step,
+	// zoom, and center. This allows parts of a list to be built on different
+	// threads and then combined in order.
+	void Append(const BatchDrawList &other);
 	
-	// Draw all the items in this list.
-	void Draw() const;
+	// Draw all the items in this list. If a fraction of a step is given, each
+	// item is moved that far along its velocity relative to the center.
+	void Draw(double fraction = 0.) const;
 	
 	
 private:
@@ -52,12 +57,17 @@ private:
 	double zoom = 1.;
 	bool isHighDPI = false;
 	Point center;
+	Point centerVelocity;
 	
 	// Each sprite consists of six vertices (four vertices to form a quad and
 	// two dummy vertices to mark the break in between them). Each of those
 	// vertices has five attributes: (x, y) position in pixels, (s, t) texture
-	// coordinates, and the index of the sprite frame.
+	// coordinates, and the index of the sprite frame. The vectors are kept from
+	// one frame to the next, so they do not need to be allocated again, until
+	// a sprite has gone a whole frame without being drawn.
 	std::map<const Sprite *, std::vector<float>> data;
+	// The velocity of each of those sprites, in pixels per step.
+	std::map<const Sprite *, std::vector<Float2>> velocities;
 };
 
 
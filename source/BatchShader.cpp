@@ -12,6 +12,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "BatchShader.h"
 
+#include "GpuProfiler.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 #include "Sprite.h"
@@ -23,12 +25,25 @@ namespace {
 	// Uniforms:
 	GLint scaleI;
 	GLint frameCountI;
+	GLint firstLayerI;
 	// Vertex data:
 	GLint vertI;
 	GLint texCoordI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each vertex has five floats: the (x, y) position and the (s, t, frame)
+	// texture coordinates.
+	constexpr size_t FLOATS_PER_VERTEX = 5;
+	// The vertex buffer is used as a ring: each batch is written just past the
+	// previous one, so the driver never has to wait for the GPU to be done with
+	// earlier data. Once the end is reached, the buffer's storage is orphaned
+	// and writing starts over at the beginning.
+	size_t capacity = 1 << 22;
+	size_t offset = 0;
+	// The index of the first vertex of the most recently mapped data.
+	size_t firstVertex = 0;
 }
 
 
@@ -53,6 +68,7 @@ void BatchShader::Init()
 		"// fragment batch shader\n"
 		"uniform sampler2DArray tex;\n"
 		"uniform float frameCount;\n"
+		"uniform float firstLayer;\n"
 		
 		"in vec3 fragTexCoord;\n"
 		
@@ -63,8 +79,8 @@ void BatchShader::Init()
 		"  float second = mod(ceil(fragTexCoord.z), frameCount);\n"
 		"  float fade = fragTexCoord.z - first;\n"
 		"  finalColor = mix(\n"
-		"    texture(tex, vec3(fragTexCoord.xy, first)),\n"
-		"    texture(tex, vec3(fragTexCoord.xy, second)), fade);\n"
+		"    texture(tex, vec3(fragTexCoord.xy, first + firstLayer)),\n"
+		"    texture(tex, vec3(fragTexCoord.xy, second + firstLayer)), fade);\n"
 		"}\n";
 	
 	// Compile the shaders.
@@ -72,6 +88,7 @@ void BatchShader::Init()
 	// Get the indices of the uniforms and attributes.
 	scaleI = shader.Uniform("scale");
 	frameCountI = shader.Uniform("frameCount");
+	firstLayerI = shader.Uniform("firstLayer");
 	vertI = shader.Attrib("vert");
 	texCoordI = shader.Attrib("texCoord");
 	
@@ -86,9 +103,10 @@ void BatchShader::Init()
 	
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
 	
 	// In this VAO, enable the two vertex arrays and specify their byte offsets.
-	constexpr auto stride = 5 * sizeof(float);
+	constexpr auto stride = FLOATS_PER_VERTEX * sizeof(float);
 	glEnableVertexAttribArray(vertI);
 	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, stride, nullptr);
 	// The 3 texture fields (s, t, frame) come after the x,y pixel fields.
@@ -106,6 +124,7 @@ void BatchShader::Init()
 
 void BatchShader::Bind()
 {
+	RenderQueue::Flush();
 	glUseProgram(shader.Object());
 	glBindVertexArray(vao);
 	// Bind the vertex buffer so we can upload data to it.
@@ -118,22 +137,67 @@ void BatchShader::Bind()
 
 
 
-void BatchShader::Add(const Sprite *sprite, bool isHighDPI, const vector<float> &data)
+// Get a pointer that the given number of floats of vertex data can be written
+// to. This must be called after Bind().
+float *BatchShader::Map(size_t size)
 {
-	// Do nothing if there are no sprites to draw.
-	if(data.empty())
+	size_t bytes = size * sizeof(float);
+	if(!bytes)
+		return nullptr;
+	
+	// If there is not enough room left in the buffer, give it new storage. The
+	// old storage will be freed once the GPU is done drawing from it.
+	if(offset + bytes > capacity)
+	{
+		while(capacity < bytes)
+			capacity *= 2;
+		glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+		offset = 0;
+	}
+	
+	// Nothing that has already been drawn is in this range of the buffer, so
+	// there is no need to synchronize with the GPU.
+	void *data = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if(!data)
+		return nullptr;
+	GpuProfiler::CountUpload();
+	
+	firstVertex = offset / (FLOATS_PER_VERTEX * sizeof(float));
+	offset += bytes;
+	return reinterpret_cast<float *>(data);
+}
+
+
+
+// Finish writing the mapped data. If this returns false, the data was lost
+// and nothing should be drawn from it.
+bool BatchShader::Unmap()
+{
+	return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+}
+
+
+
+void BatchShader::Add(const Sprite *sprite, bool isHighDPI, size_t first, size_t size)
+{
+	// Do nothing if there are no sprites to draw, or if this sprite's textures
+	// have been unloaded.
+	uint32_t texture = sprite->Texture(isHighDPI);
+	if(!size || !texture)
 		return;
 	
 	// First, bind the proper texture.
-	glBindTexture(GL_TEXTURE_2D_ARRAY, sprite->Texture(isHighDPI));
-	// The shader also needs to know how many frames the texture has.
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	GpuProfiler::CountBind();
+	// The shader also needs to know how many frames the sprite has, and where
+	// they are in the texture.
 	glUniform1f(frameCountI, sprite->Frames());
-	
-	// Upload the vertex data.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * data.size(), data.data(), GL_STREAM_DRAW);
+	glUniform1f(firstLayerI, sprite->FirstLayer(isHighDPI));
 	
 	// Draw all the vertices.
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, data.size() / 5);
+	glDrawArrays(GL_TRIANGLE_STRIP, firstVertex + first / FLOATS_PER_VERTEX, size / FLOATS_PER_VERTEX);
+	GpuProfiler::CountDraw();
 }
 
 
@@ -15,19 +15,28 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 class Sprite;
 
-#include <vector>
+#include <cstddef>
 
 
 
-// Class for drawing sprites in a batch. The input to each draw command is a
-// sprite, whether it should be drawn high DPI, and the vertex data.
+// Class for drawing sprites in a batch. The vertex data for every sprite in the
+// batch is first written to a single stream, and then each draw command is given
+// a sprite, whether it should be drawn high DPI, and where its vertices are in
+// that stream.
 class BatchShader {
 public:
 	// Initialize the shaders.
 	static void Init();
 	
 	static void Bind();
-	static void Add(const Sprite *sprite, bool isHighDPI, const std::vector<float> &data);
+	// Get a pointer that the given number of floats of vertex data can be
+	// written to, or null if the vertex buffer could not be mapped. The data
+	// is not uploaded until Unmap() is called.
+	static float *Map(size_t size);
+	static bool Unmap();
+	// Draw the given range of the vertices, counted in floats from the start of
+	// the most recently mapped data.
+	static void Add(const Sprite *sprite, bool isHighDPI, size_t first, size_t size);
 	static void Unbind();
 };
 
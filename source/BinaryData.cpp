@@ -0,0 +1,132 @@
+/* BinaryData.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "BinaryData.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace {
+	void WriteInt(uint64_t value, int bytes, string &out)
+	{
+		for(int i = 0; i < bytes; ++i)
+			out += static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+	
+	bool ReadInt(const string &data, size_t &pos, int bytes, uint64_t &value)
+	{
+		if(data.size() - pos < static_cast<size_t>(bytes))
+			return false;
+		
+		value = 0;
+		for(int i = 0; i < bytes; ++i)
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+		pos += bytes;
+		return true;
+	}
+}
+
+
+
+void BinaryData::Write32(uint32_t value, string &out)
+{
+	WriteInt(value, 4, out);
+}
+
+
+
+void BinaryData::Write64(uint64_t value, string &out)
+{
+	WriteInt(value, 8, out);
+}
+
+
+
+// Doubles are stored as their bit pattern, so they are read back exactly.
+void BinaryData::WriteDouble(double value, string &out)
+{
+	uint64_t bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	Write64(bits, out);
+}
+
+
+
+void BinaryData::WriteString(const string &value, string &out)
+{
+	Write32(value.size(), out);
+	out += value;
+}
+
+
+
+bool BinaryData::Read32(const string &data, size_t &pos, uint32_t &value)
+{
+	uint64_t result = 0;
+	if(!ReadInt(data, pos, 4, result))
+		return false;
+	value = result;
+	return true;
+}
+
+
+
+bool BinaryData::Read64(const string &data, size_t &pos, uint64_t &value)
+{
+	return ReadInt(data, pos, 8, value);
+}
+
+
+
+bool BinaryData::ReadDouble(const string &data, size_t &pos, double &value)
+{
+	uint64_t bits = 0;
+	if(!Read64(data, pos, bits))
+		return false;
+	memcpy(&value, &bits, sizeof(value));
+	return true;
+}
+
+
+
+bool BinaryData::ReadString(const string &data, size_t &pos, string &value)
+{
+	uint32_t size = 0;
+	if(!Read32(data, pos, size) || data.size() - pos < size)
+		return false;
+	
+	value.assign(data, pos, size);
+	pos += size;
+	return true;
+}
+
+
+
+// Get a 64-bit FNV-1a hash of the given data.
+uint64_t BinaryData::Hash(const string &data)
+{
+	return Hash(data.data(), data.size());
+}
+
+
+
+uint64_t BinaryData::Hash(const char *data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for(size_t i = 0; i < size; ++i)
+	{
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
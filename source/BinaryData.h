@@ -0,0 +1,46 @@
+/* BinaryData.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef BINARY_DATA_H_
+#define BINARY_DATA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+
+// Functions for storing numbers and strings in the binary cache files. All
+// numbers are stored in little-endian order, so that a cache can be read back
+// no matter what platform wrote it. Each of the read functions returns false
+// if there is not enough data left to read, and advances the position past
+// the value otherwise.
+class BinaryData {
+public:
+	static void Write32(uint32_t value, std::string &out);
+	static void Write64(uint64_t value, std::string &out);
+	static void WriteDouble(double value, std::string &out);
+	static void WriteString(const std::string &value, std::string &out);
+	
+	static bool Read32(const std::string &data, size_t &pos, uint32_t &value);
+	static bool Read64(const std::string &data, size_t &pos, uint64_t &value);
+	static bool ReadDouble(const std::string &data, size_t &pos, double &value);
+	static bool ReadString(const std::string &data, size_t &pos, std::string &value);
+	
+	// Get a 64-bit FNV-1a hash of the given data.
+	static uint64_t Hash(const std::string &data);
+	static uint64_t Hash(const char *data, size_t size);
+};
+
+
+
+#endif
@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Body.h"
 
+#include "BinaryData.h"
 #include "DataNode.h"
 #include "DataWriter.h"
 #include "Random.h"
@@ -24,6 +25,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+	// Get a random fraction for a body's starting frame. The body's first step
+	// may be set on any thread, so instead of drawing from that thread's
+	// generator, this uses a stream keyed on where the body is and when, which
+	// gives the same result no matter which thread asks.
+	double RandomStart(const Point &position, const Point &velocity, const Angle &angle, float frameRate, int step)
+	{
+		const double key[] = {position.X(), position.Y(), velocity.X(), velocity.Y(),
+			angle.Degrees(), frameRate, static_cast<double>(step)};
+		return Random::Stream(BinaryData::Hash(reinterpret_cast<const char *>(key), sizeof(key))).Real();
+	}
+}
+
 
 
 // Constructor, based on a Sprite.
@@ -313,25 +327,15 @@ void Body::SetStep(int step) const
 		return;
 	currentStep = step;
 	
-	// If the sprite only has one frame, no need to animate anything.
-	float frames = sprite->Frames();
-	if(frames <= 1.f)
-	{
-		frame = 0.f;
-		return;
-	}
-	float lastFrame = frames - 1.f;
-	// This is the number of frames per full cycle. If rewinding, a full cycle
-	// includes the first and last frames once and every other frame twice.
-	float cycle = (rewind ? 2.f * lastFrame : frames) + delay;
-	
 	// If this is the very first step, fill in some values that we could not set
 	// until we knew the sprite's frame count and the starting step.
 	if(randomize)
 	{
 		randomize = false;
 		// The random offset can be a fractional frame.
-		frameOffset += static_cast<float>(Random::Real()) * cycle;
+		float frames = sprite->Frames();
+		float cycle = (rewind ? 2.f * (frames - 1.f) : frames) + delay;
+		frameOffset += static_cast<float>(RandomStart(position, velocity, angle, frameRate, step)) * cycle;
 	}
 	else if(startAtZero)
 	{
@@ -340,9 +344,26 @@ void Body::SetStep(int step) const
 		frameOffset -= frameRate * step;
 	}
 	
+	frame = FrameAt(step);
+}
+
+
+
+// Calculate the frame for the given step.
+float Body::FrameAt(int step) const
+{
+	// If the sprite only has one frame, no need to animate anything.
+	float frames = sprite->Frames();
+	if(frames <= 1.f)
+		return 0.f;
+	float lastFrame = frames - 1.f;
+	// This is the number of frames per full cycle. If rewinding, a full cycle
+	// includes the first and last frames once and every other frame twice.
+	float cycle = (rewind ? 2.f * lastFrame : frames) + delay;
+	
 	// Figure out what fraction of the way in between frames we are. Avoid any
 	// possible floating-point glitches that might result in a negative frame.
-	frame = max(0.f, frameRate * step + frameOffset);
+	float frame = max(0.f, frameRate * step + frameOffset);
 	// If repeating, wrap the frame index by the total cycle time.
 	if(repeat)
 		frame = fmod(frame, cycle);
@@ -366,4 +387,5 @@ void Body::SetStep(int step) const
 		// be less than 0, clamp it to 0.
 		frame = max(0.f, lastFrame * 2.f - frame);
 	}
+	return frame;
 }
@@ -50,6 +50,11 @@ public:
 	// Get the sprite and mask for the given time step.
 	float GetFrame(int step = -1) const;
 	const Mask &GetMask(int step = -1) const;
+	// Set what animation step we're on. This affects future calls to GetMask()
+	// and GetFrame(). Once this has been called for a step, asking for that
+	// step's frame or mask does not modify this object, so it is safe to do so
+	// from several threads at once.
+	void SetStep(int step) const;
 	
 	// Positional attributes.
 	const Point &Position() const;
@@ -99,9 +104,9 @@ protected:
 	
 	
 private:
-	// Set what animation step we're on. This affects future calls to GetMask()
-	// and GetFrame().
-	void SetStep(int step) const;
+	// Calculate the frame for the given step, which must already have had the
+	// animation pause subtracted from it. This does not modify anything.
+	float FrameAt(int step) const;
 	
 	
 private:
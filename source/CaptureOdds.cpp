@@ -113,34 +113,38 @@ void CaptureOdds::Calculate()
 	if(powerD.empty() || powerA.empty())
 		return;
 	
-	// The first row represents the case where the attacker has only one crew left.
-	// In that case, the defending ship can never be successfully captured.
-	capture.resize(powerD.size(), 0.);
-	casualtiesA.resize(powerD.size(), 0.);
-	casualtiesD.resize(powerD.size(), 0.);
-	unsigned up = 0;
-	for(unsigned a = 2; a <= powerA.size(); ++a)
+	// Allocate the whole table at once, since a ship with a large crew needs
+	// a very large one. The first row represents the case where the attacker
+	// has only one crew left. In that case, the defending ship can never be
+	// successfully captured.
+	const size_t columns = powerD.size();
+	const size_t size = powerA.size() * columns;
+	capture.assign(size, 0.);
+	casualtiesA.assign(size, 0.);
+	casualtiesD.assign(size, 0.);
+	for(size_t a = 1; a < powerA.size(); ++a)
 	{
-		double ap = powerA[a - 1];
+		const double ap = powerA[a];
+		const size_t row = a * columns;
+		const size_t up = row - columns;
+		
 		// Special case: odds for defender having only one person,
 		// because 0 people is outside the end of the table.
 		double odds = ap / (ap + powerD[0]);
-		capture.push_back(odds + (1. - odds) * capture[up]);
-		casualtiesA.push_back((1. - odds) * (casualtiesA[up] + 1.));
-		casualtiesD.push_back(odds + (1. - odds) * casualtiesD[up]);
-		++up;
+		capture[row] = odds + (1. - odds) * capture[up];
+		casualtiesA[row] = (1. - odds) * (casualtiesA[up] + 1.);
+		casualtiesD[row] = odds + (1. - odds) * casualtiesD[up];
 		
 		// Loop through each number of crew the defender might have.
-		for(unsigned d = 2; d <= powerD.size(); ++d)
+		for(size_t d = 1; d < columns; ++d)
 		{
 			// This is  basic 2D dynamic program, where each value is based on
 			// the odds of success and the values for one fewer crew members
 			// for the defender or the attacker depending on who wins.
-			odds = ap / (ap + powerD[d - 1]);
-			capture.push_back(odds * capture.back() + (1. - odds) * capture[up]);
-			casualtiesA.push_back(odds * casualtiesA.back() + (1. - odds) * (casualtiesA[up] + 1.));
-			casualtiesD.push_back(odds * (casualtiesD.back() + 1.) + (1. - odds) * casualtiesD[up]);
-			++up;
+			odds = ap / (ap + powerD[d]);
+			capture[row + d] = odds * capture[row + d - 1] + (1. - odds) * capture[up + d];
+			casualtiesA[row + d] = odds * casualtiesA[row + d - 1] + (1. - odds) * (casualtiesA[up + d] + 1.);
+			casualtiesD[row + d] = odds * (casualtiesD[row + d - 1] + 1.) + (1. - odds) * casualtiesD[up + d];
 		}
 	}
 }
@@ -151,9 +155,9 @@ void CaptureOdds::Calculate()
 // row in the table for 0 crew on either ship.
 int CaptureOdds::Index(int attackingCrew, int defendingCrew) const
 {
-	if(static_cast<unsigned>(attackingCrew - 1) > powerA.size())
+	if(static_cast<unsigned>(attackingCrew - 1) >= powerA.size())
 		return -1;
-	if(static_cast<unsigned>(defendingCrew - 1) > powerD.size())
+	if(static_cast<unsigned>(defendingCrew - 1) >= powerD.size())
 		return -1;
 	
 	return (attackingCrew - 1) * powerD.size() + (defendingCrew - 1);
@@ -56,6 +56,7 @@ void CargoHold::Clear()
 	outfits.clear();
 	missionCargo.clear();
 	passengers.clear();
+	UpdateSizes();
 }
 
 
@@ -86,6 +87,7 @@ void CargoHold::Load(const DataNode &node)
 			}
 		}
 	}
+	UpdateSizes();
 }
 
 
@@ -186,10 +188,7 @@ int CargoHold::Used() const
 // Get the total number of tons of commodities.
 int CargoHold::CommoditiesSize() const
 {
-	int size = 0;
-	for(const auto &it : commodities)
-		size += it.second;
-	return size;
+	return commoditiesSize;
 }
 
 
@@ -197,10 +196,7 @@ int CargoHold::CommoditiesSize() const
 // Get the total mass of outfit cargo, rounded up to the nearest ton.
 int CargoHold::OutfitsSize() const
 {
-	double size = 0.;
-	for(const auto &it : outfits)
-		size += it.second * it.first->Mass();
-	return ceil(size);
+	return outfitsSize;
 }
 
 
@@ -223,10 +219,7 @@ bool CargoHold::HasOutfits() const
 // Get the total mass of mission cargo.
 int CargoHold::MissionCargoSize() const
 {
-	int size = 0;
-	for(const auto &it : missionCargo)
-		size += it.second;
-	return size;
+	return missionCargoSize;
 }
 
 
@@ -357,6 +350,7 @@ int CargoHold::Transfer(const string &commodity, int amount, CargoHold &to)
 	int removed = Remove(commodity, amount);
 	int added = to.Add(commodity, removed);
 	commodities[commodity] += removed - added;
+	commoditiesSize += removed - added;
 	
 	return added;
 }
@@ -374,7 +368,11 @@ int CargoHold::Transfer(const Outfit *outfit, int amount, CargoHold &to)
 	// remainder back to this cargo hold, even if there is not space for it.
 	int removed = Remove(outfit, amount);
 	int added = to.Add(outfit, removed);
-	outfits[outfit] += removed - added;
+	if(removed != added)
+	{
+		outfits[outfit] += removed - added;
+		UpdateOutfitsSize();
+	}
 	
 	return added;
 }
@@ -402,6 +400,8 @@ int CargoHold::Transfer(const Mission *mission, int amount, CargoHold &to)
 	
 	missionCargo[mission] -= amount;
 	to.missionCargo[mission] += amount;
+	missionCargoSize -= amount;
+	to.missionCargoSize += amount;
 	
 	return amount;
 }
@@ -468,6 +468,7 @@ int CargoHold::Add(const string &commodity, int amount)
 	if(size >= 0)
 		amount = max(0, min(amount, Free()));
 	commodities[commodity] += amount;
+	commoditiesSize += amount;
 	return amount;
 }
 
@@ -484,6 +485,7 @@ int CargoHold::Add(const Outfit *outfit, int amount)
 	if(size >= 0 && mass > 0.)
 		amount = max(0, min(amount, static_cast<int>(Free() / mass)));
 	outfits[outfit] += amount;
+	UpdateOutfitsSize();
 	return amount;
 }
 
@@ -497,6 +499,7 @@ int CargoHold::Remove(const string &commodity, int amount)
 	
 	amount = min(amount, commodities[commodity]);
 	commodities[commodity] -= amount;
+	commoditiesSize -= amount;
 	return amount;
 }
 
@@ -510,6 +513,7 @@ int CargoHold::Remove(const Outfit *outfit, int amount)
 	
 	amount = min(amount, outfits[outfit]);
 	outfits[outfit] -= amount;
+	UpdateOutfitsSize();
 	return amount;
 }
 
@@ -525,6 +529,7 @@ void CargoHold::AddMissionCargo(const Mission *mission)
 		missionCargo[mission] += mission->CargoSize();
 	if(mission && mission->Passengers())
 		passengers[mission] += mission->Passengers();
+	UpdateSizes();
 }
 
 
@@ -534,6 +539,7 @@ void CargoHold::RemoveMissionCargo(const Mission *mission)
 {
 	missionCargo.erase(mission);
 	passengers.erase(mission);
+	UpdateSizes();
 }
 
 
@@ -593,3 +599,33 @@ int CargoHold::IllegalCargoFine() const
 	
 	return totalFine;
 }
+
+
+
+// Recalculate the total size of each kind of cargo.
+void CargoHold::UpdateSizes()
+{
+	commoditiesSize = 0;
+	for(const auto &it : commodities)
+		commoditiesSize += it.second;
+	
+	UpdateOutfitsSize();
+	
+	missionCargoSize = 0;
+	for(const auto &it : missionCargo)
+		missionCargoSize += it.second;
+}
+
+
+
+// Recalculate the total size of the outfits. This is summed up from scratch
+// every time so that the rounding never depends on the order in which they
+// were added or removed.
+void CargoHold::UpdateOutfitsSize()
+{
+	// The mass of outfit cargo is rounded up to the nearest ton.
+	double mass = 0.;
+	for(const auto &it : outfits)
+		mass += it.second * it.first->Mass();
+	outfitsSize = ceil(mass);
+}
@@ -105,6 +105,14 @@ public:
 	int IllegalCargoFine() const;
 	
 	
+private:
+	// Recalculate the total size of each kind of cargo. The sizes of commodities
+	// and mission cargo are kept up to date as they are added or removed, but
+	// the outfits' size must be recalculated whenever any outfit is.
+	void UpdateSizes();
+	void UpdateOutfitsSize();
+	
+	
 private:
 	// Use -1 to indicate unlimited capacity.
 	int size = -1;
@@ -115,6 +123,12 @@ private:
 	std::map<const Outfit *, int> outfits;
 	std::map<const Mission *, int> missionCargo;
 	std::map<const Mission *, int> passengers;
+	
+	// The total size of each kind of cargo, which is needed every time a ship's
+	// mass is calculated.
+	int commoditiesSize = 0;
+	int outfitsSize = 0;
+	int missionCargoSize = 0;
 };
 
 
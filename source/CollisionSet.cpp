@@ -19,6 +19,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 #include "Projectile.h"
 #include "Ship.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
 #include <cstdlib>
@@ -40,7 +41,8 @@ namespace {
 
 // Initialize a collision set. The cell size and cell count should both be
 // powers of two; otherwise, they are rounded down to a power of two.
-CollisionSet::CollisionSet(unsigned cellSize, unsigned cellCount)
+CollisionSet::CollisionSet(unsigned cellSize, unsigned cellCount, Index index)
+	: indexType(index)
 {
 	// Right shift amount to convert from (x, y) location to grid (x, y).
 	SHIFT = 0u;
@@ -57,6 +59,10 @@ CollisionSet::CollisionSet(unsigned cellSize, unsigned cellCount)
 	
 	// Just in case Clear() isn't called before objects are added:
 	Clear(0);
+	// The counts vector starts with two sentinel slots that will be used in the
+	// course of performing the radix sort.
+	if(indexType == Index::GRID)
+		counts.resize(CELLS * CELLS + 2u, 0u);
 }
 
 
@@ -66,12 +72,11 @@ void CollisionSet::Clear(int step)
 {
 	this->step = step;
 	
+	// The lookup table is kept until Finish(), so it can be reused if none of
+	// the objects have moved to a different grid cell.
 	added.clear();
-	sorted.clear();
-	counts.clear();
-	// The counts vector starts with two sentinel slots that will be used in the
-	// course of performing the radix sort.
-	counts.resize(CELLS * CELLS + 2u, 0u);
+	bounds.clear();
+	maxWidth = 0.;
 }
 
 
@@ -79,6 +84,15 @@ void CollisionSet::Clear(int step)
 // Add an object to the set.
 void CollisionSet::Add(Body &body)
 {
+	if(indexType == Index::SWEEP_AND_PRUNE)
+	{
+		const Point &center = body.Position();
+		double radius = body.Radius();
+		bounds.emplace_back(&body, center.X() - radius, center.Y() - radius, center.X() + radius, center.Y() + radius);
+		maxWidth = max(maxWidth, 2. * radius);
+		return;
+	}
+	
 	// Calculate the range of (x, y) grid coordinates this object covers.
 	int minX = static_cast<int>(body.Position().X() - body.Radius()) >> SHIFT;
 	int minY = static_cast<int>(body.Position().Y() - body.Radius()) >> SHIFT;
@@ -87,15 +101,8 @@ void CollisionSet::Add(Body &body)
 	
 	// Add a pointer to this object in every grid cell it occupies.
 	for(int y = minY; y <= maxY; ++y)
-	{
-		auto gy = y & WRAP_MASK;
 		for(int x = minX; x <= maxX; ++x)
-		{
-			auto gx = x & WRAP_MASK;
-			added.emplace_back(&body, x, y);
-			++counts[gy * CELLS + gx + 2];
-		}
-	}
+			added.emplace_back(&body, x, y, minX, minY);
 }
 
 
@@ -103,6 +110,27 @@ void CollisionSet::Add(Body &body)
 // Finish adding objects (and organize them into the final lookup table).
 void CollisionSet::Finish()
 {
+	if(indexType == Index::SWEEP_AND_PRUNE)
+	{
+		sort(bounds.begin(), bounds.end(),
+			[](const Bounds &a, const Bounds &b) { return a.minX < b.minX; });
+		return;
+	}
+	
+	// If every object is in the same cells as last time, the lookup table that
+	// was built then is still correct.
+	if(added == indexed)
+		return;
+	
+	// Count how many items are in each bin.
+	fill(counts.begin(), counts.end(), 0u);
+	for(const Entry &entry : added)
+	{
+		auto gx = entry.x & WRAP_MASK;
+		auto gy = entry.y & WRAP_MASK;
+		++counts[gy * CELLS + gx + 2];
+	}
+	
 	// Perform a partial sum to convert the counts of items in each bin into the
 	// index of the output element where that bin begins.
 	partial_sum(counts.begin(), counts.end(), counts.begin());
@@ -120,7 +148,9 @@ void CollisionSet::Finish()
 		sorted[counts[index]++] = entry;
 	}
 	
-	// Now, counts[index] is where a certain bin begins.
+	// Now, counts[index] is where a certain bin begins. Remember what the
+	// table was built from, for comparing against in the next step.
+	indexed.swap(added);
 }
 
 
@@ -145,6 +175,9 @@ Body *CollisionSet::Line(const Projectile &projectile, double *closestHit) const
 Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 		const Government *pGov, const Body *target) const
 {
+	if(indexType == Index::SWEEP_AND_PRUNE)
+		return SweepLine(from, to, closestHit, pGov, target);
+	
 	int x = from.X();
 	int y = from.Y();
 	int endX = to.X();
@@ -312,6 +345,101 @@ Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 
 
 
+// Check all the given projectiles for collisions at once, splitting the
+// work between the given threads. The result for each projectile is stored
+// at the same index in the "hits" vector.
+void CollisionSet::Line(const vector<Projectile> &projectiles, vector<Hit> &hits, ThreadPool &workers) const
+{
+	hits.clear();
+	hits.resize(projectiles.size());
+	
+	// Most projectiles start and end in the same grid cell. Sort those by cell,
+	// so that each cell's contents only need to be examined once no matter how
+	// many projectiles are in it. Any others are checked one at a time.
+	segments.clear();
+	spanning.clear();
+	for(unsigned index = 0; index < projectiles.size(); ++index)
+	{
+		if(indexType != Index::GRID)
+		{
+			spanning.push_back(index);
+			continue;
+		}
+		
+		const Projectile &projectile = projectiles[index];
+		Point from = projectile.Position();
+		Point to = from + projectile.Velocity();
+		int gx = static_cast<int>(from.X()) >> SHIFT;
+		int gy = static_cast<int>(from.Y()) >> SHIFT;
+		if(gx == (static_cast<int>(to.X()) >> SHIFT) && gy == (static_cast<int>(to.Y()) >> SHIFT))
+			segments.emplace_back((gy & WRAP_MASK) * CELLS + (gx & WRAP_MASK), index, gx, gy);
+		else
+			spanning.push_back(index);
+	}
+	sort(segments.begin(), segments.end(),
+		[](const Segment &a, const Segment &b) { return a.cell < b.cell; });
+	
+	// Find where the segments in each occupied cell begin.
+	segmentBins.clear();
+	for(unsigned i = 0; i < segments.size(); ++i)
+		if(!i || segments[i].cell != segments[i - 1].cell)
+			segmentBins.push_back(i);
+	segmentBins.push_back(segments.size());
+	
+	// Each job either handles all the segments in one cell or one projectile
+	// that crosses multiple cells, so no two jobs write to the same hit.
+	size_t bins = segmentBins.size() - 1;
+	workers.ForEach(bins + spanning.size(), [this, bins, &projectiles, &hits](size_t job)
+	{
+		if(job >= bins)
+		{
+			unsigned index = spanning[job - bins];
+			Hit &hit = hits[index];
+			hit.body = Line(projectiles[index], &hit.distance);
+			return;
+		}
+		
+		auto first = segments.begin() + segmentBins[job];
+		auto last = segments.begin() + segmentBins[job + 1];
+		auto i = first->cell;
+		vector<Entry>::const_iterator it = sorted.begin() + counts[i];
+		vector<Entry>::const_iterator end = sorted.begin() + counts[i + 1];
+		for( ; it != end; ++it)
+		{
+			const Government *iGov = it->body->GetGovernment();
+			const Mask &mask = it->body->GetMask(step);
+			for(auto segment = first; segment != last; ++segment)
+			{
+				// Skip objects that were put in this same grid cell only because
+				// of the cell coordinates wrapping around.
+				if(it->x != segment->x || it->y != segment->y)
+					continue;
+				
+				// Check if this projectile can hit this object. If either the
+				// projectile or the object has no government, it will always hit.
+				const Projectile &projectile = projectiles[segment->index];
+				const Government *pGov = projectile.GetGovernment();
+				if(it->body != projectile.Target() && iGov && pGov && !iGov->IsEnemy(pGov))
+					continue;
+				
+				Point from = projectile.Position();
+				Point to = from + projectile.Velocity();
+				Point offset = from - it->body->Position();
+				double range = mask.Collide(offset, to - from, it->body->Facing());
+				
+				Hit &hit = hits[segment->index];
+				if(range < hit.distance)
+				{
+					hit.distance = range;
+					hit.body = it->body;
+				}
+			}
+		}
+	});
+}
+
+
+
 // Get all objects within the given range of the given point.
 const vector<Body *> &CollisionSet::Circle(const Point &center, double radius) const
 {
@@ -324,14 +452,37 @@ const vector<Body *> &CollisionSet::Circle(const Point &center, double radius) c
 // centered at the given point.
 const vector<Body *> &CollisionSet::Ring(const Point &center, double inner, double outer) const
 {
+	Ring(center, inner, outer, result);
+	return result;
+}
+
+
+
+// Get all objects within the given range of the given point, storing them in
+// the given vector.
+void CollisionSet::Circle(const Point &center, double radius, vector<Body *> &result) const
+{
+	Ring(center, 0., radius, result);
+}
+
+
+
+// Get all objects touching a ring with a given inner and outer range
+// centered at the given point, storing them in the given vector.
+void CollisionSet::Ring(const Point &center, double inner, double outer, vector<Body *> &result) const
+{
+	if(indexType == Index::SWEEP_AND_PRUNE)
+	{
+		SweepRing(center, inner, outer, result);
+		return;
+	}
+	
 	// Calculate the range of (x, y) grid coordinates this ring covers.
 	int minX = static_cast<int>(center.X() - outer) >> SHIFT;
 	int minY = static_cast<int>(center.Y() - outer) >> SHIFT;
 	int maxX = static_cast<int>(center.X() + outer) >> SHIFT;
 	int maxY = static_cast<int>(center.Y() + outer) >> SHIFT;
 	
-	// Keep track of which objects we've already considered.
-	set<const Body *> seen;
 	result.clear();
 	for(int y = minY; y <= maxY; ++y)
 	{
@@ -350,9 +501,10 @@ const vector<Body *> &CollisionSet::Ring(const Point &center, double inner, doub
 				if(it->x != x || it->y != y)
 					continue;
 				
-				if(seen.count(it->body))
+				// An object that covers several of the cells in this query is
+				// only considered in the first of those cells.
+				if(x != max(it->minX, minX) || y != max(it->minY, minY))
 					continue;
-				seen.insert(it->body);
 				
 				const Mask &mask = it->body->GetMask(step);
 				Point offset = center - it->body->Position();
@@ -363,5 +515,128 @@ const vector<Body *> &CollisionSet::Ring(const Point &center, double inner, doub
 			}
 		}
 	}
+}
+
+
+
+// Get all objects that might overlap the given rectangle, storing them in the
+// given vector. For a grid, this is every object in the cells it covers.
+void CollisionSet::Rect(const Point &topLeft, const Point &bottomRight, vector<Body *> &result) const
+{
+	if(indexType == Index::SWEEP_AND_PRUNE)
+	{
+		SweepRect(topLeft, bottomRight, result);
+		return;
+	}
+	
+	// Calculate the range of (x, y) grid coordinates this rectangle covers.
+	int minX = static_cast<int>(topLeft.X()) >> SHIFT;
+	int minY = static_cast<int>(topLeft.Y()) >> SHIFT;
+	int maxX = static_cast<int>(bottomRight.X()) >> SHIFT;
+	int maxY = static_cast<int>(bottomRight.Y()) >> SHIFT;
+	
+	result.clear();
+	for(int y = minY; y <= maxY; ++y)
+	{
+		auto gy = y & WRAP_MASK;
+		for(int x = minX; x <= maxX; ++x)
+		{
+			auto gx = x & WRAP_MASK;
+			auto i = gy * CELLS + gx;
+			vector<Entry>::const_iterator it = sorted.begin() + counts[i];
+			vector<Entry>::const_iterator end = sorted.begin() + counts[i + 1];
+			
+			for( ; it != end; ++it)
+				if(it->x == x && it->y == y && x == max(it->minX, minX) && y == max(it->minY, minY))
+					result.push_back(it->body);
+		}
+	}
+}
+
+
+
+// Check for collisions with a line, using the sweep and prune index. Unlike
+// the grid, this always finds the closest object along the whole line.
+Body *CollisionSet::SweepLine(const Point &from, const Point &to, double *closestHit,
+		const Government *pGov, const Body *target) const
+{
+	double minX = min(from.X(), to.X());
+	double minY = min(from.Y(), to.Y());
+	double maxX = max(from.X(), to.X());
+	double maxY = max(from.Y(), to.Y());
+	
+	double closest = closestHit ? *closestHit : 1.;
+	Body *result = nullptr;
+	for(auto it = FirstBounds(minX); it != bounds.end() && it->minX <= maxX; ++it)
+	{
+		if(it->maxX < minX || it->maxY < minY || it->minY > maxY)
+			continue;
+		
+		// Check if this projectile can hit this object. If either the
+		// projectile or the object has no government, it will always hit.
+		const Government *iGov = it->body->GetGovernment();
+		if(it->body != target && iGov && pGov && !iGov->IsEnemy(pGov))
+			continue;
+		
+		const Mask &mask = it->body->GetMask(step);
+		Point offset = from - it->body->Position();
+		double range = mask.Collide(offset, to - from, it->body->Facing());
+		
+		if(range < closest)
+		{
+			closest = range;
+			result = it->body;
+		}
+	}
+	
+	if(closest < 1. && closestHit)
+		*closestHit = closest;
 	return result;
 }
+
+
+
+// Get all objects touching the given ring, using the sweep and prune index.
+void CollisionSet::SweepRing(const Point &center, double inner, double outer, vector<Body *> &result) const
+{
+	double minX = center.X() - outer;
+	double minY = center.Y() - outer;
+	double maxX = center.X() + outer;
+	double maxY = center.Y() + outer;
+	
+	result.clear();
+	for(auto it = FirstBounds(minX); it != bounds.end() && it->minX <= maxX; ++it)
+	{
+		if(it->maxX < minX || it->maxY < minY || it->minY > maxY)
+			continue;
+		
+		const Mask &mask = it->body->GetMask(step);
+		Point offset = center - it->body->Position();
+		double length = offset.Length();
+		if((length <= outer && length >= inner)
+			|| mask.WithinRing(offset, it->body->Facing(), inner, outer))
+			result.push_back(it->body);
+	}
+}
+
+
+
+// Get all objects whose bounds overlap the given rectangle.
+void CollisionSet::SweepRect(const Point &topLeft, const Point &bottomRight, vector<Body *> &result) const
+{
+	result.clear();
+	for(auto it = FirstBounds(topLeft.X()); it != bounds.end() && it->minX <= bottomRight.X(); ++it)
+		if(it->maxX >= topLeft.X() && it->maxY >= topLeft.Y() && it->minY <= bottomRight.Y())
+			result.push_back(it->body);
+}
+
+
+
+// Get the first object whose bounds might extend as far left as the given
+// x coordinate. No object is wider than maxWidth, so any object that starts
+// more than that distance to the left cannot reach it.
+vector<CollisionSet::Bounds>::const_iterator CollisionSet::FirstBounds(double minX) const
+{
+	return lower_bound(bounds.begin(), bounds.end(), minX - maxWidth,
+		[](const Bounds &entry, double x) { return entry.minX < x; });
+}
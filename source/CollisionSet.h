@@ -19,24 +19,44 @@ class Government;
 class Point;
 class Projectile;
 class Body;
+class ThreadPool;
 
 
 
 // A CollisionSet allows efficient collision detection by splitting space up
 // into a grid and keeping track of which objects are in each grid cell. A check
-// for collisions can then only examine objects in certain cells.
+// for collisions can then only examine objects in certain cells. Alternatively,
+// the objects can be kept sorted by their leftmost extent ("sweep and prune"),
+// which does not suffer from objects of very different sizes sharing a cell or
+// from far-apart objects wrapping around into the same cell.
 class CollisionSet {
+public:
+	// The kinds of lookup table that a collision set can use.
+	enum class Index {GRID, SWEEP_AND_PRUNE};
+	
+	// The result of checking a projectile for collisions: the first object it
+	// hits, if any, and how far along its path for this step it hits it.
+	class Hit {
+	public:
+		Body *body = nullptr;
+		double distance = 1.;
+	};
+	
+	
 public:
 	// Initialize a collision set. The cell size and cell count should both be
-	// powers of two; otherwise, they are rounded down to a power of two.
-	CollisionSet(unsigned cellSize, unsigned cellCount);
+	// powers of two; otherwise, they are rounded down to a power of two. They
+	// are only used if the index is a grid.
+	CollisionSet(unsigned cellSize, unsigned cellCount, Index index = Index::GRID);
 	
 	// Clear all objects in the set. Specify which engine step we are on, so we
 	// know what animation frame each object is on.
 	void Clear(int step);
 	// Add an object to the set.
 	void Add(Body &body);
-	// Finish adding objects (and organize them into the final lookup table).
+	// Finish adding objects (and organize them into the final lookup table). If
+	// the same objects were added in the same order and grid cells as when the
+	// lookup table was last built, it is kept instead of being rebuilt.
 	void Finish();
 	
 	// Get the first object that collides with the given projectile. If a
@@ -46,27 +66,91 @@ public:
 	// position or its entire expected trajectory (for the auto-firing AI).
 	Body *Line(const Point &from, const Point &to, double *closestHit = nullptr,
 		const Government *pGov = nullptr, const Body *target = nullptr) const;
+	// Check all the given projectiles for collisions at once, splitting the
+	// work between the given threads. The result for each projectile is stored
+	// at the same index in the "hits" vector.
+	void Line(const std::vector<Projectile> &projectiles, std::vector<Hit> &hits, ThreadPool &workers) const;
 	
 	// Get all objects within the given range of the given point.
 	const std::vector<Body *> &Circle(const Point &center, double radius) const;
 	// Get all objects touching a ring with a given inner and outer range
 	// centered at the given point.
 	const std::vector<Body *> &Ring(const Point &center, double inner, double outer) const;
+	// These versions of the queries store the objects in the given vector
+	// instead, replacing its contents. They do not modify the collision set,
+	// so they can be called from multiple threads at once, and reusing the
+	// same vector for many queries avoids allocating memory for each one.
+	void Circle(const Point &center, double radius, std::vector<Body *> &result) const;
+	void Ring(const Point &center, double inner, double outer, std::vector<Body *> &result) const;
+	// Get all objects that might overlap the given rectangle, based on the
+	// position of each one when it was added. This is meant for culling, so it
+	// does not check the objects' masks, or even their exact bounds if the index
+	// is a grid.
+	void Rect(const Point &topLeft, const Point &bottomRight, std::vector<Body *> &result) const;
 	
 	
 private:
 	class Entry {
 	public:
 		Entry() = default;
-		Entry(Body *body, int x, int y) : body(body), x(x), y(y) {}
+		Entry(Body *body, int x, int y, int minX, int minY)
+			: body(body), x(x), y(y), minX(minX), minY(minY) {}
+		
+		bool operator==(const Entry &other) const
+		{
+			return body == other.body && x == other.x && y == other.y && minX == other.minX && minY == other.minY;
+		}
+		
+		Body *body;
+		int x;
+		int y;
+		// The first grid cell this object occupies, so that queries covering
+		// more than one cell can count each object only once.
+		int minX;
+		int minY;
+	};
+	
+	// The bounding box of an object, for the sweep and prune index.
+	class Bounds {
+	public:
+		Bounds() = default;
+		Bounds(Body *body, double minX, double minY, double maxX, double maxY)
+			: body(body), minX(minX), minY(minY), maxX(maxX), maxY(maxY) {}
 		
 		Body *body;
+		double minX;
+		double minY;
+		double maxX;
+		double maxY;
+	};
+	
+	// A projectile that starts and ends in a single grid cell.
+	class Segment {
+	public:
+		Segment() = default;
+		Segment(unsigned cell, unsigned index, int x, int y) : cell(cell), index(index), x(x), y(y) {}
+		
+		unsigned cell;
+		unsigned index;
 		int x;
 		int y;
 	};
 	
 	
 private:
+	// Sweep and prune versions of the queries.
+	Body *SweepLine(const Point &from, const Point &to, double *closestHit,
+		const Government *pGov, const Body *target) const;
+	void SweepRing(const Point &center, double inner, double outer, std::vector<Body *> &result) const;
+	void SweepRect(const Point &topLeft, const Point &bottomRight, std::vector<Body *> &result) const;
+	// Get the first object whose bounds might extend as far left as the given
+	// x coordinate. Objects are only checked until one starts beyond the query.
+	std::vector<Bounds>::const_iterator FirstBounds(double minX) const;
+	
+	
+private:
+	Index indexType;
+	
 	// The size of individual cells of the grid.
 	unsigned CELL_SIZE;
 	unsigned SHIFT;
@@ -82,11 +166,23 @@ private:
 	// Vectors to store the objects in the collision set.
 	std::vector<Entry> added;
 	std::vector<Entry> sorted;
+	// The objects that the lookup table was last built from, in the order they
+	// were added. Most objects stay in the same grid cells from one step to the
+	// next, so often the lookup table does not need to change.
+	std::vector<Entry> indexed;
 	// After Finish(), counts[index] is where a certain bin begins.
 	std::vector<unsigned> counts;
+	// For the sweep and prune index, the bounds of each object, sorted by their
+	// left edge, and the largest width of any object.
+	std::vector<Bounds> bounds;
+	double maxWidth = 0.;
 	
 	// Vector for returning the result of a circle query.
 	mutable std::vector<Body *> result;
+	// Vectors for sorting the projectiles in a batched line query.
+	mutable std::vector<Segment> segments;
+	mutable std::vector<unsigned> segmentBins;
+	mutable std::vector<unsigned> spanning;
 };
 
 
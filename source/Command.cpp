@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Command.h"
 
+#include "BinaryData.h"
 #include "DataFile.h"
 #include "DataNode.h"
 #include "DataWriter.h"
@@ -425,6 +426,35 @@ Command &Command::operator|=(const Command &command)
 
 
 
+// Write out every part of this command exactly, as binary data.
+void Command::Write(string &out) const
+{
+	BinaryData::Write64(state, out);
+	BinaryData::WriteDouble(turn, out);
+	out.append(reinterpret_cast<const char *>(aim), sizeof(aim));
+}
+
+
+
+// Read back a command written by Write(). If there is not enough data, this
+// returns false and the command is left unchanged.
+bool Command::Read(const string &data, size_t &pos)
+{
+	uint64_t newState = 0;
+	double newTurn = 0.;
+	if(!BinaryData::Read64(data, pos, newState) || !BinaryData::ReadDouble(data, pos, newTurn)
+			|| data.size() - pos < sizeof(aim))
+		return false;
+	
+	state = newState;
+	turn = newTurn;
+	copy(data.begin() + pos, data.begin() + pos + sizeof(aim), aim);
+	pos += sizeof(aim);
+	return true;
+}
+
+
+
 // Private constructor.
 Command::Command(uint64_t state)
 	: state(state)
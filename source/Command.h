@@ -100,6 +100,10 @@ public:
 	
 	// Load this command from an input file (for testing or scripted missions).
 	void Load(const DataNode &node);
+	// Write out or read back every part of this command exactly, as binary
+	// data (for recordings of the player's inputs).
+	void Write(std::string &out) const;
+	bool Read(const std::string &data, size_t &pos);
 	
 	// Reset this to an empty command.
 	void Clear();
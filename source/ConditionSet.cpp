@@ -147,32 +147,9 @@ namespace {
 		return false;
 	}
 	
-	// Converts the given vector of condition tokens (like "reputation: Republic",
-	// "random", or "4") into the integral values they have at runtime.
-	vector<int64_t> SubstituteValues(const vector<string> &side, const map<string, int64_t> &conditions, const map<string, int64_t> &created)
-	{
-		auto result = vector<int64_t>();
-		result.reserve(side.size());
-		for(const string &str : side)
-		{
-			int64_t value = 0;
-			if(str == "random")
-				value = Random::Int(100);
-			else if(DataNode::IsNumber(str))
-				value = static_cast<int64_t>(DataNode::Value(str));
-			else
-			{
-				const auto temp = created.find(str);
-				const auto perm = conditions.find(str);
-				if(temp != created.end())
-					value = temp->second;
-				else if(perm != conditions.end())
-					value = perm->second;
-			}
-			result.emplace_back(value);
-		}
-		return result;
-	}
+	// Expressions with at most this many tokens and operators are evaluated
+	// using a buffer on the stack instead of allocating one.
+	const size_t BUFFER_SIZE = 32;
 	
 	bool UsedAll(const vector<bool> &status)
 	{
@@ -271,6 +248,19 @@ bool ConditionSet::IsEmpty() const
 
 
 
+// Add the id of every condition that this set reads when it is tested.
+bool ConditionSet::ReferencedConditions(vector<unsigned> &ids) const
+{
+	bool isDeterministic = true;
+	for(const Expression &expression : expressions)
+		isDeterministic &= expression.ReferencedConditions(ids);
+	for(const ConditionSet &child : children)
+		isDeterministic &= child.ReferencedConditions(ids);
+	return isDeterministic;
+}
+
+
+
 // Read a single condition from a data node.
 void ConditionSet::Add(const DataNode &node)
 {
@@ -476,7 +466,7 @@ void ConditionSet::TestApply(const Conditions &conditions, Conditions &created)
 
 // Constructor for complex expressions.
 ConditionSet::Expression::Expression(const vector<string> &left, const string &op, const vector<string> &right)
-	: op(op), fun(Op(op)), left(left), right(right)
+	: op(op), fun(Op(op)), left(left), right(right), name(this->left.ToString()), id(IsAssignment(op) ? ConditionsStore::Intern(name) : 0)
 {
 }
 
@@ -484,7 +474,7 @@ ConditionSet::Expression::Expression(const vector<string> &left, const string &o
 
 // Constructor for simple expressions.
 ConditionSet::Expression::Expression(const string &left, const string &op, const string &right)
-	: op(op), fun(Op(op)), left(left), right(right)
+	: op(op), fun(Op(op)), left(left), right(right), name(this->left.ToString()), id(IsAssignment(op) ? ConditionsStore::Intern(name) : 0)
 {
 }
 
@@ -520,9 +510,9 @@ bool ConditionSet::Expression::IsEmpty() const
 
 // Returns everything to the left of the main assignment or comparison operator.
 // In an assignment expression, this should be only a single token.
-string ConditionSet::Expression::Name() const
+const string &ConditionSet::Expression::Name() const
 {
-	return left.ToString();
+	return name;
 }
 
 
@@ -535,6 +525,18 @@ bool ConditionSet::Expression::IsTestable() const
 
 
 
+// Assignments are only tested using the temporary conditions they create, so
+// only the value being assigned depends on the given conditions.
+bool ConditionSet::Expression::ReferencedConditions(vector<unsigned> &ids) const
+{
+	bool isDeterministic = right.ReferencedConditions(ids);
+	if(IsTestable())
+		isDeterministic &= left.ReferencedConditions(ids);
+	return isDeterministic;
+}
+
+
+
 // Evaluate both the left- and right-hand sides of the expression, then compare the evaluated numeric values.
 bool ConditionSet::Expression::Test(const Conditions &conditions, const Conditions &created) const
 {
@@ -548,9 +550,8 @@ bool ConditionSet::Expression::Test(const Conditions &conditions, const Conditio
 // Assign the computed value to the desired condition.
 void ConditionSet::Expression::Apply(Conditions &conditions, Conditions &created) const
 {
-	int64_t &c = conditions[Name()];
 	int64_t value = right.Evaluate(conditions, created);
-	c = fun(c, value);
+	conditions.Set(id, fun(conditions.Get(id), value));
 }
 
 
@@ -558,9 +559,8 @@ void ConditionSet::Expression::Apply(Conditions &conditions, Conditions &created
 // Assign the computed value to the desired temporary condition.
 void ConditionSet::Expression::TestApply(const Conditions &conditions, Conditions &created) const
 {
-	int64_t &c = created[Name()];
 	int64_t value = right.Evaluate(conditions, created);
-	c = fun(c, value);
+	created.Set(id, fun(created.Get(id), value));
 }
 
 
@@ -573,6 +573,7 @@ ConditionSet::Expression::SubExpression::SubExpression(const vector<string> &sid
 	
 	ParseSide(side);
 	GenerateSequence();
+	Compile();
 }
 
 
@@ -582,6 +583,7 @@ ConditionSet::Expression::SubExpression::SubExpression(const vector<string> &sid
 ConditionSet::Expression::SubExpression::SubExpression(const string &side)
 {
 	tokens.emplace_back(side.empty() ? "'" : side);
+	Compile();
 }
 
 
@@ -641,6 +643,22 @@ bool ConditionSet::Expression::SubExpression::IsEmpty() const
 
 
 
+// Add the ids of the conditions used as operands.
+bool ConditionSet::Expression::SubExpression::ReferencedConditions(vector<unsigned> &ids) const
+{
+	bool isDeterministic = true;
+	for(const Operand &operand : operands)
+	{
+		if(operand.type == Operand::Type::CONDITION)
+			ids.push_back(operand.id);
+		else if(operand.type == Operand::Type::RANDOM)
+			isDeterministic = false;
+	}
+	return isDeterministic;
+}
+
+
+
 // Evaluate the SubExpression using the given condition maps.
 int64_t ConditionSet::Expression::SubExpression::Evaluate(const Conditions &conditions, const Conditions &created) const
 {
@@ -648,19 +666,38 @@ int64_t ConditionSet::Expression::SubExpression::Evaluate(const Conditions &cond
 	if(tokens.empty())
 		return 0;
 	
-	// For SubExpressions with no Operations (i.e. simple conditions), tokens will consist
-	// of only the condition or numeric value to be returned as-is after substitution.
-	auto data = SubstituteValues(tokens, conditions, created);
+	// Each Operation adds its result to the end of the data buffer, so the last
+	// value is the result of the whole SubExpression. For simple conditions there
+	// are no Operations, and the result is just the single operand.
+	size_t size = operands.size() + sequence.size();
+	int64_t buffer[BUFFER_SIZE];
+	vector<int64_t> largeBuffer;
+	int64_t *data = buffer;
+	if(size > BUFFER_SIZE)
+	{
+		largeBuffer.resize(size);
+		data = largeBuffer.data();
+	}
 	
-	if(!sequence.empty())
+	for(size_t i = 0; i < operands.size(); ++i)
 	{
-		// Each Operation adds to the end of the data vector.
-		data.reserve(operatorCount + data.size());
-		for(const Operation &op : sequence)
-			data.emplace_back(op.fun(data[op.a], data[op.b]));
+		const Operand &operand = operands[i];
+		if(operand.type == Operand::Type::RANDOM)
+			data[i] = Random::Int(100);
+		else if(operand.type == Operand::Type::CONDITION)
+		{
+			// Temporary conditions take precedence over the given ones.
+			const int64_t *value = created.Find(operand.id);
+			data[i] = value ? *value : conditions.Get(operand.id);
+		}
+		else
+			data[i] = operand.value;
 	}
+	size_t index = operands.size();
+	for(const Operation &op : sequence)
+		data[index++] = op.fun(data[op.a], data[op.b]);
 	
-	return data.back();
+	return data[size - 1];
 }
 
 
@@ -815,6 +852,30 @@ bool ConditionSet::Expression::SubExpression::AddOperation(vector<int> &data, si
 
 
 
+// Parse each token once, when the SubExpression is created. The empty tokens
+// that stand in for parentheses are never used as operands.
+void ConditionSet::Expression::SubExpression::Compile()
+{
+	operands.clear();
+	operands.reserve(tokens.size());
+	for(const string &token : tokens)
+	{
+		Operand operand;
+		if(token == "random")
+			operand.type = Operand::Type::RANDOM;
+		else if(DataNode::IsNumber(token))
+			operand.value = static_cast<int64_t>(DataNode::Value(token));
+		else if(!token.empty())
+		{
+			operand.type = Operand::Type::CONDITION;
+			operand.id = ConditionsStore::Intern(token);
+		}
+		operands.push_back(operand);
+	}
+}
+
+
+
 // Constructor for an Operation, indicating the binary function and the
 // indices of its operands within the evaluation-time data vector.
 ConditionSet::Expression::SubExpression::Operation::Operation(const string &op, size_t &a, size_t &b)
@@ -13,7 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef CONDITION_SET_H_
 #define CONDITION_SET_H_
 
-#include <map>
+#include "ConditionsStore.h"
+
 #include <string>
 #include <vector>
 
@@ -28,7 +29,7 @@ class DataWriter;
 // values.
 class ConditionSet {
 public:
-	using Conditions = std::map<std::string, int64_t>;
+	using Conditions = ConditionsStore;
 	ConditionSet() = default;
 	// Construct and Load() at the same time.
 	ConditionSet(const DataNode &node);
@@ -41,6 +42,10 @@ public:
 	
 	// Check if there are any entries in this set.
 	bool IsEmpty() const;
+	// Add the id of every condition that this set reads when it is tested to
+	// the given list. Returns false if the result of testing it also depends
+	// on random numbers, so it cannot be assumed to stay the same.
+	bool ReferencedConditions(std::vector<unsigned> &ids) const;
 	
 	// Read a single condition from a data node.
 	void Add(const DataNode &node);
@@ -82,9 +87,12 @@ private:
 		bool IsEmpty() const;
 		
 		// Returns the left side of this Expression.
-		std::string Name() const;
+		const std::string &Name() const;
 		// True if this Expression performs a comparison and false if it performs an assignment.
 		bool IsTestable() const;
+		// Add the ids of the conditions this Expression reads, and return false
+		// if it uses random numbers.
+		bool ReferencedConditions(std::vector<unsigned> &ids) const;
 		
 		// Functions to use this expression:
 		bool Test(const Conditions &conditions, const Conditions &created) const;
@@ -108,8 +116,9 @@ private:
 			const std::vector<std::string> ToStrings() const;
 			
 			bool IsEmpty() const;
+			bool ReferencedConditions(std::vector<unsigned> &ids) const;
 			
-			// Substitute numbers for any string values and then compute the result.
+			// Look up the value of each operand and then compute the result.
 			int64_t Evaluate(const Conditions &conditions, const Conditions &created) const;
 			
 			
@@ -117,9 +126,24 @@ private:
 			void ParseSide(const std::vector<std::string> &side);
 			void GenerateSequence();
 			bool AddOperation(std::vector<int> &data, size_t &index, const size_t &opIndex);
+			// Convert the tokens into operands, so that numbers do not need to be
+			// parsed again every time this SubExpression is evaluated.
+			void Compile();
 			
 			
 		private:
+			// An Operand is a token that has already been parsed: either a constant,
+			// a random number, or a condition to look up.
+			class Operand {
+			public:
+				enum class Type {CONSTANT, RANDOM, CONDITION};
+				
+				Type type = Type::CONSTANT;
+				int64_t value = 0;
+				unsigned id = 0;
+			};
+			
+			
 			// An Operation has a pointer to its binary function, and the data indices for
 			// its operands. The result is always placed on the back of the data vector.
 			class Operation {
@@ -135,9 +159,11 @@ private:
 		private:
 			// Iteration of the sequence vector yields the result.
 			std::vector<Operation> sequence;
-			// The tokens vector converts into a data vector of numeric values during evaluation.
+			// The tokens vector is compiled into operands (one per token), which
+			// become the first values in the data buffer during evaluation.
 			std::vector<std::string> tokens;
 			std::vector<std::string> operators;
+			std::vector<Operand> operands;
 			// The number of true (non-parentheses) operators.
 			int operatorCount = 0;
 		};
@@ -153,6 +179,11 @@ private:
 		// SubExpressions contain one or more tokens and any number of simple operators.
 		SubExpression left;
 		SubExpression right;
+		// The left side as a single string, which is the name of the condition
+		// that an assignment expression modifies, and the id of that name (or
+		// zero, if this is a comparison).
+		std::string name;
+		unsigned id;
 	};
 	
 	
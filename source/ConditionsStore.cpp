@@ -0,0 +1,500 @@
+/* ConditionsStore.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "ConditionsStore.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+namespace {
+	// The table is never smaller than this once anything has been added to it.
+	const size_t MIN_SIZE = 16;
+	
+	// Names may be interned by several threads at once while data files are
+	// being loaded, so all access to the interned names must be locked. The
+	// names are kept in sorted order so that prefixes can be searched for.
+	mutex &InternMutex()
+	{
+		static mutex internMutex;
+		return internMutex;
+	}
+	
+	map<string, unsigned> &Ids()
+	{
+		static map<string, unsigned> ids;
+		return ids;
+	}
+	
+	// The name for each id. Id zero is reserved to mark unused slots.
+	vector<const string *> &Names()
+	{
+		static vector<const string *> names(1, nullptr);
+		return names;
+	}
+	
+	// Get the id of a name that has already been interned, or 0 if it has not.
+	unsigned FindId(const string &name)
+	{
+		lock_guard<mutex> lock(InternMutex());
+		auto it = Ids().find(name);
+		return (it == Ids().end() ? 0 : it->second);
+	}
+	
+	// The ids are assigned in sequence, so multiplying them by an odd constant
+	// spreads them out over the table without any collisions between ids that
+	// are close together.
+	size_t Slot(unsigned id, size_t mask)
+	{
+		return (id * 2654435769u) & mask;
+	}
+}
+
+
+
+ConditionsStore::ConditionsStore(initializer_list<pair<string, int64_t>> initial)
+{
+	for(const auto &it : initial)
+		Set(it.first, it.second);
+}
+
+
+
+// Get the id for the given condition name, adding it if necessary.
+unsigned ConditionsStore::Intern(const string &name)
+{
+	lock_guard<mutex> lock(InternMutex());
+	map<string, unsigned> &ids = Ids();
+	vector<const string *> &names = Names();
+	
+	auto it = ids.emplace(name, names.size());
+	if(it.second)
+		names.push_back(&it.first->first);
+	return it.first->second;
+}
+
+
+
+string ConditionsStore::Name(unsigned id)
+{
+	lock_guard<mutex> lock(InternMutex());
+	const vector<const string *> &names = Names();
+	return (id && id < names.size()) ? *names[id] : string();
+}
+
+
+
+// Access a condition for modifying it, creating it if it does not exist.
+int64_t &ConditionsStore::operator[](const string &name)
+{
+	return (*this)[Intern(name)];
+}
+
+
+
+int64_t &ConditionsStore::operator[](unsigned id)
+{
+	Entry &entry = Insert(id);
+	if(!entry.isSet)
+	{
+		entry.isSet = true;
+		++count;
+	}
+	Touch(entry);
+	return entry.value;
+}
+
+
+
+// Get the value of a condition, or 0 if it is not in this store.
+int64_t ConditionsStore::Get(const string &name) const
+{
+	const int64_t *value = Find(name);
+	return value ? *value : 0;
+}
+
+
+
+int64_t ConditionsStore::Get(unsigned id) const
+{
+	const int64_t *value = Find(id);
+	return value ? *value : 0;
+}
+
+
+
+// Get a pointer to the value of a condition, or null if it is not in this store.
+const int64_t *ConditionsStore::Find(const string &name) const
+{
+	// Don't bother looking up the name if this store is empty.
+	if(IsEmpty())
+		return nullptr;
+	
+	unsigned id = FindId(name);
+	if(id)
+		return Find(id);
+	
+	// A condition derived by a prefix provider might never have been interned.
+	for(const Provider &provider : providers)
+		if(!provider.prefix.empty() && !name.compare(0, provider.prefix.length(), provider.prefix))
+			return Derive(provider, name);
+	return nullptr;
+}
+
+
+
+const int64_t *ConditionsStore::Find(unsigned id) const
+{
+	const Provider *provider = GetProvider(id);
+	if(provider)
+		return Derive(*provider, provider->prefix.empty() ? string() : Name(id));
+	
+	const Entry *entry = Lookup(id);
+	return (entry && entry->isSet) ? &entry->value : nullptr;
+}
+
+
+
+bool ConditionsStore::Has(const string &name) const
+{
+	return Find(name);
+}
+
+
+
+// Set the value of a condition. It only counts as changed if it did not exist
+// before or if its value is different.
+void ConditionsStore::Set(const string &name, int64_t value)
+{
+	Set(Intern(name), value);
+}
+
+
+
+void ConditionsStore::Set(unsigned id, int64_t value)
+{
+	Entry &entry = Insert(id);
+	if(entry.isSet && entry.value == value)
+		return;
+	
+	if(!entry.isSet)
+	{
+		entry.isSet = true;
+		++count;
+	}
+	entry.value = value;
+	Touch(entry);
+}
+
+
+
+// Remove a single condition.
+void ConditionsStore::Erase(const string &name)
+{
+	size_t i = Position(FindId(name));
+	if(i == entries.size() || !entries[i].isSet)
+		return;
+	
+	Entry &entry = entries[i];
+	entry.isSet = false;
+	entry.value = 0;
+	--count;
+	Touch(entry);
+}
+
+
+
+// Remove all the conditions whose names start with the given prefix.
+void ConditionsStore::EraseWithPrefix(const string &prefix)
+{
+	for(const auto &it : WithPrefix(prefix))
+		Erase(it.first);
+}
+
+
+
+// Derive the value of a condition from the given function instead of storing it.
+void ConditionsStore::SetProvider(unsigned id, function<int64_t()> provider)
+{
+	Provider added;
+	added.id = id;
+	added.value = std::move(provider);
+	AddProvider(std::move(added));
+}
+
+
+
+void ConditionsStore::SetPrefixProvider(const string &prefix, function<map<string, int64_t>()> provider)
+{
+	Provider added;
+	added.prefix = prefix;
+	added.values = std::move(provider);
+	AddProvider(std::move(added));
+}
+
+
+
+// Get all the conditions whose names start with the given prefix, sorted by name.
+vector<pair<string, int64_t>> ConditionsStore::WithPrefix(const string &prefix) const
+{
+	vector<pair<string, int64_t>> result;
+	if(IsEmpty())
+		return result;
+	
+	// Finding a derived condition may involve looking up its name, so the
+	// matching names must be copied out before their values are found.
+	vector<pair<const string *, unsigned>> matches;
+	{
+		lock_guard<mutex> lock(InternMutex());
+		const map<string, unsigned> &ids = Ids();
+		for(auto it = ids.lower_bound(prefix); it != ids.end() && !it->first.compare(0, prefix.length(), prefix); ++it)
+			matches.emplace_back(&it->first, it->second);
+	}
+	for(const auto &it : matches)
+	{
+		// Conditions derived by a prefix provider are added below instead.
+		const Provider *provider = GetProvider(it.second);
+		if(provider && !provider->prefix.empty())
+			continue;
+		
+		const int64_t *value = Find(it.second);
+		if(value)
+			result.emplace_back(*it.first, *value);
+	}
+	
+	// The names of conditions derived by a prefix provider might not have
+	// been interned, so get them from the provider itself.
+	bool isSorted = true;
+	for(const Provider &provider : providers)
+	{
+		if(provider.prefix.empty())
+			continue;
+		size_t length = min(prefix.length(), provider.prefix.length());
+		if(provider.prefix.compare(0, length, prefix, 0, length))
+			continue;
+		
+		Compute(provider);
+		for(const auto &it : provider.cachedValues)
+		{
+			string name = provider.prefix + it.first;
+			if(!name.compare(0, prefix.length(), prefix))
+			{
+				result.emplace_back(std::move(name), it.second);
+				isSorted = false;
+			}
+		}
+	}
+	if(!isSorted)
+		sort(result.begin(), result.end());
+	return result;
+}
+
+
+
+bool ConditionsStore::IsEmpty() const
+{
+	return !count && providers.empty();
+}
+
+
+
+size_t ConditionsStore::Size() const
+{
+	return count;
+}
+
+
+
+// This number increases every time any condition in this store changes.
+uint64_t ConditionsStore::Revision() const
+{
+	return revision;
+}
+
+
+
+// Get the revision when the given condition last changed.
+uint64_t ConditionsStore::Revision(unsigned id) const
+{
+	const Provider *provider = GetProvider(id);
+	if(provider)
+		return provider->revision;
+	
+	const Entry *entry = Lookup(id);
+	return entry ? entry->revision : 0;
+}
+
+
+
+// Get the ids of all the conditions that have changed since the given revision.
+vector<unsigned> ConditionsStore::ChangedSince(uint64_t revision) const
+{
+	vector<unsigned> result;
+	if(revision >= this->revision)
+		return result;
+	
+	for(const Entry &entry : entries)
+		if(entry.id && entry.revision > revision && !GetProvider(entry.id))
+			result.push_back(entry.id);
+	for(unsigned id = 0; id < providerOf.size(); ++id)
+		if(providerOf[id] > 1 && providers[providerOf[id] - 2].revision > revision)
+			result.push_back(id);
+	return result;
+}
+
+
+
+// Find the index of the slot for the given id, or the size of the table if
+// it has none.
+size_t ConditionsStore::Position(unsigned id) const
+{
+	if(!id || entries.empty())
+		return entries.size();
+	
+	// Search until either the id or an unused slot is found. The table is
+	// never allowed to fill up, so there is always an unused slot.
+	size_t mask = entries.size() - 1;
+	for(size_t i = Slot(id, mask); ; i = (i + 1) & mask)
+	{
+		if(entries[i].id == id)
+			return i;
+		if(!entries[i].id)
+			return entries.size();
+	}
+}
+
+
+
+// Find the slot for the given id, or null if it has none.
+const ConditionsStore::Entry *ConditionsStore::Lookup(unsigned id) const
+{
+	size_t i = Position(id);
+	return (i == entries.size() ? nullptr : &entries[i]);
+}
+
+
+
+// Find the slot for the given id, adding it if necessary.
+ConditionsStore::Entry &ConditionsStore::Insert(unsigned id)
+{
+	size_t found = Position(id);
+	if(found != entries.size())
+		return entries[found];
+	
+	// Keep the table at most three quarters full.
+	if(4 * (used + 1) > 3 * entries.size())
+	{
+		vector<Entry> old(max(MIN_SIZE, 2 * entries.size()));
+		old.swap(entries);
+		size_t mask = entries.size() - 1;
+		for(const Entry &entry : old)
+			if(entry.id)
+			{
+				size_t i = Slot(entry.id, mask);
+				while(entries[i].id)
+					i = (i + 1) & mask;
+				entries[i] = entry;
+			}
+	}
+	
+	size_t mask = entries.size() - 1;
+	size_t i = Slot(id, mask);
+	while(entries[i].id)
+		i = (i + 1) & mask;
+	entries[i].id = id;
+	++used;
+	return entries[i];
+}
+
+
+
+// Mark the given slot as changed.
+void ConditionsStore::Touch(Entry &entry)
+{
+	entry.revision = ++revision;
+}
+
+
+
+// Find the provider for the given condition, or null if it is not derived.
+const ConditionsStore::Provider *ConditionsStore::GetProvider(unsigned id) const
+{
+	if(providers.empty() || !id)
+		return nullptr;
+	
+	if(id >= providerOf.size())
+		providerOf.resize(id + 1, 0);
+	if(!providerOf[id])
+	{
+		providerOf[id] = 1;
+		string name = Name(id);
+		for(size_t i = 0; i < providers.size(); ++i)
+		{
+			const Provider &provider = providers[i];
+			if(provider.prefix.empty() ? (provider.id == id) : !name.compare(0, provider.prefix.length(), provider.prefix))
+			{
+				providerOf[id] = i + 2;
+				break;
+			}
+		}
+	}
+	return (providerOf[id] > 1 ? &providers[providerOf[id] - 2] : nullptr);
+}
+
+
+
+// Add or replace a provider, and forget its cached result.
+void ConditionsStore::AddProvider(Provider &&provider)
+{
+	provider.revision = ++revision;
+	for(Provider &existing : providers)
+		if(existing.id == provider.id && existing.prefix == provider.prefix)
+		{
+			existing = std::move(provider);
+			return;
+		}
+	
+	// Adding a provider may change which conditions the others derive, so
+	// every condition must be looked up again.
+	providers.push_back(std::move(provider));
+	providerOf.clear();
+}
+
+
+
+// Call the given provider, unless its result is already cached.
+void ConditionsStore::Compute(const Provider &provider) const
+{
+	if(provider.isCached)
+		return;
+	
+	if(provider.prefix.empty())
+		provider.cachedValue = provider.value();
+	else
+		provider.cachedValues = provider.values();
+	provider.isCached = true;
+}
+
+
+
+// Get the value of a derived condition.
+const int64_t *ConditionsStore::Derive(const Provider &provider, const string &name) const
+{
+	Compute(provider);
+	if(provider.prefix.empty())
+		return &provider.cachedValue;
+	
+	auto it = provider.cachedValues.find(name.substr(provider.prefix.length()));
+	return (it == provider.cachedValues.end() ? nullptr : &it->second);
+}
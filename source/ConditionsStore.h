@@ -0,0 +1,163 @@
+/* ConditionsStore.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef CONDITIONS_STORE_H_
+#define CONDITIONS_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+// A collection of named integer "conditions", such as the player's set of
+// conditions. Condition names are interned, so that each one has an id that
+// is the same in every store; ConditionSets resolve the names they use to ids
+// when they are loaded, so evaluating them never involves comparing strings.
+// The values are kept in a flat, open-addressed hash table. The store also
+// keeps track of when each condition was last changed, so that anything that
+// depends on certain conditions can tell whether it needs to be checked again.
+// Some conditions are not stored at all, but are derived from other state by a
+// "provider" function the first time they are read after the provider is set.
+class ConditionsStore {
+public:
+	ConditionsStore() = default;
+	ConditionsStore(std::initializer_list<std::pair<std::string, int64_t>> initial);
+	
+	// Get the id for the given condition name, adding it if necessary. The
+	// same name always has the same id, and zero is never a valid id.
+	static unsigned Intern(const std::string &name);
+	static std::string Name(unsigned id);
+	
+	// Access a condition for modifying it, creating it if it does not exist.
+	// The condition counts as changed even if it is not actually modified.
+	int64_t &operator[](const std::string &name);
+	int64_t &operator[](unsigned id);
+	// Get the value of a condition, or 0 if it is not in this store.
+	int64_t Get(const std::string &name) const;
+	int64_t Get(unsigned id) const;
+	// Get a pointer to the value of a condition, or null if it is not in this
+	// store. The pointer becomes invalid when another condition is added.
+	const int64_t *Find(const std::string &name) const;
+	const int64_t *Find(unsigned id) const;
+	bool Has(const std::string &name) const;
+	// Set the value of a condition. It only counts as changed if it did not
+	// exist before or if its value is different.
+	void Set(const std::string &name, int64_t value);
+	void Set(unsigned id, int64_t value);
+	// Remove a single condition, or all the conditions starting with a prefix.
+	void Erase(const std::string &name);
+	void EraseWithPrefix(const std::string &prefix);
+	
+	// Derive the value of a condition from the given function instead of
+	// storing it. The function is not called until the condition is read, and
+	// its result is kept until the provider is replaced. A prefix provider
+	// gives the values of all the conditions starting with that prefix, keyed
+	// by the rest of their names. Any stored value of a derived condition is
+	// hidden, and modifying it has no effect on what is read.
+	void SetProvider(unsigned id, std::function<int64_t()> provider);
+	void SetPrefixProvider(const std::string &prefix, std::function<std::map<std::string, int64_t>()> provider);
+	
+	// Get all the conditions whose names start with the given prefix (or all
+	// the conditions, if the prefix is empty), sorted by name.
+	std::vector<std::pair<std::string, int64_t>> WithPrefix(const std::string &prefix = "") const;
+	
+	// Check whether any conditions are stored or derived, or count how many
+	// are stored (not including the derived ones).
+	bool IsEmpty() const;
+	size_t Size() const;
+	
+	// This number increases every time any condition in this store changes.
+	uint64_t Revision() const;
+	// Get the revision when the given condition last changed (including being
+	// added or removed), or 0 if it has never been in this store. A derived
+	// condition counts as changed whenever its provider is replaced.
+	uint64_t Revision(unsigned id) const;
+	// Get the ids of all the conditions that have changed since the given
+	// revision. This only includes derived conditions that have been read.
+	std::vector<unsigned> ChangedSince(uint64_t revision) const;
+	
+	
+private:
+	// Each slot in the table belongs to one condition id (or is unused, if its
+	// id is zero). Removed conditions keep their slot, so that the revision
+	// when they were removed is remembered.
+	class Entry {
+	public:
+		unsigned id = 0;
+		bool isSet = false;
+		int64_t value = 0;
+		uint64_t revision = 0;
+	};
+	
+	// A function that derives a single condition, or all the conditions with
+	// a certain prefix, along with its most recent result.
+	class Provider {
+	public:
+		unsigned id = 0;
+		std::string prefix;
+		std::function<int64_t()> value;
+		std::function<std::map<std::string, int64_t>()> values;
+		uint64_t revision = 0;
+		
+		mutable bool isCached = false;
+		mutable int64_t cachedValue = 0;
+		mutable std::map<std::string, int64_t> cachedValues;
+	};
+	
+	
+private:
+	// Find the index of the slot for the given id, or the size of the table if
+	// it has none.
+	size_t Position(unsigned id) const;
+	// Find the slot for the given id, or null if it has none.
+	const Entry *Lookup(unsigned id) const;
+	// Find the slot for the given id, adding it if necessary.
+	Entry &Insert(unsigned id);
+	// Mark the given slot as changed.
+	void Touch(Entry &entry);
+	
+	// Find the provider for the given condition, or null if it is not derived.
+	const Provider *GetProvider(unsigned id) const;
+	// Add or replace a provider, and forget its cached result.
+	void AddProvider(Provider &&provider);
+	// Call the given provider, unless its result is already cached.
+	void Compute(const Provider &provider) const;
+	// Get the value of a derived condition. The name is only needed if it is
+	// derived by a prefix provider.
+	const int64_t *Derive(const Provider &provider, const std::string &name) const;
+	
+	
+private:
+	// The size of the table is always zero or a power of two.
+	std::vector<Entry> entries;
+	// The number of slots that are in use, and the number of conditions that
+	// are currently set.
+	size_t used = 0;
+	size_t count = 0;
+	uint64_t revision = 0;
+	
+	std::vector<Provider> providers;
+	// The provider of each condition id that has been looked up: 0 if it has
+	// not been looked up yet, 1 if it is not derived, or the provider's index
+	// plus 2. Ids are the same in every store, so this can be indexed by id.
+	mutable std::vector<unsigned char> providerOf;
+};
+
+
+
+#endif
@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Conversation.h"
 
+#include "DataCache.h"
 #include "DataNode.h"
 #include "DataWriter.h"
 #include "text/Format.h"
@@ -94,132 +95,8 @@ void Conversation::Load(const DataNode &node)
 	
 	// Free any previously loaded data.
 	nodes.clear();
-	
-	for(const DataNode &child : node)
-	{
-		if(child.Token(0) == "scene" && child.Size() >= 2)
-		{
-			// A scene always starts a new text node.
-			AddNode();
-			nodes.back().scene = SpriteSet::Get(child.Token(1));
-		}
-		else if(child.Token(0) == "label" && child.Size() >= 2)
-		{
-			// You cannot merge text above a label with text below it.
-			if(!nodes.empty())
-				nodes.back().canMergeOnto = false;
-			AddLabel(child.Token(1), child);
-		}
-		else if(child.Token(0) == "choice")
-		{
-			// Create a new node with one or more choices in it.
-			nodes.emplace_back(true);
-			bool foundErrors = false;
-			for(const DataNode &grand : child)
-			{
-				// Check for common errors such as indenting a goto incorrectly:
-				if(grand.Size() > 1)
-				{
-					grand.PrintTrace("Conversation choices should be a single token:");
-					foundErrors = true;
-					continue;
-				}
-				
-				// Store the text of this choice. By default, the choice will
-				// just bring you to the next node in the script.
-				nodes.back().data.emplace_back(grand.Token(0), nodes.size());
-				nodes.back().data.back().first += '\n';
-				
-				LoadGotos(grand);
-			}
-			if(nodes.back().data.empty())
-			{
-				if(!foundErrors)
-					child.PrintTrace("Conversation contains an empty \"choice\" node:");
-				nodes.pop_back();
-			}
-		}
-		else if(child.Token(0) == "name")
-		{
-			// A name entry field is just represented as an empty choice node.
-			nodes.emplace_back(true);
-		}
-		else if(child.Token(0) == "branch")
-		{
-			// Don't merge "branch" nodes with any other nodes.
-			nodes.emplace_back();
-			nodes.back().canMergeOnto = false;
-			nodes.back().conditions.Load(child);
-			// A branch should always specify what node to go to if the test is
-			// true, and may also specify where to go if it is false.
-			for(int i = 1; i <= 2; ++i)
-			{
-				// If no link is provided, just go to the next node.
-				nodes.back().data.emplace_back("", nodes.size());
-				if(child.Size() > i)
-				{
-					int index = TokenIndex(child.Token(i));
-					if(!index)
-						Goto(child.Token(i), nodes.size() - 1, i - 1);
-					else if(index < 0)
-						nodes.back().data.back().second = index;
-				}
-			}
-		}
-		else if(child.Token(0) == "apply")
-		{
-			// Don't merge "apply" nodes with any other nodes.
-			AddNode();
-			nodes.back().canMergeOnto = false;
-			nodes.back().conditions.Load(child);
-		}
-		// Check for common errors such as indenting a goto incorrectly:
-		else if(child.Size() > 1)
-			child.PrintTrace("Conversation text should be a single token:");
-		else
-		{
-			// This is just an ordinary text node.
-			// If the previous node is a choice, or if the previous node ended
-			// in a goto, create a new node. Otherwise, just merge this new
-			// paragraph into the previous node.
-			if(nodes.empty() || !nodes.back().canMergeOnto)
-				AddNode();
-			
-			// Always append a newline to the end of the text.
-			nodes.back().data.back().first += child.Token(0);
-			nodes.back().data.back().first += '\n';
-			
-			// Check whether there is a goto attached to this block of text. If
-			// so, future nodes can't merge onto this one.
-			if(LoadGotos(child))
-				nodes.back().canMergeOnto = false;
-		}
-	}
-	
-	// Display a warning if a label was not resolved.
-	if(!unresolved.empty())
-		for(const auto &it : unresolved)
-			node.PrintTrace("Conversation contains unrecognized label \"" + it.first + "\":");
-	
-	// Check for any loops in the conversation.
-	for(const auto &it : labels)
-	{
-		int nodeIndex = it.second;
-		while(nodeIndex >= 0 && Choices(nodeIndex) <= 1)
-		{
-			nodeIndex = NextNode(nodeIndex);
-			if(nodeIndex == it.second)
-			{
-				node.PrintTrace("Conversation contains infinite loop beginning with label \"" + it.first + "\":");
-				nodes.clear();
-				return;
-			}
-		}
-	}
-	
-	// Free the working buffers that we no longer need.
-	labels.clear();
-	unresolved.clear();
+	// Keep only a compact copy of the definition until it is needed.
+	packed = make_shared<const string>(DataCache::Pack(node));
 }
 
 
@@ -227,6 +104,7 @@ void Conversation::Load(const DataNode &node)
 // Write a conversation to file.
 void Conversation::Save(DataWriter &out) const
 {
+	Unpack();
 	out.Write("conversation");
 	out.BeginChild();
 	{
@@ -286,14 +164,25 @@ void Conversation::Save(DataWriter &out) const
 // Check if this conversation contains any data.
 bool Conversation::IsEmpty() const noexcept
 {
+	Unpack();
 	return nodes.empty();
 }
 
 
 
+// Check if this conversation has been defined, without parsing it. A definition
+// that turns out to be invalid may still leave it empty once it is parsed.
+bool Conversation::IsDefined() const noexcept
+{
+	return packed || !nodes.empty();
+}
+
+
+
 // Check if this conversation contains a name prompt, and thus can be used as an "intro" conversation.
 bool Conversation::IsValidIntro() const noexcept
 {
+	Unpack();
 	return any_of(nodes.begin(), nodes.end(), [](const Node &node) noexcept -> bool {
 		return node.isChoice && node.data.empty();
 	});
@@ -304,6 +193,7 @@ bool Conversation::IsValidIntro() const noexcept
 // Do text replacement throughout this conversation.
 Conversation Conversation::Substitute(const map<string, string> &subs) const
 {
+	Unpack();
 	Conversation result = *this;
 	for(Node &node : result.nodes)
 		for(pair<string, int> &choice : node.data)
@@ -316,6 +206,7 @@ Conversation Conversation::Substitute(const map<string, string> &subs) const
 // Check if the given conversation node is a choice node.
 bool Conversation::IsChoice(int node) const
 {
+	Unpack();
 	if(static_cast<unsigned>(node) >= nodes.size())
 		return false;
 	
@@ -327,6 +218,7 @@ bool Conversation::IsChoice(int node) const
 // If the given node is a choice node, check how many choices it offers.
 int Conversation::Choices(int node) const
 {
+	Unpack();
 	if(static_cast<unsigned>(node) >= nodes.size())
 		return 0;
 	
@@ -338,6 +230,7 @@ int Conversation::Choices(int node) const
 // Check if the given converation node is a conditional branch.
 bool Conversation::IsBranch(int node) const
 {
+	Unpack();
 	if(static_cast<unsigned>(node) >= nodes.size())
 		return false;
 	
@@ -350,6 +243,7 @@ bool Conversation::IsBranch(int node) const
 // Check if the given converation node applies changes to condition variables.
 bool Conversation::IsApply(int node) const
 {
+	Unpack();
 	if(static_cast<unsigned>(node) >= nodes.size())
 		return false;
 	
@@ -361,6 +255,7 @@ bool Conversation::IsApply(int node) const
 // Get the list of conditions that the given node tests or applies.
 const ConditionSet &Conversation::Conditions(int node) const
 {
+	Unpack();
 	static ConditionSet empty;
 	if(static_cast<unsigned>(node) >= nodes.size())
 		return empty;
@@ -373,6 +268,7 @@ const ConditionSet &Conversation::Conditions(int node) const
 // Get the text of the given choice of the given node.
 const string &Conversation::Text(int node, int choice) const
 {
+	Unpack();
 	static const string empty;
 	
 	if(static_cast<unsigned>(node) >= nodes.size()
@@ -387,6 +283,7 @@ const string &Conversation::Text(int node, int choice) const
 // Get the scene image, if any, associated with the given node.
 const Sprite *Conversation::Scene(int node) const
 {
+	Unpack();
 	if(static_cast<unsigned>(node) >= nodes.size())
 		return nullptr;
 	
@@ -398,6 +295,7 @@ const Sprite *Conversation::Scene(int node) const
 // Find out where the conversation goes if the given option is chosen.
 int Conversation::NextNode(int node, int choice) const
 {
+	Unpack();
 	if(static_cast<unsigned>(node) >= nodes.size()
 			|| static_cast<unsigned>(choice) >= nodes[node].data.size())
 		return DECLINE;
@@ -407,6 +305,155 @@ int Conversation::NextNode(int node, int choice) const
 
 
 
+// Parse the given conversation definition.
+void Conversation::Parse(const DataNode &node)
+{
+	for(const DataNode &child : node)
+	{
+		if(child.Token(0) == "scene" && child.Size() >= 2)
+		{
+			// A scene always starts a new text node.
+			AddNode();
+			nodes.back().scene = SpriteSet::Get(child.Token(1));
+		}
+		else if(child.Token(0) == "label" && child.Size() >= 2)
+		{
+			// You cannot merge text above a label with text below it.
+			if(!nodes.empty())
+				nodes.back().canMergeOnto = false;
+			AddLabel(child.Token(1), child);
+		}
+		else if(child.Token(0) == "choice")
+		{
+			// Create a new node with one or more choices in it.
+			nodes.emplace_back(true);
+			bool foundErrors = false;
+			for(const DataNode &grand : child)
+			{
+				// Check for common errors such as indenting a goto incorrectly:
+				if(grand.Size() > 1)
+				{
+					grand.PrintTrace("Conversation choices should be a single token:");
+					foundErrors = true;
+					continue;
+				}
+				
+				// Store the text of this choice. By default, the choice will
+				// just bring you to the next node in the script.
+				nodes.back().data.emplace_back(grand.Token(0), nodes.size());
+				nodes.back().data.back().first += '\n';
+				
+				LoadGotos(grand);
+			}
+			if(nodes.back().data.empty())
+			{
+				if(!foundErrors)
+					child.PrintTrace("Conversation contains an empty \"choice\" node:");
+				nodes.pop_back();
+			}
+		}
+		else if(child.Token(0) == "name")
+		{
+			// A name entry field is just represented as an empty choice node.
+			nodes.emplace_back(true);
+		}
+		else if(child.Token(0) == "branch")
+		{
+			// Don't merge "branch" nodes with any other nodes.
+			nodes.emplace_back();
+			nodes.back().canMergeOnto = false;
+			nodes.back().conditions.Load(child);
+			// A branch should always specify what node to go to if the test is
+			// true, and may also specify where to go if it is false.
+			for(int i = 1; i <= 2; ++i)
+			{
+				// If no link is provided, just go to the next node.
+				nodes.back().data.emplace_back("", nodes.size());
+				if(child.Size() > i)
+				{
+					int index = TokenIndex(child.Token(i));
+					if(!index)
+						Goto(child.Token(i), nodes.size() - 1, i - 1);
+					else if(index < 0)
+						nodes.back().data.back().second = index;
+				}
+			}
+		}
+		else if(child.Token(0) == "apply")
+		{
+			// Don't merge "apply" nodes with any other nodes.
+			AddNode();
+			nodes.back().canMergeOnto = false;
+			nodes.back().conditions.Load(child);
+		}
+		// Check for common errors such as indenting a goto incorrectly:
+		else if(child.Size() > 1)
+			child.PrintTrace("Conversation text should be a single token:");
+		else
+		{
+			// This is just an ordinary text node.
+			// If the previous node is a choice, or if the previous node ended
+			// in a goto, create a new node. Otherwise, just merge this new
+			// paragraph into the previous node.
+			if(nodes.empty() || !nodes.back().canMergeOnto)
+				AddNode();
+			
+			// Always append a newline to the end of the text.
+			nodes.back().data.back().first += child.Token(0);
+			nodes.back().data.back().first += '\n';
+			
+			// Check whether there is a goto attached to this block of text. If
+			// so, future nodes can't merge onto this one.
+			if(LoadGotos(child))
+				nodes.back().canMergeOnto = false;
+		}
+	}
+	
+	// Display a warning if a label was not resolved.
+	if(!unresolved.empty())
+		for(const auto &it : unresolved)
+			node.PrintTrace("Conversation contains unrecognized label \"" + it.first + "\":");
+	
+	// Check for any loops in the conversation.
+	for(const auto &it : labels)
+	{
+		int nodeIndex = it.second;
+		while(nodeIndex >= 0 && Choices(nodeIndex) <= 1)
+		{
+			nodeIndex = NextNode(nodeIndex);
+			if(nodeIndex == it.second)
+			{
+				node.PrintTrace("Conversation contains infinite loop beginning with label \"" + it.first + "\":");
+				nodes.clear();
+				return;
+			}
+		}
+	}
+	
+	// Free the working buffers that we no longer need.
+	labels.clear();
+	unresolved.clear();
+}
+
+
+
+// If this conversation has been loaded but not parsed yet, parse it now.
+void Conversation::Unpack() const
+{
+	if(!packed)
+		return;
+	
+	// Parsing does not change what this conversation contains, only the form
+	// in which it is stored, so it is allowed even for a const conversation.
+	Conversation &self = const_cast<Conversation &>(*this);
+	shared_ptr<const string> data = move(self.packed);
+	DataNode node;
+	if(DataCache::Unpack(*data, node))
+		self.Parse(node);
+}
+
+
+
 // Parse the children of the given node to see if then contain any "gotos."
 // If so, link them up properly. Return true if gotos were found.
 bool Conversation::LoadGotos(const DataNode &node)
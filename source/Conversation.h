@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ConditionSet.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -53,11 +54,15 @@ public:
 	static bool RequiresLaunch(int outcome);
 	
 public:
-	// Read or write to files.
+	// Read or write to files. A loaded conversation is not actually parsed
+	// until the first time something needs its contents, because most of them
+	// are never used in any one session of the game.
 	void Load(const DataNode &node);
 	void Save(DataWriter &out) const;
 	// Check if any data is loaded in this conversation object.
 	bool IsEmpty() const noexcept;
+	// Check if this conversation has been defined, without parsing it.
+	bool IsDefined() const noexcept;
 	// Check if this conversation includes a name prompt.
 	bool IsValidIntro() const noexcept;
 	
@@ -106,6 +111,11 @@ private:
 	
 	
 private:
+	// Parse the given conversation definition.
+	void Parse(const DataNode &node);
+	// If this conversation has been loaded but not parsed yet, parse it now.
+	// This must only be done on the main thread.
+	void Unpack() const;
 	// Parse the children of the given node to see if then contain any "gotos."
 	// If so, link them up properly. Return true if gotos were found.
 	bool LoadGotos(const DataNode &node);
@@ -127,6 +137,9 @@ private:
 	std::multimap<std::string, std::pair<int, int>> unresolved;
 	// The actual conversation data:
 	std::vector<Node> nodes;
+	// Until this conversation is parsed, its definition is kept in the compact
+	// form that the data cache uses. Copies of it can share that definition.
+	std::shared_ptr<const std::string> packed;
 };
 
 
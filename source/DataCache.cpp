@@ -0,0 +1,222 @@
+/* DataCache.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "DataCache.h"
+
+#include "BinaryData.h"
+#include "DataFile.h"
+#include "DataNode.h"
+#include "Files.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+namespace {
+	// The cache file starts with this tag. The version must be changed whenever
+	// the format of the cache or the way that files are parsed changes.
+	const string TAG = "ESDC";
+	const uint32_t VERSION = 1;
+	
+	// The smallest possible size of a cached node: its line number, token
+	// count, and child count.
+	const size_t MIN_NODE_SIZE = 12;
+}
+
+
+
+// Read the cache from the given path.
+DataCache::DataCache(const string &path)
+	: path(path)
+{
+	if(!Files::Exists(path))
+		return;
+	
+	string data = Files::Read(path);
+	if(data.compare(0, TAG.size(), TAG))
+		return;
+	size_t pos = TAG.size();
+	uint32_t version = 0;
+	uint32_t count = 0;
+	if(!BinaryData::Read32(data, pos, version) || version != VERSION || !BinaryData::Read32(data, pos, count))
+		return;
+	
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		string name;
+		Entry entry;
+		uint64_t timestamp = 0;
+		if(!BinaryData::ReadString(data, pos, name) || !BinaryData::Read64(data, pos, timestamp)
+				|| !BinaryData::Read64(data, pos, entry.hash) || !BinaryData::ReadString(data, pos, entry.data))
+		{
+			// If the cache has been truncated, discard it entirely.
+			entries.clear();
+			return;
+		}
+		entry.timestamp = timestamp;
+		entries[name] = move(entry);
+	}
+}
+
+
+
+// Load the data file at the given path, either from the cache or by parsing it.
+void DataCache::Load(const string &path, DataFile &file)
+{
+	int64_t timestamp = Files::Timestamp(path);
+	
+	// Entries are never removed while files are being loaded, so a pointer to
+	// one stays valid even after the mutex is released.
+	Entry *entry = nullptr;
+	{
+		lock_guard<mutex> lock(entryMutex);
+		auto it = entries.find(path);
+		if(it != entries.end())
+			entry = &it->second;
+	}
+	
+	// If the file has not been modified, there is no need to even read it.
+	size_t pos = 0;
+	if(entry && entry->timestamp == timestamp && Read(entry->data, pos, file.root) && pos == entry->data.size())
+	{
+		lock_guard<mutex> lock(entryMutex);
+		entry->isUsed = true;
+		return;
+	}
+	file.root = DataNode();
+	
+	// Otherwise, the cached copy can still be used if the contents are the same.
+	MappedFile text(path);
+	uint64_t hash = BinaryData::Hash(text.Data(), text.Size());
+	pos = 0;
+	if(entry && entry->hash == hash && Read(entry->data, pos, file.root) && pos == entry->data.size())
+	{
+		lock_guard<mutex> lock(entryMutex);
+		entry->timestamp = timestamp;
+		entry->isUsed = true;
+		isChanged = true;
+		return;
+	}
+	file.root = DataNode();
+	
+	// This file has changed, so it must be parsed again.
+	file.Load(path, text.Data(), text.Size());
+	Entry result;
+	result.timestamp = timestamp;
+	result.hash = hash;
+	result.isUsed = true;
+	Write(file.root, result.data);
+	
+	lock_guard<mutex> lock(entryMutex);
+	if(entry)
+		*entry = move(result);
+	else
+		entries[path] = move(result);
+	isChanged = true;
+}
+
+
+
+// Write the cache back to disk if anything in it has changed.
+void DataCache::Save()
+{
+	// Forget about any files that no longer exist, or that are not in any of
+	// the current data sources.
+	for(auto it = entries.begin(); it != entries.end(); )
+	{
+		if(it->second.isUsed)
+			++it;
+		else
+		{
+			it = entries.erase(it);
+			isChanged = true;
+		}
+	}
+	if(!isChanged)
+		return;
+	
+	string out = TAG;
+	BinaryData::Write32(VERSION, out);
+	BinaryData::Write32(entries.size(), out);
+	for(const auto &it : entries)
+	{
+		BinaryData::WriteString(it.first, out);
+		BinaryData::Write64(it.second.timestamp, out);
+		BinaryData::Write64(it.second.hash, out);
+		BinaryData::WriteString(it.second.data, out);
+	}
+	Files::Write(path, out);
+	isChanged = false;
+}
+
+
+
+// Store a single node and its children in the compact cached form.
+string DataCache::Pack(const DataNode &node)
+{
+	string out;
+	Write(node, out);
+	return out;
+}
+
+
+
+// Restore a node that was stored by Pack(). This returns false if the data is
+// incomplete.
+bool DataCache::Unpack(const string &data, DataNode &node)
+{
+	size_t pos = 0;
+	return Read(data, pos, node) && pos == data.size();
+}
+
+
+
+// Store a node and all its children in the cached form.
+void DataCache::Write(const DataNode &node, string &out)
+{
+	BinaryData::Write32(node.lineNumber, out);
+	BinaryData::Write32(node.tokens.size(), out);
+	for(const string &token : node.tokens)
+		BinaryData::WriteString(token, out);
+	BinaryData::Write32(node.children.size(), out);
+	for(const DataNode &child : node.children)
+		Write(child, out);
+}
+
+
+
+// Restore a node and all its children from the cached form. This returns false
+// if the cached data is incomplete.
+bool DataCache::Read(const string &data, size_t &pos, DataNode &node)
+{
+	uint32_t lineNumber = 0;
+	uint32_t count = 0;
+	if(!BinaryData::Read32(data, pos, lineNumber) || !BinaryData::Read32(data, pos, count) || count > (data.size() - pos) / 4)
+		return false;
+	node.lineNumber = lineNumber;
+	
+	node.tokens.resize(count);
+	for(string &token : node.tokens)
+		if(!BinaryData::ReadString(data, pos, token))
+			return false;
+	node.ParseValues();
+	
+	if(!BinaryData::Read32(data, pos, count) || count > (data.size() - pos) / MIN_NODE_SIZE)
+		return false;
+	node.children.reserve(count);
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		node.children.emplace_back(&node);
+		if(!Read(data, pos, node.children.back()))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,77 @@
+/* DataCache.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef DATA_CACHE_H_
+#define DATA_CACHE_H_
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+
+class DataFile;
+class DataNode;
+
+
+
+// Class that keeps an on-disk copy of already parsed data files, in a compact
+// binary form that is much faster to load than the original text. Each file's
+// entry is reused as long as the file has not been modified since it was
+// cached, or if it has the same contents as before (e.g. if a plugin was
+// reinstalled). Files can be loaded from multiple threads at once, as long as
+// no two threads are loading the same file.
+class DataCache {
+public:
+	// Read the cache from the given path. If it does not exist or was written by
+	// an incompatible version of the game, start out with an empty cache.
+	explicit DataCache(const std::string &path);
+	
+	// Load the data file at the given path, either from the cache or by
+	// parsing it and then adding it to the cache.
+	void Load(const std::string &path, DataFile &file);
+	// Write the cache back to disk if anything in it has changed. Only the
+	// files that have been loaded since this cache was read are kept.
+	void Save();
+	
+	// Store a single node and its children in the compact cached form, or
+	// restore it from that form, for data that is kept but seldom needed.
+	static std::string Pack(const DataNode &node);
+	static bool Unpack(const std::string &data, DataNode &node);
+	
+	
+private:
+	class Entry {
+	public:
+		int64_t timestamp = 0;
+		uint64_t hash = 0;
+		std::string data;
+		bool isUsed = false;
+	};
+	
+	
+private:
+	// Convert a data file to and from the cached form.
+	static void Write(const DataNode &node, std::string &out);
+	static bool Read(const std::string &data, size_t &pos, DataNode &node);
+	
+	
+private:
+	std::string path;
+	std::map<std::string, Entry> entries;
+	bool isChanged = false;
+	std::mutex entryMutex;
+};
+
+
+
+#endif
@@ -12,8 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DataFile.h"
 
-#include "Files.h"
-#include "text/Utf8.h"
+#include "MappedFile.h"
 
 using namespace std;
 
@@ -38,19 +37,9 @@ DataFile::DataFile(istream &in)
 // Load from a file path (in UTF-8).
 void DataFile::Load(const string &path)
 {
-	string data = Files::Read(path);
-	if(data.empty())
-		return;
-	
-	// As a sentinel, make sure the file always ends in a newline.
-	if(data.empty() || data.back() != '\n')
-		data.push_back('\n');
-	
-	// Note what file this node is in, so it will show up in error traces.
-	root.tokens.push_back("file");
-	root.tokens.push_back(path);
-	
-	LoadData(data);
+	// Parse the file straight from the mapped memory, instead of copying it.
+	MappedFile file(path);
+	Load(path, file.Data(), file.Size());
 }
 
 
@@ -68,17 +57,14 @@ void DataFile::Load(istream &in)
 		in.read(&*data.begin() + currentSize, BLOCK);
 		data.resize(currentSize + in.gcount());
 	}
-	// As a sentinel, make sure the file always ends in a newline.
-	if(data.empty() || data.back() != '\n')
-		data.push_back('\n');
 	
-	LoadData(data);
+	LoadData(data.data(), data.size());
 }
 
 
 
 // Get an iterator to the start of the list of nodes in this file.
-list<DataNode>::const_iterator DataFile::begin() const
+vector<DataNode>::const_iterator DataFile::begin() const
 {
 	return root.begin();
 }
@@ -86,16 +72,45 @@ list<DataNode>::const_iterator DataFile::begin() const
 
 
 // Get an iterator to the end of the list of nodes in this file.
-list<DataNode>::const_iterator DataFile::end() const
+vector<DataNode>::const_iterator DataFile::end() const
 {
 	return root.end();
 }
 
 
 
-// Parse the given text.
-void DataFile::LoadData(const string &data)
+// Parse the contents of a file that has already been read.
+void DataFile::Load(const string &path, const char *data, size_t size)
 {
+	if(!size)
+		return;
+	
+	// Note what file this node is in, so it will show up in error traces.
+	root.tokens.push_back("file");
+	root.tokens.push_back(path);
+	root.ParseValues();
+	
+	LoadData(data, size);
+}
+
+
+
+// Parse the given text. It is read one byte at a time: every character that
+// matters to the syntax is ASCII, and the bytes of a multi-byte UTF-8 character
+// are never mistaken for ASCII, so they just become part of a token. The text
+// does not have to end in a newline; the end is treated as if it were one.
+void DataFile::LoadData(const char *data, size_t size)
+{
+	auto next = [data, size](size_t &pos) -> char32_t
+	{
+		if(pos >= size)
+		{
+			pos = size + 1;
+			return '\n';
+		}
+		return static_cast<unsigned char>(data[pos++]);
+	};
+	
 	// Keep track of the current stack of indentation levels and the most recent
 	// node at each level - that is, the node that will be the "parent" of any
 	// new node added at the next deeper indentation level.
@@ -105,12 +120,11 @@ void DataFile::LoadData(const string &data)
 	bool warned = false;
 	size_t lineNumber = 0;
 	
-	size_t end = data.length();
-	for(size_t pos = 0; pos < end; )
+	for(size_t pos = 0; pos < size; )
 	{
 		++lineNumber;
 		size_t tokenPos = pos;
-		char32_t c = Utf8::DecodeCodePoint(data, pos);
+		char32_t c = next(pos);
 		
 		// Find the first non-white character in this line.
 		bool isSpaces = false;
@@ -136,13 +150,13 @@ void DataFile::LoadData(const string &data)
 			
 			++white;
 			tokenPos = pos;
-			c = Utf8::DecodeCodePoint(data, pos);
+			c = next(pos);
 		}
 		
 		// If the line is a comment, skip to the end of the line.
 		if(c == '#')
 			while(c != '\n')
-				c = Utf8::DecodeCodePoint(data, pos);
+				c = next(pos);
 		// Skip empty lines (including comment lines).
 		if(c == '\n')
 			continue;
@@ -155,8 +169,9 @@ void DataFile::LoadData(const string &data)
 			stack.pop_back();
 		}
 		
-		// Add this node as a child of the proper node.
-		list<DataNode> &children = stack.back()->children;
+		// Add this node as a child of the proper node. This may move its older
+		// siblings, but none of them are on the stack any more.
+		vector<DataNode> &children = stack.back()->children;
 		children.emplace_back(stack.back());
 		DataNode &node = children.back();
 		node.lineNumber = lineNumber;
@@ -175,7 +190,7 @@ void DataFile::LoadData(const string &data)
 			if(isQuoted)
 			{
 				tokenPos = pos;
-				c = Utf8::DecodeCodePoint(data, pos);
+				c = next(pos);
 			}
 			
 			size_t endPos = tokenPos;
@@ -184,7 +199,7 @@ void DataFile::LoadData(const string &data)
 			while(c != '\n' && (isQuoted ? (c != endQuote) : (c > ' ')))
 			{
 				endPos = pos;
-				c = Utf8::DecodeCodePoint(data, pos);
+				c = next(pos);
 			}
 			
 			// It ought to be legal to construct a string from an empty iterator
@@ -193,7 +208,7 @@ void DataFile::LoadData(const string &data)
 			if(tokenPos == endPos)
 				node.tokens.emplace_back();
 			else
-				node.tokens.emplace_back(data, tokenPos, endPos - tokenPos);
+				node.tokens.emplace_back(data + tokenPos, endPos - tokenPos);
 			// This is not a fatal error, but it may indicate a format mistake:
 			if(isQuoted && c == '\n')
 				node.PrintTrace("Closing quotation mark is missing:");
@@ -205,12 +220,12 @@ void DataFile::LoadData(const string &data)
 				if(isQuoted)
 				{
 					tokenPos = pos;
-					c = Utf8::DecodeCodePoint(data, pos);
+					c = next(pos);
 				}
 				while(c != '\n' && c <= ' ' && c != '#')
 				{
 					tokenPos = pos;
-					c = Utf8::DecodeCodePoint(data, pos);
+					c = next(pos);
 				}
 				
 				// If a comment is encountered outside of a token, skip the rest
@@ -218,9 +233,12 @@ void DataFile::LoadData(const string &data)
 				if(c == '#')
 				{
 					while(c != '\n')
-						c = Utf8::DecodeCodePoint(data, pos);
+						c = next(pos);
 				}
 			}
 		}
+		
+		// Parse any numbers in this line now, rather than every time they are used.
+		node.ParseValues();
 	}
 }
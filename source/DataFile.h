@@ -16,8 +16,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DataNode.h"
 
 #include <istream>
-#include <list>
 #include <string>
+#include <vector>
 
 
 
@@ -38,17 +38,22 @@ public:
 	void Load(std::istream &in);
 	
 	// Functions for iterating through all DataNodes in this file.
-	std::list<DataNode>::const_iterator begin() const;
-	std::list<DataNode>::const_iterator end() const;
+	std::vector<DataNode>::const_iterator begin() const;
+	std::vector<DataNode>::const_iterator end() const;
 	
 	
 private:
-	void LoadData(const std::string &data);
+	// Parse the contents of the file at the given path.
+	void Load(const std::string &path, const char *data, size_t size);
+	void LoadData(const char *data, size_t size);
 	
 	
 private:
 	// This is the container for all DataNodes in this file.
 	DataNode root;
+	
+	// Allow DataCache to fill in a DataFile without parsing the text again.
+	friend class DataCache;
 };
 
 
@@ -36,7 +36,18 @@ DataNode::DataNode(const DataNode *parent)
 
 // Copy constructor.
 DataNode::DataNode(const DataNode &other)
-	: children(other.children), tokens(other.tokens)
+	: children(other.children), tokens(other.tokens), values(other.values)
+{
+	Reparent();
+}
+
+
+
+// Move constructor. This is used when a vector of children is reallocated, so
+// unlike a copy it keeps the parent pointer and line number.
+DataNode::DataNode(DataNode &&other) noexcept
+	: children(move(other.children)), tokens(move(other.tokens)), values(move(other.values)),
+	parent(other.parent), lineNumber(other.lineNumber)
 {
 	Reparent();
 }
@@ -48,6 +59,21 @@ DataNode &DataNode::operator=(const DataNode &other)
 {
 	children = other.children;
 	tokens = other.tokens;
+	values = other.values;
+	Reparent();
+	return *this;
+}
+
+
+
+// Move assignment operator.
+DataNode &DataNode::operator=(DataNode &&other) noexcept
+{
+	children = move(other.children);
+	tokens = move(other.tokens);
+	values = move(other.values);
+	parent = other.parent;
+	lineNumber = other.lineNumber;
 	Reparent();
 	return *this;
 }
@@ -85,10 +111,10 @@ double DataNode::Value(int index) const
 	// Check for empty strings and out-of-bounds indices.
 	if(static_cast<size_t>(index) >= tokens.size() || tokens[index].empty())
 		PrintTrace("Requested token index (" + to_string(index) + ") is out of bounds:");
-	else if(!IsNumber(tokens[index]))
+	else if(!IsNumber(index))
 		PrintTrace("Cannot convert value \"" + tokens[index] + "\" to a number:");
 	else
-		return Value(tokens[index]);
+		return values[index];
 	
 	return 0.;
 }
@@ -151,11 +177,8 @@ double DataNode::Value(const string &token)
 // class is able to parse.
 bool DataNode::IsNumber(int index) const
 {
-	// Make sure this token exists and is not empty.
-	if(static_cast<size_t>(index) >= tokens.size() || tokens[index].empty())
-		return false;
-	
-	return IsNumber(tokens[index]);
+	// Make sure this token exists and was found to be a number when it was loaded.
+	return static_cast<size_t>(index) < values.size() && !std::isnan(values[index]);
 }
 
 
@@ -207,7 +230,7 @@ bool DataNode::HasChildren() const
 
 
 // Iterator to the beginning of the list of children.
-list<DataNode>::const_iterator DataNode::begin() const
+vector<DataNode>::const_iterator DataNode::begin() const
 {
 	return children.begin();
 }
@@ -215,7 +238,7 @@ list<DataNode>::const_iterator DataNode::begin() const
 
 
 // Iterator to the end of the list of children.
-list<DataNode>::const_iterator DataNode::end() const
+vector<DataNode>::const_iterator DataNode::end() const
 {
 	return children.end();
 }
@@ -263,12 +286,21 @@ int DataNode::PrintTrace(const string &message) const
 
 
 
-// Adjust the parent pointers when a copy is made of a DataNode.
+// Adjust the parent pointers when a DataNode is copied or moved. Only the direct
+// children need to be updated: each child's own children were already updated
+// when that child was copied, and are not touched at all by a move.
 void DataNode::Reparent()
 {
 	for(DataNode &child : children)
-	{
 		child.parent = this;
-		child.Reparent();
-	}
+}
+
+
+
+// Convert every token that is a number to its numerical value.
+void DataNode::ParseValues()
+{
+	values.resize(tokens.size());
+	for(size_t i = 0; i < tokens.size(); ++i)
+		values[i] = (!tokens[i].empty() && IsNumber(tokens[i])) ? Value(tokens[i]) : NAN;
 }
@@ -13,7 +13,6 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef DATA_NODE_H_
 #define DATA_NODE_H_
 
-#include <list>
 #include <string>
 #include <vector>
 
@@ -32,8 +31,11 @@ public:
 	explicit DataNode(const DataNode *parent = nullptr);
 	// Copy constructor.
 	DataNode(const DataNode &other);
+	// Moving a node is cheap, because its children stay where they are.
+	DataNode(DataNode &&other) noexcept;
 	
 	DataNode &operator=(const DataNode &other);
+	DataNode &operator=(DataNode &&other) noexcept;
 	
 	// Get the number of tokens in this node.
 	int Size() const;
@@ -54,29 +56,39 @@ public:
 	// Check if this node has any children. If so, the iterator functions below
 	// can be used to access them.
 	bool HasChildren() const;
-	std::list<DataNode>::const_iterator begin() const;
-	std::list<DataNode>::const_iterator end() const;
+	std::vector<DataNode>::const_iterator begin() const;
+	std::vector<DataNode>::const_iterator end() const;
 	
 	// Print a message followed by a "trace" of this node and its parents.
 	int PrintTrace(const std::string &message = "") const;
 	
 	
 private:
-	// Adjust the parent pointers when a copy is made of a DataNode.
+	// Adjust the children's parent pointers when a DataNode is copied or moved.
 	void Reparent();
+	// Convert every token that is a number to its numerical value, so that
+	// Value() and IsNumber() do not have to parse the same token repeatedly.
+	// This must be called whenever the tokens are changed.
+	void ParseValues();
 	
 	
 private:
 	// These are "child" nodes found on subsequent lines with deeper indentation.
-	std::list<DataNode> children;
+	// They are stored contiguously, instead of in a list, so that loading a file
+	// does not need a separate allocation for every line.
+	std::vector<DataNode> children;
 	// These are the tokens found in this particular line of the data file.
 	std::vector<std::string> tokens;
+	// The numerical value of each token, or NaN if it is not a number.
+	std::vector<double> values;
 	// The parent pointer is used only for printing stack traces.
 	const DataNode *parent = nullptr;
 	// The line number in the given file that produced this node.
 	size_t lineNumber = 0;
 	
-	// Allow DataFile to modify the internal structure of DataNodes.
+	// Allow DataFile to modify the internal structure of DataNodes, and
+	// DataCache to store and restore it.
+	friend class DataCache;
 	friend class DataFile;
 };
 
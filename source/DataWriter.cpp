@@ -15,8 +15,15 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DataNode.h"
 #include "Files.h"
 
+#include <exception>
+
 using namespace std;
 
+namespace {
+	// Once this much output has been composed, write it to the file.
+	const streamoff BLOCK_SIZE = 1 << 16;
+}
+
 
 
 // This string constant is just used for remembering what string needs to be
@@ -25,19 +32,38 @@ const string DataWriter::space = " ";
 
 
 
-// Constructor, specifying the file to save.
+// Constructor, specifying the file to save. The output goes to a temporary file
+// until it is complete.
 DataWriter::DataWriter(const string &path)
-	: path(path), before(&indent)
+	: path(path), file(path + ".tmp", true), before(&indent)
 {
 	out.precision(8);
 }
 
 
 
-// Destructor, which saves the file all in one block.
+// Constructor for composing a file in memory.
+DataWriter::DataWriter()
+	: before(&indent)
+{
+	out.precision(8);
+}
+
+
+
+// Destructor, which writes out the rest of the file and then puts it in place
+// of the old one.
 DataWriter::~DataWriter()
 {
-	Files::Write(path, out.str());
+	if(!file)
+		return;
+	
+	Flush();
+	// If the file is being abandoned partway through because of an error, keep
+	// the old one instead.
+	file = File();
+	if(!uncaught_exception())
+		Files::Move(path + ".tmp", path);
 }
 
 
@@ -69,6 +95,10 @@ void DataWriter::Write()
 {
 	out << '\n';
 	before = &indent;
+	
+	// Only whole lines are written out, so the file never ends mid-line.
+	if(file && out.tellp() >= BLOCK_SIZE)
+		Flush();
 }
 
 
@@ -130,3 +160,29 @@ void DataWriter::WriteToken(const string &a)
 {
 	WriteToken(a.c_str());
 }
+
+
+
+// Save everything that has been written to the given path, in the background.
+void DataWriter::SaveInBackground(const string &path)
+{
+	Files::WriteInBackground(path, out.str());
+	out.str(string());
+}
+
+
+
+// Get everything that has been written so far.
+string DataWriter::GetString() const
+{
+	return out.str();
+}
+
+
+
+// Write out whatever has been composed so far.
+void DataWriter::Flush()
+{
+	Files::Write(file, out.str());
+	out.str(string());
+}
@@ -13,6 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef DATA_WRITER_H_
 #define DATA_WRITER_H_
 
+#include "File.h"
+
 #include <algorithm>
 #include <map>
 #include <sstream>
@@ -30,14 +32,19 @@ class DataNode;
 // automatically adds quotation marks around strings if they contain whitespace.
 class DataWriter {
 public:
-	// Constructor, specifying the file to write.
+	// Constructor, specifying the file to write. The output goes to a temporary
+	// file next to it, which only replaces it once the writer is destroyed.
 	explicit DataWriter(const std::string &path);
+	// Constructor for composing a file in memory, which can then be saved with
+	// SaveInBackground().
+	DataWriter();
 	DataWriter(const DataWriter &) = delete;
 	DataWriter(DataWriter &&) = delete;
 	DataWriter &operator=(const DataWriter &) = delete;
 	DataWriter operator=(DataWriter &&) = delete;
-	// The file is not actually saved until the destructor is called. This makes
-	// it possible to write the whole file in a single chunk.
+	// The output is written to the file in large blocks as it is composed, so
+	// even a very large file never needs to be held in memory all at once. The
+	// file is not replaced until the destructor is called.
 	~DataWriter();
 	
 	// The Write() function can take any number of arguments. Each argument is
@@ -67,10 +74,24 @@ public:
 	template <class A>
 	void WriteToken(const A &a);
 	
+	// Save everything that has been written to the given path, on a background
+	// thread (see Files::WriteInBackground()). This is only possible if this
+	// writer was not given a path when it was created.
+	void SaveInBackground(const std::string &path);
+	// Get everything that has been written so far, if this writer is composing
+	// the output in memory.
+	std::string GetString() const;
+	
+	
+private:
+	// Write out whatever has been composed so far.
+	void Flush();
+	
 	
 private:
-	// Save path (in UTF-8).
+	// The file being written, unless the output is being kept in memory.
 	std::string path;
+	File file;
 	// Current indentation level.
 	std::string indent;
 	// Before writing each token, we will write either the indentation string
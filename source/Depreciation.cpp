@@ -31,6 +31,25 @@ namespace {
 	constexpr double DAILY_DEPRECIATION = 0.997;
 	constexpr int GRACE_PERIOD = 7;
 	constexpr int MAX_AGE = 1000 + GRACE_PERIOD;
+	
+	// Get the value fraction for an item of each age from the end of the grace
+	// period up to the maximum age. Valuing a fleet looks this up once for each
+	// day on which something in it was bought, so it is only calculated once.
+	const vector<double> &DepreciationCurve()
+	{
+		static const vector<double> curve = []()
+		{
+			vector<double> result(MAX_AGE - GRACE_PERIOD);
+			for(int age = GRACE_PERIOD; age < MAX_AGE; ++age)
+			{
+				double daily = pow(DAILY_DEPRECIATION, age - GRACE_PERIOD);
+				double linear = static_cast<double>(MAX_AGE - age) / (MAX_AGE - GRACE_PERIOD);
+				result[age - GRACE_PERIOD] = FULL_DEPRECIATION + (1. - FULL_DEPRECIATION) * daily * linear;
+			}
+			return result;
+		}();
+		return curve;
+	}
 }
 
 
@@ -345,9 +364,7 @@ double Depreciation::Depreciate(int age) const
 	if(age >= MAX_AGE)
 		return FULL_DEPRECIATION;
 	
-	double daily = pow(DAILY_DEPRECIATION, age - GRACE_PERIOD);
-	double linear = static_cast<double>(MAX_AGE - age) / (MAX_AGE - GRACE_PERIOD);
-	return FULL_DEPRECIATION + (1. - FULL_DEPRECIATION) * daily * linear;
+	return DepreciationCurve()[age - GRACE_PERIOD];
 }
 
 
@@ -44,17 +44,51 @@ namespace {
 		return make_pair(low, false);
 	}
 	
+	// The mutex guarding the interned strings and the registered keys. Keys may
+	// be registered during static initialization, so this cannot be a global.
+	mutex &InternMutex()
+	{
+		static mutex m;
+		return m;
+	}
+	
 	// String interning: return a pointer to a character string that matches the
 	// given string but has static storage duration.
 	const char *Intern(const char *key)
 	{
 		static set<string> interned;
-		static mutex m;
 		
 		// Just in case this function is accessed from multiple threads:
-		lock_guard<mutex> lock(m);
+		lock_guard<mutex> lock(InternMutex());
 		return interned.insert(key).first->c_str();
 	}
+	
+	// The interned names of all registered keys, in order of their IDs. This
+	// must only be accessed while holding the intern mutex.
+	vector<const char *> &RegisteredKeys()
+	{
+		static vector<const char *> keys;
+		return keys;
+	}
+}
+
+
+
+// Register a key, giving it the next available ID.
+Dictionary::Key::Key(const char *name)
+	: name(Intern(name))
+{
+	lock_guard<mutex> lock(InternMutex());
+	vector<const char *> &keys = RegisteredKeys();
+	id = keys.size();
+	keys.push_back(this->name);
+}
+
+
+
+const char *Dictionary::Key::Name() const
+{
+	return name;
 }
 
 
@@ -65,7 +99,9 @@ double &Dictionary::operator[](const char *key)
 	if(pos.second)
 		return data()[pos.first].second;
 	
-	return insert(begin() + pos.first, make_pair(Intern(key), 0.))->second;
+	insert(begin() + pos.first, make_pair(Intern(key), 0.));
+	UpdatePositions(pos.first);
+	return data()[pos.first].second;
 }
 
 
@@ -89,3 +125,116 @@ double Dictionary::Get(const string &key) const
 {
 	return Get(key.c_str());
 }
+
+
+
+// Get the value of a registered key.
+double Dictionary::Get(const Key &key) const
+{
+	if(key.id < positions.size())
+	{
+		unsigned position = positions[key.id];
+		return position ? data()[position - 1].second : 0.;
+	}
+	// This key was registered after this dictionary was last changed.
+	return Get(key.name);
+}
+
+
+
+// Add every value in the given dictionary, multiplied by the given scale.
+void Dictionary::Add(const Dictionary &other, double scale)
+{
+	// First, count how many of the other dictionary's keys are not in this one.
+	size_t added = 0;
+	auto it = begin();
+	for(const auto &entry : other)
+	{
+		while(it != end() && strcmp(it->first, entry.first) < 0)
+			++it;
+		if(it == end() || it->first != entry.first)
+			++added;
+	}
+	
+	// If no keys need to be inserted, just add to the existing values. Every
+	// key is interned, so two keys with the same name have the same pointer.
+	if(!added)
+	{
+		it = begin();
+		for(const auto &entry : other)
+		{
+			while(it->first != entry.first)
+				++it;
+			it->second += entry.second * scale;
+		}
+		return;
+	}
+	
+	// Otherwise, merge the two from the back, so that each value in this
+	// dictionary is moved only once, directly to its final position.
+	size_t i = size();
+	size_t j = other.size();
+	resize(size() + added);
+	pair<const char *, double> *out = data() + size();
+	const pair<const char *, double> *in = other.data();
+	while(j)
+	{
+		int cmp = i ? strcmp(data()[i - 1].first, in[j - 1].first) : -1;
+		if(cmp > 0)
+			*--out = data()[--i];
+		else if(cmp < 0)
+		{
+			--j;
+			*--out = make_pair(in[j].first, in[j].second * scale);
+		}
+		else
+		{
+			--j;
+			*--out = make_pair(data()[i - 1].first, data()[i - 1].second + in[j].second * scale);
+			--i;
+		}
+	}
+	UpdatePositions();
+}
+
+
+
+// Update the position of each registered key after a key is inserted at the
+// given index.
+void Dictionary::UpdatePositions(size_t inserted)
+{
+	// Every key after the inserted one has moved down by one.
+	for(unsigned &position : positions)
+		if(position > inserted)
+			++position;
+	
+	lock_guard<mutex> lock(InternMutex());
+	const vector<const char *> &keys = RegisteredKeys();
+	const char *name = data()[inserted].first;
+	for(size_t id = 0; id < positions.size(); ++id)
+		if(keys[id] == name)
+			positions[id] = inserted + 1;
+	
+	// Look up any keys that were registered since the last update.
+	for(size_t id = positions.size(); id < keys.size(); ++id)
+	{
+		pair<size_t, bool> pos = Search(keys[id], *this);
+		positions.push_back(pos.second ? pos.first + 1 : 0);
+	}
+}
+
+
+
+// Find the position of every registered key from scratch, after many keys may
+// have been inserted at once.
+void Dictionary::UpdatePositions()
+{
+	lock_guard<mutex> lock(InternMutex());
+	const vector<const char *> &keys = RegisteredKeys();
+	positions.resize(keys.size());
+	for(size_t id = 0; id < keys.size(); ++id)
+	{
+		pair<size_t, bool> pos = Search(keys[id], *this);
+		positions[id] = pos.second ? pos.first + 1 : 0;
+	}
+}
@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef DICTIONARY_H_
 #define DICTIONARY_H_
 
+#include <cstddef>
 #include <string>
 #include <utility>
 #include <vector>
@@ -24,6 +25,24 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 // compared to an STL map. That makes it suitable for ship attributes, which are
 // changed much less frequently than they are queried.
 class Dictionary : private std::vector<std::pair<const char *, double>> {
+public:
+	// A key that is registered before it is used, e.g. as a constant for an
+	// attribute that is looked up often. Every dictionary keeps track of where
+	// each registered key is in it, so getting its value needs no searching.
+	class Key {
+	public:
+		explicit Key(const char *name);
+		
+		const char *Name() const;
+		
+	private:
+		const char *name;
+		size_t id;
+		
+		friend class Dictionary;
+	};
+	
+	
 public:
 	// Access a key for modifying it:
 	double &operator[](const char *key);
@@ -31,11 +50,31 @@ public:
 	// Get the value of a key, or 0 if it does not exist:
 	double Get(const char *key) const;
 	double Get(const std::string &key) const;
+	double Get(const Key &key) const;
+	
+	// Add every value in the given dictionary, multiplied by the given scale,
+	// to the value of the same key in this one. Because both dictionaries are
+	// sorted, this is a single merge instead of one search and insert per key.
+	void Add(const Dictionary &other, double scale = 1.);
 	
 	// Expose certain functions from the underlying vector:
 	using std::vector<std::pair<const char *, double>>::empty;
 	using std::vector<std::pair<const char *, double>>::begin;
 	using std::vector<std::pair<const char *, double>>::end;
+	
+	
+private:
+	// Update the position of each registered key after a key is inserted.
+	void UpdatePositions(size_t inserted);
+	// Find the position of every registered key from scratch.
+	void UpdatePositions();
+	
+	
+private:
+	// For each registered key, its index in this dictionary plus one, or zero
+	// if this dictionary does not contain it. Keys registered after the last
+	// change to this dictionary may be missing from this list.
+	std::vector<unsigned> positions;
 };
 
 
@@ -12,6 +12,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DistanceMap.h"
 
+#include "DistanceTable.h"
+#include "GameData.h"
 #include "Planet.h"
 #include "PlayerInfo.h"
 #include "Ship.h"
@@ -28,7 +30,12 @@ using namespace std;
 DistanceMap::DistanceMap(const System *center, int maxCount, int maxDistance)
 	: center(center), maxCount(maxCount), maxDistance(maxDistance), useWormholes(false)
 {
-	Init();
+	// Without a limit on the number of systems, this is just a copy of part of
+	// the shared table of distances.
+	if(maxCount < 0)
+		InitFromTable();
+	else
+		Init();
 }
 
 
@@ -252,6 +259,33 @@ void DistanceMap::Init(const Ship *ship)
 
 
 
+// Copy the routes to the center from the shared table of distances, for all
+// the systems within the maximum distance.
+void DistanceMap::InitFromTable()
+{
+	if(!center)
+		return;
+	
+	route[center] = Edge();
+	if(!maxDistance)
+		return;
+	
+	for(const auto &it : GameData::Systems())
+	{
+		const System *system = &it.second;
+		int days = DistanceTable::Jumps(center, system);
+		if(days <= 0 || (maxDistance > 0 && days > maxDistance))
+			continue;
+		
+		Edge &edge = route[system];
+		edge.next = DistanceTable::Previous(center, system);
+		edge.days = days;
+		edge.fuel = days * hyperspaceFuel;
+	}
+}
+
+
+
 // Add the given links to the map. Return false if an end condition is hit.
 bool DistanceMap::Propagate(Edge edge, bool useJump)
 {
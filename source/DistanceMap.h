@@ -83,6 +83,9 @@ private:
 	// jump drive paths, or both to find the shortest route. Bail out if the
 	// source system or the maximum count is reached.
 	void Init(const Ship *ship = nullptr);
+	// Fill in the map using the shared table of distances, which gives the
+	// same result as Init() when no ship and no maximum count is given.
+	void InitFromTable();
 	// Add the given links to the map. Return false if an end condition is hit.
 	bool Propagate(Edge edge, bool useJump);
 	// Check if we already have a better path to the given system.
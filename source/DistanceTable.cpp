@@ -0,0 +1,150 @@
+/* DistanceTable.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "DistanceTable.h"
+
+#include "GameData.h"
+#include "System.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// Distances and system indices are stored as 16-bit numbers, which is
+	// plenty for any galaxy that the game could reasonably handle.
+	const uint16_t NONE = numeric_limits<uint16_t>::max();
+	
+	// The routes from one system to every other system.
+	class Row {
+	public:
+		vector<uint16_t> jumps;
+		vector<uint16_t> previous;
+	};
+	
+	// Filters can be checked from both the main thread and the thread that
+	// calculates each step of the game, so the table must be locked.
+	mutex tableMutex;
+	// The universe revision that this table was built for.
+	uint64_t tableRevision = 0;
+	// Each system's row and column in the table.
+	unordered_map<const System *, size_t> indices;
+	vector<const System *> systems;
+	// For each type of travel (i.e. each jump range, or zero for hyperspace
+	// links), the routes from each system, or an empty row if they have not
+	// been found yet.
+	map<double, vector<Row>> tables;
+	
+	
+	// Forget all the routes if the universe has changed since they were found.
+	void Update()
+	{
+		if(tableRevision == GameData::Revision())
+			return;
+		
+		tableRevision = GameData::Revision();
+		indices.clear();
+		systems.clear();
+		tables.clear();
+		// Stop indexing if there are more systems than the table can hold, so
+		// that nothing beyond that is ever reachable.
+		for(const auto &it : GameData::Systems())
+		{
+			if(systems.size() == NONE)
+				break;
+			indices[&it.second] = systems.size();
+			systems.push_back(&it.second);
+		}
+	}
+	
+	
+	// Do a breadth-first search to find the routes to every system from the given one.
+	void FillRow(Row &row, size_t from, double jumpRange)
+	{
+		row.jumps.assign(systems.size(), NONE);
+		row.previous.assign(systems.size(), NONE);
+		row.jumps[from] = 0;
+		
+		vector<size_t> queue(1, from);
+		for(size_t next = 0; next < queue.size(); ++next)
+		{
+			size_t index = queue[next];
+			uint16_t jumps = row.jumps[index] + 1;
+			const System *system = systems[index];
+			for(const System *link : (jumpRange ? system->JumpNeighbors(jumpRange) : system->Links()))
+			{
+				auto it = indices.find(link);
+				if(it == indices.end() || row.jumps[it->second] != NONE)
+					continue;
+				
+				row.jumps[it->second] = jumps;
+				row.previous[it->second] = index;
+				queue.push_back(it->second);
+			}
+		}
+	}
+	
+	
+	// Get the routes from the given system, finding them if necessary. This
+	// returns null if the system is not in the table.
+	const Row *GetRow(const System *from, double jumpRange)
+	{
+		Update();
+		auto it = indices.find(from);
+		if(it == indices.end())
+			return nullptr;
+		
+		vector<Row> &rows = tables[jumpRange];
+		if(rows.empty())
+			rows.resize(systems.size());
+		Row &row = rows[it->second];
+		if(row.jumps.empty())
+			FillRow(row, it->second, jumpRange);
+		return &row;
+	}
+}
+
+
+
+// Get the number of jumps from one system to the other.
+int DistanceTable::Jumps(const System *from, const System *to, double jumpRange)
+{
+	lock_guard<mutex> lock(tableMutex);
+	const Row *row = GetRow(from, jumpRange);
+	auto it = indices.find(to);
+	if(!row || it == indices.end())
+		return -1;
+	
+	uint16_t jumps = row->jumps[it->second];
+	return (jumps == NONE ? -1 : jumps);
+}
+
+
+
+// Get the system that comes just before the given one along the shortest
+// route from the center.
+const System *DistanceTable::Previous(const System *center, const System *system, double jumpRange)
+{
+	lock_guard<mutex> lock(tableMutex);
+	const Row *row = GetRow(center, jumpRange);
+	auto it = indices.find(system);
+	if(!row || it == indices.end())
+		return nullptr;
+	
+	uint16_t previous = row->previous[it->second];
+	return (previous == NONE ? nullptr : systems[previous]);
+}
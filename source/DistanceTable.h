@@ -0,0 +1,42 @@
+/* DistanceTable.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef DISTANCE_TABLE_H_
+#define DISTANCE_TABLE_H_
+
+class System;
+
+
+
+// A table of how many jumps it takes to get from any system to any other, and
+// which way to go to get there. Jumps are made either using the hyperspace
+// links between systems, or (if a jump range is given) using a jump drive to
+// reach each system's neighbors within that range. Unlike a DistanceMap, this
+// does not depend on any particular ship's fuel, or on what systems the
+// player knows about, so it can be shared by every query for the plain
+// distance between two systems. The distances from each system are found the
+// first time they are needed, and are kept until the universe changes.
+class DistanceTable {
+public:
+	// Get the number of jumps from one system to the other, or -1 if there is
+	// no route between them.
+	static int Jumps(const System *from, const System *to, double jumpRange = 0.);
+	// Get the system that comes just before the given one along the shortest
+	// route from the center. If the links between systems go both ways, this
+	// is the next system to travel to from the given one to get closer to the
+	// center. Returns null if there is no route, or if the system is the center.
+	static const System *Previous(const System *center, const System *system, double jumpRange = 0.);
+};
+
+
+
+#endif
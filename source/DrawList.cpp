@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DrawList.h"
 
+#include "Angle.h"
 #include "Body.h"
 #include "Preferences.h"
 #include "Screen.h"
@@ -23,12 +24,17 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+	const Preferences::Setting MOTION_BLUR("Render motion blur");
+}
+
 
 
 // Clear the list.
 void DrawList::Clear(int step, double zoom)
 {
 	items.clear();
+	velocities.clear();
 	this->step = step;
 	this->zoom = zoom;
 	isHighDPI = (Screen::IsHighResolution() ? zoom > .5 : zoom > 1.);
@@ -49,10 +55,11 @@ bool DrawList::Add(const Body &body, double cloak)
 {
 	Point position = body.Position() - center;
 	Point blur = body.Velocity() - centerVelocity;
-	if(Cull(body, position, blur) || cloak >= 1.)
+	Point unit = body.Facing().Unit();
+	if(Cull(body, position, blur, unit) || cloak >= 1.)
 		return false;
 	
-	Push(body, position, blur, cloak, 1., body.GetSwizzle());
+	Push(body, position, blur, unit, cloak, 1., body.GetSwizzle());
 	return true;
 }
 
@@ -62,10 +69,11 @@ bool DrawList::Add(const Body &body, Point position)
 {
 	position -= center;
 	Point blur = body.Velocity() - centerVelocity;
-	if(Cull(body, position, blur))
+	Point unit = body.Facing().Unit();
+	if(Cull(body, position, blur, unit))
 		return false;
 	
-	Push(body, position, blur, 0., 1., body.GetSwizzle());
+	Push(body, position, blur, unit, 0., 1., body.GetSwizzle());
 	return true;
 }
 
@@ -75,10 +83,11 @@ bool DrawList::AddUnblurred(const Body &body)
 {
 	Point position = body.Position() - center;
 	Point blur;
-	if(Cull(body, position, blur))
+	Point unit = body.Facing().Unit();
+	if(Cull(body, position, blur, unit))
 		return false;
 	
-	Push(body, position, blur, 0., 1., body.GetSwizzle());
+	Push(body, position, blur, unit, 0., 1., body.GetSwizzle());
 	return true;
 }
 
@@ -88,35 +97,83 @@ bool DrawList::AddSwizzled(const Body &body, int swizzle)
 {
 	Point position = body.Position() - center;
 	Point blur = body.Velocity() - centerVelocity;
-	if(Cull(body, position, blur))
+	Point unit = body.Facing().Unit();
+	if(Cull(body, position, blur, unit))
 		return false;
 	
-	Push(body, position, blur, 0., 1., swizzle);
+	Push(body, position, blur, unit, 0., 1., swizzle);
 	return true;
 }
 
 
 
+// Add all the items from another list.
+void DrawList::Append(const DrawList &other)
+{
+	items.insert(items.end(), other.items.begin(), other.items.end());
+	velocities.insert(velocities.end(), other.velocities.begin(), other.velocities.end());
+}
+
+
+
+// Get the number of items in the list.
+size_t DrawList::Size() const
+{
+	return items.size();
+}
+
+
+
+// Rotate the items from the given index on around the given position.
+void DrawList::Rotate(size_t first, const Point &position, const Angle &angle)
+{
+	Point pivot = (position - center) * zoom;
+	for(size_t i = first; i < items.size(); ++i)
+	{
+		SpriteShader::Item &item = items[i];
+		Point offset = Point(item.position[0], item.position[1]) - pivot;
+		Float2(pivot + angle.Rotate(offset)).Store(item.position);
+		// Each pair of the transform's values is a vector in screen space, so
+		// they turn along with the position.
+		for(int j = 0; j < 4; j += 2)
+		{
+			Point axis = angle.Rotate(Point(item.transform[j], item.transform[j + 1]));
+			item.transform[j] = axis.X();
+			item.transform[j + 1] = axis.Y();
+		}
+	}
+}
+
+
+
 // Draw all the items in this list.
-void DrawList::Draw() const
+void DrawList::Draw(double fraction) const
 {
 	SpriteShader::Bind();
 	
-	bool withBlur = Preferences::Has("Render motion blur");
-	for(const SpriteShader::Item &item : items)
-		SpriteShader::Add(item, withBlur);
+	bool withBlur = MOTION_BLUR.Has();
+	if(!fraction)
+		for(const SpriteShader::Item &item : items)
+			SpriteShader::Add(item, withBlur);
+	else
+		for(size_t i = 0; i < items.size(); ++i)
+		{
+			SpriteShader::Item item = items[i];
+			item.position[0] += velocities[i].X() * static_cast<float>(fraction);
+			item.position[1] += velocities[i].Y() * static_cast<float>(fraction);
+			SpriteShader::Add(item, withBlur);
+		}
 	
 	SpriteShader::Unbind();
 }
 
 
 
-bool DrawList::Cull(const Body &body, const Point &position, const Point &blur) const
+bool DrawList::Cull(const Body &body, const Point &position, const Point &blur, const Point &unit) const
 {
 	if(!body.HasSprite() || !body.Zoom())
 		return true;
 	
-	Point unit = body.Facing().Unit();
 	// Cull sprites that are completely off screen, to reduce the number of draw
 	// calls that we issue (which may be the bottleneck on some systems).
 	Point size(
@@ -134,18 +191,18 @@ bool DrawList::Cull(const Body &body, const Point &position, const Point &blur)
 
 
 
-void DrawList::Push(const Body &body, Point pos, Point blur, double cloak, double clip, int swizzle)
+void DrawList::Push(const Body &body, Point pos, Point blur, const Point &unit, double cloak, double clip, int swizzle)
 {
 	SpriteShader::Item item;
 	
 	item.texture = body.GetSprite()->Texture(isHighDPI);
 	item.frame = body.GetFrame(step);
 	item.frameCount = body.GetSprite()->Frames();
+	item.firstLayer = body.GetSprite()->FirstLayer(isHighDPI);
 	
 	// Get unit vectors in the direction of the object's width and height.
 	double width = body.Width();
 	double height = body.Height();
-	Point unit = body.Facing().Unit();
 	Point uw = unit * width;
 	Point uh = unit * height;
 	
@@ -157,8 +214,7 @@ void DrawList::Push(const Body &body, Point pos, Point blur, double cloak, doubl
 		pos -= uh * ((1. - clip) * .5);
 		uh *= clip;
 	}
-	item.position[0] = static_cast<float>(pos.X() * zoom);
-	item.position[1] = static_cast<float>(pos.Y() * zoom);
+	Float2(pos * zoom).Store(item.position);
 	
 	// (0, -1) means a zero-degree rotation (since negative Y is up).
 	uw *= zoom;
@@ -177,4 +233,5 @@ void DrawList::Push(const Body &body, Point pos, Point blur, double cloak, doubl
 	item.swizzle = swizzle;
 	
 	items.push_back(item);
+	velocities.emplace_back((body.Velocity() - centerVelocity) * zoom);
 }
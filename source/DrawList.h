@@ -16,9 +16,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 #include "SpriteShader.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
+class Angle;
 class Body;
 class Sprite;
 
@@ -43,16 +45,28 @@ public:
 	bool AddUnblurred(const Body &body);
 	// Add an object using a specific swizzle (rather than its own).
 	bool AddSwizzled(const Body &body, int swizzle);
+	// Add all the items from another list that was built with the same step,
+	// zoom, and center. This allows parts of a list to be built on different
+	// threads and then combined in order.
+	void Append(const DrawList &other);
+	// Get the number of items in the list, so that the ones an object is about
+	// to add can be found again later.
+	size_t Size() const;
+	// Rotate the items from the given index on around the given position, as
+	// if the object they belong to had turned by the given angle.
+	void Rotate(size_t first, const Point &position, const Angle &angle);
 	
-	// Draw all the items in this list.
-	void Draw() const;
+	// Draw all the items in this list. If a fraction of a step is given, each
+	// item is moved that far along its velocity relative to the center.
+	void Draw(double fraction = 0.) const;
 	
 	
 private:
-	// Determine if the given object should be drawn at all.
-	bool Cull(const Body &body, const Point &position, const Point &blur) const;
+	// Determine if the given object should be drawn at all. The unit vector of
+	// its facing is passed in, so that it only needs to be computed once.
+	bool Cull(const Body &body, const Point &position, const Point &blur, const Point &unit) const;
 	
-	void Push(const Body &body, Point pos, Point blur, double cloak, double clip, int swizzle);
+	void Push(const Body &body, Point pos, Point blur, const Point &unit, double cloak, double clip, int swizzle);
 	
 	
 private:
@@ -60,6 +74,8 @@ private:
 	double zoom = 1.;
 	bool isHighDPI = false;
 	std::vector<SpriteShader::Item> items;
+	// The velocity of each item, in pixels per step.
+	std::vector<Float2> velocities;
 	
 	Point center;
 	Point centerVelocity;
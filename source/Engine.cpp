@@ -12,38 +12,47 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Engine.h"
 
+#include "Angle.h"
 #include "Audio.h"
 #include "CoreStartData.h"
 #include "Effect.h"
 #include "Files.h"
 #include "FillShader.h"
+#include "FlatMap.h"
 #include "Fleet.h"
 #include "Flotsam.h"
+#include "FrameArena.h"
 #include "text/Font.h"
 #include "text/FontSet.h"
 #include "text/Format.h"
 #include "FrameTimer.h"
 #include "GameData.h"
 #include "Government.h"
+#include "GpuProfiler.h"
 #include "Hazard.h"
 #include "Interface.h"
 #include "MapPanel.h"
 #include "Mask.h"
+#include "MemoryStats.h"
 #include "Messages.h"
 #include "Minable.h"
 #include "Mission.h"
+#include "Named.h"
 #include "NPC.h"
 #include "OutlineShader.h"
 #include "Person.h"
 #include "Planet.h"
 #include "PlanetLabel.h"
 #include "PlayerInfo.h"
+#include "Profiler.h"
 #include "PointerShader.h"
 #include "Politics.h"
 #include "Preferences.h"
 #include "Projectile.h"
 #include "Random.h"
+#include "Replay.h"
 #include "RingShader.h"
+#include "SceneBuffer.h"
 #include "Screen.h"
 #include "Ship.h"
 #include "ShipEvent.h"
@@ -58,12 +67,59 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "text/WrappedText.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <mutex>
 #include <string>
 
 using namespace std;
 
 namespace {
+	// The game state always advances in steps of 1/60 second.
+	const chrono::steady_clock::duration STEP_TIME = chrono::nanoseconds(1000000000 / 60);
+	
+	// How many ships, projectiles, or visuals are added to each part of the
+	// draw lists that is built on a worker thread.
+	const size_t DRAW_PART_SIZE = 128;
+	
+	// How many ship events to make room for in advance each step.
+	const size_t EVENT_CAPACITY = 256;
+	
+	// On average, how many steps pass between chances for a special person to
+	// enter the player's system (ten minutes).
+	const int PERSON_PERIOD = 36000;
+
+	// Settings that are checked every frame.
+	const Preferences::Setting HIGHLIGHT_FLAGSHIP("Highlight player's flagship");
+	const Preferences::Setting STATUS_OVERLAYS("Show status overlays");
+	const Preferences::Setting PLANET_LABELS("Show planet labels");
+	const Preferences::Setting ROTATE_FLAGSHIP("Rotate flagship in HUD");
+	const Preferences::Setting MINI_MAP("Show mini-map");
+	const Preferences::Setting SHOW_LOAD("Show CPU / GPU load");
+	const Preferences::Setting CLICKABLE_RADAR("Clickable radar display");
+	const Preferences::Setting HYPERSPACE_FLASH("Show hyperspace flash");
+	const Preferences::Setting DISABLE_RADAR_VIEWPORT("Disable viewport on radar");
+	const Preferences::Setting WARNING_SIREN("Warning siren");
+	const Preferences::Setting INTERPOLATE_FRAMES("Interpolate frames");
+	const Preferences::Setting LOW_LATENCY_INPUT("Low latency input");
+	
+	// Sprites, sounds, and colors that are used every frame.
+	const Named<Sprite> FACTION_LEFT("ui/faction left");
+	const Named<Sprite> FACTION_RIGHT("ui/faction right");
+	const Named<Sprite> AMMO_SELECTED("ui/ammo selected");
+	const Named<Sprite> AMMO_UNSELECTED("ui/ammo unselected");
+	const Named<Sound> JUMP_DRIVE("jump drive");
+	const Named<Sound> HYPERDRIVE("hyperdrive");
+	const Named<Sound> JUMP_OUT("jump out");
+	const Named<Sound> HYPERDRIVE_OUT("hyperdrive out");
+	const Named<Sound> JUMP_IN("jump in");
+	const Named<Sound> HYPERDRIVE_IN("hyperdrive in");
+	const Named<Sound> ALARM("alarm");
+	const Named<Color> FLAGSHIP_HIGHLIGHT("flagship highlight");
+	const Named<Color> BRIGHT("bright");
+	const Named<Color> DIM("dim");
+	const Named<Color> MEDIUM("medium");
+	
 	int RadarType(const Ship &ship, int step)
 	{
 		if(ship.GetPersonality().IsTarget() && !ship.IsDestroyed())
@@ -104,6 +160,14 @@ namespace {
 			objects.erase(out, objects.end());
 	}
 	
+	template <class Type>
+	void Prune(vector<shared_ptr<Type>> &objects)
+	{
+		objects.erase(remove_if(objects.begin(), objects.end(),
+				[](const shared_ptr<Type> &object) { return object->ShouldBeRemoved(); }),
+			objects.end());
+	}
+	
 	template <class Type>
 	void Prune(list<shared_ptr<Type>> &objects)
 	{
@@ -169,9 +233,12 @@ namespace {
 	
 	void DrawFlareSprites(const Ship &ship, DrawList &draw, const vector<Ship::EnginePoint> &enginePoints, const vector<pair<Body, int>> &flareSprites, uint8_t side)
 	{
-		for(const Ship::EnginePoint &point : enginePoints)
+		vector<Point> offsets(enginePoints.size());
+		ship.Facing().Rotate(enginePoints.begin(), enginePoints.end(), offsets.begin());
+		for(size_t e = 0; e < enginePoints.size(); ++e)
 		{
-			Point pos = ship.Facing().Rotate(point) * ship.Zoom() + ship.Position();
+			const Ship::EnginePoint &point = enginePoints[e];
+			Point pos = offsets[e] * ship.Zoom() + ship.Position();
 			// If multiple engines with the same flare are installed, draw up to
 			// three copies of the flare sprite.
 			for(const auto &it : flareSprites)
@@ -191,12 +258,28 @@ namespace {
 
 
 
+// For each fleet that may enter the current system, one instance of it that
+// was created ahead of time, or no ships if it is still being created.
+class Engine::PreparedFleets {
+public:
+	mutex fleetMutex;
+	map<const Fleet *, vector<shared_ptr<Ship>>> fleets;
+};
+
+
+
 Engine::Engine(PlayerInfo &player)
-	: player(player), ai(ships, asteroids.Minables(), flotsam),
-	shipCollisions(256u, 32u)
+	: player(player), preparedFleets(make_shared<PreparedFleets>()), antiMissileCollisions(256u, 32u),
+	workers(ThreadPool::Shared()), ai(ships, asteroids.Minables(), flotsam, workers),
+	shipCollisions(256u, 32u), collectorCollisions(256u, 32u)
 {
 	zoom = Preferences::ViewZoom();
 	
+	// Leave room for a big fight's worth of events, so that the calculation
+	// thread does not usually need to allocate any memory for them.
+	eventQueue.reserve(EVENT_CAPACITY);
+	events.reserve(EVENT_CAPACITY);
+	
 	// Start the thread for doing calculations.
 	calcThread = thread(&Engine::ThreadEntryPoint, this);
 	
@@ -229,7 +312,7 @@ Engine::Engine(PlayerInfo &player)
 	
 	// Add all neighboring systems that the player has seen to the radar.
 	const System *targetSystem = flagship ? flagship->GetTargetSystem() : nullptr;
-	const set<const System *> &links = (flagship && flagship->Attributes().Get("jump drive")) ?
+	const FlatSet<const System *> &links = (flagship && flagship->Attributes().Get("jump drive")) ?
 		player.GetSystem()->JumpNeighbors(flagship->JumpRange()) : player.GetSystem()->Links();
 	for(const System *system : links)
 		if(player.HasSeen(*system))
@@ -250,12 +333,19 @@ Engine::~Engine()
 	}
 	condition.notify_all();
 	calcThread.join();
+	
+	// If the player's inputs were being recorded, the recording ends here.
+	Replay::Finish();
 }
 
 
 
 void Engine::Place()
 {
+	// If the player's inputs are being recorded or played back, this is where
+	// that begins.
+	Replay::TakeOff(player);
+	
 	ships.clear();
 	ai.ClearOrders();
 	
@@ -336,7 +426,8 @@ void Engine::Place()
 	}
 	// Move any ships that were randomly spawned into the main list, now
 	// that all special ships have been repositioned.
-	ships.splice(ships.end(), newShips);
+	ships.insert(ships.end(), newShips.begin(), newShips.end());
+	newShips.clear();
 	
 	player.SetPlanet(nullptr);
 }
@@ -421,6 +512,21 @@ void Engine::Place(const list<NPC> &npcs, shared_ptr<Ship> flagship)
 
 
 
+// Add the given ships, which must already be placed in the player's system.
+void Engine::Add(const list<shared_ptr<Ship>> &added)
+{
+	ships.insert(ships.end(), added.begin(), added.end());
+}
+
+
+
+void Engine::AddAsteroids(const string &name, int count, double energy)
+{
+	asteroids.Add(name, count, energy);
+}
+
+
+
 // Wait for the previous calculations (if any) to be done.
 void Engine::Wait()
 {
@@ -431,6 +537,15 @@ void Engine::Wait()
 
 
 
+// Check whether the previous calculations are done, without waiting.
+bool Engine::IsReady()
+{
+	unique_lock<mutex> lock(swapMutex);
+	return calcTickTock == drawTickTock;
+}
+
+
+
 // Begin the next step of calculations.
 void Engine::Step(bool isActive)
 {
@@ -504,7 +619,7 @@ void Engine::Step(bool isActive)
 	}
 	
 	// Draw a highlight to distinguish the flagship from other ships.
-	if(flagship && !flagship->IsDestroyed() && Preferences::Has("Highlight player's flagship"))
+	if(flagship && !flagship->IsDestroyed() && HIGHLIGHT_FLAGSHIP.Has())
 	{
 		highlightSprite = flagship->GetSprite();
 		highlightUnit = flagship->Unit() * zoom;
@@ -524,6 +639,9 @@ void Engine::Step(bool isActive)
 		player.TravelPlan().push_back(flagship->GetTargetSystem());
 	if(player.HasTravelPlan() && currentSystem == player.TravelPlan().back())
 		player.PopTravel();
+	// Make sure the sprites for the next system in the travel plan will be
+	// ready by the time the player arrives there.
+	GameData::PreloadSystem(player.HasTravelPlan() ? player.TravelPlan().back() : nullptr);
 	if(doFlash)
 	{
 		flash = .4;
@@ -584,7 +702,7 @@ void Engine::Step(bool isActive)
 	
 	// Create the status overlays.
 	statuses.clear();
-	if(isActive && Preferences::Has("Show status overlays"))
+	if(isActive && STATUS_OVERLAYS.Has())
 		for(const auto &it : ships)
 		{
 			if(!it->GetGovernment() || it->GetSystem() != currentSystem || it->Cloaking() == 1.)
@@ -597,14 +715,14 @@ void Engine::Step(bool isActive)
 			if(isEnemy || it->IsYours() || it->GetPersonality().IsEscort())
 			{
 				double width = min(it->Width(), it->Height());
-				statuses.emplace_back(it->Position() - center, it->Shields(), it->Hull(),
+				statuses.emplace_back(it->Position() - center, it->Velocity() - centerVelocity, it->Shields(), it->Hull(),
 					min(it->Hull(), it->DisabledHull()), max(20., width * .5), isEnemy);
 			}
 		}
 	
 	// Create the planet labels.
 	labels.clear();
-	if(currentSystem && Preferences::Has("Show planet labels"))
+	if(currentSystem && PLANET_LABELS.Has())
 	{
 		for(const StellarObject &object : currentSystem->Objects())
 		{
@@ -625,7 +743,7 @@ void Engine::Step(bool isActive)
 	if(flagship && flagship->Hull())
 	{
 		Point shipFacingUnit(0., -1.);
-		if(Preferences::Has("Rotate flagship in HUD"))
+		if(ROTATE_FLAGSHIP.Has())
 			shipFacingUnit = flagship->Facing().Unit();
 		
 		info.SetSprite("player sprite", flagship->GetSprite(), shipFacingUnit, flagship->GetFrame(step));
@@ -665,6 +783,7 @@ void Engine::Step(bool isActive)
 		
 		targets.push_back({
 			object->Position() - center,
+			object->Velocity() - centerVelocity,
 			object->Facing(),
 			object->Radius(),
 			object->GetPlanet()->CanLand() ? Radar::FRIENDLY : Radar::HOSTILE,
@@ -745,6 +864,7 @@ void Engine::Step(bool isActive)
 			double size = (target->Width() + target->Height()) * .35;
 			targets.push_back({
 				target->Position() - center,
+				target->Velocity() - centerVelocity,
 				Angle(45.) + target->Facing(),
 				size,
 				targetType,
@@ -781,7 +901,8 @@ void Engine::Step(bool isActive)
 	{
 		double width = max(target->Width(), target->Height());
 		Point pos = target->Position() - center;
-		statuses.emplace_back(pos, flagship->OutfitScanFraction(), flagship->CargoScanFraction(),
+		statuses.emplace_back(pos, target->Velocity() - centerVelocity,
+			flagship->OutfitScanFraction(), flagship->CargoScanFraction(),
 			0, 10. + max(20., width * .5), 2, Angle(pos).Degrees() + 180.);
 	}
 	// Handle any events that change the selected ships.
@@ -827,6 +948,7 @@ void Engine::Step(bool isActive)
 			double size = (ship->Width() + ship->Height()) * .35;
 			targets.push_back({
 				ship->Position() - center,
+				ship->Velocity() - centerVelocity,
 				Angle(45.) + ship->Facing(),
 				size,
 				Radar::PLAYER,
@@ -845,6 +967,7 @@ void Engine::Step(bool isActive)
 			
 			targets.push_back({
 				offset,
+				minable->Velocity() - centerVelocity,
 				minable->Facing(),
 				.8 * minable->Radius(),
 				minable == flagship->GetTargetAsteroid() ? Radar::SPECIAL : Radar::INACTIVE,
@@ -857,19 +980,57 @@ void Engine::Step(bool isActive)
 // Begin the next step of calculations.
 void Engine::Go()
 {
+	// Record the player's inputs for the step that is about to be calculated,
+	// or replace them with the ones from a recording that is being played.
+	if(Replay::IsActive())
+	{
+		Replay::Input input;
+		input.command = activeCommands;
+		input.isClick = doClick;
+		input.isRightClick = isRightClick;
+		input.isRadarClick = isRadarClick;
+		input.hasShift = hasShift;
+		input.clickPoint = clickPoint;
+		input.clickBox = clickBox;
+		Replay::Step(input);
+		activeCommands = input.command;
+		doClick = input.isClick;
+		isRightClick = input.isRightClick;
+		isRadarClick = input.isRadarClick;
+		hasShift = input.hasShift;
+		clickPoint = input.clickPoint;
+		clickBox = input.clickBox;
+	}
+	PredictFlagshipTurn();
 	{
 		unique_lock<mutex> lock(swapMutex);
 		++step;
 		drawTickTock = !drawTickTock;
+		isCalcStepDrawn = isNextStepDrawn;
 	}
 	condition.notify_all();
+	
+	// Keep the times of the steps on a fixed schedule, so that any frames that
+	// are drawn in between them are spaced evenly, but never let the schedule
+	// get more than one step ahead of or behind the actual time.
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	stepTime = max(now - STEP_TIME, min(now, stepTime + STEP_TIME));
+}
+
+
+
+// Set whether the steps that begin from now on will be drawn. If not,
+// they skip building the draw lists and radar.
+void Engine::SetNextStepDrawn(bool isDrawn)
+{
+	isNextStepDrawn = isDrawn;
 }
 
 
 
 // Pass the list of game events to MainPanel for handling by the player, and any
 // UI element generation.
-list<ShipEvent> &Engine::Events()
+vector<ShipEvent> &Engine::Events()
 {
 	return events;
 }
@@ -879,17 +1040,38 @@ list<ShipEvent> &Engine::Events()
 // Draw a frame.
 void Engine::Draw() const
 {
-	GameData::Background().Draw(center, centerVelocity, zoom);
+	Profiler::Scope profile("Draw");
+	GpuProfiler::Scope gpuProfile("GPU draw");
+	
+	// If frames are being interpolated, everything is drawn moved along its
+	// velocity by the fraction of a step that has elapsed.
+	double fraction = DrawFraction();
+	// The scene itself may be drawn at a lower resolution and then stretched to
+	// fill the screen, but everything drawn on top of it is drawn at full
+	// resolution, so that text and the HUD stay sharp.
+	SceneBuffer::Begin();
+	{
+		GpuProfiler::Scope gpuPhase("GPU starfield");
+		GameData::Background().Draw(center + centerVelocity * fraction, centerVelocity, zoom);
+	}
 	static const Set<Color> &colors = GameData::Colors();
 	const Interface *hud = GameData::Interfaces().Get("hud");
 	
 	// Draw any active planet labels.
 	for(const PlanetLabel &label : labels)
-		label.Draw();
+		label.Draw(centerVelocity * (-fraction * zoom));
 	
-	draw[drawTickTock].Draw();
-	batchDraw[drawTickTock].Draw();
+	{
+		GpuProfiler::Scope gpuPhase("GPU draw list");
+		draw[drawTickTock].Draw(fraction);
+	}
+	{
+		GpuProfiler::Scope gpuPhase("GPU batch draw list");
+		batchDraw[drawTickTock].Draw(fraction);
+	}
+	SceneBuffer::End();
 	
+	// Draw the status overlays. The rings are all drawn in a single batch.
 	for(const auto &it : statuses)
 	{
 		static const Color color[8] = {
@@ -902,7 +1084,7 @@ void Engine::Draw() const
 			*colors.Get("overlay friendly disabled"),
 			*colors.Get("overlay hostile disabled")
 		};
-		Point pos = it.position * zoom;
+		Point pos = (it.position + it.velocity * fraction) * zoom;
 		double radius = it.radius * zoom;
 		if(it.outer > 0.)
 			RingShader::Draw(pos, radius + 3., 1.5f, it.outer, color[it.type], 0.f, it.angle);
@@ -917,7 +1099,7 @@ void Engine::Draw() const
 	if(highlightSprite)
 	{
 		Point size(highlightSprite->Width(), highlightSprite->Height());
-		const Color &color = *colors.Get("flagship highlight");
+		const Color &color = *FLAGSHIP_HIGHLIGHT;
 		// The flagship is always in the dead center of the screen.
 		OutlineShader::Draw(highlightSprite, Point(), size, color, highlightUnit, highlightFrame);
 	}
@@ -934,15 +1116,18 @@ void Engine::Draw() const
 	messageLine.SetWrapWidth(messageBox.Width());
 	messageLine.SetParagraphBreak(0.);
 	Point messagePoint = Point(messageBox.Left(), messageBox.Bottom());
-	for(auto it = messages.rbegin(); it != messages.rend(); ++it)
 	{
-		messageLine.Wrap(it->message);
-		messagePoint.Y() -= messageLine.Height();
-		if(messagePoint.Y() < messageBox.Top())
-			break;
-		float alpha = (it->step + 1000 - step) * .001f;
-		Color color(alpha, 0.f);
-		messageLine.Draw(messagePoint, color);
+		GpuProfiler::Scope gpuPhase("GPU text");
+		for(auto it = messages.rbegin(); it != messages.rend(); ++it)
+		{
+			messageLine.Wrap(it->message);
+			messagePoint.Y() -= messageLine.Height();
+			if(messagePoint.Y() < messageBox.Top())
+				break;
+			float alpha = (it->step + 1000 - step) * .001f;
+			Color color(alpha, 0.f);
+			messageLine.Draw(messagePoint, color);
+		}
 	}
 	
 	// Draw crosshairs around anything that is targeted.
@@ -951,20 +1136,22 @@ void Engine::Draw() const
 		Angle a = target.angle;
 		Angle da(360. / target.count);
 		
-		PointerShader::Bind();
 		for(int i = 0; i < target.count; ++i)
 		{
-			PointerShader::Add(target.center * zoom, a.Unit(), 12.f, 14.f, -target.radius * zoom,
+			PointerShader::Draw((target.center + target.velocity * fraction) * zoom, a.Unit(), 12.f, 14.f, -target.radius * zoom,
 				Radar::GetColor(target.type));
 			a += da;
 		}
-		PointerShader::Unbind();
 	}
 	
 	// Draw the heads-up display.
-	hud->Draw(info);
+	{
+		GpuProfiler::Scope gpuPhase("GPU HUD");
+		hud->Draw(info);
+	}
 	if(hud->HasPoint("radar"))
 	{
+		GpuProfiler::Scope gpuPhase("GPU radar");
 		radar[drawTickTock].Draw(
 			hud->GetPoint("radar"),
 			RADAR_SCALE,
@@ -984,13 +1171,13 @@ void Engine::Draw() const
 		int width = font.Width(info.GetString("target government"));
 		Point center = hud->GetPoint("faction markers");
 		
-		const Sprite *mark[2] = {SpriteSet::Get("ui/faction left"), SpriteSet::Get("ui/faction right")};
+		const Sprite *mark[2] = {FACTION_LEFT, FACTION_RIGHT};
 		// Round the x offsets to whole numbers so the icons are sharp.
 		double dx[2] = {(width + mark[0]->Width() + 1) / -2, (width + mark[1]->Width() + 1) / 2};
 		for(int i = 0; i < 2; ++i)
 			SpriteShader::Draw(mark[i], center + Point(dx[i], 0.), 1., targetSwizzle);
 	}
-	if(jumpCount && Preferences::Has("Show mini-map"))
+	if(jumpCount && MINI_MAP.Has())
 		MapPanel::DrawMiniMap(player, .5f * min(1.f, jumpCount / 30.f), jumpInProgress, step);
 	
 	// Draw ammo status.
@@ -999,10 +1186,10 @@ void Engine::Draw() const
 	Rectangle ammoBox = hud->GetBox("ammo");
 	// Pad the ammo list by the same amount on all four sides.
 	double ammoPad = .5 * (ammoBox.Width() - AMMO_WIDTH);
-	const Sprite *selectedSprite = SpriteSet::Get("ui/ammo selected");
-	const Sprite *unselectedSprite = SpriteSet::Get("ui/ammo unselected");
-	Color selectedColor = *colors.Get("bright");
-	Color unselectedColor = *colors.Get("dim");
+	const Sprite *selectedSprite = AMMO_SELECTED;
+	const Sprite *unselectedSprite = AMMO_UNSELECTED;
+	Color selectedColor = *BRIGHT;
+	Color unselectedColor = *DIM;
 	
 	// This is the top left corner of the ammo display.
 	Point pos(ammoBox.Left() + ammoPad, ammoBox.Bottom() - ammoPad);
@@ -1034,17 +1221,38 @@ void Engine::Draw() const
 	// Draw escort status.
 	escorts.Draw(hud->GetBox("escorts"));
 	
-	// Upload any preloaded sprites that are now available. This is to avoid
-	// filling the entire backlog of sprites before landing on a planet.
-	GameData::Progress();
-	
-	if(Preferences::Has("Show CPU / GPU load"))
+	if(SHOW_LOAD.Has())
 	{
 		string loadString = to_string(lround(load * 100.)) + "% CPU";
-		Color color = *colors.Get("medium");
+		Color color = *MEDIUM;
 		font.Draw(loadString,
 			Point(-10 - font.Width(loadString), Screen::Height() * -.5 + 5.), color);
 	}
+	
+	// In debug mode, show how long each part of the game loop is taking.
+	if(Profiler::IsEnabled())
+	{
+		Color color = *MEDIUM;
+		Point pos(-10., Screen::Height() * -.5 + 25.);
+		for(const auto &it : Profiler::Averages())
+		{
+			string text = it.first + ": " + Format::Decimal(it.second, 2) + " ms";
+			font.Draw(text, pos - Point(font.Width(text), 0.), color);
+			pos.Y() += 20.;
+		}
+		for(const auto &it : Profiler::Counters())
+		{
+			string text = it.first + ": " + to_string(it.second);
+			font.Draw(text, pos - Point(font.Width(text), 0.), color);
+			pos.Y() += 20.;
+		}
+		for(const auto &it : MemoryStats::Totals())
+		{
+			string text = it.first + ": " + Format::Decimal(it.second / 1048576., 1) + " MB";
+			font.Draw(text, pos - Point(font.Width(text), 0.), color);
+			pos.Y() += 20.;
+		}
+	}
 }
 
 
@@ -1069,7 +1277,7 @@ void Engine::Click(const Point &from, const Point &to, bool hasShift)
 	const Interface *hud = GameData::Interfaces().Get("hud");
 	Point radarCenter = hud->GetPoint("radar");
 	double radarRadius = hud->GetValue("radar radius");
-	if(Preferences::Has("Clickable radar display") && (from - radarCenter).Length() <= radarRadius)
+	if(CLICKABLE_RADAR.Has() && (from - radarCenter).Length() <= radarRadius)
 		isRadarClick = true;
 	else
 		isRadarClick = false;
@@ -1095,7 +1303,7 @@ void Engine::RClick(const Point &point)
 	const Interface *hud = GameData::Interfaces().Get("hud");
 	Point radarCenter = hud->GetPoint("radar");
 	double radarRadius = hud->GetValue("radar radius");
-	if(Preferences::Has("Clickable radar display") && (point - radarCenter).Length() <= radarRadius)
+	if(CLICKABLE_RADAR.Has() && (point - radarCenter).Length() <= radarRadius)
 		clickPoint = (point - radarCenter) / RADAR_SCALE;
 	else
 		clickPoint = point / zoom;
@@ -1122,9 +1330,26 @@ void Engine::EnterSystem()
 	
 	doEnter = true;
 	player.IncrementDate();
-	const Date &today = player.GetDate();
 	
+	// Fleets from the previous system will not be entering this one. Any that
+	// were prepared for this system while the flagship was jumping are kept.
+	pendingFleets.clear();
 	const System *system = flagship->GetSystem();
+	{
+		lock_guard<mutex> lock(preparedFleets->fleetMutex);
+		for(auto it = preparedFleets->fleets.begin(); it != preparedFleets->fleets.end(); )
+		{
+			bool isHere = false;
+			for(const System::FleetProbability &fleet : system->Fleets())
+				isHere |= (fleet.Get() == it->first);
+			if(isHere)
+				++it;
+			else
+				it = preparedFleets->fleets.erase(it);
+		}
+	}
+	const Date &today = player.GetDate();
+	
 	Audio::PlayMusic(system->MusicName());
 	GameData::SetHaze(system->Haze());	
 	
@@ -1193,7 +1418,15 @@ void Engine::EnterSystem()
 	{
 		for(const System::FleetProbability &fleet : system->Fleets())
 			if(fleet.Get()->GetGovernment() && Random::Int(fleet.Period()) < 60)
-				fleet.Get()->Place(*system, newShips);
+			{
+				// Use an instance of this fleet that was created while the
+				// flagship was jumping here, if there is one.
+				vector<shared_ptr<Ship>> placed = TakePreparedFleet(fleet.Get());
+				if(placed.empty())
+					fleet.Get()->Place(*system, newShips);
+				else
+					fleet.Get()->Place(*system, std::move(placed), newShips);
+			}
 		for(const System::HazardProbability &hazard : system->Hazards())
 			if(Random::Int(hazard.Period()) < 60)
 			{
@@ -1273,16 +1506,34 @@ void Engine::CalculateStep()
 {
 	FrameTimer loadTimer;
 	
-	// Clear the list of objects to draw.
-	draw[calcTickTock].Clear(step, zoom);
-	batchDraw[calcTickTock].Clear(step, zoom);
-	radar[calcTickTock].Clear();
+	// Nothing from the last step still needs its temporary memory, so every
+	// thread can start reusing its arena from the beginning.
+	FrameArena::NextStep();
+	
+	// Clear the list of objects to draw. If this step will not be drawn, leave
+	// the lists from an earlier step in place instead, so that if it ends up
+	// being drawn after all, that is all that will be out of date.
+	if(isCalcStepDrawn)
+	{
+		draw[calcTickTock].Clear(step, zoom);
+		batchDraw[calcTickTock].Clear(step, zoom);
+		radar[calcTickTock].Clear();
+	}
 	
 	if(!player.GetSystem())
 		return;
 	
+	// Find every ship's animation frame for this step all at once, so that the
+	// turret aiming and collision checks that are split between threads only
+	// ever read the frames instead of calculating them.
+	workers.ForEach(ships.size(), [this](size_t i) { ships[i]->SetStep(step); });
+	
 	// Now, all the ships must decide what they are doing next.
-	ai.Step(player, activeCommands);
+	Profiler::SetCounter("Ships", ships.size());
+	{
+		Profiler::Scope profile("AI step");
+		ai.Step(player, activeCommands);
+	}
 	
 	// Clear the active players commands, they are all processed at this point.
 	activeCommands.Clear();
@@ -1300,16 +1551,26 @@ void Engine::CalculateStep()
 	// Keep track of the flagship to see if it jumps or enters a wormhole this turn.
 	const Ship *flagship = player.Flagship();
 	bool wasHyperspacing = (flagship && flagship->IsEnteringHyperspace());
-	// Move all the ships.
-	for(const shared_ptr<Ship> &it : ships)
-		MoveShip(it);
-	// If the flagship just began jumping, play the appropriate sound.
+	// Move all the ships. The part of each ship's movement that only depends
+	// on that ship is done for many ships at once; the rest of the movement
+	// (which may interact with other ships or create new objects) is done one
+	// ship at a time, in order, so the results do not depend on the threads.
+	{
+		Profiler::Scope profile("Ship movement");
+		workers.ForEach(ships.size(), [this](size_t i) { ships[i]->PrepareMove(); });
+		for(const shared_ptr<Ship> &it : ships)
+			MoveShip(it);
+	}
+	// If the flagship just began jumping, play the appropriate sound, and start
+	// creating the fleets that will already be in the system it is going to.
 	if(!wasHyperspacing && flagship && flagship->IsEnteringHyperspace())
 	{
+		if(flagship->GetTargetSystem())
+			PrepareFleets(*flagship->GetTargetSystem());
 		bool isJumping = flagship->IsUsingJumpDrive();
-		const map<const Sound *, int> &jumpSounds = isJumping ? flagship->Attributes().JumpSounds() : flagship->Attributes().HyperSounds();
+		const FlatMap<const Sound *, int> &jumpSounds = isJumping ? flagship->Attributes().JumpSounds() : flagship->Attributes().HyperSounds();
 		if(jumpSounds.empty())
-			Audio::Play(Audio::Get(isJumping ? "jump drive" : "hyperdrive"));
+			Audio::Play(isJumping ? JUMP_DRIVE : HYPERDRIVE);
 		else
 			for(const auto &sound : jumpSounds)
 				Audio::Play(sound.first);
@@ -1324,7 +1585,7 @@ void Engine::CalculateStep()
 						it.GetPlanet()->WormholeDestination(playerSystem) == flagship->GetSystem())
 					player.Visit(*it.GetPlanet());
 		
-		doFlash = Preferences::Has("Show hyperspace flash");
+		doFlash = HYPERSPACE_FLASH.Has();
 		playerSystem = flagship->GetSystem();
 		player.SetSystem(*playerSystem);
 		EnterSystem();
@@ -1341,9 +1602,16 @@ void Engine::CalculateStep()
 		it->Move(newVisuals);
 	Prune(flotsam);
 	
-	// Move the projectiles.
-	for(Projectile &projectile : projectiles)
-		projectile.Move(newVisuals, newProjectiles);
+	// Move the projectiles. The ships are done moving, so the homing course of
+	// every projectile can be worked out at once before they are moved in order.
+	// Most projectiles fly straight, and are moved entirely by Guide(), leaving
+	// only the homing, trailing, and dying ones for the serial loop.
+	{
+		Profiler::Scope profile("Projectile movement");
+		workers.ForEach(projectiles.size(), [this](size_t i) { projectiles[i].Guide(); });
+		for(Projectile &projectile : projectiles)
+			projectile.Move(newVisuals, newProjectiles);
+	}
 	Prune(projectiles);
 	
 	// Step the weather.
@@ -1357,9 +1625,8 @@ void Engine::CalculateStep()
 	Prune(visuals);
 	
 	// Perform various minor actions.
+	StepSpawns();
 	SpawnFleets();
-	SpawnPersons();
-	GenerateWeather();
 	SendHails();
 	HandleMouseClicks();
 	
@@ -1368,7 +1635,8 @@ void Engine::CalculateStep()
 	// be drawn this step (and the projectiles will participate in collision
 	// detection) but they should not be moved, which is why we put off adding
 	// them to the lists until now.
-	ships.splice(ships.end(), newShips);
+	ships.insert(ships.end(), newShips.begin(), newShips.end());
+	newShips.clear();
 	Append(projectiles, newProjectiles);
 	flotsam.splice(flotsam.end(), newFlotsam);
 	Append(visuals, newVisuals);
@@ -1378,11 +1646,20 @@ void Engine::CalculateStep()
 		--grudgeTime;
 	
 	// Populate the collision detection lookup sets.
-	FillCollisionSets();
+	{
+		Profiler::Scope profile("Collision fill");
+		FillCollisionSets();
+	}
 	
-	// Perform collision detection.
-	for(Projectile &projectile : projectiles)
-		DoCollisions(projectile);
+	// Perform collision detection. Checking the projectiles against the ships
+	// does not change anything, so it can be done for all of them at once.
+	{
+		Profiler::Scope profile("Collisions");
+		shipCollisions.Line(projectiles, projectileHits, workers);
+		for(size_t i = 0; i < projectiles.size(); ++i)
+			DoCollisions(projectiles[i], projectileHits[i]);
+		DoBlasts();
+	}
 	// Now that collision detection is done, clear the cache of ships with anti-
 	// missile systems ready to fire.
 	hasAntiMissile.clear();
@@ -1391,13 +1668,16 @@ void Engine::CalculateStep()
 	for(Weather &weather : activeWeather)
 		DoWeather(weather);
 	
-	// Check for flotsam collection (collisions with ships).
-	for(const shared_ptr<Flotsam> &it : flotsam)
-		DoCollection(*it);
+	// Check for flotsam collection (collisions with ships). If no ship is able
+	// to pick anything up, there is no need to check any of the flotsam.
+	if(hasCollectors)
+		for(const shared_ptr<Flotsam> &it : flotsam)
+			DoCollection(*it);
 	
-	// Check for ship scanning.
-	for(const shared_ptr<Ship> &it : ships)
+	// Check for ship scanning. Only ships in the player's system can scan.
+	for(const shared_ptr<Ship> &it : scanners)
 		DoScanning(it);
+	scanners.clear();
 	
 	// Draw the objects. Start by figuring out where the view should be centered:
 	Point newCenter = center;
@@ -1407,12 +1687,40 @@ void Engine::CalculateStep()
 		newCenter = flagship->Position();
 		newCenterVelocity = flagship->Velocity();
 	}
-	draw[calcTickTock].SetCenter(newCenter, newCenterVelocity);
-	batchDraw[calcTickTock].SetCenter(newCenter);
-	radar[calcTickTock].SetCenter(newCenter);
 	
-	// Populate the radar.
-	FillRadar();
+	// Populate the radar, and check if hostile ships have appeared. If this
+	// step will not be drawn (e.g. when fast-forwarding), only the check for
+	// hostile ships is needed, and there is no need to build the draw lists.
+	{
+		Profiler::Scope profile("Radar");
+		if(isCalcStepDrawn)
+			radar[calcTickTock].SetCenter(newCenter);
+		FillRadar(isCalcStepDrawn);
+	}
+	if(isCalcStepDrawn)
+		FillDrawLists(playerSystem, flagship, newCenter, newCenterVelocity);
+	
+	// Keep track of how much of the CPU time we are using.
+	loadSum += loadTimer.Time();
+	if(++loadCount == 60)
+	{
+		load = loadSum;
+		loadSum = 0.;
+		loadCount = 0;
+	}
+}
+
+
+
+// Build the lists of everything that will be drawn for this step.
+void Engine::FillDrawLists(const System *playerSystem, const Ship *flagship,
+	const Point &newCenter, const Point &newCenterVelocity)
+{
+	Profiler::Scope profile("Draw lists");
+	
+	draw[calcTickTock].SetCenter(newCenter, newCenterVelocity);
+	batchDraw[calcTickTock].SetCenter(newCenter, newCenterVelocity);
+	flagshipDrawIndex[calcTickTock] = -1;
 	
 	// Draw the planets.
 	for(const StellarObject &object : playerSystem->Objects())
@@ -1425,18 +1733,19 @@ void Engine::CalculateStep()
 				draw[calcTickTock].Add(object);
 		}
 	// Draw the asteroids and minables.
-	asteroids.Draw(draw[calcTickTock], newCenter, zoom);
+	asteroids.Draw(draw[calcTickTock], newCenter, newCenterVelocity, zoom);
 	// Draw the flotsam.
 	for(const shared_ptr<Flotsam> &it : flotsam)
 		draw[calcTickTock].Add(*it);
 	// Draw the ships. Skip the flagship, then draw it on top of all the others.
+	vector<const Ship *> shipsToDraw;
 	bool showFlagship = false;
 	for(const shared_ptr<Ship> &ship : ships)
 		if(ship->GetSystem() == playerSystem && ship->HasSprite())
 		{
 			if(ship.get() != flagship)
 			{
-				AddSprites(*ship);
+				shipsToDraw.push_back(ship.get());
 				if(ship->IsThrusting() && !ship->EnginePoints().empty())
 				{
 					for(const auto &it : ship->Attributes().FlareSounds())
@@ -1459,7 +1768,6 @@ void Engine::CalculateStep()
 		
 	if(flagship && showFlagship)
 	{
-		AddSprites(*flagship);
 		if(flagship->IsThrusting() && !flagship->EnginePoints().empty())
 		{
 			for(const auto &it : flagship->Attributes().FlareSounds())
@@ -1476,21 +1784,56 @@ void Engine::CalculateStep()
 				Audio::Play(it.first);
 		}
 	}
-	// Draw the projectiles.
-	for(const Projectile &projectile : projectiles)
-		batchDraw[calcTickTock].Add(projectile, projectile.Clip());
-	// Draw the visuals.
-	for(const Visual &visual : visuals)
-		batchDraw[calcTickTock].AddVisual(visual);
-	
-	// Keep track of how much of the CPU time we are using.
-	loadSum += loadTimer.Time();
-	if(++loadCount == 60)
+	// Each ship's sprites only depend on that ship, so they are found for many
+	// ships at once, in separate parts of the draw list.
+	size_t shipParts = (shipsToDraw.size() + DRAW_PART_SIZE - 1) / DRAW_PART_SIZE;
+	if(drawParts.size() < shipParts)
+		drawParts.resize(shipParts);
+	workers.ForEach(shipParts, [this, &shipsToDraw, &newCenter, &newCenterVelocity](size_t part)
+	{
+		DrawList &drawList = drawParts[part];
+		drawList.Clear(step, zoom);
+		drawList.SetCenter(newCenter, newCenterVelocity);
+		size_t end = min(shipsToDraw.size(), (part + 1) * DRAW_PART_SIZE);
+		for(size_t i = part * DRAW_PART_SIZE; i < end; ++i)
+			AddSprites(*shipsToDraw[i], drawList);
+	});
+	for(size_t part = 0; part < shipParts; ++part)
+		draw[calcTickTock].Append(drawParts[part]);
+	// The flagship's sprites are added last, so that they can be found again
+	// when this step is drawn.
+	if(flagship && showFlagship)
 	{
-		load = loadSum;
-		loadSum = 0.;
-		loadCount = 0;
+		flagshipDrawIndex[calcTickTock] = draw[calcTickTock].Size();
+		AddSprites(*flagship, draw[calcTickTock]);
 	}
+	
+	// Draw the projectiles, then the visuals, in the same way.
+	size_t projectileParts = (projectiles.size() + DRAW_PART_SIZE - 1) / DRAW_PART_SIZE;
+	size_t batchParts = projectileParts + (visuals.size() + DRAW_PART_SIZE - 1) / DRAW_PART_SIZE;
+	if(batchDrawParts.size() < batchParts)
+		batchDrawParts.resize(batchParts);
+	workers.ForEach(batchParts, [this, projectileParts, &newCenter, &newCenterVelocity](size_t part)
+	{
+		BatchDrawList &drawList = batchDrawParts[part];
+		drawList.Clear(step, zoom);
+		drawList.SetCenter(newCenter, newCenterVelocity);
+		if(part < projectileParts)
+		{
+			size_t end = min(projectiles.size(), (part + 1) * DRAW_PART_SIZE);
+			for(size_t i = part * DRAW_PART_SIZE; i < end; ++i)
+				drawList.Add(projectiles[i], projectiles[i].Clip());
+		}
+		else
+		{
+			part -= projectileParts;
+			size_t end = min(visuals.size(), (part + 1) * DRAW_PART_SIZE);
+			for(size_t i = part * DRAW_PART_SIZE; i < end; ++i)
+				drawList.AddVisual(visuals[i]);
+		}
+	});
+	for(size_t part = 0; part < batchParts; ++part)
+		batchDraw[calcTickTock].Append(batchDrawParts[part]);
 }
 
 
@@ -1532,9 +1875,9 @@ void Engine::MoveShip(const shared_ptr<Ship> &ship)
 		// Did this ship just begin hyperspacing?
 		if(wasHere && !wasHyperspacing && ship->IsHyperspacing())
 		{
-			const map<const Sound *, int> &jumpSounds = isJump ? ship->Attributes().JumpOutSounds() : ship->Attributes().HyperOutSounds();
+			const FlatMap<const Sound *, int> &jumpSounds = isJump ? ship->Attributes().JumpOutSounds() : ship->Attributes().HyperOutSounds();
 			if(jumpSounds.empty())
-				Audio::Play(Audio::Get(isJump ? "jump out" : "hyperdrive out"), position);
+				Audio::Play(isJump ? JUMP_OUT : HYPERDRIVE_OUT, position);
 			else
 				for(const auto &sound : jumpSounds)
 					Audio::Play(sound.first, position);
@@ -1543,9 +1886,9 @@ void Engine::MoveShip(const shared_ptr<Ship> &ship)
 		// Did this ship just jump into the player's system?
 		if(!wasHere && flagship && ship->GetSystem() == flagship->GetSystem())
 		{
-			const map<const Sound *, int> &jumpSounds = isJump ? ship->Attributes().JumpInSounds() : ship->Attributes().HyperInSounds();
+			const FlatMap<const Sound *, int> &jumpSounds = isJump ? ship->Attributes().JumpInSounds() : ship->Attributes().HyperInSounds();
 			if(jumpSounds.empty())
-				Audio::Play(Audio::Get(isJump ? "jump in" : "hyperdrive in"), position);
+				Audio::Play(isJump ? JUMP_IN : HYPERDRIVE_IN, position);
 			else
 				for(const auto &sound : jumpSounds)
 					Audio::Play(sound.first, position);
@@ -1575,16 +1918,108 @@ void Engine::MoveShip(const shared_ptr<Ship> &ship)
 
 
 
-// Populate the ship collision detection set for projectile & flotsam computations.
+// Populate the ship collision detection sets for projectile & flotsam
+// computations, and make a list of the ships that are able to scan.
 void Engine::FillCollisionSets()
 {
 	shipCollisions.Clear(step);
+	collectorCollisions.Clear(step);
+	hasCollectors = false;
+	scanners.clear();
 	for(const shared_ptr<Ship> &it : ships)
-		if(it->GetSystem() == player.GetSystem() && it->Zoom() == 1.)
-			shipCollisions.Add(*it);
+	{
+		if(it->GetSystem() != player.GetSystem())
+			continue;
+		
+		const Outfit &attributes = it->Attributes();
+		if(attributes.Get("cargo scan power") || attributes.Get("outfit scan power"))
+			scanners.push_back(it);
+		
+		if(it->Zoom() != 1.)
+			continue;
+		
+		// Ships created during this step do not have a frame for it yet, and
+		// the batched projectile checks must only read the ships' masks.
+		it->SetStep(step);
+		shipCollisions.Add(*it);
+		if(!it->CannotAct() && it->Cargo().Free() > 0)
+		{
+			collectorCollisions.Add(*it);
+			hasCollectors = true;
+		}
+	}
 	
-	// Get the ship collision set ready to query.
+	// Get the ship collision sets ready to query.
 	shipCollisions.Finish();
+	collectorCollisions.Finish();
+	
+	// Index the ships that have anti-missiles ready to fire. A missile can
+	// only be shot down by a ship within the longest range of any of them.
+	antiMissileCollisions.Clear(step);
+	antiMissileOrder.clear();
+	antiMissileRange = 0.;
+	for(size_t i = 0; i < hasAntiMissile.size(); ++i)
+	{
+		Ship *ship = hasAntiMissile[i];
+		antiMissileCollisions.Add(*ship);
+		antiMissileOrder[ship] = i;
+		antiMissileRange = max(antiMissileRange, ship->AntiMissileRange());
+	}
+	antiMissileCollisions.Finish();
+}
+
+
+
+// Decide when each of the given system's fleets, hazards, and special persons
+// will first appear. In every step, each of them happens with a probability of
+// one over its period, so the number of steps until it next happens follows a
+// geometric distribution.
+void Engine::ScheduleSpawns(const System &system)
+{
+	spawnSystem = &system;
+	spawnEvents = decltype(spawnEvents)();
+	auto schedule = [this](int period, const Fleet *fleet, const Hazard *hazard)
+	{
+		period = max(1, period);
+		spawnEvents.push({step + static_cast<int>(Random::Geometric(1. / period)), period, fleet, hazard});
+	};
+	
+	// Check for undefined fleets by not trying to create anything with no
+	// government set.
+	for(const System::FleetProbability &fleet : system.Fleets())
+		if(fleet.Get()->GetGovernment())
+			schedule(fleet.Period(), fleet.Get(), nullptr);
+	for(const System::HazardProbability &hazard : system.Hazards())
+		schedule(hazard.Period(), nullptr, hazard.Get());
+	schedule(PERSON_PERIOD, nullptr, nullptr);
+}
+
+
+
+// Trigger each of the player's system's random events that is due in this step,
+// and decide when it will happen next.
+void Engine::StepSpawns()
+{
+	if(player.GetSystem() != spawnSystem)
+		ScheduleSpawns(*player.GetSystem());
+	
+	while(!spawnEvents.empty() && spawnEvents.top().step <= step)
+	{
+		SpawnEvent event = spawnEvents.top();
+		spawnEvents.pop();
+		
+		// Non-mission NPCs spawn at random intervals in neighboring systems,
+		// or coming from planets in the current one.
+		if(event.fleet)
+			pendingFleets.push_back(event.fleet);
+		else if(event.hazard)
+			GenerateWeather(event.hazard);
+		else
+			SpawnPersons();
+		
+		event.step = step + 1 + static_cast<int>(Random::Geometric(1. / event.period));
+		spawnEvents.push(event);
+	}
 }
 
 
@@ -1600,24 +2035,75 @@ void Engine::SpawnFleets()
 		player.ClearActiveBoardingMission();
 	}
 	
-	// Non-mission NPCs spawn at random intervals in neighboring systems,
-	// or coming from planets in the current one.
-	for(const System::FleetProbability &fleet : player.GetSystem()->Fleets())
-		if(!Random::Int(fleet.Period()))
+	// Placing a fleet takes a while if it is a large one, so only one fleet
+	// enters per step. If several are due at once, the rest wait their turn.
+	if(!pendingFleets.empty())
+	{
+		const Fleet *fleet = pendingFleets.front();
+		pendingFleets.pop_front();
+		
+		// Don't spawn a fleet if its allies in-system already far outnumber
+		// its enemies. This is to avoid having a system get mobbed with
+		// massive numbers of "reinforcements" during a battle.
+		const Government *gov = fleet->GetGovernment();
+		int64_t enemyStrength = ai.EnemyStrength(gov);
+		if(!enemyStrength || ai.AllyStrength(gov) <= 2 * enemyStrength)
 		{
-			const Government *gov = fleet.Get()->GetGovernment();
-			if(!gov)
-				continue;
-			
-			// Don't spawn a fleet if its allies in-system already far outnumber
-			// its enemies. This is to avoid having a system get mobbed with
-			// massive numbers of "reinforcements" during a battle.
-			int64_t enemyStrength = ai.EnemyStrength(gov);
-			if(enemyStrength && ai.AllyStrength(gov) > 2 * enemyStrength)
-				continue;
-			
-			fleet.Get()->Enter(*player.GetSystem(), newShips);
+			// Use the instance of this fleet that was created ahead of time,
+			// unless it is not ready yet.
+			vector<shared_ptr<Ship>> placed = TakePreparedFleet(fleet);
+			if(placed.empty())
+				placed = fleet->Prepare();
+			fleet->Enter(*player.GetSystem(), std::move(placed), newShips);
 		}
+	}
+	
+	PrepareFleets(*player.GetSystem());
+}
+
+
+
+// Start creating an instance of each fleet that may enter the given system
+// and that is not already prepared, on the worker threads.
+void Engine::PrepareFleets(const System &system)
+{
+	lock_guard<mutex> lock(preparedFleets->fleetMutex);
+	for(const System::FleetProbability &fleet : system.Fleets())
+	{
+		const Fleet *prepared = fleet.Get();
+		if(!prepared->GetGovernment() || preparedFleets->fleets.count(prepared))
+			continue;
+		
+		// An empty entry marks this fleet as being created. If the entry is
+		// gone by the time it is done, the player has left this system.
+		preparedFleets->fleets[prepared];
+		shared_ptr<PreparedFleets> shared = preparedFleets;
+		workers.Run([shared, prepared]()
+		{
+			vector<shared_ptr<Ship>> ships = prepared->Prepare();
+			lock_guard<mutex> lock(shared->fleetMutex);
+			auto it = shared->fleets.find(prepared);
+			if(it != shared->fleets.end())
+				it->second.swap(ships);
+		});
+	}
+}
+
+
+
+// Get the instance of the given fleet that was created ahead of time, or no
+// ships if it is not ready yet.
+vector<shared_ptr<Ship>> Engine::TakePreparedFleet(const Fleet *fleet)
+{
+	vector<shared_ptr<Ship>> placed;
+	lock_guard<mutex> lock(preparedFleets->fleetMutex);
+	auto it = preparedFleets->fleets.find(fleet);
+	if(it != preparedFleets->fleets.end() && !it->second.empty())
+	{
+		placed.swap(it->second);
+		preparedFleets->fleets.erase(it);
+	}
+	return placed;
 }
 
 
@@ -1625,7 +2111,7 @@ void Engine::SpawnFleets()
 // At random intervals, create new special "persons" who enter the current system.
 void Engine::SpawnPersons()
 {
-	if(Random::Int(36000) || player.GetSystem()->Links().empty())
+	if(player.GetSystem()->Links().empty())
 		return;
 	
 	// Loop through all persons once to see if there are any who can enter
@@ -1640,7 +2126,7 @@ void Engine::SpawnPersons()
 	// Adjustment factor: special persons will appear once every ten
 	// minutes, but much less frequently if the game only specifies a
 	// few of them. This way, they will become more common as I add
-	// more, without needing to change the 10-minute constant above.
+	// more, without needing to change PERSON_PERIOD.
 	sum = Random::Int(sum + 1000);
 	for(const auto &it : GameData::Persons())
 	{
@@ -1675,19 +2161,13 @@ void Engine::SpawnPersons()
 
 
 
-// Generate weather from the current system's hazards.
-void Engine::GenerateWeather()
+// Start weather from one of the current system's hazards.
+void Engine::GenerateWeather(const Hazard *hazard)
 {
-	// If this system has any hazards, see if any have activated this frame.
-	for(const System::HazardProbability &hazard : player.GetSystem()->Hazards())
-		if(!Random::Int(hazard.Period()))
-		{
-			const Hazard *weather = hazard.Get();
-			// If a hazard has activated, generate a duration and strength of the
-			// resulting weather and place it in the list of active weather.
-			int duration = weather->RandomDuration();
-			activeWeather.emplace_back(weather, duration, duration, weather->RandomStrength());
-		}
+	// Generate a duration and strength of the resulting weather and place it in
+	// the list of active weather.
+	int duration = hazard->RandomDuration();
+	activeWeather.emplace_back(hazard, duration, duration, hazard->RandomStrength());
 }
 
 
@@ -1698,14 +2178,7 @@ void Engine::SendHails()
 	if(Random::Int(600) || player.IsDead() || ships.empty())
 		return;
 	
-	shared_ptr<Ship> source;
-	unsigned i = Random::Int(ships.size());
-	for(const shared_ptr<Ship> &it : ships)
-		if(!i--)
-		{
-			source = it;
-			break;
-		}
+	shared_ptr<Ship> source = ships[Random::Int(ships.size())];
 	
 	if(!CanSendHail(source, player))
 		return;
@@ -1775,6 +2248,30 @@ void Engine::HandleKeyboardInputs()
 
 
 
+// In the low latency mode, if the player is steering, show the flagship already
+// turned by as much as it will turn in the step that is about to be calculated.
+// Otherwise, what is drawn is always a step behind the input. If the prediction
+// is wrong, the next step that is drawn will correct it.
+void Engine::PredictFlagshipTurn()
+{
+	// The step that is about to be drawn is the one that was just calculated.
+	int first = flagshipDrawIndex[!drawTickTock];
+	flagshipDrawIndex[!drawTickTock] = -1;
+	if(first < 0 || !LOW_LATENCY_INPUT.Has())
+		return;
+	
+	const Ship *flagship = player.Flagship();
+	int turn = activeCommands.Has(Command::RIGHT) - activeCommands.Has(Command::LEFT);
+	if(!turn || !flagship || flagship->IsDisabled() || flagship->IsHyperspacing() || flagship->Zoom() != 1.)
+		return;
+	
+	Angle angle(turn * flagship->TurnRate());
+	draw[!drawTickTock].Rotate(first, flagship->Position(), angle);
+	highlightUnit = angle.Rotate(highlightUnit);
+}
+
+
+
 // Handle any mouse clicks. This is done in the calculation thread rather than
 // in the main UI thread to avoid race conditions.
 void Engine::HandleMouseClicks()
@@ -1899,7 +2396,7 @@ void Engine::HandleMouseClicks()
 // Perform collision detection. Note that unlike the preceding functions, this
 // one adds any visuals that are created directly to the main visuals list. If
 // this is multi-threaded in the future, that will need to change.
-void Engine::DoCollisions(Projectile &projectile)
+void Engine::DoCollisions(Projectile &projectile, const CollisionSet::Hit &shipHit)
 {
 	// The asteroids can collide with projectiles, the same as any other
 	// object. If the asteroid turns out to be closer than the ship, it
@@ -1941,14 +2438,12 @@ void Engine::DoCollisions(Projectile &projectile)
 				}
 		
 		// If nothing triggered the projectile, check for collisions with ships.
-		if(closestHit > 0.)
+		if(closestHit > 0. && shipHit.body)
 		{
-			Ship *ship = reinterpret_cast<Ship *>(shipCollisions.Line(projectile, &closestHit));
-			if(ship)
-			{
-				hit = ship->shared_from_this();
-				hitVelocity = ship->Velocity();
-			}
+			Ship *ship = reinterpret_cast<Ship *>(shipHit.body);
+			closestHit = shipHit.distance;
+			hit = ship->shared_from_this();
+			hitVelocity = ship->Velocity();
 		}
 		// "Phasing" projectiles can pass through asteroids. For all other
 		// projectiles, check if they've hit an asteroid that is closer than any
@@ -1971,48 +2466,91 @@ void Engine::DoCollisions(Projectile &projectile)
 		// motion path for this step.
 		projectile.Explode(visuals, closestHit, hitVelocity);
 		
-		// If this projectile has a blast radius, find all ships within its
-		// radius. Otherwise, only one is damaged.
-		double blastRadius = projectile.GetWeapon().BlastRadius();
-		bool isSafe = projectile.GetWeapon().IsSafe();
-		if(blastRadius)
-		{
-			// Even friendly ships can be hit by the blast, unless it is a
-			// "safe" weapon.
-			Point hitPos = projectile.Position() + closestHit * projectile.Velocity();
-			for(Body *body : shipCollisions.Circle(hitPos, blastRadius))
-			{
-				Ship *ship = reinterpret_cast<Ship *>(body);
-				if(isSafe && projectile.Target() != ship && !gov->IsEnemy(ship->GetGovernment()))
-					continue;
-				
-				int eventType = ship->TakeDamage(projectile, ship != hit.get());
-				if(eventType)
-					eventQueue.emplace_back(gov, ship->shared_from_this(), eventType);
-			}
-		}
+		// If this projectile has a blast radius, all the ships within its
+		// radius are damaged once every projectile has been checked (which
+		// includes the explosions of any ships destroyed by now). Otherwise,
+		// only one is damaged.
+		if(projectile.GetWeapon().BlastRadius())
+			blasts.emplace_back(projectile, projectile.Position() + closestHit * projectile.Velocity(), hit);
 		else if(hit)
 		{
 			int eventType = hit->TakeDamage(projectile);
 			if(eventType)
 				eventQueue.emplace_back(gov, hit, eventType);
-		}
-		
-		if(hit)
 			DoGrudge(hit, gov);
+		}
 	}
-	else if(projectile.MissileStrength())
+	else if(projectile.MissileStrength() && !hasAntiMissile.empty())
 	{
 		// If the projectile did not hit anything, give the anti-missile systems
-		// a chance to shoot it down.
-		for(Ship *ship : hasAntiMissile)
+		// that are close enough a chance to shoot it down. They get that chance
+		// in the same order as if every one of them were checked.
+		antiMissileCollisions.Circle(projectile.Position(), antiMissileRange, antiMissileInRange);
+		sort(antiMissileInRange.begin(), antiMissileInRange.end(),
+			[this](const Body *a, const Body *b) { return antiMissileOrder[a] < antiMissileOrder[b]; });
+		for(Body *body : antiMissileInRange)
+		{
+			Ship *ship = static_cast<Ship *>(body);
 			if(ship == projectile.Target() || gov->IsEnemy(ship->GetGovernment()))
 				if(ship->FireAntiMissile(projectile, visuals))
 				{
 					projectile.Kill();
 					break;
 				}
+		}
+	}
+}
+
+
+
+// Apply the damage from all the blasts in this step. Finding the ships caught in
+// each blast and how much damage each one takes does not change anything, so
+// that can be done for all the blasts at once.
+void Engine::DoBlasts()
+{
+	if(blasts.empty())
+		return;
+	
+	workers.ForEach(blasts.size(), [this](size_t i)
+	{
+		Blast &blast = blasts[i];
+		const Projectile &projectile = *blast.projectile;
+		const Weapon &weapon = projectile.GetWeapon();
+		shipCollisions.Circle(blast.position, weapon.BlastRadius(), blast.ships);
+		
+		// Even friendly ships can be hit by the blast, unless it is a "safe"
+		// weapon. The ship that was hit directly takes the full damage.
+		const Government *gov = projectile.GetGovernment();
+		bool isSafe = weapon.IsSafe();
+		auto end = remove_if(blast.ships.begin(), blast.ships.end(), [&projectile, gov, isSafe](Body *body)
+		{
+			return isSafe && projectile.Target() != body && !gov->IsEnemy(body->GetGovernment());
+		});
+		blast.ships.erase(end, blast.ships.end());
+		for(Body *body : blast.ships)
+		{
+			const Ship *ship = reinterpret_cast<Ship *>(body);
+			blast.damageScaling.push_back(ship == blast.hit.get() ? 1.
+				: ship->BlastDamageScaling(weapon, projectile.Position()));
+		}
+	});
+	
+	for(Blast &blast : blasts)
+	{
+		const Projectile &projectile = *blast.projectile;
+		const Government *gov = projectile.GetGovernment();
+		for(size_t i = 0; i < blast.ships.size(); ++i)
+		{
+			Ship *ship = reinterpret_cast<Ship *>(blast.ships[i]);
+			int eventType = (ship == blast.hit.get()) ? ship->TakeDamage(projectile)
+				: ship->TakeBlastDamage(projectile, blast.damageScaling[i]);
+			if(eventType)
+				eventQueue.emplace_back(gov, ship->shared_from_this(), eventType);
+		}
+		if(blast.hit)
+			DoGrudge(blast.hit, gov);
 	}
+	blasts.clear();
 }
 
 
@@ -2043,7 +2581,7 @@ void Engine::DoCollection(Flotsam &flotsam)
 {
 	// Check if any ship can pick up this flotsam. Cloaked ships cannot act.
 	Ship *collector = nullptr;
-	for(Body *body : shipCollisions.Circle(flotsam.Position(), 5.))
+	for(Body *body : collectorCollisions.Circle(flotsam.Position(), 5.))
 	{
 		Ship *ship = reinterpret_cast<Ship *>(body);
 		if(!ship->CannotAct() && ship != flotsam.Source() && ship->Cargo().Free() >= flotsam.UnitSize())
@@ -2119,24 +2657,25 @@ void Engine::DoScanning(const shared_ptr<Ship> &ship)
 
 
 // Fill in all the objects in the radar display.
-void Engine::FillRadar()
+void Engine::FillRadar(bool isDrawn)
 {
 	const Ship *flagship = player.Flagship();
 	const System *playerSystem = player.GetSystem();
 	
 	// Add stellar objects.
-	for(const StellarObject &object : playerSystem->Objects())
-		if(object.HasSprite())
-		{
-			double r = max(2., object.Radius() * .03 + .5);
-			radar[calcTickTock].Add(object.RadarType(flagship), object.Position(), r, r - 1.);
-		}
+	if(isDrawn)
+		for(const StellarObject &object : playerSystem->Objects())
+			if(object.HasSprite())
+			{
+				double r = max(2., object.Radius() * .03 + .5);
+				radar[calcTickTock].Add(object.RadarType(flagship), object.Position(), r, r - 1.);
+			}
 	
 	// Add pointers for neighboring systems.
-	if(flagship)
+	if(flagship && isDrawn)
 	{
 		const System *targetSystem = flagship->GetTargetSystem();
-		const set<const System *> &links = (flagship->Attributes().Get("jump drive")) ?
+		const FlatSet<const System *> &links = (flagship->Attributes().Get("jump drive")) ?
 			playerSystem->JumpNeighbors(flagship->JumpRange()) : playerSystem->Links();
 		for(const System *system : links)
 			if(player.HasSeen(*system))
@@ -2146,7 +2685,7 @@ void Engine::FillRadar()
 	}
 	
 	// Add viewport brackets.
-	if(!Preferences::Has("Disable viewport on radar"))
+	if(isDrawn && !DISABLE_RADAR_VIEWPORT.Has())
 	{
 		radar[calcTickTock].AddViewportBoundary(Screen::TopLeft() / zoom);
 		radar[calcTickTock].AddViewportBoundary(Screen::TopRight() / zoom);
@@ -2164,13 +2703,16 @@ void Engine::FillRadar()
 			if(ship->Cloaking() >= 1. && !isYours)
 				continue;
 			
-			// Figure out what radar color should be used for this ship.
-			bool isYourTarget = (flagship && ship == flagship->GetTargetShip());
-			int type = isYourTarget ? Radar::SPECIAL : RadarType(*ship, step);
-			// Calculate how big the radar dot should be.
-			double size = sqrt(ship->Width() + ship->Height()) * .14 + .5;
-			
-			radar[calcTickTock].Add(type, ship->Position(), size);
+			if(isDrawn)
+			{
+				// Figure out what radar color should be used for this ship.
+				bool isYourTarget = (flagship && ship == flagship->GetTargetShip());
+				int type = isYourTarget ? Radar::SPECIAL : RadarType(*ship, step);
+				// Calculate how big the radar dot should be.
+				double size = sqrt(ship->Width() + ship->Height()) * .14 + .5;
+				
+				radar[calcTickTock].Add(type, ship->Position(), size);
+			}
 			
 			// Check if this is a hostile ship.
 			hasHostiles |= (!ship->IsDisabled() && ship->GetGovernment()->IsEnemy()
@@ -2181,14 +2723,17 @@ void Engine::FillRadar()
 		--alarmTime;
 	else if(hasHostiles && !hadHostiles)
 	{
-		if(Preferences::Has("Warning siren"))
-			Audio::Play(Audio::Get("alarm"));
+		if(WARNING_SIREN.Has())
+			Audio::Play(ALARM);
 		alarmTime = 180;
 		hadHostiles = true;
 	}
 	else if(!hasHostiles)
 		hadHostiles = false;
 	
+	if(!isDrawn)
+		return;
+	
 	// Add projectiles that have a missile strength or homing.
 	for(Projectile &projectile : projectiles)
 	{
@@ -2207,19 +2752,18 @@ void Engine::FillRadar()
 
 // Each ship is drawn as an entire stack of sprites, including hardpoint sprites
 // and engine flares and any fighters it is carrying externally.
-void Engine::AddSprites(const Ship &ship)
+void Engine::AddSprites(const Ship &ship, DrawList &drawList)
 {
 	bool hasFighters = ship.PositionFighters();
 	double cloak = ship.Cloaking();
 	bool drawCloaked = (cloak && ship.IsYours());
-	auto &itemsToDraw = draw[calcTickTock];
-	auto drawObject = [&itemsToDraw, cloak, drawCloaked](const Body &body) -> void
+	auto drawObject = [&drawList, cloak, drawCloaked](const Body &body) -> void
 	{
 		// Draw cloaked/cloaking sprites swizzled red, and overlay this solid
 		// sprite with an increasingly transparent "regular" sprite.
 		if(drawCloaked)
-			itemsToDraw.AddSwizzled(body, 7);
-		itemsToDraw.Add(body, cloak);
+			drawList.AddSwizzled(body, 7);
+		drawList.Add(body, cloak);
 	};
 	
 	if(hasFighters)
@@ -2228,11 +2772,11 @@ void Engine::AddSprites(const Ship &ship)
 				drawObject(*bay.ship);
 	
 	if(ship.IsThrusting() && !ship.EnginePoints().empty())
-		DrawFlareSprites(ship, draw[calcTickTock], ship.EnginePoints(), ship.Attributes().FlareSprites(), Ship::EnginePoint::UNDER);
+		DrawFlareSprites(ship, drawList, ship.EnginePoints(), ship.Attributes().FlareSprites(), Ship::EnginePoint::UNDER);
 	else if(ship.IsReversing() && !ship.ReverseEnginePoints().empty())
-		DrawFlareSprites(ship, draw[calcTickTock], ship.ReverseEnginePoints(), ship.Attributes().ReverseFlareSprites(), Ship::EnginePoint::UNDER);
+		DrawFlareSprites(ship, drawList, ship.ReverseEnginePoints(), ship.Attributes().ReverseFlareSprites(), Ship::EnginePoint::UNDER);
 	if(ship.IsSteering() && !ship.SteeringEnginePoints().empty())
-		DrawFlareSprites(ship, draw[calcTickTock], ship.SteeringEnginePoints(), ship.Attributes().SteeringFlareSprites(), Ship::EnginePoint::UNDER);
+		DrawFlareSprites(ship, drawList, ship.SteeringEnginePoints(), ship.Attributes().SteeringFlareSprites(), Ship::EnginePoint::UNDER);
 	
 	drawObject(ship);
 	for(const Hardpoint &hardpoint : ship.Weapons())
@@ -2248,11 +2792,11 @@ void Engine::AddSprites(const Ship &ship)
 		}
 	
 	if(ship.IsThrusting() && !ship.EnginePoints().empty())
-		DrawFlareSprites(ship, draw[calcTickTock], ship.EnginePoints(), ship.Attributes().FlareSprites(), Ship::EnginePoint::OVER);
+		DrawFlareSprites(ship, drawList, ship.EnginePoints(), ship.Attributes().FlareSprites(), Ship::EnginePoint::OVER);
 	else if(ship.IsReversing() && !ship.ReverseEnginePoints().empty())
-		DrawFlareSprites(ship, draw[calcTickTock], ship.ReverseEnginePoints(), ship.Attributes().ReverseFlareSprites(), Ship::EnginePoint::OVER);
+		DrawFlareSprites(ship, drawList, ship.ReverseEnginePoints(), ship.Attributes().ReverseFlareSprites(), Ship::EnginePoint::OVER);
 	if(ship.IsSteering() && !ship.SteeringEnginePoints().empty())
-		DrawFlareSprites(ship, draw[calcTickTock], ship.SteeringEnginePoints(), ship.Attributes().SteeringFlareSprites(), Ship::EnginePoint::OVER);
+		DrawFlareSprites(ship, drawList, ship.SteeringEnginePoints(), ship.Attributes().SteeringFlareSprites(), Ship::EnginePoint::OVER);
 	
 	if(hasFighters)
 		for(const Ship::Bay &bay : ship.Bays())
@@ -2345,8 +2889,29 @@ void Engine::DoGrudge(const shared_ptr<Ship> &target, const Government *attacker
 
 
 
+// Get how far the current frame is from the step being drawn toward the next
+// one, if frames are being interpolated.
+double Engine::DrawFraction() const
+{
+	if(!INTERPOLATE_FRAMES.Has())
+		return 0.;
+	
+	double elapsed = (chrono::steady_clock::now() - stepTime).count();
+	return max(0., min(1., elapsed / STEP_TIME.count()));
+}
+
+
+
 // Constructor for the ship status display rings.
-Engine::Status::Status(const Point &position, double outer, double inner, double disabled, double radius, int type, double angle)
-	: position(position), outer(outer), inner(inner), disabled(disabled), radius(radius), type(type), angle(angle)
+Engine::Status::Status(const Point &position, const Point &velocity, double outer, double inner, double disabled, double radius, int type, double angle)
+	: position(position), velocity(velocity), outer(outer), inner(inner), disabled(disabled), radius(radius), type(type), angle(angle)
+{
+}
+
+
+
+// Constructor for a blast that has yet to be resolved.
+Engine::Blast::Blast(const Projectile &projectile, const Point &position, const shared_ptr<Ship> &hit)
+	: projectile(&projectile), position(position), hit(hit)
 {
 }
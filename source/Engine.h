@@ -24,17 +24,25 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 #include "Radar.h"
 #include "Rectangle.h"
+#include "ThreadPool.h"
 
+#include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <queue>
+#include <string>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+class Fleet;
 class Flotsam;
 class Government;
+class Hazard;
 class NPC;
 class Outfit;
 class PlanetLabel;
@@ -43,6 +51,7 @@ class Projectile;
 class Ship;
 class ShipEvent;
 class Sprite;
+class System;
 class Visual;
 class Weather;
 
@@ -64,18 +73,28 @@ public:
 	void Place();
 	// Place NPCs spawned by a mission that offers when the player is not landed.
 	void Place(const std::list<NPC> &npcs, std::shared_ptr<Ship> flagship = nullptr);
+	// Add the given ships, which must already be placed in the player's system,
+	// and the given number of asteroids (for stress tests). This can only be
+	// done while no step is being calculated.
+	void Add(const std::list<std::shared_ptr<Ship>> &added);
+	void AddAsteroids(const std::string &name, int count, double energy = 1.);
 	
 	// Wait for the previous calculations (if any) to be done.
 	void Wait();
+	// Check whether the previous calculations are done, without waiting.
+	bool IsReady();
 	// Perform all the work that can only be done while the calculation thread
 	// is paused (for thread safety reasons).
 	void Step(bool isActive);
 	// Begin the next step of calculations.
 	void Go();
+	// Set whether the steps that begin from now on will be drawn. If not,
+	// they skip building the draw lists and radar.
+	void SetNextStepDrawn(bool isDrawn);
 	
 	// Get any special events that happened in this step.
 	// MainPanel::Step will clear this list.
-	std::list<ShipEvent> &Events();
+	std::vector<ShipEvent> &Events();
 	
 	// Draw a frame.
 	void Draw() const;
@@ -97,31 +116,55 @@ private:
 	
 	void MoveShip(const std::shared_ptr<Ship> &ship);
 	
+	// Decide when each of the system's random events will first happen, and
+	// trigger any that are due in this step.
+	void ScheduleSpawns(const System &system);
+	void StepSpawns();
 	void SpawnFleets();
 	void SpawnPersons();
-	void GenerateWeather();
+	// Start creating any fleets that may enter the given system, so that
+	// they are ready by the time they are needed.
+	void PrepareFleets(const System &system);
+	// Get the instance of the given fleet that was created ahead of time, or
+	// no ships if it is not ready yet.
+	std::vector<std::shared_ptr<Ship>> TakePreparedFleet(const Fleet *fleet);
+	void GenerateWeather(const Hazard *hazard);
 	void SendHails();
 	void HandleKeyboardInputs();
 	void HandleMouseClicks();
+	// Turn the flagship in the step that is about to be drawn to match the
+	// latest input, instead of waiting a step for that turn to be calculated.
+	void PredictFlagshipTurn();
 	
 	void FillCollisionSets();
 	
-	void DoCollisions(Projectile &projectile);
+	void DoCollisions(Projectile &projectile, const CollisionSet::Hit &shipHit);
+	void DoBlasts();
 	void DoWeather(Weather &weather);
 	void DoCollection(Flotsam &flotsam);
 	void DoScanning(const std::shared_ptr<Ship> &ship);
 	
-	void FillRadar();
+	// Populate the radar, and sound the siren if hostile ships have appeared.
+	// If this step will not be drawn, only check for hostile ships.
+	void FillRadar(bool isDrawn);
+	// Build the lists of everything that will be drawn for this step.
+	void FillDrawLists(const System *playerSystem, const Ship *flagship,
+		const Point &newCenter, const Point &newCenterVelocity);
 	
-	void AddSprites(const Ship &ship);
+	void AddSprites(const Ship &ship, DrawList &drawList);
 	
 	void DoGrudge(const std::shared_ptr<Ship> &target, const Government *attacker);
 	
+	// Get how far the current frame is from the step being drawn toward the
+	// next one, if frames are being interpolated.
+	double DrawFraction() const;
+	
 	
 private:
 	class Target {
 	public:
 		Point center;
+		Point velocity;
 		Angle angle;
 		double radius;
 		int type;
@@ -130,9 +173,10 @@ private:
 	
 	class Status {
 	public:
-		Status(const Point &position, double outer, double inner, double disabled, double radius, int type, double angle = 0.);
+		Status(const Point &position, const Point &velocity, double outer, double inner, double disabled, double radius, int type, double angle = 0.);
 		
 		Point position;
+		Point velocity;
 		double outer;
 		double inner;
 		double disabled;
@@ -141,11 +185,36 @@ private:
 		double angle;
 	};
 	
+	// A projectile with a blast radius that exploded in this step, the ship
+	// that it hit directly (if any), and the other ships caught in its blast.
+	class Blast {
+	public:
+		Blast(const Projectile &projectile, const Point &position, const std::shared_ptr<Ship> &hit);
+		
+		const Projectile *projectile;
+		Point position;
+		std::shared_ptr<Ship> hit;
+		std::vector<Body *> ships;
+		std::vector<double> damageScaling;
+	};
+	
+	// The next time that one of the system's fleets will be sent in, one of
+	// its hazards will start, or (if neither) a special person will appear.
+	class SpawnEvent {
+	public:
+		bool operator>(const SpawnEvent &other) const { return step > other.step; }
+		
+		int step;
+		int period;
+		const Fleet *fleet;
+		const Hazard *hazard;
+	};
+	
 	
 private:
 	PlayerInfo &player;
 	
-	std::list<std::shared_ptr<Ship>> ships;
+	std::vector<std::shared_ptr<Ship>> ships;
 	std::vector<Projectile> projectiles;
 	std::vector<Weather> activeWeather;
 	std::list<std::shared_ptr<Flotsam>> flotsam;
@@ -158,8 +227,33 @@ private:
 	std::list<std::shared_ptr<Flotsam>> newFlotsam;
 	std::vector<Visual> newVisuals;
 	
-	// Track which ships currently have anti-missiles ready to fire.
+	// Fleets that the worker threads have created ahead of time. Any tasks
+	// that are still creating them share this with the engine.
+	class PreparedFleets;
+	std::shared_ptr<PreparedFleets> preparedFleets;
+	// Fleets that are due to enter the system, but are waiting their turn.
+	std::list<const Fleet *> pendingFleets;
+	// Rather than rolling the dice for every fleet and hazard in every step,
+	// the step when each will next happen is drawn ahead of time, and only the
+	// soonest one needs to be checked.
+	const System *spawnSystem = nullptr;
+	std::priority_queue<SpawnEvent, std::vector<SpawnEvent>, std::greater<SpawnEvent>> spawnEvents;
+	
+	// Track which ships currently have anti-missiles ready to fire. They are
+	// also indexed by position, so each missile only needs to check the ones
+	// that are near it, in the same order as they appear in the list.
 	std::vector<Ship *> hasAntiMissile;
+	CollisionSet antiMissileCollisions;
+	std::unordered_map<const Body *, size_t> antiMissileOrder;
+	double antiMissileRange = 0.;
+	std::vector<Body *> antiMissileInRange;
+	// Blasts are resolved together once all projectiles have been checked.
+	std::vector<Blast> blasts;
+	
+	// Worker threads that help the calculation thread with any work that can
+	// be divided up into independent jobs. These are shared with the rest of
+	// the game.
+	ThreadPool &workers;
 	
 	AI ai;
 	
@@ -169,14 +263,28 @@ private:
 	
 	bool calcTickTock = false;
 	bool drawTickTock = false;
+	// Whether the next step to begin, and the one being calculated, will be
+	// drawn. The second is only changed while the calculation thread is paused.
+	bool isNextStepDrawn = true;
+	bool isCalcStepDrawn = true;
 	bool terminate = false;
 	bool wasActive = false;
 	DrawList draw[2];
 	BatchDrawList batchDraw[2];
+	// Where the flagship's sprites start in each draw list, or -1 if it has
+	// none there or they have already been turned to match the input.
+	int flagshipDrawIndex[2] = {-1, -1};
+	// Parts of the draw lists, which are built on the worker threads and then
+	// combined in order. They are kept so their memory can be reused.
+	std::vector<DrawList> drawParts;
+	std::vector<BatchDrawList> batchDrawParts;
 	Radar radar[2];
 	// Viewport position and velocity.
 	Point center;
 	Point centerVelocity;
+	// When the state that is now being drawn is considered to have begun, for
+	// interpolating the frames that are drawn in between steps.
+	std::chrono::steady_clock::time_point stepTime;
 	// Other information to display.
 	Information info;
 	std::vector<Target> targets;
@@ -195,13 +303,23 @@ private:
 	
 	int step = 0;
 	
-	std::list<ShipEvent> eventQueue;
-	std::list<ShipEvent> events;
+	// The events are double buffered: the calculation thread adds to the
+	// queue while the main thread handles the previous step's events. The two
+	// buffers are swapped each step, so their memory is reused.
+	std::vector<ShipEvent> eventQueue;
+	std::vector<ShipEvent> events;
 	// Keep track of who has asked for help in fighting whom.
 	std::map<const Government *, std::weak_ptr<const Ship>> grudge;
 	int grudgeTime = 0;
 	
 	CollisionSet shipCollisions;
+	// Ships that are able to pick up flotsam, and ships that have scanners.
+	// Flotsam only needs to be checked against the former, and only the latter
+	// need to be checked for scanning.
+	CollisionSet collectorCollisions;
+	bool hasCollectors = false;
+	std::vector<std::shared_ptr<Ship>> scanners;
+	std::vector<CollisionSet::Hit> projectileHits;
 	
 	int alarmTime = 0;
 	double flash = 0.;
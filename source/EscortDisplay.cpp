@@ -18,6 +18,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "GameData.h"
 #include "Government.h"
 #include "LineShader.h"
+#include "Named.h"
 #include "OutlineShader.h"
 #include "Point.h"
 #include "Rectangle.h"
@@ -27,6 +28,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <algorithm>
 #include <set>
+#include <unordered_map>
 
 using namespace std;
 
@@ -38,20 +40,27 @@ namespace {
 	const double BAR_PAD = 5.;
 	const double WIDTH = 120.;
 	const double BAR_WIDTH = WIDTH - ICON_SIZE - 2. * PAD - 2. * BAR_PAD;
+	
+	const Named<Color> ELSEWHERE_COLOR("escort elsewhere");
+	const Named<Color> CANNOT_JUMP_COLOR("escort blocked");
+	const Named<Color> NOT_READY_COLOR("escort not ready");
+	const Named<Color> SELECTED_COLOR("escort selected");
+	const Named<Color> HERE_COLOR("escort present");
+	const Named<Color> HOSTILE_COLOR("escort hostile");
 }
 
 
 
 void EscortDisplay::Clear()
 {
-	icons.clear();
+	added.clear();
 }
 
 
 
 void EscortDisplay::Add(const Ship &ship, bool isHere, bool fleetIsJumping, bool isSelected)
 {
-	icons.emplace_back(ship, isHere, fleetIsJumping, isSelected);
+	added.emplace_back(ship, isHere, fleetIsJumping, isSelected);
 }
 
 
@@ -61,8 +70,22 @@ void EscortDisplay::Draw(const Rectangle &bounds) const
 {
 	// Figure out how much space there is for the icons.
 	int maxColumns = max(1., bounds.Width() / WIDTH);
-	MergeStacks(maxColumns * bounds.Height());
-	icons.sort();
+	int maxHeight = maxColumns * bounds.Height();
+	// Only work out the stacks again if the escorts have changed in a way that
+	// might affect them. Their status can still change every step.
+	bool isSame = (maxHeight == layoutHeight && added.size() == layout.size());
+	for(size_t i = 0; isSame && i < added.size(); ++i)
+		isSame = added[i].HasSameLayout(layout[i]);
+	if(!isSame)
+		Regroup(maxHeight);
+	
+	icons.clear();
+	for(const vector<size_t> &group : groups)
+	{
+		icons.push_back(added[group.front()]);
+		for(size_t i = 1; i < group.size(); ++i)
+			icons.back().Merge(added[group[i]]);
+	}
 	stacks.clear();
 	zones.clear();
 	static const Set<Color> &colors = GameData::Colors();
@@ -71,12 +94,15 @@ void EscortDisplay::Draw(const Rectangle &bounds) const
 	const Font &font = FontSet::Get(14);
 	// Top left corner of the current escort icon.
 	Point corner = Point(bounds.Left(), bounds.Bottom());
-	const Color &elsewhereColor = *colors.Get("escort elsewhere");
-	const Color &cannotJumpColor = *colors.Get("escort blocked");
-	const Color &notReadyToJumpColor = *colors.Get("escort not ready");
-	const Color &selectedColor = *colors.Get("escort selected");
-	const Color &hereColor = *colors.Get("escort present");
-	const Color &hostileColor = *colors.Get("escort hostile");
+	const Color &elsewhereColor = *ELSEWHERE_COLOR;
+	const Color &cannotJumpColor = *CANNOT_JUMP_COLOR;
+	const Color &notReadyToJumpColor = *NOT_READY_COLOR;
+	const Color &selectedColor = *SELECTED_COLOR;
+	const Color &hereColor = *HERE_COLOR;
+	const Color &hostileColor = *HOSTILE_COLOR;
+	// The icons, labels, and status bars are each drawn in a pass of their own,
+	// so that all the bars can be drawn in a single batch.
+	vector<const Icon *> shown;
 	for(const Icon &escort : icons)
 	{
 		if(!escort.sprite)
@@ -93,10 +119,6 @@ void EscortDisplay::Draw(const Rectangle &bounds) const
 		}
 		Point pos = corner + Point(PAD + .5 * ICON_SIZE, .5 * ICON_SIZE);
 		
-		// Draw the system name for any escort not in the current system.
-		if(!escort.system.empty())
-			font.Draw(escort.system, pos + Point(-10., 10.), elsewhereColor);
-
 		Color color;
 		if(escort.isHostile)
 			color = hostileColor;
@@ -114,21 +136,38 @@ void EscortDisplay::Draw(const Rectangle &bounds) const
 		// Figure out what scale should be applied to the ship sprite.
 		float scale = min(ICON_SIZE / escort.sprite->Width(), ICON_SIZE / escort.sprite->Height());
 		Point size(escort.sprite->Width() * scale, escort.sprite->Height() * scale);
-		OutlineShader::Draw(escort.sprite, pos, size, color);
+		OutlineShader::DrawCached(escort.sprite, pos, size, color);
 		zones.push_back(pos);
 		stacks.push_back(escort.ships);
+		shown.push_back(&escort);
+	}
+	
+	for(size_t s = 0; s < shown.size(); ++s)
+	{
+		const Icon &escort = *shown[s];
+		const Point &pos = zones[s];
+		// Draw the system name for any escort not in the current system.
+		if(!escort.system.empty())
+			font.Draw(escort.system, pos + Point(-10., 10.), elsewhereColor);
+		
 		// Draw the number of ships in this stack.
-		double width = BAR_WIDTH;
 		if(escort.ships.size() > 1)
 		{
 			string number = to_string(escort.ships.size());
-		
+			
 			Point numberPos = pos;
-			numberPos.X() += 15. + width - font.Width(number);
+			numberPos.X() += 15. + BAR_WIDTH - font.Width(number);
 			numberPos.Y() -= .5 * font.Height();
 			font.Draw(number, numberPos, elsewhereColor);
-			width -= 20.;
 		}
+	}
+	
+	for(size_t s = 0; s < shown.size(); ++s)
+	{
+		const Icon &escort = *shown[s];
+		const Point &pos = zones[s];
+		// Leave room for the number of ships in this stack.
+		double width = BAR_WIDTH - 20. * (escort.ships.size() > 1);
 		
 		// Draw the status bars.
 		static const Color fullColor[5] = {
@@ -236,7 +275,40 @@ void EscortDisplay::Icon::Merge(const Icon &other)
 
 
 
-void EscortDisplay::MergeStacks(int maxHeight) const
+bool EscortDisplay::Icon::HasSameLayout(const Icon &other) const
+{
+	return ships == other.ships && sprite == other.sprite && cost == other.cost
+		&& isHostile == other.isHostile && system == other.system;
+}
+
+
+
+// Work out which of the added escorts are stacked together, and in what order
+// the stacks are drawn.
+void EscortDisplay::Regroup(int maxHeight) const
+{
+	list<Icon> merged(added.begin(), added.end());
+	MergeStacks(merged, maxHeight);
+	merged.sort();
+	
+	unordered_map<const Ship *, size_t> index;
+	for(size_t i = 0; i < added.size(); ++i)
+		index[added[i].ships.front()] = i;
+	
+	groups.clear();
+	for(const Icon &icon : merged)
+	{
+		groups.emplace_back();
+		for(const Ship *ship : icon.ships)
+			groups.back().push_back(index[ship]);
+	}
+	layout = added;
+	layoutHeight = maxHeight;
+}
+
+
+
+void EscortDisplay::MergeStacks(list<Icon> &icons, int maxHeight)
 {
 	if(icons.empty())
 		return;
@@ -27,7 +27,9 @@ class Sprite;
 
 
 // This class stores a list of escorts, sorted according to their value and
-// stacked if necessary to get them to all fit on screen.
+// stacked if necessary to get them to all fit on screen. The escorts are added
+// again every step, but which of them are stacked together only changes when
+// the fleet does, so the stacks are only worked out again when it does.
 class EscortDisplay {
 public:
 	void Clear();
@@ -51,6 +53,9 @@ private:
 		
 		int Height() const;
 		void Merge(const Icon &other);
+		// Check if this icon would be stacked and sorted the same way as the
+		// given one. Both must be for a single ship.
+		bool HasSameLayout(const Icon &other) const;
 		
 		const Sprite *sprite;
 		bool isHere;
@@ -67,11 +72,23 @@ private:
 	
 	
 private:
-	void MergeStacks(int maxHeight) const;
+	// Work out which of the added escorts are stacked together, and in what
+	// order the stacks are drawn.
+	void Regroup(int maxHeight) const;
+	static void MergeStacks(std::list<Icon> &icons, int maxHeight);
 	
 	
 private:
-	mutable std::list<Icon> icons;
+	// One icon for each escort that has been added.
+	std::vector<Icon> added;
+	// The escorts that the stacks were last worked out for, and the height
+	// that they had to fit in.
+	mutable std::vector<Icon> layout;
+	mutable int layoutHeight = 0;
+	// Each stack, as the indices of the escorts in it.
+	mutable std::vector<std::vector<size_t>> groups;
+	
+	mutable std::vector<Icon> icons;
 	mutable std::vector<std::vector<const Ship *>> stacks;
 	mutable std::vector<Point> zones;
 };
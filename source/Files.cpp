@@ -12,7 +12,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Files.h"
 
+#include "Archive.h"
 #include "File.h"
+#include "ThreadPool.h"
 
 #include <SDL2/SDL.h>
 
@@ -22,13 +24,18 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <sys/stat.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 
 using namespace std;
 
@@ -44,6 +51,23 @@ namespace {
 	
 	mutex errorMutex;
 	File errorLog;
+	// Errors that are being held back for threads that asked for that.
+	map<thread::id, vector<string>> errorBuffers;
+	
+	// Archives that have been mounted, and the directories that the files in
+	// them appear to be in.
+	vector<pair<string, unique_ptr<Archive>>> archives;
+	
+	// The thread that is writing a file in the background. If the game exits
+	// while a file is being written, wait for it to be finished.
+	class BackgroundWrite {
+	public:
+		~BackgroundWrite() { Wait(); }
+		void Wait() { if(thread.joinable()) thread.join(); }
+		
+		std::thread thread;
+	};
+	BackgroundWrite backgroundWrite;
 	
 	// Convert windows-style directory separators ('\\') to standard '/'.
 #if defined _WIN32
@@ -80,6 +104,234 @@ namespace {
 		return result;
 	}
 #endif
+	
+	// Add every regular file in the given directory (whose path ends in a
+	// slash), and in the directories it contains, to the given list. If asked
+	// to, also look up each file's timestamp and size. Subdirectories are
+	// searched in parallel, and their files are added after this directory's.
+#if defined _WIN32
+	void ListEntries(const string &directory, bool withMetadata, vector<Files::Entry> &entries)
+	{
+		WIN32_FIND_DATAW ffd;
+		HANDLE hFind = FindFirstFileW(ToUTF16(directory + '*').c_str(), &ffd);
+		if(hFind == INVALID_HANDLE_VALUE)
+			return;
+		
+		vector<string> subdirectories;
+		do {
+			if(!ffd.cFileName || ffd.cFileName[0] == '.')
+				continue;
+			
+			if(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				subdirectories.push_back(directory + ToUTF8(ffd.cFileName) + '/');
+			else
+			{
+				entries.emplace_back();
+				Files::Entry &entry = entries.back();
+				entry.path = directory + ToUTF8(ffd.cFileName);
+				if(withMetadata)
+				{
+					// File times count 100 ns intervals since the year 1601.
+					uint64_t fileTime = (static_cast<uint64_t>(ffd.ftLastWriteTime.dwHighDateTime) << 32)
+						| ffd.ftLastWriteTime.dwLowDateTime;
+					entry.timestamp = static_cast<time_t>(fileTime / 10000000 - 11644473600ULL);
+					entry.size = (static_cast<uint64_t>(ffd.nFileSizeHigh) << 32) | ffd.nFileSizeLow;
+				}
+			}
+		} while(FindNextFileW(hFind, &ffd));
+		
+		FindClose(hFind);
+		
+		vector<vector<Files::Entry>> results(subdirectories.size());
+		ThreadPool::Shared().ForEach(subdirectories.size(), [&](size_t i)
+		{
+			ListEntries(subdirectories[i], withMetadata, results[i]);
+		});
+		for(vector<Files::Entry> &result : results)
+			move(result.begin(), result.end(), back_inserter(entries));
+	}
+#else
+	// The directory is given as an open file descriptor, so that the files in
+	// it can be looked up without resolving the whole path again each time.
+	// The descriptor is closed once it is no longer needed.
+	void ListEntries(int fd, const string &directory, bool withMetadata, vector<Files::Entry> &entries)
+	{
+		DIR *dir = fdopendir(fd);
+		if(!dir)
+		{
+			close(fd);
+			return;
+		}
+		
+		vector<string> subdirectories;
+		while(true)
+		{
+			dirent *ent = readdir(dir);
+			if(!ent)
+				break;
+			// Skip dotfiles (including "." and "..").
+			if(ent->d_name[0] == '.')
+				continue;
+			
+			struct stat buf;
+			bool hasStat = false;
+			bool isRegularFile = false;
+			bool isDirectory = false;
+			// Most file systems report each entry's type, which saves having to
+			// look it up. Symbolic links have to be followed to see what they
+			// point to, though.
+#if defined DT_UNKNOWN
+			isRegularFile = (ent->d_type == DT_REG);
+			isDirectory = (ent->d_type == DT_DIR);
+			if(ent->d_type == DT_UNKNOWN || ent->d_type == DT_LNK)
+#endif
+			{
+				hasStat = !fstatat(dirfd(dir), ent->d_name, &buf, 0);
+				isRegularFile = hasStat && S_ISREG(buf.st_mode);
+				isDirectory = hasStat && S_ISDIR(buf.st_mode);
+			}
+			
+			if(isDirectory)
+				subdirectories.emplace_back(ent->d_name);
+			else if(isRegularFile)
+			{
+				entries.emplace_back();
+				Files::Entry &entry = entries.back();
+				entry.path = directory + ent->d_name;
+				if(withMetadata && (hasStat || !fstatat(dirfd(dir), ent->d_name, &buf, 0)))
+				{
+					entry.timestamp = buf.st_mtime;
+					entry.size = buf.st_size;
+				}
+			}
+		}
+		
+		vector<vector<Files::Entry>> results(subdirectories.size());
+		ThreadPool::Shared().ForEach(subdirectories.size(), [&](size_t i)
+		{
+			int subFd = openat(dirfd(dir), subdirectories[i].c_str(), O_RDONLY | O_DIRECTORY);
+			if(subFd >= 0)
+				ListEntries(subFd, directory + subdirectories[i] + '/', withMetadata, results[i]);
+		});
+		closedir(dir);
+		
+		for(vector<Files::Entry> &result : results)
+			move(result.begin(), result.end(), back_inserter(entries));
+	}
+#endif
+	
+	
+	
+	// Find the given file in one of the mounted archives. If it is there, point
+	// the given data at its contents and return the archive.
+	const Archive *FindArchive(const string &path, const char *&data, size_t &size)
+	{
+		for(const auto &it : archives)
+			if(!path.compare(0, it.first.size(), it.first) && it.second->Find(path.substr(it.first.size()), data, size))
+				return it.second.get();
+		return nullptr;
+	}
+	
+	
+	
+	// Get all the files in the mounted archives that are in the given directory
+	// (which must end in a slash) or any directory that it contains.
+	vector<Files::Entry> ListArchived(const string &directory)
+	{
+		vector<Files::Entry> entries;
+		for(const auto &it : archives)
+		{
+			if(directory.compare(0, it.first.size(), it.first))
+				continue;
+			
+			auto range = it.second->List(directory.substr(it.first.size()));
+			for(auto entry = range.first; entry != range.second; ++entry)
+			{
+				entries.emplace_back();
+				entries.back().path = it.first + entry->path;
+				entries.back().timestamp = it.second->Timestamp();
+				entries.back().size = entry->size;
+			}
+		}
+		return entries;
+	}
+	
+	
+	
+	// Add the files or directories that the mounted archives have directly in
+	// the given directory (which must end in a slash) to the given list.
+	vector<string> AddArchived(const string &directory, bool isDirectories, vector<string> list)
+	{
+		bool hasArchived = false;
+		for(Files::Entry &entry : ListArchived(directory))
+		{
+			size_t end = entry.path.find('/', directory.size());
+			if(isDirectories && end != string::npos)
+				list.push_back(entry.path.substr(0, end + 1));
+			else if(!isDirectories && end == string::npos)
+				list.push_back(move(entry.path));
+			else
+				continue;
+			hasArchived = true;
+		}
+		if(hasArchived)
+		{
+			sort(list.begin(), list.end());
+			list.erase(unique(list.begin(), list.end()), list.end());
+		}
+		return list;
+	}
+	
+	
+	
+	// Open a stream that reads from the given data, which must stay in memory
+	// until the stream is closed.
+	FILE *OpenArchived(const char *data, size_t size)
+	{
+#if defined _WIN32
+		// Windows has no way to read a stream from memory, so use a temporary
+		// file instead.
+		FILE *file = tmpfile();
+		if(file)
+		{
+			fwrite(data, 1, size, file);
+			rewind(file);
+		}
+		return file;
+#else
+		// Some versions of fmemopen() refuse to open an empty buffer.
+		if(!size)
+			return fopen("/dev/null", "rb");
+		return fmemopen(const_cast<char *>(data), size, "rb");
+#endif
+	}
+	
+	
+	
+	// Find all the regular files in the given directory, recursively, sorted
+	// by path. Files in the mounted archives are included, and take the place
+	// of any files on disk with the same paths.
+	vector<Files::Entry> ListEntries(string directory, bool withMetadata)
+	{
+		if(directory.empty() || directory.back() != '/')
+			directory += '/';
+		
+		vector<Files::Entry> entries = ListArchived(directory);
+		bool hasArchived = !entries.empty();
+#if defined _WIN32
+		ListEntries(directory, withMetadata, entries);
+#else
+		int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+		if(fd >= 0)
+			ListEntries(fd, directory, withMetadata, entries);
+#endif
+		stable_sort(entries.begin(), entries.end(),
+			[](const Files::Entry &a, const Files::Entry &b) { return a.path < b.path; });
+		if(hasArchived)
+			entries.erase(unique(entries.begin(), entries.end(),
+				[](const Files::Entry &a, const Files::Entry &b) { return a.path == b.path; }), entries.end());
+		return entries;
+	}
 }
 
 
@@ -139,6 +391,7 @@ void Files::Init(const char * const *argv)
 			throw runtime_error("Unable to find the resource directories!");
 		resources.erase(pos + 1);
 	}
+	Mount(resources);
 	dataPath = resources + "data/";
 	imagePath = resources + "images/";
 	soundPath = resources + "sounds/";
@@ -247,7 +500,7 @@ vector<string> Files::List(string directory)
 	WIN32_FIND_DATAW ffd;
 	HANDLE hFind = FindFirstFileW(ToUTF16(directory + '*').c_str(), &ffd);
 	if(!hFind)
-		return list;
+		return AddArchived(directory, false, move(list));
 	
 	do {
 		if(!ffd.cFileName || ffd.cFileName[0] == '.')
@@ -261,7 +514,7 @@ vector<string> Files::List(string directory)
 #else
 	DIR *dir = opendir(directory.c_str());
 	if(!dir)
-		return list;
+		return AddArchived(directory, false, move(list));
 	
 	while(true)
 	{
@@ -285,7 +538,7 @@ vector<string> Files::List(string directory)
 	
 	closedir(dir);
 #endif
-	return list;
+	return AddArchived(directory, false, move(list));
 }
 
 
@@ -302,7 +555,7 @@ vector<string> Files::ListDirectories(string directory)
 	WIN32_FIND_DATAW ffd;
 	HANDLE hFind = FindFirstFileW(ToUTF16(directory + '*').c_str(), &ffd);
 	if(!hFind)
-		return list;
+		return AddArchived(directory, true, move(list));
 	
 	do {
 		if(!ffd.cFileName || ffd.cFileName[0] == '.')
@@ -316,7 +569,7 @@ vector<string> Files::ListDirectories(string directory)
 #else
 	DIR *dir = opendir(directory.c_str());
 	if(!dir)
-		return list;
+		return AddArchived(directory, true, move(list));
 	
 	while(true)
 	{
@@ -344,7 +597,7 @@ vector<string> Files::ListDirectories(string directory)
 	
 	closedir(dir);
 #endif
-	return list;
+	return AddArchived(directory, true, move(list));
 }
 
 
@@ -360,62 +613,47 @@ vector<string> Files::RecursiveList(const string &directory)
 
 void Files::RecursiveList(string directory, vector<string> *list)
 {
-	if(directory.empty() || directory.back() != '/')
-		directory += '/';
-	
-#if defined _WIN32
-	WIN32_FIND_DATAW ffd;
-	HANDLE hFind = FindFirstFileW(ToUTF16(directory + '*').c_str(), &ffd);
-	if(hFind == INVALID_HANDLE_VALUE)
-		return;
-	
-	do {
-		if(!ffd.cFileName || ffd.cFileName[0] == '.')
-			continue;
-		
-		if(!(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-			list->push_back(directory + ToUTF8(ffd.cFileName));
-		else
-			RecursiveList(directory + ToUTF8(ffd.cFileName) + '/', list);
-	} while(FindNextFileW(hFind, &ffd));
-	
-	FindClose(hFind);
-#else
-	DIR *dir = opendir(directory.c_str());
-	if(!dir)
-		return;
-	
-	while(true)
-	{
-		dirent *ent = readdir(dir);
-		if(!ent)
-			break;
-		// Skip dotfiles (including "." and "..").
-		if(ent->d_name[0] == '.')
-			continue;
-		
-		string name = directory + ent->d_name;
-		// Don't assume that this operating system's implementation of dirent
-		// includes the t_type field; in particular, on Windows it will not.
-		struct stat buf;
-		stat(name.c_str(), &buf);
-		bool isRegularFile = S_ISREG(buf.st_mode);
-		bool isDirectory = S_ISDIR(buf.st_mode);
-		
-		if(isRegularFile)
-			list->push_back(name);
-		else if(isDirectory)
-			RecursiveList(name + '/', list);
-	}
-	
-	closedir(dir);
-#endif
+	vector<Entry> entries = ListEntries(move(directory), false);
+	list->reserve(list->size() + entries.size());
+	for(Entry &entry : entries)
+		list->push_back(move(entry.path));
+}
+
+
+
+vector<Files::Entry> Files::RecursiveListEntries(string directory)
+{
+	return ListEntries(move(directory), true);
+}
+
+
+
+// If the given resource directory contains an archive, read the files in it
+// as if they were in that directory.
+void Files::Mount(const string &directory)
+{
+	unique_ptr<Archive> archive(new Archive(Archive::Path(directory)));
+	if(!archive->IsEmpty())
+		archives.emplace_back(directory, move(archive));
+}
+
+
+
+// If the given file is in one of the mounted archives, point the given data at
+// its contents and return true.
+bool Files::FindArchived(const string &path, const char *&data, size_t &size)
+{
+	return FindArchive(path, data, size);
 }
 
 
 
 bool Files::Exists(const string &filePath)
 {
+	for(const auto &it : archives)
+		if(!filePath.compare(0, it.first.size(), it.first) && it.second->Contains(filePath.substr(it.first.size())))
+			return true;
+	
 #if defined _WIN32
 	struct _stat buf;
 	return !_wstat(ToUTF16(filePath).c_str(), &buf);
@@ -429,6 +667,12 @@ bool Files::Exists(const string &filePath)
 
 time_t Files::Timestamp(const string &filePath)
 {
+	const char *data = nullptr;
+	size_t size = 0;
+	const Archive *archive = FindArchive(filePath, data, size);
+	if(archive)
+		return archive->Timestamp();
+	
 #if defined _WIN32
 	struct _stat buf;
 	_wstat(ToUTF16(filePath).c_str(), &buf);
@@ -474,6 +718,20 @@ void Files::Delete(const string &filePath)
 
 
 
+void Files::CreateFolder(const string &path)
+{
+	if(Exists(path))
+		return;
+	
+#if defined _WIN32
+	CreateDirectoryW(ToUTF16(path).c_str(), nullptr);
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+}
+
+
+
 // Get the filename from a path.
 string Files::Name(const string &path)
 {
@@ -486,8 +744,13 @@ string Files::Name(const string &path)
 
 FILE *Files::Open(const string &path, bool write)
 {
+	const char *data = nullptr;
+	size_t size = 0;
+	if(!write && FindArchive(path, data, size))
+		return OpenArchived(data, size);
+	
 #if defined _WIN32
-	return _wfopen(ToUTF16(path).c_str(), write ? L"w" : L"rb");
+	return _wfopen(ToUTF16(path).c_str(), write ? L"wb" : L"rb");
 #else
 	return fopen(path.c_str(), write ? "wb" : "rb");
 #endif
@@ -497,6 +760,18 @@ FILE *Files::Open(const string &path, bool write)
 
 string Files::Read(const string &path)
 {
+	// Files in an archive can be copied straight out of it.
+	const char *data = nullptr;
+	size_t size = 0;
+	if(FindArchive(path, data, size))
+	{
+		// Reserve one extra byte, for the same reason as below.
+		string result;
+		result.reserve(size + 1);
+		result.assign(data, size);
+		return result;
+	}
+	
 	File file(path);
 	return Read(file);
 }
@@ -547,9 +822,65 @@ void Files::Write(FILE *file, const string &data)
 
 
 
+// Write a file on a background thread, replacing the old file only once the
+// new one is complete.
+void Files::WriteInBackground(const string &path, string data)
+{
+	FinishWriting();
+	
+	// The data is moved into the thread, so the caller is free to change or
+	// destroy its copy right away.
+	auto write = [path](const string &data)
+	{
+		string temporary = path + ".tmp";
+		Write(temporary, data);
+		Move(temporary, path);
+	};
+	backgroundWrite.thread = thread(write, move(data));
+}
+
+
+
+// Add to the end of a file on a background thread.
+void Files::AppendInBackground(const string &path, string data)
+{
+	FinishWriting();
+	
+	auto append = [path](const string &data)
+	{
+#if defined _WIN32
+		FILE *file = _wfopen(ToUTF16(path).c_str(), L"ab");
+#else
+		FILE *file = fopen(path.c_str(), "ab");
+#endif
+		if(!file)
+			return;
+		Write(file, data);
+		fclose(file);
+	};
+	backgroundWrite.thread = thread(append, move(data));
+}
+
+
+
+// Wait for any background write to be finished.
+void Files::FinishWriting()
+{
+	backgroundWrite.Wait();
+}
+
+
+
 void Files::LogError(const string &message)
 {
 	lock_guard<mutex> lock(errorMutex);
+	auto it = errorBuffers.find(this_thread::get_id());
+	if(it != errorBuffers.end())
+	{
+		it->second.push_back(message);
+		return;
+	}
+	
 	cerr << message << endl;
 	if(!errorLog)
 		errorLog = File(config + "errors.txt", true);
@@ -558,3 +889,29 @@ void Files::LogError(const string &message)
 	fwrite("\n", 1, 1, errorLog);
 	fflush(errorLog);
 }
+
+
+
+// Hold on to any errors that the calling thread logs.
+void Files::BeginErrorBuffer()
+{
+	lock_guard<mutex> lock(errorMutex);
+	errorBuffers[this_thread::get_id()];
+}
+
+
+
+// Stop holding on to the calling thread's errors, and return the ones that it
+// has logged since BeginErrorBuffer() was called.
+vector<string> Files::EndErrorBuffer()
+{
+	vector<string> errors;
+	lock_guard<mutex> lock(errorMutex);
+	auto it = errorBuffers.find(this_thread::get_id());
+	if(it != errorBuffers.end())
+	{
+		errors = move(it->second);
+		errorBuffers.erase(it);
+	}
+	return errors;
+}
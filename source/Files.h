@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef FILES_H_
 #define FILES_H_
 
+#include <cstdint>
 #include <cstdio>
 #include <ctime>
 #include <string>
@@ -27,6 +28,15 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 // provides an interface for file operations so that the rest of the code can
 // be completely platform-agnostic.
 class Files {
+public:
+	// A regular file, along with when it was last modified and its size.
+	struct Entry {
+		std::string path;
+		std::time_t timestamp = 0;
+		std::uint64_t size = 0;
+	};
+	
+	
 public:
 	static void Init(const char * const *argv);
 	
@@ -44,15 +54,30 @@ public:
 	// Get a list of any directories in the given directory.
 	static std::vector<std::string> ListDirectories(std::string directory);
 	// Get a list of all regular files in the given directory or any directory
-	// that it contains, recursively.
+	// that it contains, recursively. The subdirectories are searched in
+	// parallel, and the paths are returned in sorted order.
 	static std::vector<std::string> RecursiveList(const std::string &directory);
 	static void RecursiveList(std::string directory, std::vector<std::string> *list);
+	// Get the same list, but also look up each file's timestamp and size.
+	static std::vector<Entry> RecursiveListEntries(std::string directory);
+	
+	// If the given resource directory contains an archive, read the files in it
+	// as if they were in that directory. Files in an archive take the place of
+	// any files on disk with the same paths. Archives must all be mounted before
+	// any other threads begin reading files.
+	static void Mount(const std::string &directory);
+	// If the given file is in one of the mounted archives, point the given data
+	// at its contents and return true.
+	static bool FindArchived(const std::string &path, const char *&data, size_t &size);
 	
 	static bool Exists(const std::string &filePath);
 	static std::time_t Timestamp(const std::string &filePath);
 	static void Copy(const std::string &from, const std::string &to);
 	static void Move(const std::string &from, const std::string &to);
 	static void Delete(const std::string &filePath);
+	// Create the given directory, if it does not already exist. Its parent
+	// directory must already exist.
+	static void CreateFolder(const std::string &path);
 	
 	// Get the filename from a path.
 	static std::string Name(const std::string &path);
@@ -63,8 +88,25 @@ public:
 	static std::string Read(FILE *file);
 	static void Write(const std::string &path, const std::string &data);
 	static void Write(FILE *file, const std::string &data);
+	// Write a file on a background thread. The data is written to a temporary
+	// file first, which then replaces the given file, so that it is never left
+	// only partly written. Only one file is written in the background at a time,
+	// and this should only be called from the main thread.
+	static void WriteInBackground(const std::string &path, std::string data);
+	// Add to the end of a file on a background thread, creating it if it does
+	// not exist. The same restrictions apply as for WriteInBackground().
+	static void AppendInBackground(const std::string &path, std::string data);
+	// Wait until the file that is being written in the background (if any) is
+	// complete. Call this before reading any file that may have been written in
+	// the background.
+	static void FinishWriting();
 	
 	static void LogError(const std::string &message);
+	// Hold on to any errors that the calling thread logs, instead of writing
+	// them right away, until EndErrorBuffer() returns them. This lets work that
+	// is done in parallel report its errors in a consistent order.
+	static void BeginErrorBuffer();
+	static std::vector<std::string> EndErrorBuffer();
 };
 
 
@@ -13,23 +13,63 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "FillShader.h"
 
 #include "Color.h"
+#include "GpuProfiler.h"
 #include "Point.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint centerI;
-	GLint sizeI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each vertex has its position (x, y) in pixels and its color (r, g, b, a).
+	constexpr int FLOATS_PER_VERTEX = 6;
+	// Each rectangle is drawn as two triangles.
+	const float CORNERS[] = {
+		-.5f, -.5f,
+		 .5f, -.5f,
+		-.5f,  .5f,
+		-.5f,  .5f,
+		 .5f, -.5f,
+		 .5f,  .5f
+	};
+	
+	// Rectangles that are filled one after another are collected here, so they
+	// can all be drawn with a single draw call.
+	vector<float> vertices;
+	
+	// Draw all the rectangles that have been added since the last time.
+	void Flush()
+	{
+		if(vertices.empty())
+			return;
+		
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+		GpuProfiler::CountUpload();
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+		GpuProfiler::CountDraw();
+		vertices.clear();
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+	}
 }
 
 
@@ -39,48 +79,43 @@ void FillShader::Init()
 	static const char *vertexCode =
 		"// vertex fill shader\n"
 		"uniform vec2 scale;\n"
-		"uniform vec2 center;\n"
-		"uniform vec2 size;\n"
 		
 		"in vec2 vert;\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
 		
 		"void main() {\n"
-		"  gl_Position = vec4((center + vert * size) * scale, 0, 1);\n"
+		"  fragColor = color;\n"
+		"  gl_Position = vec4(vert * scale, 0, 1);\n"
 		"}\n";
 
 	static const char *fragmentCode =
 		"// fragment fill shader\n"
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
+		"in vec4 fragColor;\n"
 		
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  finalColor = color;\n"
+		"  finalColor = fragColor;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	centerI = shader.Uniform("center");
-	sizeI = shader.Uniform("size");
-	colorI = shader.Uniform("color");
 	
-	// Generate the vertex data for drawing sprites.
+	// Generate the buffer for uploading the batched vertex data.
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		-.5f, -.5f,
-		 .5f, -.5f,
-		-.5f,  .5f,
-		 .5f,  .5f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
+	constexpr auto stride = FLOATS_PER_VERTEX * sizeof(GLfloat);
 	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, stride, nullptr);
+	
+	glEnableVertexAttribArray(shader.Attrib("color"));
+	glVertexAttribPointer(shader.Attrib("color"), 4, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<const GLvoid *>(2 * sizeof(GLfloat)));
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -94,22 +129,15 @@ void FillShader::Fill(const Point &center, const Point &size, const Color &color
 	if(!shader.Object())
 		throw runtime_error("FillShader: Draw() called before Init().");
 	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
-	
-	GLfloat centerV[2] = {static_cast<float>(center.X()), static_cast<float>(center.Y())};
-	glUniform2fv(centerI, 1, centerV);
-	
-	GLfloat sizeV[2] = {static_cast<float>(size.X()), static_cast<float>(size.Y())};
-	glUniform2fv(sizeI, 1, sizeV);
+	// The rectangle is not drawn until something other than a rectangle needs
+	// to be drawn, so that consecutive rectangles share one draw call.
+	RenderQueue::Add(Flush);
 	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	
-	glBindVertexArray(0);
-	glUseProgram(0);
+	const float *rgba = color.Get();
+	for(int i = 0; i < 12; i += 2)
+	{
+		vertices.push_back(center.X() + CORNERS[i] * size.X());
+		vertices.push_back(center.Y() + CORNERS[i + 1] * size.Y());
+		vertices.insert(vertices.end(), rgba, rgba + 4);
+	}
 }
@@ -20,7 +20,8 @@ class Color;
 
 // Class holding a function to fill a rectangular region of the screen with a
 // given color. This can be used with translucent colors to darken or lighten a
-// part of the screen, or with additive colors (alpha = 0) as well.
+// part of the screen, or with additive colors (alpha = 0) as well. Rectangles
+// that are filled one after another are drawn together, through the RenderQueue.
 class FillShader {
 public:
 	static void Init();
@@ -0,0 +1,112 @@
+/* FlatMap.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef FLAT_MAP_H_
+#define FLAT_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+
+// A map from keys to values that is kept sorted in a vector instead of a tree,
+// for the same reasons as a FlatSet: it is slower to change than a std::map,
+// but iterating over it does not have to follow a pointer for every entry.
+// This is meant for small maps that are iterated over every frame, like the
+// sounds that an outfit makes.
+template <class Key, class Value>
+class FlatMap {
+public:
+	using value_type = std::pair<Key, Value>;
+	using const_iterator = typename std::vector<value_type>::const_iterator;
+	using iterator = const_iterator;
+	
+	
+public:
+	const_iterator begin() const { return data.begin(); }
+	const_iterator end() const { return data.end(); }
+	const_iterator cbegin() const { return data.cbegin(); }
+	const_iterator cend() const { return data.cend(); }
+	
+	size_t size() const { return data.size(); }
+	bool empty() const { return data.empty(); }
+	
+	// Find the entry with the given key, or return end() if there is none.
+	const_iterator find(const Key &key) const;
+	size_t count(const Key &key) const { return find(key) != end(); }
+	
+	// Get the value for the given key, adding it with a default value if it is
+	// not in the map yet.
+	Value &operator[](const Key &key);
+	// Remove the entry with the given key, and return how many were removed
+	// (zero or one).
+	size_t erase(const Key &key);
+	void clear() { data.clear(); }
+	
+	
+private:
+	// Find where the given key is, or where it would be inserted.
+	typename std::vector<value_type>::iterator Search(const Key &key);
+	
+	
+private:
+	std::vector<value_type> data;
+};
+
+
+
+template <class Key, class Value>
+typename FlatMap<Key, Value>::const_iterator FlatMap<Key, Value>::find(const Key &key) const
+{
+	auto it = std::lower_bound(data.begin(), data.end(), key,
+		[](const value_type &entry, const Key &other) { return entry.first < other; });
+	return (it != data.end() && !(key < it->first)) ? it : data.end();
+}
+
+
+
+template <class Key, class Value>
+Value &FlatMap<Key, Value>::operator[](const Key &key)
+{
+	auto it = Search(key);
+	if(it == data.end() || key < it->first)
+		it = data.insert(it, value_type(key, Value()));
+	return it->second;
+}
+
+
+
+template <class Key, class Value>
+size_t FlatMap<Key, Value>::erase(const Key &key)
+{
+	auto it = Search(key);
+	if(it == data.end() || key < it->first)
+		return 0;
+	
+	data.erase(it);
+	return 1;
+}
+
+
+
+template <class Key, class Value>
+typename std::vector<typename FlatMap<Key, Value>::value_type>::iterator FlatMap<Key, Value>::Search(const Key &key)
+{
+	return std::lower_bound(data.begin(), data.end(), key,
+		[](const value_type &entry, const Key &other) { return entry.first < other; });
+}
+
+
+
+#endif
@@ -0,0 +1,96 @@
+/* FlatSet.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef FLAT_SET_H_
+#define FLAT_SET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+
+
+// A set of values that are kept sorted in a vector instead of a tree. Adding or
+// removing a value is slower than for a std::set, but iterating over the set is
+// much faster because the values are all next to each other in memory. This is
+// meant for sets that are built once and then read many times, like the links
+// between star systems.
+template <class Type>
+class FlatSet {
+public:
+	using const_iterator = typename std::vector<Type>::const_iterator;
+	using iterator = const_iterator;
+	
+	
+public:
+	const_iterator begin() const { return data.begin(); }
+	const_iterator end() const { return data.end(); }
+	const_iterator cbegin() const { return data.cbegin(); }
+	const_iterator cend() const { return data.cend(); }
+	
+	size_t size() const { return data.size(); }
+	bool empty() const { return data.empty(); }
+	
+	// Find the given value, or return end() if it is not in the set.
+	const_iterator find(const Type &value) const;
+	size_t count(const Type &value) const { return find(value) != end(); }
+	
+	// Add the given value, unless it is already in the set. Return true if it
+	// was added.
+	bool insert(const Type &value);
+	// Remove the given value, and return how many were removed (zero or one).
+	size_t erase(const Type &value);
+	void clear() { data.clear(); }
+	
+	
+private:
+	std::vector<Type> data;
+};
+
+
+
+template <class Type>
+typename FlatSet<Type>::const_iterator FlatSet<Type>::find(const Type &value) const
+{
+	auto it = std::lower_bound(data.begin(), data.end(), value);
+	return (it != data.end() && !(value < *it)) ? it : data.end();
+}
+
+
+
+template <class Type>
+bool FlatSet<Type>::insert(const Type &value)
+{
+	auto it = std::lower_bound(data.begin(), data.end(), value);
+	if(it != data.end() && !(value < *it))
+		return false;
+	
+	data.insert(it, value);
+	return true;
+}
+
+
+
+template <class Type>
+size_t FlatSet<Type>::erase(const Type &value)
+{
+	auto it = std::lower_bound(data.begin(), data.end(), value);
+	if(it == data.end() || value < *it)
+		return 0;
+	
+	data.erase(it);
+	return 1;
+}
+
+
+
+#endif
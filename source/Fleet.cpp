@@ -298,14 +298,34 @@ const Government *Fleet::GetGovernment() const
 
 
 // Choose a fleet to be created during flight, and have it enter the system via jump or planetary departure.
-void Fleet::Enter(const System &system, list<shared_ptr<Ship>> &ships, const Planet *planet) const
+// Create the ships of a randomly chosen variant of this fleet.
+vector<shared_ptr<Ship>> Fleet::Prepare() const
 {
 	if(!total || variants.empty())
-		return;
+		return vector<shared_ptr<Ship>>();
 	
 	// Pick a fleet variant to instantiate.
-	const Variant &variant = ChooseVariant();
-	if(variant.ships.empty())
+	auto placed = Instantiate(ChooseVariant());
+	// Carry all ships that can be carried, as they don't need to be positioned
+	// or checked to see if they can access a particular planet.
+	for(auto &ship : placed)
+		PlaceFighter(ship, placed);
+	
+	return placed;
+}
+
+
+
+void Fleet::Enter(const System &system, list<shared_ptr<Ship>> &ships, const Planet *planet) const
+{
+	Enter(system, Prepare(), ships, planet);
+}
+
+
+
+void Fleet::Enter(const System &system, vector<shared_ptr<Ship>> placed, list<shared_ptr<Ship>> &ships, const Planet *planet) const
+{
+	if(placed.empty())
 		return;
 	
 	// Figure out what system the fleet is starting in, where it is going, and
@@ -328,7 +348,7 @@ void Fleet::Enter(const System &system, list<shared_ptr<Ship>> &ships, const Pla
 		bool hasJump = false;
 		bool hasHyper = false;
 		double jumpDistance = System::DEFAULT_NEIGHBOR_DISTANCE;
-		for(const Ship *ship : variant.ships)
+		for(const shared_ptr<Ship> &ship : placed)
 		{
 			if(ship->Attributes().Get("jump drive"))
 			{
@@ -393,12 +413,6 @@ void Fleet::Enter(const System &system, list<shared_ptr<Ship>> &ships, const Pla
 			source = linkVector[choice];
 	}
 	
-	auto placed = Instantiate(variant);
-	// Carry all ships that can be carried, as they don't need to be positioned
-	// or checked to see if they can access a particular planet.
-	for(auto &ship : placed)
-		PlaceFighter(ship, placed);
-	
 	// Find the stellar object for this planet, and place the ships there.
 	if(planet)
 	{
@@ -508,6 +522,41 @@ void Fleet::Place(const System &system, list<shared_ptr<Ship>> &ships, bool carr
 
 
 
+// Place ships that were created by Prepare() in the given system, already "in action."
+void Fleet::Place(const System &system, vector<shared_ptr<Ship>> placed, list<shared_ptr<Ship>> &ships) const
+{
+	if(placed.empty())
+		return;
+	
+	// Determine where the fleet is going to or coming from.
+	auto center = ChooseCenter(system);
+	
+	shared_ptr<Ship> flagship;
+	for(shared_ptr<Ship> &ship : placed)
+	{
+		// If this is a carried fighter, no need to position it.
+		if(ship->GetParent())
+			continue;
+		
+		Angle angle = Angle::Random();
+		Point pos = center.first + Angle::Random().Unit() * OffsetFrom(center);
+		double velocity = Random::Real() * ship->MaxVelocity();
+		
+		ships.push_front(ship);
+		ship->SetSystem(&system);
+		ship->Place(pos, velocity * angle.Unit(), angle);
+		
+		if(flagship)
+			ship->SetParent(flagship);
+		else
+			flagship = ship;
+		
+		SetCargo(&*ship);
+	}
+}
+
+
+
 // Do the randomization to make a ship enter or be in the given system.
 const System *Fleet::Enter(const System &system, Ship &ship, const System *source)
 {
@@ -570,6 +619,17 @@ int64_t Fleet::Strength() const
 
 
 
+// Get every ship model that may be part of this fleet.
+set<const Ship *> Fleet::Ships() const
+{
+	set<const Ship *> result;
+	for(const Variant &variant : variants)
+		result.insert(variant.ships.begin(), variant.ships.end());
+	return result;
+}
+
+
+
 Fleet::Variant::Variant(const DataNode &node)
 {
 	weight = 1;
@@ -55,11 +55,21 @@ public:
 	// Get the government of this fleet.
 	const Government *GetGovernment() const;
 	
+	// Create the ships of a randomly chosen variant of this fleet, with any
+	// fighters already stored in their carriers' bays. Nothing else refers to
+	// the new ships, so this may be done ahead of time on a worker thread.
+	std::vector<std::shared_ptr<Ship>> Prepare() const;
 	// Choose a fleet to be created during flight, and have it enter the system via jump or planetary departure.
 	void Enter(const System &system, std::list<std::shared_ptr<Ship>> &ships, const Planet *planet = nullptr) const;
+	// Have ships that were created by Prepare() enter the system.
+	void Enter(const System &system, std::vector<std::shared_ptr<Ship>> placed,
+		std::list<std::shared_ptr<Ship>> &ships, const Planet *planet = nullptr) const;
 	// Place a fleet in the given system, already "in action." If the carried flag is set, only
 	// uncarried ships will be added to the list (as any carriables will be stored in bays).
 	void Place(const System &system, std::list<std::shared_ptr<Ship>> &ships, bool carried = true) const;
+	// Place ships that were created by Prepare() in the given system, already "in action."
+	void Place(const System &system, std::vector<std::shared_ptr<Ship>> placed,
+		std::list<std::shared_ptr<Ship>> &ships) const;
 	
 	// Do the randomization to make a ship enter or be in the given system.
 	// Return the system that was chosen for the ship to enter from.
@@ -67,6 +77,8 @@ public:
 	static void Place(const System &system, Ship &ship);
 	
 	int64_t Strength() const;
+	// Get every ship model that may be part of this fleet.
+	std::set<const Ship *> Ships() const;
 	
 	
 private:
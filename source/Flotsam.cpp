@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Effect.h"
 #include "GameData.h"
 #include "Outfit.h"
+#include "PoolAllocator.h"
 #include "Random.h"
 #include "Ship.h"
 #include "SpriteSet.h"
@@ -53,6 +54,21 @@ Flotsam::Flotsam(const Outfit *outfit, int count)
 
 
 
+// Allocate flotsam from the pool, along with their reference counts.
+shared_ptr<Flotsam> Flotsam::Create(const string &commodity, int count)
+{
+	return allocate_shared<Flotsam>(PoolAllocator<Flotsam>(), commodity, count);
+}
+
+
+
+shared_ptr<Flotsam> Flotsam::Create(const Outfit *outfit, int count)
+{
+	return allocate_shared<Flotsam>(PoolAllocator<Flotsam>(), outfit, count);
+}
+
+
+
 // Place this flotsam, and set the given ship as its source. This is a
 // separate function because a ship may queue up flotsam to dump but take
 // several frames before it finishes dumping it all.
@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Body.h"
 #include "Point.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -32,6 +33,10 @@ public:
 	// Constructors for flotsam carrying either a commodity or an outfit.
 	Flotsam(const std::string &commodity, int count);
 	Flotsam(const Outfit *outfit, int count);
+	// Flotsam are created and destroyed in large numbers, so they should be
+	// allocated from a shared pool using these functions instead.
+	static std::shared_ptr<Flotsam> Create(const std::string &commodity, int count);
+	static std::shared_ptr<Flotsam> Create(const Outfit *outfit, int count);
 	
 	/* Functions provided by the Body base class:
 	Frame GetFrame(int step = -1) const;
@@ -13,8 +13,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "FogShader.h"
 
 #include "GameData.h"
+#include "GpuProfiler.h"
 #include "PlayerInfo.h"
 #include "Point.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 #include "System.h"
@@ -23,6 +25,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <set>
 #include <vector>
 
 using namespace std;
@@ -35,9 +39,10 @@ namespace {
 	const int DIAG = 7;
 	// Limit distances to the size of an unsigned char.
 	const int LIMIT = 255;
-	// Pad beyond the screen enough to include any system that might "cast light"
-	// on the on-screen view.
-	const int PAD = LIMIT / ORTH;
+	// Pad beyond the edges of the galaxy enough that the edges of the mask are
+	// completely fogged, and no system is close enough to "cast light" past
+	// them. This is also the farthest a system can affect the mask.
+	const int PAD = LIMIT / ORTH + 1;
 	
 	// OpenGL objects:
 	Shader shader;
@@ -47,14 +52,166 @@ namespace {
 	GLuint vbo;
 	GLuint texture = 0;
 	
-	// Keep track of the previous frame's view so that if it is unchanged we can
-	// skip regenerating the mask.
-	double previousZoom = 0.;
-	double previousLeft = 0.;
-	double previousTop = 0.;
-	int previousColumns = 0;
-	int previousRows = 0;
-	Point previousCenter;
+	// The mask covers the whole galaxy, in map coordinates, so it does not
+	// change when the map is panned or zoomed. This is the map position of
+	// the center of the top left pixel:
+	Point origin;
+	int columns = 0;
+	int rows = 0;
+	// The distance from each pixel to the closest visited system, and the
+	// mask image that was generated from those distances.
+	vector<unsigned char> distances;
+	vector<unsigned char> mask;
+	// The state that the mask was generated from.
+	uint64_t maskRevision = 0;
+	set<const System *> visited;
+	// Whether the visited systems should be checked for changes.
+	bool shouldUpdate = true;
+	
+	
+	// Distance transformation over the given part of the buffer: make two
+	// passes through it. In the first pass, propagate down and to the right.
+	// In the second, propagate in the opposite direction. Once these two
+	// passes are done, each value is equal to the distance to the closest
+	// visited system. The pixels at the edges of the buffer are skipped, but
+	// that does not matter because they are far from any system.
+	void Transform(int left, int top, int right, int bottom)
+	{
+		left = max(left, 1);
+		top = max(top, 1);
+		right = min(right, columns - 1);
+		bottom = min(bottom, rows - 1);
+		for(int y = top; y < bottom; ++y)
+			for(int x = left; x < right; ++x)
+				distances[x + y * columns] = min<int>(distances[x + y * columns], min(
+					ORTH + min(distances[(x - 1) + y * columns], distances[x + (y - 1) * columns]),
+					DIAG + min(distances[(x - 1) + (y - 1) * columns], distances[(x + 1) + (y - 1) * columns])));
+		for(int y = bottom - 1; y >= top; --y)
+			for(int x = right - 1; x >= left; --x)
+				distances[x + y * columns] = min<int>(distances[x + y * columns], min(
+					ORTH + min(distances[(x + 1) + y * columns], distances[x + (y + 1) * columns]),
+					DIAG + min(distances[(x - 1) + (y + 1) * columns], distances[(x + 1) + (y + 1) * columns])));
+	}
+	
+	// Strech the distance values so there is no shading up to about 200 pixels
+	// away, then it transitions somewhat quickly.
+	void Stretch(int left, int top, int right, int bottom)
+	{
+		for(int y = top; y < bottom; ++y)
+			for(int x = left; x < right; ++x)
+				mask[x + y * columns] = max(0, min(LIMIT, (distances[x + y * columns] - 60) * 4));
+	}
+	
+	// Get the pixel that the given system is in.
+	int Column(const System &system)
+	{
+		return round((system.Position().X() - origin.X()) / GRID);
+	}
+	
+	int Row(const System &system)
+	{
+		return round((system.Position().Y() - origin.Y()) / GRID);
+	}
+	
+	// Generate the whole mask from scratch, for the given visited systems.
+	void Generate()
+	{
+		// Make the mask big enough for every system, not just the ones that
+		// have been visited, so that it never has to be resized when the
+		// player explores more of the galaxy.
+		bool isFirst = true;
+		Point topLeft;
+		Point bottomRight;
+		for(const auto &it : GameData::Systems())
+			if(it.second.IsValid())
+			{
+				const Point &pos = it.second.Position();
+				topLeft = isFirst ? pos : Point(min(topLeft.X(), pos.X()), min(topLeft.Y(), pos.Y()));
+				bottomRight = isFirst ? pos : Point(max(bottomRight.X(), pos.X()), max(bottomRight.Y(), pos.Y()));
+				isFirst = false;
+			}
+		origin = topLeft - Point(GRID * PAD, GRID * PAD);
+		columns = ceil((bottomRight.X() - topLeft.X()) / GRID) + 1 + 2 * PAD;
+		rows = ceil((bottomRight.Y() - topLeft.Y()) / GRID) + 1 + 2 * PAD;
+		// Round up to a multiple of 4 so the rows will be 32-bit aligned.
+		columns = (columns + 3) & ~3;
+		
+		// For each system the player has visited, its "distance" pixel in the
+		// buffer should be set to 0.
+		distances.assign(static_cast<size_t>(rows) * columns, LIMIT);
+		mask.resize(distances.size());
+		for(const System *system : visited)
+			distances[Column(*system) + Row(*system) * columns] = 0;
+		Transform(0, 0, columns, rows);
+		Stretch(0, 0, columns, rows);
+		
+		// The texture size may have changed, so it must be reallocated.
+		if(texture)
+			glDeleteTextures(1, &texture);
+		
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		GpuProfiler::CountBind();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		
+		// Upload the new "image."
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, columns, rows, 0, GL_RED, GL_UNSIGNED_BYTE, mask.data());
+		GpuProfiler::CountUpload();
+	}
+	
+	// Light up the area around a newly visited system, and upload only the
+	// part of the mask that it changed.
+	void Patch(const System &system)
+	{
+		int x = Column(system);
+		int y = Row(system);
+		distances[x + y * columns] = 0;
+		
+		// Keep the rows of the uploaded part 32-bit aligned.
+		int left = max(0, x - PAD) & ~3;
+		int right = min(columns, (x + PAD + 4) & ~3);
+		int top = max(0, y - PAD);
+		int bottom = min(rows, y + PAD + 1);
+		Transform(left, top, right, bottom);
+		Stretch(left, top, right, bottom);
+		
+		vector<unsigned char> part;
+		part.reserve((right - left) * (bottom - top));
+		for(int row = top; row < bottom; ++row)
+			part.insert(part.end(), mask.begin() + row * columns + left, mask.begin() + row * columns + right);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		GpuProfiler::CountBind();
+		glTexSubImage2D(GL_TEXTURE_2D, 0, left, top, right - left, bottom - top, GL_RED, GL_UNSIGNED_BYTE, part.data());
+		GpuProfiler::CountUpload();
+	}
+	
+	// Bring the mask up to date with the systems the player has visited.
+	void Update(const PlayerInfo &player)
+	{
+		set<const System *> current;
+		for(const auto &it : GameData::Systems())
+			if(it.second.IsValid() && player.HasVisited(it.second))
+				current.insert(&it.second);
+		
+		// If the galaxy has changed, or any system is no longer visited, the
+		// whole mask must be generated again. Otherwise, systems can just be
+		// added to it.
+		bool isRemoved = (current.size() < visited.size() || !includes(current.begin(), current.end(), visited.begin(), visited.end()));
+		if(!texture || maskRevision != GameData::Revision() || isRemoved)
+		{
+			maskRevision = GameData::Revision();
+			visited = move(current);
+			Generate();
+			return;
+		}
+		
+		for(const System *system : current)
+			if(visited.insert(system).second)
+				Patch(*system);
+	}
 }
 
 
@@ -70,8 +227,8 @@ void FogShader::Init()
 		"out vec2 fragTexCoord;\n"
 		
 		"void main() {\n"
-		"  gl_Position = vec4(corner + vert * dimensions, 0, 1);\n"
-		"  fragTexCoord = vert;\n"
+		"  gl_Position = vec4(2 * vert.x - 1, 1 - 2 * vert.y, 0, 1);\n"
+		"  fragTexCoord = corner + vert * dimensions;\n"
 		"}\n";
 
 	static const char *fragmentCode =
@@ -123,121 +280,43 @@ void FogShader::Init()
 
 void FogShader::Redraw()
 {
-	previousZoom = 0.;
+	shouldUpdate = true;
 }
 
 
 
 void FogShader::Draw(const Point &center, double zoom, const PlayerInfo &player)
 {
-	// Generate a scaled-down mask image that represents the entire screen plus
-	// enough pixels beyond the screen to include any systems that may be off
-	// screen but close enough to "illuminate" part of the on-screen map.
-	double left = Screen::Left() - GRID * PAD * zoom + fmod(center.X(), GRID) * zoom;
-	double top = Screen::Top() - GRID * PAD * zoom + fmod(center.Y(), GRID) * zoom;
-	int columns = ceil(Screen::Width() / (GRID * zoom)) + 1 + 2 * PAD;
-	int rows = ceil(Screen::Height() / (GRID * zoom)) + 1 + 2 * PAD;
-	// Round up to a multiple of 4 so the rows will be 32-bit aligned.
-	columns = (columns + 3) & ~3;
-	
-	// To avoid extra work, don't regenerate the mask buffer if the view has not
-	// moved. This might cause an inaccurate mask if you explore more systems,
-	// come back to the original, and view the map again without viewing it in
-	// between. But, that's an unlikely situation.
-	bool shouldRegenerate = (
-		zoom != previousZoom || center.X() != previousCenter.X() || center.Y() != previousCenter.Y() ||
-		left != previousLeft || top != previousTop || columns != previousColumns || rows != previousRows);
-	if(shouldRegenerate)
+	// Only check what systems have been visited when asked to, because that
+	// cannot change while the map is open.
+	if(shouldUpdate || maskRevision != GameData::Revision())
 	{
-		bool sizeChanged = (!texture || columns != previousColumns || rows != previousRows);
-		
-		// Remember the current viewport attributes.
-		previousZoom = zoom;
-		previousCenter = center;
-		previousLeft = left;
-		previousTop = top;
-		previousColumns = columns;
-		previousRows = rows;
-		
-		// This buffer will hold the mask image.
-		auto buffer = vector<unsigned char>(static_cast<size_t>(rows) * columns, LIMIT);
-	
-		// For each system the player knows about, its "distance" pixel in the
-		// buffer should be set to 0.
-		for(const auto &it : GameData::Systems())
-		{
-			const System &system = it.second;
-			if(!system.IsValid() || !player.HasVisited(system))
-				continue;
-			Point pos = zoom * (system.Position() + center);
-		
-			int x = round((pos.X() - left) / (GRID * zoom));
-			int y = round((pos.Y() - top) / (GRID * zoom));
-			if(x >= 0 && y >= 0 && x < columns && y < rows)
-				buffer[x + y * columns] = 0;
-		}
-	
-		// Distance transformation: make two passes through the buffer. In the first
-		// pass, propagate down and to the right. In the second, propagate in the
-		// opposite direction. Once these two passes are done, each value is equal
-		for(int y = 1; y < rows; ++y)
-			for(int x = 1; x < columns; ++x)
-				buffer[x + y * columns] = min<int>(buffer[x + y * columns], min(
-					ORTH + min(buffer[(x - 1) + y * columns], buffer[x + (y - 1) * columns]),
-					DIAG + min(buffer[(x - 1) + (y - 1) * columns], buffer[(x + 1) + (y - 1) * columns])));
-		for(int y = rows - 2; y >= 0; --y)
-			for(int x = columns - 2; x >= 0; --x)
-				buffer[x + y * columns] = min<int>(buffer[x + y * columns], min(
-					ORTH + min(buffer[(x + 1) + y * columns], buffer[x + (y + 1) * columns]),
-					DIAG + min(buffer[(x - 1) + (y + 1) * columns], buffer[(x + 1) + (y + 1) * columns])));
-	
-		// Strech the distance values so there is no shading up to about 200 pixels
-		// away, then it transitions somewhat quickly.
-		for(unsigned char &value : buffer)
-			value = max(0, min(LIMIT, (value - 60) * 4));
-		const void *data = &buffer.front();
-		
-		// Set up the OpenGL texture if it doesn't exist yet.
-		if(sizeChanged)
-		{
-			// If the texture size changed, it must be reallocated.
-			if(texture)
-				glDeleteTextures(1, &texture);
-			
-			glGenTextures(1, &texture);
-			glBindTexture(GL_TEXTURE_2D, texture);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			
-			// Upload the new "image."
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, columns, rows, 0, GL_RED, GL_UNSIGNED_BYTE, data);
-		}
-		else
-		{
-			glBindTexture(GL_TEXTURE_2D, texture);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, columns, rows, GL_RED, GL_UNSIGNED_BYTE, data);
-		}
+		shouldUpdate = false;
+		Update(player);
 	}
-	else
-		glBindTexture(GL_TEXTURE_2D, texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	GpuProfiler::CountBind();
 	
 	// Set up to draw the image.
+	RenderQueue::Flush();
 	glUseProgram(shader.Object());
 	glBindVertexArray(vao);
 	
+	// The mask is drawn over the whole screen. Find what part of the mask
+	// texture is on screen. Anything beyond the edges is fully fogged.
+	Point topLeft = (Screen::TopLeft() / zoom - center - origin) / GRID + Point(.5, .5);
 	GLfloat corner[2] = {
-		static_cast<float>(left - .5 * GRID * zoom) / (.5f * Screen::Width()),
-		static_cast<float>(top - .5 * GRID * zoom) / (-.5f * Screen::Height())};
+		static_cast<float>(topLeft.X() / columns),
+		static_cast<float>(topLeft.Y() / rows)};
 	glUniform2fv(cornerI, 1, corner);
 	GLfloat dimensions[2] = {
-		GRID * static_cast<float>(zoom) * (columns + 1.f) / (.5f * Screen::Width()),
-		GRID * static_cast<float>(zoom) * (rows + 1.f) / (-.5f * Screen::Height())};
+		static_cast<float>(Screen::Width() / (zoom * GRID * columns)),
+		static_cast<float>(Screen::Height() / (zoom * GRID * rows))};
 	glUniform2fv(dimensionsI, 1, dimensions);
 	
 	// Call the shader program to draw the image.
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	GpuProfiler::CountDraw();
 	
 	// Clean up.
 	glBindVertexArray(0);
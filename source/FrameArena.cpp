@@ -0,0 +1,133 @@
+/* FrameArena.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+namespace {
+	// Each block of memory is at least this big.
+	const size_t BLOCK_SIZE = 64 * 1024;
+	
+	atomic<unsigned> currentStep(0);
+}
+
+
+
+// Get memory from the calling thread's arena, or give it back. (Where
+// thread_local storage is not supported, this just uses the heap.)
+void *FrameArena::Get(size_t bytes, size_t alignment)
+{
+#ifdef __linux__
+	return Local().Allocate(bytes, alignment);
+#else
+	return ::operator new(bytes);
+#endif
+}
+
+
+
+void FrameArena::Release(void *memory) noexcept
+{
+#ifndef __linux__
+	::operator delete(memory);
+#endif
+}
+
+
+
+// Begin a new step. Each thread's arena will start over from the beginning
+// of its memory the next time that thread allocates anything.
+void FrameArena::NextStep()
+{
+	++currentStep;
+}
+
+
+
+// Get the arena belonging to the calling thread. Where thread_local storage
+// is not supported, there is just one arena, which Get() does not use.
+FrameArena &FrameArena::Local()
+{
+#ifdef __linux__
+	thread_local FrameArena arena;
+#else
+	static FrameArena arena;
+#endif
+	unsigned step = currentStep.load(memory_order_relaxed);
+	if(arena.step != step)
+	{
+		arena.Reset();
+		arena.step = step;
+	}
+	return arena;
+}
+
+
+
+// Get memory for the given number of bytes, with the given alignment.
+void *FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	// Find the first block, starting with the current one, that has room for
+	// this allocation once it is aligned.
+	for( ; current < blocks.size(); ++current, used = 0)
+	{
+		size_t start = (used + alignment - 1) / alignment * alignment;
+		if(start + bytes <= sizes[current])
+		{
+			used = start + bytes;
+			return blocks[current].get() + start;
+		}
+	}
+	
+	// Allocate a new block. Memory from new[] is aligned for any type.
+	size_t size = max(BLOCK_SIZE, bytes);
+	blocks.emplace_back(new char[size]);
+	sizes.push_back(size);
+	++allocations;
+	used = bytes;
+	return blocks[current].get();
+}
+
+
+
+// Take back all the memory that has been handed out. If more than one block
+// had to be allocated, replace them with a single block that is big enough
+// for all of them, so that future steps will not need to allocate.
+void FrameArena::Reset()
+{
+	if(blocks.size() > 1)
+	{
+		size_t total = 0;
+		for(size_t size : sizes)
+			total += size;
+		blocks.clear();
+		sizes.clear();
+		blocks.emplace_back(new char[total]);
+		sizes.push_back(total);
+		++allocations;
+	}
+	current = 0;
+	used = 0;
+}
+
+
+
+// Get how many blocks of memory this arena has allocated from the heap
+// since it was created.
+size_t FrameArena::Allocations() const
+{
+	return allocations;
+}
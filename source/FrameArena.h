@@ -0,0 +1,96 @@
+/* FrameArena.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef FRAME_ARENA_H_
+#define FRAME_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+
+// Class for handing out memory for temporary containers that only exist for
+// part of one step of the game, such as the list of ships that an AI is
+// considering shooting at. Each thread has its own arena, so allocating does
+// not need any locks, and an allocation is just a pointer increment. Freeing
+// memory does nothing; instead, everything an arena has handed out is taken
+// back at once when the next step begins. So, a container that uses this
+// memory must never be kept from one step to the next.
+class FrameArena {
+public:
+	// Get memory from the calling thread's arena, or give it back. (Where
+	// thread_local storage is not supported, this just uses the heap.)
+	static void *Get(size_t bytes, size_t alignment);
+	static void Release(void *memory) noexcept;
+	// Begin a new step. Each thread's arena will start over from the beginning
+	// of its memory the next time that thread allocates anything.
+	static void NextStep();
+	// Get the arena belonging to the calling thread.
+	static FrameArena &Local();
+	
+	// Get memory for the given number of bytes, with the given alignment.
+	void *Allocate(size_t bytes, size_t alignment);
+	// Take back all the memory that has been handed out. If more than one block
+	// had to be allocated, replace them with a single block that is big enough
+	// for all of them, so that future steps will not need to allocate.
+	void Reset();
+	
+	// Get how many blocks of memory this arena has allocated from the heap
+	// since it was created.
+	size_t Allocations() const;
+	
+	
+private:
+	std::vector<std::unique_ptr<char[]>> blocks;
+	std::vector<size_t> sizes;
+	// The block that memory is currently being handed out from, and how much
+	// of it has been used.
+	size_t current = 0;
+	size_t used = 0;
+	size_t allocations = 0;
+	// Which step this arena's memory was last reset for.
+	unsigned step = 0;
+};
+
+
+
+// An allocator that takes its memory from the calling thread's FrameArena, so
+// that it can be used with the standard containers.
+template <class Type>
+class FrameAllocator {
+public:
+	using value_type = Type;
+	
+	FrameAllocator() noexcept = default;
+	template <class Other>
+	FrameAllocator(const FrameAllocator<Other> &) noexcept {}
+	
+	Type *allocate(size_t count)
+	{
+		return static_cast<Type *>(FrameArena::Get(count * sizeof(Type), alignof(Type)));
+	}
+	void deallocate(Type *memory, size_t) noexcept { FrameArena::Release(memory); }
+};
+
+template <class Type, class Other>
+bool operator==(const FrameAllocator<Type> &, const FrameAllocator<Other> &) noexcept { return true; }
+template <class Type, class Other>
+bool operator!=(const FrameAllocator<Type> &, const FrameAllocator<Other> &) noexcept { return false; }
+
+// A vector that is only used within a single step.
+template <class Type>
+using FrameVector = std::vector<Type, FrameAllocator<Type>>;
+
+
+
+#endif
@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "FrameTimer.h"
 
+#include <algorithm>
 #include <thread>
 
 using namespace std;
@@ -43,25 +44,86 @@ FrameTimer::FrameTimer(int fps, int maxLagMsec)
 // Wait until the next frame should begin.
 void FrameTimer::Wait()
 {
+	Sleep(chrono::steady_clock::duration::zero());
+}
+
+
+
+// Wait until the next frame should begin, given how long the buffer swap
+// at the end of this frame took and the display's refresh rate (or 0 if it
+// is not known). If VSync made the swap wait for the display, that wait is
+// counted as part of the pacing instead of waiting a second time.
+void FrameTimer::Wait(chrono::steady_clock::duration swapTime, int refreshRate)
+{
+	swapWait += (swapTime - swapWait) / 8;
+	// If the swaps are not blocking, VSync is off (or the frames are taking
+	// too long for it to matter), so this timer must do all the pacing.
+	if(refreshRate <= 0 || swapWait < chrono::milliseconds(1))
+	{
+		Wait();
+		return;
+	}
+	
+	chrono::steady_clock::duration refresh = chrono::nanoseconds(1000000000 / refreshRate);
+	// If the display refreshes no faster than the frame rate (allowing for
+	// displays that run at e.g. 59.94 Hz), each swap already waited out the
+	// rest of the frame. Start the next frame right away, and schedule the
+	// one after that from when this frame was actually shown, so that the
+	// timer and the display never drift out of phase.
+	if(refresh * 21 >= step * 20)
+	{
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		if(now - next > maxLag)
+			++missedFrames;
+		next = now + step;
+		return;
+	}
+	
+	// Otherwise, the frame spans several refreshes. Wake up early by about as
+	// long as the swaps have been waiting, so the swap ends on the first
+	// refresh after the frame is due rather than on the one after that.
+	Sleep(min(swapWait, refresh));
+}
+
+
+
+// Get how many frames have begun later than they should have.
+int FrameTimer::MissedFrames() const
+{
+	return missedFrames;
+}
+
+
+
+// Sleep until the given amount of time before the next frame should begin.
+void FrameTimer::Sleep(chrono::steady_clock::duration early)
+{
+	chrono::steady_clock::time_point wake = next - early;
 	// Note: in theory this could get interrupted by a signal handler, although
 	// it's unlikely the program will receive any signals that do not terminate
 	// it and that it does not ignore. But, the worst that would happen in that
 	// case is that this particular frame will end too quickly, and then it will
 	// go back to normal for the next one.
 	chrono::steady_clock::time_point now = chrono::steady_clock::now();
-	if(now < next)
+	if(now < wake)
 	{
 		// This should never happen with a true steady clock, but make sure that
 		// the sleep time is never longer than one frame.
 		if(now + step + maxLag < next)
+		{
 			next = now + step;
+			wake = next - early;
+		}
 		
-		this_thread::sleep_until(next);
+		this_thread::sleep_until(wake);
 		now = chrono::steady_clock::now();
 	}
 	// If the lag is too high, don't try to do catch-up.
 	if(now - next > maxLag)
+	{
 		next = now;
+		++missedFrames;
+	}
 	
 	Step();
 }
@@ -32,6 +32,13 @@ public:
 	
 	// Wait until the next frame should begin.
 	void Wait();
+	// Wait until the next frame should begin, given how long the buffer swap
+	// at the end of this frame took and the display's refresh rate (or 0 if it
+	// is not known). If VSync made the swap wait for the display, that wait is
+	// counted as part of the pacing instead of waiting a second time.
+	void Wait(std::chrono::steady_clock::duration swapTime, int refreshRate);
+	// Get how many frames have begun later than they should have.
+	int MissedFrames() const;
 	// Find out how long it has been since this timer was created, in seconds.
 	double Time() const;
 	
@@ -40,6 +47,8 @@ public:
 	
 	
 private:
+	// Sleep until the given amount of time before the next frame should begin.
+	void Sleep(std::chrono::steady_clock::duration early);
 	// Calculate when the next frame should begin.
 	void Step();
 	
@@ -48,6 +57,10 @@ private:
 	std::chrono::steady_clock::time_point next;
 	std::chrono::steady_clock::duration step;
 	std::chrono::steady_clock::duration maxLag;
+	
+	// A running average of how long the buffer swaps are taking.
+	std::chrono::steady_clock::duration swapWait = std::chrono::steady_clock::duration::zero();
+	int missedFrames = 0;
 };
 
 
@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Color.h"
 #include "Command.h"
 #include "Conversation.h"
+#include "DataCache.h"
 #include "DataFile.h"
 #include "DataNode.h"
 #include "DataWriter.h"
@@ -33,9 +34,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ImageSet.h"
 #include "Interface.h"
 #include "LineShader.h"
+#include "MapShader.h"
+#include "MemoryStats.h"
 #include "Minable.h"
 #include "Mission.h"
 #include "Music.h"
+#include "Named.h"
 #include "News.h"
 #include "Outfit.h"
 #include "OutlineShader.h"
@@ -44,8 +48,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Planet.h"
 #include "PointerShader.h"
 #include "Politics.h"
+#include "PriceTable.h"
+#include "Profiler.h"
 #include "Random.h"
 #include "RingShader.h"
+#include "SceneBuffer.h"
+#include "Shader.h"
 #include "Ship.h"
 #include "Sprite.h"
 #include "SpriteQueue.h"
@@ -53,9 +61,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteShader.h"
 #include "StarField.h"
 #include "StartConditions.h"
+#include "StellarObject.h"
 #include "System.h"
 #include "Test.h"
 #include "TestData.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
 #include <iostream>
@@ -93,14 +103,6 @@ namespace {
 	Set<Sale<Ship>> shipSales;
 	Set<Sale<Outfit>> outfitSales;
 	
-	Set<Fleet> defaultFleets;
-	Set<Government> defaultGovernments;
-	Set<Planet> defaultPlanets;
-	Set<System> defaultSystems;
-	Set<Galaxy> defaultGalaxies;
-	Set<Sale<Ship>> defaultShipSales;
-	Set<Sale<Outfit>> defaultOutfitSales;
-	
 	Politics politics;
 	vector<StartConditions> startConditions;
 	
@@ -122,13 +124,31 @@ namespace {
 	SpriteQueue spriteQueue;
 	// Whether sprites and audio have finished loading at game startup.
 	bool initiallyLoaded = false;
+	// Whether to print how much memory is in use once that happens.
+	bool printMemory = false;
 	
 	vector<string> sources;
 	map<const Sprite *, shared_ptr<ImageSet>> deferred;
 	map<const Sprite *, int> preloaded;
+	// The system that the player is travelling to, and the sprites of its
+	// stellar objects and the ships that may appear there.
+	const System *preloadedSystem = nullptr;
+	set<const Sprite *> preloadedSprites;
+	
+	// In debug mode, the timestamp of every file in each source's "data" and
+	// "images" folders is remembered, so that changed files can be reloaded.
+	bool isWatchingFiles = false;
+	map<string, time_t> watchedFiles;
+	// Reverting the systems does not recalculate their neighbors, so if a system
+	// has been redefined since the game started, that must be done separately.
+	bool systemsRedefined = false;
 	
 	const Government *playerGovernment = nullptr;
 	
+	// Zero is never a valid revision, so it can be used to mark values that
+	// have never been calculated.
+	uint64_t revision = 1;
+	
 	// TODO (C++14): make these 3 methods generic lambdas visible only to the CheckReferences method.
 	// Log a warning for an "undefined" class object that was never loaded from disk.
 	void Warn(const string &noun, const string &name)
@@ -153,6 +173,82 @@ namespace {
 		it.second.SetName(it.first);
 		Warn(noun, it.first);
 	}
+	
+	// Find the data files and images that have been added or modified since
+	// this was last called. The data files are listed in the order they should
+	// be loaded in, and the images are listed by name.
+	void FindChangedFiles(vector<string> &dataPaths, set<string> &imageNames)
+	{
+		vector<vector<Files::Entry>> entries(2 * sources.size());
+		ThreadPool::Shared().ForEach(entries.size(), [&entries](size_t i)
+		{
+			entries[i] = Files::RecursiveListEntries(sources[i / 2] + (i % 2 ? "images/" : "data/"));
+		});
+		
+		for(size_t i = 0; i < entries.size(); ++i)
+		{
+			size_t start = (sources[i / 2] + (i % 2 ? "images/" : "data/")).size();
+			for(const Files::Entry &entry : entries[i])
+			{
+				time_t &timestamp = watchedFiles[entry.path];
+				if(timestamp == entry.timestamp)
+					continue;
+				timestamp = entry.timestamp;
+				
+				const string &path = entry.path;
+				if(i % 2)
+				{
+					if(ImageSet::IsImage(path))
+						imageNames.insert(ImageSet::Name(path.substr(start)));
+				}
+				else if(path.length() >= 4 && !path.compare(path.length() - 4, 4, ".txt"))
+					dataPaths.push_back(path);
+			}
+		}
+	}
+	
+	// Finish loading every ship model and variant, and the ships of every
+	// person. Besides the outfits, each ship only looks at its own model, so
+	// the models can all be finished in parallel, and then the variants and
+	// persons. Any errors are logged in the same order every time.
+	void FinishLoadingShips()
+	{
+		// Make sure the default launch effect exists, so that finishing a ship
+		// never has to add it to the set.
+		effects.Get("basic launch");
+		
+		vector<Ship *> models;
+		vector<Ship *> variants;
+		for(auto &&it : ships)
+			(it.first == it.second.ModelName() ? models : variants).push_back(&it.second);
+		vector<Person *> people;
+		for(auto &&it : persons)
+			people.push_back(&it.second);
+		
+		vector<vector<string>> errors(models.size());
+		ThreadPool::Shared().ForEach(models.size(), [&models, &errors](size_t i)
+		{
+			Files::BeginErrorBuffer();
+			models[i]->FinishLoading(true);
+			errors[i] = Files::EndErrorBuffer();
+		});
+		
+		vector<vector<string>> laterErrors(variants.size() + people.size());
+		ThreadPool::Shared().ForEach(laterErrors.size(), [&variants, &people, &laterErrors](size_t i)
+		{
+			Files::BeginErrorBuffer();
+			if(i < variants.size())
+				variants[i]->FinishLoading(true);
+			else
+				people[i - variants.size()]->FinishLoading();
+			laterErrors[i] = Files::EndErrorBuffer();
+		});
+		
+		errors.insert(errors.end(), laterErrors.begin(), laterErrors.end());
+		for(const vector<string> &list : errors)
+			for(const string &error : list)
+				Files::LogError(error);
+	}
 }
 
 
@@ -176,6 +272,10 @@ bool GameData::BeginLoad(const char * const *argv)
 				printTests = true;
 			if(arg == "-d" || arg == "--debug")
 				debugMode = true;
+			if(arg == "--headless")
+				spriteQueue.SkipTextures();
+			if(arg == "--memory-report")
+				printMemory = true;
 			continue;
 		}
 	}
@@ -189,6 +289,10 @@ bool GameData::BeginLoad(const char * const *argv)
 	// paths override the default images.
 	map<string, shared_ptr<ImageSet>> images = FindImages();
 	
+	// Tracing the outlines of all the ships and asteroids takes a while, so the
+	// collision masks are cached as well.
+	spriteQueue.CacheMasks(Files::Config() + "masks.cache");
+	
 	// From the name, strip out any frame number, plus the extension.
 	for(const auto &it : images)
 	{
@@ -208,14 +312,41 @@ bool GameData::BeginLoad(const char * const *argv)
 	// Generate a catalog of music files.
 	Music::Init(sources);
 	
+	// Iterate through the paths starting with the last directory given. That
+	// is, things in folders near the start of the path have the ability to
+	// override things in folders later in the path.
+	vector<string> dataPaths;
 	for(const string &source : sources)
+		for(const string &path : Files::RecursiveList(source + "data/"))
+		{
+			// Skip anything that is not a data file (e.g. an image).
+			if(path.length() >= 4 && !path.compare(path.length() - 4, 4, ".txt"))
+				dataPaths.push_back(path);
+		}
+	
+	// Parsing each file does not depend on any other file, so the files can all
+	// be parsed in parallel. Any that have not changed since the last time the
+	// game was run can be loaded from the cache instead. The parsed files must
+	// still be loaded one at a time and in their original order, so that they
+	// override each other correctly.
+	vector<DataFile> dataFiles(dataPaths.size());
 	{
-		// Iterate through the paths starting with the last directory given. That
-		// is, things in folders near the start of the path have the ability to
-		// override things in folders later in the path.
-		vector<string> dataFiles = Files::RecursiveList(source + "data/");
-		for(const string &path : dataFiles)
-			LoadFile(path, debugMode);
+		DataCache cache(Files::Config() + "data.cache");
+		ThreadPool::Shared().ForEach(dataPaths.size(), [&dataPaths, &dataFiles, &cache](size_t i)
+		{
+			Profiler::Scope profile("Parse file");
+			cache.Load(dataPaths[i], dataFiles[i]);
+		});
+		cache.Save();
+	}
+	{
+		Profiler::Scope profile("Load data");
+		for(size_t i = 0; i < dataFiles.size(); ++i)
+		{
+			if(debugMode)
+				Files::LogError("Parsing: " + dataPaths[i]);
+			LoadFile(dataPaths[i], dataFiles[i]);
+		}
 	}
 	
 	// Now that all data is loaded, update the neighbor lists and other
@@ -225,10 +356,10 @@ bool GameData::BeginLoad(const char * const *argv)
 	UpdateSystems();
 	
 	// And, update the ships with the outfits we've now finished loading.
-	for(auto &&it : ships)
-		it.second.FinishLoading(true);
-	for(auto &&it : persons)
-		it.second.FinishLoading();
+	{
+		Profiler::Scope profile("Finish loading");
+		FinishLoadingShips();
+	}
 	
 	for(auto &&it : startConditions)
 		it.FinishLoading();
@@ -238,18 +369,28 @@ bool GameData::BeginLoad(const char * const *argv)
 		startConditions.end()
 	);
 	
-	// Store the current state, to revert back to later.
-	defaultFleets = fleets;
-	defaultGovernments = governments;
-	defaultPlanets = planets;
-	defaultSystems = systems;
-	defaultGalaxies = galaxies;
-	defaultShipSales = shipSales;
-	defaultOutfitSales = outfitSales;
-	playerGovernment = governments.Get("Escort");
+	// Keep track of any changes to the current state, to revert them later.
+	fleets.TrackChanges();
+	governments.TrackChanges();
+	planets.TrackChanges();
+	systems.TrackChanges();
+	galaxies.TrackChanges();
+	shipSales.TrackChanges();
+	outfitSales.TrackChanges();
+	playerGovernment = GameData::Governments().Get("Escort");
 	
 	politics.Reset();
 	
+	// In debug mode, remember when each file was modified, so that any files
+	// that are changed while the game is running can be reloaded.
+	if(debugMode)
+	{
+		isWatchingFiles = true;
+		vector<string> unusedPaths;
+		set<string> unusedNames;
+		FindChangedFiles(unusedPaths, unusedNames);
+	}
+	
 	if(printShips)
 		PrintShipTable();
 	if(printTests)
@@ -266,25 +407,33 @@ bool GameData::BeginLoad(const char * const *argv)
 // planets) are written to the player's save and need a name to prevent data loss.
 void GameData::CheckReferences()
 {
-	// Parse all GameEvents for object definitions.
-	auto deferred = map<string, set<string>>{};
+	// Parse all GameEvents for object definitions. Each event is parsed on its
+	// own, so that can be done in parallel.
+	vector<const GameEvent *> named;
 	for(auto &&it : events)
 	{
 		// Stock GameEvents are serialized in MissionActions by name.
 		if(it.second.Name().empty())
 			NameAndWarn("event", it);
 		else
-		{
-			// Any already-named event (i.e. loaded) may alter the universe.
-			auto definitions = GameEvent::DeferredDefinitions(it.second.Changes());
-			for(auto &&type : definitions)
-				deferred[type.first].insert(type.second.begin(), type.second.end());
-		}
+			named.push_back(&it.second);
 	}
+	// Any already-named event (i.e. loaded) may alter the universe.
+	vector<map<string, set<string>>> definitions(named.size());
+	ThreadPool::Shared().ForEach(named.size(), [&named, &definitions](size_t i)
+	{
+		definitions[i] = GameEvent::DeferredDefinitions(named[i]->Changes());
+	});
+	auto deferred = map<string, set<string>>{};
+	for(const auto &eventDefinitions : definitions)
+		for(auto &&type : eventDefinitions)
+			deferred[type.first].insert(type.second.begin(), type.second.end());
 	
-	// Stock conversations are never serialized.
+	// Stock conversations are never serialized. Checking whether they are
+	// defined does not require parsing them, unless in debug mode, where they
+	// are all parsed now so that any errors in them are reported right away.
 	for(const auto &it : conversations)
-		if(it.second.IsEmpty())
+		if(isWatchingFiles ? it.second.IsEmpty() : !it.second.IsDefined())
 			Warn("conversation", it.first);
 	// The "default intro" conversation must invoke the prompt to set the player's name.
 	if(!conversations.Get("default intro")->IsValidIntro())
@@ -294,14 +443,27 @@ void GameData::CheckReferences()
 		if(it.second.Name().empty())
 			NameAndWarn("effect", it);
 	// Fleets are not serialized. Any changes via events are written as DataNodes and thus self-define.
+	// Each fleet only checks its own variants, so they are checked in parallel, and any warnings are
+	// logged afterward in the same order as if they had been checked one at a time.
+	vector<pair<const string, Fleet> *> allFleets;
 	for(auto &&it : fleets)
+		allFleets.push_back(&it);
+	const set<string> &deferredFleets = deferred["fleet"];
+	vector<vector<string>> fleetErrors(allFleets.size());
+	ThreadPool::Shared().ForEach(allFleets.size(), [&allFleets, &deferredFleets, &fleetErrors](size_t i)
 	{
+		Files::BeginErrorBuffer();
 		// Plugins may alter stock fleets with new variants that exclusively use plugin ships.
 		// Rather than disable the whole fleet due to these non-instantiable variants, remove them.
-		it.second.RemoveInvalidVariants();
-		if(!it.second.IsValid() && !deferred["fleet"].count(it.first))
-			Warn("fleet", it.first);
-	}
+		Fleet &fleet = allFleets[i]->second;
+		fleet.RemoveInvalidVariants();
+		if(!fleet.IsValid() && !deferredFleets.count(allFleets[i]->first))
+			Warn("fleet", allFleets[i]->first);
+		fleetErrors[i] = Files::EndErrorBuffer();
+	});
+	for(const vector<string> &list : fleetErrors)
+		for(const string &error : list)
+			Files::LogError(error);
 	// Government names are used in mission NPC blocks and LocationFilters.
 	for(auto &&it : governments)
 		if(it.second.GetTrueName().empty() && !NameIfDeferred(deferred["government"], it))
@@ -353,8 +515,10 @@ void GameData::CheckReferences()
 
 
 
-void GameData::LoadShaders(bool useShaderSwizzle)
+void GameData::LoadShaders()
 {
+	Profiler::Scope profile("Compile shaders");
+	Shader::LoadCache(Files::Config() + "shaders.cache");
 	FontSet::Add(Files::Images() + "font/ubuntu14r.png", 14);
 	FontSet::Add(Files::Images() + "font/ubuntu18r.png", 18);
 	
@@ -365,19 +529,34 @@ void GameData::LoadShaders(bool useShaderSwizzle)
 	FillShader::Init();
 	FogShader::Init();
 	LineShader::Init();
+	MapShader::Init();
 	OutlineShader::Init();
 	PointerShader::Init();
 	RingShader::Init();
-	SpriteShader::Init(useShaderSwizzle);
+	SpriteShader::Init();
 	BatchShader::Init();
+	SceneBuffer::Init();
 	
 	background.Init(16384, 4096);
+	Shader::SaveCache();
 }
 
 
 
 double GameData::Progress()
 {
+	// The objects in the sets change as the game is played, because the
+	// originals of any that are changed are kept for reverting them.
+	size_t gameData = colors.MemoryUsage() + conversations.MemoryUsage() + effects.MemoryUsage()
+		+ events.MemoryUsage() + fleets.MemoryUsage() + galaxies.MemoryUsage()
+		+ governments.MemoryUsage() + hazards.MemoryUsage() + interfaces.MemoryUsage()
+		+ minables.MemoryUsage() + missions.MemoryUsage() + outfits.MemoryUsage()
+		+ persons.MemoryUsage() + phrases.MemoryUsage() + planets.MemoryUsage()
+		+ ships.MemoryUsage() + systems.MemoryUsage() + tests.MemoryUsage()
+		+ testDataSets.MemoryUsage() + shipSales.MemoryUsage() + outfitSales.MemoryUsage()
+		+ news.MemoryUsage();
+	MemoryStats::Set(MemoryStats::GAME_DATA, gameData);
+	
 	auto progress = min(spriteQueue.Progress(), Audio::GetProgress());
 	if(progress == 1.)
 	{
@@ -385,11 +564,20 @@ double GameData::Progress()
 		{
 			// Now that we have finished loading all the basic sprites, we can look for invalid file paths,
 			// e.g. due to capitalization errors or other typos. Landscapes are allowed to still be empty.
+			// Look up any named sprites that have not been used yet, so that they are checked too.
+			NamedReference::ResolveAll();
 			auto unloaded = SpriteSet::CheckReferences();
 			for(const auto &path : unloaded)
 				if(path.compare(0, 5, "land/") != 0)
 					Files::LogError("Warning: image \"" + path + "\" is referred to, but has no pixels.");
 			initiallyLoaded = true;
+			
+			// In debug mode, save a timeline of everything that was loaded, and
+			// which thread loaded it, for viewing in a trace viewer.
+			if(Profiler::IsEnabled())
+				Profiler::WriteTrace(Files::Config() + "startup.json");
+			if(printMemory)
+				MemoryStats::Print(cout);
 		}
 	}
 	return progress;
@@ -430,14 +618,13 @@ void GameData::Preload(const Sprite *sprite)
 	// This sprite is not currently preloaded. Check to see whether we already
 	// have the maximum number of sprites loaded, in which case the oldest one
 	// must be unloaded to make room for this one.
-	const string &name = sprite->Name();
 	pit = preloaded.begin();
 	while(pit != preloaded.end())
 	{
 		++pit->second;
 		if(pit->second >= 20)
 		{
-			spriteQueue.Unload(name);
+			spriteQueue.Unload(pit->first->Name());
 			pit = preloaded.erase(pit);
 		}
 		else
@@ -451,6 +638,43 @@ void GameData::Preload(const Sprite *sprite)
 
 
 
+// Show a low resolution version of a deferred sprite until it is loaded.
+void GameData::LoadPreview(const Sprite *sprite)
+{
+	auto it = deferred.find(sprite);
+	if(sprite && it != deferred.end())
+		spriteQueue.Preview(it->second);
+}
+
+
+
+// Keep the sprites that will be needed in the given system loaded.
+void GameData::PreloadSystem(const System *system)
+{
+	if(system != preloadedSystem)
+	{
+		preloadedSystem = system;
+		preloadedSprites.clear();
+		if(system)
+		{
+			for(const System::FleetProbability &fleet : system->Fleets())
+				for(const Ship *ship : fleet.Get()->Ships())
+					preloadedSprites.insert(ship->GetSprite());
+			for(const StellarObject &object : system->Objects())
+				preloadedSprites.insert(object.GetSprite());
+			preloadedSprites.insert(system->Haze());
+			preloadedSprites.erase(nullptr);
+		}
+	}
+	
+	// Any of these sprites that have been unloaded to save memory will be
+	// loaded again the next time the sprite queue is updated.
+	for(const Sprite *sprite : preloadedSprites)
+		sprite->MarkInUse();
+}
+
+
+
 void GameData::FinishLoading()
 {
 	spriteQueue.Finish();
@@ -458,6 +682,102 @@ void GameData::FinishLoading()
 
 
 
+// If the game was started in debug mode, load any data files that have been
+// added or modified since they were last loaded, and reload any images that
+// have changed.
+void GameData::ReloadChanged()
+{
+	if(!isWatchingFiles)
+		return;
+	
+	vector<string> dataPaths;
+	set<string> imageNames;
+	FindChangedFiles(dataPaths, imageNames);
+	
+	// Each file is loaded on top of what is already there, just as a plugin's
+	// definitions are loaded on top of the ones before it. Remember which of
+	// the objects that other objects depend on were defined in these files.
+	set<string> shipNames;
+	set<string> modelNames;
+	set<const Outfit *> outfitsChanged;
+	set<string> personNames;
+	bool systemsChanged = false;
+	for(const string &path : dataPaths)
+	{
+		Files::LogError("Reloading: " + path);
+		DataFile file(path);
+		LoadFile(path, file, true);
+		
+		for(const DataNode &node : file)
+		{
+			if(node.Size() < 2)
+				continue;
+			const string &key = node.Token(0);
+			if(key == "ship")
+			{
+				shipNames.insert(node.Token((node.Size() > 2) ? 2 : 1));
+				modelNames.insert(node.Token(1));
+			}
+			else if(key == "outfit")
+				outfitsChanged.insert(outfits.Get(node.Token(1)));
+			else if(key == "person")
+				personNames.insert(node.Token(1));
+			else if(key == "system")
+				systemsChanged = true;
+		}
+	}
+	
+	if(systemsChanged)
+	{
+		systemsRedefined = true;
+		UpdateSystems();
+	}
+	
+	// Finish loading only the ships that were redefined, the variants of any
+	// ship model that was redefined, and the ships that use a changed outfit.
+	for(auto &it : ships)
+	{
+		Ship &ship = it.second;
+		bool isChanged = shipNames.count(it.first) || modelNames.count(ship.ModelName());
+		for(auto oit = ship.Outfits().begin(); !isChanged && oit != ship.Outfits().end(); ++oit)
+			isChanged = outfitsChanged.count(oit->first);
+		if(isChanged)
+			ship.FinishLoading(true);
+	}
+	for(const string &name : personNames)
+		persons.Get(name)->FinishLoading();
+	if(!dataPaths.empty())
+		for(auto &&it : startConditions)
+			it.FinishLoading();
+	
+	// Reload the changed images. A deferred image is only loaded if it is
+	// currently in use; otherwise it will be loaded when it is next needed.
+	if(imageNames.empty())
+		return;
+	
+	map<string, shared_ptr<ImageSet>> images = FindImages();
+	for(const string &name : imageNames)
+	{
+		auto it = images.find(name);
+		if(it == images.end() || !it->second)
+			continue;
+		
+		Files::LogError("Reloading: " + name);
+		it->second->Check();
+		if(ImageSet::IsDeferred(name))
+		{
+			const Sprite *sprite = SpriteSet::Get(name);
+			deferred[sprite] = it->second;
+			if(preloaded.count(sprite))
+				spriteQueue.Add(it->second);
+		}
+		else
+			spriteQueue.Add(it->second);
+	}
+}
+
+
+
 // Get the list of resource sources (i.e. plugin folders).
 const vector<string> &GameData::Sources()
 {
@@ -469,18 +789,21 @@ const vector<string> &GameData::Sources()
 // Revert any changes that have been made to the universe.
 void GameData::Revert()
 {
-	fleets.Revert(defaultFleets);
-	governments.Revert(defaultGovernments);
-	planets.Revert(defaultPlanets);
-	systems.Revert(defaultSystems);
-	galaxies.Revert(defaultGalaxies);
-	shipSales.Revert(defaultShipSales);
-	outfitSales.Revert(defaultOutfitSales);
+	fleets.Revert();
+	governments.Revert();
+	planets.Revert();
+	systems.Revert();
+	galaxies.Revert();
+	shipSales.Revert();
+	outfitSales.Revert();
 	for(auto &it : persons)
 		it.second.Restore();
+	if(systemsRedefined)
+		UpdateSystems();
 	
 	politics.Reset();
 	purchases.clear();
+	++revision;
 }
 
 
@@ -523,6 +846,7 @@ void GameData::ReadEconomy(const DataNode &node)
 				system.SetSupply(commodity, child.Value(++index));
 		}
 	}
+	PriceTable::Update();
 }
 
 
@@ -572,7 +896,7 @@ void GameData::WriteEconomy(DataWriter &out)
 
 
 
-void GameData::StepEconomy()
+void GameData::StepEconomy(int days)
 {
 	// First, apply any purchases the player made. These are deferred until now
 	// so that prices will not change as you are buying or selling goods.
@@ -584,29 +908,74 @@ void GameData::StepEconomy()
 	}
 	purchases.clear();
 	
-	// Then, have each system generate new goods for local use and trade.
-	for(auto &it : systems)
-		it.second.StepEconomy();
+	// Every system's exports are copied into a table with one row per system
+	// and one column per commodity, so that they need not be looked up by name
+	// once per link. Each system's links are flattened into a list of the rows
+	// to import from, which stays the same for all the days being simulated.
+	const vector<Trade::Commodity> &commodities = trade.Commodities();
+	const size_t columns = commodities.size();
+	map<const System *, size_t> rows;
+	for(const auto &it : systems)
+		rows.emplace(&it.second, rows.size());
+	vector<size_t> linkStart;
+	vector<size_t> linkRows;
+	vector<double> linkScales;
+	for(const auto &it : systems)
+	{
+		linkStart.push_back(linkRows.size());
+		for(const System *neighbor : it.second.Links())
+		{
+			double scale = neighbor->Links().size();
+			auto rit = rows.find(neighbor);
+			if(scale && rit != rows.end())
+			{
+				linkRows.push_back(rit->second);
+				linkScales.push_back(scale);
+			}
+		}
+	}
+	linkStart.push_back(linkRows.size());
 	
-	// Finally, send out the trade goods. This has to be done in a separate step
-	// because otherwise whichever systems trade last would already have gotten
-	// supplied by the other systems.
-	for(auto &it : systems)
+	vector<double> exports(systems.size() * columns);
+	vector<double> supply(columns);
+	for(int day = 0; day < days; ++day)
 	{
-		System &system = it.second;
-		if(!system.Links().empty())
-			for(const Trade::Commodity &commodity : trade.Commodities())
+		// Have each system generate new goods for local use and trade.
+		size_t row = 0;
+		for(auto &it : systems)
+		{
+			it.second.StepEconomy();
+			for(size_t i = 0; i < columns; ++i)
+				exports[row * columns + i] = it.second.Exports(commodities[i].name);
+			++row;
+		}
+		
+		// Then, send out the trade goods. This has to be done in a separate step
+		// because otherwise whichever systems trade last would already have
+		// gotten supplied by the other systems.
+		row = 0;
+		for(auto &it : systems)
+		{
+			System &system = it.second;
+			size_t begin = linkStart[row];
+			size_t end = linkStart[++row];
+			if(system.Links().empty())
+				continue;
+			
+			for(size_t i = 0; i < columns; ++i)
+				supply[i] = system.Supply(commodities[i].name);
+			for(size_t j = begin; j < end; ++j)
 			{
-				double supply = system.Supply(commodity.name);
-				for(const System *neighbor : system.Links())
-				{
-					double scale = neighbor->Links().size();
-					if(scale)
-						supply += neighbor->Exports(commodity.name) / scale;
-				}
-				system.SetSupply(commodity.name, supply);
+				const double *imports = &exports[linkRows[j] * columns];
+				for(size_t i = 0; i < columns; ++i)
+					supply[i] += imports[i] / linkScales[j];
 			}
+			for(size_t i = 0; i < columns; ++i)
+				system.SetSupply(commodities[i].name, supply[i]);
+		}
 	}
+	// Take a snapshot of the new prices for the trading panel and the maps.
+	PriceTable::Update();
 }
 
 
@@ -627,7 +996,10 @@ void GameData::Change(const DataNode &node)
 	else if(node.Token(0) == "galaxy" && node.Size() >= 2)
 		galaxies.Get(node.Token(1))->Load(node);
 	else if(node.Token(0) == "government" && node.Size() >= 2)
+	{
 		governments.Get(node.Token(1))->Load(node);
+		politics.UpdateHostility();
+	}
 	else if(node.Token(0) == "outfitter" && node.Size() >= 2)
 		outfitSales.Get(node.Token(1))->Load(node, outfits);
 	else if(node.Token(0) == "planet" && node.Size() >= 2)
@@ -644,6 +1016,7 @@ void GameData::Change(const DataNode &node)
 		systems.Get(node.Token(1))->Unlink(systems.Get(node.Token(2)));
 	else
 		node.PrintTrace("Invalid \"event\" data:");
+	++revision;
 }
 
 
@@ -652,13 +1025,26 @@ void GameData::Change(const DataNode &node)
 // This must be done any time that a change creates or moves a system.
 void GameData::UpdateSystems()
 {
+	Profiler::Scope profile("Update systems");
+	// Index the systems by position, so that each one can find its neighbors
+	// without checking the distance to every other system.
+	const System::Grid grid(systems);
 	for(auto &it : systems)
 	{
 		// Skip systems that have no name.
 		if(it.first.empty() || it.second.Name().empty())
 			continue;
-		it.second.UpdateSystem(systems, neighborDistances);
+		it.second.UpdateSystem(grid, neighborDistances);
 	}
+	++revision;
+}
+
+
+
+// This number increases every time the universe is changed or reverted.
+uint64_t GameData::Revision()
+{
+	return revision;
 }
 
 
@@ -983,12 +1369,14 @@ const map<string, string> &GameData::PluginAboutText()
 
 void GameData::LoadSources()
 {
+	Profiler::Scope profile("Find sources");
 	sources.clear();
 	sources.push_back(Files::Resources());
 	
 	vector<string> globalPlugins = Files::ListDirectories(Files::Resources() + "plugins/");
 	for(const string &path : globalPlugins)
 	{
+		Files::Mount(path);
 		if(Files::Exists(path + "data") || Files::Exists(path + "images") || Files::Exists(path + "sounds"))
 			sources.push_back(path);
 	}
@@ -996,6 +1384,7 @@ void GameData::LoadSources()
 	vector<string> localPlugins = Files::ListDirectories(Files::Config() + "plugins/");
 	for(const string &path : localPlugins)
 	{
+		Files::Mount(path);
 		if(Files::Exists(path + "data") || Files::Exists(path + "images") || Files::Exists(path + "sounds"))
 			sources.push_back(path);
 	}
@@ -1030,20 +1419,19 @@ void GameData::LoadSources()
 
 
 
-void GameData::LoadFile(const string &path, bool debugMode)
+// Load all the definitions in a data file that has already been parsed.
+void GameData::LoadFile(const string &path, const DataFile &data, bool isReloading)
 {
-	// This is an ordinary file. Check to see if it is an image.
-	if(path.length() < 4 || path.compare(path.length() - 4, 4, ".txt"))
-		return;
-	
-	DataFile data(path);
-	if(debugMode)
-		Files::LogError("Parsing: " + path);
-	
 	for(const DataNode &node : data)
 	{
 		const string &key = node.Token(0);
-		if(key == "color" && node.Size() >= 6)
+		// Each phrase node adds more sentences to the phrase, and each start
+		// node adds a new start or adds to an existing one. The other files
+		// may contribute to the same objects, so they cannot simply be cleared
+		// and reloaded from this file alone.
+		if(isReloading && (key == "phrase" || key == "start"))
+			node.PrintTrace("Skipping reload; restart the game to apply changes to:");
+		else if(key == "color" && node.Size() >= 6)
 			colors.Get(node.Token(1))->Load(
 				node.Value(2), node.Value(3), node.Value(4), node.Value(5));
 		else if(key == "conversation" && node.Size() >= 2)
@@ -1053,11 +1441,11 @@ void GameData::LoadFile(const string &path, bool debugMode)
 		else if(key == "event" && node.Size() >= 2)
 			events.Get(node.Token(1))->Load(node);
 		else if(key == "fleet" && node.Size() >= 2)
-			fleets.Get(node.Token(1))->Load(node);
+			fleets.Redefine(node.Token(1), [&node](Fleet &fleet) { fleet.Load(node); });
 		else if(key == "galaxy" && node.Size() >= 2)
-			galaxies.Get(node.Token(1))->Load(node);
+			galaxies.Redefine(node.Token(1), [&node](Galaxy &galaxy) { galaxy.Load(node); });
 		else if(key == "government" && node.Size() >= 2)
-			governments.Get(node.Token(1))->Load(node);
+			governments.Redefine(node.Token(1), [&node](Government &government) { government.Load(node); });
 		else if(key == "hazard" && node.Size() >= 2)
 			hazards.Get(node.Token(1))->Load(node);
 		else if(key == "interface" && node.Size() >= 2)
@@ -1069,13 +1457,13 @@ void GameData::LoadFile(const string &path, bool debugMode)
 		else if(key == "outfit" && node.Size() >= 2)
 			outfits.Get(node.Token(1))->Load(node);
 		else if(key == "outfitter" && node.Size() >= 2)
-			outfitSales.Get(node.Token(1))->Load(node, outfits);
+			outfitSales.Redefine(node.Token(1), [&node](Sale<Outfit> &sale) { sale.Load(node, outfits); });
 		else if(key == "person" && node.Size() >= 2)
 			persons.Get(node.Token(1))->Load(node);
 		else if(key == "phrase" && node.Size() >= 2)
 			phrases.Get(node.Token(1))->Load(node);
 		else if(key == "planet" && node.Size() >= 2)
-			planets.Get(node.Token(1))->Load(node);
+			planets.Redefine(node.Token(1), [&node](Planet &planet) { planet.Load(node); });
 		else if(key == "ship" && node.Size() >= 2)
 		{
 			// Allow multiple named variants of the same ship model.
@@ -1083,7 +1471,7 @@ void GameData::LoadFile(const string &path, bool debugMode)
 			ships.Get(name)->Load(node);
 		}
 		else if(key == "shipyard" && node.Size() >= 2)
-			shipSales.Get(node.Token(1))->Load(node, ships);
+			shipSales.Redefine(node.Token(1), [&node](Sale<Ship> &sale) { sale.Load(node, ships); });
 		else if(key == "start" && node.HasChildren())
 		{
 			// This node may either declare an immutable starting scenario, or one that is open to extension
@@ -1102,7 +1490,7 @@ void GameData::LoadFile(const string &path, bool debugMode)
 			}
 		}
 		else if(key == "system" && node.Size() >= 2)
-			systems.Get(node.Token(1))->Load(node, planets);
+			systems.Redefine(node.Token(1), [&node](System &system) { system.Load(node, planets); });
 		else if((key == "test") && node.Size() >= 2)
 			tests.Get(node.Token(1))->Load(node);
 		else if((key == "test-data") && node.Size() >= 2)
@@ -1160,16 +1548,23 @@ void GameData::LoadFile(const string &path, bool debugMode)
 
 map<string, shared_ptr<ImageSet>> GameData::FindImages()
 {
+	Profiler::Scope profile("Find images");
+	// Search all the sources at once, but add their images in order so that
+	// the later sources override the earlier ones.
+	vector<vector<string>> imageFiles(sources.size());
+	ThreadPool::Shared().ForEach(sources.size(), [&imageFiles](size_t i)
+	{
+		imageFiles[i] = Files::RecursiveList(sources[i] + "images/");
+	});
+	
 	map<string, shared_ptr<ImageSet>> images;
-	for(const string &source : sources)
+	for(size_t i = 0; i < sources.size(); ++i)
 	{
 		// All names will only include the portion of the path that comes after
 		// this directory prefix.
-		string directoryPath = source + "images/";
-		size_t start = directoryPath.size();
+		size_t start = (sources[i] + "images/").size();
 		
-		vector<string> imageFiles = Files::RecursiveList(directoryPath);
-		for(const string &path : imageFiles)
+		for(const string &path : imageFiles[i])
 			if(ImageSet::IsImage(path))
 			{
 				string name = ImageSet::Name(path.substr(start));
@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Set.h"
 #include "Trade.h"
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -24,6 +25,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 class Color;
 class Conversation;
+class DataFile;
 class DataNode;
 class DataWriter;
 class Date;
@@ -64,7 +66,7 @@ public:
 	static bool BeginLoad(const char * const *argv);
 	// Check for objects that are referred to but never defined.
 	static void CheckReferences();
-	static void LoadShaders(bool useShaderSwizzle);
+	static void LoadShaders();
 	// TODO: make Progress() a simple accessor.
 	static double Progress();
 	// Whether initial game loading is complete (sprites and audio are loaded).
@@ -72,7 +74,18 @@ public:
 	// Begin loading a sprite that was previously deferred. Currently this is
 	// done with all landscapes to speed up the program's startup.
 	static void Preload(const Sprite *sprite);
+	// If a deferred sprite is not loaded yet, show a low resolution version of
+	// it right away, until the full sprite is ready.
+	static void LoadPreview(const Sprite *sprite);
+	// Keep the sprites that will be needed in the given system loaded, so that
+	// they are ready by the time the player arrives there. This must be called
+	// once per frame; passing a null pointer stops preloading.
+	static void PreloadSystem(const System *system);
 	static void FinishLoading();
+	// If the game was started in debug mode, load any data files that have
+	// been added or modified since they were last loaded, and reload any
+	// images that have changed.
+	static void ReloadChanged();
 	
 	// Get the list of resource sources (i.e. plugin folders).
 	static const std::vector<std::string> &Sources();
@@ -83,7 +96,8 @@ public:
 	// Functions for the dynamic economy.
 	static void ReadEconomy(const DataNode &node);
 	static void WriteEconomy(DataWriter &out);
-	static void StepEconomy();
+	// Advance the economy by the given number of days.
+	static void StepEconomy(int days = 1);
 	static void AddPurchase(const System &system, const std::string &commodity, int tons);
 	// Apply the given change to the universe.
 	static void Change(const DataNode &node);
@@ -91,6 +105,9 @@ public:
 	// This must be done any time that a change creates or moves a system.
 	static void UpdateSystems();
 	static void AddJumpRange(double neighborDistance);
+	// This number increases every time the universe is changed or reverted, so
+	// that anything derived from it can tell when it must be recalculated.
+	static uint64_t Revision();
 	
 	// Re-activate any special persons that were created previously but that are
 	// still alive.
@@ -150,7 +167,10 @@ public:
 	
 private:
 	static void LoadSources();
-	static void LoadFile(const std::string &path, bool debugMode);
+	// Load the definitions in a data file. When reloading a file that changed,
+	// definitions that add to what is already loaded instead of replacing it
+	// are skipped, because loading them again would duplicate their contents.
+	static void LoadFile(const std::string &path, const DataFile &data, bool isReloading = false);
 	static std::map<std::string, std::shared_ptr<ImageSet>> FindImages();
 	
 	static void PrintShipTable();
@@ -14,11 +14,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Files.h"
 #include "ImageBuffer.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 
 #include "gl_header.h"
 #include <SDL2/SDL.h>
 
+#include <chrono>
 #include <cstring>
 #include <string>
 #include <sstream>
@@ -30,8 +32,8 @@ namespace {
 	SDL_GLContext context = nullptr;
 	int width = 0;
 	int height = 0;
-	bool hasSwizzle = false;
 	bool supportsAdaptiveVSync = false;
+	chrono::steady_clock::duration swapTime;
 	
 	// Logs SDL errors and returns true if found
 	bool checkSDLerror()
@@ -200,7 +202,6 @@ bool GameWindow::Init()
 	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 	
 	// Check for support of various graphical features.
-	hasSwizzle = HasOpenGLExtension("_texture_swizzle");
 	supportsAdaptiveVSync = HasOpenGLExtension("_swap_control_tear");
 	
 	// Enable the user's preferred VSync state, otherwise update to an available
@@ -246,7 +247,29 @@ void GameWindow::Quit()
 
 void GameWindow::Step()
 {
+	RenderQueue::Flush();
+	
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
 	SDL_GL_SwapWindow(mainWindow);
+	swapTime = chrono::steady_clock::now() - start;
+}
+
+
+
+chrono::steady_clock::duration GameWindow::SwapTime()
+{
+	return swapTime;
+}
+
+
+
+int GameWindow::RefreshRate()
+{
+	SDL_DisplayMode mode;
+	if(!mainWindow || SDL_GetWindowDisplayMode(mainWindow, &mode))
+		return 0;
+	
+	return mode.refresh_rate;
 }
 
 
@@ -396,13 +419,6 @@ void GameWindow::ToggleFullscreen()
 
 
 
-bool GameWindow::HasSwizzle()
-{
-	return hasSwizzle;
-}
-
-
-
 void GameWindow::ExitWithError(const string& message, bool doPopUp)
 {
 	// Print the error message in the terminal and the error file.
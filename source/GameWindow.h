@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Preferences.h"
 
+#include <chrono>
 #include <string>
 
 // This class is a collection of global functions for handling SDL_Windows.
@@ -26,6 +27,11 @@ public:
 	
 	// Paint the next frame in the main window.
 	static void Step();
+	// Get how long the buffer swap at the end of the last frame took. With
+	// VSync on, this includes the time spent waiting for the display.
+	static std::chrono::steady_clock::duration SwapTime();
+	// Get the refresh rate of the display the window is on, or 0 if unknown.
+	static int RefreshRate();
 	
 	// Ensure the proper icon is set on the main window.
 	static void SetIcon();
@@ -44,9 +50,6 @@ public:
 	static bool IsFullscreen();
 	static void ToggleFullscreen();	
 	
-	// Check if the initialized window system supports OpenGL texture_swizzle.
-	static bool HasSwizzle();
-	
 	// Print the error message in the terminal, error file, and message box.
 	// Checks for video system errors and records those as well.
 	static void ExitWithError(const std::string& message, bool doPopUp = true);
@@ -179,6 +179,15 @@ const Color &Government::GetColor() const
 
 
 
+// Get a small number that identifies this government, for use as an index
+// into tables of relationships between governments.
+unsigned Government::ID() const
+{
+	return id;
+}
+
+
+
 // Get the government's initial disposition toward other governments or
 // toward the player.
 double Government::AttitudeToward(const Government *other) const
@@ -54,6 +54,9 @@ public:
 	int GetSwizzle() const;
 	// Get the color to use for displaying this government on the map.
 	const Color &GetColor() const;
+	// Get a small number that identifies this government, for use as an index
+	// into tables of relationships between governments.
+	unsigned ID() const;
 	
 	// Get the government's initial disposition toward other governments or
 	// toward the player.
@@ -0,0 +1,142 @@
+/* GpuProfiler.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "GpuProfiler.h"
+
+#include "gl_header.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+using namespace std;
+
+namespace {
+	// The queries for one frame. Each scope uses two of them, one for when it
+	// starts and one for when it ends.
+	const int MAX_SCOPES = 16;
+	class Frame {
+	public:
+		GLuint queries[2 * MAX_SCOPES] = {};
+		const char *names[MAX_SCOPES] = {};
+		int count = 0;
+	};
+	
+	// Results usually become available one or two frames after they were
+	// asked for, so keep enough frames' queries that the driver never has to
+	// stall to hand one back for reuse.
+	const int FRAMES = 3;
+	Frame frames[FRAMES];
+	int current = 0;
+	bool isSupported = false;
+}
+
+int GpuProfiler::drawCalls = 0;
+int GpuProfiler::textureBinds = 0;
+int GpuProfiler::uploads = 0;
+
+
+
+// Start timing a phase of drawing.
+GpuProfiler::Scope::Scope(const char *name)
+	: index(-1)
+{
+	Frame &frame = frames[current];
+	if(!isSupported || !Profiler::IsEnabled() || frame.count == MAX_SCOPES)
+		return;
+	
+	index = frame.count++;
+	frame.names[index] = name;
+	glQueryCounter(frame.queries[2 * index], GL_TIMESTAMP);
+}
+
+
+
+// Mark the end of this phase. The result is read back in a later frame.
+GpuProfiler::Scope::~Scope()
+{
+	if(index >= 0)
+		glQueryCounter(frames[current].queries[2 * index + 1], GL_TIMESTAMP);
+}
+
+
+
+// Check whether timer queries are supported, and create them if so.
+void GpuProfiler::Init()
+{
+	// Timestamp queries are part of OpenGL 3.3, or available as an extension.
+#ifdef __APPLE__
+	isSupported = true;
+#else
+	isSupported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+#endif
+	// A driver may support the queries but have no timer to back them.
+	if(isSupported)
+	{
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		isSupported = (bits > 0);
+	}
+	if(!isSupported)
+		return;
+	
+	for(Frame &frame : frames)
+		glGenQueries(2 * MAX_SCOPES, frame.queries);
+}
+
+
+
+// Check whether the driver supports timer queries.
+bool GpuProfiler::HasTimers()
+{
+	return isSupported;
+}
+
+
+
+// Pass on any timings that have finished, and this frame's call counts.
+void GpuProfiler::EndFrame()
+{
+	Profiler::SetCounter("GPU draw calls", drawCalls);
+	Profiler::SetCounter("GPU texture binds", textureBinds);
+	Profiler::SetCounter("GPU uploads", uploads);
+	drawCalls = 0;
+	textureBinds = 0;
+	uploads = 0;
+	
+	if(!isSupported)
+		return;
+	
+	// Move on to the oldest frame's queries. If the GPU has finished with them,
+	// report their results. Otherwise, rather than waiting for it, that frame's
+	// timings are dropped.
+	current = (current + 1) % FRAMES;
+	Frame &frame = frames[current];
+	// Scopes may be nested, so the last one to start is not always the last to
+	// end. Check that every scope's end time is ready.
+	bool isReady = true;
+	for(int i = 0; isReady && i < frame.count; ++i)
+	{
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(frame.queries[2 * i + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		isReady = available;
+	}
+	for(int i = 0; isReady && i < frame.count; ++i)
+	{
+		GLuint64 start = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+		if(end > start)
+			Profiler::RecordGpu(frame.names[i], chrono::nanoseconds(end - start));
+	}
+	frame.count = 0;
+}
@@ -0,0 +1,70 @@
+/* GpuProfiler.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef GPU_PROFILER_H_
+#define GPU_PROFILER_H_
+
+
+
+// Class for measuring how long the GPU spends on each part of drawing a frame,
+// and how much work the drawing code is handing to it. The CPU timings from the
+// Profiler only show how long it takes to issue OpenGL commands, not how long
+// they take to run, so each phase is also wrapped in a pair of timestamp
+// queries. Query results are not available until the GPU catches up, so they
+// are collected a couple of frames later and passed on to the Profiler, which
+// shows them alongside everything else. If the driver does not support timer
+// queries, or profiling is turned off, this does nothing.
+class GpuProfiler {
+public:
+	// Time the drawing commands issued from when this object is created until
+	// it goes out of scope. The name must be a string literal.
+	class Scope {
+	public:
+		explicit Scope(const char *name);
+		~Scope();
+		
+		Scope(const Scope &other) = delete;
+		Scope &operator=(const Scope &other) = delete;
+		
+	private:
+		int index;
+	};
+	
+	
+public:
+	// Check whether timer queries are supported, and create them if so. This
+	// must be called once the OpenGL context has been created.
+	static void Init();
+	// Call this once each frame is done drawing, to pass on any timings that
+	// have finished and the number of calls made to OpenGL in that frame.
+	static void EndFrame();
+	// Check whether the driver supports timer queries. This is only known once
+	// Init() has been called.
+	static bool HasTimers();
+	
+	// Count the draw calls, texture binds, and uploads of vertex or texture
+	// data that each frame makes. These are cheap enough to call whether or
+	// not profiling is turned on.
+	static void CountDraw() { ++drawCalls; }
+	static void CountBind() { ++textureBinds; }
+	static void CountUpload() { ++uploads; }
+	
+	
+private:
+	static int drawCalls;
+	static int textureBinds;
+	static int uploads;
+};
+
+
+
+#endif
@@ -156,6 +156,16 @@ bool Hardpoint::WasFiring() const
 
 
 
+// Check if this weapon is fully reloaded and has stopped firing, so that
+// stepping it would not change anything.
+bool Hardpoint::IsIdle() const
+{
+	return !outfit || (reload <= 0. && burstReload <= 0. && !isFiring && !wasFiring
+		&& burstCount == outfit->BurstCount());
+}
+
+
+
 // Get the number of remaining burst shots before a full reload is required.
 int Hardpoint::BurstRemaining() const
 {
@@ -55,6 +55,9 @@ public:
 	bool IsReady() const;
 	// Check if this weapon was firing in the previous step.
 	bool WasFiring() const;
+	// Check if this weapon is fully reloaded and has stopped firing, so that
+	// stepping it would not change anything.
+	bool IsIdle() const;
 	// If this is a burst weapon, get the number of shots left in the burst.
 	int BurstRemaining() const;
 	// Perform one step (i.e. decrement the reload count).
@@ -12,20 +12,38 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "ImageBuffer.h"
 
-#include "File.h"
+#include "MappedFile.h"
+#include "MemoryStats.h"
 
 #include <png.h>
 #include <jpeglib.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 using namespace std;
 
 namespace {
+	// The contents of a PNG file, and how much of them libpng has read so far.
+	class PngInput {
+	public:
+		const MappedFile &file;
+		size_t pos;
+	};
+	void ReadPngData(png_struct *png, png_byte *data, png_size_t length);
+	
 	bool ReadPNG(const string &path, ImageBuffer &buffer, int frame);
-	bool ReadJPG(const string &path, ImageBuffer &buffer, int frame);
-	void Premultiply(ImageBuffer &buffer, int frame, int additive);
+	bool ReadJPG(const string &path, ImageBuffer &buffer, int frame, int reduction);
+	template <int additive>
+	void PremultiplyLine(unsigned char *it, unsigned char *end);
+	void ShrinkLine(const unsigned char *a, const unsigned char *b, unsigned char *out, unsigned char *end);
 }
 
 
@@ -47,8 +65,12 @@ ImageBuffer::~ImageBuffer()
 // Set the number of frames. This must be called before allocating.
 void ImageBuffer::Clear(int frames)
 {
+	if(pixels)
+		MemoryStats::Add(MemoryStats::IMAGE_BUFFERS, -4 * static_cast<int64_t>(width) * height * this->frames);
 	delete [] pixels;
 	pixels = nullptr;
+	delete halfSize;
+	halfSize = nullptr;
 	this->frames = frames;
 }
 
@@ -66,6 +88,7 @@ void ImageBuffer::Allocate(int width, int height)
 	this->width = width;
 	this->height = height;
 	pixels = new uint32_t[width * height * frames];
+	MemoryStats::Add(MemoryStats::IMAGE_BUFFERS, 4 * static_cast<int64_t>(width) * height * frames);
 }
 
 
@@ -119,34 +142,84 @@ uint32_t *ImageBuffer::Begin(int y, int frame)
 
 
 
+// Replace the image with one half its size. If PrepareMipmaps() already made
+// that smaller image, this just switches to it.
 void ImageBuffer::ShrinkToHalfSize()
 {
-	ImageBuffer result(frames);
+	if(!halfSize)
+	{
+		halfSize = new ImageBuffer(frames);
+		Shrink(*halfSize);
+	}
+	ImageBuffer *result = halfSize;
+	halfSize = result->halfSize;
+	result->halfSize = nullptr;
+	
+	swap(width, result->width);
+	swap(height, result->height);
+	swap(pixels, result->pixels);
+	delete result;
+}
+
+
+
+// Make each smaller size of the image that ShrinkToHalfSize() would be asked
+// for when the image is uploaded as a mipmapped texture. Sprite textures have
+// mipmap levels down to where either dimension is less than 8 pixels.
+void ImageBuffer::PrepareMipmaps()
+{
+	if(!pixels)
+		return;
+	
+	for(ImageBuffer *level = this; level->width >= 8 && level->height >= 8; level = level->halfSize)
+		if(!level->halfSize)
+		{
+			level->halfSize = new ImageBuffer(frames);
+			level->Shrink(*level->halfSize);
+		}
+}
+
+
+
+// Fill in the given buffer with this image at half its size.
+void ImageBuffer::Shrink(ImageBuffer &result) const
+{
 	result.Allocate(width / 2, height / 2);
 	
-	unsigned char *begin = reinterpret_cast<unsigned char *>(pixels);
 	unsigned char *out = reinterpret_cast<unsigned char *>(result.pixels);
-	// Loop through every line of every frame of the buffer.
-	for(int y = 0; y < result.height * frames; ++y)
-	{
-		unsigned char *aIt = begin + (4 * width) * (2 * y);
-		unsigned char *aEnd = aIt + 4 * 2 * result.width;
-		unsigned char *bIt = begin + (4 * width) * (2 * y + 1);
-		for( ; aIt != aEnd; aIt += 4, bIt += 4)
+	// Loop through every line of every frame of the buffer. If the height is
+	// odd, the last line of each frame is dropped.
+	for(int frame = 0; frame < frames; ++frame)
+		for(int y = 0; y < result.height; ++y)
 		{
-			for(int channel = 0; channel < 4; ++channel, ++aIt, ++bIt, ++out)
-				*out = (static_cast<unsigned>(aIt[0]) + static_cast<unsigned>(bIt[0])
-					+ static_cast<unsigned>(aIt[4]) + static_cast<unsigned>(bIt[4]) + 2) / 4;
+			unsigned char *end = out + 4 * result.width;
+			ShrinkLine(reinterpret_cast<const unsigned char *>(Begin(2 * y, frame)),
+				reinterpret_cast<const unsigned char *>(Begin(2 * y + 1, frame)), out, end);
+			out = end;
 		}
+}
+
+
+
+// Convert the given frame to premultiplied alpha.
+void ImageBuffer::Premultiply(int frame, int additive)
+{
+	for(int y = 0; y < height; ++y)
+	{
+		unsigned char *it = reinterpret_cast<unsigned char *>(Begin(y, frame));
+		unsigned char *end = it + 4 * width;
+		if(additive == 2)
+			PremultiplyLine<2>(it, end);
+		else if(additive == 1)
+			PremultiplyLine<1>(it, end);
+		else
+			PremultiplyLine<0>(it, end);
 	}
-	swap(width, result.width);
-	swap(height, result.height);
-	swap(pixels, result.pixels);
 }
 
 
 
-bool ImageBuffer::Read(const string &path, int frame)
+bool ImageBuffer::Read(const string &path, int frame, int reduction)
 {
 	// First, make sure this is a JPG or PNG file.
 	if(path.length() < 4)
@@ -157,10 +230,14 @@ bool ImageBuffer::Read(const string &path, int frame)
 	bool isJPG = (extension == ".jpg" || extension == ".JPG");
 	if(!isPNG && !isJPG)
 		return false;
+	// The JPG decoder can skip most of its work to produce a smaller image,
+	// but the PNG decoder cannot.
+	if(isPNG && reduction != 1)
+		return false;
 	
 	if(isPNG && !ReadPNG(path, *this, frame))
 		return false;
-	if(isJPG && !ReadJPG(path, *this, frame))
+	if(isJPG && !ReadJPG(path, *this, frame, reduction))
 		return false;
 	
 	// Check if the sprite uses additive blending. Start by getting the index of
@@ -177,7 +254,7 @@ bool ImageBuffer::Read(const string &path, int frame)
 	{
 		int additive = (path[pos] == '+') ? 2 : (path[pos] == '~') ? 1 : 0;
 		if(isPNG || (isJPG && additive == 2))
-			Premultiply(*this, frame, additive);
+			Premultiply(frame, additive);
 	}
 	return true;
 }
@@ -187,9 +264,9 @@ bool ImageBuffer::Read(const string &path, int frame)
 namespace {
 	bool ReadPNG(const string &path, ImageBuffer &buffer, int frame)
 	{
-		// Open the file, and make sure it really is a PNG.
-		File file(path);
-		if(!file)
+		// Map the file. The image is decoded straight from the mapped memory.
+		MappedFile file(path);
+		if(file.IsEmpty())
 			return false;
 		
 		// Set up libpng.
@@ -210,7 +287,8 @@ namespace {
 			return false;
 		}
 		
-		png_init_io(png, file);
+		PngInput input = {file, 0};
+		png_set_read_fn(png, &input, ReadPngData);
 		png_set_sig_bytes(png, 0);
 		
 		png_read_info(png, info);
@@ -258,10 +336,24 @@ namespace {
 	
 	
 	
-	bool ReadJPG(const string &path, ImageBuffer &buffer, int frame)
+	// Let libpng read the next part of a PNG file from memory.
+	void ReadPngData(png_struct *png, png_byte *data, png_size_t length)
 	{
-		File file(path);
-		if(!file)
+		PngInput &input = *static_cast<PngInput *>(png_get_io_ptr(png));
+		if(length > input.file.Size() - input.pos)
+			png_error(png, "Unexpected end of file.");
+		
+		const char *begin = input.file.Data() + input.pos;
+		copy(begin, begin + length, reinterpret_cast<char *>(data));
+		input.pos += length;
+	}
+	
+	
+	
+	bool ReadJPG(const string &path, ImageBuffer &buffer, int frame, int reduction)
+	{
+		MappedFile file(path);
+		if(file.IsEmpty())
 			return false;
 		
 		jpeg_decompress_struct cinfo;
@@ -272,13 +364,17 @@ namespace {
 		jpeg_create_decompress(&cinfo);
 #pragma GCC diagnostic pop
 		
-		jpeg_stdio_src(&cinfo, file);
+		// Older versions of libjpeg take a non-const pointer to the input, even
+		// though they never modify it.
+		jpeg_mem_src(&cinfo, reinterpret_cast<unsigned char *>(const_cast<char *>(file.Data())), file.Size());
 		jpeg_read_header(&cinfo, true);
 		cinfo.out_color_space = JCS_EXT_BGRA;
+		cinfo.scale_num = 1;
+		cinfo.scale_denom = reduction;
 		
 		jpeg_start_decompress(&cinfo);
-		int width = cinfo.image_width;
-		int height = cinfo.image_height;
+		int width = cinfo.output_width;
+		int height = cinfo.output_height;
 		// If the buffer is not yet allocated, allocate it.
 		buffer.Allocate(width, height);
 		// Make sure this frame's dimensions are valid.
@@ -305,29 +401,116 @@ namespace {
 	
 	
 	
-	void Premultiply(ImageBuffer &buffer, int frame, int additive)
+#ifdef __SSE2__
+	// Premultiply two pixels whose channels have been widened to 16 bits, so
+	// that the products fit.
+	template <int additive>
+	__m128i PremultiplyPixels(__m128i color)
 	{
-		for(int y = 0; y < buffer.Height(); ++y)
+		// Copy each pixel's alpha into all four of its channels.
+		__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i value = _mm_mullo_epi16(color, alpha);
+		value = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), _mm_set1_epi16(1)), 8);
+		
+		// Put the new alpha value in place of the product of alpha with itself.
+		const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+		__m128i newAlpha = (additive == 2) ? _mm_setzero_si128() : (additive == 1) ? _mm_srli_epi16(alpha, 2) : alpha;
+		return _mm_or_si128(_mm_andnot_si128(alphaMask, value), _mm_and_si128(alphaMask, newAlpha));
+	}
+	
+	
+	
+	// Average each 2x2 block of the given pixels from two lines, producing two
+	// pixels whose channels are 16 bits wide.
+	__m128i ShrinkPixels(__m128i a, __m128i b)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		// Add the two lines together, then add each pair of neighboring pixels.
+		__m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		__m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+		return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+	}
+#endif
+	
+	
+	
+	// Premultiply one line of pixels. The division by 255 is done with shifts,
+	// and the result is the same as rounding c * a / 255 down. Where vector
+	// instructions are available, most of the line is done with those, and
+	// the scalar loop only handles what is left over.
+	template <int additive>
+	void PremultiplyLine(unsigned char *it, unsigned char *end)
+	{
+#ifdef __SSE2__
+		const __m128i zero = _mm_setzero_si128();
+		for( ; end - it >= 16; it += 16)
 		{
-			uint32_t *it = buffer.Begin(y, frame);
-			
-			for(uint32_t *end = it + buffer.Width(); it != end; ++it)
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(it));
+			__m128i low = PremultiplyPixels<additive>(_mm_unpacklo_epi8(pixels, zero));
+			__m128i high = PremultiplyPixels<additive>(_mm_unpackhi_epi8(pixels, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(it), _mm_packus_epi16(low, high));
+		}
+#elif defined(__ARM_NEON)
+		// Load eight pixels with each of their channels in a separate vector.
+		for( ; end - it >= 32; it += 32)
+		{
+			uint8x8x4_t pixels = vld4_u8(it);
+			uint8x8_t alpha = pixels.val[3];
+			for(int channel = 0; channel < 3; ++channel)
 			{
-				uint64_t value = *it;
-				uint64_t alpha = (value & 0xFF000000) >> 24;
-				
-				uint64_t red = (((value & 0xFF0000) * alpha) / 255) & 0xFF0000;
-				uint64_t green = (((value & 0xFF00) * alpha) / 255) & 0xFF00;
-				uint64_t blue = (((value & 0xFF) * alpha) / 255) & 0xFF;
-				
-				value = red | green | blue;
-				if(additive == 1)
-					alpha >>= 2;
-				if(additive != 2)
-					value |= (alpha << 24);
-				
-				*it = static_cast<uint32_t>(value);
+				uint16x8_t value = vmull_u8(pixels.val[channel], alpha);
+				value = vaddq_u16(vaddq_u16(value, vshrq_n_u16(value, 8)), vdupq_n_u16(1));
+				pixels.val[channel] = vshrn_n_u16(value, 8);
 			}
+			pixels.val[3] = (additive == 2) ? vdup_n_u8(0) : (additive == 1) ? vshr_n_u8(alpha, 2) : alpha;
+			vst4_u8(it, pixels);
+		}
+#endif
+		for( ; it != end; it += 4)
+		{
+			unsigned alpha = it[3];
+			for(int channel = 0; channel < 3; ++channel)
+			{
+				unsigned value = it[channel] * alpha;
+				it[channel] = (value + (value >> 8) + 1) >> 8;
+			}
+			it[3] = (additive == 2) ? 0 : (additive == 1) ? (alpha >> 2) : alpha;
+		}
+	}
+	
+	
+	
+	// Fill in one line of a half size image, from the two lines of the full
+	// size image that it covers. Each channel of each pixel is the rounded
+	// average of that channel in the 2x2 block of pixels it replaces.
+	void ShrinkLine(const unsigned char *a, const unsigned char *b, unsigned char *out, unsigned char *end)
+	{
+#ifdef __SSE2__
+		for( ; end - out >= 16; out += 16, a += 32, b += 32)
+		{
+			__m128i first = ShrinkPixels(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+			__m128i second = ShrinkPixels(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 16)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 16)));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(first, second));
+		}
+#elif defined(__ARM_NEON)
+		// Load sixteen pixels from each line, with each of their channels in a
+		// separate vector, and add up each pair of neighbors.
+		for( ; end - out >= 32; out += 32, a += 64, b += 64)
+		{
+			uint8x16x4_t aPixels = vld4q_u8(a);
+			uint8x16x4_t bPixels = vld4q_u8(b);
+			uint8x8x4_t result;
+			for(int channel = 0; channel < 4; ++channel)
+				result.val[channel] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(aPixels.val[channel]), bPixels.val[channel]), 2);
+			vst4_u8(out, result);
 		}
+#endif
+		for( ; out != end; a += 4, b += 4)
+			for(int channel = 0; channel < 4; ++channel, ++a, ++b, ++out)
+				*out = (static_cast<unsigned>(a[0]) + static_cast<unsigned>(b[0])
+					+ static_cast<unsigned>(a[4]) + static_cast<unsigned>(b[4]) + 2) / 4;
 	}
 }
@@ -49,11 +49,28 @@ public:
 	const uint32_t *Begin(int y, int frame = 0) const;
 	uint32_t *Begin(int y, int frame = 0);
 	
+	// Replace the image with one half its size. If PrepareMipmaps() already
+	// made that smaller image, this just switches to it.
 	void ShrinkToHalfSize();
+	// Make each smaller size of the image that ShrinkToHalfSize() would be
+	// asked for when the image is uploaded as a mipmapped texture, so that this
+	// work can be done in a worker thread instead of the one that uploads it.
+	void PrepareMipmaps();
+	
+	// Convert the given frame to premultiplied alpha. If "additive" is 1, the
+	// frame is made half-additive, and if it is 2, fully additive.
+	void Premultiply(int frame, int additive = 0);
 	
 	// Read a single frame. Return false if an error is encountered - either the
-	// image is the wrong size, or it is not a supported image format.
-	bool Read(const std::string &path, int frame = 0);
+	// image is the wrong size, or it is not a supported image format. If a
+	// reduction of 2, 4, or 8 is given, the image is decoded at that fraction
+	// of its size, which is much faster. Only JPG images can be reduced.
+	bool Read(const std::string &path, int frame = 0, int reduction = 1);
+	
+	
+private:
+	// Fill in the given buffer with this image at half its size.
+	void Shrink(ImageBuffer &result) const;
 	
 	
 private:
@@ -61,6 +78,8 @@ private:
 	int height;
 	int frames;
 	uint32_t *pixels;
+	// The image at half this size, if it was prepared ahead of time.
+	ImageBuffer *halfSize = nullptr;
 };
 
 
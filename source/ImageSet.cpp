@@ -14,6 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Files.h"
 #include "Mask.h"
+#include "MaskCache.h"
 #include "Sprite.h"
 
 #include <algorithm>
@@ -22,6 +23,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
+	// Previews of sprites are decoded at this fraction of their full size.
+	const int PREVIEW_REDUCTION = 8;
+	
 	// Check if the given character is a valid blending mode.
 	bool IsBlend(char c)
 	{
@@ -200,10 +204,21 @@ void ImageSet::Check() const
 
 
 
-// Load all the frames. This should be called in one of the image-loading
-// worker threads. This also generates collision masks if needed.
-void ImageSet::Load()
+// Get the number of frames in this sprite. The number of 1x frames is
+// definitive.
+size_t ImageSet::Frames() const
+{
+	return paths[0].size();
+}
+
+
+
+// Load the first frame of each resolution. This also sets the number of frames
+// in the image buffers and the mask vector.
+bool ImageSet::LoadFirst(MaskCache *cache, bool read2x)
 {
+	this->read2x = read2x;
+	
 	// Determine how many frames there will be, total. The image buffers will
 	// not actually be allocated until the first image is loaded (at which point
 	// the sprite's dimensions will be known).
@@ -212,19 +227,45 @@ void ImageSet::Load()
 	buffer[1].Clear(frames);
 	
 	// Check whether we need to generate collision masks.
-	bool makeMasks = IsMasked(name);
-	if(makeMasks)
+	if(IsMasked(name) && !skipMasks)
 		masks.resize(frames);
 	
-	// Load the 1x sprites first, then the 2x sprites, because they are likely
-	// to be in separate locations on the disk. Create masks if needed.
-	for(size_t i = 0; i < frames; ++i)
-		if(buffer[0].Read(paths[0][i], i) && makeMasks)
-			masks[i].Create(buffer[0], i);
-	// Now, load the 2x sprites, if they exist. Because the number of 1x frames
-	// is definitive, don't load any frames beyond the size of the 1x list.
-	for(size_t i = 0; i < frames && i < paths[1].size(); ++i)
-		buffer[1].Read(paths[1][i], i);
+	if(!frames)
+		return true;
+	LoadFrame(0, cache);
+	
+	// If a first frame is missing, whichever frame is read first will allocate
+	// the buffer, so the frames cannot be read at the same time.
+	return buffer[0].Pixels() && (!read2x || paths[1].size() < 2 || buffer[1].Pixels());
+}
+
+
+
+// Load the given frame of each resolution. Each frame is stored in a separate
+// part of the image buffers, so different threads can load different frames.
+void ImageSet::LoadFrame(size_t frame, MaskCache *cache)
+{
+	if(buffer[0].Read(paths[0][frame], frame) && !masks.empty())
+	{
+		if(cache)
+			cache->Load(paths[0][frame], buffer[0], frame, masks[frame]);
+		else
+			masks[frame].Create(buffer[0], frame);
+	}
+	// Because the number of 1x frames is definitive, don't load any frames
+	// beyond the size of the 1x list.
+	if(read2x && frame < paths[1].size())
+		buffer[1].Read(paths[1][frame], frame);
+}
+
+
+
+// Once all the frames are loaded, make the smaller versions of them that the
+// textures' mipmap levels need.
+void ImageSet::PrepareMipmaps()
+{
+	buffer[0].PrepareMipmaps();
+	buffer[1].PrepareMipmaps();
 }
 
 
@@ -232,10 +273,54 @@ void ImageSet::Load()
 // Create the sprite and upload the image data to the GPU. After this is
 // called, the internal image buffers and mask vector will be cleared, but
 // the paths are saved in case the sprite needs to be loaded again.
-void ImageSet::Upload(Sprite *sprite)
+void ImageSet::Upload(Sprite *sprite, bool uploadTextures, bool isHighResolution)
+{
+	// Load the frames. This will clear the buffers and the mask vector. The
+	// 1x frames still set the sprite's size even if they are not uploaded.
+	bool use2x = uploadTextures && isHighResolution && buffer[1].Pixels();
+	sprite->AddFrames(buffer[0], false, uploadTextures && !use2x);
+	sprite->AddFrames(buffer[1], true, use2x);
+	if(uploadTextures)
+		sprite->UnloadTexture(!use2x);
+	if(!skipMasks)
+		sprite->AddMasks(masks);
+	skipMasks = false;
+}
+
+
+
+// Read a low resolution version of the first frame and upload it. JPG images
+// can be decoded at an eighth of their size, which only takes a fraction of
+// the time. Other images have to be read at their full size.
+void ImageSet::UploadPreview(Sprite *sprite) const
+{
+	if(paths[0].empty())
+		return;
+	
+	ImageBuffer preview;
+	int reduction = PREVIEW_REDUCTION;
+	if(!preview.Read(paths[0][0], 0, reduction))
+	{
+		reduction = 1;
+		if(!preview.Read(paths[0][0]))
+			return;
+	}
+	sprite->AddPreview(preview, reduction);
+}
+
+
+
+// Check whether this set has any @2x images.
+bool ImageSet::Has2x() const
+{
+	return !paths[1].empty();
+}
+
+
+
+// Only reload the images, not the collision masks, the next time this set is
+// loaded.
+void ImageSet::SkipMasks()
 {
-	// Load the frames. This will clear the buffers and the mask vector.
-	sprite->AddFrames(buffer[0], false);
-	sprite->AddFrames(buffer[1], true);
-	sprite->AddMasks(masks);
+	skipMasks = true;
 }
@@ -19,6 +19,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <vector>
 
 class Mask;
+class MaskCache;
 class Sprite;
 
 
@@ -58,13 +59,41 @@ public:
 	// Check this image set to determine whether any frames are missing. Report
 	// an error for each missing frame. (It will be left uninitialized.)
 	void Check() const;
-	// Load all the frames. This should be called in one of the image-loading
-	// worker threads. This also generates collision masks if needed.
-	void Load();
+	// Get the number of frames in this sprite.
+	size_t Frames() const;
+	// Load the first frame of each resolution, which determines the size of
+	// the image buffers. This should be called in one of the image-loading
+	// worker threads. This also generates collision masks if needed. If this
+	// returns true, the rest of the frames can then be loaded by different
+	// threads at once; otherwise they must be loaded one at a time.
+	// If a mask cache is given, the masks are loaded from it when possible.
+	// The @2x images are only read if the screen might need them. The 1x
+	// images are always read, because they determine the sprite's size and
+	// its collision masks.
+	bool LoadFirst(MaskCache *cache = nullptr, bool read2x = true);
+	// Load the given frame of each resolution, and its collision mask.
+	void LoadFrame(size_t frame, MaskCache *cache = nullptr);
+	// Once all the frames are loaded, make the smaller versions of them that
+	// the textures' mipmap levels need. This should also be called in one of
+	// the worker threads, so that uploading the textures is faster.
+	void PrepareMipmaps();
 	// Create the sprite and upload the image data to the GPU. After this is
 	// called, the internal image buffers and mask vector will be cleared, but
-	// the paths are saved in case the sprite needs to be loaded again.
-	void Upload(Sprite *sprite);
+	// the paths are saved in case the sprite needs to be loaded again. If
+	// there is no OpenGL context, only the sizes and collision masks are set.
+	// Only the texture for the screen's current resolution is uploaded, and
+	// the sprite's texture for the other one is freed.
+	void Upload(Sprite *sprite, bool uploadTextures = true, bool isHighResolution = false);
+	// Read a low resolution version of the first frame and upload it to the
+	// given sprite, so that there is something to draw until the full images
+	// are loaded. This is fast enough to do in the main thread.
+	void UploadPreview(Sprite *sprite) const;
+	// Check whether this set has any @2x images.
+	bool Has2x() const;
+	// Only reload the images, not the collision masks, the next time this set
+	// is loaded. This is for sprites whose textures were freed to save memory,
+	// but which still have their masks.
+	void SkipMasks();
 	
 	
 private:
@@ -75,6 +104,8 @@ private:
 	// Data loaded from the images:
 	ImageBuffer buffer[2];
 	std::vector<Mask> masks;
+	bool skipMasks = false;
+	bool read2x = true;
 };
 
 
@@ -55,6 +55,13 @@ namespace {
 		}
 		return alignment;
 	}
+	
+	// Split a leading "!" off of a condition, recording that it is negated.
+	void ParseCondition(const string &condition, string &name, bool &isNegated)
+	{
+		isNegated = (!condition.empty() && condition.front() == '!');
+		name = isNegated ? condition.substr(1) : condition;
+	}
 }
 
 
@@ -298,13 +305,13 @@ void Interface::Element::Load(const DataNode &node, const Point &globalAnchor)
 // button, it will add a clickable zone to the given panel.
 void Interface::Element::Draw(const Information &info, Panel *panel) const
 {
-	if(!info.HasCondition(visibleIf))
+	if(info.HasCondition(visibleIf) == isVisibleIfNot)
 		return;
 	
 	// Get the bounding box of this element, relative to the anchor point.
 	Rectangle box = Bounds();
 	// Check if this element is active.
-	int state = info.HasCondition(activeIf);
+	int state = (info.HasCondition(activeIf) != isActiveIfNot);
 	// Check if the mouse is hovering over this element.
 	state += (state && box.Contains(UI::GetMouse()));
 	// Place buttons even if they are inactive, in case the UI wants to show a
@@ -326,8 +333,8 @@ void Interface::Element::Draw(const Information &info, Panel *panel) const
 // An empty string means it is always visible or active.
 void Interface::Element::SetConditions(const string &visible, const string &active)
 {
-	visibleIf = visible;
-	activeIf = active;
+	ParseCondition(visible, visibleIf, isVisibleIfNot);
+	ParseCondition(active, activeIf, isActiveIfNot);
 }
 
 
@@ -556,8 +563,15 @@ bool Interface::TextElement::ParseLine(const DataNode &node)
 Point Interface::TextElement::NativeDimensions(const Information &info, int state) const
 {
 	const Font &font = FontSet::Get(fontSize);
-	const auto layout = Layout(static_cast<int>(Bounds().Width() - padding.X()), truncate);
-	return Point(font.FormattedWidth({GetString(info), layout}), font.Height());
+	const string &text = GetString(info);
+	int space = static_cast<int>(Bounds().Width() - padding.X());
+	if(space != measuredSpace || text != measuredText)
+	{
+		measuredText = text;
+		measuredSpace = space;
+		measuredWidth = font.FormattedWidth({text, Layout(space, truncate)});
+	}
+	return Point(measuredWidth, font.Height());
 }
 
 
@@ -585,7 +599,7 @@ void Interface::TextElement::Place(const Rectangle &bounds, Panel *panel) const
 
 
 
-string Interface::TextElement::GetString(const Information &info) const
+const string &Interface::TextElement::GetString(const Information &info) const
 {
 	return isDynamic ? info.GetString(str) : str;
 }
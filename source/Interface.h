@@ -109,8 +109,13 @@ private:
 		AnchoredPoint to;
 		Point alignment;
 		Point padding;
+		// The conditions that control when this element is visible and active.
+		// Any leading "!" is stripped off when they are set, so that it does not
+		// have to be checked for each time this element is drawn.
 		std::string visibleIf;
 		std::string activeIf;
+		bool isVisibleIfNot = false;
+		bool isActiveIfNot = false;
 	};
 	
 	// This class handles "sprite", "image", and "outline" elements.
@@ -160,11 +165,16 @@ private:
 		virtual void Place(const Rectangle &bounds, Panel *panel) const override;
 		
 	private:
-		std::string GetString(const Information &info) const;
+		const std::string &GetString(const Information &info) const;
 	
 	private:
 		// The string may either be a name of a dynamic string, or static text.
 		std::string str;
+		// Measuring the text is the slowest part of drawing it, so the width is
+		// only measured again if the text or the space it has changes.
+		mutable std::string measuredText;
+		mutable int measuredSpace = -1;
+		mutable int measuredWidth = 0;
 		// Color for inactive, active, and hover states.
 		const Color *color[3] = {nullptr, nullptr, nullptr};
 		int fontSize = 14;
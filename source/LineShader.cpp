@@ -13,24 +13,65 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "LineShader.h"
 
 #include "Color.h"
+#include "GpuProfiler.h"
 #include "Point.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint startI;
-	GLint lengthI;
-	GLint widthI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each vertex has its position (x, y) in pixels, its coordinates along and
+	// across the line (for anti-aliasing), the line's length, and its color.
+	constexpr int FLOATS_PER_VERTEX = 9;
+	// Each line is drawn as two triangles. The x coordinate is the fraction of
+	// the length, and y is the offset across the width.
+	const float CORNERS[] = {
+		0.f, -1.f,
+		1.f, -1.f,
+		0.f,  1.f,
+		0.f,  1.f,
+		1.f, -1.f,
+		1.f,  1.f
+	};
+	
+	// Lines that are drawn one after another are collected here, so they can
+	// all be drawn with a single draw call.
+	vector<float> vertices;
+	
+	// Draw all the lines that have been added since the last time.
+	void Flush()
+	{
+		if(vertices.empty())
+			return;
+		
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+		GpuProfiler::CountUpload();
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+		GpuProfiler::CountDraw();
+		vertices.clear();
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+	}
 }
 
 
@@ -40,57 +81,56 @@ void LineShader::Init()
 	static const char *vertexCode =
 		"// vertex line shader\n"
 		"uniform vec2 scale;\n"
-		"uniform vec2 start;\n"
-		"uniform vec2 len;\n"
-		"uniform vec2 width;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 corner;\n"
+		"in float len;\n"
+		"in vec4 color;\n"
 		"out vec2 tpos;\n"
 		"out float tscale;\n"
+		"out vec4 fragColor;\n"
 		
 		"void main() {\n"
-		"  tpos = vert;\n"
-		"  tscale = length(len);\n"
-		"  gl_Position = vec4((start + vert.x * len + vert.y * width) * scale, 0, 1);\n"
+		"  tpos = corner;\n"
+		"  tscale = len;\n"
+		"  fragColor = color;\n"
+		"  gl_Position = vec4(vert * scale, 0, 1);\n"
 		"}\n";
 
 	static const char *fragmentCode =
 		"// fragment line shader\n"
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		
 		"in vec2 tpos;\n"
 		"in float tscale;\n"
+		"in vec4 fragColor;\n"
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
 		"  float alpha = min(tscale - abs(tpos.x * (2 * tscale) - tscale), 1 - abs(tpos.y));\n"
-		"  finalColor = color * alpha;\n"
+		"  finalColor = fragColor * alpha;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	startI = shader.Uniform("start");
-	lengthI = shader.Uniform("len");
-	widthI = shader.Uniform("width");
-	colorI = shader.Uniform("color");
 	
-	// Generate the vertex data for drawing sprites.
+	// Generate the buffer for uploading the batched vertex data.
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		0.f, -1.f,
-		1.f, -1.f,
-		0.f,  1.f,
-		1.f,  1.f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	// Enable each of the vertex attributes, at its offset within the vertex.
+	struct Attribute { const char *name; int size; };
+	static const Attribute ATTRIBUTES[] = {{"vert", 2}, {"corner", 2}, {"len", 1}, {"color", 4}};
+	int offset = 0;
+	for(const Attribute &attribute : ATTRIBUTES)
+	{
+		GLint index = shader.Attrib(attribute.name);
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, attribute.size, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(GLfloat),
+			reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+		offset += attribute.size;
+	}
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -104,27 +144,22 @@ void LineShader::Draw(const Point &from, const Point &to, float width, const Col
 	if(!shader.Object())
 		throw runtime_error("LineShader: Draw() called before Init().");
 	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
-	
-	GLfloat start[2] = {static_cast<float>(from.X()), static_cast<float>(from.Y())};
-	glUniform2fv(startI, 1, start);
+	// The line is not drawn until something other than a line needs to be
+	// drawn, so that consecutive lines share one draw call.
+	RenderQueue::Add(Flush);
 	
 	Point v = to - from;
 	Point u = v.Unit() * width;
-	GLfloat length[2] = {static_cast<float>(v.X()), static_cast<float>(v.Y())};
-	glUniform2fv(lengthI, 1, length);
-	
-	GLfloat w[2] = {static_cast<float>(u.Y()), static_cast<float>(-u.X())};
-	glUniform2fv(widthI, 1, w);
-	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	
-	glBindVertexArray(0);
-	glUseProgram(0);
+	Point w(u.Y(), -u.X());
+	float length = v.Length();
+	const float *rgba = color.Get();
+	for(int i = 0; i < 12; i += 2)
+	{
+		Point vert = from + CORNERS[i] * v + CORNERS[i + 1] * w;
+		vertices.push_back(vert.X());
+		vertices.push_back(vert.Y());
+		vertices.insert(vertices.end(), CORNERS + i, CORNERS + i + 2);
+		vertices.push_back(length);
+		vertices.insert(vertices.end(), rgba, rgba + 4);
+	}
 }
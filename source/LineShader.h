@@ -19,7 +19,8 @@ class Point;
 
 
 // Class to be used for drawing lines. The sides of a line are anti-aliased, but
-// the start and end of the line are not.
+// the start and end of the line are not. Lines that are drawn one after another
+// are drawn together, through the RenderQueue.
 class LineShader {
 public:
 	static void Init();
@@ -32,7 +32,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PlayerInfo.h"
 #include "Preferences.h"
 #include "Rectangle.h"
+#include "SaveJournal.h"
 #include "ShipyardPanel.h"
+#include "SnapshotStore.h"
 #include "StarField.h"
 #include "StartConditionsPanel.h"
 #include "text/truncate.hpp"
@@ -65,7 +67,8 @@ namespace {
 	string FileDate(const string &filename)
 	{
 		string date = "0000-00-00";
-		DataFile file(filename);
+		DataFile file;
+		SaveJournal::Load(filename, file);
 		for(const DataNode &node : file)
 			if(node.Token(0) == "date")
 			{
@@ -404,17 +407,28 @@ void LoadPanel::UpdateLists()
 {
 	files.clear();
 	
+	// Make sure the list includes any save that was just made.
+	Files::FinishWriting();
 	vector<string> fileList = Files::List(Files::Saves());
 	for(const string &path : fileList)
 	{
 		string fileName = Files::Name(path);
 		// The file name is either "Pilot Name.txt" or "Pilot Name~SnapshotTitle.txt".
+		// Any other files, such as the journals of saves, are not listed.
+		if(fileName.length() < 4 || fileName.compare(fileName.length() - 4, 4, ".txt"))
+			continue;
 		size_t pos = fileName.find('~');
 		if(pos == string::npos)
 			pos = fileName.size() - 4;
 		
+		// If this save has a journal, it was last changed when that was.
+		time_t timestamp = Files::Timestamp(path);
+		string journalPath = SaveJournal::JournalPath(path);
+		if(Files::Exists(journalPath))
+			timestamp = max(timestamp, Files::Timestamp(journalPath));
+		
 		string pilotName = fileName.substr(0, pos);
-		files[pilotName].emplace_back(fileName, Files::Timestamp(path));
+		files[pilotName].emplace_back(fileName, timestamp);
 	}
 	
 	for(auto &it : files)
@@ -472,8 +486,13 @@ void LoadPanel::SnapshotCallback(const string &name)
 // This name is the one to be used, even if it already exists.
 void LoadPanel::WriteSnapshot(const string &sourceFile, const string &snapshotName)
 {
-	// Copy the autosave to a new, named file.
-	Files::Copy(sourceFile, snapshotName);
+	// Store the autosave (with its journal's changes, if any) as a new, named
+	// snapshot. Most of it is the same as in other snapshots of this pilot,
+	// so only the parts that differ are actually written.
+	SnapshotStore::Write(snapshotName, SaveJournal::Read(sourceFile));
+	// If this replaced an older snapshot, some of that one's parts may no
+	// longer be needed.
+	SnapshotStore::CollectGarbage();
 	if(Files::Exists(snapshotName))
 	{
 		UpdateLists();
@@ -522,7 +541,11 @@ void LoadPanel::DeletePilot()
 		string path = Files::Saves() + fit.first;
 		Files::Delete(path);
 		failed |= Files::Exists(path);
+		string journalPath = SaveJournal::JournalPath(path);
+		if(Files::Exists(journalPath))
+			Files::Delete(journalPath);
 	}
+	SnapshotStore::CollectGarbage();
 	if(failed)
 		GetUI()->Push(new Dialog("Deleting pilot files failed."));
 	
@@ -540,6 +563,10 @@ void LoadPanel::DeleteSave()
 	string pilot = selectedPilot;
 	string path = Files::Saves() + selectedFile;
 	Files::Delete(path);
+	string journalPath = SaveJournal::JournalPath(path);
+	if(Files::Exists(journalPath))
+		Files::Delete(journalPath);
+	SnapshotStore::CollectGarbage();
 	if(Files::Exists(path))
 		GetUI()->Push(new Dialog("Deleting snapshot file failed."));
 	
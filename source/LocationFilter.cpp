@@ -14,7 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DataNode.h"
 #include "DataWriter.h"
-#include "DistanceMap.h"
+#include "DistanceTable.h"
 #include "GameData.h"
 #include "Government.h"
 #include "Planet.h"
@@ -24,7 +24,6 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "System.h"
 
 #include <algorithm>
-#include <mutex>
 
 using namespace std;
 
@@ -68,23 +67,8 @@ namespace {
 	// Check if the given system is within the given distance of the center.
 	int Distance(const System *center, const System *system, int maximum)
 	{
-		// This function should only ever be called from the main thread, but
-		// just to be sure, use mutex protection on the static locals.
-		static mutex distanceMutex;
-		lock_guard<mutex> lock(distanceMutex);
-		
-		static const System *previousCenter = center;
-		static DistanceMap distance(center, -1, maximum);
-		static int previousMaximum = maximum;
-		
-		if(center != previousCenter || maximum > previousMaximum)
-		{
-			previousCenter = center;
-			previousMaximum = maximum;
-			distance = DistanceMap(center, -1, maximum);
-		}
 		// If the distance is greater than the maximum, this is not a match.
-		int d = distance.Days(system);
+		int d = DistanceTable::Jumps(center, system);
 		return (d > maximum) ? -1 : d;
 	}
 	
@@ -151,6 +135,10 @@ LocationFilter::LocationFilter(const DataNode &node)
 
 void LocationFilter::Load(const DataNode &node)
 {
+	// Any systems or planets found before are no longer valid.
+	systemsRevision = 0;
+	planetsRevision = 0;
+	
 	for(const DataNode &child : node)
 	{
 		// Handle filters that must not match, or must apply to a
@@ -431,6 +419,9 @@ LocationFilter LocationFilter::SetOrigin(const System *origin) const
 	// Revert "distance" parameters to their default.
 	result.originMinDistance = 0;
 	result.originMaxDistance = -1;
+	// The candidates must be found again, now that they depend on the center.
+	result.systemsRevision = 0;
+	result.planetsRevision = 0;
 	
 	return result;
 }
@@ -440,15 +431,29 @@ LocationFilter LocationFilter::SetOrigin(const System *origin) const
 // Pick a random system that matches this filter, based on the given origin.
 const System *LocationFilter::PickSystem(const System *origin) const
 {
-	// Find a planet that satisfies the filter.
+	// Find a system that satisfies the filter.
 	vector<const System *> options;
-	for(const auto &it : GameData::Systems())
+	if(HasNestedDistance())
 	{
-		// Skip entries with incomplete data.
-		if(!it.second.IsValid())
-			continue;
-		if(Matches(&it.second, origin))
-			options.push_back(&it.second);
+		for(const auto &it : GameData::Systems())
+		{
+			// Skip entries with incomplete data.
+			if(!it.second.IsValid())
+				continue;
+			if(Matches(&it.second, origin))
+				options.push_back(&it.second);
+		}
+	}
+	else
+	{
+		// Everything but the distance from the origin is the same every time.
+		const vector<const System *> &candidates = SystemCandidates();
+		if(!origin || originMaxDistance < 0)
+			return candidates.empty() ? nullptr : candidates[Random::Int(candidates.size())];
+		
+		for(const System *system : candidates)
+			if(Distance(origin, system, originMaxDistance) >= originMinDistance)
+				options.push_back(system);
 	}
 	return options.empty() ? nullptr : options[Random::Int(options.size())];
 }
@@ -458,20 +463,37 @@ const System *LocationFilter::PickSystem(const System *origin) const
 // Pick a random planet that matches this filter, based on the given origin.
 const Planet *LocationFilter::PickPlanet(const System *origin, bool hasClearance, bool requireSpaceport) const
 {
+	// Skip planets that do not offer special jobs or missions, unless they were explicitly listed as options.
+	auto isOffered = [this, hasClearance, requireSpaceport](const Planet &planet) -> bool
+	{
+		if(planet.IsWormhole() || (requireSpaceport && !planet.HasSpaceport()) || (!hasClearance && !planet.CanLand()))
+			return !planets.empty() && planets.count(&planet);
+		return true;
+	};
+	
 	// Find a planet that satisfies the filter.
 	vector<const Planet *> options;
-	for(const auto &it : GameData::Planets())
+	if(HasNestedDistance())
 	{
-		const Planet &planet = it.second;
-		// Skip entries with incomplete data.
-		if(!planet.IsValid())
-			continue;
-		// Skip planets that do not offer special jobs or missions, unless they were explicitly listed as options.
-		if(planet.IsWormhole() || (requireSpaceport && !planet.HasSpaceport()) || (!hasClearance && !planet.CanLand()))
-			if(planets.empty() || !planets.count(&planet))
+		for(const auto &it : GameData::Planets())
+		{
+			const Planet &planet = it.second;
+			// Skip entries with incomplete data.
+			if(!planet.IsValid())
 				continue;
-		if(Matches(&planet, origin))
-			options.push_back(&planet);
+			if(isOffered(planet) && Matches(&planet, origin))
+				options.push_back(&planet);
+		}
+	}
+	else
+	{
+		// Everything but the distance from the origin, and whether the planet is
+		// offering jobs right now, is the same every time.
+		bool checkDistance = (origin && originMaxDistance >= 0);
+		for(const Planet *planet : PlanetCandidates())
+			if(isOffered(*planet) && (!checkDistance
+					|| Distance(origin, planet->GetSystem(), originMaxDistance) >= originMinDistance))
+				options.push_back(planet);
 	}
 	return options.empty() ? nullptr : options[Random::Int(options.size())];
 }
@@ -617,3 +639,51 @@ bool LocationFilter::Matches(const System *system, const System *origin, bool di
 	
 	return true;
 }
+
+
+
+// Check if any "not" or "neighbor" filter within this one has a "distance" condition.
+bool LocationFilter::HasNestedDistance() const
+{
+	for(const LocationFilter &filter : notFilters)
+		if(filter.originMaxDistance >= 0 || filter.HasNestedDistance())
+			return true;
+	for(const LocationFilter &filter : neighborFilters)
+		if(filter.originMaxDistance >= 0 || filter.HasNestedDistance())
+			return true;
+	return false;
+}
+
+
+
+// Get the valid systems that match this filter, not counting any "distance"
+// from the origin. This is only valid if there are no nested "distance" filters.
+const vector<const System *> &LocationFilter::SystemCandidates() const
+{
+	if(systemsRevision != GameData::Revision())
+	{
+		systemsRevision = GameData::Revision();
+		systemCandidates.clear();
+		for(const auto &it : GameData::Systems())
+			if(it.second.IsValid() && Matches(&it.second))
+				systemCandidates.push_back(&it.second);
+	}
+	return systemCandidates;
+}
+
+
+
+// Get the valid planets that match this filter, not counting any "distance"
+// from the origin. This is only valid if there are no nested "distance" filters.
+const vector<const Planet *> &LocationFilter::PlanetCandidates() const
+{
+	if(planetsRevision != GameData::Revision())
+	{
+		planetsRevision = GameData::Revision();
+		planetCandidates.clear();
+		for(const auto &it : GameData::Planets())
+			if(it.second.IsValid() && Matches(&it.second))
+				planetCandidates.push_back(&it.second);
+	}
+	return planetCandidates;
+}
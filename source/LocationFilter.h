@@ -13,9 +13,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef LOCATION_FILTER_H_
 #define LOCATION_FILTER_H_
 
+#include <cstdint>
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 class DataNode;
 class DataWriter;
@@ -70,6 +72,13 @@ private:
 	// only if the filter wasn't looking for planet characteristics or if the
 	// didPlanet argument is set (meaning we already checked those).
 	bool Matches(const System *system, const System *origin, bool didPlanet) const;
+	// Check if any "not" or "neighbor" filter within this one has a "distance"
+	// condition, which would make it depend on the origin it is checked from.
+	bool HasNestedDistance() const;
+	// Get the valid systems or planets that match this filter, not counting any
+	// "distance" from the origin.
+	const std::vector<const System *> &SystemCandidates() const;
+	const std::vector<const Planet *> &PlanetCandidates() const;
 	
 	
 private:
@@ -99,6 +108,15 @@ private:
 	std::list<LocationFilter> notFilters;
 	// These filters store all the things the planet or system must border.
 	std::list<LocationFilter> neighborFilters;
+	
+	// The systems and planets that match this filter, not counting the distance
+	// from the origin, are only found when a random one is picked. They are kept
+	// until the universe changes, which is tracked by the revision they were
+	// found for (or zero, if they have not been found).
+	mutable std::vector<const System *> systemCandidates;
+	mutable std::vector<const Planet *> planetCandidates;
+	mutable uint64_t systemsRevision = 0;
+	mutable uint64_t planetsRevision = 0;
 };
 
 
@@ -133,36 +133,36 @@ void LogbookPanel::Draw()
 	wrap.SetAlignment(Alignment::JUSTIFIED);
 	wrap.SetWrapWidth(TEXT_WIDTH - 2. * PAD);
 	
-	// Draw the main text.
-	pos = Screen::TopLeft() + Point(SIDEBAR_WIDTH + PAD, PAD + .5 * (LINE_HEIGHT - font.Height()) - scroll);
-	
-	// Branch based on whether this is an ordinary log month or a special page.
-	auto pit = player.SpecialLogs().find(selectedName);
-	if(selectedDate && begin != end)
+	// Measure the entries on this page, if that has not been done yet.
+	if(heights.size() != entries.size())
 	{
-		const auto layout = Layout(static_cast<int>(TEXT_WIDTH - 2. * PAD), Alignment::RIGHT);
-		for(auto it = begin; it != end; ++it)
+		heights.clear();
+		for(const auto &it : entries)
 		{
-			string date = it->first.ToString();
-			font.Draw({date, layout}, pos + Point(0., textOffset.Y()), dim);
-			pos.Y() += LINE_HEIGHT;
-		
-			wrap.Wrap(it->second);
-			wrap.Draw(pos, medium);
-			pos.Y() += wrap.Height() + GAP;
+			wrap.Wrap(*it.second);
+			heights.push_back(wrap.Height());
 		}
 	}
-	else if(!selectedDate && pit != player.SpecialLogs().end())
+	
+	// Draw the main text, skipping any entries that are scrolled out of view.
+	// Ordinary log months have the date as each entry's heading, while special
+	// pages have a title for each entry.
+	pos = Screen::TopLeft() + Point(SIDEBAR_WIDTH + PAD, PAD + .5 * (LINE_HEIGHT - font.Height()) - scroll);
+	const auto layout = Layout(static_cast<int>(TEXT_WIDTH - 2. * PAD), Alignment::RIGHT);
+	for(size_t i = 0; i < entries.size(); ++i)
 	{
-		for(const auto &it : pit->second)
+		double bottom = pos.Y() + LINE_HEIGHT + heights[i];
+		if(bottom > Screen::Top() && pos.Y() < Screen::Bottom())
 		{
-			font.Draw(it.first, pos + textOffset, bright);
-			pos.Y() += LINE_HEIGHT;
-		
-			wrap.Wrap(it.second);
-			wrap.Draw(pos, medium);
-			pos.Y() += wrap.Height() + GAP;
+			if(selectedDate)
+				font.Draw({entries[i].first, layout}, pos + Point(0., textOffset.Y()), dim);
+			else
+				font.Draw(entries[i].first, pos + textOffset, bright);
+			
+			wrap.Wrap(*entries[i].second);
+			wrap.Draw(pos + Point(0., LINE_HEIGHT), medium);
 		}
+		pos.Y() = bottom + GAP;
 	}
 	
 	maxScroll = max(0., scroll + pos.Y() - Screen::Bottom());
@@ -298,6 +298,16 @@ void LogbookPanel::Update(bool selectLast)
 {
 	contents.clear();
 	dates.clear();
+	entries.clear();
+	heights.clear();
+	
+	// If a special page is selected, it has the same entries no matter what is
+	// in the rest of the logbook.
+	auto pit = player.SpecialLogs().find(selectedName);
+	if(!selectedDate && pit != player.SpecialLogs().end())
+		for(const auto &it : pit->second)
+			entries.emplace_back(it.first, &it.second);
+	
 	for(const auto &it : player.SpecialLogs())
 	{
 		contents.emplace_back(it.first);
@@ -305,10 +315,7 @@ void LogbookPanel::Update(bool selectLast)
 	}
 	// The logbook should never be opened if it has no entries, but just in case:
 	if(player.Logbook().empty())
-	{
-		begin = end = player.Logbook().end();
 		return;
-	}
 	
 	// Check what years and months have entries for them.
 	set<int> years;
@@ -334,10 +341,7 @@ void LogbookPanel::Update(bool selectLast)
 	}
 	// If a special category is selected, bail out here.
 	if(!selectedDate)
-	{
-		begin = end = player.Logbook().end();
 		return;
-	}
 	
 	// Make sure a month is selected, within the current year.
 	if(!selectedDate.Month())
@@ -345,7 +349,9 @@ void LogbookPanel::Update(bool selectLast)
 		selectedDate = Date(0, selectLast ? *--months.end() : *months.begin(), selectedDate.Year());
 		selectedName = MONTH[selectedDate.Month() - 1];
 	}
-	// Get the range of entries that include the selected month.
-	begin = player.Logbook().lower_bound(Date(0, selectedDate.Month(), selectedDate.Year()));
-	end = player.Logbook().lower_bound(Date(32, selectedDate.Month(), selectedDate.Year()));
+	// Get the entries that are in the selected month.
+	auto begin = player.Logbook().lower_bound(Date(0, selectedDate.Month(), selectedDate.Year()));
+	auto end = player.Logbook().lower_bound(Date(32, selectedDate.Month(), selectedDate.Year()));
+	for(auto it = begin; it != end; ++it)
+		entries.emplace_back(it->first.ToString(), &it->second);
 }
@@ -19,6 +19,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 class PlayerInfo;
@@ -56,8 +57,11 @@ private:
 	// Current month being displayed:
 	Date selectedDate;
 	std::string selectedName;
-	std::multimap<Date, std::string>::const_iterator begin;
-	std::multimap<Date, std::string>::const_iterator end;
+	// The heading and text of each entry on the current page, and the height
+	// of its text once wrapped. The heights are measured the first time the
+	// page is drawn, so that only the entries on screen are wrapped after that.
+	std::vector<std::pair<std::string, const std::string *>> entries;
+	std::vector<double> heights;
 	// Other months available for display:
 	std::vector<std::string> contents;
 	std::vector<Date> dates;
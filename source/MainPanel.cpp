@@ -43,11 +43,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "gl_header.h"
 
 #include <cmath>
+#include <iterator>
 #include <sstream>
 #include <string>
 
 using namespace std;
 
+namespace {
+	const Preferences::Setting SHOW_LOAD("Show CPU / GPU load");
+}
+
 
 
 MainPanel::MainPanel(PlayerInfo &player)
@@ -127,9 +132,11 @@ void MainPanel::Step()
 	
 	engine.Step(isActive);
 	
-	// Splice new events onto the eventQueue for (eventual) handling. No
+	// Move new events onto the eventQueue for (eventual) handling. No
 	// other classes use Engine::Events() after Engine::Step() completes.
-	eventQueue.splice(eventQueue.end(), engine.Events());
+	vector<ShipEvent> &events = engine.Events();
+	eventQueue.insert(eventQueue.end(), make_move_iterator(events.begin()), make_move_iterator(events.end()));
+	events.clear();
 	// Handle as many ShipEvents as possible (stopping if no longer active
 	// and updating the isActive flag).
 	StepEvents(isActive);
@@ -164,7 +171,7 @@ void MainPanel::Draw()
 			isDragging = false;
 	}
 	
-	if(Preferences::Has("Show CPU / GPU load"))
+	if(SHOW_LOAD.Has())
 	{
 		string loadString = to_string(lround(load * 100.)) + "% GPU";
 		const Color &color = *GameData::Colors().Get("medium");
@@ -204,6 +211,20 @@ bool MainPanel::AllowFastForward() const
 
 
 
+bool MainPanel::IsReadyToStep()
+{
+	return engine.IsReady();
+}
+
+
+
+void MainPanel::SetNextStepDrawn(bool isDrawn)
+{
+	engine.SetNextStepDrawn(isDrawn);
+}
+
+
+
 // Only override the ones you need; the default action is to return false.
 bool MainPanel::KeyDown(SDL_Keycode key, Uint16 mod, const Command &command, bool isNewPress)
 {
@@ -455,9 +476,9 @@ bool MainPanel::ShowHailPanel()
 // oldest and then process events until any create a new UI element.
 void MainPanel::StepEvents(bool &isActive)
 {
-	while(isActive && !eventQueue.empty())
+	while(isActive && nextEvent < eventQueue.size())
 	{
-		const ShipEvent &event = eventQueue.front();
+		const ShipEvent &event = eventQueue[nextEvent];
 		const Government *actor = event.ActorGovernment();
 		
 		// Pass this event to the player, to update conditions and make
@@ -536,8 +557,13 @@ void MainPanel::StepEvents(bool &isActive)
 			}
 		}
 		
-		// Remove the fully-handled event.
-		eventQueue.pop_front();
+		// Move on from the fully-handled event.
+		++nextEvent;
 		handledFront = false;
 	}
+	if(nextEvent == eventQueue.size())
+	{
+		eventQueue.clear();
+		nextEvent = 0;
+	}
 }
@@ -18,7 +18,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Command.h"
 #include "Engine.h"
 
-#include <list>
+#include <cstddef>
+#include <vector>
 
 class PlayerInfo;
 class ShipEvent;
@@ -44,6 +45,10 @@ public:
 
 	// The main panel allows fast-forward.
 	virtual bool AllowFastForward() const override;
+	// The next step can only begin once the engine has finished calculating.
+	virtual bool IsReadyToStep() override;
+	// Steps that will not be drawn do not need to build the engine's draw lists.
+	virtual void SetNextStepDrawn(bool isDrawn) override;
 	
 	
 protected:
@@ -67,8 +72,11 @@ private:
 	
 	Engine engine;
 	
-	// These are the pending ShipEvents that have yet to be processed.
-	std::list<ShipEvent> eventQueue;
+	// These are the pending ShipEvents that have yet to be processed, starting
+	// with the one at index nextEvent. Once all of them have been handled, the
+	// queue is cleared but keeps its memory for the next step's events.
+	std::vector<ShipEvent> eventQueue;
+	size_t nextEvent = 0;
 	bool handledFront = false;
 	
 	Command show;
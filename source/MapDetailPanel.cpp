@@ -33,6 +33,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PointerShader.h"
 #include "Politics.h"
 #include "Preferences.h"
+#include "PriceTable.h"
 #include "Radar.h"
 #include "RingShader.h"
 #include "Screen.h"
@@ -150,7 +151,7 @@ bool MapDetailPanel::KeyDown(SDL_Keycode key, Uint16 mod, const Command &command
 		// Depending on whether the flagship has a jump drive, the possible links
 		// we can travel along are different:
 		bool hasJumpDrive = player.Flagship()->Attributes().Get("jump drive");
-		const set<const System *> &links = hasJumpDrive ? source->JumpNeighbors(player.Flagship()->JumpRange()) : source->Links();
+		const FlatSet<const System *> &links = hasJumpDrive ? source->JumpNeighbors(player.Flagship()->JumpRange()) : source->Links();
 		
 		// For each link we can travel from this system, check whether the link
 		// is closer to the current angle (while still being larger) than any
@@ -558,8 +559,9 @@ void MapDetailPanel::DrawInfo()
 		bool hasVisited = player.HasVisited(*selectedSystem);
 		if(hasVisited && selectedSystem->IsInhabited(player.Flagship()))
 		{
-			int value = selectedSystem->Trade(commodity.name);
-			int localValue = (player.GetSystem() ? player.GetSystem()->Trade(commodity.name) : 0);
+			int index = &commodity - &GameData::Commodities().front();
+			int value = PriceTable::Price(*selectedSystem, index);
+			int localValue = (player.GetSystem() ? PriceTable::Price(*player.GetSystem(), index) : 0);
 			// Don't "compare" prices if the current system is uninhabited and
 			// thus has no prices to compare to.
 			bool noCompare = (!player.GetSystem() || !player.GetSystem()->IsInhabited(player.Flagship()));
@@ -692,18 +694,14 @@ void MapDetailPanel::DrawOrbits()
 			// Draw an X (to mark the spot, of course).
 			auto uiPoint = (pendingOrder.second * scale) + orbitCenter;
 			const Color *color = GameData::Colors().Get("map orbits fleet destination");
-			// TODO: Add a "batch pointershader" method that takes the shape description, a count, and a reference point+orientation
-			// Use that method below and in Engine for drawing target reticles.
 			auto a = Angle{45.};
 			auto inc = Angle{90.};
 			
-			PointerShader::Bind();
 			for(int i = 0; i < 4; ++i)
 			{
-				PointerShader::Add(uiPoint, a.Unit(), 6.f, 6.f, -3.f, *color);
+				PointerShader::Draw(uiPoint, a.Unit(), 6.f, 6.f, -3.f, *color);
 				a += inc;
 			}
-			PointerShader::Unbind();
 		}
 	}
 	
@@ -29,6 +29,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "LineShader.h"
 #include "MapDetailPanel.h"
 #include "MapOutfitterPanel.h"
+#include "MapShader.h"
 #include "MapShipyardPanel.h"
 #include "Mission.h"
 #include "MissionPanel.h"
@@ -37,12 +38,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PointerShader.h"
 #include "Politics.h"
 #include "Preferences.h"
+#include "PriceTable.h"
 #include "RingShader.h"
 #include "Screen.h"
 #include "Ship.h"
 #include "SpriteShader.h"
 #include "StellarObject.h"
 #include "System.h"
+#include "SystemGrid.h"
 #include "Trade.h"
 #include "UI.h"
 
@@ -56,6 +59,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
+	// The systems and links that the mini-map shows only change when the
+	// player makes a different jump, so they are only worked out once for
+	// each jump. The positions are relative to the mini-map's center, and the
+	// colors are scaled by the mini-map's alpha when it is drawn.
+	class MiniMap {
+	public:
+		class Ring {
+		public:
+			Point position;
+			Color color;
+		};
+		class Name {
+		public:
+			Point position;
+			string text;
+		};
+		
+		// What the layout was worked out for.
+		const System *jump[2] = {nullptr, nullptr};
+		const Ship *flagship = nullptr;
+		uint64_t revision = 0;
+		bool visited[2] = {false, false};
+		
+		vector<Ring> rings;
+		vector<pair<Point, Point>> links;
+		vector<pair<Point, Point>> arrow;
+		vector<Name> names;
+	};
+	MiniMap miniMap;
+	
 	// Log how many player ships and stored outfits are in a given system, tracking for
 	// ships if they are parked or in-flight.
 	//
@@ -102,8 +135,17 @@ namespace {
 	const int HOVER_TIME = 60;
 	// Length in frames of the recentering animation.
 	const int RECENTER_TIME = 20;
+	
+	// Flags for what the player knows about each system.
+	const int SEEN = 1;
+	const int VISITED = 2;
+	const int KNOWS_NAME = 4;
+	const int SPECIAL = 8;
+	const int PLAYER_SYSTEM = 16;
 }
 
+map<int, MapPanel::Cache> MapPanel::sharedCaches;
+
 const float MapPanel::OUTER = 6.f;
 const float MapPanel::INNER = 3.5f;
 const float MapPanel::LINK_WIDTH = 1.2f;
@@ -237,64 +279,50 @@ void MapPanel::DrawButtons(const string &condition)
 
 void MapPanel::DrawMiniMap(const PlayerInfo &player, float alpha, const System *const jump[2], int step)
 {
+	const Ship *flagship = player.Flagship();
+	bool visited[2] = {player.HasVisited(*jump[0]), player.HasVisited(*jump[1])};
+	if(miniMap.jump[0] != jump[0] || miniMap.jump[1] != jump[1] || miniMap.flagship != flagship
+			|| miniMap.revision != GameData::Revision()
+			|| miniMap.visited[0] != visited[0] || miniMap.visited[1] != visited[1])
+	{
+		miniMap.jump[0] = jump[0];
+		miniMap.jump[1] = jump[1];
+		miniMap.flagship = flagship;
+		miniMap.revision = GameData::Revision();
+		miniMap.visited[0] = visited[0];
+		miniMap.visited[1] = visited[1];
+		LayOutMiniMap(player, jump);
+	}
+	
 	const Font &font = FontSet::Get(14);
 	Color lineColor(alpha, 0.f);
 	Point center = .5 * (jump[0]->Position() + jump[1]->Position());
 	const Point &drawPos = GameData::Interfaces().Get("hud")->GetPoint("mini-map");
-	set<const System *> drawnSystems = { jump[0], jump[1] };
-	bool isLink = jump[0]->Links().count(jump[1]);
+	
+	// Draw all the links, then all the systems, so that each of them can be
+	// drawn in a single batch.
+	for(const auto &link : miniMap.links)
+		LineShader::Draw(link.first + drawPos, link.second + drawPos, LINK_WIDTH, lineColor);
+	Color bright(2.f * alpha, 0.f);
+	for(const auto &line : miniMap.arrow)
+		LineShader::Draw(line.first + drawPos, line.second + drawPos, LINK_WIDTH, bright);
+	for(const MiniMap::Ring &ring : miniMap.rings)
+	{
+		const float *rgb = ring.color.Get();
+		RingShader::Draw(ring.position + drawPos, OUTER, INNER, Color(alpha * rgb[0], alpha * rgb[1], alpha * rgb[2], 0.f));
+	}
 	
 	const Set<Color> &colors = GameData::Colors();
 	const Color &currentColor = colors.Get("active mission")->Additive(alpha * 2.f);
 	const Color &blockedColor = colors.Get("blocked mission")->Additive(alpha * 2.f);
 	const Color &waypointColor = colors.Get("waypoint")->Additive(alpha * 2.f);
 	
-	const Ship *flagship = player.Flagship();
+	// Whether a mission's pointer is blinking changes from one step to the
+	// next, so those are not part of the cached layout.
 	for(int i = 0; i < 2; ++i)
 	{
-		static const string UNKNOWN_SYSTEM = "Unexplored System";
 		const System &system = *jump[i];
-		const Government *gov = system.GetGovernment();
 		Point from = system.Position() - center + drawPos;
-		const string &name = player.KnowsName(system) ? system.Name() : UNKNOWN_SYSTEM;
-		font.Draw(name, from + Point(OUTER, -.5 * font.Height()), lineColor);
-		
-		// Draw the origin and destination systems, since they
-		// might not be linked via hyperspace.
-		Color color = Color(.5f * alpha, 0.f);
-		if(player.HasVisited(system) && system.IsInhabited(flagship) && gov)
-			color = Color(
-				alpha * gov->GetColor().Get()[0],
-				alpha * gov->GetColor().Get()[1],
-				alpha * gov->GetColor().Get()[2], 0.f);
-		RingShader::Draw(from, OUTER, INNER, color);
-		
-		for(const System *link : system.Links())
-		{
-			// Only draw systems known to be attached to the jump systems.
-			if(!player.HasVisited(system) && !player.HasVisited(*link))
-				continue;
-			
-			// Draw the system link. This will double-draw the jump
-			// path if it is via hyperlink, to increase brightness.
-			Point to = link->Position() - center + drawPos;
-			Point unit = (from - to).Unit() * LINK_OFFSET;
-			LineShader::Draw(from - unit, to + unit, LINK_WIDTH, lineColor);
-			
-			if(drawnSystems.count(link))
-				continue;
-			drawnSystems.insert(link);
-			
-			gov = link->GetGovernment();
-			Color color = Color(.5f * alpha, 0.f);
-			if(player.HasVisited(*link) && link->IsInhabited(flagship) && gov)
-				color = Color(
-					alpha * gov->GetColor().Get()[0],
-					alpha * gov->GetColor().Get()[1],
-					alpha * gov->GetColor().Get()[2], 0.f);
-			RingShader::Draw(to, OUTER, INNER, color);
-		}
-		
 		Angle angle;
 		for(const Mission &mission : player.Missions())
 		{
@@ -326,27 +354,85 @@ void MapPanel::DrawMiniMap(const PlayerInfo &player, float alpha, const System *
 		}
 	}
 	
+	for(const MiniMap::Name &name : miniMap.names)
+		font.Draw(name.text, name.position + drawPos + Point(OUTER, -.5 * font.Height()), lineColor);
+}
+
+
+
+// Work out which systems and links the mini-map shows for the given jump.
+void MapPanel::LayOutMiniMap(const PlayerInfo &player, const System *const jump[2])
+{
+	miniMap.rings.clear();
+	miniMap.links.clear();
+	miniMap.arrow.clear();
+	miniMap.names.clear();
+	
+	Point center = .5 * (jump[0]->Position() + jump[1]->Position());
+	set<const System *> drawnSystems = { jump[0], jump[1] };
+	bool isLink = jump[0]->Links().count(jump[1]);
+	
+	// Systems that the player has not visited, or that are uninhabited, are
+	// drawn in gray. Others are drawn in their government's color.
+	const Ship *flagship = player.Flagship();
+	auto systemColor = [&player, flagship](const System &system) -> Color
+	{
+		const Government *gov = system.GetGovernment();
+		if(player.HasVisited(system) && system.IsInhabited(flagship) && gov)
+			return gov->GetColor();
+		return Color(.5f, 0.f);
+	};
+	
+	for(int i = 0; i < 2; ++i)
+	{
+		static const string UNKNOWN_SYSTEM = "Unexplored System";
+		const System &system = *jump[i];
+		Point from = system.Position() - center;
+		miniMap.names.push_back({from, player.KnowsName(system) ? system.Name() : UNKNOWN_SYSTEM});
+		
+		// Draw the origin and destination systems, since they
+		// might not be linked via hyperspace.
+		miniMap.rings.push_back({from, systemColor(system)});
+		
+		for(const System *link : system.Links())
+		{
+			// Only draw systems known to be attached to the jump systems.
+			if(!player.HasVisited(system) && !player.HasVisited(*link))
+				continue;
+			
+			// Draw the system link. This will double-draw the jump
+			// path if it is via hyperlink, to increase brightness.
+			Point to = link->Position() - center;
+			Point unit = (from - to).Unit() * LINK_OFFSET;
+			miniMap.links.emplace_back(from - unit, to + unit);
+			
+			if(drawnSystems.count(link))
+				continue;
+			drawnSystems.insert(link);
+			
+			miniMap.rings.push_back({to, systemColor(*link)});
+		}
+	}
+	
 	// Draw the rest of the directional arrow. If this is a normal jump,
 	// the stem was already drawn above.
-	Point from = jump[0]->Position() - center + drawPos;
-	Point to = jump[1]->Position() - center + drawPos;
+	Point from = jump[0]->Position() - center;
+	Point to = jump[1]->Position() - center;
 	Point unit = (to - from).Unit();
 	from += LINK_OFFSET * unit;
 	to -= LINK_OFFSET * unit;
-	Color bright(2.f * alpha, 0.f);
 	// Non-hyperspace jumps are drawn with a dashed directional arrow.
 	if(!isLink)
 	{
 		double length = (to - from).Length();
 		int segments = static_cast<int>(length / 15.);
 		for(int i = 0; i < segments; ++i)
-			LineShader::Draw(
+			miniMap.arrow.emplace_back(
 				from + unit * ((i * length) / segments + 2.),
-				from + unit * (((i + 1) * length) / segments - 2.),
-				LINK_WIDTH, bright);
+				from + unit * (((i + 1) * length) / segments - 2.));
 	}
-	LineShader::Draw(to, to + Angle(-30.).Rotate(unit) * -10., LINK_WIDTH, bright);
-	LineShader::Draw(to, to + Angle(30.).Rotate(unit) * -10., LINK_WIDTH, bright);
+	miniMap.arrow.emplace_back(to, to + Angle(-30.).Rotate(unit) * -10.);
+	miniMap.arrow.emplace_back(to, to + Angle(30.).Rotate(unit) * -10.);
 }
 
 
@@ -405,14 +491,9 @@ bool MapPanel::KeyDown(SDL_Keycode key, Uint16 mod, const Command &command, bool
 bool MapPanel::Click(int x, int y, int clicks)
 {
 	// Figure out if a system was clicked on.
-	Point click = Point(x, y) / Zoom() - center;
-	for(const auto &it : GameData::Systems())
-		if(it.second.IsValid() && click.Distance(it.second.Position()) < 10.
-				&& (player.HasSeen(it.second) || &it.second == specialSystem))
-		{
-			Select(&it.second);
-			break;
-		}
+	const System *system = SystemAt(x, y);
+	if(system)
+		Select(system);
 	
 	return true;
 }
@@ -710,159 +791,302 @@ void MapPanel::CenterOnSystem(const System *system, bool immediate)
 
 
 
+// Find the system that the player knows about at the given point on the
+// screen, if any.
+const System *MapPanel::SystemAt(int x, int y) const
+{
+	Point click = Point(x, y) / Zoom() - center;
+	for(const System *system : SystemGrid::Near(click, 10.))
+		if(player.HasSeen(*system) || system == specialSystem)
+			return system;
+	return nullptr;
+}
+
+
+
 // Cache the map layout, so it doesn't have to be re-calculated every frame.
-// The node cache must be updated when the coloring mode changes.
+// The node cache must be updated when the coloring mode changes. Only the
+// systems whose state has changed since the cache for this coloring mode was
+// last updated have their colors recalculated.
 void MapPanel::UpdateCache()
 {
 	// Remember which commodity the cached systems are colored by.
 	cachedCommodity = commodity;
-	nodes.clear();
+	// Coloring by "special" values depends on what kind of map panel this is
+	// and what is selected in it, so that cache cannot be shared.
+	Cache &cache = (commodity == SHOW_SPECIAL ? specialCache : sharedCaches[commodity]);
+	this->cache = &cache;
 	
-	// Draw the circles for the systems, colored based on the selected criterion,
-	// which may be government, services, or commodity prices.
-	const Color &closeNameColor = *GameData::Colors().Get("map name");
-	const Color &farNameColor = closeNameColor.Transparent(.5);
+	Stamp stamp;
+	stamp.flagship = player.Flagship();
+	for(const auto &it : GameData::Planets())
+		if(!it.second.IsUnrestricted())
+			stamp.access.push_back(it.second.IsAccessible(stamp.flagship));
+	stamp.galaxyRevision = GameData::Revision();
+	// Only the reputation colors depend on the player's standing.
+	if(commodity == SHOW_REPUTATION)
+		stamp.politicsRevision = GameData::GetPolitics().Revision();
+	// Coloring by special values or by visited planets depends on more than
+	// just the state of each system, so those colors are always calculated.
+	bool recolorAll = !(stamp == cache.stamp) || commodity == SHOW_SPECIAL || commodity == SHOW_VISITED;
+	if(recolorAll)
+	{
+		// If the galaxy has changed, some of the systems may no longer exist.
+		if(stamp.galaxyRevision != cache.stamp.galaxyRevision)
+			cache.systems.clear();
+		cache.stamp = move(stamp);
+	}
+	
+	bool isChanged = recolorAll;
+	const Trade::Commodity *com = (commodity >= 0 ? &GameData::Commodities()[commodity] : nullptr);
 	for(const auto &it : GameData::Systems())
 	{
 		const System &system = it.second;
 		// Ignore systems which have been referred to, but not actually defined.
 		if(!system.IsValid())
 			continue;
-		// Ignore systems the player has never seen, unless they have a pending mission that lets them see it.
-		if(!player.HasSeen(system) && &system != specialSystem)
+		
+		int flags = (player.HasSeen(system) ? SEEN : 0)
+			| (player.HasVisited(system) ? VISITED : 0)
+			| (player.KnowsName(system) ? KNOWS_NAME : 0)
+			| (&system == specialSystem ? SPECIAL : 0)
+			| (&system == &playerSystem ? PLAYER_SYSTEM : 0);
+		int price = (com ? PriceTable::Price(system, commodity) : 0);
+		
+		auto sit = cache.systems.find(&system);
+		if(sit == cache.systems.end())
+			sit = cache.systems.emplace(&system, SystemState()).first;
+		else if(!recolorAll && sit->second.flags == flags && sit->second.price == price)
 			continue;
 		
-		Color color = UninhabitedColor();
-		if(!player.HasVisited(system))
-			color = UnexploredColor();
-		else if(system.IsInhabited(player.Flagship()) || commodity == SHOW_SPECIAL || commodity == SHOW_VISITED)
-		{
-			if(commodity >= SHOW_SPECIAL)
-			{
-				double value = 0.;
-				bool colorSystem = true;
-				if(commodity >= 0)
-				{
-					const Trade::Commodity &com = GameData::Commodities()[commodity];
-					double price = system.Trade(com.name);
-					if(!price)
-						value = numeric_limits<double>::quiet_NaN();
-					else
-						value = (2. * (price - com.low)) / (com.high - com.low) - 1.;
-				}
-				else if(commodity == SHOW_SHIPYARD)
-				{
-					double size = 0;
-					for(const StellarObject &object : system.Objects())
-						if(object.HasSprite() && object.HasValidPlanet())
-							size += object.GetPlanet()->Shipyard().size();
-					value = size ? min(10., size) / 10. : -1.;
-				}
-				else if(commodity == SHOW_OUTFITTER)
-				{
-					double size = 0;
-					for(const StellarObject &object : system.Objects())
-						if(object.HasSprite() && object.HasValidPlanet())
-							size += object.GetPlanet()->Outfitter().size();
-					value = size ? min(60., size) / 60. : -1.;
-				}
-				else if(commodity == SHOW_VISITED)
-				{
-					bool all = true;
-					bool some = false;
-					colorSystem = false;
-					for(const StellarObject &object : system.Objects())
-						if(object.HasSprite() && object.HasValidPlanet() && !object.GetPlanet()->IsWormhole()
-							&& object.GetPlanet()->IsAccessible(player.Flagship()))
-						{
-							bool visited = player.HasVisited(*object.GetPlanet());
-							all &= visited;
-							some |= visited;
-							colorSystem = true;
-						}
-					value = -1 + some + all;
-				}
-				else
-					value = SystemValue(&system);
-				
-				if(colorSystem)
-					color = MapColor(value);
-			}
-			else if(commodity == SHOW_GOVERNMENT)
-			{
-				const Government *gov = system.GetGovernment();
-				color = GovernmentColor(gov);
-			}
-			else
-			{
-				double reputation = system.GetGovernment()->Reputation();
-				
-				// A system should show up as dominated if it contains at least
-				// one inhabited planet and all inhabited planets have been
-				// dominated. It should show up as restricted if you cannot land
-				// on any of the planets that have spaceports.
-				bool hasDominated = true;
-				bool isInhabited = false;
-				bool canLand = false;
-				bool hasSpaceport = false;
-				for(const StellarObject &object : system.Objects())
-					if(object.HasSprite() && object.HasValidPlanet())
-					{
-						const Planet *planet = object.GetPlanet();
-						hasSpaceport |= !planet->IsWormhole() && planet->HasSpaceport();
-						if(planet->IsWormhole() || !planet->IsAccessible(player.Flagship()))
-							continue;
-						canLand |= planet->CanLand() && planet->HasSpaceport();
-						isInhabited |= planet->IsInhabited();
-						hasDominated &= (!planet->IsInhabited()
-							|| GameData::GetPolitics().HasDominated(planet));
-					}
-				hasDominated &= (isInhabited && canLand);
-				// Some systems may count as "inhabited" but not contain any
-				// planets with spaceports. Color those as if they're
-				// uninhabited to make it clear that no fuel is available there.
-				if(hasSpaceport || hasDominated)
-					color = ReputationColor(reputation, canLand, hasDominated);
-			}
-		}
+		SystemState &state = sit->second;
+		state.flags = flags;
+		state.price = price;
+		// Ignore systems the player has never seen, unless they have a pending mission that lets them see it.
+		if(flags & (SEEN | SPECIAL))
+			state.color = SystemColor(system);
+		isChanged = true;
+	}
+	if(!isChanged)
+		return;
+	
+	cache.nodes.clear();
+	const Color &closeNameColor = *GameData::Colors().Get("map name");
+	const Color &farNameColor = closeNameColor.Transparent(.5);
+	for(auto &it : cache.systems)
+	{
+		const System &system = *it.first;
+		SystemState &state = it.second;
+		state.node = -1;
+		if(!(state.flags & (SEEN | SPECIAL)))
+			continue;
 		
-		nodes.emplace_back(system.Position(), color,
-			player.KnowsName(system) ? system.Name() : "",
-			(&system == &playerSystem) ? closeNameColor : farNameColor,
-			player.HasVisited(system) ? system.GetGovernment() : nullptr);
+		state.node = cache.nodes.size();
+		cache.nodes.emplace_back(system.Position(), state.color,
+			(state.flags & KNOWS_NAME) ? system.Name() : "",
+			(state.flags & PLAYER_SYSTEM) ? closeNameColor : farNameColor,
+			(state.flags & VISITED) ? system.GetGovernment() : nullptr);
 	}
 	
 	// Now, update the cache of the links.
-	links.clear();
+	cache.links.clear();
 	
 	// The link color depends on whether it's connected to the current system or not.
 	const Color &closeColor = *GameData::Colors().Get("map link");
 	const Color &farColor = closeColor.Transparent(.5);
-	for(const auto &it : GameData::Systems())
+	for(const auto &it : cache.systems)
 	{
-		const System *system = &it.second;
-		if(!system->IsValid() || !player.HasSeen(*system))
+		const System *system = it.first;
+		int flags = it.second.flags;
+		if(!(flags & SEEN))
 			continue;
 		
 		for(const System *link : system->Links())
-			if(link < system || !player.HasSeen(*link))
+		{
+			// Links to systems that are not valid are not in the cache.
+			auto lit = cache.systems.find(link);
+			int linkFlags = (lit == cache.systems.end() ? 0 : lit->second.flags);
+			if(link < system || !(linkFlags & SEEN))
 			{
 				// Only draw links between two systems if one of the two is
 				// visited. Also, avoid drawing twice by only drawing in the
 				// direction of increasing pointer values.
-				if((!player.HasVisited(*system) && !player.HasVisited(*link)) || !link->IsValid())
+				if(!((flags | linkFlags) & VISITED) || !link->IsValid())
 					continue;
 				
-				bool isClose = (system == &playerSystem || link == &playerSystem);
-				links.emplace_back(system->Position(), link->Position(), isClose ? closeColor : farColor);
+				bool isClose = ((flags | linkFlags) & PLAYER_SYSTEM);
+				cache.links.emplace_back(system->Position(), link->Position(), isClose ? closeColor : farColor);
 			}
+		}
 	}
+	
+	// Upload the new layout the next time it is drawn.
+	static uint64_t nextBatchId = 0;
+	cache.batchId = ++nextBatchId;
+	cache.ringData.clear();
+	for(const Node &node : cache.nodes)
+		MapShader::AddRing(cache.ringData, node.position, node.color);
+	cache.lineData.clear();
+	for(const Link &link : cache.links)
+		MapShader::AddLine(cache.lineData, link.start, link.end, link.color);
+}
+
+
+
+// Get the color of the given system in the current coloring mode, which may
+// be based on government, services, or commodity prices.
+Color MapPanel::SystemColor(const System &system) const
+{
+	Color color = UninhabitedColor();
+	if(!player.HasVisited(system))
+		color = UnexploredColor();
+	else if(system.IsInhabited(player.Flagship()) || commodity == SHOW_SPECIAL || commodity == SHOW_VISITED)
+	{
+		if(commodity >= SHOW_SPECIAL)
+		{
+			double value = 0.;
+			bool colorSystem = true;
+			if(commodity >= 0)
+			{
+				const Trade::Commodity &com = GameData::Commodities()[commodity];
+				double price = PriceTable::Price(system, commodity);
+				if(!price)
+					value = numeric_limits<double>::quiet_NaN();
+				else
+					value = (2. * (price - com.low)) / (com.high - com.low) - 1.;
+			}
+			else if(commodity == SHOW_SHIPYARD)
+			{
+				double size = 0;
+				for(const StellarObject &object : system.Objects())
+					if(object.HasSprite() && object.HasValidPlanet())
+						size += object.GetPlanet()->Shipyard().size();
+				value = size ? min(10., size) / 10. : -1.;
+			}
+			else if(commodity == SHOW_OUTFITTER)
+			{
+				double size = 0;
+				for(const StellarObject &object : system.Objects())
+					if(object.HasSprite() && object.HasValidPlanet())
+						size += object.GetPlanet()->Outfitter().size();
+				value = size ? min(60., size) / 60. : -1.;
+			}
+			else if(commodity == SHOW_VISITED)
+			{
+				bool all = true;
+				bool some = false;
+				colorSystem = false;
+				for(const StellarObject &object : system.Objects())
+					if(object.HasSprite() && object.HasValidPlanet() && !object.GetPlanet()->IsWormhole()
+						&& object.GetPlanet()->IsAccessible(player.Flagship()))
+					{
+						bool visited = player.HasVisited(*object.GetPlanet());
+						all &= visited;
+						some |= visited;
+						colorSystem = true;
+					}
+				value = -1 + some + all;
+			}
+			else
+				value = SystemValue(&system);
+			
+			if(colorSystem)
+				color = MapColor(value);
+		}
+		else if(commodity == SHOW_GOVERNMENT)
+		{
+			const Government *gov = system.GetGovernment();
+			color = GovernmentColor(gov);
+		}
+		else
+		{
+			double reputation = system.GetGovernment()->Reputation();
+			
+			// A system should show up as dominated if it contains at least
+			// one inhabited planet and all inhabited planets have been
+			// dominated. It should show up as restricted if you cannot land
+			// on any of the planets that have spaceports.
+			bool hasDominated = true;
+			bool isInhabited = false;
+			bool canLand = false;
+			bool hasSpaceport = false;
+			for(const StellarObject &object : system.Objects())
+				if(object.HasSprite() && object.HasValidPlanet())
+				{
+					const Planet *planet = object.GetPlanet();
+					hasSpaceport |= !planet->IsWormhole() && planet->HasSpaceport();
+					if(planet->IsWormhole() || !planet->IsAccessible(player.Flagship()))
+						continue;
+					canLand |= planet->CanLand() && planet->HasSpaceport();
+					isInhabited |= planet->IsInhabited();
+					hasDominated &= (!planet->IsInhabited()
+						|| GameData::GetPolitics().HasDominated(planet));
+				}
+			hasDominated &= (isInhabited && canLand);
+			// Some systems may count as "inhabited" but not contain any
+			// planets with spaceports. Color those as if they're
+			// uninhabited to make it clear that no fuel is available there.
+			if(hasSpaceport || hasDominated)
+				color = ReputationColor(reputation, canLand, hasDominated);
+		}
+	}
+	return color;
+}
+
+
+
+bool MapPanel::Stamp::operator==(const Stamp &other) const
+{
+	return flagship == other.flagship && access == other.access
+		&& galaxyRevision == other.galaxyRevision && politicsRevision == other.politicsRevision;
 }
 
 
 
 void MapPanel::DrawTravelPlan()
 {
+	const Ship *flagship = player.Flagship();
+	if(!flagship)
+		return;
+	
+	// The route only needs to be worked out again if the plan, the fleet's
+	// fuel, or what the player knows about the systems along it has changed.
+	// A disabled ship is listed with negative fuel, since it cannot jump.
+	vector<pair<const Ship *, double>> fleetFuel;
+	for(const shared_ptr<Ship> &it : player.Ships())
+		if(!it->IsParked() && !it->CanBeCarried() && it->GetSystem() == flagship->GetSystem())
+			fleetFuel.emplace_back(it.get(), it->IsDisabled() ? -1. : it->Fuel() * it->Attributes().Get("fuel capacity"));
+	double jumpRange = flagship->JumpRange();
+	if(travelPlan.plan != player.TravelPlan() || travelPlan.fuel != fleetFuel || travelPlan.planet != player.GetPlanet()
+			|| travelPlan.jumpRange != jumpRange || travelPlan.galaxyRevision != GameData::Revision()
+			|| travelPlan.conditionsRevision != player.Conditions().Revision())
+	{
+		travelPlan.plan = player.TravelPlan();
+		travelPlan.fuel = move(fleetFuel);
+		travelPlan.planet = player.GetPlanet();
+		travelPlan.jumpRange = jumpRange;
+		travelPlan.galaxyRevision = GameData::Revision();
+		travelPlan.conditionsRevision = player.Conditions().Revision();
+		UpdateTravelPlan();
+	}
+	
+	for(const Link &segment : travelPlan.segments)
+	{
+		Point from = Zoom() * (segment.start + center);
+		Point to = Zoom() * (segment.end + center);
+		Point unit = (from - to).Unit() * LINK_OFFSET;
+		LineShader::Draw(from - unit, to + unit, 3.f, segment.color);
+	}
+}
+
+
+
+// Work out how far along the travel plan the fleet can make it, and color
+// each segment of it to match.
+void MapPanel::UpdateTravelPlan()
+{
+	travelPlan.segments.clear();
+	
 	const Set<Color> &colors = GameData::Colors();
 	const Color &defaultColor = *colors.Get("map travel ok flagship");
 	const Color &outOfFlagshipFuelRangeColor = *colors.Get("map travel ok none");
@@ -872,31 +1096,27 @@ void MapPanel::DrawTravelPlan()
 	// At each point in the path, keep track of how many ships in the
 	// fleet are able to make it this far.
 	const Ship *flagship = player.Flagship();
-	if(!flagship)
-		return;
-	
 	bool stranded = false;
 	bool hasEscort = false;
 	map<const Ship *, double> fuel;
-	for(const shared_ptr<Ship> &it : player.Ships())
-		if(!it->IsParked() && !it->CanBeCarried() && it->GetSystem() == flagship->GetSystem())
+	for(const auto &it : travelPlan.fuel)
+	{
+		if(it.second < 0.)
 		{
-			if(it->IsDisabled())
-			{
-				stranded = true;
-				continue;
-			}
-			
-			fuel[it.get()] = it->Fuel() * it->Attributes().Get("fuel capacity");
-			hasEscort |= (it.get() != flagship);
+			stranded = true;
+			continue;
 		}
+		
+		fuel[it.first] = it.second;
+		hasEscort |= (it.first != flagship);
+	}
 	stranded |= !hasEscort;
 	
 	const System *previous = &playerSystem;
-	double jumpRange = flagship->JumpRange();
-	for(int i = player.TravelPlan().size() - 1; i >= 0; --i)
+	double jumpRange = travelPlan.jumpRange;
+	for(int i = travelPlan.plan.size() - 1; i >= 0; --i)
 	{
-		const System *next = player.TravelPlan()[i];
+		const System *next = travelPlan.plan[i];
 		bool isHyper = previous->Links().count(next);
 		bool isJump = !isHyper && previous->JumpNeighbors(jumpRange).count(next);
 		bool systemJumpRange = previous->JumpRange() > 0.;
@@ -938,10 +1158,7 @@ void MapPanel::DrawTravelPlan()
 		else if(fuel[flagship] >= 0.)
 			drawColor = defaultColor;
 		
-		Point from = Zoom() * (next->Position() + center);
-		Point to = Zoom() * (previous->Position() + center);
-		Point unit = (from - to).Unit() * LINK_OFFSET;
-		LineShader::Draw(from - unit, to + unit, 3.f, drawColor);
+		travelPlan.segments.emplace_back(next->Position(), previous->Position(), drawColor);
 		
 		previous = next;
 	}
@@ -1048,17 +1265,7 @@ void MapPanel::DrawWormholes()
 
 void MapPanel::DrawLinks()
 {
-	double zoom = Zoom();
-	for(const Link &link : links)
-	{
-		Point from = zoom * (link.start + center);
-		Point to = zoom * (link.end + center);
-		Point unit = (from - to).Unit() * LINK_OFFSET;
-		from -= unit;
-		to += unit;
-		
-		LineShader::Draw(from, to, LINK_WIDTH, link.color);
-	}
+	MapShader::DrawLines(cache->lineData, cache->batchId, center, Zoom(), LINK_WIDTH, LINK_OFFSET);
 }
 
 
@@ -1076,24 +1283,24 @@ void MapPanel::DrawSystems()
 	
 	// Draw the circles for the systems.
 	double zoom = Zoom();
-	for(const Node &node : nodes)
-	{
-		Point pos = zoom * (node.position + center);
-		RingShader::Draw(pos, OUTER, INNER, node.color);
-		
-		if(commodity == SHOW_GOVERNMENT && node.government && node.government->GetName() != "Uninhabited")
+	MapShader::DrawRings(cache->ringData, cache->batchId, center, zoom, OUTER, INNER);
+	
+	if(commodity == SHOW_GOVERNMENT)
+		for(const Node &node : cache->nodes)
 		{
+			if(!node.government || node.government->GetName() == "Uninhabited")
+				continue;
+			
 			// For every government that is drawn, keep track of how close it
 			// is to the center of the view. The four closest governments
 			// will be displayed in the key.
-			double distance = pos.Length();
+			double distance = (zoom * (node.position + center)).Length();
 			auto it = closeGovernments.find(node.government);
 			if(it == closeGovernments.end())
 				closeGovernments[node.government] = distance;
 			else
 				it->second = min(it->second, distance);
 		}
-	}
 }
 
 
@@ -1109,8 +1316,20 @@ void MapPanel::DrawNames()
 	bool useBigFont = (zoom > 2.);
 	const Font &font = FontSet::Get(useBigFont ? 18 : 14);
 	Point offset(useBigFont ? 8. : 6., -.5 * font.Height());
-	for(const Node &node : nodes)
+	// Only look at the systems that are on screen, or just off the left edge
+	// of it (since their names extend to the right of them).
+	Point margin(200., font.Height());
+	Point topLeft = (Screen::TopLeft() - margin) / zoom - center;
+	Point bottomRight = (Screen::BottomRight() + Point(0., font.Height())) / zoom - center;
+	for(const System *system : SystemGrid::InRect(topLeft, bottomRight))
+	{
+		auto it = cache->systems.find(system);
+		if(it == cache->systems.end() || it->second.node < 0)
+			continue;
+		
+		const Node &node = cache->nodes[it->second.node];
 		font.Draw(node.name, zoom * (node.position + center) + offset, node.nameColor);
+	}
 }
 
 
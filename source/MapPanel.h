@@ -20,6 +20,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 #include "text/WrappedText.h"
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <utility>
@@ -30,6 +31,7 @@ class Government;
 class Mission;
 class Planet;
 class PlayerInfo;
+class Ship;
 class System;
 
 
@@ -129,9 +131,14 @@ protected:
 	// Center the view on the given system (may actually be slightly offset
 	// to account for panels on the screen).
 	void CenterOnSystem(const System *system, bool immediate = false);
+	// Find the system that the player knows about at the given point on the
+	// screen, if any.
+	const System *SystemAt(int x, int y) const;
 	
 	// Cache the map layout, so it doesn't have to be re-calculated every frame.
-	// The cache must be updated when the coloring mode changes.
+	// The cache must be updated when the coloring mode changes. The layout for
+	// each coloring mode is kept even after the map is closed, and only the
+	// systems whose state has changed since then are updated.
 	void UpdateCache();
 	
 	// For tooltips:
@@ -142,7 +149,10 @@ protected:
 	
 	
 private:
+	// Work out which systems and links the mini-map shows for the given jump.
+	static void LayOutMiniMap(const PlayerInfo &player, const System *const jump[2]);
 	void DrawTravelPlan();
+	void UpdateTravelPlan();
 	// Indicate which other systems have player escorts.
 	void DrawEscorts();
 	void DrawWormholes();
@@ -155,6 +165,9 @@ private:
 	void DrawPointer(const System *system, Angle &angle, const Color &color, bool bigger = false);
 	static void DrawPointer(Point position, Angle &angle, const Color &color, bool drawBack = true, bool bigger = false);
 	
+	// Get the color of the given system in the current coloring mode.
+	Color SystemColor(const System &system) const;
+	
 	
 private:
 	// This is the coloring mode currently used in the cache.
@@ -171,7 +184,6 @@ private:
 		Color nameColor;
 		const Government *government;
 	};
-	std::vector<Node> nodes;
 	
 	class Link {
 	public:
@@ -182,7 +194,59 @@ private:
 		Point end;
 		Color color;
 	};
-	std::vector<Link> links;
+	
+	// The state of each system when its color was last calculated.
+	class SystemState {
+	public:
+		int flags = 0;
+		// The price of the commodity being shown, if any.
+		int price = 0;
+		Color color;
+		// The index of this system's node, or -1 if it is not drawn.
+		int node = -1;
+	};
+	// Everything else that the colors depend on.
+	class Stamp {
+	public:
+		bool operator==(const Stamp &other) const;
+		
+		const Ship *flagship = nullptr;
+		// Which planets with required attributes the flagship can land on.
+		std::vector<bool> access;
+		uint64_t galaxyRevision = 0;
+		uint64_t politicsRevision = 0;
+	};
+	class Cache {
+	public:
+		Stamp stamp;
+		std::map<const System *, SystemState> systems;
+		std::vector<Node> nodes;
+		std::vector<Link> links;
+		// The vertex data for drawing all the nodes and links at once.
+		std::vector<float> ringData;
+		std::vector<float> lineData;
+		uint64_t batchId = 0;
+	};
+	// The caches for all the coloring modes that do not depend on what panel
+	// is showing the map.
+	static std::map<int, Cache> sharedCaches;
+	Cache specialCache;
+	const Cache *cache = &specialCache;
+	
+	// The segments of the travel plan, in map coordinates, and everything that
+	// their colors depend on. They are only worked out again if that changes.
+	class TravelPlan {
+	public:
+		std::vector<const System *> plan;
+		std::vector<std::pair<const Ship *, double>> fuel;
+		const Planet *planet = nullptr;
+		double jumpRange = 0.;
+		uint64_t galaxyRevision = 0;
+		uint64_t conditionsRevision = 0;
+		
+		std::vector<Link> segments;
+	};
+	TravelPlan travelPlan;
 };
 
 
@@ -0,0 +1,290 @@
+/* MapShader.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MapShader.h"
+
+#include "Color.h"
+#include "GpuProfiler.h"
+#include "Point.h"
+#include "RenderQueue.h"
+#include "Screen.h"
+#include "Shader.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+	// The vertex data for one ring is its corner (x, y), its position, and its
+	// color. A line also has an end position after its start position.
+	constexpr int RING_FLOATS = 8;
+	constexpr int LINE_FLOATS = 10;
+	// Each ring or line is drawn as two triangles.
+	const float RING_CORNERS[] = {
+		-1.f, -1.f,
+		-1.f,  1.f,
+		 1.f, -1.f,
+		-1.f,  1.f,
+		 1.f, -1.f,
+		 1.f,  1.f
+	};
+	const float LINE_CORNERS[] = {
+		0.f, -1.f,
+		1.f, -1.f,
+		0.f,  1.f,
+		1.f, -1.f,
+		0.f,  1.f,
+		1.f,  1.f
+	};
+	
+	// Everything needed to draw one kind of batch.
+	class Batch {
+	public:
+		Shader shader;
+		GLint scaleI;
+		GLint centerI;
+		GLint zoomI;
+		// For rings, this is the outer radius. For lines, it is how far each
+		// end of the line is pulled back from the system it ends at.
+		GLint sizeI;
+		GLint widthI;
+		
+		GLuint vao;
+		GLuint vbo;
+		// The ID of the data that is stored in the vbo now.
+		uint64_t id = 0;
+		GLsizei count = 0;
+	};
+	Batch rings;
+	Batch lines;
+	
+	// Look up the uniforms, and create the buffer for the given batch.
+	void InitBatch(Batch &batch, const char *vertexCode, const char *fragmentCode)
+	{
+		batch.shader = Shader(vertexCode, fragmentCode);
+		batch.scaleI = batch.shader.Uniform("scale");
+		batch.centerI = batch.shader.Uniform("center");
+		batch.zoomI = batch.shader.Uniform("zoom");
+		batch.sizeI = batch.shader.Uniform("size");
+		batch.widthI = batch.shader.Uniform("width");
+		
+		glGenVertexArrays(1, &batch.vao);
+		glBindVertexArray(batch.vao);
+		
+		glGenBuffers(1, &batch.vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+	}
+	
+	// Enable the vertex attribute with the given name, which has the given
+	// number of floats starting after the given number of floats.
+	void EnableAttrib(const Batch &batch, const char *name, int size, int offset, int stride)
+	{
+		GLint index = batch.shader.Attrib(name);
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, size, GL_FLOAT, GL_FALSE, stride * sizeof(float),
+			reinterpret_cast<const GLvoid *>(offset * sizeof(float)));
+	}
+	
+	// Bind the given batch and set up the uniforms that all batches have.
+	// Upload the data if it has changed.
+	void Bind(Batch &batch, const vector<float> &data, uint64_t id, int stride, const Point &center, double zoom)
+	{
+		if(!batch.shader.Object())
+			throw runtime_error("MapShader: Draw called before Init().");
+		
+		RenderQueue::Flush();
+		glUseProgram(batch.shader.Object());
+		glBindVertexArray(batch.vao);
+		if(batch.id != id)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(float) * data.size(), data.data(), GL_STATIC_DRAW);
+			GpuProfiler::CountUpload();
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			batch.id = id;
+			batch.count = data.size() / stride;
+		}
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(batch.scaleI, 1, scale);
+		GLfloat position[2] = {static_cast<float>(center.X()), static_cast<float>(center.Y())};
+		glUniform2fv(batch.centerI, 1, position);
+		glUniform1f(batch.zoomI, zoom);
+	}
+	
+	// Draw the given batch, and unbind it.
+	void Draw(const Batch &batch)
+	{
+		glDrawArrays(GL_TRIANGLES, 0, batch.count);
+		GpuProfiler::CountDraw();
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+	}
+	
+	void AddColor(vector<float> &data, const Color &color)
+	{
+		const float *rgba = color.Get();
+		data.insert(data.end(), rgba, rgba + 4);
+	}
+}
+
+
+
+void MapShader::Init()
+{
+	static const char *ringVertexCode =
+		"// vertex map ring shader\n"
+		"uniform vec2 scale;\n"
+		"uniform vec2 center;\n"
+		"uniform float zoom;\n"
+		"uniform float size;\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 position;\n"
+		"in vec4 color;\n"
+		"out vec2 coord;\n"
+		"out vec4 ringColor;\n"
+		
+		"void main() {\n"
+		"  coord = size * vert;\n"
+		"  ringColor = color;\n"
+		"  gl_Position = vec4((zoom * (position + center) + coord) * scale, 0, 1);\n"
+		"}\n";
+	
+	static const char *ringFragmentCode =
+		"// fragment map ring shader\n"
+		"uniform float size;\n"
+		"uniform float width;\n"
+		
+		"in vec2 coord;\n"
+		"in vec4 ringColor;\n"
+		"out vec4 finalColor;\n"
+		
+		"void main() {\n"
+		"  float lenFalloff = width - abs(length(coord) - (size - width));\n"
+		"  finalColor = ringColor * clamp(lenFalloff, 0, 1);\n"
+		"}\n";
+	
+	InitBatch(rings, ringVertexCode, ringFragmentCode);
+	EnableAttrib(rings, "vert", 2, 0, RING_FLOATS);
+	EnableAttrib(rings, "position", 2, 2, RING_FLOATS);
+	EnableAttrib(rings, "color", 4, 4, RING_FLOATS);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	
+	static const char *lineVertexCode =
+		"// vertex map line shader\n"
+		"uniform vec2 scale;\n"
+		"uniform vec2 center;\n"
+		"uniform float zoom;\n"
+		"uniform float size;\n"
+		"uniform float width;\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 start;\n"
+		"in vec2 end;\n"
+		"in vec4 color;\n"
+		"out vec2 tpos;\n"
+		"out float tscale;\n"
+		"out vec4 lineColor;\n"
+		
+		"void main() {\n"
+		"  vec2 from = zoom * (start + center);\n"
+		"  vec2 to = zoom * (end + center);\n"
+		"  vec2 unit = normalize(from - to) * size;\n"
+		"  from -= unit;\n"
+		"  to += unit;\n"
+		"  vec2 len = to - from;\n"
+		"  vec2 u = normalize(len) * width;\n"
+		"  tpos = vert;\n"
+		"  tscale = length(len);\n"
+		"  lineColor = color;\n"
+		"  gl_Position = vec4((from + vert.x * len + vert.y * vec2(u.y, -u.x)) * scale, 0, 1);\n"
+		"}\n";
+	
+	static const char *lineFragmentCode =
+		"// fragment map line shader\n"
+		"in vec2 tpos;\n"
+		"in float tscale;\n"
+		"in vec4 lineColor;\n"
+		"out vec4 finalColor;\n"
+		
+		"void main() {\n"
+		"  float alpha = min(tscale - abs(tpos.x * (2 * tscale) - tscale), 1 - abs(tpos.y));\n"
+		"  finalColor = lineColor * alpha;\n"
+		"}\n";
+	
+	InitBatch(lines, lineVertexCode, lineFragmentCode);
+	EnableAttrib(lines, "vert", 2, 0, LINE_FLOATS);
+	EnableAttrib(lines, "start", 2, 2, LINE_FLOATS);
+	EnableAttrib(lines, "end", 2, 4, LINE_FLOATS);
+	EnableAttrib(lines, "color", 4, 6, LINE_FLOATS);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+
+
+// Add a ring to the given vertex data.
+void MapShader::AddRing(vector<float> &data, const Point &position, const Color &color)
+{
+	for(int i = 0; i < 12; i += 2)
+	{
+		data.push_back(RING_CORNERS[i]);
+		data.push_back(RING_CORNERS[i + 1]);
+		data.push_back(position.X());
+		data.push_back(position.Y());
+		AddColor(data, color);
+	}
+}
+
+
+
+// Add a line to the given vertex data.
+void MapShader::AddLine(vector<float> &data, const Point &from, const Point &to, const Color &color)
+{
+	for(int i = 0; i < 12; i += 2)
+	{
+		data.push_back(LINE_CORNERS[i]);
+		data.push_back(LINE_CORNERS[i + 1]);
+		data.push_back(from.X());
+		data.push_back(from.Y());
+		data.push_back(to.X());
+		data.push_back(to.Y());
+		AddColor(data, color);
+	}
+}
+
+
+
+// Draw the given rings at the given map center and zoom.
+void MapShader::DrawRings(const vector<float> &data, uint64_t id, const Point &center, double zoom, float outer, float inner)
+{
+	Bind(rings, data, id, RING_FLOATS, center, zoom);
+	// Use the same anti-aliasing as RingShader does for filled in rings.
+	float width = .5f * (1.f + outer - inner);
+	glUniform1f(rings.sizeI, outer);
+	glUniform1f(rings.widthI, width);
+	Draw(rings);
+}
+
+
+
+// Draw the given lines at the given map center and zoom.
+void MapShader::DrawLines(const vector<float> &data, uint64_t id, const Point &center, double zoom, float width, float offset)
+{
+	Bind(lines, data, id, LINE_FLOATS, center, zoom);
+	glUniform1f(lines.sizeI, offset);
+	glUniform1f(lines.widthI, width);
+	Draw(lines);
+}
@@ -0,0 +1,48 @@
+/* MapShader.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAP_SHADER_H_
+#define MAP_SHADER_H_
+
+#include <cstdint>
+#include <vector>
+
+class Color;
+class Point;
+
+
+
+// Class for drawing all the system rings or all the links on the map in a
+// single draw call. The rings and lines are given in map coordinates, so the
+// vertex data only needs to be uploaded again when it changes, not when the
+// map is panned or zoomed. They look the same as the ones that RingShader and
+// LineShader would draw at the same screen positions.
+class MapShader {
+public:
+	static void Init();
+	
+	// Add a ring or a line to the given vertex data.
+	static void AddRing(std::vector<float> &data, const Point &position, const Color &color);
+	static void AddLine(std::vector<float> &data, const Point &from, const Point &to, const Color &color);
+	
+	// Draw the given rings, with the given outer and inner radius in pixels,
+	// or the given lines, with the given width and with each end pulled back
+	// by the given offset in pixels. The rings and lines are drawn at the given
+	// map center and zoom. Each new set of vertex data must have a different
+	// ID; it is only uploaded to the GPU if it is not the same as last time.
+	static void DrawRings(const std::vector<float> &data, uint64_t id, const Point &center, double zoom, float outer, float inner);
+	static void DrawLines(const std::vector<float> &data, uint64_t id, const Point &center, double zoom, float width, float offset);
+};
+
+
+
+#endif
@@ -0,0 +1,119 @@
+/* MappedFile.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MappedFile.h"
+
+#include "Files.h"
+
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+
+
+// Map the file at the given path. If it does not exist or is empty, this
+// will have no data.
+MappedFile::MappedFile(const string &path)
+{
+	if(Files::FindArchived(path, data, size))
+		return;
+	
+#if defined _WIN32
+	int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+	wstring widePath(length, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], length);
+	
+	HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+		return;
+	
+	LARGE_INTEGER fileSize;
+	if(GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+	{
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mapping)
+		{
+			void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if(view)
+			{
+				data = static_cast<const char *>(view);
+				size = fileSize.QuadPart;
+				isMapped = true;
+			}
+			// The view stays valid after the handles are closed.
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return;
+	
+	struct stat buf;
+	if(!fstat(fd, &buf) && buf.st_size > 0)
+	{
+		void *mapped = mmap(nullptr, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapped != MAP_FAILED)
+		{
+			data = static_cast<const char *>(mapped);
+			size = buf.st_size;
+			isMapped = true;
+		}
+	}
+	// The mapping stays valid after the file is closed.
+	close(fd);
+#endif
+}
+
+
+
+MappedFile::~MappedFile()
+{
+	if(!isMapped)
+		return;
+	
+#if defined _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast<char *>(data), size);
+#endif
+}
+
+
+
+bool MappedFile::IsEmpty() const
+{
+	return !size;
+}
+
+
+
+const char *MappedFile::Data() const
+{
+	return data;
+}
+
+
+
+size_t MappedFile::Size() const
+{
+	return size;
+}
@@ -0,0 +1,52 @@
+/* MappedFile.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+
+
+// Class that gives read-only access to the contents of a file by mapping it
+// into memory, so that it can be parsed or decoded without first being copied
+// into a buffer. If the file is in one of the mounted archives, this points to
+// its contents in the archive instead. The contents do not end in a null
+// character, so they must only be read up to the given size.
+class MappedFile {
+public:
+	MappedFile() = default;
+	// Map the file at the given path. If it does not exist or is empty, this
+	// will have no data.
+	explicit MappedFile(const std::string &path);
+	~MappedFile();
+	
+	// No copying this class.
+	MappedFile(const MappedFile &other) = delete;
+	MappedFile &operator=(const MappedFile &other) = delete;
+	
+	bool IsEmpty() const;
+	const char *Data() const;
+	size_t Size() const;
+	
+	
+private:
+	const char *data = nullptr;
+	size_t size = 0;
+	// Whether this object mapped the data, and therefore must unmap it.
+	bool isMapped = false;
+};
+
+
+
+#endif
@@ -18,9 +18,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <cmath>
 #include <limits>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 using namespace std;
 
 namespace {
+	// The outline is read two points at a time straight out of its array.
+	static_assert(sizeof(Float2) == 2 * sizeof(float), "Float2 must be two packed floats.");
+	
+#ifdef __SSE2__
+	// Load two consecutive points of an outline, as a vector of their x
+	// coordinates and a vector of their y coordinates.
+	inline void LoadPoints(const Float2 *points, __m128d &x, __m128d &y)
+	{
+		__m128 xy = _mm_loadu_ps(reinterpret_cast<const float *>(points));
+		x = _mm_cvtps_pd(_mm_shuffle_ps(xy, xy, _MM_SHUFFLE(2, 0, 2, 0)));
+		y = _mm_cvtps_pd(_mm_shuffle_ps(xy, xy, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	inline void LoadPoints(const Float2 *points, float64x2_t &x, float64x2_t &y)
+	{
+		float32x2x2_t xy = vld2_f32(reinterpret_cast<const float *>(points));
+		x = vcvt_f64_f32(xy.val[0]);
+		y = vcvt_f64_f32(xy.val[1]);
+	}
+#endif
+	
 	// Trace out a pixmap.
 	void Trace(const ImageBuffer &image, int frame, vector<Point> *raw)
 	{
@@ -206,6 +233,42 @@ namespace {
 			radius = max(radius, p.LengthSquared());
 		return sqrt(radius);
 	}
+	
+	
+	// Find the convex hull of the outline using Andrew's monotone chain
+	// algorithm. The result is in counterclockwise order (with y pointing up),
+	// or empty if the outline does not enclose any area.
+	vector<Point> ComputeHull(vector<Point> points)
+	{
+		if(points.size() < 3)
+			return vector<Point>();
+		
+		sort(points.begin(), points.end(), [](const Point &a, const Point &b)
+			{ return a.X() < b.X() || (a.X() == b.X() && a.Y() < b.Y()); });
+		
+		// Build the lower half of the hull from left to right, then the upper
+		// half from right to left, dropping any point that is not a left turn.
+		vector<Point> hull(2 * points.size());
+		size_t count = 0;
+		for(size_t i = 0; i < points.size(); ++i)
+		{
+			while(count >= 2 && (hull[count - 1] - hull[count - 2]).Cross(points[i] - hull[count - 2]) <= 0.)
+				--count;
+			hull[count++] = points[i];
+		}
+		for(size_t i = points.size() - 1, lower = count + 1; i-- > 0; )
+		{
+			while(count >= lower && (hull[count - 1] - hull[count - 2]).Cross(points[i] - hull[count - 2]) <= 0.)
+				--count;
+			hull[count++] = points[i];
+		}
+		// The last point is the same as the first one.
+		hull.resize(count ? count - 1 : 0);
+		if(hull.size() < 3)
+			hull.clear();
+		hull.shrink_to_fit();
+		return hull;
+	}
 }
 
 
@@ -227,9 +290,30 @@ void Mask::Create(const ImageBuffer &image, int frame)
 	
 	SmoothAndCenter(&raw, Point(image.Width(), image.Height()));
 	
-	Simplify(raw, &outline);
-	
-	radius = ComputeRadius(outline);
+	vector<Point> simplified;
+	Simplify(raw, &simplified);
+	Create(simplified);
+}
+
+
+
+// Construct a mask from an outline that was generated earlier.
+void Mask::Create(const vector<Point> &outline)
+{
+	// The outline is stored in single precision, which is still precise to a
+	// tiny fraction of a pixel. The radius and hull are found from the stored
+	// points, so that they enclose exactly the same outline.
+	this->outline.clear();
+	this->outline.reserve(outline.size());
+	vector<Point> stored;
+	stored.reserve(outline.size());
+	for(const Point &point : outline)
+	{
+		this->outline.emplace_back(point);
+		stored.emplace_back(this->outline.back());
+	}
+	radius = ComputeRadius(stored);
+	hull = ComputeHull(stored);
 }
 
 
@@ -258,6 +342,11 @@ double Mask::Collide(Point sA, Point vA, Angle facing) const
 	sA = (-facing).Rotate(sA);
 	vA = (-facing).Rotate(vA);
 	
+	// Most segments that pass within the radius still miss the outline, and
+	// checking against the convex hull rules them out with far fewer edges.
+	if(!MightTouch(sA, vA))
+		return 1.;
+	
 	// If this point is contained within the mask, a ray drawn out from it will
 	// intersect the mask an even number of times. If that ray coincides with an
 	// edge, ignore that edge, and count all segments as closed at the start and
@@ -280,7 +369,8 @@ bool Mask::Contains(Point point, Angle facing) const
 		return false;
 	
 	// Rotate into the mask's frame of reference.
-	return Contains((-facing).Rotate(point));
+	point = (-facing).Rotate(point);
+	return MightTouch(point, Point()) && Contains(point);
 }
 
 
@@ -299,9 +389,9 @@ bool Mask::WithinRing(Point point, Angle facing, double inner, double outer) con
 	inner *= inner;
 	outer *= outer;
 	
-	for(const Point &p : outline)
+	for(const Float2 &p : outline)
 	{
-		double pSquared = p.DistanceSquared(point);
+		double pSquared = Point(p).DistanceSquared(point);
 		if(pSquared < outer && pSquared > inner)
 			return true;
 	}
@@ -323,8 +413,8 @@ double Mask::Range(Point point, Angle facing) const
 	if(Contains(point))
 		return 0.;
 	
-	for(const Point &p : outline)
-		range = min(range, p.Distance(point));
+	for(const Float2 &p : outline)
+		range = min(range, Point(p).Distance(point));
 	
 	return range;
 }
@@ -339,20 +429,22 @@ double Mask::Radius() const
 
 
 // Get the list of points in the outline.
-const vector<Point> &Mask::Points() const
+const vector<Float2> &Mask::Points() const
 {
 	return outline;
 }
 
 
 
+// Each edge of the outline is checked separately, so where vector instructions
+// are available, two edges are checked at once. The math is done in the same
+// order and the same precision either way, so the results are identical.
 double Mask::Intersection(Point sA, Point vA) const
 {
 	// Keep track of the closest intersection point found.
 	double closest = 1.;
 	
-	Point prev = outline.back();
-	for(const Point &next : outline)
+	auto check = [&closest, &sA, &vA](Point prev, Point next)
 	{
 		// Check if there is an intersection. (If not, the cross would be 0.) If
 		// there is, handle it only if it is a point where the segment is
@@ -370,9 +462,67 @@ double Mask::Intersection(Point sA, Point vA) const
 			if((uB >= 0.) & (uB < cross) & (uA >= 0.))
 				closest = min(closest, uA / cross);
 		}
-		
-		prev = next;
+	};
+	
+	// The first edge wraps around from the last point to the first.
+	check(Point(outline.back()), Point(outline.front()));
+	size_t i = 1;
+#ifdef __SSE2__
+	const __m128d sx = _mm_set1_pd(sA.X());
+	const __m128d sy = _mm_set1_pd(sA.Y());
+	const __m128d vx = _mm_set1_pd(vA.X());
+	const __m128d vy = _mm_set1_pd(vA.Y());
+	const __m128d zero = _mm_setzero_pd();
+	__m128d best = _mm_set1_pd(closest);
+	for( ; i + 1 < outline.size(); i += 2)
+	{
+		__m128d prevX, prevY, nextX, nextY;
+		LoadPoints(&outline[i - 1], prevX, prevY);
+		LoadPoints(&outline[i], nextX, nextY);
+		__m128d bX = _mm_sub_pd(nextX, prevX);
+		__m128d bY = _mm_sub_pd(nextY, prevY);
+		__m128d cross = _mm_sub_pd(_mm_mul_pd(bX, vy), _mm_mul_pd(bY, vx));
+		__m128d sX = _mm_sub_pd(prevX, sx);
+		__m128d sY = _mm_sub_pd(prevY, sy);
+		__m128d uB = _mm_sub_pd(_mm_mul_pd(vx, sY), _mm_mul_pd(vy, sX));
+		__m128d uA = _mm_sub_pd(_mm_mul_pd(bX, sY), _mm_mul_pd(bY, sX));
+		__m128d hit = _mm_and_pd(_mm_and_pd(_mm_cmpgt_pd(cross, zero), _mm_cmpge_pd(uB, zero)),
+			_mm_and_pd(_mm_cmplt_pd(uB, cross), _mm_cmpge_pd(uA, zero)));
+		// Edges that are not hit may divide by zero, but their results are
+		// never used.
+		__m128d fraction = _mm_div_pd(uA, cross);
+		best = _mm_min_pd(best, _mm_or_pd(_mm_and_pd(hit, fraction), _mm_andnot_pd(hit, best)));
 	}
+	closest = min(_mm_cvtsd_f64(best), _mm_cvtsd_f64(_mm_unpackhi_pd(best, best)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const float64x2_t sx = vdupq_n_f64(sA.X());
+	const float64x2_t sy = vdupq_n_f64(sA.Y());
+	const float64x2_t vx = vdupq_n_f64(vA.X());
+	const float64x2_t vy = vdupq_n_f64(vA.Y());
+	const float64x2_t zero = vdupq_n_f64(0.);
+	float64x2_t best = vdupq_n_f64(closest);
+	for( ; i + 1 < outline.size(); i += 2)
+	{
+		float64x2_t prevX, prevY, nextX, nextY;
+		LoadPoints(&outline[i - 1], prevX, prevY);
+		LoadPoints(&outline[i], nextX, nextY);
+		float64x2_t bX = vsubq_f64(nextX, prevX);
+		float64x2_t bY = vsubq_f64(nextY, prevY);
+		float64x2_t cross = vsubq_f64(vmulq_f64(bX, vy), vmulq_f64(bY, vx));
+		float64x2_t sX = vsubq_f64(prevX, sx);
+		float64x2_t sY = vsubq_f64(prevY, sy);
+		float64x2_t uB = vsubq_f64(vmulq_f64(vx, sY), vmulq_f64(vy, sX));
+		float64x2_t uA = vsubq_f64(vmulq_f64(bX, sY), vmulq_f64(bY, sX));
+		uint64x2_t hit = vandq_u64(vandq_u64(vcgtq_f64(cross, zero), vcgeq_f64(uB, zero)),
+			vandq_u64(vcltq_f64(uB, cross), vcgeq_f64(uA, zero)));
+		float64x2_t fraction = vdivq_f64(uA, cross);
+		best = vminq_f64(best, vbslq_f64(hit, fraction, best));
+	}
+	closest = vminvq_f64(best);
+#endif
+	for( ; i < outline.size(); ++i)
+		check(Point(outline[i - 1]), Point(outline[i]));
+	
 	return closest;
 }
 
@@ -388,8 +538,7 @@ bool Mask::Contains(Point point) const
 	// For simplicity, use a ray pointing straight downwards. A segment then
 	// intersects only if its x coordinates span the point's coordinates.
 	int intersections = 0;
-	Point prev = outline.back();
-	for(const Point &next : outline)
+	auto check = [&intersections, &point](Point prev, Point next)
 	{
 		if(prev.X() != next.X())
 			if((prev.X() <= point.X()) == (point.X() < next.X()))
@@ -398,8 +547,80 @@ bool Mask::Contains(Point point) const
 					(point.X() - prev.X()) / (next.X() - prev.X());
 				intersections += (y >= point.Y());
 			}
-		prev = next;
+	};
+	
+	// As in Intersection(), two edges are checked at once where possible.
+	check(Point(outline.back()), Point(outline.front()));
+	size_t i = 1;
+#ifdef __SSE2__
+	const __m128d px = _mm_set1_pd(point.X());
+	const __m128d py = _mm_set1_pd(point.Y());
+	for( ; i + 1 < outline.size(); i += 2)
+	{
+		__m128d prevX, prevY, nextX, nextY;
+		LoadPoints(&outline[i - 1], prevX, prevY);
+		LoadPoints(&outline[i], nextX, nextY);
+		__m128d y = _mm_add_pd(prevY, _mm_div_pd(_mm_mul_pd(_mm_sub_pd(nextY, prevY), _mm_sub_pd(px, prevX)),
+			_mm_sub_pd(nextX, prevX)));
+		// An edge counts if it is not vertical, it spans the point, and it is
+		// below the point.
+		__m128d outside = _mm_xor_pd(_mm_cmple_pd(prevX, px), _mm_cmplt_pd(px, nextX));
+		__m128d hit = _mm_andnot_pd(_mm_cmpeq_pd(prevX, nextX), _mm_andnot_pd(outside, _mm_cmpge_pd(y, py)));
+		int bits = _mm_movemask_pd(hit);
+		intersections += (bits & 1) + (bits >> 1);
 	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const float64x2_t px = vdupq_n_f64(point.X());
+	const float64x2_t py = vdupq_n_f64(point.Y());
+	for( ; i + 1 < outline.size(); i += 2)
+	{
+		float64x2_t prevX, prevY, nextX, nextY;
+		LoadPoints(&outline[i - 1], prevX, prevY);
+		LoadPoints(&outline[i], nextX, nextY);
+		float64x2_t y = vaddq_f64(prevY, vdivq_f64(vmulq_f64(vsubq_f64(nextY, prevY), vsubq_f64(px, prevX)),
+			vsubq_f64(nextX, prevX)));
+		uint64x2_t outside = veorq_u64(vcleq_f64(prevX, px), vcltq_f64(px, nextX));
+		uint64x2_t hit = vbicq_u64(vbicq_u64(vcgeq_f64(y, py), outside), vceqq_f64(prevX, nextX));
+		intersections += (vgetq_lane_u64(hit, 0) & 1) + (vgetq_lane_u64(hit, 1) & 1);
+	}
+#endif
+	for( ; i < outline.size(); ++i)
+		check(Point(outline[i - 1]), Point(outline[i]));
+	
 	// If the number of intersections is odd, the point is within the mask.
 	return (intersections & 1);
 }
+
+
+
+// Check if the given line segment might touch the outline, based on its
+// convex hull. Clip the segment against each edge of the hull in turn; if
+// nothing is left of it, it is entirely outside.
+bool Mask::MightTouch(Point sA, Point vA) const
+{
+	if(hull.empty())
+		return true;
+	
+	double enter = 0.;
+	double exit = 1.;
+	Point prev = hull.back();
+	for(const Point &next : hull)
+	{
+		// The hull is on the left side of each edge. Find where along the
+		// segment it crosses to that side, and which way it is going.
+		Point edge = next - prev;
+		double start = edge.Cross(sA - prev);
+		double rate = edge.Cross(vA);
+		if(rate > 0.)
+			enter = max(enter, -start / rate);
+		else if(rate < 0.)
+			exit = min(exit, -start / rate);
+		else if(start < 0.)
+			return false;
+		if(enter > exit)
+			return false;
+		
+		prev = next;
+	}
+	return true;
+}
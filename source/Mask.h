@@ -34,6 +34,8 @@ public:
 	
 	// Construct a mask from the alpha channel of an image.
 	void Create(const ImageBuffer &image, int frame = 0);
+	// Construct a mask from an outline that was generated earlier.
+	void Create(const std::vector<Point> &outline);
 	
 	// Check whether a mask was successfully loaded.
 	bool IsLoaded() const;
@@ -58,16 +60,23 @@ public:
 	double Radius() const;
 	
 	// Get the list of points in the outline.
-	const std::vector<Point> &Points() const;
+	const std::vector<Float2> &Points() const;
 	
 	
 private:
 	double Intersection(Point sA, Point vA) const;
 	bool Contains(Point point) const;
+	// Check if the given line segment might touch the outline, based on its
+	// convex hull. This is much faster than checking the full outline, and
+	// rules out most of the segments that come within the radius but miss.
+	bool MightTouch(Point sA, Point vA) const;
 	
 	
 private:
-	std::vector<Point> outline;
+	std::vector<Float2> outline;
+	// The convex hull of the outline, in counterclockwise order. It is empty if
+	// the outline is too small to have one.
+	std::vector<Point> hull;
 	double radius;
 };
 
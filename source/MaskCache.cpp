@@ -0,0 +1,171 @@
+/* MaskCache.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MaskCache.h"
+
+#include "BinaryData.h"
+#include "Files.h"
+#include "Mask.h"
+
+using namespace std;
+
+namespace {
+	// The cache file starts with this tag. The version must be changed whenever
+	// the format of the cache or the way that masks are generated changes.
+	const string TAG = "ESMC";
+	const uint32_t VERSION = 1;
+	
+	// The size of each point in a cached outline.
+	const size_t POINT_SIZE = 16;
+}
+
+
+
+// Read the cache from the given path.
+MaskCache::MaskCache(const string &path)
+	: path(path)
+{
+	if(!Files::Exists(path))
+		return;
+	
+	string data = Files::Read(path);
+	if(data.compare(0, TAG.size(), TAG))
+		return;
+	size_t pos = TAG.size();
+	uint32_t version = 0;
+	uint32_t count = 0;
+	if(!BinaryData::Read32(data, pos, version) || version != VERSION || !BinaryData::Read32(data, pos, count))
+		return;
+	
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		string name;
+		Entry entry;
+		uint64_t timestamp = 0;
+		uint32_t points = 0;
+		if(!BinaryData::ReadString(data, pos, name) || !BinaryData::Read64(data, pos, timestamp)
+				|| !BinaryData::Read64(data, pos, entry.hash) || !BinaryData::Read32(data, pos, points)
+				|| points > (data.size() - pos) / POINT_SIZE)
+		{
+			// If the cache has been truncated, discard it entirely.
+			entries.clear();
+			return;
+		}
+		// The size check above ensures that all the points can be read.
+		entry.outline.resize(points);
+		for(Point &point : entry.outline)
+		{
+			double x = 0.;
+			double y = 0.;
+			BinaryData::ReadDouble(data, pos, x);
+			BinaryData::ReadDouble(data, pos, y);
+			point = Point(x, y);
+		}
+		entry.timestamp = timestamp;
+		entries[name] = move(entry);
+	}
+}
+
+
+
+// Get the mask for the given frame of an image, either from the cache or by
+// generating it from the image.
+void MaskCache::Load(const string &path, const ImageBuffer &image, int frame, Mask &mask)
+{
+	int64_t timestamp = Files::Timestamp(path);
+	
+	// If the image has not been modified, there is no need to even hash it.
+	bool isCached = false;
+	{
+		lock_guard<mutex> lock(entryMutex);
+		auto it = entries.find(path);
+		if(it != entries.end() && it->second.timestamp == timestamp)
+		{
+			mask.Create(it->second.outline);
+			it->second.isUsed = true;
+			return;
+		}
+		isCached = (it != entries.end());
+	}
+	
+	// Otherwise, the cached outline can still be used if the contents are the
+	// same. The mutex is not held while reading the file, since that is slow.
+	uint64_t hash = BinaryData::Hash(Files::Read(path));
+	if(isCached)
+	{
+		lock_guard<mutex> lock(entryMutex);
+		auto it = entries.find(path);
+		if(it->second.hash == hash)
+		{
+			mask.Create(it->second.outline);
+			it->second.timestamp = timestamp;
+			it->second.isUsed = true;
+			isChanged = true;
+			return;
+		}
+	}
+	
+	// This image has changed, so its outline must be traced again.
+	mask.Create(image, frame);
+	Entry result;
+	result.timestamp = timestamp;
+	result.hash = hash;
+	for(const Float2 &point : mask.Points())
+		result.outline.emplace_back(point);
+	result.isUsed = true;
+	
+	lock_guard<mutex> lock(entryMutex);
+	entries[path] = move(result);
+	isChanged = true;
+}
+
+
+
+// Write the cache back to disk if anything in it has changed.
+void MaskCache::Save()
+{
+	lock_guard<mutex> lock(entryMutex);
+	// Forget about any images that no longer exist, or that are not in any of
+	// the current data sources.
+	for(auto it = entries.begin(); it != entries.end(); )
+	{
+		if(it->second.isUsed)
+			++it;
+		else
+		{
+			it = entries.erase(it);
+			isChanged = true;
+		}
+	}
+	if(!isChanged)
+		return;
+	
+	string out = TAG;
+	BinaryData::Write32(VERSION, out);
+	BinaryData::Write32(entries.size(), out);
+	for(const auto &it : entries)
+	{
+		BinaryData::WriteString(it.first, out);
+		BinaryData::Write64(it.second.timestamp, out);
+		BinaryData::Write64(it.second.hash, out);
+		BinaryData::Write32(it.second.outline.size(), out);
+		for(const Point &point : it.second.outline)
+		{
+			BinaryData::WriteDouble(point.X(), out);
+			BinaryData::WriteDouble(point.Y(), out);
+		}
+	}
+	// The masks are saved while the game is running, so write the file on a
+	// background thread to avoid stalling the game.
+	Files::WriteInBackground(path, move(out));
+	isChanged = false;
+}
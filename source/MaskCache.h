@@ -0,0 +1,67 @@
+/* MaskCache.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MASK_CACHE_H_
+#define MASK_CACHE_H_
+
+#include "Point.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ImageBuffer;
+class Mask;
+
+
+
+// Class that keeps an on-disk copy of the collision masks generated from each
+// image file, so that they do not have to be traced again every time the game
+// starts. As with the DataCache, each image's entry is reused as long as the
+// file has not been modified, or if it still has the same contents. Masks can
+// be loaded from multiple threads at once.
+class MaskCache {
+public:
+	// Read the cache from the given path. If it does not exist or was written by
+	// an incompatible version of the game, start out with an empty cache.
+	explicit MaskCache(const std::string &path);
+	
+	// Get the mask for the given frame of an image that was read from the given
+	// path, either from the cache or by generating it from the image.
+	void Load(const std::string &path, const ImageBuffer &image, int frame, Mask &mask);
+	// Write the cache back to disk if anything in it has changed. Only the
+	// images that have been loaded since this cache was read are kept.
+	void Save();
+	
+	
+private:
+	class Entry {
+	public:
+		int64_t timestamp = 0;
+		uint64_t hash = 0;
+		std::vector<Point> outline;
+		bool isUsed = false;
+	};
+	
+	
+private:
+	std::string path;
+	std::map<std::string, Entry> entries;
+	bool isChanged = false;
+	std::mutex entryMutex;
+};
+
+
+
+#endif
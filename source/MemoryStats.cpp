@@ -0,0 +1,74 @@
+/* MemoryStats.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MemoryStats.h"
+
+#include "text/Format.h"
+
+#include <atomic>
+
+using namespace std;
+
+namespace {
+	const string NAMES[MemoryStats::CATEGORIES] = {
+		"Sprite textures",
+		"Image buffers",
+		"Collision masks",
+		"Sounds",
+		"Game data"
+	};
+	
+	atomic<int64_t> totals[MemoryStats::CATEGORIES];
+}
+
+
+
+// Record that the given number of bytes was allocated (or, if negative,
+// freed) in the given category.
+void MemoryStats::Add(Category category, int64_t bytes)
+{
+	totals[category] += bytes;
+}
+
+
+
+// Replace the total for a category whose size is measured all at once.
+void MemoryStats::Set(Category category, int64_t bytes)
+{
+	totals[category] = bytes;
+}
+
+
+
+// Get the current total for each category, in bytes.
+vector<pair<string, int64_t>> MemoryStats::Totals()
+{
+	vector<pair<string, int64_t>> result;
+	for(int i = 0; i < CATEGORIES; ++i)
+		result.emplace_back(NAMES[i], totals[i].load());
+	return result;
+}
+
+
+
+// Write a table of the totals, in megabytes.
+void MemoryStats::Print(ostream &out)
+{
+	int64_t sum = 0;
+	out << "category\tMB" << '\n';
+	for(const auto &it : Totals())
+	{
+		out << it.first << '\t' << Format::Decimal(it.second / 1048576., 1) << '\n';
+		sum += it.second;
+	}
+	out << "Total\t" << Format::Decimal(sum / 1048576., 1) << endl;
+}
@@ -0,0 +1,61 @@
+/* MemoryStats.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MEMORY_STATS_H_
+#define MEMORY_STATS_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+// Class for keeping track of how much memory each part of the game is using.
+// Each subsystem reports what it allocates and frees in its own category, from
+// any thread. The totals can be shown in the debug overlay, or printed once
+// the game has finished loading (with the --memory-report option).
+class MemoryStats {
+public:
+	enum Category {
+		// Video memory used by sprite textures, including shared pages.
+		TEXTURES,
+		// Pixels that have been loaded from image files but not yet uploaded.
+		IMAGE_BUFFERS,
+		// The outlines of the sprites' collision masks.
+		MASKS,
+		// Decoded sound effects, in OpenAL buffers.
+		SOUNDS,
+		// The game objects in GameData's sets, including the originals that
+		// are kept for reverting them, but not what those objects allocate.
+		GAME_DATA,
+		CATEGORIES
+	};
+	
+	
+public:
+	// Record that the given number of bytes was allocated (or, if negative,
+	// freed) in the given category.
+	static void Add(Category category, int64_t bytes);
+	// Replace the total for a category whose size is measured all at once.
+	static void Set(Category category, int64_t bytes);
+	
+	// Get the current total for each category, in bytes.
+	static std::vector<std::pair<std::string, int64_t>> Totals();
+	// Write a table of the totals, in megabytes.
+	static void Print(std::ostream &out);
+};
+
+
+
+#endif
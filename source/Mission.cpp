@@ -15,7 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DataNode.h"
 #include "DataWriter.h"
 #include "Dialog.h"
-#include "DistanceMap.h"
+#include "DistanceTable.h"
 #include "Files.h"
 #include "text/Format.h"
 #include "GameData.h"
@@ -286,12 +286,34 @@ void Mission::Load(const DataNode &node)
 			else
 				child.PrintTrace("Skipping unrecognized attribute:");
 		}
+		else if(child.Token(0) == "deferred")
+		{
+			deferred.isDeferred = true;
+			deferred.from = GameData::Missions().Find(name);
+			for(const DataNode &grand : child)
+			{
+				if(grand.Token(0) == "origin" && grand.Size() >= 2)
+					deferred.origin = GameData::Systems().Get(grand.Token(1));
+				else if(grand.Token(0) == "jumps" && grand.Size() >= 2)
+					deferred.jumps = grand.Value(1);
+				else if(grand.Token(0) == "payload" && grand.Size() >= 2)
+					deferred.payload = grand.Value(1);
+				else if(grand.Token(0) == "substitution" && grand.Size() >= 3)
+					deferred.subs[grand.Token(1)] = grand.Token(2);
+				else
+					grand.PrintTrace("Skipping unrecognized attribute:");
+			}
+		}
 		else
 			child.PrintTrace("Skipping unrecognized attribute:");
 	}
 	
 	if(displayName.empty())
 		displayName = name;
+	displayNameTemplate = TextTemplate(displayName);
+	descriptionTemplate = TextTemplate(description);
+	clearanceTemplate = TextTemplate(clearance);
+	blockedTemplate = TextTemplate(blocked);
 	if((isMinor || hasPriority) && location == LANDING)
 		node.PrintTrace("Warning: \"minor\" or \"priority\" tags have no effect on \"landing\" missions:");
 }
@@ -401,6 +423,23 @@ void Mission::Save(DataWriter &out, const string &tag) const
 		for(const MissionAction &action : genericOnEnter)
 			if(!didEnter.count(&action))
 				action.Save(out);
+		
+		// If this job has not been fully instantiated, save what is needed to
+		// finish instantiating it from the mission it came from.
+		if(deferred.isDeferred)
+		{
+			out.Write("deferred");
+			out.BeginChild();
+			{
+				if(deferred.origin)
+					out.Write("origin", deferred.origin->Name());
+				out.Write("jumps", deferred.jumps);
+				out.Write("payload", deferred.payload);
+				for(const auto &it : deferred.subs)
+					out.Write("substitution", it.first, it.second);
+			}
+			out.EndChild();
+		}
 	}
 	out.EndChild();
 }
@@ -471,6 +510,10 @@ bool Mission::IsValid() const
 	if(!clearanceFilter.IsValid())
 		return false;
 	
+	// A job that has not been fully instantiated must still be able to be.
+	if(deferred.isDeferred && (!deferred.from || deferred.from->Identifier() != name))
+		return false;
+	
 	// The instantiated NPCs should also be valid.
 	for(auto &&npc : NPCs())
 		if(!npc.Validate().empty())
@@ -665,8 +708,8 @@ bool Mission::CanOffer(const PlayerInfo &player, const shared_ptr<Ship> &boardin
 	
 	if(repeat)
 	{
-		auto cit = player.Conditions().find(name + ": offered");
-		if(cit != player.Conditions().end() && cit->second >= repeat)
+		const int64_t *offered = player.Conditions().Find(name + ": offered");
+		if(offered && *offered >= repeat)
 			return false;
 	}
 	
@@ -691,6 +734,14 @@ bool Mission::CanOffer(const PlayerInfo &player, const shared_ptr<Ship> &boardin
 
 
 
+// Get the conditions that must be met for this mission to be offered.
+const ConditionSet &Mission::ToOffer() const
+{
+	return toOffer;
+}
+
+
+
 bool Mission::HasSpace(const PlayerInfo &player) const
 {
 	int extraCrew = 0;
@@ -969,6 +1020,13 @@ const list<NPC> &Mission::NPCs() const
 
 
 
+list<NPC> &Mission::NPCs()
+{
+	return npcs;
+}
+
+
+
 // Update which NPCs are active based on their spawn and despawn conditions.
 void Mission::UpdateNPCs(const PlayerInfo &player)
 {
@@ -992,7 +1050,7 @@ bool Mission::HasShip(const shared_ptr<Ship> &ship) const
 
 // If any event occurs between two ships, check to see if this mission cares
 // about it. This may affect the mission status or display a message.
-void Mission::Do(const ShipEvent &event, PlayerInfo &player, UI *ui)
+void Mission::Do(const ShipEvent &event, PlayerInfo &player, UI *ui, bool includeNPCs)
 {
 	if(event.TargetGovernment()->IsPlayer() && !hasFailed)
 	{
@@ -1044,8 +1102,9 @@ void Mission::Do(const ShipEvent &event, PlayerInfo &player, UI *ui)
 			UpdateNPCs(player);
 	}
 	
-	for(NPC &npc : npcs)
-		npc.Do(event, player, ui, isVisible);
+	if(includeNPCs)
+		for(NPC &npc : npcs)
+			npc.Do(event, player, ui, isVisible);
 }
 
 
@@ -1205,19 +1264,17 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 	while(!destinations.empty())
 	{
 		// Find the closest destination to this location.
-		DistanceMap distance(path);
 		auto it = destinations.begin();
 		auto bestIt = it;
 		for(++it; it != destinations.end(); ++it)
-			if(distance.Days(*it) < distance.Days(*bestIt))
+			if(DistanceTable::Jumps(path, *it) < DistanceTable::Jumps(path, *bestIt))
 				bestIt = it;
 		
+		jumps += DistanceTable::Jumps(path, *bestIt);
 		path = *bestIt;
-		jumps += distance.Days(*bestIt);
 		destinations.erase(bestIt);
 	}
-	DistanceMap distance(path);
-	jumps += distance.Days(result.destination->GetSystem());
+	jumps += DistanceTable::Jumps(path, result.destination->GetSystem());
 	int64_t payload = static_cast<int64_t>(result.cargoSize) + 10 * static_cast<int64_t>(result.passengers);
 	
 	// Set the deadline, if requested.
@@ -1278,7 +1335,7 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 		subs["<waypoints>"] = systems;
 	}
 	
-	// Instantiate the NPCs. This also fills in the "<npc>" substitution.
+	// Make sure that the NPCs and actions can all be instantiated.
 	string reason;
 	for(auto &&n : npcs)
 		reason = n.Validate(true);
@@ -1288,11 +1345,6 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 			+ Identifier() + "\" uses invalid " + std::move(reason));
 		return result;
 	}
-	for(const NPC &npc : npcs)
-		result.npcs.push_back(npc.Instantiate(subs, source, result.destination->GetSystem()));
-	
-	// Instantiate the actions. The "complete" action is always first so that
-	// the "<payment>" substitution can be filled in.
 	auto ait = actions.begin();
 	for( ; ait != actions.end(); ++ait)
 	{
@@ -1306,9 +1358,6 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 			+ Identifier() + "\" uses invalid " + std::move(reason));
 		return result;
 	}
-	for(const auto &it : actions)
-		result.actions[it.first] = it.second.Instantiate(subs, source, jumps, payload);
-	
 	auto oit = onEnter.begin();
 	for( ; oit != onEnter.end(); ++oit)
 	{
@@ -1322,9 +1371,6 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 			+ Identifier() + "\" uses invalid " + std::move(reason));
 		return result;
 	}
-	for(const auto &it : onEnter)
-		result.onEnter[it.first] = it.second.Instantiate(subs, source, jumps, payload);
-	
 	auto eit = genericOnEnter.begin();
 	for( ; eit != genericOnEnter.end(); ++eit)
 	{
@@ -1338,14 +1384,40 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 			+ Identifier() + "\" uses invalid " + std::move(reason));
 		return result;
 	}
-	for(const MissionAction &action : genericOnEnter)
-		result.genericOnEnter.emplace_back(action.Instantiate(subs, source, jumps, payload));
+	
+	// Many jobs are offered every time the player lands, and most of them are
+	// never accepted, so a job's NPCs and actions are only instantiated once it
+	// is accepted. Until then, only its text is needed, and that only depends on
+	// the NPCs if it names one of them, and on the actions for the payment.
+	if(location == JOB)
+	{
+		auto namesNPC = [](const string &text) noexcept -> bool { return text.find("<npc>") != string::npos; };
+		if(namesNPC(displayName) || namesNPC(description) || namesNPC(clearance) || namesNPC(blocked))
+			for(const NPC &npc : npcs)
+				result.npcs.push_back(npc.Instantiate(subs, source, result.destination->GetSystem()));
+		
+		// Instantiating any action defines "<payment>", even if it is empty.
+		if(!actions.empty() || !onEnter.empty() || !genericOnEnter.empty())
+			subs["<payment>"];
+		auto cit = actions.find(COMPLETE);
+		if(cit != actions.end())
+			cit->second.SubstitutePayment(subs, jumps, payload);
+		
+		result.deferred.isDeferred = true;
+		result.deferred.from = this;
+		result.deferred.origin = source;
+		result.deferred.jumps = jumps;
+		result.deferred.payload = payload;
+		result.deferred.subs = subs;
+	}
+	else
+		result.InstantiateActions(*this, subs, source, jumps, payload);
 	
 	// Perform substitution in the name and description.
-	result.displayName = Format::Replace(displayName, subs);
-	result.description = Format::Replace(description, subs);
-	result.clearance = Format::Replace(clearance, subs);
-	result.blocked = Format::Replace(blocked, subs);
+	result.displayName = displayNameTemplate.Replace(subs);
+	result.description = descriptionTemplate.Replace(subs);
+	result.clearance = clearanceTemplate.Replace(subs);
+	result.blocked = blockedTemplate.Replace(subs);
 	result.clearanceFilter = clearanceFilter;
 	result.hasFullClearance = hasFullClearance;
 	
@@ -1355,6 +1427,41 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 
 
 
+// If this is a job that was offered but has not been fully instantiated yet,
+// instantiate its NPCs and actions. This must be done before it is accepted.
+void Mission::FinishInstantiating()
+{
+	if(!deferred.isDeferred || !deferred.from)
+		return;
+	
+	InstantiateActions(*deferred.from, deferred.subs, deferred.origin, deferred.jumps, deferred.payload);
+	deferred = Deferred();
+}
+
+
+
+// Instantiate the NPCs (unless they already have been) and the actions of the
+// given mission template for this mission.
+void Mission::InstantiateActions(const Mission &from, map<string, string> &subs,
+	const System *origin, int jumps, int64_t payload)
+{
+	// Instantiating the NPCs also fills in the "<npc>" substitution.
+	if(npcs.empty())
+		for(const NPC &npc : from.npcs)
+			npcs.push_back(npc.Instantiate(subs, origin, destination->GetSystem()));
+	
+	// The "complete" action is always first so that the "<payment>"
+	// substitution can be filled in.
+	for(const auto &it : from.actions)
+		actions[it.first] = it.second.Instantiate(subs, origin, jumps, payload);
+	for(const auto &it : from.onEnter)
+		onEnter[it.first] = it.second.Instantiate(subs, origin, jumps, payload);
+	for(const MissionAction &action : from.genericOnEnter)
+		genericOnEnter.emplace_back(action.Instantiate(subs, origin, jumps, payload));
+}
+
+
+
 // Perform an "on enter" MissionAction associated with the current system.
 // Returns true if an action was performed.
 bool Mission::Enter(const System *system, PlayerInfo &player, UI *ui)
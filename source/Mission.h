@@ -18,6 +18,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "LocationFilter.h"
 #include "MissionAction.h"
 #include "NPC.h"
+#include "text/TextTemplate.h"
 
 #include <list>
 #include <map>
@@ -105,6 +106,8 @@ public:
 	// into account, so before actually offering a mission you should also check
 	// if the player has enough space.
 	bool CanOffer(const PlayerInfo &player, const std::shared_ptr<Ship> &boardingShip = nullptr) const;
+	// Get the conditions that must be met for this mission to be offered.
+	const ConditionSet &ToOffer() const;
 	bool HasSpace(const PlayerInfo &player) const;
 	bool HasSpace(const Ship &ship) const;
 	bool CanComplete(const PlayerInfo &player) const;
@@ -136,13 +139,16 @@ public:
 	// Get a list of NPCs associated with this mission. Every time the player
 	// takes off from a planet, they should be added to the active ships.
 	const std::list<NPC> &NPCs() const;
+	std::list<NPC> &NPCs();
 	// Update which NPCs are active based on their spawn and despawn conditions.
 	void UpdateNPCs(const PlayerInfo &player);
 	// Checks if the given ship belongs to one of the mission's NPCs.
 	bool HasShip(const std::shared_ptr<Ship> &ship) const;
 	// If any event occurs between two ships, check to see if this mission cares
-	// about it. This may affect the mission status or display a message.
-	void Do(const ShipEvent &event, PlayerInfo &player, UI *ui);
+	// about it. This may affect the mission status or display a message. The
+	// event is also passed on to this mission's NPCs, unless the caller has
+	// already looked up which NPC (if any) the event's target belongs to.
+	void Do(const ShipEvent &event, PlayerInfo &player, UI *ui, bool includeNPCs = true);
 	
 	// Get the internal name used for this mission. This name is unique and is
 	// never modified by string substitution, so it can be used in condition
@@ -156,15 +162,34 @@ public:
 	// "Instantiate" a mission by replacing randomly selected values and places
 	// with a single choice, and then replacing any wildcard text as well.
 	Mission Instantiate(const PlayerInfo &player, const std::shared_ptr<Ship> &boardingShip = nullptr) const;
+	// Jobs are instantiated without their NPCs and actions, because most jobs
+	// are never accepted. This instantiates the rest of a job, and must be
+	// called before it is accepted. It does nothing for any other mission.
+	void FinishInstantiating();
 	
 	
 private:
 	bool Enter(const System *system, PlayerInfo &player, UI *ui);
+	// Instantiate the NPCs and actions of the given mission template.
+	void InstantiateActions(const Mission &from, std::map<std::string, std::string> &subs,
+		const System *origin, int jumps, int64_t payload);
 	// For legacy code, contraband definitions can be placed in two different
 	// locations, so move that parsing out to a helper function.
 	bool ParseContraband(const DataNode &node);
 	
 	
+private:
+	// What is needed to finish instantiating a job after it has been offered.
+	struct Deferred {
+		bool isDeferred = false;
+		const Mission *from = nullptr;
+		const System *origin = nullptr;
+		int jumps = 0;
+		int64_t payload = 0;
+		std::map<std::string, std::string> subs;
+	};
+	
+	
 private:
 	std::string name;
 	std::string displayName;
@@ -182,6 +207,11 @@ private:
 	int deadlineMultiplier = 0;
 	std::string clearance;
 	LocationFilter clearanceFilter;
+	// The text that is filled in when this mission is instantiated.
+	TextTemplate displayNameTemplate;
+	TextTemplate descriptionTemplate;
+	TextTemplate clearanceTemplate;
+	TextTemplate blockedTemplate;
 	bool hasFullClearance = true;
 	
 	int repeat = 1;
@@ -225,6 +255,8 @@ private:
 	std::list<MissionAction> genericOnEnter;
 	// Track which `on enter` MissionActions have triggered.
 	std::set<const MissionAction *> didEnter;
+	
+	Deferred deferred;
 };
 
 
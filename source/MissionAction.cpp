@@ -78,16 +78,13 @@ namespace {
 			cargo.Remove(outfit, moved);
 			didCargo = true;
 		}
-		while(count)
+		// Install or remove as many as the flagship allows all at once, rather
+		// than one at a time, so its attributes are only updated once.
+		int moved = flagship->Attributes().CanAdd(*outfit, count);
+		if(moved)
 		{
-			int moved = (count > 0) ? 1 : -1;
-			if(flagship->Attributes().CanAdd(*outfit, moved))
-			{
-				flagship->AddOutfit(outfit, moved);
-				didShip = true;
-			}
-			else
-				break;
+			flagship->AddOutfit(outfit, moved);
+			didShip = true;
 			count -= moved;
 		}
 		if(count > 0)
@@ -255,6 +252,9 @@ void MissionAction::Load(const DataNode &node, const string &missionName)
 		else
 			conditions.Add(child);
 	}
+	
+	logTemplate = TextTemplate(logText);
+	dialogTemplate = TextTemplate(dialogText);
 }
 
 
@@ -557,25 +557,25 @@ MissionAction MissionAction::Instantiate(map<string, string> &subs, const System
 		result.giftShips.emplace_back(it.first, !it.second.empty() ? it.second : GameData::Phrases().Get("civilian")->Get());
 	result.giftOutfits = giftOutfits;
 	result.requiredOutfits = requiredOutfits;
-	result.payment = payment + (jumps + 1) * payload * paymentMultiplier;
 	// Fill in the payment amount if this is the "complete" action.
 	string previousPayment = subs["<payment>"];
-	if(result.payment)
-		subs["<payment>"] = Format::Credits(abs(result.payment))
-			+ (result.payment == 1 ? " credit" : " credits");
+	result.payment = SubstitutePayment(subs, jumps, payload);
 	
-	if(!logText.empty())
-		result.logText = Format::Replace(logText, subs);
+	if(!logTemplate.IsEmpty())
+		result.logText = logTemplate.Replace(subs);
 	for(const auto &it : specialLogText)
 		for(const auto &eit : it.second)
 			result.specialLogText[it.first][eit.first] = Format::Replace(eit.second, subs);
 	
 	// Create any associated dialog text from phrases, or use the directly specified text.
-	string dialogText = stockDialogPhrase ? stockDialogPhrase->Get()
-		: (!dialogPhrase.Name().empty() ? dialogPhrase.Get()
-		: this->dialogText);
-	if(!dialogText.empty())
-		result.dialogText = Format::Replace(dialogText, subs);
+	if(stockDialogPhrase || !dialogPhrase.Name().empty())
+	{
+		string dialogText = stockDialogPhrase ? stockDialogPhrase->Get() : dialogPhrase.Get();
+		if(!dialogText.empty())
+			result.dialogText = Format::Replace(dialogText, subs);
+	}
+	else if(!dialogTemplate.IsEmpty())
+		result.dialogText = dialogTemplate.Replace(subs);
 	
 	if(stockConversation)
 		result.conversation = stockConversation->Substitute(subs);
@@ -593,3 +593,14 @@ MissionAction MissionAction::Instantiate(map<string, string> &subs, const System
 	
 	return result;
 }
+
+
+
+int64_t MissionAction::SubstitutePayment(map<string, string> &subs, int jumps, int64_t payload) const
+{
+	int64_t result = payment + (jumps + 1) * payload * paymentMultiplier;
+	if(result)
+		subs["<payment>"] = Format::Credits(abs(result))
+			+ (result == 1 ? " credit" : " credits");
+	return result;
+}
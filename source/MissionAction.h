@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Conversation.h"
 #include "LocationFilter.h"
 #include "Phrase.h"
+#include "text/TextTemplate.h"
 
 #include <cstdint>
 #include <map>
@@ -69,6 +70,9 @@ public:
 	// "Instantiate" this action by filling in the wildcard text for the actual
 	// destination, payment, cargo, etc.
 	MissionAction Instantiate(std::map<std::string, std::string> &subs, const System *origin, int jumps, int64_t payload) const;
+	// Fill in the "<payment>" substitution the same way Instantiate() does, but
+	// without instantiating anything else. Return the payment.
+	int64_t SubstitutePayment(std::map<std::string, std::string> &subs, int jumps, int64_t payload) const;
 	
 	
 private:
@@ -80,6 +84,9 @@ private:
 	std::map<std::string, std::map<std::string, std::string>> specialLogText;
 	
 	std::string dialogText;
+	// The log and dialog text, ready to be filled in by Instantiate().
+	TextTemplate logTemplate;
+	TextTemplate dialogTemplate;
 	const Phrase *stockDialogPhrase = nullptr;
 	Phrase dialogPhrase;
 	
@@ -384,15 +384,7 @@ bool MissionPanel::Click(int x, int y, int clicks)
 	}
 	
 	// Figure out if a system was clicked on.
-	Point click = Point(x, y) / Zoom() - center;
-	const System *system = nullptr;
-	for(const auto &it : GameData::Systems())
-		if(it.second.IsValid() && click.Distance(it.second.Position()) < 10.
-				&& (player.HasSeen(it.second) || &it.second == specialSystem))
-		{
-			system = &it.second;
-			break;
-		}
+	const System *system = SystemAt(x, y);
 	if(system)
 	{
 		Select(system);
@@ -601,20 +593,16 @@ void MissionPanel::DrawMissionSystem(const Mission &mission, const Color &color)
 	
 	double zoom = Zoom();
 	auto drawRing = [&](const System *system, const Color &drawColor)
-		{ RingShader::Add(zoom * (system->Position() + center), 22.f, 20.5f, drawColor); };
-	
-	RingShader::Bind();
-	{
-		// Draw a colored ring around the destination system.
-		drawRing(mission.Destination()->GetSystem(), color);
-		// Draw bright rings around systems that still need to be visited.
-		for(const System *system : toVisit)
-			drawRing(system, waypoint);
-		// Draw faint rings around systems already visited for this mission.
-		for(const System *system : hasVisited)
-			drawRing(system, visited);
-	}
-	RingShader::Unbind();
+		{ RingShader::Draw(zoom * (system->Position() + center), 22.f, 20.5f, drawColor); };
+	
+	// Draw a colored ring around the destination system.
+	drawRing(mission.Destination()->GetSystem(), color);
+	// Draw bright rings around systems that still need to be visited.
+	for(const System *system : toVisit)
+		drawRing(system, waypoint);
+	// Draw faint rings around systems already visited for this mission.
+	for(const System *system : hasVisited)
+		drawRing(system, visited);
 }
 
 
@@ -644,8 +632,12 @@ Point MissionPanel::DrawPanel(Point pos, const string &label, int entries) const
 	while(dy && edgePos.Y() > Screen::Top())
 	{
 		edgePos.Y() -= dy;
-		SpriteShader::Draw(left, edgePos + leftOff);
-		SpriteShader::Draw(right, edgePos + rightOff);
+		// If the list is very long, most of it may be below the screen.
+		if(edgePos.Y() - dy < Screen::Bottom())
+		{
+			SpriteShader::Draw(left, edgePos + leftOff);
+			SpriteShader::Draw(right, edgePos + rightOff);
+		}
 		edgePos.Y() -= dy;
 	}
 	
@@ -677,6 +669,10 @@ Point MissionPanel::DrawList(const list<Mission> &list, Point pos) const
 			continue;
 		
 		pos.Y() += 20.;
+		// Only the rows that are on screen need to be drawn, or checked for
+		// whether the player can accept them. There may be hundreds of jobs.
+		if(pos.Y() + 20. < Screen::Top() || pos.Y() > Screen::Bottom())
+			continue;
 		
 		bool isSelected = (it == availableIt || it == acceptedIt);
 		if(isSelected)
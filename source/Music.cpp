@@ -13,21 +13,24 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Music.h"
 
 #include "Files.h"
+#include "MusicDecoder.h"
 
-#include <mad.h>
-
-#include <algorithm>
-#include <cstring>
+#include <chrono>
 #include <map>
 
 using namespace std;
 
 namespace {
-	// How many bytes to read from the file at a time:
-	const size_t INPUT_CHUNK = 65536;
 	// How many samples to put in each output block. Because the output is in
 	// stereo, the duration of the sample is half this amount:
 	const size_t OUTPUT_CHUNK = 32768;
+	// How many samples the decoding thread may get ahead of playback. A few
+	// blocks are queued up, just in case NextChunk() gets called several times
+	// in rapid succession.
+	const size_t RING_SIZE = 4 * OUTPUT_CHUNK;
+	// When the ring is full, how long the decoding thread waits before checking
+	// whether space has been freed up.
+	const chrono::milliseconds WRITE_WAIT(10);
 	
 	map<string, string> paths;
 }
@@ -47,8 +50,7 @@ void Music::Init(const vector<string> &sources)
 			// Sanity check on the path length.
 			if(path.length() < root.length() + 4)
 				continue;
-			string ext = path.substr(path.length() - 4);
-			if(ext != ".mp3" && ext != ".MP3")
+			if(!MusicDecoder::IsSupported(path))
 				continue;
 			
 			string name = path.substr(root.length(), path.length() - root.length() - 4);
@@ -62,7 +64,8 @@ void Music::Init(const vector<string> &sources)
 // Music constructor, which starts the decoding thread. Initially, the thread
 // has no file to read, so it will sleep until a file is specified.
 Music::Music()
-	: silence(OUTPUT_CHUNK, 0)
+	: silence(OUTPUT_CHUNK, 0), current(OUTPUT_CHUNK, 0), ring(RING_SIZE, 0),
+	writeIndex(0), readIndex(0), started(0), startIndex(0)
 {
 	// Don't start the thread until this object is fully constructed.
 	thread = std::thread(&Music::Decode, this);
@@ -80,11 +83,6 @@ Music::~Music()
 	}
 	condition.notify_all();
 	thread.join();
-	
-	// If the decode thread has not yet taken possession of the next file, it is
-	// our job to close it.
-	if(nextFile)
-		fclose(nextFile);
 }
 
 
@@ -102,15 +100,11 @@ void Music::SetSource(const string &name)
 	previousPath = path;
 	
 	// Inform the decoding thread that it should switch to decoding a new file.
+	// Opening the file is left to that thread, so this never blocks on a disk.
 	unique_lock<mutex> lock(decodeMutex);
-	if(path.empty())
-		nextFile = nullptr;
-	else
-		nextFile = Files::Open(path);
+	nextPath = path;
 	hasNewFile = true;
-	
-	// Also clear any decoded data left over from the previous file.
-	next.clear();
+	++requested;
 	
 	// Notify the decoding thread that it can start.
 	lock.unlock();
@@ -122,25 +116,28 @@ void Music::SetSource(const string &name)
 // Get the next audio buffer to play.
 const vector<int16_t> &Music::NextChunk()
 {
-	// Check whether the "next" buffer is ready.
-	unique_lock<mutex> lock(decodeMutex);
-	if(next.size() < OUTPUT_CHUNK)
+	// Until the decoding thread has started on the most recent file, anything
+	// in the ring is left over from the previous one.
+	if(started.load(memory_order_acquire) != requested)
 		return silence;
 	
-	// If the next buffer is ready, move a chunk of data into the output buffer.
-	// All output buffers need to be the same size so that we can fade between
-	// two different sources.
-	current.clear();
-	current.insert(current.begin(), next.begin(), next.begin() + OUTPUT_CHUNK);
-	next.erase(next.begin(), next.begin() + OUTPUT_CHUNK);
+	// Skip over any samples from the previous file.
+	size_t read = max(readIndex.load(memory_order_relaxed), startIndex.load(memory_order_relaxed));
+	size_t available = writeIndex.load(memory_order_acquire) - read;
+	if(available < OUTPUT_CHUNK)
+	{
+		readIndex.store(read, memory_order_release);
+		return silence;
+	}
 	
-	// Once the lock is unlocked, notify the decoding thread to continue.
-	lock.unlock();
-	condition.notify_all();
+	// Move a chunk of data into the output buffer. All output buffers need to
+	// be the same size so that we can fade between two different sources.
+	for(size_t i = 0; i < OUTPUT_CHUNK; ++i)
+		current[i] = ring[(read + i) % RING_SIZE];
+	// Hand that part of the ring back to the decoding thread.
+	readIndex.store(read + OUTPUT_CHUNK, memory_order_release);
 	
-	// Return the buffer.
 	return current;
-	
 }
 
 
@@ -148,18 +145,14 @@ const vector<int16_t> &Music::NextChunk()
 // Entry point for the decoding thread.
 void Music::Decode()
 {
-	// This vector will store the input from the file.
-	vector<unsigned char> input(INPUT_CHUNK, 0);
-	// Objects for MP3 decoding:
-	mad_stream stream;
-	mad_frame frame;
-	mad_synth synth;
+	// This vector will store each block of decoded samples.
+	vector<int16_t> samples;
 	// Loop until the thread is told to quit.
 	while(true)
 	{
 		// First, wait until a new file has been specified or we're done.
-		FILE *file = nullptr;
-		while(!file)
+		string path;
+		unsigned request = 0;
 		{
 			unique_lock<mutex> lock(decodeMutex);
 			while(!done && !hasNewFile)
@@ -169,108 +162,70 @@ void Music::Decode()
 			if(done)
 				return;
 			
-			// The new file now belongs to us, and it's our job to close it.
-			file = nextFile;
-			nextFile = nullptr;
+			path = nextPath;
+			request = requested;
 			hasNewFile = false;
 		}
 		
-		// Now, we have a file to read. Initialize the decoder.
-		mad_stream_init(&stream);
-		mad_frame_init(&frame);
-		mad_synth_init(&synth);
+		// Everything that was written to the ring before this point belongs to
+		// the previous file.
+		startIndex.store(writeIndex.load(memory_order_relaxed), memory_order_relaxed);
+		started.store(request, memory_order_release);
 		
-		// Loop until we are asked to switch files.
+		// Now, open the file and pick a decoder for it. An empty path means
+		// there is nothing to play.
+		unique_ptr<MusicDecoder> decoder;
+		if(!path.empty())
+			decoder = MusicDecoder::Create(path);
+		if(!decoder)
+			continue;
+		
+		// Loop until we are asked to switch files, or the file is unreadable.
 		while(true)
 		{
-			// If the "next" buffer has filled up, wait until it is retrieved.
-			// Generally try to queue up two chunks worth of samples in it, just
-			// in case NextChunk() gets called twice in rapid succession.
+			samples.clear();
+			if(!decoder->Decode(samples) || !Write(samples))
+				break;
+		}
+	}
+}
+
+
+
+// Copy the given samples into the ring buffer, waiting for space to free up if
+// it is full. Return false if decoding of this file should stop.
+bool Music::Write(const vector<int16_t> &samples)
+{
+	size_t written = 0;
+	while(true)
+	{
+		// Check if we're done or if we need to switch files. If so, there is no
+		// need to finish writing these samples.
+		{
 			unique_lock<mutex> lock(decodeMutex);
-			while(!done && next.size() >= 2 * OUTPUT_CHUNK)
-				condition.wait(lock);
-			// Check if we're done or if we need to switch files.
 			if(done || hasNewFile)
-				break;
+				return false;
+			if(written == samples.size())
+				return true;
 			
-			// The lock can be freed until we start filling the output buffer.
-			lock.unlock();
-			
-			// See if any input data is left undecoded in the stream. Typically
-			// this is because the last block of input contained a fraction of a
-			// full MP3 frame.
-			size_t remainder = 0;
-			if(stream.next_frame && stream.next_frame < stream.bufend)
-				remainder = stream.bufend - stream.next_frame;
-			if(remainder)
-				memcpy(&input.front(), stream.next_frame, remainder);
-			
-			// Now, read a chunk of data from the file.
-			size_t read = fread(&input.front() + remainder, 1, INPUT_CHUNK - remainder, file);
-			// If you get the end of the file, loop around to the beginning.
-			if(!read || feof(file))
-				rewind(file);
-			// If there is nothing to decode, return to the top of this loop.
-			if(!(read + remainder))
-				continue;
-			
-			// Hand the input to the stream decoder.
-			mad_stream_buffer(&stream, &input.front(), read + remainder);
-			
-			// Loop through the decoded result for that input block.
-			while(true)
+			// If the ring is full, wait until NextChunk() frees some of it up.
+			// NextChunk() never waits on the decoding thread, so it does not
+			// signal when it does that; just check back in a moment.
+			size_t write = writeIndex.load(memory_order_relaxed);
+			if(write - readIndex.load(memory_order_acquire) == RING_SIZE)
 			{
-				// Decode the next frame, and check if there is an error.
-				if(mad_frame_decode(&frame, &stream))
-				{
-					// For recoverable errors, keep going.
-					if(MAD_RECOVERABLE(stream.error))
-						continue;
-					else
-						break;
-				}
-				// Convert the decoded audio into a PCM signal.
-				mad_synth_frame(&synth, &frame);
-				
-				// If the source is mono, read both output channels from the left input.
-				// Otherwise, read two separate input channels.
-				mad_fixed_t *channels[2] = {
-					synth.pcm.samples[0],
-					synth.pcm.samples[synth.pcm.channels > 1]
-				};
-				
-				// For this part, we need access to the output buffer.
-				lock.lock();
-				if(done || hasNewFile)
-					break;
-	
-				// We'll alternate what channel we read from each time through the loop.
-				int channel = 0;
-				for(unsigned i = 0; i < 2 * synth.pcm.length; ++i)
-				{
-					// Read the next sample from the next channel.
-					mad_fixed_t sample = *channels[channel]++;
-					channel = !channel;
-		
-					// Clip and scale the sample to 16 bits.
-					sample += (1L << (MAD_F_FRACBITS - 16));
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-					sample = max(-MAD_F_ONE, min(MAD_F_ONE - 1, sample));
-#pragma GCC diagnostic pop
-					next.push_back(sample >> (MAD_F_FRACBITS + 1 - 16));
-				}
-				// Now, the "next" buffer can be used by others. In theory, the
-				// NextChunk() function could take what's in that buffer while
-				// we are right in the middle of this decoding cycle.
-				lock.unlock();
+				condition.wait_for(lock, WRITE_WAIT);
+				continue;
 			}
 		}
 		
-		// Clean up.
-		mad_synth_finish(&synth);
-		mad_frame_finish(&frame);
-		mad_stream_finish(&stream);
-		fclose(file);
+		// The lock can be freed while filling in the ring buffer.
+		size_t write = writeIndex.load(memory_order_relaxed);
+		size_t space = RING_SIZE - (write - readIndex.load(memory_order_acquire));
+		size_t count = min(space, samples.size() - written);
+		for(size_t i = 0; i < count; ++i)
+			ring[(write + i) % RING_SIZE] = samples[written + i];
+		writeIndex.store(write + count, memory_order_release);
+		written += count;
 	}
 }
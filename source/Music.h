@@ -13,9 +13,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef MUSIC_H_
 #define MUSIC_H_
 
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
-#include <cstdio>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -23,11 +23,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 
 
-// The Music class streams mp3 audio from a file and delivers it to the program
-// on "block" at a time, so it never needs to hold the entire decoded file in
-// memory. Each block is 16-bit stereo, 44100 Hz. If no file is specified, or if
-// the decoding thread is not done yet, it returns silence rather than blocking,
-// so the game won't freeze if the music stops for some reason.
+// The Music class streams audio from a file (using whichever MusicDecoder can
+// read that file's format) and delivers it to the program one "block" at a
+// time, so it never needs to hold the entire decoded file in memory. Each block
+// is 16-bit stereo, 44100 Hz. If no file is specified, or if the decoding thread
+// is not done yet, it returns silence rather than blocking, so the game won't
+// freeze if the music stops for some reason.
 class Music {
 public:
 	static void Init(const std::vector<std::string> &sources);
@@ -44,20 +45,35 @@ public:
 private:
 	// This is the entry point for the decoding thread.
 	void Decode();
+	// Copy the given samples into the ring buffer, waiting for space to free
+	// up if it is full. Return false if decoding of this file should stop.
+	bool Write(const std::vector<int16_t> &samples);
 	
 	
 private:
 	// Buffers for storing the decoded audio sample. The "silence" buffer holds
 	// a block of silence to be returned if nothing was read from the file.
 	std::vector<int16_t> silence;
-	std::vector<int16_t> next;
 	std::vector<int16_t> current;
 	
+	// Decoded samples are handed from the decoding thread to NextChunk()
+	// through this ring buffer. Only the decoding thread advances the write
+	// index and only NextChunk() advances the read index, so neither side
+	// ever has to lock the other out. Both indices only ever increase.
+	std::vector<int16_t> ring;
+	std::atomic<size_t> writeIndex;
+	std::atomic<size_t> readIndex;
+	// Each call to SetSource() is a new request. Once the decoding thread
+	// starts on a request, it records where in the ring that file's samples
+	// begin; anything before that is left over from the previous file.
+	unsigned requested = 0;
+	std::atomic<unsigned> started;
+	std::atomic<size_t> startIndex;
+	
 	std::string previousPath;
-	// This pointer holds the file for as long as it is owned by the main
-	// thread. When the decode thread takes possession of it, it sets this
-	// pointer to null.
-	FILE *nextFile = nullptr;
+	// The file for the decoding thread to switch to. The mutex only guards
+	// this hand-off, not the decoded samples.
+	std::string nextPath;
 	bool hasNewFile = false;
 	bool done = false;
 	
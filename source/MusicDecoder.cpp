@@ -0,0 +1,280 @@
+/* MusicDecoder.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MusicDecoder.h"
+
+#include "Files.h"
+
+#include <mad.h>
+#include <vorbis/vorbisfile.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+	// The sample rate that all music must be played at.
+	const long SAMPLE_RATE = 44100;
+	// How many bytes to read from an MP3 file at a time:
+	const size_t INPUT_CHUNK = 65536;
+	// How many bytes of samples to decode from an Ogg Vorbis file at a time:
+	const int OUTPUT_BYTES = 16384;
+	
+	// Decoder for MP3 files, using libmad.
+	class Mp3Decoder : public MusicDecoder {
+	public:
+		explicit Mp3Decoder(FILE *file);
+		virtual ~Mp3Decoder() override;
+		
+		virtual bool Decode(vector<int16_t> &output) override;
+	
+	private:
+		// Read the next block of the file into the input buffer. Return false
+		// if a whole pass through the file did not produce any audio.
+		bool ReadInput();
+	
+	private:
+		FILE *file;
+		vector<unsigned char> input;
+		bool rewoundWithoutAudio = false;
+		
+		mad_stream stream;
+		mad_frame frame;
+		mad_synth synth;
+	};
+	
+	// Decoder for Ogg Vorbis files, using libvorbisfile.
+	class VorbisDecoder : public MusicDecoder {
+	public:
+		explicit VorbisDecoder(FILE *file);
+		virtual ~VorbisDecoder() override;
+		
+		// Check whether the file was recognized and can be played.
+		bool IsValid() const;
+		
+		virtual bool Decode(vector<int16_t> &output) override;
+	
+	private:
+		OggVorbis_File vorbis;
+		bool isOpen = false;
+		int channels = 0;
+		long rate = 0;
+		char buffer[OUTPUT_BYTES];
+	};
+	
+	
+	
+	bool HasExtension(const string &path, const char *extension)
+	{
+		size_t length = strlen(extension);
+		return path.length() >= length && !path.compare(path.length() - length, length, extension);
+	}
+}
+
+
+
+// Check whether any decoder can read files with the given path's extension.
+bool MusicDecoder::IsSupported(const string &path)
+{
+	return HasExtension(path, ".mp3") || HasExtension(path, ".MP3") || HasExtension(path, ".ogg");
+}
+
+
+
+// Open the given file and create a decoder for it. If the file cannot be
+// opened or is in a format that cannot be played, this returns null.
+unique_ptr<MusicDecoder> MusicDecoder::Create(const string &path)
+{
+	if(!IsSupported(path))
+		return nullptr;
+	
+	FILE *file = Files::Open(path);
+	if(!file)
+		return nullptr;
+	
+	if(!HasExtension(path, ".ogg"))
+		return unique_ptr<MusicDecoder>(new Mp3Decoder(file));
+	
+	unique_ptr<VorbisDecoder> decoder(new VorbisDecoder(file));
+	if(!decoder->IsValid())
+	{
+		Files::LogError("Unable to play music file \"" + path
+			+ "\": it must be a mono or stereo Ogg Vorbis file at 44100 Hz.");
+		return nullptr;
+	}
+	return unique_ptr<MusicDecoder>(decoder.release());
+}
+
+
+
+namespace {
+	Mp3Decoder::Mp3Decoder(FILE *file)
+		: file(file), input(INPUT_CHUNK, 0)
+	{
+		mad_stream_init(&stream);
+		mad_frame_init(&frame);
+		mad_synth_init(&synth);
+	}
+	
+	
+	
+	Mp3Decoder::~Mp3Decoder()
+	{
+		mad_synth_finish(&synth);
+		mad_frame_finish(&frame);
+		mad_stream_finish(&stream);
+		fclose(file);
+	}
+	
+	
+	
+	// Decode the next MP3 frame.
+	bool Mp3Decoder::Decode(vector<int16_t> &output)
+	{
+		// Decode the next frame, reading more of the file whenever the input
+		// runs out. For recoverable errors, just skip to the next frame.
+		while(mad_frame_decode(&frame, &stream))
+			if(!MAD_RECOVERABLE(stream.error) && !ReadInput())
+				return false;
+		rewoundWithoutAudio = false;
+		
+		// Convert the decoded audio into a PCM signal.
+		mad_synth_frame(&synth, &frame);
+		
+		// If the source is mono, read both output channels from the left input.
+		// Otherwise, read two separate input channels.
+		const mad_fixed_t *channels[2] = {
+			synth.pcm.samples[0],
+			synth.pcm.samples[synth.pcm.channels > 1]
+		};
+		
+		// We'll alternate what channel we read from each time through the loop.
+		int channel = 0;
+		for(unsigned i = 0; i < 2 * synth.pcm.length; ++i)
+		{
+			// Read the next sample from the next channel.
+			mad_fixed_t sample = *channels[channel]++;
+			channel = !channel;
+			
+			// Clip and scale the sample to 16 bits.
+			sample += (1L << (MAD_F_FRACBITS - 16));
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+			sample = max(-MAD_F_ONE, min(MAD_F_ONE - 1, sample));
+#pragma GCC diagnostic pop
+			output.push_back(sample >> (MAD_F_FRACBITS + 1 - 16));
+		}
+		return true;
+	}
+	
+	
+	
+	// Read the next block of the file into the input buffer.
+	bool Mp3Decoder::ReadInput()
+	{
+		// See if any input data is left undecoded in the stream. Typically
+		// this is because the last block of input contained a fraction of a
+		// full MP3 frame.
+		size_t remainder = 0;
+		if(stream.next_frame && stream.next_frame < stream.bufend)
+			remainder = stream.bufend - stream.next_frame;
+		if(remainder)
+			memmove(&input.front(), stream.next_frame, remainder);
+		
+		// Now, read a chunk of data from the file.
+		size_t read = fread(&input.front() + remainder, 1, INPUT_CHUNK - remainder, file);
+		// If you get the end of the file, loop around to the beginning. If that
+		// already happened without any audio being decoded, the file is broken.
+		if(!read || feof(file))
+		{
+			if(rewoundWithoutAudio)
+				return false;
+			rewoundWithoutAudio = true;
+			rewind(file);
+		}
+		
+		// Hand the input to the stream decoder.
+		mad_stream_buffer(&stream, &input.front(), read + remainder);
+		return true;
+	}
+	
+	
+	
+	VorbisDecoder::VorbisDecoder(FILE *file)
+	{
+		// Once the file is open, libvorbisfile takes care of closing it.
+		isOpen = !ov_open_callbacks(file, &vorbis, nullptr, 0, OV_CALLBACKS_DEFAULT);
+		if(!isOpen)
+		{
+			fclose(file);
+			return;
+		}
+		
+		const vorbis_info *info = ov_info(&vorbis, -1);
+		if(info)
+		{
+			channels = info->channels;
+			rate = info->rate;
+		}
+	}
+	
+	
+	
+	VorbisDecoder::~VorbisDecoder()
+	{
+		if(isOpen)
+			ov_clear(&vorbis);
+	}
+	
+	
+	
+	// Check whether the file was recognized and can be played.
+	bool VorbisDecoder::IsValid() const
+	{
+		return isOpen && (channels == 1 || channels == 2) && rate == SAMPLE_RATE;
+	}
+	
+	
+	
+	// Decode the next block of little-endian, signed 16-bit samples.
+	bool VorbisDecoder::Decode(vector<int16_t> &output)
+	{
+		int bitstream = 0;
+		long bytes = ov_read(&vorbis, buffer, OUTPUT_BYTES, 0, 2, 1, &bitstream);
+		// At the end of the file, loop around to the beginning.
+		if(!bytes)
+		{
+			if(ov_pcm_seek(&vorbis, 0))
+				return false;
+			bytes = ov_read(&vorbis, buffer, OUTPUT_BYTES, 0, 2, 1, &bitstream);
+		}
+		// A hole in the data is not fatal; there is just nothing to add.
+		if(bytes == OV_HOLE)
+			return true;
+		if(bytes <= 0)
+			return false;
+		
+		const int16_t *samples = reinterpret_cast<const int16_t *>(buffer);
+		size_t count = bytes / 2;
+		if(channels == 2)
+			output.insert(output.end(), samples, samples + count);
+		else
+			for(size_t i = 0; i < count; ++i)
+			{
+				output.push_back(samples[i]);
+				output.push_back(samples[i]);
+			}
+		return true;
+	}
+}
@@ -0,0 +1,47 @@
+/* MusicDecoder.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MUSIC_DECODER_H_
+#define MUSIC_DECODER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+
+// Interface for the back ends that decode a music file into 16-bit stereo
+// samples at 44100 Hz. Each supported file format has its own decoder; the
+// Music class picks one based on the file's extension. When a decoder reaches
+// the end of its file, it loops back around to the beginning.
+class MusicDecoder {
+public:
+	// Check whether any decoder can read files with the given path's extension.
+	static bool IsSupported(const std::string &path);
+	// Open the given file and create a decoder for it. If the file cannot be
+	// opened or is in a format that cannot be played, this returns null.
+	static std::unique_ptr<MusicDecoder> Create(const std::string &path);
+	
+	
+public:
+	virtual ~MusicDecoder() = default;
+	
+	// Decode the next block of the file, and append its samples (with the left
+	// and right channels interleaved) to the given buffer. Return false if the
+	// file cannot be decoded any further.
+	virtual bool Decode(std::vector<int16_t> &output) = 0;
+};
+
+
+
+#endif
@@ -0,0 +1,83 @@
+/* Named.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Named.h"
+
+#include "Audio.h"
+#include "Color.h"
+#include "Effect.h"
+#include "GameData.h"
+#include "Set.h"
+#include "SpriteSet.h"
+
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// Every named reference that has been created. This is a function so that
+	// the list is sure to exist before any of the static references are.
+	vector<const NamedReference *> &References()
+	{
+		static vector<const NamedReference *> references;
+		return references;
+	}
+}
+
+
+
+// Look up every named object that has not been used yet.
+void NamedReference::ResolveAll()
+{
+	for(const NamedReference *reference : References())
+		reference->Resolve();
+}
+
+
+
+NamedReference::NamedReference(const char *name)
+	: name(name)
+{
+	References().push_back(this);
+}
+
+
+
+template <>
+const Color *Named<Color>::Find(const string &name)
+{
+	return GameData::Colors().Get(name);
+}
+
+
+
+template <>
+const Effect *Named<Effect>::Find(const string &name)
+{
+	return GameData::Effects().Get(name);
+}
+
+
+
+template <>
+const Sound *Named<Sound>::Find(const string &name)
+{
+	return Audio::Get(name);
+}
+
+
+
+template <>
+const Sprite *Named<Sprite>::Find(const string &name)
+{
+	return SpriteSet::Get(name);
+}
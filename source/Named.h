@@ -0,0 +1,101 @@
+/* Named.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef NAMED_H_
+#define NAMED_H_
+
+#include <atomic>
+#include <string>
+
+class Color;
+class Effect;
+class Sound;
+class Sprite;
+
+
+
+// Base class for references to game objects by name. It keeps a list of all of
+// them, so that they can all be looked up once the game data is loaded.
+class NamedReference {
+public:
+	// Look up every named object that has not been used yet. Any that refer to
+	// something that is not defined will then be reported by the game data's
+	// usual checks for undefined objects.
+	static void ResolveAll();
+	
+	
+protected:
+	explicit NamedReference(const char *name);
+	~NamedReference() = default;
+	
+	virtual void Resolve() const = 0;
+	
+	
+protected:
+	const char *name;
+};
+
+
+
+// A reference to a sprite, sound, color, or effect by its name, for code that
+// uses the same one over and over, such as every frame. The name is looked up
+// the first time the object is needed, and after that the pointer to it is
+// remembered. These must only be created as static variables at namespace
+// scope, because the list of them is never shortened.
+template <class Type>
+class Named : public NamedReference {
+public:
+	explicit Named(const char *name) : NamedReference(name) {}
+	
+	const Type *Get() const;
+	operator const Type *() const { return Get(); }
+	const Type *operator->() const { return Get(); }
+	
+	
+protected:
+	virtual void Resolve() const override { Get(); }
+	
+	
+private:
+	// Look up the object with the given name. This is defined in Named.cpp for
+	// each type of object.
+	static const Type *Find(const std::string &name);
+	
+	
+private:
+	mutable std::atomic<const Type *> object{nullptr};
+};
+
+template <> const Color *Named<Color>::Find(const std::string &name);
+template <> const Effect *Named<Effect>::Find(const std::string &name);
+template <> const Sound *Named<Sound>::Find(const std::string &name);
+template <> const Sprite *Named<Sprite>::Find(const std::string &name);
+
+
+
+template <class Type>
+const Type *Named<Type>::Get() const
+{
+	// Objects never move once they have been created, so if two threads both
+	// look up the same object at once, they will find the same pointer.
+	const Type *result = object.load(std::memory_order_acquire);
+	if(!result)
+	{
+		result = Find(name);
+		object.store(result, std::memory_order_release);
+	}
+	return result;
+}
+
+
+
+#endif
@@ -111,13 +111,27 @@ bool News::IsEmpty() const
 
 
 // Check if this news item is available given the player's planet and conditions.
-bool News::Matches(const Planet *planet, const map<string, int64_t> &conditions) const
+bool News::Matches(const Planet *planet, const ConditionsStore &conditions) const
 {
 	// If no location filter is specified, it should never match. This can be
 	// used to create news items that are never shown until an event "activates"
 	// them by specifying their location.
 	// Similarly, by updating a news item with "remove location", it can be deactivated.
-	return location.IsEmpty() ? false : (location.Matches(planet) && toShow.Test(conditions));
+	return MatchesLocation(planet) && MatchesConditions(conditions);
+}
+
+
+
+bool News::MatchesLocation(const Planet *planet) const
+{
+	return location.IsEmpty() ? false : location.Matches(planet);
+}
+
+
+
+bool News::MatchesConditions(const ConditionsStore &conditions) const
+{
+	return toShow.Test(conditions);
 }
 
 
@@ -21,6 +21,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <algorithm>
 #include <cmath>
+#include <map>
 
 using namespace std;
 
@@ -91,12 +92,13 @@ namespace {
 	// Used to add the contents of one outfit's map to another, while also
 	// erasing any key with a value of zero.
 	template <class T>
-	void MergeMaps(map<const T *, int> &thisMap, const map<const T *, int> &otherMap, int count)
+	void MergeMaps(FlatMap<const T *, int> &thisMap, const FlatMap<const T *, int> &otherMap, int count)
 	{
 		for(const auto &it : otherMap)
 		{
-			thisMap[it.first] += count * it.second;
-			if(thisMap[it.first] == 0)
+			int &value = thisMap[it.first];
+			value += count * it.second;
+			if(!value)
 				thisMap.erase(it.first);
 		}
 	}
@@ -319,6 +321,13 @@ double Outfit::Get(const string &attribute) const
 
 
 
+double Outfit::Get(const Dictionary::Key &attribute) const
+{
+	return attributes.Get(attribute);
+}
+
+
+
 const Dictionary &Outfit::Attributes() const
 {
 	return attributes;
@@ -346,9 +355,9 @@ int Outfit::CanAdd(const Outfit &other, int count) const
 				continue;
 		}
 		double value = Get(at.first);
-		// Allow for rounding errors:
+		// Allow for rounding errors, in whichever direction the count is going:
 		if(value + at.second * count < minimum - EPS)
-			count = (value - minimum) / -at.second + EPS;
+			count = (value - minimum) / -at.second + (count > 0 ? EPS : -EPS);
 	}
 	
 	return count;
@@ -362,12 +371,10 @@ void Outfit::Add(const Outfit &other, int count)
 {
 	cost += other.cost * count;
 	mass += other.mass * count;
-	for(const auto &at : other.attributes)
-	{
-		attributes[at.first] += at.second * count;
-		if(fabs(attributes[at.first]) < EPS)
-			attributes[at.first] = 0.;
-	}
+	attributes.Add(other.attributes, count);
+	for(auto &at : attributes)
+		if(fabs(at.second) < EPS)
+			at.second = 0.;
 	
 	for(const auto &it : other.flareSprites)
 		AddFlareSprites(flareSprites, it, count);
@@ -420,21 +427,21 @@ const vector<pair<Body, int>> &Outfit::SteeringFlareSprites() const
 
 
 
-const map<const Sound *, int> &Outfit::FlareSounds() const
+const FlatMap<const Sound *, int> &Outfit::FlareSounds() const
 {
 	return flareSounds;
 }
 
 
 
-const map<const Sound *, int> &Outfit::ReverseFlareSounds() const
+const FlatMap<const Sound *, int> &Outfit::ReverseFlareSounds() const
 {
 	return reverseFlareSounds;
 }
 
 
 
-const map<const Sound *, int> &Outfit::SteeringFlareSounds() const
+const FlatMap<const Sound *, int> &Outfit::SteeringFlareSounds() const
 {
 	return steeringFlareSounds;
 }
@@ -442,7 +449,7 @@ const map<const Sound *, int> &Outfit::SteeringFlareSounds() const
 
 
 // Get the afterburner effect, if any.
-const map<const Effect *, int> &Outfit::AfterburnerEffects() const
+const FlatMap<const Effect *, int> &Outfit::AfterburnerEffects() const
 {
 	return afterburnerEffects;
 }
@@ -450,49 +457,49 @@ const map<const Effect *, int> &Outfit::AfterburnerEffects() const
 
 
 // Get this oufit's jump effects and sounds, if any.
-const map<const Effect *, int> &Outfit::JumpEffects() const
+const FlatMap<const Effect *, int> &Outfit::JumpEffects() const
 {
 	return jumpEffects;
 }
 
 
 
-const map<const Sound *, int> &Outfit::HyperSounds() const
+const FlatMap<const Sound *, int> &Outfit::HyperSounds() const
 {
 	return hyperSounds;
 }
 
 
 
-const map<const Sound *, int> &Outfit::HyperInSounds() const
+const FlatMap<const Sound *, int> &Outfit::HyperInSounds() const
 {
 	return hyperInSounds;
 }
 
 
 
-const map<const Sound *, int> &Outfit::HyperOutSounds() const
+const FlatMap<const Sound *, int> &Outfit::HyperOutSounds() const
 {
 	return hyperOutSounds;
 }
 
 
 
-const map<const Sound *, int> &Outfit::JumpSounds() const
+const FlatMap<const Sound *, int> &Outfit::JumpSounds() const
 {
 	return jumpSounds;
 }
 
 
 
-const map<const Sound *, int> &Outfit::JumpInSounds() const
+const FlatMap<const Sound *, int> &Outfit::JumpInSounds() const
 {
 	return jumpInSounds;
 }
 
 
 
-const map<const Sound *, int> &Outfit::JumpOutSounds() const
+const FlatMap<const Sound *, int> &Outfit::JumpOutSounds() const
 {
 	return jumpOutSounds;
 }
@@ -16,8 +16,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Weapon.h"
 
 #include "Dictionary.h"
+#include "FlatMap.h"
 
-#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -61,6 +61,7 @@ public:
 	
 	double Get(const char *attribute) const;
 	double Get(const std::string &attribute) const;
+	double Get(const Dictionary::Key &attribute) const;
 	const Dictionary &Attributes() const;
 	
 	// Determine whether the given number of instances of the given outfit can
@@ -78,19 +79,19 @@ public:
 	const std::vector<std::pair<Body, int>> &FlareSprites() const;
 	const std::vector<std::pair<Body, int>> &ReverseFlareSprites() const;
 	const std::vector<std::pair<Body, int>> &SteeringFlareSprites() const;
-	const std::map<const Sound *, int> &FlareSounds() const;
-	const std::map<const Sound *, int> &ReverseFlareSounds() const;
-	const std::map<const Sound *, int> &SteeringFlareSounds() const;
+	const FlatMap<const Sound *, int> &FlareSounds() const;
+	const FlatMap<const Sound *, int> &ReverseFlareSounds() const;
+	const FlatMap<const Sound *, int> &SteeringFlareSounds() const;
 	// Get the afterburner effect, if any.
-	const std::map<const Effect *, int> &AfterburnerEffects() const;
+	const FlatMap<const Effect *, int> &AfterburnerEffects() const;
 	// Get this oufit's jump effects and sounds, if any.
-	const std::map<const Effect *, int> &JumpEffects() const;
-	const std::map<const Sound *, int> &HyperSounds() const;
-	const std::map<const Sound *, int> &HyperInSounds() const;
-	const std::map<const Sound *, int> &HyperOutSounds() const;
-	const std::map<const Sound *, int> &JumpSounds() const;
-	const std::map<const Sound *, int> &JumpInSounds() const;
-	const std::map<const Sound *, int> &JumpOutSounds() const;
+	const FlatMap<const Effect *, int> &JumpEffects() const;
+	const FlatMap<const Sound *, int> &HyperSounds() const;
+	const FlatMap<const Sound *, int> &HyperInSounds() const;
+	const FlatMap<const Sound *, int> &HyperOutSounds() const;
+	const FlatMap<const Sound *, int> &JumpSounds() const;
+	const FlatMap<const Sound *, int> &JumpInSounds() const;
+	const FlatMap<const Sound *, int> &JumpOutSounds() const;
 	// Get the sprite this outfit uses when dumped into space.
 	const Sprite *FlotsamSprite() const;
 	
@@ -114,17 +115,17 @@ private:
 	std::vector<std::pair<Body, int>> flareSprites;
 	std::vector<std::pair<Body, int>> reverseFlareSprites;
 	std::vector<std::pair<Body, int>> steeringFlareSprites;
-	std::map<const Sound *, int> flareSounds;
-	std::map<const Sound *, int> reverseFlareSounds;
-	std::map<const Sound *, int> steeringFlareSounds;
-	std::map<const Effect *, int> afterburnerEffects;
-	std::map<const Effect *, int> jumpEffects;
-	std::map<const Sound *, int> hyperSounds;
-	std::map<const Sound *, int> hyperInSounds;
-	std::map<const Sound *, int> hyperOutSounds;
-	std::map<const Sound *, int> jumpSounds;
-	std::map<const Sound *, int> jumpInSounds;
-	std::map<const Sound *, int> jumpOutSounds;
+	FlatMap<const Sound *, int> flareSounds;
+	FlatMap<const Sound *, int> reverseFlareSounds;
+	FlatMap<const Sound *, int> steeringFlareSounds;
+	FlatMap<const Effect *, int> afterburnerEffects;
+	FlatMap<const Effect *, int> jumpEffects;
+	FlatMap<const Sound *, int> hyperSounds;
+	FlatMap<const Sound *, int> hyperInSounds;
+	FlatMap<const Sound *, int> hyperOutSounds;
+	FlatMap<const Sound *, int> jumpSounds;
+	FlatMap<const Sound *, int> jumpInSounds;
+	FlatMap<const Sound *, int> jumpOutSounds;
 	const Sprite *flotsamSprite = nullptr;
 };
 
@@ -14,6 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Depreciation.h"
 #include "text/Format.h"
+#include "GameData.h"
 #include "Outfit.h"
 #include "PlayerInfo.h"
 
@@ -26,6 +27,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
+	// The formatted attributes of an outfit.
+	class CachedAttributes {
+	public:
+		vector<string> labels;
+		vector<string> values;
+		int height = 0;
+	};
+	
 	const vector<pair<double, string>> SCALE_LABELS = {
 		make_pair(60., ""),
 		make_pair(60. * 60., ""),
@@ -237,6 +246,35 @@ void OutfitInfoDisplay::UpdateRequirements(const Outfit &outfit, const PlayerInf
 
 
 void OutfitInfoDisplay::UpdateAttributes(const Outfit &outfit)
+{
+	// An outfit's attributes do not change unless the game data does, so they
+	// are only formatted the first time that each outfit is shown.
+	static map<const Outfit *, CachedAttributes> cache;
+	static uint64_t cacheRevision = 0;
+	if(cacheRevision != GameData::Revision())
+	{
+		cache.clear();
+		cacheRevision = GameData::Revision();
+	}
+	auto it = cache.find(&outfit);
+	if(it != cache.end())
+	{
+		attributeLabels = it->second.labels;
+		attributeValues = it->second.values;
+		attributesHeight = it->second.height;
+		return;
+	}
+	
+	CalculateAttributes(outfit);
+	CachedAttributes &cached = cache[&outfit];
+	cached.labels = attributeLabels;
+	cached.values = attributeValues;
+	cached.height = attributesHeight;
+}
+
+
+
+void OutfitInfoDisplay::CalculateAttributes(const Outfit &outfit)
 {
 	attributeLabels.clear();
 	attributeValues.clear();
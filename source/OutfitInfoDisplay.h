@@ -51,6 +51,7 @@ public:
 private:
 	void UpdateRequirements(const Outfit &outfit, const PlayerInfo &player, bool canSell);
 	void UpdateAttributes(const Outfit &outfit);
+	void CalculateAttributes(const Outfit &outfit);
 	
 	
 private:
@@ -58,8 +58,8 @@ OutfitterPanel::OutfitterPanel(PlayerInfo &player)
 	
 	// Add owned licenses
 	const string PREFIX = "license: ";
-	for(auto &it : player.Conditions())
-		if(it.first.compare(0, PREFIX.length(), PREFIX) == 0 && it.second > 0)
+	for(const auto &it : player.Conditions().WithPrefix(PREFIX))
+		if(it.second > 0)
 		{
 			const string name = it.first.substr(PREFIX.length()) + " License";
 			const Outfit *outfit = GameData::Outfits().Get(name);
@@ -96,10 +96,14 @@ int OutfitterPanel::TileSize() const
 
 int OutfitterPanel::DrawPlayerShipInfo(const Point &point)
 {
-	shipInfo.Update(*playerShip, player.FleetDepreciation(), day);
-	shipInfo.DrawAttributes(point);
+	if(playerShipInfoShip != playerShip)
+	{
+		playerShipInfo.Update(*playerShip, player.FleetDepreciation(), day);
+		playerShipInfoShip = playerShip;
+	}
+	playerShipInfo.DrawAttributes(point);
 	
-	return shipInfo.AttributesHeight();
+	return playerShipInfo.AttributesHeight();
 }
 
 
@@ -235,7 +239,11 @@ int OutfitterPanel::DrawDetails(const Point &center)
 	
 	if(selectedOutfit)
 	{
-		outfitInfo.Update(*selectedOutfit, player, CanSell());
+		if(outfitInfoOutfit != selectedOutfit)
+		{
+			outfitInfo.Update(*selectedOutfit, player, CanSell());
+			outfitInfoOutfit = selectedOutfit;
+		}
 		selectedItem = selectedOutfit->Name();
 		
 		const Sprite *thumbnail = selectedOutfit->Thumbnail();
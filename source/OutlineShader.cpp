@@ -13,14 +13,38 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "OutlineShader.h"
 
 #include "Color.h"
+#include "GpuProfiler.h"
 #include "Point.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 #include "Sprite.h"
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
 using namespace std;
 
 namespace {
+	// Outlines that are drawn the same way every frame are rendered into a
+	// texture of this size, and then copied from it.
+	const int CACHE_SIZE = 2048;
+	// The cached outlines only have one channel. Before its color is applied,
+	// an outline can be brighter than 1, so it is stored at this fraction of
+	// its brightness.
+	const float CACHE_RANGE = 4.f;
+	
+	// Where in the cache texture an outline is stored.
+	class CachedOutline {
+	public:
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+	
 	Shader shader;
 	GLint scaleI;
 	GLint offI;
@@ -28,10 +52,106 @@ namespace {
 	GLint positionI;
 	GLint frameI;
 	GLint frameCountI;
+	GLint firstLayerI;
 	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	Shader cacheShader;
+	GLint cacheScaleI;
+	GLint cachePositionI;
+	GLint cacheSizeI;
+	GLint cacheRegionI;
+	GLint cacheColorI;
+	
+	GLuint cacheVao;
+	GLuint cacheTexture = 0;
+	GLuint cacheFramebuffer = 0;
+	
+	// The cached outlines are identified by the sprite and the texture layer
+	// they were made from, so that a sprite that is reloaded gets a new one,
+	// and by their size in pixels. The cache is packed in rows, and once it
+	// is full, it is emptied and filled up again.
+	map<tuple<const Sprite *, uint32_t, float, int, int>, CachedOutline> cache;
+	int rowX = 0;
+	int rowY = 0;
+	int rowHeight = 0;
+	
+	
+	
+	// Run the outline filter on the given sprite. The scale converts from
+	// the given coordinates to OpenGL's, which range from -1 to 1.
+	void DrawOutline(const Sprite *sprite, const Point &pos, const Point &size, const Color &color, const Point &unit, float frame, const GLfloat scale[2])
+	{
+		bool isHighDPI = (unit.Length() * Screen::Zoom() > 50.);
+		uint32_t texture = sprite->Texture(isHighDPI);
+		
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		glUniform2fv(scaleI, 1, scale);
+		
+		GLfloat off[2] = {
+			static_cast<float>(.5 / size.X()),
+			static_cast<float>(.5 / size.Y())};
+		glUniform2fv(offI, 1, off);
+		
+		glUniform1f(frameI, frame);
+		glUniform1f(frameCountI, sprite->Frames());
+		glUniform1f(firstLayerI, sprite->FirstLayer(isHighDPI));
+		
+		Point uw = unit * size.X();
+		Point uh = unit * size.Y();
+		GLfloat transform[4] = {
+			static_cast<float>(-uw.Y()),
+			static_cast<float>(uw.X()),
+			static_cast<float>(-uh.X()),
+			static_cast<float>(-uh.Y())
+		};
+		glUniformMatrix2fv(transformI, 1, false, transform);
+		
+		GLfloat position[2] = {
+			static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
+		glUniform2fv(positionI, 1, position);
+		
+		glUniform4fv(colorI, 1, color.Get());
+		
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		GpuProfiler::CountBind();
+		
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		GpuProfiler::CountDraw();
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+	}
+	
+	
+	
+	// Find room in the cache for an outline of the given size, emptying the
+	// cache if it is full. A gap is left around each outline, so that they do
+	// not bleed into each other when they are drawn with linear filtering.
+	CachedOutline Allocate(int width, int height)
+	{
+		if(rowX + width > CACHE_SIZE)
+		{
+			rowX = 0;
+			rowY += rowHeight + 1;
+			rowHeight = 0;
+		}
+		if(rowY + height > CACHE_SIZE)
+		{
+			cache.clear();
+			rowX = 0;
+			rowY = 0;
+			rowHeight = 0;
+		}
+		CachedOutline result = {rowX, rowY, width, height};
+		rowX += width + 1;
+		rowHeight = max(rowHeight, height);
+		return result;
+	}
 }
 
 
@@ -69,6 +189,7 @@ void OutlineShader::Init()
 		"uniform sampler2DArray tex;\n"
 		"uniform float frame = 0;\n"
 		"uniform float frameCount = 0;\n"
+		"uniform float firstLayer = 0;\n"
 		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
 		"uniform vec2 off;\n"
 		"const vec4 weight = vec4(.4, .4, .4, 1.);\n"
@@ -104,7 +225,7 @@ void OutlineShader::Init()
 		"  float first = floor(frame);\n"
 		"  float second = mod(ceil(frame), frameCount);\n"
 		"  float fade = frame - first;\n"
-		"  float sum = mix(Sobel(first), Sobel(second), fade);\n"
+		"  float sum = mix(Sobel(first + firstLayer), Sobel(second + firstLayer), fade);\n"
 		"  finalColor = color * sqrt(sum / 180);\n"
 		"}\n";
 	
@@ -115,6 +236,7 @@ void OutlineShader::Init()
 	positionI = shader.Uniform("position");
 	frameI = shader.Uniform("frame");
 	frameCountI = shader.Uniform("frameCount");
+	firstLayerI = shader.Uniform("firstLayer");
 	colorI = shader.Uniform("color");
 	
 	glUseProgram(shader.Object());
@@ -147,45 +269,182 @@ void OutlineShader::Init()
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+	
+	// The cached outlines are drawn with a shader that just copies them from
+	// the cache texture and applies their color.
+	static const char *cacheVertexCode =
+		"// vertex cached outline shader\n"
+		"uniform vec2 scale;\n"
+		"uniform vec2 position;\n"
+		"uniform vec2 size;\n"
+		"uniform vec4 region;\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 vertTexCoord;\n"
+		
+		"out vec2 fragTexCoord;\n"
+		
+		"void main() {\n"
+		"  fragTexCoord = region.xy + vertTexCoord * region.zw;\n"
+		"  gl_Position = vec4((vert * size + position) * scale, 0, 1);\n"
+		"}\n";
+	
+	static const char *cacheFragmentCode =
+		"// fragment cached outline shader\n"
+		"uniform sampler2D tex;\n"
+		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
+		
+		"in vec2 fragTexCoord;\n"
+		
+		"out vec4 finalColor;\n"
+		
+		"void main() {\n"
+		"  finalColor = color * texture(tex, fragTexCoord).r;\n"
+		"}\n";
+	
+	cacheShader = Shader(cacheVertexCode, cacheFragmentCode);
+	cacheScaleI = cacheShader.Uniform("scale");
+	cachePositionI = cacheShader.Uniform("position");
+	cacheSizeI = cacheShader.Uniform("size");
+	cacheRegionI = cacheShader.Uniform("region");
+	cacheColorI = cacheShader.Uniform("color");
+	
+	glUseProgram(cacheShader.Object());
+	glUniform1i(cacheShader.Uniform("tex"), 0);
+	glUseProgram(0);
+	
+	glGenVertexArrays(1, &cacheVao);
+	glBindVertexArray(cacheVao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	
+	glEnableVertexAttribArray(cacheShader.Attrib("vert"));
+	glVertexAttribPointer(cacheShader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, stride, nullptr);
+	
+	glEnableVertexAttribArray(cacheShader.Attrib("vertTexCoord"));
+	glVertexAttribPointer(cacheShader.Attrib("vertTexCoord"), 2, GL_FLOAT, GL_TRUE,
+		stride, reinterpret_cast<const GLvoid*>(2 * sizeof(GLfloat)));
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	
+	// Create the texture that the outlines are cached in, and a framebuffer
+	// for drawing into it. If that is not possible, outlines are not cached.
+	glGenTextures(1, &cacheTexture);
+	glBindTexture(GL_TEXTURE_2D, cacheTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, CACHE_SIZE, CACHE_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	
+	glGenFramebuffers(1, &cacheFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, cacheFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cacheTexture, 0);
+	bool isComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if(!isComplete)
+	{
+		glDeleteFramebuffers(1, &cacheFramebuffer);
+		glDeleteTextures(1, &cacheTexture);
+		cacheFramebuffer = 0;
+		cacheTexture = 0;
+	}
 }
 
 
 
 void OutlineShader::Draw(const Sprite *sprite, const Point &pos, const Point &size, const Color &color, const Point &unit, float frame)
 {
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
+	bool isHighDPI = (unit.Length() * Screen::Zoom() > 50.);
+	if(!sprite->Texture(isHighDPI))
+		return;
 	
+	RenderQueue::Flush();
 	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
-	
-	GLfloat off[2] = {
-		static_cast<float>(.5 / size.X()),
-		static_cast<float>(.5 / size.Y())};
-	glUniform2fv(offI, 1, off);
-	
-	glUniform1f(frameI, frame);
-	glUniform1f(frameCountI, sprite->Frames());
-	
-	Point uw = unit * size.X();
-	Point uh = unit * size.Y();
-	GLfloat transform[4] = {
-		static_cast<float>(-uw.Y()),
-		static_cast<float>(uw.X()),
-		static_cast<float>(-uh.X()),
-		static_cast<float>(-uh.Y())
-	};
-	glUniformMatrix2fv(transformI, 1, false, transform);
+	DrawOutline(sprite, pos, size, color, unit, frame, scale);
+}
+
+
+
+// Draw a sprite's outline from the cache, rendering it into the cache first
+// if this is the first time it has been drawn at this size.
+void OutlineShader::DrawCached(const Sprite *sprite, const Point &pos, const Point &size, const Color &color)
+{
+	static const Point UNIT(0., -1.);
+	bool isHighDPI = (UNIT.Length() * Screen::Zoom() > 50.);
+	uint32_t texture = sprite->Texture(isHighDPI);
+	if(!texture)
+		return;
+	
+	// Find out how many pixels of the screen the outline will cover.
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	double pixels = static_cast<double>(viewport[2]) / Screen::Width();
+	int width = ceil(size.X() * pixels);
+	int height = ceil(size.Y() * pixels);
+	if(!cacheFramebuffer || width > CACHE_SIZE || height > CACHE_SIZE)
+	{
+		Draw(sprite, pos, size, color);
+		return;
+	}
+	
+	RenderQueue::Flush();
+	auto key = make_tuple(sprite, texture, sprite->FirstLayer(isHighDPI), width, height);
+	auto it = cache.find(key);
+	if(it == cache.end())
+	{
+		CachedOutline region = Allocate(width, height);
+		it = cache.emplace(key, region).first;
+		
+		// Draw the outline into its place in the cache, replacing whatever
+		// was there before. It is stretched to fill a whole number of pixels.
+		GLint framebuffer;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+		bool isBlending = glIsEnabled(GL_BLEND);
+		glBindFramebuffer(GL_FRAMEBUFFER, cacheFramebuffer);
+		glViewport(region.x, region.y, region.width, region.height);
+		glDisable(GL_BLEND);
+		
+		GLfloat scale[2] = {static_cast<float>(2. / size.X()), static_cast<float>(2. / size.Y())};
+		DrawOutline(sprite, Point(), size, Color(1.f / CACHE_RANGE, 1.f), UNIT, 0.f, scale);
+		
+		if(isBlending)
+			glEnable(GL_BLEND);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+	const CachedOutline &region = it->second;
+	
+	glUseProgram(cacheShader.Object());
+	glBindVertexArray(cacheVao);
+	
+	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+	glUniform2fv(cacheScaleI, 1, scale);
+	GLfloat position[2] = {static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
+	glUniform2fv(cachePositionI, 1, position);
+	GLfloat quadSize[2] = {static_cast<float>(size.X()), static_cast<float>(size.Y())};
+	glUniform2fv(cacheSizeI, 1, quadSize);
 	
-	GLfloat position[2] = {
-		static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
-	glUniform2fv(positionI, 1, position);
+	GLfloat cacheRegion[4] = {
+		static_cast<float>(region.x) / CACHE_SIZE,
+		static_cast<float>(region.y) / CACHE_SIZE,
+		static_cast<float>(region.width) / CACHE_SIZE,
+		static_cast<float>(region.height) / CACHE_SIZE};
+	glUniform4fv(cacheRegionI, 1, cacheRegion);
 	
-	glUniform4fv(colorI, 1, color.Get());
+	// Undo the scaling of the brightness that was done to fit the outline
+	// into the cache.
+	const float *channels = color.Get();
+	GLfloat cacheColor[4] = {
+		channels[0] * CACHE_RANGE, channels[1] * CACHE_RANGE, channels[2] * CACHE_RANGE, channels[3] * CACHE_RANGE};
+	glUniform4fv(cacheColorI, 1, cacheColor);
 	
-	glBindTexture(GL_TEXTURE_2D_ARRAY, sprite->Texture(unit.Length() * Screen::Zoom() > 50.));
+	glBindTexture(GL_TEXTURE_2D, cacheTexture);
+	GpuProfiler::CountBind();
 	
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	GpuProfiler::CountDraw();
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
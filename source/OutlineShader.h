@@ -27,6 +27,11 @@ public:
 	static void Init();
 	
 	static void Draw(const Sprite *sprite, const Point &pos, const Point &size, const Color &color, const Point &unit = Point(0., -1.), float frame = 0.f);
+	// Draw the first frame of a sprite's outline, unrotated. The filter is
+	// only run the first time an outline is drawn at a given size; after that,
+	// it is copied from a cache. This is for the ship icons in the panels,
+	// which are drawn the same way every frame.
+	static void DrawCached(const Sprite *sprite, const Point &pos, const Point &size, const Color &color);
 };
 
 
@@ -119,6 +119,20 @@ bool Panel::AllowFastForward() const
 
 
 
+// Most panels do all their work in Step(), so they are always ready for it.
+bool Panel::IsReadyToStep()
+{
+	return true;
+}
+
+
+
+void Panel::SetNextStepDrawn(bool isDrawn)
+{
+}
+
+
+
 // Only override the ones you need; the default action is to return false.
 bool Panel::KeyDown(SDL_Keycode key, Uint16 mod, const Command &command, bool isNewPress)
 {
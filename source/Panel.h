@@ -63,6 +63,12 @@ public:
 	
 	// Is fast-forward allowed to be on when this panel is on top of the GUI stack?
 	virtual bool AllowFastForward() const;
+	// Check if this panel's next step can begin without waiting for anything
+	// (e.g. for calculations that are running in another thread).
+	virtual bool IsReadyToStep();
+	// Tell this panel whether the results of its next step will be drawn. If
+	// not (e.g. when fast-forwarding), it can skip preparing anything to draw.
+	virtual void SetNextStepDrawn(bool isDrawn);
 	
 	
 protected:
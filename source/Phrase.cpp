@@ -63,23 +63,49 @@ const string &Phrase::Name() const
 string Phrase::Get() const
 {
 	string result;
+	Append(result);
+	return result;
+}
+
+
+
+// Append a random sentence's text to the given string. Any phrases that this
+// one refers to append their text to the same string, instead of each of them
+// building a separate string that then has to be copied into this one.
+void Phrase::Append(string &result) const
+{
 	if(sentences.empty())
-		return result;
+		return;
 	
+	// Replacements only apply to the text that this phrase has added.
+	const size_t start = result.length();
 	for(const auto &part : sentences[Random::Int(sentences.size())])
 	{
 		if(!part.choices.empty())
 		{
 			const auto &choice = part.choices[Random::Int(part.choices.size())];
 			for(const auto &element : choice)
-				result += element.second ? element.second->Get() : element.first;
+			{
+				if(element.second)
+					element.second->Append(result);
+				else
+					result += element.first;
+			}
 		}
 		else if(!part.replacements.empty())
-			for(const auto &pair : part.replacements)
-				Format::ReplaceAll(result, pair.first, pair.second);
+		{
+			if(!start)
+				for(const auto &pair : part.replacements)
+					Format::ReplaceAll(result, pair.first, pair.second);
+			else
+			{
+				string text = result.substr(start);
+				for(const auto &pair : part.replacements)
+					Format::ReplaceAll(text, pair.first, pair.second);
+				result.replace(start, string::npos, text);
+			}
+		}
 	}
-	
-	return result;
 }
 
 
@@ -35,6 +35,8 @@ public:
 	
 	
 private:
+	// Append a random sentence's text to the given string.
+	void Append(std::string &result) const;
 	bool ReferencesPhrase(const Phrase *phrase) const;
 	
 	
@@ -25,6 +25,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "System.h"
 
 #include <algorithm>
+#include <atomic>
 
 using namespace std;
 
@@ -241,6 +242,13 @@ bool Planet::IsValid() const
 
 
 
+size_t Planet::Index() const
+{
+	return index;
+}
+
+
+
 // Get the name of the planet.
 const string &Planet::Name() const
 {
@@ -628,3 +636,12 @@ void Planet::ResetDefense() const
 	defenseDeployed = 0;
 	defenders.clear();
 }
+
+
+
+// Planets may be created while the data files are being loaded in parallel.
+size_t Planet::NextIndex()
+{
+	static atomic<size_t> count(0);
+	return count++;
+}
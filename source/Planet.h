@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Sale.h"
 
+#include <cstddef>
 #include <list>
 #include <memory>
 #include <set>
@@ -42,6 +43,9 @@ public:
 	void Load(const DataNode &node);
 	// Check if both this planet and its containing system(s) have been defined.
 	bool IsValid() const;
+	// Get a number that is unique to this planet, and small enough to be used
+	// as an index into per-planet tables. A copy of a planet has its index.
+	size_t Index() const;
 	
 	// Get the name of the planet (all wormholes use the same name).
 	// When saving missions or writing the player's save, the reference name
@@ -136,6 +140,12 @@ public:
 	
 	
 private:
+	// Get the index for a newly created planet.
+	static size_t NextIndex();
+	
+	
+private:
+	size_t index = NextIndex();
 	bool isDefined = false;
 	std::string name;
 	std::string description;
@@ -106,23 +106,24 @@ PlanetLabel::PlanetLabel(const Point &position, const StellarObject &object, con
 
 
 
-void PlanetLabel::Draw() const
+void PlanetLabel::Draw(const Point &offset) const
 {
 	// Draw any active planet labels.
 	const Font &font = FontSet::Get(14);
 	const Font &bigFont = FontSet::Get(18);
+	Point center = position + offset;
 	
 	// The angle of the outer ring should be reduced by just enough that the
 	// circumference is reduced by 6 pixels.
 	double innerAngle = LINE_ANGLE[direction];
 	double outerAngle = innerAngle - 360. * GAP / (2. * PI * radius);
 	Point unit = Angle(innerAngle).Unit();
-	RingShader::Draw(position, radius + INNER_SPACE, 2.3f, .9f, color, 0.f, innerAngle);
-	RingShader::Draw(position, radius + INNER_SPACE + GAP, 1.3f, .6f, color, 0.f, outerAngle);
+	RingShader::Draw(center, radius + INNER_SPACE, 2.3f, .9f, color, 0.f, innerAngle);
+	RingShader::Draw(center, radius + INNER_SPACE + GAP, 1.3f, .6f, color, 0.f, outerAngle);
 	
 	if(!name.empty())
 	{
-		Point from = position + (radius + INNER_SPACE + LINE_GAP) * unit;
+		Point from = center + (radius + INNER_SPACE + LINE_GAP) * unit;
 		Point to = from + LINE_LENGTH * unit;
 		LineShader::Draw(from, to, 1.3f, color);
 		
@@ -136,6 +137,6 @@ void PlanetLabel::Draw() const
 	for(int i = 0; i < hostility; ++i)
 	{
 		barbAngle += Angle(800. / (radius + 25.));
-		PointerShader::Draw(position, barbAngle.Unit(), 15.f, 15.f, radius + 25., color);
+		PointerShader::Draw(center, barbAngle.Unit(), 15.f, 15.f, radius + 25., color);
 	}
 }
@@ -27,7 +27,9 @@ class PlanetLabel {
 public:
 	PlanetLabel(const Point &position, const StellarObject &object, const System *system, double zoom);
 	
-	void Draw() const;
+	// Draw the label, shifted by the given offset (in pixels) from where it
+	// was placed.
+	void Draw(const Point &offset = Point()) const;
 	
 	
 private:
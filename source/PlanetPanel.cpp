@@ -57,10 +57,11 @@ PlanetPanel::PlanetPanel(PlayerInfo &player, function<void()> callback)
 	text.SetWrapWidth(480);
 	text.Wrap(planet.Description());
 	
-	// Since the loading of landscape images is deferred, make sure that the
-	// landscapes for this system are loaded before showing the planet panel.
+	// Since the loading of landscape images is deferred, the landscape may not
+	// be loaded yet. Rather than waiting for it, show a low resolution version
+	// of it until the full image is ready.
 	GameData::Preload(planet.Landscape());
-	GameData::FinishLoading();
+	GameData::LoadPreview(planet.Landscape());
 }
 
 
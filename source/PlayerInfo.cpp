@@ -33,6 +33,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SavedGame.h"
 #include "Ship.h"
 #include "ShipEvent.h"
+#include "SnapshotStore.h"
+#include "Sprite.h"
 #include "StartConditions.h"
 #include "StellarObject.h"
 #include "System.h"
@@ -48,6 +50,51 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+	// The conditions that are derived automatically from the player's status.
+	// Their ids are looked up just once.
+	const unsigned NET_WORTH = ConditionsStore::Intern("net worth");
+	const unsigned CREDITS = ConditionsStore::Intern("credits");
+	const unsigned UNPAID_MORTGAGES = ConditionsStore::Intern("unpaid mortgages");
+	const unsigned UNPAID_FINES = ConditionsStore::Intern("unpaid fines");
+	const unsigned UNPAID_SALARIES = ConditionsStore::Intern("unpaid salaries");
+	const unsigned UNPAID_MAINTENANCE = ConditionsStore::Intern("unpaid maintenance");
+	const unsigned CREDIT_SCORE = ConditionsStore::Intern("credit score");
+	const unsigned CARGO_SPACE = ConditionsStore::Intern("cargo space");
+	const unsigned PASSENGER_SPACE = ConditionsStore::Intern("passenger space");
+	const unsigned FLAGSHIP_CREW = ConditionsStore::Intern("flagship crew");
+	const unsigned FLAGSHIP_REQUIRED_CREW = ConditionsStore::Intern("flagship required crew");
+	const unsigned FLAGSHIP_BUNKS = ConditionsStore::Intern("flagship bunks");
+	const unsigned CARGO_ATTRACTIVENESS = ConditionsStore::Intern("cargo attractiveness");
+	const unsigned ARMAMENT_DETERRENCE = ConditionsStore::Intern("armament deterrence");
+	const unsigned PIRATE_ATTRACTION = ConditionsStore::Intern("pirate attraction");
+	
+	// Check if the given ship counts toward the fleet conditions, i.e. whether
+	// it is active and in the given system.
+	bool IsInFleet(const Ship &ship, const System *system)
+	{
+		return !ship.IsParked() && !ship.IsDisabled() && ship.GetSystem() == system;
+	}
+	
+	// Check or set the entry for the given system or planet index in a table
+	// of which ones the player has seen or visited.
+	bool IsMarked(const vector<bool> &marks, size_t index)
+	{
+		return index < marks.size() && marks[index];
+	}
+	
+	void SetMark(vector<bool> &marks, size_t index, bool value = true)
+	{
+		if(index >= marks.size())
+		{
+			if(!value)
+				return;
+			marks.resize(index + 1);
+		}
+		marks[index] = value;
+	}
+}
+
 
 
 // Completely clear all loaded information, to prepare for loading a file or
@@ -117,8 +164,10 @@ void PlayerInfo::New(const StartConditions &start)
 // Load player information from a saved game file.
 void PlayerInfo::Load(const string &path)
 {
-	// Make sure any previously loaded data is cleared.
+	// Make sure any previously loaded data is cleared, and that the file is
+	// not still being saved.
 	Clear();
+	Files::FinishWriting();
 	
 	filePath = path;
 	// Strip anything after the "~" from snapshots, so that the file we save
@@ -132,7 +181,8 @@ void PlayerInfo::Load(const string &path)
 	// we provide the same access to services in this session, too.
 	bool hasFullClearance = false;
 	
-	DataFile file(path);
+	DataFile file;
+	SaveJournal::Load(path, file);
 	for(const DataNode &child : file)
 	{
 		// Basic player information and persistent UI settings:
@@ -222,6 +272,7 @@ void PlayerInfo::Load(const string &path)
 		{
 			missions.emplace_back(child);
 			cargo.AddMissionCargo(&missions.back());
+			npcIndexIsStale = true;
 		}
 		else if(child.Token(0) == "available job")
 			availableJobs.emplace_back(child);
@@ -230,10 +281,13 @@ void PlayerInfo::Load(const string &path)
 		else if(child.Token(0) == "conditions")
 		{
 			for(const DataNode &grand : child)
-				conditions[grand.Token(0)] = (grand.Size() >= 2) ? grand.Value(1) : 1;
+				conditions.Set(grand.Token(0), (grand.Size() >= 2) ? grand.Value(1) : 1);
 		}
 		else if(child.Token(0) == "event")
-			gameEvents.emplace_back(child);
+		{
+			GameEvent event(child);
+			gameEvents.emplace(event.GetDate(), std::move(event));
+		}
 		else if(child.Token(0) == "changes")
 		{
 			for(const DataNode &grand : child)
@@ -330,7 +384,7 @@ bool PlayerInfo::LoadRecent()
 
 
 // Save this player. The file name is based on the player's name.
-void PlayerInfo::Save() const
+void PlayerInfo::Save(bool isFull) const
 {
 	// Don't save dead players or players that are not fully created.
 	if(!CanBeSaved())
@@ -339,6 +393,21 @@ void PlayerInfo::Save() const
 	// Remember that this was the most recently saved player.
 	Files::Write(Files::Config() + "recent.txt", filePath + '\n');
 	
+	// The previous save may still be being written.
+	Files::FinishWriting();
+	DataWriter out;
+	Save(out);
+	string text = out.GetString();
+	
+	// Unless it is time for a full save, only record what has changed since
+	// the last one. The backups are only rotated on full saves.
+	bool isJournaling = Preferences::Has("Journaled saves");
+	if(isJournaling && !isFull && !journal.NeedsFullSave(filePath))
+	{
+		journal.SaveChanges(text);
+		return;
+	}
+	
 	if(filePath.rfind(".txt") == filePath.length() - 4)
 	{
 		// Only update the backups if this save will have a newer date.
@@ -352,13 +421,31 @@ void PlayerInfo::Save() const
 				root + "~~previous-1.txt",
 				filePath
 			};
-			for(int i = 0; i < 3; ++i)
+			for(int i = 0; i < 2; ++i)
+			{
 				if(Files::Exists(files[i + 1]))
 					Files::Move(files[i + 1], files[i]);
+				// Each backup's journal goes with it, and any journal left over
+				// from the backup it replaces no longer applies.
+				string from = SaveJournal::JournalPath(files[i + 1]);
+				string to = SaveJournal::JournalPath(files[i]);
+				if(Files::Exists(to))
+					Files::Delete(to);
+				if(Files::Exists(from))
+					Files::Move(from, to);
+			}
+			// The newest backup is mostly the same as the others, so store it
+			// in the snapshot store instead of keeping a full copy of it.
+			string journalPath = SaveJournal::JournalPath(files[2]);
+			if(Files::Exists(journalPath))
+				Files::Delete(journalPath);
+			if(Files::Exists(filePath))
+				SnapshotStore::Write(files[2], SaveJournal::Read(filePath));
+			SnapshotStore::CollectGarbage();
 		}
 	}
-		
-	Save(filePath);
+	
+	journal.SaveFull(filePath, move(text), isJournaling);
 }
 
 
@@ -377,7 +464,6 @@ string PlayerInfo::Identifier() const
 // Apply the given set of changes to the game data.
 void PlayerInfo::AddChanges(list<DataNode> &changes)
 {
-	bool changedSystems = false;
 	for(const DataNode &change : changes)
 	{
 		changedSystems |= (change.Token(0) == "system");
@@ -385,19 +471,10 @@ void PlayerInfo::AddChanges(list<DataNode> &changes)
 		changedSystems |= (change.Token(0) == "unlink");
 		GameData::Change(change);
 	}
-	if(changedSystems)
-	{
-		// Recalculate what systems have been seen.
-		GameData::UpdateSystems();
-		seen.clear();
-		for(const System *system : visitedSystems)
-		{
-			seen.insert(system);
-			for(const System *neighbor : system->VisibleNeighbors())
-				if(!neighbor->Hidden() || system->Links().count(neighbor))
-					seen.insert(neighbor);
-		}
-	}
+	// If several events are being applied at once, only update the systems
+	// once they have all been applied.
+	if(!isBatchingChanges)
+		UpdateSystems();
 	
 	// Only move the changes into my list if they are not already there.
 	if(&changes != &dataChanges)
@@ -409,8 +486,8 @@ void PlayerInfo::AddChanges(list<DataNode> &changes)
 // Add an event that will happen at the given date.
 void PlayerInfo::AddEvent(const GameEvent &event, const Date &date)
 {
-	gameEvents.push_back(event);
-	gameEvents.back().SetDate(date);
+	auto it = gameEvents.emplace(date, event);
+	it->second.SetDate(date);
 }
 
 
@@ -527,22 +604,22 @@ const Date &PlayerInfo::GetDate() const
 void PlayerInfo::IncrementDate()
 {
 	++date;
-	conditions["day"] = date.Day();
-	conditions["month"] = date.Month();
-	conditions["year"] = date.Year();
+	conditions.Set("day", date.Day());
+	conditions.Set("month", date.Month());
+	conditions.Set("year", date.Year());
 	
-	// Check if any special events should happen today.
-	auto it = gameEvents.begin();
-	while(it != gameEvents.end())
+	// Check if any special events should happen today. The events are sorted
+	// by date, so only the ones that are due need to be looked at. Applying an
+	// event may schedule more, so always start again from the earliest one.
+	isBatchingChanges = true;
+	while(!gameEvents.empty() && !(date < gameEvents.begin()->first))
 	{
-		if(date < it->GetDate())
-			++it;
-		else
-		{
-			it->Apply(*this);
-			it = gameEvents.erase(it);
-		}
+		auto it = gameEvents.begin();
+		it->second.Apply(*this);
+		gameEvents.erase(it);
 	}
+	isBatchingChanges = false;
+	UpdateSystems();
 	
 	// Check if any missions have failed because of deadlines.
 	for(Mission &mission : missions)
@@ -554,9 +631,8 @@ void PlayerInfo::IncrementDate()
 	static const string prefix[2] = {"salary: ", "tribute: "};
 	for(int i = 0; i < 2; ++i)
 	{
-		auto it = conditions.lower_bound(prefix[i]);
-		for( ; it != conditions.end() && !it->first.compare(0, prefix[i].length(), prefix[i]); ++it)
-			total[i] += it->second;
+		for(const auto &it : conditions.WithPrefix(prefix[i]))
+			total[i] += it.second;
 	}
 	if(total[0] || total[1])
 	{
@@ -791,7 +867,7 @@ map<const shared_ptr<Ship>, vector<string>> PlayerInfo::FlightCheck() const
 	for(const auto &ship : ships)
 		if(ship->GetSystem() == system && !ship->IsDisabled() && !ship->IsParked())
 		{
-			auto checks = ship->FlightCheck();
+			const auto &checks = ship->FlightCheck();
 			if(!checks.empty())
 				flightChecks.emplace(ship, checks);
 			
@@ -1573,11 +1649,13 @@ void PlayerInfo::AcceptJob(const Mission &mission, UI *ui)
 	for(auto it = availableJobs.begin(); it != availableJobs.end(); ++it)
 		if(&*it == &mission)
 		{
+			it->FinishInstantiating();
 			cargo.AddMissionCargo(&mission);
 			it->Do(Mission::OFFER, *this);
 			it->Do(Mission::ACCEPT, *this, ui);
 			auto spliceIt = it->IsUnique() ? missions.begin() : missions.end();
 			missions.splice(spliceIt, availableJobs, it);
+			npcIndexIsStale = true;
 			break;
 		}
 }
@@ -1701,6 +1779,7 @@ void PlayerInfo::MissionCallback(int response)
 		// to the front, so they appear at the top of the list if viewed.
 		auto spliceIt = mission.IsUnique() ? missions.begin() : missions.end();
 		missions.splice(spliceIt, missionList, missionList.begin());
+		npcIndexIsStale = true;
 		mission.Do(Mission::ACCEPT, *this);
 		if(shouldAutosave)
 			Autosave();
@@ -1746,6 +1825,7 @@ void PlayerInfo::RemoveMission(Mission::Trigger trigger, const Mission &mission,
 			// this first avoids the possibility of an infinite loop, e.g. if a
 			// mission's "on fail" fails the mission itself.
 			doneMissions.splice(doneMissions.end(), missions, it);
+			npcIndexIsStale = true;
 			
 			it->Do(trigger, *this, ui);
 			cargo.RemoveMissionCargo(&mission);
@@ -1782,8 +1862,18 @@ void PlayerInfo::HandleEvent(const ShipEvent &event, UI *ui)
 			rating = min(maxRating, rating + (event.Target()->Cost() + 250000) / 500000);
 		}
 	
+	// Only the NPCs that the event's target belongs to need to see this event,
+	// but they must still see it in the same order as the missions.
+	UpdateNPCIndex();
+	auto it = npcIndex.find(event.Target().get());
+	const vector<pair<Mission *, NPC *>> *owners = (it == npcIndex.end() ? nullptr : &it->second);
+	size_t next = 0;
 	for(Mission &mission : missions)
-		mission.Do(event, *this, ui);
+	{
+		mission.Do(event, *this, ui, false);
+		for( ; owners && next < owners->size() && owners->at(next).first == &mission; ++next)
+			owners->at(next).second->Do(event, *this, ui, mission.IsVisible());
+	}
 	
 	// If the player's flagship was destroyed, the player is dead.
 	if((event.Type() & ShipEvent::DESTROY) && !ships.empty() && event.Target().get() == Flagship())
@@ -1795,14 +1885,13 @@ void PlayerInfo::HandleEvent(const ShipEvent &event, UI *ui)
 // Get the value of the given condition (default 0).
 int64_t PlayerInfo::GetCondition(const string &name) const
 {
-	auto it = conditions.find(name);
-	return (it == conditions.end()) ? 0 : it->second;
+	return conditions.Get(name);
 }
 
 
 
 // Get mutable access to the player's list of conditions.
-map<string, int64_t> &PlayerInfo::Conditions()
+ConditionsStore &PlayerInfo::Conditions()
 {
 	return conditions;
 }
@@ -1810,7 +1899,7 @@ map<string, int64_t> &PlayerInfo::Conditions()
 
 
 // Access the player's list of conditions.
-const map<string, int64_t> &PlayerInfo::Conditions() const
+const ConditionsStore &PlayerInfo::Conditions() const
 {
 	return conditions;
 }
@@ -1824,7 +1913,7 @@ void PlayerInfo::SetReputationConditions()
 	for(const auto &it : GameData::Governments())
 	{
 		int64_t rep = it.second.Reputation();
-		conditions["reputation: " + it.first] = rep;
+		conditions.Set("reputation: " + it.first, rep);
 	}
 }
 
@@ -1835,7 +1924,7 @@ void PlayerInfo::CheckReputationConditions()
 	for(const auto &it : GameData::Governments())
 	{
 		int64_t rep = it.second.Reputation();
-		int64_t newRep = conditions["reputation: " + it.first];
+		int64_t newRep = conditions.Get("reputation: " + it.first);
 		if(newRep != rep)
 			it.second.AddReputation(newRep - rep);
 	}
@@ -1847,7 +1936,7 @@ void PlayerInfo::CheckReputationConditions()
 // they have actually visited it).
 bool PlayerInfo::HasSeen(const System &system) const
 {
-	if(seen.count(&system))
+	if(IsMarked(seen, system.Index()))
 		return true;
 	
 	auto usesSystem = [&system](const Mission &m) noexcept -> bool
@@ -1874,7 +1963,7 @@ bool PlayerInfo::HasSeen(const System &system) const
 // Check if the player has visited the given system.
 bool PlayerInfo::HasVisited(const System &system) const
 {
-	return visitedSystems.count(&system);
+	return IsMarked(visitedSystems, system.Index());
 }
 
 
@@ -1882,7 +1971,7 @@ bool PlayerInfo::HasVisited(const System &system) const
 // Check if the player has visited the given system.
 bool PlayerInfo::HasVisited(const Planet &planet) const
 {
-	return visitedPlanets.count(&planet);
+	return IsMarked(visitedPlanets, planet.Index());
 }
 
 
@@ -1909,11 +1998,11 @@ bool PlayerInfo::KnowsName(const System &system) const
 // Mark the given system as visited, and mark all its neighbors as seen.
 void PlayerInfo::Visit(const System &system)
 {
-	visitedSystems.insert(&system);
-	seen.insert(&system);
+	SetMark(visitedSystems, system.Index());
+	SetMark(seen, system.Index());
 	for(const System *neighbor : system.VisibleNeighbors())
 		if(!neighbor->Hidden() || system.Links().count(neighbor))
-			seen.insert(neighbor);
+			SetMark(seen, neighbor->Index());
 }
 
 
@@ -1921,7 +2010,7 @@ void PlayerInfo::Visit(const System &system)
 // Mark the given planet as visited.
 void PlayerInfo::Visit(const Planet &planet)
 {
-	visitedPlanets.insert(&planet);
+	SetMark(visitedPlanets, planet.Index());
 }
 
 
@@ -1929,7 +2018,7 @@ void PlayerInfo::Visit(const Planet &planet)
 // Mark a system as unvisited, even if visited previously.
 void PlayerInfo::Unvisit(const System &system)
 {
-	visitedSystems.erase(&system);
+	SetMark(visitedSystems, system.Index(), false);
 	for(const StellarObject &object : system.Objects())
 		if(object.GetPlanet())
 			Unvisit(*object.GetPlanet());
@@ -1939,7 +2028,7 @@ void PlayerInfo::Unvisit(const System &system)
 
 void PlayerInfo::Unvisit(const Planet &planet)
 {
-	visitedPlanets.erase(&planet);
+	SetMark(visitedPlanets, planet.Index(), false);
 }
 
 
@@ -2353,12 +2442,9 @@ void PlayerInfo::ApplyChanges()
 	
 	// Check which planets you have dominated.
 	static const string prefix = "tribute: ";
-	for(auto it = conditions.lower_bound(prefix); it != conditions.end(); ++it)
+	for(const auto &it : conditions.WithPrefix(prefix))
 	{
-		if(it->first.compare(0, prefix.length(), prefix))
-			break;
-		
-		const Planet *planet = GameData::Planets().Find(it->first.substr(prefix.length()));
+		const Planet *planet = GameData::Planets().Find(it.first.substr(prefix.length()));
 		if(planet)
 			GameData::GetPolitics().DominatePlanet(planet);
 	}
@@ -2378,6 +2464,31 @@ void PlayerInfo::ApplyChanges()
 
 
 
+// If any changes that were applied affected the systems, update their
+// neighbors and recalculate which of them the player has seen.
+void PlayerInfo::UpdateSystems()
+{
+	if(!changedSystems)
+		return;
+	changedSystems = false;
+	
+	GameData::UpdateSystems();
+	seen.clear();
+	for(const auto &it : GameData::Systems())
+	{
+		const System &system = it.second;
+		if(!HasVisited(system))
+			continue;
+		
+		SetMark(seen, system.Index());
+		for(const System *neighbor : system.VisibleNeighbors())
+			if(!neighbor->Hidden() || system.Links().count(neighbor))
+				SetMark(seen, neighbor->Index());
+	}
+}
+
+
+
 // Make change's to the player's planet, system, & ship locations as needed, to ensure the player and
 // their ships are in valid locations, even if the player did something drastic, such as remove a mod.
 void PlayerInfo::ValidateLoad()
@@ -2460,7 +2571,7 @@ void PlayerInfo::ValidateLoad()
 			startData = GameData::StartOptions().front();
 			// When necessary, record in the pilot file that the starting data is just an assumption.
 			if(startCount >= 2)
-				conditions["unverified start scenario"] = true;
+				conditions.Set("unverified start scenario", true);
 		}
 		else
 			throw runtime_error("Unable to set a starting scenario for an existing pilot. (No valid \"start\" "
@@ -2470,6 +2581,7 @@ void PlayerInfo::ValidateLoad()
 	// Validate the missions that were loaded. Active-but-invalid missions are removed from
 	// the standard mission list, effectively pausing them until necessary data is restored. 
 	missions.sort([](const Mission &lhs, const Mission &rhs) noexcept -> bool { return lhs.IsValid(); });
+	npcIndexIsStale = true;
 	auto isInvalidMission = [](const Mission &m) noexcept -> bool { return !m.IsValid(); };
 	auto mit = find_if(missions.begin(), missions.end(), isInvalidMission);
 	if(mit != missions.end())
@@ -2483,76 +2595,105 @@ void PlayerInfo::ValidateLoad()
 
 
 
-// Update the conditions that reflect the current status of the player.
+// Update the conditions that reflect the current status of the player. Rather
+// than calculating them all now, replace the functions that provide them, so
+// that each one is calculated the first time it is read. The providers refer
+// to this object, so this must be called again if it is copied.
 void PlayerInfo::UpdateAutoConditions(bool isBoarding)
 {
 	// Bound financial conditions to +/- 4.6 x 10^18 credits, within the range of a 64-bit int.
 	static constexpr int64_t limit = static_cast<int64_t>(1) << 62;
-	conditions["net worth"] = min(limit, max(-limit, accounts.NetWorth()));
-	conditions["credits"] = min(limit, accounts.Credits());
-	conditions["unpaid mortgages"] = min(limit, accounts.TotalDebt("Mortgage"));
-	conditions["unpaid fines"] = min(limit, accounts.TotalDebt("Fine"));
-	conditions["unpaid salaries"] = min(limit, accounts.SalariesOwed());
-	conditions["unpaid maintenance"] = min(limit, accounts.MaintenanceDue());
-	conditions["credit score"] = accounts.CreditScore();
-	// Serialize the current reputation with other governments.
+	conditions.SetProvider(NET_WORTH, [this]() { return min(limit, max(-limit, accounts.NetWorth())); });
+	conditions.SetProvider(CREDITS, [this]() { return min(limit, accounts.Credits()); });
+	conditions.SetProvider(UNPAID_MORTGAGES, [this]() { return min(limit, accounts.TotalDebt("Mortgage")); });
+	conditions.SetProvider(UNPAID_FINES, [this]() { return min(limit, accounts.TotalDebt("Fine")); });
+	conditions.SetProvider(UNPAID_SALARIES, [this]() { return min(limit, accounts.SalariesOwed()); });
+	conditions.SetProvider(UNPAID_MAINTENANCE, [this]() { return min(limit, accounts.MaintenanceDue()); });
+	conditions.SetProvider(CREDIT_SCORE, [this]() -> int64_t { return accounts.CreditScore(); });
+	// Serialize the current reputation with other governments. Missions can
+	// modify these conditions, so they must actually be stored.
 	SetReputationConditions();
-	// Helper lambda function to clear a range
-	auto clearRange = [](map<string, int64_t> &conditionsMap, string firstStr, string lastStr)
-	{
-		auto first = conditionsMap.lower_bound(firstStr);
-		auto last = conditionsMap.lower_bound(lastStr);
-		if(first != last)
-			conditionsMap.erase(first, last);
-	};
-	// Clear any existing ships: conditions. (Note: '!' = ' ' + 1.)
-	clearRange(conditions, "ships: ", "ships:!");
-	// Store special conditions for cargo and passenger space.
-	conditions["cargo space"] = 0;
-	conditions["passenger space"] = 0;
-	for(const shared_ptr<Ship> &ship : ships)
-		if(!ship->IsParked() && !ship->IsDisabled() && ship->GetSystem() == system)
-		{
-			conditions["cargo space"] += ship->Attributes().Get("cargo space");
-			conditions["passenger space"] += ship->Attributes().Get("bunks") - ship->RequiredCrew();
-			++conditions["ships: " + ship->Attributes().Category()];
-		}
-	// If boarding a ship, missions should not consider the space available
-	// in the player's entire fleet. The only fleet parameter offered to a
-	// boarding mission is the fleet composition (e.g. 4 Heavy Warships).
-	if(isBoarding && flagship)
-	{
-		conditions["cargo space"] = flagship->Cargo().Free();
-		conditions["passenger space"] = flagship->Cargo().BunksFree();
-	}
 	
-	// Clear any existing flagship system: and planet: conditions. (Note: '!' = ' ' + 1.)
-	clearRange(conditions, "flagship system: ", "flagship system:!");
-	clearRange(conditions, "flagship planet: ", "flagship planet:!");
-	
-	// Store conditions for flagship current crew, required crew, and bunks.
-	if(flagship)
+	// Special conditions for cargo and passenger space. If boarding a ship,
+	// missions should not consider the space available in the player's entire
+	// fleet. The only fleet parameter offered to a boarding mission is the
+	// fleet composition (e.g. 4 Heavy Warships).
+	conditions.SetProvider(CARGO_SPACE, [this, isBoarding]() -> int64_t
 	{
-		conditions["flagship crew"] = flagship->Crew();
-		conditions["flagship required crew"] = flagship->RequiredCrew();
-		conditions["flagship bunks"] = flagship->Attributes().Get("bunks");
-		if(flagship->GetSystem())
-			conditions["flagship system: " + flagship->GetSystem()->Name()] = 1;
-		if(flagship->GetPlanet())
-			conditions["flagship planet: " + flagship->GetPlanet()->TrueName()] = 1;
-	}
-	else
+		if(isBoarding && flagship)
+			return flagship->Cargo().Free();
+		
+		// Each value is truncated separately, as they were when they were
+		// added to the conditions one at a time.
+		int64_t cargoSpace = 0;
+		for(const shared_ptr<Ship> &ship : ships)
+			if(IsInFleet(*ship, system))
+				cargoSpace += static_cast<int64_t>(ship->Attributes().Get("cargo space"));
+		return cargoSpace;
+	});
+	conditions.SetProvider(PASSENGER_SPACE, [this, isBoarding]() -> int64_t
+	{
+		if(isBoarding && flagship)
+			return flagship->Cargo().BunksFree();
+		
+		int64_t passengerSpace = 0;
+		for(const shared_ptr<Ship> &ship : ships)
+			if(IsInFleet(*ship, system))
+				passengerSpace += static_cast<int64_t>(ship->Attributes().Get("bunks") - ship->RequiredCrew());
+		return passengerSpace;
+	});
+	conditions.SetPrefixProvider("ships: ", [this]()
 	{
-		conditions["flagship crew"] = 0;
-		conditions["flagship required crew"] = 0;
-		conditions["flagship bunks"] = 0;
-	}
+		map<string, int64_t> shipCategories;
+		for(const shared_ptr<Ship> &ship : ships)
+			if(IsInFleet(*ship, system))
+				++shipCategories[ship->Attributes().Category()];
+		return shipCategories;
+	});
+	
+	// Conditions for flagship current crew, required crew, and bunks, and for
+	// the system and planet that the flagship is in.
+	conditions.SetProvider(FLAGSHIP_CREW, [this]() -> int64_t
+	{
+		return flagship ? flagship->Crew() : 0;
+	});
+	conditions.SetProvider(FLAGSHIP_REQUIRED_CREW, [this]() -> int64_t
+	{
+		return flagship ? flagship->RequiredCrew() : 0;
+	});
+	conditions.SetProvider(FLAGSHIP_BUNKS, [this]() -> int64_t
+	{
+		return flagship ? flagship->Attributes().Get("bunks") : 0.;
+	});
+	conditions.SetPrefixProvider("flagship system: ", [this]()
+	{
+		map<string, int64_t> flagshipSystem;
+		if(flagship && flagship->GetSystem())
+			flagshipSystem[flagship->GetSystem()->Name()] = 1;
+		return flagshipSystem;
+	});
+	conditions.SetPrefixProvider("flagship planet: ", [this]()
+	{
+		map<string, int64_t> flagshipPlanet;
+		if(flagship && flagship->GetPlanet())
+			flagshipPlanet[flagship->GetPlanet()->TrueName()] = 1;
+		return flagshipPlanet;
+	});
 	
 	// Conditions for your fleet's attractiveness to pirates:
-	pair<double, double> factors = RaidFleetFactors();
-	conditions["cargo attractiveness"] = factors.first;
-	conditions["armament deterrence"] = factors.second;
-	conditions["pirate attraction"] = factors.first - factors.second;
+	conditions.SetProvider(CARGO_ATTRACTIVENESS, [this]() -> int64_t
+	{
+		return RaidFleetFactors().first;
+	});
+	conditions.SetProvider(ARMAMENT_DETERRENCE, [this]() -> int64_t
+	{
+		return RaidFleetFactors().second;
+	});
+	conditions.SetProvider(PIRATE_ATTRACTION, [this]() -> int64_t
+	{
+		pair<double, double> factors = RaidFleetFactors();
+		return factors.first - factors.second;
+	});
 }
 
 
@@ -2562,6 +2703,19 @@ void PlayerInfo::CreateMissions()
 {
 	boardingMissions.clear();
 	
+	// Any missions that were rejected because of their "to offer" conditions
+	// must be checked again if any of those conditions have changed.
+	for(unsigned id : conditions.ChangedSince(offersRevision))
+	{
+		auto it = rejectedByCondition.find(id);
+		if(it == rejectedByCondition.end())
+			continue;
+		for(const Mission *mission : it->second)
+			rejectedOffers.erase(mission);
+		rejectedByCondition.erase(it);
+	}
+	offersRevision = conditions.Revision();
+	
 	// Check for available missions.
 	bool skipJobs = planet && !planet->IsInhabited();
 	bool hasPriorityMissions = false;
@@ -2571,6 +2725,8 @@ void PlayerInfo::CreateMissions()
 			continue;
 		if(skipJobs && it.second.IsAtLocation(Mission::JOB))
 			continue;
+		if(!CanOfferMission(it.second))
+			continue;
 		
 		if(it.second.CanOffer(*this))
 		{
@@ -2620,6 +2776,28 @@ void PlayerInfo::CreateMissions()
 
 
 
+// Check if the given mission's "to offer" conditions are met. If they are not,
+// and they do not depend on random numbers, the mission will be skipped until
+// one of the conditions they read changes.
+bool PlayerInfo::CanOfferMission(const Mission &mission)
+{
+	if(rejectedOffers.count(&mission))
+		return false;
+	if(mission.ToOffer().Test(conditions))
+		return true;
+	
+	vector<unsigned> ids;
+	if(mission.ToOffer().ReferencedConditions(ids))
+	{
+		rejectedOffers.insert(&mission);
+		for(unsigned id : ids)
+			rejectedByCondition[id].insert(&mission);
+	}
+	return false;
+}
+
+
+
 // Updates each mission upon landing, to perform landing actions (Stopover,
 // Visit, Complete, Fail), and remove now-complete or now-failed missions.
 void PlayerInfo::StepMissions(UI *ui)
@@ -2714,6 +2892,23 @@ void PlayerInfo::StepMissions(UI *ui)
 
 
 
+// Rebuild the index of which mission NPCs each ship belongs to, if the
+// list of active missions has changed since it was last built.
+void PlayerInfo::UpdateNPCIndex()
+{
+	if(!npcIndexIsStale)
+		return;
+	
+	npcIndex.clear();
+	for(Mission &mission : missions)
+		for(NPC &npc : mission.NPCs())
+			for(const shared_ptr<Ship> &ship : npc.Ships())
+				npcIndex[ship.get()].emplace_back(&mission, &npc);
+	npcIndexIsStale = false;
+}
+
+
+
 void PlayerInfo::Autosave() const
 {
 	if(!CanBeSaved() || filePath.length() < 4)
@@ -2725,11 +2920,20 @@ void PlayerInfo::Autosave() const
 
 
 
+// Compose the save file on this thread, but write it to disk in the background
+// so that saving does not interrupt the game.
 void PlayerInfo::Save(const string &path) const
 {
-	DataWriter out(path);
-	
-	
+	DataWriter out;
+	Save(out);
+	out.SaveInBackground(path);
+}
+
+
+
+// Write everything that goes in the save file.
+void PlayerInfo::Save(DataWriter &out) const
+{
 	// Basic player information and persistent UI settings:
 	
 	// Pilot information:
@@ -2742,6 +2946,16 @@ void PlayerInfo::Save(const string &path) const
 	if(planet && planet->CanUseServices())
 		out.Write("clearance");
 	out.Write("playtime", playTime);
+	// Summarize the rest of the file, so that the load panel only needs to read
+	// the start of it.
+	out.Write("summary");
+	out.BeginChild();
+	{
+		out.Write("credits", accounts.Credits());
+		if(!ships.empty() && ships.front()->GetSprite())
+			out.Write("ship", ships.front()->Name(), ships.front()->GetSprite()->Name());
+	}
+	out.EndChild();
 	// This flag is set if the player must leave the planet immediately upon
 	// entering their ship (i.e. because a mission forced them to take off).
 	if(shouldLaunch)
@@ -2862,12 +3076,12 @@ void PlayerInfo::Save(const string &path) const
 		mission.Save(out, "available mission");
 	
 	// Save any "condition" flags that are set.
-	if(!conditions.empty())
+	if(!conditions.IsEmpty())
 	{
 		out.Write("conditions");
 		out.BeginChild();
 		{
-			for(const auto &it : conditions)
+			for(const auto &it : conditions.WithPrefix())
 			{
 				// If the condition's value is 1, don't bother writing the 1.
 				if(it.second == 1)
@@ -2880,8 +3094,8 @@ void PlayerInfo::Save(const string &path) const
 	}
 	
 	// Save pending events, and changes that have happened due to past events.
-	for(const GameEvent &event : gameEvents)
-		event.Save(out);
+	for(const auto &it : gameEvents)
+		it.second.Save(out);
 	if(!dataChanges.empty())
 	{
 		out.Write("changes");
@@ -2904,23 +3118,16 @@ void PlayerInfo::Save(const string &path) const
 	out.Write();
 	out.WriteComment("What you know:");
 	
-	// Save a list of systems the player has visited.
-	WriteSorted(visitedSystems,
-		[](const System *const *lhs, const System *const *rhs)
-			{ return (*lhs)->Name() < (*rhs)->Name(); },
-		[&out](const System *system)
-		{
-			out.Write("visited", system->Name());
-		});
+	// Save a list of systems the player has visited. The game data is already
+	// sorted by name.
+	for(const auto &it : GameData::Systems())
+		if(HasVisited(it.second))
+			out.Write("visited", it.second.Name());
 	
 	// Save a list of planets the player has visited.
-	WriteSorted(visitedPlanets,
-		[](const Planet *const *lhs, const Planet *const *rhs)
-			{ return (*lhs)->TrueName() < (*rhs)->TrueName(); },
-		[&out](const Planet *planet)
-		{
-			out.Write("visited planet", planet->TrueName());
-		});
+	for(const auto &it : GameData::Planets())
+		if(HasVisited(it.second))
+			out.Write("visited planet", it.second.TrueName());
 	
 	if(!harvested.empty())
 	{
@@ -15,12 +15,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Account.h"
 #include "CargoHold.h"
+#include "ConditionsStore.h"
 #include "CoreStartData.h"
 #include "DataNode.h"
 #include "Date.h"
 #include "Depreciation.h"
 #include "GameEvent.h"
 #include "Mission.h"
+#include "SaveJournal.h"
 
 #include <chrono>
 #include <list>
@@ -31,6 +33,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <utility>
 #include <vector>
 
+class DataWriter;
 class Government;
 class Outfit;
 class Planet;
@@ -65,8 +68,12 @@ public:
 	void Load(const std::string &path);
 	// Load the most recently saved player. If no save could be loaded, returns false.
 	bool LoadRecent();
-	// Save this player (using the Identifier() as the file name).
-	void Save() const;
+	// Save this player (using the Identifier() as the file name). If journaled
+	// saves are on, this may only record what changed since the last full
+	// save, unless a full save is requested (e.g. when quitting).
+	void Save(bool isFull = false) const;
+	// Write everything that goes in this player's saved game.
+	void Save(DataWriter &out) const;
 	
 	// Get the root filename used for this player's saved game files. (If there
 	// are multiple pilots with the same name it may have a digit appended.)
@@ -194,8 +201,8 @@ public:
 	
 	// Access the "condition" flags for this player.
 	int64_t GetCondition(const std::string &name) const;
-	std::map<std::string, int64_t> &Conditions();
-	const std::map<std::string, int64_t> &Conditions() const;
+	ConditionsStore &Conditions();
+	const ConditionsStore &Conditions() const;
 	// Set and check the reputation conditions, which missions and events
 	// can use to modify the player's reputation with other governments.
 	void SetReputationConditions();
@@ -273,13 +280,22 @@ private:
 	
 	// Apply any "changes" saved in this player info to the global game state.
 	void ApplyChanges();
+	// If any changes that were applied affected the systems, update their
+	// neighbors and recalculate which of them the player has seen.
+	void UpdateSystems();
 	// After loading & applying changes, make sure the player & ship locations are sensible.
 	void ValidateLoad();
 	
 	// New missions are generated each time you land on a planet.
 	void UpdateAutoConditions(bool isBoarding = false);
 	void CreateMissions();
+	// Check if the given mission's "to offer" conditions are met, remembering
+	// if they are not so that it is not checked again until they change.
+	bool CanOfferMission(const Mission &mission);
 	void StepMissions(UI *ui);
+	// Rebuild the index of which mission NPCs each ship belongs to, if the
+	// list of active missions has changed since it was last built.
+	void UpdateNPCIndex();
 	void Autosave() const;
 	void Save(const std::string &path) const;
 	
@@ -297,6 +313,8 @@ private:
 	std::string firstName;
 	std::string lastName;
 	std::string filePath;
+	// Record of the last full save, so that later saves can be journaled.
+	mutable SaveJournal journal;
 	
 	Date date;
 	const System *system = nullptr;
@@ -336,12 +354,31 @@ private:
 	// This pointer to the most recently accepted boarding mission enables
 	// its NPCs to be placed before the player lands, and is then cleared.
 	Mission *activeBoardingMission = nullptr;
-	
-	std::map<std::string, int64_t> conditions;
-	
-	std::set<const System *> seen;
-	std::set<const System *> visitedSystems;
-	std::set<const Planet *> visitedPlanets;
+	// For each ship belonging to an active mission's NPC, which mission and
+	// NPC it belongs to (in mission order), so that a ship event only has to
+	// be passed to the NPCs that care about it. This must be marked as stale
+	// whenever a mission is added to or removed from the active list.
+	std::map<const Ship *, std::vector<std::pair<Mission *, NPC *>>> npcIndex;
+	bool npcIndexIsStale = true;
+	
+	ConditionsStore conditions;
+	// Missions whose "to offer" conditions were not met the last time they were
+	// checked, and for each condition, which of those missions read it. The
+	// missions only need to be checked again once one of those conditions has
+	// changed since the revision when the offers were last updated.
+	std::set<const Mission *> rejectedOffers;
+	std::map<unsigned, std::set<const Mission *>> rejectedByCondition;
+	uint64_t offersRevision = 0;
+	
+	// Which systems the player has seen or visited, and which planets they have
+	// visited, with one entry for each system or planet index.
+	std::vector<bool> seen;
+	std::vector<bool> visitedSystems;
+	// Whether several events' changes are being applied at once, and whether
+	// any changes since the systems were last updated have affected them.
+	bool isBatchingChanges = false;
+	bool changedSystems = false;
+	std::vector<bool> visitedPlanets;
 	std::vector<const System *> travelPlan;
 	const Planet *travelDestination = nullptr;
 	
@@ -358,8 +395,10 @@ private:
 	DataNode economy;
 	// Persons that have been killed in this player's universe:
 	std::vector<std::string> destroyedPersons;
-	// Events that are going to happen some time in the future:
-	std::list<GameEvent> gameEvents;
+	// Events that are going to happen some time in the future, sorted by the
+	// date when they will happen. Events on the same date stay in the order in
+	// which they were added.
+	std::multimap<Date, GameEvent> gameEvents;
 	
 	// The system and position therein to which the "orbits" system UI issued a move order.
 	std::pair<const System *, Point> interstellarEscortDestination;
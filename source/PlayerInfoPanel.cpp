@@ -50,14 +50,9 @@ namespace {
 	{
 		vector<pair<int64_t, string>> match;
 		
-		auto it = player.Conditions().lower_bound(prefix);
-		for( ; it != player.Conditions().end(); ++it)
-		{
-			if(it->first.compare(0, prefix.length(), prefix))
-				break;
-			if(it->second > 0)
-				match.emplace_back(it->second, it->first.substr(prefix.length()) + suffix);
-		}
+		for(const auto &it : player.Conditions().WithPrefix(prefix))
+			if(it.second > 0)
+				match.emplace_back(it.second, it.first.substr(prefix.length()) + suffix);
 		return match;
 	}
 	
@@ -588,6 +583,7 @@ void PlayerInfoPanel::DrawFleet(const Rectangle &bounds)
 	table.DrawGap(5);
 	
 	// Loop through all the player's ships.
+	rows.resize(player.Ships().size());
 	int index = scroll;
 	for(auto sit = player.Ships().begin() + scroll; sit < player.Ships().end(); ++sit)
 	{
@@ -617,23 +613,29 @@ void PlayerInfoPanel::DrawFleet(const Rectangle &bounds)
 		const System *system = ship.GetSystem();
 		table.Draw(system ? system->Name() : "");
 		
-		string shields = to_string(static_cast<int>(100. * max(0., ship.Shields()))) + "%";
-		table.Draw(shields);
-		
-		string hull = to_string(static_cast<int>(100. * max(0., ship.Hull()))) + "%";
-		table.Draw(hull);
-		
-		string fuel = to_string(static_cast<int>(
-			ship.Attributes().Get("fuel capacity") * ship.Fuel()));
-		table.Draw(fuel);
-		
 		// If this isn't the flagship, we'll remember how many crew it has, but
 		// only the minimum number of crew need to be paid for.
 		int crewCount = ship.Crew();
 		if(&ship != player.Flagship())
 			crewCount = min(crewCount, ship.RequiredCrew());
-		string crew = (ship.IsParked() ? "Parked" : to_string(crewCount));
-		table.Draw(crew);
+		const int values[4] = {
+			static_cast<int>(100. * max(0., ship.Shields())),
+			static_cast<int>(100. * max(0., ship.Hull())),
+			static_cast<int>(ship.Attributes().Get("fuel capacity") * ship.Fuel()),
+			ship.IsParked() ? -1 : crewCount};
+		
+		Row &row = rows[index];
+		if(row.ship != &ship || !equal(values, values + 4, row.values))
+		{
+			row.ship = &ship;
+			copy(values, values + 4, row.values);
+			row.cells[0] = to_string(values[0]) + "%";
+			row.cells[1] = to_string(values[1]) + "%";
+			row.cells[2] = to_string(values[2]);
+			row.cells[3] = (values[3] < 0 ? "Parked" : to_string(values[3]));
+		}
+		for(const string &cell : row.cells)
+			table.Draw(cell);
 		
 		++index;
 	}
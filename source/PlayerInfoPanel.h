@@ -19,10 +19,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 
 #include <set>
+#include <string>
 #include <vector>
 
 class PlayerInfo;
 class Rectangle;
+class Ship;
 
 
 
@@ -61,10 +63,24 @@ private:
 	bool Scroll(int distance);
 	
 	
+private:
+	// The status columns of one row of the fleet listing, as they were last
+	// formatted, and the values they were formatted from.
+	class Row {
+	public:
+		const Ship *ship = nullptr;
+		int values[4] = {};
+		std::string cells[4];
+	};
+	
+	
 private:
 	PlayerInfo &player;
 	
 	std::vector<ClickZone<int>> zones;
+	// Rows are only formatted again when the ship's status has changed. Only
+	// the rows that are on screen are ever formatted.
+	std::vector<Row> rows;
 	// Keep track of which ship the mouse is hovering over, which ship was most
 	// recently selected, which ship is currently being dragged, and all ships
 	// that are currently selected.
@@ -13,25 +13,62 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PointerShader.h"
 
 #include "Color.h"
+#include "GpuProfiler.h"
 #include "Point.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint centerI;
-	GLint angleI;
-	GLint sizeI;
-	GLint offsetI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each vertex has its corner (x, y), and then a copy of the data for the
+	// pointer that it is part of: the center (2 floats), the direction it
+	// points in (2), its width and height, its offset, and its color (4).
+	constexpr int FLOATS_PER_VERTEX = 13;
+	// Each pointer is drawn as a single triangle.
+	const float CORNERS[] = {
+		0.f, 0.f,
+		0.f, 1.f,
+		1.f, 0.f
+	};
+	
+	// Pointers that are drawn one after another are collected here, so they
+	// can all be drawn with a single draw call.
+	vector<float> vertices;
+	
+	// Draw all the pointers that have been added but not drawn yet.
+	void Flush()
+	{
+		if(vertices.empty())
+			return;
+		
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+		GpuProfiler::CountUpload();
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+		GpuProfiler::CountDraw();
+		vertices.clear();
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+	}
 }
 
 
@@ -41,16 +78,21 @@ void PointerShader::Init()
 	static const char *vertexCode =
 		"// vertex pointer shader\n"
 		"uniform vec2 scale;\n"
-		"uniform vec2 center;\n"
-		"uniform vec2 angle;\n"
-		"uniform vec2 size;\n"
-		"uniform float offset;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 center;\n"
+		"in vec2 angle;\n"
+		"in vec2 size;\n"
+		"in float offset;\n"
+		"in vec4 color;\n"
 		"out vec2 coord;\n"
+		"out float fragWidth;\n"
+		"out vec4 fragColor;\n"
 		
 		"void main() {\n"
 		"  coord = vert * size.x;\n"
+		"  fragWidth = size.x;\n"
+		"  fragColor = color;\n"
 		"  vec2 base = center + angle * (offset - size.y * (vert.x + vert.y));\n"
 		"  vec2 wing = vec2(angle.y, -angle.x) * (size.x * .5 * (vert.x - vert.y));\n"
 		"  gl_Position = vec4((base + wing) * scale, 0, 1);\n"
@@ -58,45 +100,43 @@ void PointerShader::Init()
 
 	static const char *fragmentCode =
 		"// fragment pointer shader\n"
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		"uniform vec2 size;\n"
-		
 		"in vec2 coord;\n"
+		"in float fragWidth;\n"
+		"in vec4 fragColor;\n"
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  float height = (coord.x + coord.y) / size.x;\n"
+		"  float height = (coord.x + coord.y) / fragWidth;\n"
 		"  float taper = height * height * height;\n"
-		"  taper *= taper * .5 * size.x;\n"
+		"  taper *= taper * .5 * fragWidth;\n"
 		"  float alpha = clamp(.8 * min(coord.x, coord.y) - taper, 0, 1);\n"
 		"  alpha *= clamp(1.8 * (1. - height), 0, 1);\n"
-		"  finalColor = color * alpha;\n"
+		"  finalColor = fragColor * alpha;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	centerI = shader.Uniform("center");
-	angleI = shader.Uniform("angle");
-	sizeI = shader.Uniform("size");
-	offsetI = shader.Uniform("offset");
-	colorI = shader.Uniform("color");
 	
-	// Generate the vertex data for drawing sprites.
+	// Generate the buffer for uploading the batched vertex data.
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		0.f, 0.f,
-		0.f, 1.f,
-		1.f, 0.f,
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	// Enable each of the vertex attributes, at its offset within the vertex.
+	struct Attribute { const char *name; int size; };
+	static const Attribute ATTRIBUTES[] = {
+		{"vert", 2}, {"center", 2}, {"angle", 2}, {"size", 2}, {"offset", 1}, {"color", 4}};
+	int offset = 0;
+	for(const Attribute &attribute : ATTRIBUTES)
+	{
+		GLint index = shader.Attrib(attribute.name);
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, attribute.size, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(GLfloat),
+			reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+		offset += attribute.size;
+	}
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -106,52 +146,24 @@ void PointerShader::Init()
 
 
 void PointerShader::Draw(const Point &center, const Point &angle, float width, float height, float offset, const Color &color)
-{
-	Bind();
-	
-	Add(center, angle, width, height, offset, color);
-	
-	Unbind();
-}
-
-
-	
-void PointerShader::Bind()
 {
 	if(!shader.Object())
-		throw runtime_error("PointerShader: Bind() called before Init().");
-	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
-}
-
-
-
-void PointerShader::Add(const Point &center, const Point &angle, float width, float height, float offset, const Color &color)
-{
-	GLfloat c[2] = {static_cast<float>(center.X()), static_cast<float>(center.Y())};
-	glUniform2fv(centerI, 1, c);
-	
-	GLfloat a[2] = {static_cast<float>(angle.X()), static_cast<float>(angle.Y())};
-	glUniform2fv(angleI, 1, a);
-	
-	GLfloat size[2] = {width, height};
-	glUniform2fv(sizeI, 1, size);
-	
-	glUniform1f(offsetI, offset);
-	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	glDrawArrays(GL_TRIANGLES, 0, 3);
-}
-
-
-
-void PointerShader::Unbind()
-{
-	glBindVertexArray(0);
-	glUseProgram(0);
+		throw runtime_error("PointerShader: Draw() called before Init().");
+	
+	// The pointer is not drawn until something other than a pointer needs to
+	// be drawn, so that consecutive pointers share one draw call.
+	RenderQueue::Add(Flush);
+	
+	const float data[] = {
+		static_cast<float>(center.X()), static_cast<float>(center.Y()),
+		static_cast<float>(angle.X()), static_cast<float>(angle.Y()),
+		width, height,
+		offset};
+	const float *rgba = color.Get();
+	for(int i = 0; i < 6; i += 2)
+	{
+		vertices.insert(vertices.end(), CORNERS + i, CORNERS + i + 2);
+		vertices.insert(vertices.end(), data, data + 7);
+		vertices.insert(vertices.end(), rgba, rgba + 4);
+	}
 }
@@ -19,15 +19,13 @@ class Point;
 
 
 // Functions for drawing triangular "pointers," e.g. for target crosshairs.
+// Pointers that are drawn one after another are collected and drawn together,
+// with a single draw call.
 class PointerShader {
 public:
 	static void Init();
 	
 	static void Draw(const Point &center, const Point &angle, float width, float height, float offset, const Color &color);
-	
-	static void Bind();
-	static void Add(const Point &center, const Point &angle, float width, float height, float offset, const Color &color);
-	static void Unbind();
 };
 
 
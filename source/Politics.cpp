@@ -34,6 +34,7 @@ void Politics::Reset()
 	reputationWith.clear();
 	dominatedPlanets.clear();
 	ResetDaily();
+	++revision;
 	
 	for(const auto &it : GameData::Governments())
 		reputationWith[&it.second] = it.second.InitialPlayerReputation();
@@ -42,11 +43,44 @@ void Politics::Reset()
 	// were already checked for when you first landed).
 	for(const auto &it : GameData::Governments())
 		fined.insert(&it.second);
+	
+	UpdateHostility();
 }
 
 
 
+// Check whether two governments are hostile to each other.
 bool Politics::IsEnemy(const Government *first, const Government *second) const
+{
+	size_t row = first->ID();
+	size_t column = second->ID();
+	if(row >= governmentCount || column >= governmentCount)
+		return CalculateIsEnemy(first, second);
+	
+	size_t bit = row * governmentCount + column;
+	return (hostility[bit / 64] >> (bit % 64)) & 1;
+}
+
+
+
+// Recalculate whether each pair of governments is hostile.
+void Politics::UpdateHostility()
+{
+	governmentCount = 0;
+	for(const auto &it : GameData::Governments())
+		governmentCount = max<size_t>(governmentCount, it.second.ID() + 1);
+	hostility.assign((governmentCount * governmentCount + 63) / 64, 0);
+	
+	for(const auto &first : GameData::Governments())
+		for(const auto &second : GameData::Governments())
+			SetHostility(first.second.ID(), second.second.ID(),
+				CalculateIsEnemy(&first.second, &second.second));
+	++revision;
+}
+
+
+
+bool Politics::CalculateIsEnemy(const Government *first, const Government *second) const
 {
 	if(first == second)
 		return false;
@@ -73,6 +107,34 @@ bool Politics::IsEnemy(const Government *first, const Government *second) const
 
 
 
+// Recalculate the player's row and column of the hostility table.
+void Politics::UpdatePlayerHostility()
+{
+	const Government *player = GameData::PlayerGovernment();
+	if(!player || player->ID() >= governmentCount)
+		return;
+	
+	for(const auto &it : GameData::Governments())
+	{
+		bool isEnemy = CalculateIsEnemy(player, &it.second);
+		SetHostility(player->ID(), it.second.ID(), isEnemy);
+		SetHostility(it.second.ID(), player->ID(), isEnemy);
+	}
+}
+
+
+
+void Politics::SetHostility(size_t first, size_t second, bool isEnemy)
+{
+	size_t bit = first * governmentCount + second;
+	if(isEnemy)
+		hostility[bit / 64] |= uint64_t(1) << (bit % 64);
+	else
+		hostility[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+}
+
+
+
 // Commit the given "offense" against the given government (which may not
 // actually consider it to be an offense). This may result in temporary
 // hostilities (if the even type is PROVOKE), or a permanent change to your
@@ -82,6 +144,7 @@ void Politics::Offend(const Government *gov, int eventType, int count)
 	if(gov->IsPlayer())
 		return;
 	
+	++revision;
 	for(const auto &it : GameData::Governments())
 	{
 		const Government *other = &it.second;
@@ -112,6 +175,7 @@ void Politics::Offend(const Government *gov, int eventType, int count)
 			reputationWith[other] -= penalty;
 		}
 	}
+	UpdatePlayerHostility();
 }
 
 
@@ -122,6 +186,8 @@ void Politics::Bribe(const Government *gov)
 	bribed.insert(gov);
 	provoked.erase(gov);
 	fined.insert(gov);
+	++revision;
+	UpdatePlayerHostility();
 }
 
 
@@ -181,6 +247,7 @@ bool Politics::CanUseServices(const Planet *planet) const
 void Politics::BribePlanet(const Planet *planet, bool fullAccess)
 {
 	bribedPlanets[planet] = fullAccess;
+	++revision;
 }
 
 
@@ -191,6 +258,7 @@ void Politics::DominatePlanet(const Planet *planet, bool dominate)
 		dominatedPlanets.insert(planet);
 	else
 		dominatedPlanets.erase(planet);
+	++revision;
 }
 
 
@@ -311,6 +379,8 @@ double Politics::Reputation(const Government *gov) const
 void Politics::AddReputation(const Government *gov, double value)
 {
 	reputationWith[gov] += value;
+	++revision;
+	UpdatePlayerHostility();
 }
 
 
@@ -318,6 +388,8 @@ void Politics::AddReputation(const Government *gov, double value)
 void Politics::SetReputation(const Government *gov, double value)
 {
 	reputationWith[gov] = value;
+	++revision;
+	UpdatePlayerHostility();
 }
 
 
@@ -325,8 +397,21 @@ void Politics::SetReputation(const Government *gov, double value)
 // Reset any temporary provocation (typically because a day has passed).
 void Politics::ResetDaily()
 {
+	// Fines do not affect anything but this class, so clearing them does not
+	// count as a change.
+	if(!provoked.empty() || !bribed.empty() || !bribedPlanets.empty())
+		++revision;
 	provoked.clear();
 	bribed.clear();
 	bribedPlanets.clear();
 	fined.clear();
+	UpdatePlayerHostility();
+}
+
+
+
+// Get a number that changes whenever reputations or landing permissions change.
+uint64_t Politics::Revision() const
+{
+	return revision;
 }
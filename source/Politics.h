@@ -13,9 +13,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef POLITICS_H_
 #define POLITICS_H_
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 class Government;
 class Planet;
@@ -33,7 +35,12 @@ public:
 	// Reset to the initial political state defined in the game data.
 	void Reset();
 	
+	// Check whether two governments are hostile to each other. This is looked
+	// up in a table that is kept up to date as the political situation changes.
 	bool IsEnemy(const Government *first, const Government *second) const;
+	// Recalculate that table, e.g. because governments' attitudes toward each
+	// other have changed.
+	void UpdateHostility();
 	
 	// Commit the given "offense" against the given government (which may not
 	// actually consider it to be an offense). This may result in temporary
@@ -65,6 +72,19 @@ public:
 	// Reset any temporary effects (typically because a day has passed).
 	void ResetDaily();
 	
+	// Get a number that changes whenever reputations or landing permissions
+	// change, so that anything derived from them knows when to update.
+	uint64_t Revision() const;
+	
+	
+private:
+	// Check whether two governments are enemies, without using the table.
+	bool CalculateIsEnemy(const Government *first, const Government *second) const;
+	// Recalculate only the player's row and column of the table, because
+	// something changed in the player's relationships.
+	void UpdatePlayerHostility();
+	void SetHostility(size_t first, size_t second, bool isEnemy);
+	
 	
 private:
 	// attitude[target][other] stores how much an action toward the given target
@@ -78,6 +98,14 @@ private:
 	std::map<const Planet *, bool> bribedPlanets;
 	std::set<const Planet *> dominatedPlanets;
 	std::set<const Government *> fined;
+	
+	uint64_t revision = 0;
+	
+	// A bit for each pair of governments (by ID) that is set if they are
+	// enemies. Governments created after the table was last calculated, which
+	// therefore do not fit in it, are checked the slow way instead.
+	std::vector<uint64_t> hostility;
+	size_t governmentCount = 0;
 };
 
 
@@ -0,0 +1,116 @@
+/* PoolAllocator.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef POOL_ALLOCATOR_H_
+#define POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+
+
+// Allocator for objects that are created and destroyed in large numbers, such
+// as flotsam. Freed memory is kept on a free list (one for each type) to be
+// handed out again, instead of being returned to the system, so once the pool
+// has grown to the peak number of objects no more heap allocations are needed.
+// This can be used with std::allocate_shared(), so that the object and its
+// reference counts are allocated together in one pooled block.
+template <class Type>
+class PoolAllocator {
+public:
+	using value_type = Type;
+	
+	PoolAllocator() noexcept = default;
+	template <class Other>
+	PoolAllocator(const PoolAllocator<Other> &) noexcept {}
+	
+	Type *allocate(std::size_t n);
+	void deallocate(Type *p, std::size_t n) noexcept;
+	
+	// All pool allocators of the same type share the same pool.
+	template <class Other>
+	bool operator==(const PoolAllocator<Other> &) const noexcept { return true; }
+	template <class Other>
+	bool operator!=(const PoolAllocator<Other> &) const noexcept { return false; }
+	
+	
+private:
+	// Objects may be released from any thread (e.g. when the last reference to
+	// them is dropped), so the free list is guarded by a mutex.
+	static std::mutex &Mutex();
+	static std::vector<Type *> &FreeList();
+};
+
+
+
+template <class Type>
+Type *PoolAllocator<Type>::allocate(std::size_t n)
+{
+	if(n == 1)
+	{
+		std::lock_guard<std::mutex> lock(Mutex());
+		std::vector<Type *> &freeList = FreeList();
+		if(!freeList.empty())
+		{
+			Type *p = freeList.back();
+			freeList.pop_back();
+			return p;
+		}
+	}
+	return static_cast<Type *>(::operator new(n * sizeof(Type)));
+}
+
+
+
+template <class Type>
+void PoolAllocator<Type>::deallocate(Type *p, std::size_t n) noexcept
+{
+	if(n == 1)
+	{
+		std::lock_guard<std::mutex> lock(Mutex());
+		try {
+			FreeList().push_back(p);
+			return;
+		}
+		catch(const std::bad_alloc &)
+		{
+			// If the free list cannot grow, just release this block.
+		}
+	}
+	::operator delete(p);
+}
+
+
+
+// The mutex and free list are never destroyed, in case any pooled objects
+// outlive them during program exit.
+template <class Type>
+std::mutex &PoolAllocator<Type>::Mutex()
+{
+	static std::mutex *mutex = new std::mutex;
+	return *mutex;
+}
+
+
+
+template <class Type>
+std::vector<Type *> &PoolAllocator<Type>::FreeList()
+{
+	static std::vector<Type *> *freeList = new std::vector<Type *>;
+	return *freeList;
+}
+
+
+
+#endif
@@ -26,7 +26,15 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
-	map<string, bool> settings;
+	// The on / off settings. Each value stays at the same address once it has
+	// been added, so a Setting handle can keep a pointer to it. The map is only
+	// created when it is first used, so that handles can be static variables.
+	map<string, atomic<bool>> &Settings()
+	{
+		static map<string, atomic<bool>> settings;
+		return settings;
+	}
+	
 	int scrollSpeed = 60;
 	
 	// Strings for ammo expenditure:
@@ -40,12 +48,17 @@ namespace {
 	// Enable standard VSync by default.
 	const vector<string> VSYNC_SETTINGS = {"off", "on", "adaptive"};
 	int vsyncIndex = 1;
+	
+	// Sprite memory limits, in megabytes.
+	const vector<int> TEXTURE_MEMORY = {0, 512, 1024, 2048, 4096};
+	int textureMemoryIndex = 0;
 }
 
 
 
 void Preferences::Load()
 {
+	map<string, atomic<bool>> &settings = Settings();
 	// These settings should be on by default. There is no need to specify
 	// values for settings that are off by default.
 	settings["Automatic aiming"] = true;
@@ -79,6 +92,8 @@ void Preferences::Load()
 			zoomIndex = max<int>(0, min<int>(node.Value(1), ZOOMS.size() - 1));
 		else if(node.Token(0) == "vsync")
 			vsyncIndex = max<int>(0, min<int>(node.Value(1), VSYNC_SETTINGS.size() - 1));
+		else if(node.Token(0) == "texture memory")
+			textureMemoryIndex = max<int>(0, min<int>(node.Value(1), TEXTURE_MEMORY.size() - 1));
 		else
 			settings[node.Token(0)] = (node.Size() == 1 || node.Value(1));
 	}
@@ -96,15 +111,17 @@ void Preferences::Save()
 	out.Write("scroll speed", scrollSpeed);
 	out.Write("view zoom", zoomIndex);
 	out.Write("vsync", vsyncIndex);
+	out.Write("texture memory", textureMemoryIndex);
 	
-	for(const auto &it : settings)
-		out.Write(it.first, it.second);
+	for(const auto &it : Settings())
+		out.Write(it.first, it.second.load());
 }
 
 
 
 bool Preferences::Has(const string &name)
 {
+	const map<string, atomic<bool>> &settings = Settings();
 	auto it = settings.find(name);
 	return (it != settings.end() && it->second);
 }
@@ -113,7 +130,23 @@ bool Preferences::Has(const string &name)
 
 void Preferences::Set(const string &name, bool on)
 {
-	settings[name] = on;
+	Settings()[name] = on;
+}
+
+
+
+// Find the value of the given setting, adding it (turned off) if it has not
+// been set yet.
+Preferences::Setting::Setting(const string &name)
+	: value(&Settings()[name])
+{
+}
+
+
+
+bool Preferences::Setting::Has() const
+{
+	return value->load(memory_order_relaxed);
 }
 
 
@@ -150,6 +183,21 @@ void Preferences::SetScrollSpeed(int speed)
 
 
 
+// Sprite memory limit.
+int Preferences::TextureMemory()
+{
+	return TEXTURE_MEMORY[textureMemoryIndex];
+}
+
+
+
+void Preferences::ToggleTextureMemory()
+{
+	textureMemoryIndex = (textureMemoryIndex + 1) % TEXTURE_MEMORY.size();
+}
+
+
+
 // View zoom.
 double Preferences::ViewZoom()
 {
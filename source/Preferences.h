@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef PREFERENCES_H_
 #define PREFERENCES_H_
 
+#include <atomic>
 #include <string>
 
 
@@ -25,6 +26,20 @@ public:
 		adaptive,
 	};
 	
+	// A handle for one of the on / off settings, which can be checked without
+	// looking it up by name. These are meant to be created once, as static
+	// variables next to the code that checks them. Checking one is safe in any
+	// thread, and always gives the value it was most recently Set() to.
+	class Setting {
+	public:
+		explicit Setting(const std::string &name);
+		
+		bool Has() const;
+		
+	private:
+		const std::atomic<bool> *value;
+	};
+	
 	
 public:
 	static void Load();
@@ -42,6 +57,11 @@ public:
 	static int ScrollSpeed();
 	static void SetScrollSpeed(int speed);
 	
+	// The most video memory, in megabytes, that sprites should use before the
+	// ones that have not been drawn recently are unloaded. Zero means no limit.
+	static int TextureMemory();
+	static void ToggleTextureMemory();
+	
 	// View zoom.
 	static double ViewZoom();
 	static bool ZoomViewIn();
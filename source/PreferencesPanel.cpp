@@ -57,6 +57,7 @@ namespace {
 	const string SCROLL_SPEED = "Scroll speed";
 	const string FIGHTER_REPAIR = "Repair fighters in";
 	const string SHIP_OUTLINES = "Ship outlines in shops";
+	const string TEXTURE_MEMORY = "Texture memory limit";
 }
 
 
@@ -187,6 +188,8 @@ bool PreferencesPanel::Click(int x, int y, int clicks)
 				for(const auto &it : GameData::HelpTemplates())
 					Preferences::Set("help: " + it.first, false);
 			}
+			else if(zone.Value() == TEXTURE_MEMORY)
+				Preferences::ToggleTextureMemory();
 			else if(zone.Value() == SCROLL_SPEED)
 			{
 				// Toggle between three different speeds.
@@ -449,7 +452,13 @@ void PreferencesPanel::DrawSettings()
 		"Performance",
 		"Show CPU / GPU load",
 		"Render motion blur",
+		"Interpolate frames",
+		"Dynamic resolution",
+		"Low latency input",
+		"Journaled saves",
 		"Reduce large graphics",
+		"Compress textures",
+		TEXTURE_MEMORY,
 		"Draw background haze",
 		"Draw starfield",
 		"Show hyperspace flash",
@@ -564,6 +573,11 @@ void PreferencesPanel::DrawSettings()
 			isOn = true;
 			text = to_string(Preferences::ScrollSpeed());
 		}
+		else if(setting == TEXTURE_MEMORY)
+		{
+			isOn = Preferences::TextureMemory();
+			text = isOn ? to_string(Preferences::TextureMemory()) + " MB" : "off";
+		}
 		else
 			text = isOn ? "on" : "off";
 		
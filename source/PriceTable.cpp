@@ -0,0 +1,85 @@
+/* PriceTable.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "PriceTable.h"
+
+#include "GameData.h"
+#include "System.h"
+#include "Trade.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	uint64_t tableRevision = 0;
+	unordered_map<const System *, size_t> rows;
+	unordered_map<string, int> columns;
+	size_t width = 0;
+	vector<int> prices;
+	
+	// Make sure the table has a row for every system in the current universe.
+	void Check()
+	{
+		if(tableRevision != GameData::Revision())
+			PriceTable::Update();
+	}
+}
+
+
+
+// Copy the current prices into the table.
+void PriceTable::Update()
+{
+	tableRevision = GameData::Revision();
+	
+	const vector<Trade::Commodity> &commodities = GameData::Commodities();
+	width = commodities.size();
+	columns.clear();
+	for(size_t i = 0; i < width; ++i)
+		columns.emplace(commodities[i].name, i);
+	
+	rows.clear();
+	prices.clear();
+	prices.reserve(GameData::Systems().size() * width);
+	for(const auto &it : GameData::Systems())
+	{
+		rows.emplace(&it.second, rows.size());
+		for(const Trade::Commodity &commodity : commodities)
+			prices.push_back(it.second.Trade(commodity.name));
+	}
+}
+
+
+
+// Get the price of the commodity with the given index in the list of
+// commodities, or zero if it is not traded in the given system.
+int PriceTable::Price(const System &system, int commodity)
+{
+	Check();
+	auto it = rows.find(&system);
+	if(it == rows.end() || commodity < 0 || static_cast<size_t>(commodity) >= width)
+		return 0;
+	
+	return prices[it->second * width + commodity];
+}
+
+
+
+int PriceTable::Price(const System &system, const string &commodity)
+{
+	Check();
+	auto it = columns.find(commodity);
+	return (it == columns.end()) ? 0 : Price(system, it->second);
+}
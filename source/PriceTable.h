@@ -0,0 +1,42 @@
+/* PriceTable.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PRICE_TABLE_H_
+#define PRICE_TABLE_H_
+
+#include <string>
+
+class System;
+
+
+
+// A table of the price of every commodity in every system, as of the start of
+// the current day. Prices only change when the economy is stepped forward, but
+// the trading panel and the maps look them up for many systems every frame, so
+// this copies them into one array, with a row for each system and a column for
+// each commodity, instead of each lookup going through the system's map of
+// commodity names. The table is updated after each day's economy step, and is
+// rebuilt whenever the universe changes.
+class PriceTable {
+public:
+	// Copy the current prices into the table.
+	static void Update();
+	
+	// Get the price of the commodity with the given index in the list of
+	// commodities, or zero if it is not traded in the given system.
+	static int Price(const System &system, int commodity);
+	static int Price(const System &system, const std::string &commodity);
+};
+
+
+
+#endif
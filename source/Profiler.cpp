@@ -0,0 +1,273 @@
+/* Profiler.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Profiler.h"
+
+#include "Files.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+	// A single timing measurement.
+	class Event {
+	public:
+		const char *name = nullptr;
+		steady_clock::time_point start;
+		steady_clock::duration duration;
+		unsigned thread = 0;
+	};
+	
+	// Keep enough events for several seconds of every phase being recorded.
+	const size_t CAPACITY = 1 << 14;
+	
+	atomic<bool> isEnabled(false);
+	mutex eventMutex;
+	vector<Event> events;
+	// The index where the next event will be stored.
+	size_t nextEvent = 0;
+	// The total and worst time each phase has taken since the last reset.
+	class Summary {
+	public:
+		steady_clock::duration total = steady_clock::duration::zero();
+		steady_clock::duration worst = steady_clock::duration::zero();
+		int count = 0;
+	};
+	map<string, Summary> summaries;
+	// The most recent value of each counter.
+	map<string, int> counters;
+	// Give each thread a small number, so the trace viewer can show them apart.
+	map<thread::id, unsigned> threadNumbers;
+	// All event times in the trace are relative to this.
+	const steady_clock::time_point epoch = steady_clock::now();
+	
+	// Escape a name for use in a JSON string.
+	string Escape(const char *name)
+	{
+		string result;
+		for(const char *it = name; *it; ++it)
+		{
+			if(*it == '"' || *it == '\\')
+				result += '\\';
+			result += *it;
+		}
+		return result;
+	}
+	
+	// Convert a duration to milliseconds, formatted for JSON.
+	string Milliseconds(steady_clock::duration time)
+	{
+		return to_string(duration<double, milli>(time).count());
+	}
+}
+
+
+
+// Start timing a phase of the game loop.
+Profiler::Scope::Scope(const char *name)
+	: name(name)
+{
+	if(isEnabled)
+		start = steady_clock::now();
+}
+
+
+
+// Record how long this phase took.
+Profiler::Scope::~Scope()
+{
+	if(isEnabled && start != steady_clock::time_point())
+		Record(name, start, steady_clock::now());
+}
+
+
+
+// Turn recording on or off.
+void Profiler::SetEnabled(bool enabled)
+{
+	isEnabled = enabled;
+}
+
+
+
+bool Profiler::IsEnabled()
+{
+	return isEnabled;
+}
+
+
+
+// Get the average time, in milliseconds, that each named phase took over
+// the last second, sorted by name.
+vector<pair<string, double>> Profiler::Averages()
+{
+	map<string, pair<steady_clock::duration, int>> totals;
+	{
+		lock_guard<mutex> lock(eventMutex);
+		steady_clock::time_point cutoff = steady_clock::now() - seconds(1);
+		for(const Event &event : events)
+			if(event.start >= cutoff)
+			{
+				pair<steady_clock::duration, int> &total = totals[event.name];
+				total.first += event.duration;
+				++total.second;
+			}
+	}
+	
+	vector<pair<string, double>> result;
+	for(const auto &it : totals)
+		result.emplace_back(it.first,
+			duration<double, milli>(it.second.first).count() / it.second.second);
+	return result;
+}
+
+
+
+// Write all the recorded timings to the given file as a Chrome trace. Each
+// event is a "complete" event, with its start time and duration given in
+// microseconds.
+void Profiler::WriteTrace(const string &path)
+{
+	string out = "{\"traceEvents\":[\n";
+	{
+		lock_guard<mutex> lock(eventMutex);
+		// Write the events from oldest to newest.
+		bool isFirst = true;
+		for(size_t i = 0; i < events.size(); ++i)
+		{
+			const Event &event = events[(nextEvent + i) % events.size()];
+			if(!isFirst)
+				out += ",\n";
+			isFirst = false;
+			
+			out += "{\"name\":\"" + Escape(event.name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+				+ to_string(event.thread)
+				+ ",\"ts\":" + to_string(duration_cast<microseconds>(event.start - epoch).count())
+				+ ",\"dur\":" + to_string(duration_cast<microseconds>(event.duration).count()) + "}";
+		}
+	}
+	out += "\n]}\n";
+	Files::Write(path, out);
+}
+
+
+
+// Write the number of times each phase ran and its mean and worst times
+// since recording was last reset, plus the counters, as a JSON object.
+void Profiler::WriteSummary(const string &path, const string &title)
+{
+	string out = "{\"title\":\"" + Escape(title.c_str()) + "\",\n\"phases\":{";
+	{
+		lock_guard<mutex> lock(eventMutex);
+		bool isFirst = true;
+		for(const auto &it : summaries)
+		{
+			out += (isFirst ? "\n" : ",\n");
+			isFirst = false;
+			
+			const Summary &summary = it.second;
+			out += "\"" + Escape(it.first.c_str()) + "\":{\"count\":" + to_string(summary.count)
+				+ ",\"total ms\":" + Milliseconds(summary.total)
+				+ ",\"mean ms\":" + Milliseconds(summary.total / max(1, summary.count))
+				+ ",\"worst ms\":" + Milliseconds(summary.worst) + "}";
+		}
+		out += "},\n\"counters\":{";
+		isFirst = true;
+		for(const auto &it : counters)
+		{
+			out += (isFirst ? "\n" : ",\n");
+			isFirst = false;
+			out += "\"" + Escape(it.first.c_str()) + "\":" + to_string(it.second);
+		}
+	}
+	out += "}}\n";
+	Files::Write(path, out);
+}
+
+
+
+// Discard everything that has been recorded so far.
+void Profiler::Reset()
+{
+	lock_guard<mutex> lock(eventMutex);
+	events.clear();
+	nextEvent = 0;
+	summaries.clear();
+	counters.clear();
+}
+
+
+
+// Report the current value of a named quantity.
+void Profiler::SetCounter(const char *name, int value)
+{
+	if(!isEnabled)
+		return;
+	
+	lock_guard<mutex> lock(eventMutex);
+	counters[name] = value;
+}
+
+
+
+// Get the most recent value of each counter, sorted by name.
+vector<pair<string, int>> Profiler::Counters()
+{
+	lock_guard<mutex> lock(eventMutex);
+	return vector<pair<string, int>>(counters.begin(), counters.end());
+}
+
+
+
+// Record a phase that was timed by the GPU.
+void Profiler::RecordGpu(const char *name, nanoseconds duration)
+{
+	if(!isEnabled)
+		return;
+	
+	steady_clock::time_point end = steady_clock::now();
+	Record(name, end - duration_cast<steady_clock::duration>(duration), end, true);
+}
+
+
+
+// Store one timing measurement in the ring buffer.
+void Profiler::Record(const char *name, steady_clock::time_point start, steady_clock::time_point end, bool onGpu)
+{
+	lock_guard<mutex> lock(eventMutex);
+	
+	Event event;
+	event.name = name;
+	event.start = start;
+	event.duration = end - start;
+	// GPU timings are filed under a default-constructed ID, which no running
+	// thread ever has.
+	auto it = threadNumbers.emplace(onGpu ? thread::id() : this_thread::get_id(), threadNumbers.size()).first;
+	event.thread = it->second;
+	
+	Summary &summary = summaries[name];
+	summary.total += event.duration;
+	summary.worst = max(summary.worst, event.duration);
+	++summary.count;
+	
+	if(events.size() < CAPACITY)
+		events.push_back(event);
+	else
+		events[nextEvent] = event;
+	nextEvent = (nextEvent + 1) % CAPACITY;
+}
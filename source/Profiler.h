@@ -0,0 +1,82 @@
+/* Profiler.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+// Class for measuring how long each phase of the game loop takes. Each phase
+// is timed by creating a Profiler::Scope at the start of it. The most recent
+// timings are kept in a fixed-size ring buffer, which can be summarized for an
+// on-screen display or written out in the trace format that Chrome's
+// "about:tracing" viewer understands. Other statistics, such as how many sounds
+// are playing, can be reported as named counters. Nothing is recorded unless
+// profiling has been turned on (e.g. by running in debug mode).
+class Profiler {
+public:
+	// Time the code from where this object is created until it goes out of
+	// scope. The name must be a string literal (or otherwise never freed).
+	class Scope {
+	public:
+		explicit Scope(const char *name);
+		~Scope();
+		
+		Scope(const Scope &other) = delete;
+		Scope &operator=(const Scope &other) = delete;
+		
+	private:
+		const char *name;
+		std::chrono::steady_clock::time_point start;
+	};
+	
+	
+public:
+	// Turn recording on or off.
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+	
+	// Get the average time, in milliseconds, that each named phase took over
+	// the last second, sorted by name.
+	static std::vector<std::pair<std::string, double>> Averages();
+	// Write all the recorded timings to the given file as a Chrome trace.
+	static void WriteTrace(const std::string &path);
+	// Write the number of times each phase ran and its mean and worst times
+	// since recording was last reset, plus the counters, as a JSON object.
+	static void WriteSummary(const std::string &path, const std::string &title);
+	// Discard everything that has been recorded so far.
+	static void Reset();
+	
+	// Report the current value of a named quantity, such as how many of some
+	// resource are in use. The name must be a string literal.
+	static void SetCounter(const char *name, int value);
+	// Get the most recent value of each counter, sorted by name.
+	static std::vector<std::pair<std::string, int>> Counters();
+	
+	// Record a phase that was timed by the GPU rather than by this clock. It
+	// is taken to have ended just now, and is shown apart from the CPU threads.
+	static void RecordGpu(const char *name, std::chrono::nanoseconds duration);
+	
+	
+private:
+	static void Record(const char *name, std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end, bool onGpu = false);
+};
+
+
+
+#endif
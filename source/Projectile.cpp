@@ -98,9 +98,49 @@ Projectile::Projectile(Point position, const Weapon *weapon)
 
 
 
+// Check whether this projectile's target is still valid and, if it is locked
+// on, work out its course for this step. This only reads the target ship and
+// modifies this projectile, so it is safe to call for all the projectiles at
+// once, before any of them move. Move() still makes all the random decisions.
+void Projectile::Guide()
+{
+	isGuided = false;
+	// A projectile that is about to die does not need to be steered, and its
+	// submunitions should inherit its target as it is now.
+	if(lifetime <= 1)
+		return;
+	
+	const Ship *target = CheckTarget();
+	// A projectile that flies straight has nothing random or order-dependent
+	// to do until it dies, so it can finish this whole step right here.
+	if(weapon->MovesStraight())
+	{
+		--lifetime;
+		position += velocity;
+		distanceTraveled += velocity.Length();
+		isMoved = true;
+		return;
+	}
+	isGuided = true;
+	guidedLock = target && weapon->Homing() && hasLock;
+	if(!guidedLock)
+		return;
+	
+	guidedTurn = weapon->Turn();
+	guidedAccel = weapon->Acceleration();
+	guidedKeepsTarget = Steer(*target, guidedTurn, guidedAccel);
+}
+
+
+
 // This returns false if it is time to delete this projectile.
 void Projectile::Move(vector<Visual> &visuals, vector<Projectile> &projectiles)
 {
+	if(isMoved)
+	{
+		isMoved = false;
+		return;
+	}
 	if(--lifetime <= 0)
 	{
 		if(lifetime > -100)
@@ -123,18 +163,9 @@ void Projectile::Move(vector<Visual> &visuals, vector<Projectile> &projectiles)
 			visuals.emplace_back(*it.first, position, velocity, angle);
 	
 	// If the target has left the system, stop following it. Also stop if the
-	// target has been captured by a different government.
-	const Ship *target = cachedTarget;
-	if(target)
-	{
-		target = TargetPtr().get();
-		if(!target || !target->IsTargetable() || target->GetGovernment() != targetGovernment)
-		{
-			targetShip.reset();
-			cachedTarget = nullptr;
-			target = nullptr;
-		}
-	}
+	// target has been captured by a different government. Guide() may already
+	// have checked this during this step.
+	const Ship *target = isGuided ? cachedTarget : CheckTarget();
 	
 	double turn = weapon->Turn();
 	double accel = weapon->Acceleration();
@@ -143,60 +174,19 @@ void Projectile::Move(vector<Visual> &visuals, vector<Projectile> &projectiles)
 		CheckLock(*target);
 	if(target && homing && hasLock)
 	{
-		// Vector d is the direction we want to turn towards.
-		Point d = target->Position() - position;
-		Point unit = d.Unit();
-		double drag = weapon->Drag();
-		double trueVelocity = drag ? accel / drag : velocity.Length();
-		double stepsToReach = d.Length() / trueVelocity;
-		bool isFacingAway = d.Dot(angle.Unit()) < 0.;
-		// At the highest homing level, compensate for target motion.
-		if(homing >= 4)
+		// Use the course that Guide() worked out, unless this projectile was not
+		// locked on when it was called.
+		bool keepsTarget = true;
+		if(isGuided && guidedLock)
 		{
-			if(unit.Dot(target->Velocity()) < 0.)
-			{
-				// If the target is moving toward this projectile, the intercept
-				// course is where the target and the projectile have the same
-				// velocity normal to the distance between them.
-				Point normal(unit.Y(), -unit.X());
-				double vN = normal.Dot(target->Velocity());
-				double vT = sqrt(max(0., trueVelocity * trueVelocity - vN * vN));
-				d = vT * unit + vN * normal;
-			}
-			else
-			{
-				// Adjust the target's position based on where it will be when we
-				// reach it (assuming we're pointed right towards it).
-				d += stepsToReach * target->Velocity();
-				stepsToReach = d.Length() / trueVelocity;
-			}
-			unit = d.Unit();
+			turn = guidedTurn;
+			accel = guidedAccel;
+			keepsTarget = guidedKeepsTarget;
 		}
-		
-		double cross = angle.Unit().Cross(unit);
-		
-		// The very dumbest of homing missiles lose their target if pointed
-		// away from it.
-		if(isFacingAway && homing == 1)
-			targetShip.reset();
 		else
-		{
-			double desiredTurn = TO_DEG * asin(cross);
-			if(fabs(desiredTurn) > turn)
-				turn = copysign(turn, desiredTurn);
-			else
-				turn = desiredTurn;
-			
-			// Levels 3 and 4 stop accelerating when facing away.
-			if(homing >= 3)
-			{
-				double stepsToFace = desiredTurn / turn;
-		
-				// If you are facing away from the target, stop accelerating.
-				if(stepsToFace * 1.5 > stepsToReach)
-					accel = 0.;
-			}
-		}
+			keepsTarget = Steer(*target, turn, accel);
+		if(!keepsTarget)
+			targetShip.reset();
 	}
 	// Homing weapons that have lost their lock have a chance to get confused
 	// and turn in a random direction ("go haywire"). Each tracking method has
@@ -237,6 +227,8 @@ void Projectile::Move(vector<Visual> &visuals, vector<Projectile> &projectiles)
 	else if(homing)
 		turn = 0.;
 	
+	isGuided = false;
+	
 	if(turn)
 		angle += Angle(turn);
 	
@@ -320,6 +312,90 @@ shared_ptr<Ship> Projectile::TargetPtr() const
 }
 
 
+// If the target has left the system or been captured by a different
+// government, stop following it. Return the target, if it is still valid.
+const Ship *Projectile::CheckTarget()
+{
+	if(!cachedTarget)
+		return nullptr;
+	
+	const Ship *target = TargetPtr().get();
+	if(!target || !target->IsTargetable() || target->GetGovernment() != targetGovernment)
+	{
+		targetShip.reset();
+		cachedTarget = nullptr;
+		target = nullptr;
+	}
+	return target;
+}
+
+
+
+// Work out how far this projectile should turn and how hard it should
+// accelerate to home in on the given target. This only reads the target, so it
+// may be called for many projectiles at once. Return false if the projectile
+// should instead lose track of its target.
+bool Projectile::Steer(const Ship &target, double &turn, double &accel) const
+{
+	int homing = weapon->Homing();
+	
+	// Vector d is the direction we want to turn towards.
+	Point d = target.Position() - position;
+	Point unit = d.Unit();
+	double drag = weapon->Drag();
+	double trueVelocity = drag ? accel / drag : velocity.Length();
+	double stepsToReach = d.Length() / trueVelocity;
+	bool isFacingAway = d.Dot(angle.Unit()) < 0.;
+	// At the highest homing level, compensate for target motion.
+	if(homing >= 4)
+	{
+		if(unit.Dot(target.Velocity()) < 0.)
+		{
+			// If the target is moving toward this projectile, the intercept
+			// course is where the target and the projectile have the same
+			// velocity normal to the distance between them.
+			Point normal(unit.Y(), -unit.X());
+			double vN = normal.Dot(target.Velocity());
+			double vT = sqrt(max(0., trueVelocity * trueVelocity - vN * vN));
+			d = vT * unit + vN * normal;
+		}
+		else
+		{
+			// Adjust the target's position based on where it will be when we
+			// reach it (assuming we're pointed right towards it).
+			d += stepsToReach * target.Velocity();
+			stepsToReach = d.Length() / trueVelocity;
+		}
+		unit = d.Unit();
+	}
+	
+	double cross = angle.Unit().Cross(unit);
+	
+	// The very dumbest of homing missiles lose their target if pointed
+	// away from it.
+	if(isFacingAway && homing == 1)
+		return false;
+	
+	double desiredTurn = TO_DEG * asin(cross);
+	if(fabs(desiredTurn) > turn)
+		turn = copysign(turn, desiredTurn);
+	else
+		turn = desiredTurn;
+	
+	// Levels 3 and 4 stop accelerating when facing away.
+	if(homing >= 3)
+	{
+		double stepsToFace = desiredTurn / turn;
+		
+		// If you are facing away from the target, stop accelerating.
+		if(stepsToFace * 1.5 > stepsToReach)
+			accel = 0.;
+	}
+	return true;
+}
+
+
+
 // TODO: add more conditions in the future. For example maybe proximity to stars
 // and their brightness could could cause IR missiles to lose their locks more
 // often, and dense asteroid fields could do the same for radar and optically
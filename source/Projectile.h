@@ -50,6 +50,10 @@ public:
 	const Government *GetGovernment() const;
 	*/
 	
+	// Check that the target is still valid and work out how to steer toward it.
+	// This may be done for many projectiles in parallel, before moving them.
+	// Projectiles that fly straight are moved here, too, unless they are dying.
+	void Guide();
 	// Move the projectile. It may create effects or submunitions.
 	void Move(std::vector<Visual> &visuals, std::vector<Projectile> &projectiles);
 	// This projectile hit something. Create the explosion, if any. This also
@@ -78,6 +82,8 @@ public:
 	
 	
 private:
+	const Ship *CheckTarget();
+	bool Steer(const Ship &target, double &turn, double &accel) const;
 	void CheckLock(const Ship &target);
 	
 	
@@ -92,6 +98,15 @@ private:
 	int lifetime = 0;
 	double distanceTraveled = 0;
 	bool hasLock = true;
+	
+	// The course worked out by Guide(), if it has been called this step.
+	bool isGuided = false;
+	bool guidedLock = false;
+	bool guidedKeepsTarget = true;
+	double guidedTurn = 0.;
+	double guidedAccel = 0.;
+	// Whether Guide() has already moved this projectile for this step.
+	bool isMoved = false;
 };
 
 
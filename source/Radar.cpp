@@ -108,7 +108,6 @@ void Radar::Draw(const Point &center, double scale, double radius, double pointe
 	}
 	
 	// Draw StellarObjects and ships.
-	RingShader::Bind();
 	for(const Object &object : objects)
 	{
 		Point position = object.position * scale;
@@ -117,15 +116,12 @@ void Radar::Draw(const Point &center, double scale, double radius, double pointe
 			position *= radius / length;
 		position += center;
 		
-		RingShader::Add(position, object.outer, object.inner, object.color);
+		RingShader::Draw(position, object.outer, object.inner, object.color);
 	}
-	RingShader::Unbind();
 	
 	// Draw neighboring system indicators.
-	PointerShader::Bind();
 	for(const Pointer &pointer : pointers)
-		PointerShader::Add(center, pointer.unit, 10.f, 10.f, pointerRadius, pointer.color);
-	PointerShader::Unbind();
+		PointerShader::Draw(center, pointer.unit, 10.f, 10.f, pointerRadius, pointer.color);
 }
 
 
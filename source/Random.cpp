@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Random.h"
 
+#include <atomic>
 #include <random>
 
 #ifndef __linux__
@@ -22,28 +23,76 @@ using namespace std;
 
 // Right now thread_local storage is only supported under Linux.
 namespace {
+	// The seed from which all streams are derived. Streams only read it when
+	// they are created, so it is safe to seed from any thread.
+	atomic<uint64_t> streamSeed(0);
+	
+	// The SplitMix64 finalizer, which scrambles the bits of a 64-bit integer
+	// so that consecutive inputs give unrelated outputs.
+	uint64_t Mix(uint64_t x)
+	{
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+	
 #ifndef __linux__
 	mutex workaroundMutex;
 	mt19937_64 gen;
 	uniform_int_distribution<uint32_t> uniform;
 	uniform_real_distribution<double> real;
+	
+	mt19937_64 &Generator()
+	{
+		return gen;
+	}
 #else
 	thread_local mt19937_64 gen;
 	thread_local uniform_int_distribution<uint32_t> uniform;
 	thread_local uniform_real_distribution<double> real;
+	
+	// Seeding applies to every thread, not just the one that called Seed(),
+	// so each thread's generator is reseeded the next time it is used. Each
+	// thread mixes a different index into the seed, so that no two threads
+	// draw the same numbers. The thread that called Seed() always gets the
+	// first index; the others are numbered in whatever order they next draw a
+	// number, so any work that is split between threads and must be repeatable
+	// should use a Stream instead.
+	atomic<uint64_t> threadSeed(mt19937_64::default_seed);
+	atomic<uint64_t> nextThreadIndex(0);
+	atomic<unsigned> seedCount(1);
+	thread_local unsigned threadSeedCount = 0;
+	
+	mt19937_64 &Generator()
+	{
+		unsigned count = seedCount.load(memory_order_acquire);
+		if(count != threadSeedCount)
+		{
+			threadSeedCount = count;
+			gen.seed(Mix(threadSeed.load(memory_order_relaxed) ^ nextThreadIndex++));
+		}
+		return gen;
+	}
 #endif
 }
 
 
 
 // Seed the generator (e.g. to make it produce exactly the same random
-// numbers it produced previously).
+// numbers it produced previously). This applies to all threads, but each
+// thread gets a different sequence of numbers from it.
 void Random::Seed(uint64_t seed)
 {
 #ifndef __linux__
 	lock_guard<mutex> lock(workaroundMutex);
-#endif
 	gen.seed(seed);
+#else
+	threadSeed.store(seed, memory_order_relaxed);
+	nextThreadIndex = 1;
+	threadSeedCount = seedCount.fetch_add(1, memory_order_release) + 1;
+	gen.seed(Mix(seed));
+#endif
+	streamSeed = seed;
 }
 
 
@@ -53,7 +102,7 @@ uint32_t Random::Int()
 #ifndef __linux__
 	lock_guard<mutex> lock(workaroundMutex);
 #endif
-	return uniform(gen);
+	return uniform(Generator());
 }
 
 
@@ -63,7 +112,7 @@ uint32_t Random::Int(uint32_t modulus)
 #ifndef __linux__
 	lock_guard<mutex> lock(workaroundMutex);
 #endif
-	return uniform(gen) % modulus;
+	return uniform(Generator()) % modulus;
 }
 
 
@@ -73,7 +122,7 @@ double Random::Real()
 #ifndef __linux__
 	lock_guard<mutex> lock(workaroundMutex);
 #endif
-	return real(gen);
+	return real(Generator());
 }
 
 
@@ -86,7 +135,20 @@ uint32_t Random::Polya(uint32_t k, double p)
 #ifndef __linux__
 	lock_guard<mutex> lock(workaroundMutex);
 #endif
-	return polya(gen);
+	return polya(Generator());
+}
+
+
+
+// Return the number of failures before the first success, when the
+// probability of success is p.
+uint32_t Random::Geometric(double p)
+{
+	geometric_distribution<uint32_t> geometric(p);
+#ifndef __linux__
+	lock_guard<mutex> lock(workaroundMutex);
+#endif
+	return geometric(Generator());
 }
 
 
@@ -98,7 +160,7 @@ uint32_t Random::Binomial(uint32_t t, double p)
 #ifndef __linux__
 	lock_guard<mutex> lock(workaroundMutex);
 #endif
-	return binomial(gen);
+	return binomial(Generator());
 }
 
 
@@ -110,5 +172,60 @@ double Random::Normal()
 #ifndef __linux__
 	lock_guard<mutex> lock(workaroundMutex);
 #endif
-	return normal(gen);
+	return normal(Generator());
+}
+
+
+
+// Create the stream with the given key. Two streams created with the
+// same key after the same call to Seed() produce the same numbers.
+Random::Stream::Stream(uint64_t key)
+	: key(Mix(streamSeed ^ Mix(key)))
+{
+}
+
+
+
+uint32_t Random::Stream::Int()
+{
+	return Next() >> 32;
+}
+
+
+
+uint32_t Random::Stream::Int(uint32_t modulus)
+{
+	return Int() % modulus;
+}
+
+
+
+double Random::Stream::Real()
+{
+	// Use the top 53 bits, which is all that a double can hold.
+	return (Next() >> 11) * (1. / (UINT64_C(1) << 53));
+}
+
+
+
+// Skip directly to the given position in the stream.
+void Random::Stream::SetCounter(uint64_t counter)
+{
+	this->counter = counter;
+}
+
+
+
+uint64_t Random::Stream::Counter() const
+{
+	return counter;
+}
+
+
+
+// Each number is a hash of the stream's key and its position in the stream,
+// so there is no hidden state that depends on what was drawn before.
+uint64_t Random::Stream::Next()
+{
+	return Mix(key + 0x9E3779B97F4A7C15ULL * ++counter);
 }
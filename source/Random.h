@@ -21,9 +21,40 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 // different distributions. (This is done partly because on some systems the
 // random number generation is not thread-safe.)
 class Random {
+public:
+	// A stream of random numbers that belongs to one particular object or
+	// job. The Nth number drawn from a stream depends only on the seed, the
+	// stream's key, and N, so code running on many threads at once can use
+	// separate streams and still get the same results no matter how the
+	// threads are scheduled. Streams do not need any locking.
+	class Stream {
+	public:
+		Stream() = default;
+		// Create the stream with the given key. Two streams created with the
+		// same key after the same call to Seed() produce the same numbers.
+		explicit Stream(uint64_t key);
+		
+		uint32_t Int();
+		uint32_t Int(uint32_t modulus);
+		double Real();
+		
+		// Skip directly to the given position in the stream.
+		void SetCounter(uint64_t counter);
+		uint64_t Counter() const;
+		
+	private:
+		uint64_t Next();
+		
+	private:
+		uint64_t key = 0;
+		uint64_t counter = 0;
+	};
+	
+	
 public:
 	// Seed the generator (e.g. to make it produce exactly the same random
-	// numbers it produced previously).
+	// numbers it produced previously). This applies to all threads, but each
+	// thread gets a different sequence of numbers from it.
 	static void Seed(uint64_t seed);
 	
 	static uint32_t Int();
@@ -37,6 +68,10 @@ public:
 	// Return the expected number of failures before k successes, when the
 	// probability of success is p. The mean value will be k / (1 - p).
 	static uint32_t Polya(uint32_t k, double p = .5);
+	// Return the number of failures before the first success, when the
+	// probability of success is p. This is how many times in a row something
+	// that happens with that probability will not happen.
+	static uint32_t Geometric(double p);
 	// Get a number from a binomial distribution (i.e. integer bell curve).
 	static uint32_t Binomial(uint32_t t, double p = .5);
 	// Get a normally distributed number (mean = 0, sigma= 1).
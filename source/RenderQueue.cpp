@@ -0,0 +1,44 @@
+/* RenderQueue.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "RenderQueue.h"
+
+namespace {
+	// The function that draws the run that is currently being collected.
+	void (*pending)() = nullptr;
+}
+
+
+
+// Begin or continue a run of primitives that will be drawn by the given
+// function. If a different shader's run is pending, it is drawn first.
+void RenderQueue::Add(void (*flush)())
+{
+	if(pending != flush)
+		Flush();
+	pending = flush;
+}
+
+
+
+// Draw the pending run, if there is one.
+void RenderQueue::Flush()
+{
+	if(!pending)
+		return;
+	
+	// Clear the pending function before calling it, in case it draws anything
+	// that would otherwise try to flush the queue again.
+	void (*flush)() = pending;
+	pending = nullptr;
+	flush();
+}
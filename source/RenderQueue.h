@@ -0,0 +1,35 @@
+/* RenderQueue.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+
+
+// Class that keeps track of which shader, if any, has primitives that have been
+// added but not drawn yet. The interface draws many rectangles and lines one
+// after another, so those shaders collect them into a single run and only
+// draw it once something else needs to be drawn. To preserve the painter's
+// order, anything that draws without going through this queue must flush it
+// first, and so must anything that clears or presents the frame.
+class RenderQueue {
+public:
+	// Begin or continue a run of primitives that will be drawn by the given
+	// function. If a different shader's run is pending, it is drawn first.
+	static void Add(void (*flush)());
+	// Draw the pending run, if there is one.
+	static void Flush();
+};
+
+
+
+#endif
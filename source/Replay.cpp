@@ -0,0 +1,234 @@
+/* Replay.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Replay.h"
+
+#include "BinaryData.h"
+#include "DataWriter.h"
+#include "Files.h"
+#include "PlayerInfo.h"
+#include "Random.h"
+#include "Ship.h"
+
+#include <chrono>
+
+using namespace std;
+
+namespace {
+	// A recording begins with this, so that any other file (or a recording
+	// made by a version of the game that stored it differently) is rejected.
+	const uint32_t VERSION = 1;
+	
+	// Bits that say what kind of click, if any, happened in a recorded step.
+	const uint32_t CLICK = 1;
+	const uint32_t RIGHT_CLICK = 2;
+	const uint32_t RADAR_CLICK = 4;
+	const uint32_t SHIFT = 8;
+	
+	enum class Mode {NONE, STARTING, RECORDING, PLAYING, DONE};
+	Mode mode = Mode::NONE;
+	
+	string recordingPath;
+	uint64_t seed = 0;
+	// The recording, and how much of it has been played back.
+	string data;
+	size_t pos = 0;
+	// How many steps the engine has taken since the recording began.
+	uint32_t step = 0;
+	
+	// The next recorded step that had any inputs, if any are left.
+	bool hasNext = false;
+	uint32_t nextStep = 0;
+	Replay::Input nextInput;
+	
+	
+	
+	// Add the given inputs to the recording, for the current step.
+	void Write(const Replay::Input &input)
+	{
+		BinaryData::Write32(step, data);
+		input.command.Write(data);
+		
+		uint32_t flags = (input.isClick ? CLICK : 0) | (input.isRightClick ? RIGHT_CLICK : 0)
+			| (input.isRadarClick ? RADAR_CLICK : 0) | (input.hasShift ? SHIFT : 0);
+		BinaryData::Write32(flags, data);
+		if(input.isClick)
+		{
+			BinaryData::WriteDouble(input.clickPoint.X(), data);
+			BinaryData::WriteDouble(input.clickPoint.Y(), data);
+			BinaryData::WriteDouble(input.clickBox.Center().X(), data);
+			BinaryData::WriteDouble(input.clickBox.Center().Y(), data);
+			BinaryData::WriteDouble(input.clickBox.Width(), data);
+			BinaryData::WriteDouble(input.clickBox.Height(), data);
+		}
+	}
+	
+	
+	
+	// Read the next recorded step. If the recording ends here, or the rest of
+	// it is incomplete, there is no next step.
+	void ReadNext()
+	{
+		hasNext = false;
+		nextInput = Replay::Input();
+		uint32_t flags = 0;
+		if(!BinaryData::Read32(data, pos, nextStep) || !nextInput.command.Read(data, pos)
+				|| !BinaryData::Read32(data, pos, flags))
+			return;
+		
+		nextInput.isClick = (flags & CLICK);
+		nextInput.isRightClick = (flags & RIGHT_CLICK);
+		nextInput.isRadarClick = (flags & RADAR_CLICK);
+		nextInput.hasShift = (flags & SHIFT);
+		if(nextInput.isClick)
+		{
+			double value[6];
+			for(double &it : value)
+				if(!BinaryData::ReadDouble(data, pos, it))
+					return;
+			nextInput.clickPoint = Point(value[0], value[1]);
+			nextInput.clickBox = Rectangle(Point(value[2], value[3]), Point(value[4], value[5]));
+		}
+		hasNext = true;
+	}
+}
+
+
+
+// Start recording to the given file.
+void Replay::Record(const string &path)
+{
+	recordingPath = path;
+	mode = Mode::STARTING;
+}
+
+
+
+// Load the given recording and its saved game, to be played back.
+bool Replay::Play(const string &path, PlayerInfo &player)
+{
+	data = Files::Read(path);
+	pos = 0;
+	uint32_t version = 0;
+	string save;
+	if(!BinaryData::Read32(data, pos, version) || version != VERSION
+			|| !BinaryData::Read64(data, pos, seed) || !BinaryData::ReadString(data, pos, save))
+		return false;
+	
+	// The player can only be loaded from a file, so write the saved game out
+	// to one temporarily.
+	string savePath = Files::Config() + "replay.txt";
+	Files::Write(savePath, save);
+	player.Load(savePath);
+	Files::Delete(savePath);
+	if(!player.IsLoaded())
+		return false;
+	// The recording was saved after PlayerInfo::TakeOff(), which also keeps the
+	// flagship from being carried by another ship. That is not saved.
+	if(player.Flagship())
+		player.FlagshipPtr()->AllowCarried(false);
+	
+	step = 0;
+	ReadNext();
+	mode = Mode::PLAYING;
+	return true;
+}
+
+
+
+// Stop recording, and write the recording to its file.
+void Replay::Finish()
+{
+	if(mode == Mode::RECORDING)
+	{
+		// Mark the step that the recording ended at, so that playing it back
+		// lasts just as long even if the player gave no inputs at the end.
+		Write(Replay::Input());
+		Files::Write(recordingPath, data);
+	}
+	if(mode != Mode::PLAYING)
+		mode = Mode::NONE;
+	data.clear();
+}
+
+
+
+// Check whether anything is being recorded or played back.
+bool Replay::IsActive()
+{
+	return mode != Mode::NONE && mode != Mode::DONE;
+}
+
+
+
+// Check whether the recording that was being played back has ended.
+bool Replay::IsDone()
+{
+	return mode == Mode::DONE;
+}
+
+
+
+// Begin a recording that was requested, or the playback of one, as the player
+// takes off.
+void Replay::TakeOff(const PlayerInfo &player)
+{
+	// The recording begins with the pilot's saved game as of takeoff, before
+	// anything in the engine has drawn a random number.
+	if(mode == Mode::STARTING)
+	{
+		seed = chrono::system_clock::now().time_since_epoch().count();
+		DataWriter out;
+		player.Save(out);
+		
+		data.clear();
+		BinaryData::Write32(VERSION, data);
+		BinaryData::Write64(seed, data);
+		BinaryData::WriteString(out.GetString(), data);
+		step = 0;
+		mode = Mode::RECORDING;
+	}
+	// Any later takeoff is just part of what is being recorded. A playback
+	// stops when the player lands, so it only ever takes off once.
+	else if(mode != Mode::PLAYING || step)
+		return;
+	
+	Random::Seed(seed);
+}
+
+
+
+// Record the player's inputs for this step, or replace them with the recorded
+// ones.
+void Replay::Step(Input &input)
+{
+	if(mode == Mode::RECORDING)
+	{
+		// Most steps have no inputs at all, so only the ones that do are saved.
+		if(input.command || input.isClick)
+			Write(input);
+	}
+	else if(mode == Mode::PLAYING)
+	{
+		input = Input();
+		if(hasNext && nextStep == step)
+		{
+			input = nextInput;
+			ReadNext();
+		}
+		if(!hasNext)
+			mode = Mode::DONE;
+	}
+	else
+		return;
+	++step;
+}
@@ -0,0 +1,78 @@
+/* Replay.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "Command.h"
+#include "Point.h"
+#include "Rectangle.h"
+
+#include <string>
+
+class PlayerInfo;
+
+
+
+// Class for recording what the player does in flight, so that the same session
+// can be played back later, e.g. to find out why the game slowed down in some
+// particular fight. A recording begins the first time the player takes off
+// after it is requested. It holds the pilot's saved game as it was at takeoff,
+// the random seed, and the commands and clicks that the player gave the engine
+// in each step after that. Playing it back loads that saved game, takes off in
+// the same way, and gives the engine the same inputs in the same steps. Only
+// what happens in flight is recorded, so playback ends when the recording does,
+// or when any other panel (such as a planet or a conversation) would need input.
+class Replay {
+public:
+	// Everything the player does that affects one step of the engine.
+	class Input {
+	public:
+		Command command;
+		bool isClick = false;
+		bool isRightClick = false;
+		bool isRadarClick = false;
+		bool hasShift = false;
+		Point clickPoint;
+		Rectangle clickBox;
+	};
+	
+	
+public:
+	// Start recording to the given file. The recording begins the next time
+	// the player takes off, and is written out when Finish() is called.
+	static void Record(const std::string &path);
+	// Load the given recording and its saved game, to be played back. If the
+	// file is not a recording, this returns false.
+	static bool Play(const std::string &path, PlayerInfo &player);
+	// Stop recording, and write the recording to its file.
+	static void Finish();
+	
+	// Check whether anything is being recorded or played back.
+	static bool IsActive();
+	// Check whether the recording that was being played back has ended.
+	static bool IsDone();
+	
+	// The engine calls this when the player takes off, before it places any
+	// ships. A recording that was requested begins here, with the pilot's saved
+	// game. The random numbers are seeded here both when recording and when
+	// playing back, so that the engine draws the same numbers from then on.
+	static void TakeOff(const PlayerInfo &player);
+	// The engine calls this in every step, with the player's inputs for that
+	// step. If they are being recorded, they are saved. If a recording is being
+	// played back, they are replaced with the recorded inputs.
+	static void Step(Input &input);
+};
+
+
+
+#endif
@@ -13,28 +13,66 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "RingShader.h"
 
 #include "Color.h"
+#include "GpuProfiler.h"
 #include "pi.h"
 #include "Point.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint positionI;
-	GLint radiusI;
-	GLint widthI;
-	GLint angleI;
-	GLint startAngleI;
-	GLint dashI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each vertex has its corner (x, y), and then a copy of the data for the
+	// ring that it is part of: the position (2 floats), the radius, width,
+	// angle, start angle, and dash, and the color (4).
+	constexpr int FLOATS_PER_VERTEX = 13;
+	// Each ring is drawn as two triangles.
+	const float CORNERS[] = {
+		-1.f, -1.f,
+		-1.f,  1.f,
+		 1.f, -1.f,
+		-1.f,  1.f,
+		 1.f, -1.f,
+		 1.f,  1.f
+	};
+	
+	// Rings that are drawn one after another are collected here, so they can
+	// all be drawn with a single draw call.
+	vector<float> vertices;
+	
+	// Draw all the rings that have been added but not drawn yet.
+	void Flush()
+	{
+		if(vertices.empty())
+			return;
+		
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+		GpuProfiler::CountUpload();
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+		GpuProfiler::CountDraw();
+		vertices.clear();
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+	}
 }
 
 
@@ -44,72 +82,85 @@ void RingShader::Init()
 	static const char *vertexCode =
 		"// vertex ring shader\n"
 		"uniform vec2 scale;\n"
-		"uniform vec2 position;\n"
-		"uniform float radius;\n"
-		"uniform float width;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 position;\n"
+		"in float radius;\n"
+		"in float width;\n"
+		"in float angle;\n"
+		"in float startAngle;\n"
+		"in float dash;\n"
+		"in vec4 color;\n"
 		"out vec2 coord;\n"
+		"out float fragRadius;\n"
+		"out float fragWidth;\n"
+		"out float fragAngle;\n"
+		"out float fragStartAngle;\n"
+		"out float fragDash;\n"
+		"out vec4 fragColor;\n"
 		
 		"void main() {\n"
 		"  coord = (radius + width) * vert;\n"
 		"  gl_Position = vec4((coord + position) * scale, 0, 1);\n"
+		"  fragRadius = radius;\n"
+		"  fragWidth = width;\n"
+		"  fragAngle = angle;\n"
+		"  fragStartAngle = startAngle;\n"
+		"  fragDash = dash;\n"
+		"  fragColor = color;\n"
 		"}\n";
 
 	static const char *fragmentCode =
 		"// fragment ring shader\n"
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		"uniform float radius;\n"
-		"uniform float width;\n"
-		"uniform float angle;\n"
-		"uniform float startAngle;\n"
-		"uniform float dash;\n"
 		"const float pi = 3.1415926535897932384626433832795;\n"
 		
 		"in vec2 coord;\n"
+		"in float fragRadius;\n"
+		"in float fragWidth;\n"
+		"in float fragAngle;\n"
+		"in float fragStartAngle;\n"
+		"in float fragDash;\n"
+		"in vec4 fragColor;\n"
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  float arc = mod(atan(coord.x, coord.y) + pi + startAngle, 2 * pi);\n"
-		"  float arcFalloff = 1 - min(2 * pi - arc, arc - angle) * radius;\n"
-		"  if(dash != 0)\n"
+		"  float arc = mod(atan(coord.x, coord.y) + pi + fragStartAngle, 2 * pi);\n"
+		"  float arcFalloff = 1 - min(2 * pi - arc, arc - fragAngle) * fragRadius;\n"
+		"  if(fragDash != 0)\n"
 		"  {\n"
-		"    arc = mod(arc, dash);\n"
-		"    arcFalloff = min(arcFalloff, min(arc, dash - arc) * radius);\n"
+		"    arc = mod(arc, fragDash);\n"
+		"    arcFalloff = min(arcFalloff, min(arc, fragDash - arc) * fragRadius);\n"
 		"  }\n"
 		"  float len = length(coord);\n"
-		"  float lenFalloff = width - abs(len - radius);\n"
+		"  float lenFalloff = fragWidth - abs(len - fragRadius);\n"
 		"  float alpha = clamp(min(arcFalloff, lenFalloff), 0, 1);\n"
-		"  finalColor = color * alpha;\n"
+		"  finalColor = fragColor * alpha;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	positionI = shader.Uniform("position");
-	radiusI = shader.Uniform("radius");
-	widthI = shader.Uniform("width");
-	angleI = shader.Uniform("angle");
-	startAngleI = shader.Uniform("startAngle");
-	dashI = shader.Uniform("dash");
-	colorI = shader.Uniform("color");
 	
-	// Generate the vertex data for drawing sprites.
+	// Generate the buffer for uploading the batched vertex data.
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		-1.f, -1.f,
-		-1.f,  1.f,
-		 1.f, -1.f,
-		 1.f,  1.f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	// Enable each of the vertex attributes, at its offset within the vertex.
+	struct Attribute { const char *name; int size; };
+	static const Attribute ATTRIBUTES[] = {
+		{"vert", 2}, {"position", 2}, {"radius", 1}, {"width", 1}, {"angle", 1}, {"startAngle", 1},
+		{"dash", 1}, {"color", 4}};
+	int offset = 0;
+	for(const Attribute &attribute : ATTRIBUTES)
+	{
+		GLint index = shader.Attrib(attribute.name);
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, attribute.size, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(GLfloat),
+			reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+		offset += attribute.size;
+	}
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -127,58 +178,26 @@ void RingShader::Draw(const Point &pos, float out, float in, const Color &color)
 
 
 void RingShader::Draw(const Point &pos, float radius, float width, float fraction, const Color &color, float dash, float startAngle)
-{
-	Bind();
-	
-	Add(pos, radius, width, fraction, color, dash, startAngle);
-	
-	Unbind();
-}
-
-
-
-void RingShader::Bind()
 {
 	if(!shader.Object())
-		throw runtime_error("RingShader: Bind() called before Init().");
-	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
-}
-
-
-
-void RingShader::Add(const Point &pos, float out, float in, const Color &color)
-{
-	float width = .5f * (1.f + out - in) ;
-	Add(pos, out - width, width, 1.f, color);
-}
-
-
-
-void RingShader::Add(const Point &pos, float radius, float width, float fraction, const Color &color, float dash, float startAngle)
-{
-	GLfloat position[2] = {static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
-	glUniform2fv(positionI, 1, position);
-	
-	glUniform1f(radiusI, radius);
-	glUniform1f(widthI, width);
-	glUniform1f(angleI, fraction * 2. * PI);
-	glUniform1f(startAngleI, startAngle * TO_RAD);
-	glUniform1f(dashI, dash ? 2. * PI / dash : 0.);
+		throw runtime_error("RingShader: Draw() called before Init().");
 	
-	glUniform4fv(colorI, 1, color.Get());
+	// The ring is not drawn until something other than a ring needs to be
+	// drawn, so that consecutive rings share one draw call.
+	RenderQueue::Add(Flush);
 	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-}
-
-
-
-void RingShader::Unbind()
-{
-	glBindVertexArray(0);
-	glUseProgram(0);
+	const float data[] = {
+		static_cast<float>(pos.X()), static_cast<float>(pos.Y()),
+		radius,
+		width,
+		static_cast<float>(fraction * 2. * PI),
+		static_cast<float>(startAngle * TO_RAD),
+		static_cast<float>(dash ? 2. * PI / dash : 0.)};
+	const float *rgba = color.Get();
+	for(int i = 0; i < 12; i += 2)
+	{
+		vertices.insert(vertices.end(), CORNERS + i, CORNERS + i + 2);
+		vertices.insert(vertices.end(), data, data + 7);
+		vertices.insert(vertices.end(), rgba, rgba + 4);
+	}
 }
@@ -19,18 +19,14 @@ class Point;
 
 
 // Class representing a shader that draws round "dots," either filled in or with
-// transparent centers (i.e. circles or rings).
+// transparent centers (i.e. circles or rings). Rings that are drawn one after
+// another are collected and drawn together, with a single draw call.
 class RingShader {
 public:
 	static void Init();
 	
 	static void Draw(const Point &pos, float out, float in, const Color &color);
 	static void Draw(const Point &pos, float radius, float width, float fraction, const Color &color, float dash = 0.f, float startAngle = 0.f);
-	
-	static void Bind();
-	static void Add(const Point &pos, float out, float in, const Color &color);
-	static void Add(const Point &pos, float radius, float width, float fraction, const Color &color, float dash = 0.f, float startAngle = 0.f);
-	static void Unbind();
 };
 
 
@@ -0,0 +1,141 @@
+/* RouteCache.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "RouteCache.h"
+
+#include "GameData.h"
+#include "Planet.h"
+#include "Ship.h"
+#include "ThreadPool.h"
+
+#include <memory>
+#include <tuple>
+
+using namespace std;
+
+
+
+// Calculate the routes for all of the given ship and destination pairs that
+// are not already known, spreading the work over the given threads.
+void RouteCache::Prefetch(const vector<pair<const Ship *, const System *>> &requests, ThreadPool &workers)
+{
+	CheckRevision();
+	
+	// Forget any routes that no ship has asked for recently.
+	for(auto it = entries.begin(); it != entries.end(); )
+	{
+		if(it->second.isUsed)
+		{
+			it->second.isUsed = false;
+			++it;
+		}
+		else
+			it = entries.erase(it);
+	}
+	
+	// Many ships (e.g. a fleet and its escorts) will ask for the same route,
+	// so only calculate each one once.
+	map<Key, const Ship *> missing;
+	for(const auto &request : requests)
+	{
+		if(!request.first || !request.first->GetSystem() || !request.second
+				|| request.first->GetSystem() == request.second)
+			continue;
+		Key key = MakeKey(*request.first, request.second);
+		if(!entries.count(key))
+			missing.emplace(move(key), request.first);
+	}
+	if(missing.empty())
+		return;
+	
+	vector<pair<const Key *, const Ship *>> jobs;
+	jobs.reserve(missing.size());
+	for(const auto &it : missing)
+		jobs.emplace_back(&it.first, it.second);
+	vector<unique_ptr<DistanceMap>> routes(jobs.size());
+	workers.ForEach(jobs.size(), [&jobs, &routes](size_t i)
+	{
+		routes[i].reset(new DistanceMap(*jobs[i].second, jobs[i].first->destination));
+	});
+	
+	// Prefetched routes start out unused, so that they are dropped next step
+	// if it turns out that nothing needed them.
+	for(size_t i = 0; i < jobs.size(); ++i)
+		entries.emplace(*jobs[i].first, Entry(move(*routes[i]))).first->second.isUsed = false;
+}
+
+
+
+// Get the route for the given ship to reach the given system.
+const DistanceMap &RouteCache::Get(const Ship &ship, const System *destination)
+{
+	CheckRevision();
+	
+	Key key = MakeKey(ship, destination);
+	auto it = entries.find(key);
+	if(it == entries.end())
+		it = entries.emplace(move(key), Entry(DistanceMap(ship, destination))).first;
+	it->second.isUsed = true;
+	return it->second.route;
+}
+
+
+
+bool RouteCache::Key::operator<(const Key &other) const
+{
+	return tie(source, destination, hyperspaceFuel, jumpFuel, jumpRange, wormholes)
+		< tie(other.source, other.destination, other.hyperspaceFuel, other.jumpFuel, other.jumpRange, other.wormholes);
+}
+
+
+
+RouteCache::Entry::Entry(DistanceMap &&route)
+	: route(move(route))
+{
+}
+
+
+
+// Clear the cache if the galaxy has changed since it was filled in.
+void RouteCache::CheckRevision()
+{
+	if(revision == GameData::Revision())
+		return;
+	
+	revision = GameData::Revision();
+	entries.clear();
+	restricted.clear();
+	for(const auto &it : GameData::Planets())
+		if(it.second.IsWormhole() && !it.second.IsUnrestricted())
+			restricted.push_back(&it.second);
+}
+
+
+
+// Get the properties of this ship that DistanceMap uses to plan its route.
+RouteCache::Key RouteCache::MakeKey(const Ship &ship, const System *destination) const
+{
+	Key key;
+	key.source = ship.GetSystem();
+	key.destination = destination;
+	// These are rounded the same way DistanceMap does it, so that ships whose
+	// drives only differ by a fraction of a unit of fuel share their routes.
+	key.hyperspaceFuel = ship.HyperdriveFuel();
+	key.jumpFuel = ship.JumpDriveFuel();
+	key.jumpRange = ship.JumpRange();
+	if(key.hyperspaceFuel == key.jumpFuel)
+		key.hyperspaceFuel = 0;
+	key.wormholes.reserve(restricted.size());
+	for(const Planet *planet : restricted)
+		key.wormholes.push_back(planet->IsAccessible(&ship));
+	return key;
+}
@@ -0,0 +1,86 @@
+/* RouteCache.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ROUTE_CACHE_H_
+#define ROUTE_CACHE_H_
+
+#include "DistanceMap.h"
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+class Planet;
+class Ship;
+class System;
+class ThreadPool;
+
+
+
+// Class that remembers the routes the AI has calculated for its ships. A
+// ship's route only depends on where it is, where it is going, and what drives
+// and wormhole access it has, so whole fleets of escorts with the same drives
+// can share a single route. The routes that are likely to be needed in a
+// given step can be calculated ahead of time, in parallel. All the routes are
+// thrown out whenever the galaxy changes.
+class RouteCache {
+public:
+	// Calculate the routes for all of the given ship and destination pairs
+	// that are not already known, spreading the work over the given threads.
+	// Any route that was not used since the last call to this is forgotten.
+	void Prefetch(const std::vector<std::pair<const Ship *, const System *>> &requests, ThreadPool &workers);
+	// Get the route for the given ship to reach the given system, calculating
+	// it now if it was not prefetched.
+	const DistanceMap &Get(const Ship &ship, const System *destination);
+	
+	
+private:
+	// Everything that affects the route a ship will take.
+	class Key {
+	public:
+		bool operator<(const Key &other) const;
+		
+		const System *source = nullptr;
+		const System *destination = nullptr;
+		int hyperspaceFuel = 0;
+		int jumpFuel = 0;
+		double jumpRange = 0.;
+		// Which of the wormholes with required attributes this ship can use.
+		std::vector<bool> wormholes;
+	};
+	
+	class Entry {
+	public:
+		explicit Entry(DistanceMap &&route);
+		
+		DistanceMap route;
+		bool isUsed = true;
+	};
+	
+	
+private:
+	// Clear the cache if the galaxy has changed since it was filled in.
+	void CheckRevision();
+	Key MakeKey(const Ship &ship, const System *destination) const;
+	
+	
+private:
+	std::map<Key, Entry> entries;
+	// The wormholes that not every ship can travel through.
+	std::vector<const Planet *> restricted;
+	uint64_t revision = 0;
+};
+
+
+
+#endif
@@ -0,0 +1,284 @@
+/* SaveJournal.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SaveJournal.h"
+
+#include "BinaryData.h"
+#include "DataFile.h"
+#include "Files.h"
+#include "SnapshotStore.h"
+
+#include <sstream>
+#include <utility>
+
+using namespace std;
+
+namespace {
+	// Each record begins with this, so that a journal written by a different
+	// version of this class is not mistaken for one that can be read.
+	const uint32_t VERSION = 1;
+	// A chunk ends after any line whose hash has none of its top five bits set,
+	// so on average a chunk is no more than 32 lines long. (The low bits of the
+	// hash vary too little between lines that differ only near the end.)
+	const int BOUNDARY_SHIFT = 59;
+	// Once the journal is this fraction of the size of the full save, the
+	// next save rewrites the whole file instead.
+	const size_t COMPACT_RATIO = 4;
+	const size_t NONE = static_cast<size_t>(-1);
+}
+
+
+
+// Get the path of the journal that goes with the given file.
+string SaveJournal::JournalPath(const string &path)
+{
+	if(path.length() >= 4 && !path.compare(path.length() - 4, 4, ".txt"))
+		return path.substr(0, path.length() - 4) + ".journal";
+	return path + ".journal";
+}
+
+
+
+// Read the given file, with its journal (if any) applied.
+string SaveJournal::Read(const string &path)
+{
+	string base = Files::Read(path);
+	if(SnapshotStore::IsSnapshot(base))
+		base = SnapshotStore::Reconstruct(base);
+	string journalPath = JournalPath(path);
+	if(!Files::Exists(journalPath))
+		return base;
+	
+	string result;
+	return Apply(base, Files::Read(journalPath), result) ? result : base;
+}
+
+
+
+void SaveJournal::Load(const string &path, DataFile &file)
+{
+	// The file may be a snapshot, or have a journal, so it cannot always be
+	// parsed straight from the disk.
+	istringstream in(Read(path));
+	file.Load(in);
+}
+
+
+
+// Apply the last complete record in the given journal to the given text.
+bool SaveJournal::Apply(const string &base, const string &journal, string &result)
+{
+	vector<Chunk> chunks = Split(base);
+	uint64_t baseHash = BinaryData::Hash(base);
+	
+	bool found = false;
+	size_t pos = 0;
+	while(pos < journal.size())
+	{
+		uint32_t version = 0;
+		uint64_t hash = 0;
+		uint32_t count = 0;
+		if(!BinaryData::Read32(journal, pos, version) || version != VERSION
+				|| !BinaryData::Read64(journal, pos, hash) || !BinaryData::Read32(journal, pos, count))
+			break;
+		
+		// A record that was made from a different full save can still be
+		// skipped over, in case a later one was made from this one.
+		bool isValid = (hash == baseHash);
+		string text;
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			uint32_t first = 0;
+			uint32_t run = 0;
+			string literal;
+			if(!BinaryData::Read32(journal, pos, first) || !BinaryData::Read32(journal, pos, run)
+					|| !BinaryData::ReadString(journal, pos, literal))
+				return found;
+			
+			if(static_cast<size_t>(first) + run > chunks.size())
+				isValid = false;
+			else if(isValid)
+				for(uint32_t j = first; j < first + run; ++j)
+					text.append(base, chunks[j].start, chunks[j].length);
+			text += literal;
+		}
+		// The record ends with the hash of the text it describes. If it was
+		// cut off before that, it is incomplete.
+		uint64_t check = 0;
+		if(!BinaryData::Read64(journal, pos, check))
+			break;
+		if(isValid && check == BinaryData::Hash(text))
+		{
+			result = move(text);
+			found = true;
+		}
+	}
+	return found;
+}
+
+
+
+// Check whether the next save to the given path has to be a full one.
+bool SaveJournal::NeedsFullSave(const string &path) const
+{
+	return path != this->path || base.empty() || journalSize > base.size() / COMPACT_RATIO;
+}
+
+
+
+// Write the given text to the given path in full, and start a new journal.
+void SaveJournal::SaveFull(const string &path, string text, bool isJournaling)
+{
+	// Any journal that is left over from an earlier full save will be ignored
+	// when this file is read, and is replaced by the first new record.
+	if(!isJournaling)
+	{
+		*this = SaveJournal();
+		Files::WriteInBackground(path, move(text));
+		return;
+	}
+	
+	Files::WriteInBackground(path, text);
+	SetBase(path, move(text));
+}
+
+
+
+// Append the differences between the given text and the last full save to
+// the journal.
+void SaveJournal::SaveChanges(const string &text)
+{
+	string record = Changes(text);
+	string journalPath = JournalPath(path);
+	if(!journalSize)
+		Files::WriteInBackground(journalPath, record);
+	else
+		Files::AppendInBackground(journalPath, record);
+	journalSize += record.size();
+}
+
+
+
+// Remember the given text as the last full save of the given path.
+void SaveJournal::SetBase(const string &path, string text)
+{
+	this->path = path;
+	base = move(text);
+	baseHash = BinaryData::Hash(base);
+	chunks = Split(base);
+	index.clear();
+	for(size_t i = 0; i < chunks.size(); ++i)
+		index.emplace(chunks[i].hash, i);
+	journalSize = 0;
+}
+
+
+
+// Get a journal record that turns the last full save into the given text.
+// The record is a list of runs of the full save's chunks to keep, each
+// followed by any new text that comes after them.
+string SaveJournal::Changes(const string &text) const
+{
+	auto isSame = [this, &text](size_t i, const Chunk &chunk) -> bool
+	{
+		const Chunk &old = chunks[i];
+		return old.hash == chunk.hash && old.length == chunk.length
+			&& !base.compare(old.start, old.length, text, chunk.start, chunk.length);
+	};
+	
+	string ops;
+	uint32_t count = 0;
+	size_t first = 0;
+	size_t run = 0;
+	string literal;
+	for(const Chunk &chunk : Split(text))
+	{
+		// Most chunks are unchanged, and in the same order as before, so check
+		// whether this one continues the current run before looking it up.
+		size_t match = NONE;
+		bool continuesRun = (literal.empty() && first + run < chunks.size() && isSame(first + run, chunk));
+		if(continuesRun)
+			match = first + run;
+		else
+		{
+			auto it = index.find(chunk.hash);
+			if(it != index.end() && isSame(it->second, chunk))
+				match = it->second;
+		}
+		
+		if(match == NONE)
+			literal.append(text, chunk.start, chunk.length);
+		else if(continuesRun)
+			++run;
+		else
+		{
+			if(run || !literal.empty())
+			{
+				BinaryData::Write32(first, ops);
+				BinaryData::Write32(run, ops);
+				BinaryData::WriteString(literal, ops);
+				literal.clear();
+				++count;
+			}
+			first = match;
+			run = 1;
+		}
+	}
+	if(run || !literal.empty())
+	{
+		BinaryData::Write32(first, ops);
+		BinaryData::Write32(run, ops);
+		BinaryData::WriteString(literal, ops);
+		++count;
+	}
+	
+	string record;
+	BinaryData::Write32(VERSION, record);
+	BinaryData::Write64(baseHash, record);
+	BinaryData::Write32(count, record);
+	record += ops;
+	BinaryData::Write64(BinaryData::Hash(text), record);
+	return record;
+}
+
+
+
+// Split the given text into chunks. Each top-level node begins a new chunk,
+// so that, for example, each ship and mission is in chunks of its own, and
+// large nodes are broken up wherever a line's hash says to.
+vector<SaveJournal::Chunk> SaveJournal::Split(const string &text)
+{
+	vector<Chunk> result;
+	size_t start = 0;
+	size_t line = 0;
+	while(line < text.size())
+	{
+		size_t end = text.find('\n', line);
+		end = (end == string::npos) ? text.size() : end + 1;
+		
+		if(text[line] != '\t' && line > start)
+		{
+			result.push_back({start, line - start, BinaryData::Hash(text.data() + start, line - start)});
+			start = line;
+		}
+		if(!(BinaryData::Hash(text.data() + line, end - line) >> BOUNDARY_SHIFT))
+		{
+			result.push_back({start, end - start, BinaryData::Hash(text.data() + start, end - start)});
+			start = end;
+		}
+		line = end;
+	}
+	if(start < text.size())
+		result.push_back({start, text.size() - start, BinaryData::Hash(text.data() + start, text.size() - start)});
+	
+	return result;
+}
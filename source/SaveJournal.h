@@ -0,0 +1,93 @@
+/* SaveJournal.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SAVE_JOURNAL_H_
+#define SAVE_JOURNAL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class DataFile;
+
+
+
+// Class for saving a file by appending what has changed since it was last
+// saved in full to a "journal" next to it, instead of rewriting the whole file
+// every time. Most saves only change a few conditions, ships, or missions, so
+// this writes kilobytes instead of megabytes. The text is split into chunks at
+// each top-level node, and also at lines whose contents hash to a certain
+// value, so that a change only affects the chunks around it. Each record in
+// the journal lists which chunks of the full save to keep and what new text to
+// put between them, so only the last complete record matters when the file is
+// read back. Any record that was cut short, or that was made from a different
+// version of the full save, is ignored.
+class SaveJournal {
+public:
+	// Get the path of the journal that goes with the given file.
+	static std::string JournalPath(const std::string &path);
+	// Read the given file, with its journal (if any) applied. If the file is
+	// a snapshot, it is put back together from the snapshot store first.
+	static std::string Read(const std::string &path);
+	static void Load(const std::string &path, DataFile &file);
+	// Apply the last complete record in the given journal to the given text.
+	// If there is no such record, this returns false.
+	static bool Apply(const std::string &base, const std::string &journal, std::string &result);
+	
+	
+public:
+	// Check whether the next save to the given path has to be a full one,
+	// either because this journal has no record of that file's last full save,
+	// or because enough has been added to its journal that a full save is due.
+	bool NeedsFullSave(const std::string &path) const;
+	// Write the given text to the given path in full, in the background. Any
+	// journal that was made from an earlier full save no longer applies. If the
+	// changes will be journaled from now on, remember the text to compare to.
+	void SaveFull(const std::string &path, std::string text, bool isJournaling);
+	// Append the differences between the given text and the last full save
+	// to the journal, in the background.
+	void SaveChanges(const std::string &text);
+	
+	// Remember the given text as the last full save of the given path.
+	void SetBase(const std::string &path, std::string text);
+	// Get a journal record that turns the last full save into the given text.
+	std::string Changes(const std::string &text) const;
+	
+	
+private:
+	class Chunk {
+	public:
+		size_t start;
+		size_t length;
+		uint64_t hash;
+	};
+	
+	// Split the given text into chunks.
+	static std::vector<Chunk> Split(const std::string &text);
+	
+	
+private:
+	std::string path;
+	std::string base;
+	uint64_t baseHash = 0;
+	std::vector<Chunk> chunks;
+	// Look up which of the base's chunks has the given hash.
+	std::unordered_map<uint64_t, size_t> index;
+	// How much has been added to the journal since the last full save.
+	size_t journalSize = 0;
+};
+
+
+
+#endif
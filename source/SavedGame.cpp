@@ -15,11 +15,24 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DataFile.h"
 #include "DataNode.h"
 #include "Date.h"
+#include "File.h"
+#include "Files.h"
+#include "SaveJournal.h"
+#include "SnapshotStore.h"
 #include "text/Format.h"
 #include "SpriteSet.h"
 
+#include <iterator>
+#include <sstream>
+
 using namespace std;
 
+namespace {
+	// The pilot information and the summary are at the very start of a save
+	// file, so there is no need to read more than this to find them.
+	const size_t HEADER_SIZE = 4096;
+}
+
 
 
 SavedGame::SavedGame(const string &path)
@@ -29,15 +42,57 @@ SavedGame::SavedGame(const string &path)
 
 
 
+// Load the pilot information from the given file. If it has a summary at the
+// start, only that part of the file needs to be read.
 void SavedGame::Load(const string &path)
 {
 	Clear();
-	DataFile file(path);
+	string header(HEADER_SIZE, '\0');
+	{
+		File file(path);
+		if(!file)
+			return;
+		header.resize(fread(&header[0], 1, header.size(), file));
+	}
+	// If this save has a journal, the changes recorded in it may include the
+	// summary, so the whole file must be read to apply them. A snapshot also
+	// has to be put back together before its summary can be read.
+	if(Files::Exists(SaveJournal::JournalPath(path)) || SnapshotStore::IsSnapshot(header))
+		header = SaveJournal::Read(path).substr(0, HEADER_SIZE);
+	// Only parse complete lines.
+	size_t end = header.rfind('\n');
+	if(end != string::npos)
+	{
+		istringstream in(header.substr(0, end + 1));
+		DataFile file(in);
+		// The summary's children may continue past the end of what was read, so
+		// it is only complete if some other node comes after it.
+		if(file.begin() != file.end() && LoadNodes(file.begin(), prev(file.end())))
+		{
+			this->path = path;
+			return;
+		}
+	}
+	
+	// This save was made before summaries were added, so read the whole file.
+	Clear();
+	DataFile file;
+	SaveJournal::Load(path, file);
 	if(file.begin() != file.end())
 		this->path = path;
-	
-	for(const DataNode &node : file)
+	LoadNodes(file.begin(), file.end());
+}
+
+
+
+// Read the pilot information from the given nodes.
+template <class Iterator>
+bool SavedGame::LoadNodes(Iterator begin, Iterator end)
+{
+	bool hasSummary = false;
+	for(Iterator it = begin; it != end; ++it)
 	{
+		const DataNode &node = *it;
 		if(node.Token(0) == "pilot" && node.Size() >= 3)
 			name = node.Token(1) + " " + node.Token(2);
 		else if(node.Token(0) == "date" && node.Size() >= 4)
@@ -48,6 +103,20 @@ void SavedGame::Load(const string &path)
 			planet = node.Token(1);
 		else if(node.Token(0) == "playtime" && node.Size() >= 2)
 			playTime = Format::PlayTime(node.Value(1));
+		else if(node.Token(0) == "summary")
+		{
+			hasSummary = true;
+			for(const DataNode &child : node)
+			{
+				if(child.Token(0) == "credits" && child.Size() >= 2)
+					credits = Format::Credits(child.Value(1));
+				else if(child.Token(0) == "ship" && child.Size() >= 3)
+				{
+					shipName = child.Token(1);
+					shipSprite = SpriteSet::Get(child.Token(2));
+				}
+			}
+		}
 		else if(node.Token(0) == "account")
 		{
 			for(const DataNode &child : node)
@@ -68,6 +137,7 @@ void SavedGame::Load(const string &path)
 			}
 		}
 	}
+	return hasSummary;
 }
 
 
@@ -46,6 +46,13 @@ public:
 	const std::string &ShipName() const;
 	
 	
+private:
+	// Read the pilot information from the given nodes. This returns true if a
+	// summary of the rest of the file was found.
+	template <class Iterator>
+	bool LoadNodes(Iterator begin, Iterator end);
+	
+	
 private:
 	std::string path;
 	
@@ -0,0 +1,256 @@
+/* SceneBuffer.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SceneBuffer.h"
+
+#include "GpuProfiler.h"
+#include "Preferences.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+	const Preferences::Setting DYNAMIC_RESOLUTION("Dynamic resolution");
+	
+	// If drawing the scene takes the GPU longer than this, draw it at a lower
+	// resolution. A frame lasts about 16.7 ms, and the HUD and the CPU's own
+	// work need some of that. Once the scene takes well under this, the
+	// resolution is raised again; the gap between the two keeps it from going
+	// back and forth every frame.
+	const double TOO_SLOW = 12e6;
+	const double FAST_ENOUGH = 8e6;
+	// Going below half resolution makes the scene too blurry to be worth it.
+	const double MIN_SCALE = .5;
+	
+	Shader shader;
+	GLint fractionI;
+	
+	GLuint vao;
+	GLuint vbo;
+	
+	// The texture is always as big as the screen, and only the part of it that
+	// is in use is drawn into, so changing the scale does not reallocate it.
+	GLuint framebuffer = 0;
+	GLuint texture = 0;
+	GLint width = 0;
+	GLint height = 0;
+	bool isComplete = false;
+	double scale = 1.;
+	GLint scaledWidth = 0;
+	GLint scaledHeight = 0;
+	
+	// What to go back to drawing into once the scene is done.
+	GLint previousFramebuffer = 0;
+	GLint viewport[4] = {};
+	bool isActive = false;
+	
+	// The time each frame's scene took is read back a couple of frames later,
+	// so that the CPU never waits on the GPU.
+	const int QUERIES = 3;
+	GLuint queries[QUERIES] = {};
+	bool isPending[QUERIES] = {};
+	int current = 0;
+	
+	
+	
+	// Make the texture match the size of the screen.
+	void Resize(GLint newWidth, GLint newHeight)
+	{
+		width = newWidth;
+		height = newHeight;
+		
+		if(!texture)
+			glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		GpuProfiler::CountUpload();
+		// Linear filtering is what smooths out the stretched image.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		
+		if(!framebuffer)
+			glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+		isComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+		glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	}
+	
+	
+	
+	// If the oldest frame's timing is ready, use it to adjust the scale.
+	void AdjustScale()
+	{
+		if(!isPending[current])
+			return;
+		
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(queries[current], GL_QUERY_RESULT_AVAILABLE, &available);
+		isPending[current] = false;
+		if(!available)
+			return;
+		
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &elapsed);
+		// The time taken is roughly proportional to the number of pixels drawn,
+		// so small steps are enough.
+		if(elapsed > TOO_SLOW)
+			scale = max(MIN_SCALE, scale * .9);
+		else if(elapsed < FAST_ENOUGH)
+			scale = min(1., scale * 1.05);
+	}
+}
+
+
+
+void SceneBuffer::Init()
+{
+	static const char *vertexCode =
+		"// vertex scene shader\n"
+		"uniform vec2 fraction;\n"
+	
+		"in vec2 vert;\n"
+		"out vec2 texCoord;\n"
+	
+		"void main() {\n"
+		"  texCoord = (vert + vec2(1, 1)) * .5 * fraction;\n"
+		"  gl_Position = vec4(vert, 0, 1);\n"
+		"}\n";
+	
+	static const char *fragmentCode =
+		"// fragment scene shader\n"
+		"uniform sampler2D tex;\n"
+	
+		"in vec2 texCoord;\n"
+		"out vec4 finalColor;\n"
+	
+		"void main() {\n"
+		"  finalColor = vec4(texture(tex, texCoord).rgb, 1);\n"
+		"}\n";
+	
+	shader = Shader(vertexCode, fragmentCode);
+	fractionI = shader.Uniform("fraction");
+	
+	glUseProgram(shader.Object());
+	glUniform1i(shader.Uniform("tex"), 0);
+	glUseProgram(0);
+	
+	// The stretched scene is drawn as a single quad covering the whole screen.
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	
+	const GLfloat vertexData[] = {
+		-1.f, -1.f,
+		 1.f, -1.f,
+		-1.f,  1.f,
+		 1.f,  1.f
+	};
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
+	
+	glEnableVertexAttribArray(shader.Attrib("vert"));
+	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	
+	// unbind the VBO and VAO
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	
+	glGenQueries(QUERIES, queries);
+}
+
+
+
+void SceneBuffer::Begin()
+{
+	if(!DYNAMIC_RESOLUTION.Has() || !GpuProfiler::HasTimers() || !shader.Object())
+	{
+		scale = 1.;
+		return;
+	}
+	
+	// Anything that is still waiting to be drawn belongs on the screen.
+	RenderQueue::Flush();
+	
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if(viewport[2] != width || viewport[3] != height)
+		Resize(viewport[2], viewport[3]);
+	// If the driver will not draw into this texture, draw straight to the
+	// screen instead, and do not try again until the screen is resized.
+	if(!isComplete || !width || !height)
+		return;
+	
+	AdjustScale();
+	Profiler::SetCounter("Scene resolution (%)", lround(scale * 100.));
+	scaledWidth = max<GLint>(1, lround(width * scale));
+	scaledHeight = max<GLint>(1, lround(height * scale));
+	
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, scaledWidth, scaledHeight);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+	isActive = true;
+}
+
+
+
+void SceneBuffer::End()
+{
+	if(!isActive)
+		return;
+	isActive = false;
+	
+	RenderQueue::Flush();
+	glEndQuery(GL_TIME_ELAPSED);
+	isPending[current] = true;
+	current = (current + 1) % QUERIES;
+	
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	
+	// The scene replaces whatever was on the screen, so there is nothing to
+	// blend it with.
+	glDisable(GL_BLEND);
+	glUseProgram(shader.Object());
+	glBindVertexArray(vao);
+	
+	GLfloat fraction[2] = {
+		static_cast<float>(scaledWidth) / width,
+		static_cast<float>(scaledHeight) / height};
+	glUniform2fv(fractionI, 1, fraction);
+	
+	glBindTexture(GL_TEXTURE_2D, texture);
+	GpuProfiler::CountBind();
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	GpuProfiler::CountDraw();
+	
+	glBindVertexArray(0);
+	glUseProgram(0);
+	glEnable(GL_BLEND);
+}
+
+
+
+double SceneBuffer::Scale()
+{
+	return scale;
+}
@@ -0,0 +1,41 @@
+/* SceneBuffer.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SCENE_BUFFER_H_
+#define SCENE_BUFFER_H_
+
+
+
+// Class for drawing the flight view at less than the screen's full resolution
+// when the GPU cannot keep up with it. If the "Dynamic resolution" preference
+// is on, everything drawn between Begin() and End() goes into an offscreen
+// texture instead of the screen, and is then stretched to fill the screen. The
+// fraction of the screen's resolution that the texture uses is adjusted based
+// on how long the GPU took to draw it in earlier frames. This needs timer
+// queries to measure that, so without them it does nothing.
+class SceneBuffer {
+public:
+	// This must be called once the OpenGL context has been created.
+	static void Init();
+	
+	// Start drawing into the offscreen texture, if dynamic resolution is on.
+	static void Begin();
+	// Stretch whatever was drawn since Begin() to fill the screen.
+	static void End();
+	
+	// Get the fraction of the screen's resolution that the scene is drawn at.
+	static double Scale();
+};
+
+
+
+#endif
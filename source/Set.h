@@ -13,49 +13,125 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SET_H_
 #define SET_H_
 
+#include <cstddef>
 #include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
 
 
 
 // Template representing a set of named objects of a given type, where you can
 // query it for a pointer to any object and it will return one, whether or not that
-// object has been loaded yet. (This allows cyclic pointers.)
+// object has been loaded yet. (This allows cyclic pointers.) The objects are
+// kept sorted by name, but looking them up by name uses a hash table. A set
+// can also keep track of which objects have been changed, so that the changes
+// can be undone without having to keep a copy of every object.
 template<class Type>
 class Set {
 public:
+	Set() = default;
+	// Copying a set must rebuild the index, so that it refers to the copies.
+	Set(const Set<Type> &other);
+	Set(Set<Type> &&other) = default;
+	Set<Type> &operator=(const Set<Type> &other);
+	Set<Type> &operator=(Set<Type> &&other) = default;
+	
 	// Allow non-const access to the owner of this set; it can hand off only
 	// const references to avoid anyone else modifying the objects.
-	Type *Get(const std::string &name) { return &data[name]; }
-	const Type *Get(const std::string &name) const { return &data[name]; }
+	Type *Get(const std::string &name) { return Modify(name); }
+	const Type *Get(const std::string &name) const { return Insert(name); }
 	// If an item already exists in this set, get it. Otherwise, return a null
 	// pointer rather than creating the item.
 	const Type *Find(const std::string &name) const;
 	
-	bool Has(const std::string &name) const { return data.count(name); }
+	bool Has(const std::string &name) const { return index.count(name); }
 	
-	typename std::map<std::string, Type>::iterator begin() { return data.begin(); }
+	// Iterating over a non-const set counts as changing every object in it.
+	typename std::map<std::string, Type>::iterator begin() { SaveAll(); return data.begin(); }
 	typename std::map<std::string, Type>::const_iterator begin() const { return data.begin(); }
 	typename std::map<std::string, Type>::iterator end() { return data.end(); }
 	typename std::map<std::string, Type>::const_iterator end() const { return data.end(); }
 	
 	int size() const { return data.size(); }
+	// Estimate how much memory the objects in this set and their saved
+	// originals use, not counting anything that the objects allocate.
+	size_t MemoryUsage() const;
 	// Remove any objects in this set that are not in the given set, and for
 	// those that are in the given set, revert to their contents.
 	void Revert(const Set<Type> &other);
 	
+	// From now on, store the original state of each object the first time it
+	// is given out for modifying, and remember which objects are added.
+	void TrackChanges();
+	// Undo every change made since TrackChanges() was called, by restoring
+	// the objects that were changed and removing any that were added.
+	void Revert();
+	// Apply the given function to the named object, and also to the state it
+	// would be reverted to, so that the change is kept by Revert(). This is for
+	// changing how an object is defined, rather than its state in the game.
+	template <class Function>
+	void Redefine(const std::string &name, Function apply);
+	
+	
+private:
+	// Get the object with the given name, creating it if it does not exist.
+	Type *Insert(const std::string &name) const;
+	// Get the object with the given name for modifying it, first storing its
+	// original state if changes are being tracked.
+	Type *Modify(const std::string &name);
+	// Store the original state of every object that has not been stored yet.
+	void SaveAll();
+	// Rebuild the index from scratch.
+	void Reindex();
+	
 	
 private:
 	mutable std::map<std::string, Type> data;
+	// Pointers to each object in the map, for looking them up by name without
+	// comparing against the names of all the objects along the way. Objects in
+	// a map never move, so these stay valid until the object is erased.
+	mutable std::unordered_map<std::string, Type *> index;
+	
+	// The original state of each object that has been changed since changes
+	// started being tracked, and the names of the objects that were added.
+	bool isTracking = false;
+	bool isAllSaved = false;
+	std::map<std::string, Type> originals;
+	mutable std::set<std::string> added;
 };
 
 
 
+template <class Type>
+Set<Type>::Set(const Set<Type> &other)
+	: data(other.data), isTracking(other.isTracking), isAllSaved(other.isAllSaved),
+	originals(other.originals), added(other.added)
+{
+	Reindex();
+}
+
+
+
+template <class Type>
+Set<Type> &Set<Type>::operator=(const Set<Type> &other)
+{
+	data = other.data;
+	isTracking = other.isTracking;
+	isAllSaved = other.isAllSaved;
+	originals = other.originals;
+	added = other.added;
+	Reindex();
+	return *this;
+}
+
+
+
 template <class Type>
 const Type *Set<Type>::Find(const std::string &name) const
 {
-	auto it = data.find(name);
-	return (it == data.end() ? nullptr : &it->second);
+	auto it = index.find(name);
+	return (it == index.end() ? nullptr : it->second);
 }
 
 
@@ -69,7 +145,10 @@ void Set<Type>::Revert(const Set<Type> &other)
 	while(it != data.end())
 	{
 		if(oit == other.data.end() || it->first < oit->first)
+		{
+			index.erase(it->first);
 			it = data.erase(it);
+		}
 		else if(it->first == oit->first)
 		{
 			// If this is an entry that is in the set we are reverting to, copy
@@ -86,4 +165,123 @@ void Set<Type>::Revert(const Set<Type> &other)
 
 
 
+template <class Type>
+size_t Set<Type>::MemoryUsage() const
+{
+	// Each object is stored in a map node along with its name, and has an
+	// entry in the index as well.
+	const size_t NODE = sizeof(std::string) + sizeof(Type) + 4 * sizeof(void *);
+	const size_t ENTRY = sizeof(std::string) + 3 * sizeof(void *);
+	return (data.size() + originals.size()) * NODE + index.size() * ENTRY;
+}
+
+
+
+template <class Type>
+void Set<Type>::TrackChanges()
+{
+	isTracking = true;
+	isAllSaved = false;
+	originals.clear();
+	added.clear();
+}
+
+
+
+template <class Type>
+void Set<Type>::Revert()
+{
+	for(auto &it : originals)
+	{
+		auto iit = index.find(it.first);
+		if(iit != index.end())
+			*iit->second = std::move(it.second);
+	}
+	for(const std::string &name : added)
+	{
+		index.erase(name);
+		data.erase(name);
+	}
+	originals.clear();
+	added.clear();
+	isAllSaved = false;
+}
+
+
+
+template <class Type>
+template <class Function>
+void Set<Type>::Redefine(const std::string &name, Function apply)
+{
+	Type *object = Modify(name);
+	apply(*object);
+	if(!isTracking)
+		return;
+	
+	// If the object was created by this definition, it should no longer be
+	// removed by Revert(). Otherwise, its original state must be updated too.
+	auto it = originals.find(name);
+	if(it != originals.end())
+		apply(it->second);
+	else if(added.erase(name) && isAllSaved)
+		originals.emplace(name, *object);
+}
+
+
+
+template <class Type>
+Type *Set<Type>::Insert(const std::string &name) const
+{
+	auto it = index.find(name);
+	if(it != index.end())
+		return it->second;
+	
+	Type *object = &data[name];
+	index.emplace(name, object);
+	if(isTracking)
+		added.insert(name);
+	return object;
+}
+
+
+
+template <class Type>
+Type *Set<Type>::Modify(const std::string &name)
+{
+	auto it = index.find(name);
+	if(it == index.end())
+		return Insert(name);
+	
+	if(isTracking && !isAllSaved && !added.count(name) && !originals.count(name))
+		originals.emplace(name, *it->second);
+	return it->second;
+}
+
+
+
+template <class Type>
+void Set<Type>::SaveAll()
+{
+	if(!isTracking || isAllSaved)
+		return;
+	
+	for(const auto &it : data)
+		if(!added.count(it.first) && !originals.count(it.first))
+			originals.emplace(it.first, it.second);
+	isAllSaved = true;
+}
+
+
+
+template <class Type>
+void Set<Type>::Reindex()
+{
+	index.clear();
+	index.reserve(data.size());
+	for(auto &it : data)
+		index.emplace(it.first, &it.second);
+}
+
+
+
 #endif
@@ -16,16 +16,148 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <cctype>
 #include <cstring>
+#include <map>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 using namespace std;
 
+namespace {
+	// A compiled program, in whatever format the driver uses.
+	class CachedProgram {
+	public:
+		GLenum format = 0;
+		string binary;
+	};
+	
+	// The cached programs, keyed by a hash of their source code.
+	map<uint64_t, CachedProgram> cache;
+	string cachePath;
+	bool canCache = false;
+	bool cacheChanged = false;
+	
+	// Hash a string using the FNV-1a algorithm, continuing from the given hash.
+	uint64_t Hash(const char *str, uint64_t hash = 14695981039346656037ull)
+	{
+		for( ; *str; ++str)
+		{
+			hash ^= static_cast<unsigned char>(*str);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+	
+	// Describe the graphics driver. A program that one driver compiled cannot
+	// be used by any other driver, or even by other versions of the same one.
+	string DriverName()
+	{
+		string name;
+		for(GLenum property : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION})
+		{
+			const GLubyte *value = glGetString(property);
+			if(value)
+				name += reinterpret_cast<const char *>(value);
+			name += '\n';
+		}
+		return name;
+	}
+	
+	template <class Type>
+	void Append(string &data, Type value)
+	{
+		data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	
+	template <class Type>
+	Type Extract(const string &data, size_t &pos)
+	{
+		Type value;
+		memcpy(&value, data.data() + pos, sizeof(value));
+		pos += sizeof(value);
+		return value;
+	}
+}
+
+
+
+// Load the cache of shader programs that were compiled by an earlier run of
+// the game. If it was created by a different driver, it is ignored, and will
+// be replaced with the programs that this driver compiles.
+void Shader::LoadCache(const string &path)
+{
+	cache.clear();
+	cachePath = path;
+	cacheChanged = false;
+	
+	// Saving and loading compiled programs requires OpenGL 4.1, or an extension.
+#ifdef __APPLE__
+	canCache = true;
+#else
+	canCache = GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary;
+#endif
+	if(canCache)
+	{
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		canCache = (formats > 0);
+	}
+	if(!canCache)
+		return;
+	
+	string data = Files::Read(path);
+	string driver = DriverName();
+	if(data.compare(0, driver.length(), driver))
+		return;
+	
+	// Each program is stored as its key, format, and size, followed by the data.
+	const size_t HEADER = sizeof(uint64_t) + 2 * sizeof(uint32_t);
+	size_t pos = driver.length();
+	while(pos + HEADER <= data.length())
+	{
+		uint64_t key = Extract<uint64_t>(data, pos);
+		uint32_t format = Extract<uint32_t>(data, pos);
+		uint32_t size = Extract<uint32_t>(data, pos);
+		if(size > data.length() - pos)
+			break;
+		
+		CachedProgram &program = cache[key];
+		program.format = format;
+		program.binary.assign(data, pos, size);
+		pos += size;
+	}
+}
+
+
+
+// Save the cache of compiled programs, if any new ones were added to it.
+void Shader::SaveCache()
+{
+	if(!canCache || !cacheChanged || cachePath.empty())
+		return;
+	
+	string data = DriverName();
+	for(const auto &it : cache)
+	{
+		Append<uint64_t>(data, it.first);
+		Append<uint32_t>(data, it.second.format);
+		Append<uint32_t>(data, it.second.binary.size());
+		data += it.second.binary;
+	}
+	Files::Write(cachePath, data);
+	cacheChanged = false;
+}
+
 
 
 Shader::Shader(const char *vertex, const char *fragment)
 {
+	// Programs are cached by their source code, so if it changes, a program
+	// with the old code will not be used.
+	uint64_t key = Hash(fragment, Hash(vertex));
+	if(LoadFromCache(key))
+		return;
+	
 	GLuint vertexShader = Compile(vertex, GL_VERTEX_SHADER);
 	GLuint fragmentShader = Compile(fragment, GL_FRAGMENT_SHADER);
 	
@@ -36,6 +168,8 @@ Shader::Shader(const char *vertex, const char *fragment)
 	glAttachShader(program, vertexShader);
 	glAttachShader(program, fragmentShader);
 	
+	if(canCache)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(program);
 	
 	glDetachShader(program, vertexShader);
@@ -54,6 +188,8 @@ Shader::Shader(const char *vertex, const char *fragment)
 		
 		throw runtime_error("Linking OpenGL shader program failed.");
 	}
+	
+	AddToCache(key);
 }
 
 
@@ -136,3 +272,53 @@ GLuint Shader::Compile(const char *str, GLenum type)
 	
 	return object;
 }
+
+
+
+// Create this program from the cached copy with the given key, if there is one
+// and the driver accepts it.
+bool Shader::LoadFromCache(uint64_t key)
+{
+	auto it = cache.find(key);
+	if(!canCache || it == cache.end())
+		return false;
+	
+	program = glCreateProgram();
+	if(!program)
+		throw runtime_error("Creating OpenGL shader program failed.");
+	
+	glProgramBinary(program, it->second.format, it->second.binary.data(), it->second.binary.size());
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if(status == GL_TRUE)
+		return true;
+	
+	// The driver may reject a program that it compiled, e.g. if it has been
+	// updated without its version changing. If so, compile it from source.
+	glDeleteProgram(program);
+	program = 0;
+	cache.erase(it);
+	cacheChanged = true;
+	return false;
+}
+
+
+
+// Add this program to the cache, to be saved the next time SaveCache() is called.
+void Shader::AddToCache(uint64_t key) const
+{
+	if(!canCache)
+		return;
+	
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+		return;
+	
+	CachedProgram &cached = cache[key];
+	cached.binary.resize(length);
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &cached.format, &cached.binary[0]);
+	cached.binary.resize(written);
+	cacheChanged = true;
+}
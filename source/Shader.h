@@ -15,6 +15,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "gl_header.h"
 
+#include <cstdint>
+#include <string>
+
 
 
 // Class representing a shader, i.e. a compiled GLSL program that the GPU uses
@@ -23,6 +26,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 // of the classes representing a particular shader.
 class Shader {
 public:
+	// Load the cache of shader programs that were compiled by an earlier run of
+	// the game, or save any new programs to it. Loading a program from the
+	// cache is much faster than compiling it, but the cache is only used if
+	// it was created by the same graphics driver.
+	static void LoadCache(const std::string &path);
+	static void SaveCache();
+	
 	Shader() noexcept = default;
 	Shader(const char *vertex, const char *fragment);
 	
@@ -33,6 +43,10 @@ public:
 	
 private:
 	GLuint Compile(const char *str, GLenum type);
+	// Create this program from the cached copy with the given key, if there is
+	// one and the driver accepts it, or add this program to the cache.
+	bool LoadFromCache(uint64_t key);
+	void AddToCache(uint64_t key) const;
 	
 	
 private:
@@ -15,8 +15,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Audio.h"
 #include "DataNode.h"
 #include "DataWriter.h"
+#include "Dictionary.h"
 #include "Effect.h"
 #include "Files.h"
+#include "FlatMap.h"
 #include "Flotsam.h"
 #include "text/Format.h"
 #include "GameData.h"
@@ -58,6 +60,93 @@ namespace {
 	
 	const double SCAN_TIME = 60.;
 	
+	// Attributes that are looked up every frame, or whenever a ship is hit.
+	const Dictionary::Key ABSOLUTE_THRESHOLD("absolute threshold");
+	const Dictionary::Key ACTIVE_COOLING("active cooling");
+	const Dictionary::Key AFTERBURNER_ENERGY("afterburner energy");
+	const Dictionary::Key AFTERBURNER_FUEL("afterburner fuel");
+	const Dictionary::Key AFTERBURNER_HEAT("afterburner heat");
+	const Dictionary::Key AFTERBURNER_THRUST("afterburner thrust");
+	const Dictionary::Key AUTOMATON("automaton");
+	const Dictionary::Key CLOAK("cloak");
+	const Dictionary::Key CLOAKING_ENERGY("cloaking energy");
+	const Dictionary::Key CLOAKING_FUEL("cloaking fuel");
+	const Dictionary::Key CLOAKING_HEAT("cloaking heat");
+	const Dictionary::Key COOLING("cooling");
+	const Dictionary::Key COOLING_ENERGY("cooling energy");
+	const Dictionary::Key COOLING_INEFFICIENCY("cooling inefficiency");
+	const Dictionary::Key DEPLETED_SHIELD_DELAY("depleted shield delay");
+	const Dictionary::Key DISABLED_REPAIR_DELAY("disabled repair delay");
+	const Dictionary::Key DISRUPTION_PROTECTION("disruption protection");
+	const Dictionary::Key DISRUPTION_RESISTANCE("disruption resistance");
+	const Dictionary::Key DISRUPTION_RESISTANCE_ENERGY("disruption resistance energy");
+	const Dictionary::Key DISRUPTION_RESISTANCE_FUEL("disruption resistance fuel");
+	const Dictionary::Key DISRUPTION_RESISTANCE_HEAT("disruption resistance heat");
+	const Dictionary::Key DRAG("drag");
+	const Dictionary::Key ENERGY_CAPACITY("energy capacity");
+	const Dictionary::Key ENERGY_CONSUMPTION("energy consumption");
+	const Dictionary::Key ENERGY_GENERATION("energy generation");
+	const Dictionary::Key ENERGY_PROTECTION("energy protection");
+	const Dictionary::Key FORCE_PROTECTION("force protection");
+	const Dictionary::Key FUEL_CAPACITY("fuel capacity");
+	const Dictionary::Key FUEL_CONSUMPTION("fuel consumption");
+	const Dictionary::Key FUEL_ENERGY("fuel energy");
+	const Dictionary::Key FUEL_GENERATION("fuel generation");
+	const Dictionary::Key FUEL_HEAT("fuel heat");
+	const Dictionary::Key FUEL_PROTECTION("fuel protection");
+	const Dictionary::Key HEAT_DISSIPATION("heat dissipation");
+	const Dictionary::Key HEAT_GENERATION("heat generation");
+	const Dictionary::Key HEAT_PROTECTION("heat protection");
+	const Dictionary::Key HULL("hull");
+	const Dictionary::Key HULL_ENERGY("hull energy");
+	const Dictionary::Key HULL_ENERGY_MULTIPLIER("hull energy multiplier");
+	const Dictionary::Key HULL_FUEL("hull fuel");
+	const Dictionary::Key HULL_FUEL_MULTIPLIER("hull fuel multiplier");
+	const Dictionary::Key HULL_HEAT("hull heat");
+	const Dictionary::Key HULL_HEAT_MULTIPLIER("hull heat multiplier");
+	const Dictionary::Key HULL_PROTECTION("hull protection");
+	const Dictionary::Key HULL_REPAIR_MULTIPLIER("hull repair multiplier");
+	const Dictionary::Key HULL_REPAIR_RATE("hull repair rate");
+	const Dictionary::Key HULL_THRESHOLD("hull threshold");
+	const Dictionary::Key HYPERDRIVE("hyperdrive");
+	const Dictionary::Key ION_PROTECTION("ion protection");
+	const Dictionary::Key ION_RESISTANCE("ion resistance");
+	const Dictionary::Key ION_RESISTANCE_ENERGY("ion resistance energy");
+	const Dictionary::Key ION_RESISTANCE_FUEL("ion resistance fuel");
+	const Dictionary::Key ION_RESISTANCE_HEAT("ion resistance heat");
+	const Dictionary::Key JUMP_DRIVE("jump drive");
+	const Dictionary::Key JUMP_SPEED("jump speed");
+	const Dictionary::Key PIERCING_PROTECTION("piercing protection");
+	const Dictionary::Key PIERCING_RESISTANCE("piercing resistance");
+	const Dictionary::Key RAMSCOOP("ramscoop");
+	const Dictionary::Key REPAIR_DELAY("repair delay");
+	const Dictionary::Key REQUIRED_CREW("required crew");
+	const Dictionary::Key REVERSE_THRUST("reverse thrust");
+	const Dictionary::Key SCRAM_DRIVE("scram drive");
+	const Dictionary::Key SHIELD_DELAY("shield delay");
+	const Dictionary::Key SHIELD_ENERGY("shield energy");
+	const Dictionary::Key SHIELD_ENERGY_MULTIPLIER("shield energy multiplier");
+	const Dictionary::Key SHIELD_FUEL("shield fuel");
+	const Dictionary::Key SHIELD_FUEL_MULTIPLIER("shield fuel multiplier");
+	const Dictionary::Key SHIELD_GENERATION("shield generation");
+	const Dictionary::Key SHIELD_GENERATION_MULTIPLIER("shield generation multiplier");
+	const Dictionary::Key SHIELD_HEAT("shield heat");
+	const Dictionary::Key SHIELD_HEAT_MULTIPLIER("shield heat multiplier");
+	const Dictionary::Key SHIELD_PROTECTION("shield protection");
+	const Dictionary::Key SHIELDS("shields");
+	const Dictionary::Key SLOWING_PROTECTION("slowing protection");
+	const Dictionary::Key SLOWING_RESISTANCE("slowing resistance");
+	const Dictionary::Key SLOWING_RESISTANCE_ENERGY("slowing resistance energy");
+	const Dictionary::Key SLOWING_RESISTANCE_FUEL("slowing resistance fuel");
+	const Dictionary::Key SLOWING_RESISTANCE_HEAT("slowing resistance heat");
+	const Dictionary::Key SOLAR_COLLECTION("solar collection");
+	const Dictionary::Key SOLAR_HEAT("solar heat");
+	const Dictionary::Key THRESHOLD_PERCENTAGE("threshold percentage");
+	const Dictionary::Key THRUST("thrust");
+	const Dictionary::Key TURN("turn");
+	const Dictionary::Key TURNING_ENERGY("turning energy");
+	const Dictionary::Key TURNING_HEAT("turning heat");
+	
 	// Helper function to transfer energy to a given stat if it is less than the
 	// given maximum value.
 	void DoRepair(double &stat, double &available, double maximum)
@@ -214,7 +303,7 @@ void Ship::Load(const DataNode &node)
 		else if(key == "attributes" || add)
 		{
 			if(!add)
-				baseAttributes.Load(child);
+				EditChassis().baseAttributes.Load(child);
 			else
 			{
 				addAttributes = true;
@@ -225,16 +314,17 @@ void Ship::Load(const DataNode &node)
 		{
 			if(!hasEngine)
 			{
-				enginePoints.clear();
-				reverseEnginePoints.clear();
-				steeringEnginePoints.clear();
+				EditChassis().enginePoints.clear();
+				EditChassis().reverseEnginePoints.clear();
+				EditChassis().steeringEnginePoints.clear();
 				hasEngine = true;
 			}
 			bool reverse = (key == "reverse engine");
 			bool steering = (key == "steering engine");
 			
-			vector<EnginePoint> &editPoints = (!steering && !reverse) ? enginePoints : 
-				(reverse ? reverseEnginePoints : steeringEnginePoints); 
+			Chassis &edit = EditChassis();
+			vector<EnginePoint> &editPoints = (!steering && !reverse) ? edit.enginePoints : 
+				(reverse ? edit.reverseEnginePoints : edit.steeringEnginePoints); 
 			editPoints.emplace_back(0.5 * child.Value(1), 0.5 * child.Value(2),
 				(child.Size() > 3 ? child.Value(3) : 1.));
 			EnginePoint &engine = editPoints.back();
@@ -377,7 +467,7 @@ void Ship::Load(const DataNode &node)
 		{
 			if(!hasLeak)
 			{
-				leaks.clear();
+				EditChassis().leaks.clear();
 				hasLeak = true;
 			}
 			Leak leak(GameData::Effects().Get(child.Token(1)));
@@ -385,29 +475,29 @@ void Ship::Load(const DataNode &node)
 				leak.openPeriod = child.Value(2);
 			if(child.Size() >= 4)
 				leak.closePeriod = child.Value(3);
-			leaks.push_back(leak);
+			EditChassis().leaks.push_back(leak);
 		}
 		else if(key == "explode" && child.Size() >= 2)
 		{
 			if(!hasExplode)
 			{
-				explosionEffects.clear();
+				EditChassis().explosionEffects.clear();
 				explosionTotal = 0;
 				hasExplode = true;
 			}
 			int count = (child.Size() >= 3) ? child.Value(2) : 1;
-			explosionEffects[GameData::Effects().Get(child.Token(1))] += count;
+			EditChassis().explosionEffects[GameData::Effects().Get(child.Token(1))] += count;
 			explosionTotal += count;
 		}
 		else if(key == "final explode" && child.Size() >= 2)
 		{
 			if(!hasFinalExplode)
 			{
-				finalExplosions.clear();
+				EditChassis().finalExplosions.clear();
 				hasFinalExplode = true;
 			}
 			int count = (child.Size() >= 3) ? child.Value(2) : 1;
-			finalExplosions[GameData::Effects().Get(child.Token(1))] += count;
+			EditChassis().finalExplosions[GameData::Effects().Get(child.Token(1))] += count;
 		}
 		else if(key == "outfits")
 		{
@@ -452,11 +542,11 @@ void Ship::Load(const DataNode &node)
 		{
 			if(!hasDescription)
 			{
-				description.clear();
+				EditChassis().description.clear();
 				hasDescription = true;
 			}
-			description += child.Token(1);
-			description += '\n';
+			EditChassis().description += child.Token(1);
+			EditChassis().description += '\n';
 		}
 		else if(key != "actions")
 			child.PrintTrace("Skipping unrecognized attribute:");
@@ -493,27 +583,27 @@ void Ship::FinishLoading(bool isNewInstance)
 			reinterpret_cast<Body &>(*this) = *base;
 		if(customSwizzle == -1)
 			customSwizzle = base->CustomSwizzle();
-		if(baseAttributes.Attributes().empty())
-			baseAttributes = base->baseAttributes;
+		if(chassis->baseAttributes.Attributes().empty())
+			EditChassis().baseAttributes = base->chassis->baseAttributes;
 		if(bays.empty() && !base->bays.empty())
 			bays = base->bays;
-		if(enginePoints.empty())
-			enginePoints = base->enginePoints;
-		if(reverseEnginePoints.empty())
-			reverseEnginePoints = base->reverseEnginePoints;
-		if(steeringEnginePoints.empty())
-			steeringEnginePoints = base->steeringEnginePoints;
-		if(explosionEffects.empty())
-		{
-			explosionEffects = base->explosionEffects;
+		if(chassis->enginePoints.empty())
+			EditChassis().enginePoints = base->chassis->enginePoints;
+		if(chassis->reverseEnginePoints.empty())
+			EditChassis().reverseEnginePoints = base->chassis->reverseEnginePoints;
+		if(chassis->steeringEnginePoints.empty())
+			EditChassis().steeringEnginePoints = base->chassis->steeringEnginePoints;
+		if(chassis->explosionEffects.empty())
+		{
+			EditChassis().explosionEffects = base->chassis->explosionEffects;
 			explosionTotal = base->explosionTotal;
 		}
-		if(finalExplosions.empty())
-			finalExplosions = base->finalExplosions;
+		if(chassis->finalExplosions.empty())
+			EditChassis().finalExplosions = base->chassis->finalExplosions;
 		if(outfits.empty())
 			outfits = base->outfits;
-		if(description.empty())
-			description = base->description;
+		if(chassis->description.empty())
+			EditChassis().description = base->chassis->description;
 		
 		bool hasHardpoints = false;
 		for(const Hardpoint &hardpoint : armament.Get())
@@ -598,21 +688,25 @@ void Ship::FinishLoading(bool isNewInstance)
 	
 	// Mark any drone that has no "automaton" value as an automaton, to
 	// grandfather in the drones from before that attribute existed.
-	if(baseAttributes.Category() == "Drone" && !baseAttributes.Get("automaton"))
-		baseAttributes.Set("automaton", 1.);
+	if(chassis->baseAttributes.Category() == "Drone" && !chassis->baseAttributes.Get("automaton"))
+		EditChassis().baseAttributes.Set("automaton", 1.);
 	
-	baseAttributes.Set("gun ports", armament.GunCount());
-	baseAttributes.Set("turret mounts", armament.TurretCount());
+	// Only touch the chassis if these differ, so instances of a model that is
+	// already finished can keep sharing its chassis.
+	if(chassis->baseAttributes.Get("gun ports") != armament.GunCount())
+		EditChassis().baseAttributes.Set("gun ports", armament.GunCount());
+	if(chassis->baseAttributes.Get("turret mounts") != armament.TurretCount())
+		EditChassis().baseAttributes.Set("turret mounts", armament.TurretCount());
 	
 	if(addAttributes)
 	{
 		// Store attributes from an "add attributes" node in the ship's
 		// baseAttributes so they can be written to the save file.
-		baseAttributes.Add(attributes);
+		EditChassis().baseAttributes.Add(attributes);
 		addAttributes = false;
 	}
 	// Add the attributes of all your outfits to the ship's base attributes.
-	attributes = baseAttributes;
+	attributes = chassis->baseAttributes;
 	vector<string> undefinedOutfits;
 	for(const auto &it : outfits)
 	{
@@ -696,6 +790,13 @@ void Ship::FinishLoading(bool isNewInstance)
 	for(Bay &bay : bays)
 		if(bay.side == Bay::INSIDE && bay.launchEffects.empty() && Crew())
 			bay.launchEffects.emplace_back(GameData::Effects().Get("basic launch"));
+	bayCounts.clear();
+	for(const Bay &bay : bays)
+	{
+		BayCount &count = bayCounts[bay.category];
+		++count.total;
+		count.used += static_cast<bool>(bay.ship);
+	}
 	
 	canBeCarried = BAY_TYPES.count(attributes.Category()) > 0;
 	
@@ -713,6 +814,7 @@ void Ship::FinishLoading(bool isNewInstance)
 		warning += "Defaulting " + string(attributes.Get("drag") ? "invalid" : "missing") + " \"drag\" attribute to 100.0\n";
 		attributes.Set("drag", 100.);
 	}
+	UpdateDerivedAttributes();
 	if(!warning.empty())
 	{
 		// This check is mostly useful for variants and stock ships, which have
@@ -792,52 +894,52 @@ void Ship::Save(DataWriter &out) const
 		out.Write("attributes");
 		out.BeginChild();
 		{
-			out.Write("category", baseAttributes.Category());
-			out.Write("cost", baseAttributes.Cost());
-			out.Write("mass", baseAttributes.Mass());
-			for(const auto &it : baseAttributes.FlareSprites())
+			out.Write("category", chassis->baseAttributes.Category());
+			out.Write("cost", chassis->baseAttributes.Cost());
+			out.Write("mass", chassis->baseAttributes.Mass());
+			for(const auto &it : chassis->baseAttributes.FlareSprites())
 				for(int i = 0; i < it.second; ++i)
 					it.first.SaveSprite(out, "flare sprite");
-			for(const auto &it : baseAttributes.FlareSounds())
+			for(const auto &it : chassis->baseAttributes.FlareSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("flare sound", it.first->Name());
-			for(const auto &it : baseAttributes.ReverseFlareSprites())
+			for(const auto &it : chassis->baseAttributes.ReverseFlareSprites())
 				for(int i = 0; i < it.second; ++i)
 					it.first.SaveSprite(out, "reverse flare sprite");
-			for(const auto &it : baseAttributes.ReverseFlareSounds())
+			for(const auto &it : chassis->baseAttributes.ReverseFlareSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("reverse flare sound", it.first->Name());
-			for(const auto &it : baseAttributes.SteeringFlareSprites())
+			for(const auto &it : chassis->baseAttributes.SteeringFlareSprites())
 				for(int i = 0; i < it.second; ++i)
 					it.first.SaveSprite(out, "steering flare sprite");
-			for(const auto &it : baseAttributes.SteeringFlareSounds())
+			for(const auto &it : chassis->baseAttributes.SteeringFlareSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("steering flare sound", it.first->Name());
-			for(const auto &it : baseAttributes.AfterburnerEffects())
+			for(const auto &it : chassis->baseAttributes.AfterburnerEffects())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("afterburner effect", it.first->Name());
-			for(const auto &it : baseAttributes.JumpEffects())
+			for(const auto &it : chassis->baseAttributes.JumpEffects())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("jump effect", it.first->Name());
-			for(const auto &it : baseAttributes.JumpSounds())
+			for(const auto &it : chassis->baseAttributes.JumpSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("jump sound", it.first->Name());
-			for(const auto &it : baseAttributes.JumpInSounds())
+			for(const auto &it : chassis->baseAttributes.JumpInSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("jump in sound", it.first->Name());
-			for(const auto &it : baseAttributes.JumpOutSounds())
+			for(const auto &it : chassis->baseAttributes.JumpOutSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("jump out sound", it.first->Name());
-			for(const auto &it : baseAttributes.HyperSounds())
+			for(const auto &it : chassis->baseAttributes.HyperSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("hyperdrive sound", it.first->Name());
-			for(const auto &it : baseAttributes.HyperInSounds())
+			for(const auto &it : chassis->baseAttributes.HyperInSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("hyperdrive in sound", it.first->Name());
-			for(const auto &it : baseAttributes.HyperOutSounds())
+			for(const auto &it : chassis->baseAttributes.HyperOutSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("hyperdrive out sound", it.first->Name());
-			for(const auto &it : baseAttributes.Attributes())
+			for(const auto &it : chassis->baseAttributes.Attributes())
 				if(it.second)
 					out.Write(it.first, it.second);
 		}
@@ -866,7 +968,7 @@ void Ship::Save(DataWriter &out) const
 		out.Write("hull", hull);
 		out.Write("position", position.X(), position.Y());
 		
-		for(const EnginePoint &point : enginePoints)
+		for(const EnginePoint &point : chassis->enginePoints)
 		{
 			out.Write("engine", 2. * point.X(), 2. * point.Y());
 			out.BeginChild();
@@ -876,7 +978,7 @@ void Ship::Save(DataWriter &out) const
 			out.EndChild();
 				
 		}
-		for(const EnginePoint &point : reverseEnginePoints)
+		for(const EnginePoint &point : chassis->reverseEnginePoints)
 		{
 			out.Write("reverse engine", 2. * point.X(), 2. * point.Y());
 			out.BeginChild();
@@ -885,7 +987,7 @@ void Ship::Save(DataWriter &out) const
 			out.Write(ENGINE_SIDE[point.side]);
 			out.EndChild();
 		}
-		for(const EnginePoint &point : steeringEnginePoints)
+		for(const EnginePoint &point : chassis->steeringEnginePoints)
 		{
 			out.Write("steering engine", 2. * point.X(), 2. * point.Y());
 			out.BeginChild();
@@ -937,18 +1039,18 @@ void Ship::Save(DataWriter &out) const
 				out.EndChild();
 			}
 		}
-		for(const Leak &leak : leaks)
+		for(const Leak &leak : chassis->leaks)
 			out.Write("leak", leak.effect->Name(), leak.openPeriod, leak.closePeriod);
 		
 		using EffectElement = pair<const Effect *const, int>;
 		auto effectSort = [](const EffectElement *lhs, const EffectElement *rhs)
 			{ return lhs->first->Name() < rhs->first->Name(); };
-		WriteSorted(explosionEffects, effectSort, [&out](const EffectElement &it)
+		WriteSorted(chassis->explosionEffects, effectSort, [&out](const EffectElement &it)
 		{
 			if(it.second)
 				out.Write("explode", it.first->Name(), it.second);
 		});
-		WriteSorted(finalExplosions, effectSort, [&out](const EffectElement &it)
+		WriteSorted(chassis->finalExplosions, effectSort, [&out](const EffectElement &it)
 		{
 			if(it.second)
 				out.Write("final explode", it.first->Name(), it.second);
@@ -1024,7 +1126,7 @@ const string &Ship::Noun() const
 // Get this ship's description.
 const string &Ship::Description() const
 {
-	return description;
+	return chassis->description;
 }
 
 
@@ -1048,16 +1150,30 @@ int64_t Ship::Cost() const
 // Get the cost of this ship's chassis, with no outfits installed.
 int64_t Ship::ChassisCost() const
 {
-	return baseAttributes.Cost();
+	return chassis->baseAttributes.Cost();
 }
 
 
 
 // Check if this ship is configured in such a way that it would be difficult
 // or impossible to fly.
-vector<string> Ship::FlightCheck() const
-{
-	auto checks = vector<string>{};
+const vector<string> &Ship::FlightCheck() const
+{
+	// Besides the attributes and outfits, the checks depend on the mass of any
+	// cargo (through the maximum heat), on whether this ship can be carried,
+	// and on whether it is currently in a bay (through the jump fuel).
+	int cargoUsed = cargo.Used();
+	bool inSystem = (currentSystem != nullptr);
+	if(hasFlightChecks && flightCheckCargo == cargoUsed && flightCheckCarried == canBeCarried
+			&& flightCheckInSystem == inSystem)
+		return flightChecks;
+	
+	hasFlightChecks = true;
+	flightCheckCargo = cargoUsed;
+	flightCheckCarried = canBeCarried;
+	flightCheckInSystem = inSystem;
+	auto &checks = flightChecks;
+	checks.clear();
 	
 	double generation = attributes.Get("energy generation") - attributes.Get("energy consumption");
 	double burning = attributes.Get("fuel energy");
@@ -1312,10 +1428,10 @@ const Command &Ship::Commands() const
 
 
 
-// Move this ship. A ship may create effects as it moves, in particular if
-// it is in the process of blowing up. If this returns false, the ship
-// should be deleted.
-void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
+// Update the parts of this ship's state that do not depend on any other ship.
+// Because this does not draw any random numbers or touch any shared state, the
+// engine is free to run this for all its ships at once.
+void Ship::PrepareMove()
 {
 	// Check if this ship has been in a different system from the player for so
 	// long that it should be "forgotten." Also eliminate ships that have no
@@ -1331,30 +1447,11 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 		return;
 	}
 	isInSystem = false;
-	if(!fuel || !(attributes.Get("hyperdrive") || attributes.Get("jump drive")))
+	if(!fuel || !(attributes.Get(HYPERDRIVE) || attributes.Get(JUMP_DRIVE)))
 		hyperspaceSystem = nullptr;
 	
-	// Adjust the error in the pilot's targeting.
-	personality.UpdateConfusion(commands.IsFiring());
-	
 	// Generate energy, heat, etc.
 	DoGeneration();
-
-	// Handle ionization effects, etc.
-	if(ionization)
-		CreateSparks(visuals, "ion spark", ionization * .1);
-	if(disruption)
-		CreateSparks(visuals, "disruption spark", disruption * .1);
-	if(slowness)
-		CreateSparks(visuals, "slowing spark", slowness * .1);
-	// Jettisoned cargo effects (only for ships in the current system).
-	if(!jettisoned.empty() && !forget)
-	{
-		jettisoned.front()->Place(*this);
-		flotsam.splice(flotsam.end(), jettisoned, jettisoned.begin());
-	}
-	int requiredCrew = RequiredCrew();
-	double slowMultiplier = 1. / (1. + slowness * .05);
 	
 	// Move the turrets.
 	if(!isDisabled)
@@ -1367,16 +1464,16 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 		if(!cloak)
 			cloakDisruption = max(0., cloakDisruption - 1.);
 		
-		double cloakingSpeed = attributes.Get("cloak");
+		double cloakingSpeed = attributes.Get(CLOAK);
 		bool canCloak = (!isDisabled && cloakingSpeed > 0. && !cloakDisruption
-			&& fuel >= attributes.Get("cloaking fuel")
-			&& energy >= attributes.Get("cloaking energy"));
+			&& fuel >= attributes.Get(CLOAKING_FUEL)
+			&& energy >= attributes.Get(CLOAKING_ENERGY));
 		if(commands.Has(Command::CLOAK) && canCloak)
 		{
 			cloak = min(1., cloak + cloakingSpeed);
-			fuel -= attributes.Get("cloaking fuel");
-			energy -= attributes.Get("cloaking energy");
-			heat += attributes.Get("cloaking heat");
+			fuel -= attributes.Get(CLOAKING_FUEL);
+			energy -= attributes.Get(CLOAKING_ENERGY);
+			heat += attributes.Get(CLOAKING_HEAT);
 		}
 		else if(cloakingSpeed)
 		{
@@ -1390,6 +1487,37 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 		else
 			cloak = 0.;
 	}
+}
+
+
+
+// Move this ship. A ship may create effects as it moves, in particular if
+// it is in the process of blowing up. If this returns false, the ship
+// should be deleted.
+void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
+{
+	// Ships that PrepareMove() decided to forget do nothing more.
+	if(ShouldBeRemoved())
+		return;
+	
+	// Adjust the error in the pilot's targeting.
+	personality.UpdateConfusion(commands.IsFiring());
+	
+	// Handle ionization effects, etc.
+	if(ionization)
+		CreateSparks(visuals, "ion spark", ionization * .1);
+	if(disruption)
+		CreateSparks(visuals, "disruption spark", disruption * .1);
+	if(slowness)
+		CreateSparks(visuals, "slowing spark", slowness * .1);
+	// Jettisoned cargo effects (only for ships in the current system).
+	if(!jettisoned.empty() && !forget)
+	{
+		jettisoned.front()->Place(*this);
+		flotsam.splice(flotsam.end(), jettisoned, jettisoned.begin());
+	}
+	int requiredCrew = RequiredCrew();
+	double slowMultiplier = 1. / (1. + slowness * .05);
 	
 	if(IsDestroyed())
 	{
@@ -1408,7 +1536,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				int debrisCount = attributes.Mass() * .07;
 				
 				// Estimate how many new visuals will be added during destruction.
-				visuals.reserve(visuals.size() + debrisCount + explosionTotal + finalExplosions.size());
+				visuals.reserve(visuals.size() + debrisCount + explosionTotal + chassis->finalExplosions.size());
 				
 				for(int i = 0; i < debrisCount; ++i)
 				{
@@ -1421,7 +1549,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				
 				for(unsigned i = 0; i < explosionTotal / 2; ++i)
 					CreateExplosion(visuals, true);
-				for(const auto &it : finalExplosions)
+				for(const auto &it : chassis->finalExplosions)
 					visuals.emplace_back(*it.first, position, velocity, angle);
 				// For everything in this ship's cargo hold there is a 25% chance
 				// that it will survive as flotsam.
@@ -1458,18 +1586,20 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 			CreateExplosion(visuals);
 		
 		// Handle hull "leaks."
-		for(const Leak &leak : leaks)
+		for(const Leak &leak : chassis->leaks)
 			if(leak.openPeriod > 0 && !Random::Int(leak.openPeriod))
 			{
 				activeLeaks.push_back(leak);
-				const vector<Point> &outline = GetMask().Points();
+				const vector<Float2> &outline = GetMask().Points();
 				if(outline.size() < 2)
 					break;
 				int i = Random::Int(outline.size() - 1);
 				
 				// Position the leak along the outline of the ship, facing outward.
-				activeLeaks.back().location = (outline[i] + outline[i + 1]) * .5;
-				activeLeaks.back().angle = Angle(outline[i] - outline[i + 1]) + Angle(90.);
+				Point first(outline[i]);
+				Point second(outline[i + 1]);
+				activeLeaks.back().location = (first + second) * .5;
+				activeLeaks.back().angle = Angle(first - second) + Angle(90.);
 			}
 		for(Leak &leak : activeLeaks)
 			if(leak.effect)
@@ -1504,7 +1634,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 		if(isUsingJumpDrive && !forget)
 		{
 			double sparkAmount = hyperspaceCount * Width() * Height() * .000006;
-			const map<const Effect *, int> &jumpEffects = attributes.JumpEffects();
+			const FlatMap<const Effect *, int> &jumpEffects = attributes.JumpEffects();
 			if(jumpEffects.empty())
 				CreateSparks(visuals, "jump drive", sparkAmount);
 			else
@@ -1658,7 +1788,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 			}
 		}
 		// Only refuel if this planet has a spaceport.
-		else if(fuel >= attributes.Get("fuel capacity")
+		else if(fuel >= attributes.Get(FUEL_CAPACITY)
 				|| !landingPlanet || !landingPlanet->HasSpaceport())
 		{
 			zoom = min(1.f, zoom + .02f);
@@ -1666,7 +1796,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 			landingPlanet = nullptr;
 		}
 		else
-			fuel = min(fuel + 1., attributes.Get("fuel capacity"));
+			fuel = min(fuel + 1., attributes.Get(FUEL_CAPACITY));
 		
 		// Move the ship at the velocity it had when it began landing, but
 		// scaled based on how small it is now.
@@ -1684,7 +1814,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 	else if(commands.Has(Command::JUMP) && IsReadyToJump())
 	{
 		hyperspaceSystem = GetTargetSystem();
-		isUsingJumpDrive = !attributes.Get("hyperdrive") || !currentSystem->Links().count(hyperspaceSystem);
+		isUsingJumpDrive = !attributes.Get(HYPERDRIVE) || !currentSystem->Links().count(hyperspaceSystem);
 		hyperspaceFuelCost = JumpFuel(hyperspaceSystem);
 	}
 	
@@ -1712,13 +1842,13 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 	double mass = Mass();
 	bool isUsingAfterburner = false;
 	if(isDisabled)
-		velocity *= 1. - attributes.Get("drag") / mass;
+		velocity *= 1. - attributes.Get(DRAG) / mass;
 	else if(!pilotError)
 	{
 		if(commands.Turn())
 		{
 			// Check if we are able to turn.
-			double cost = attributes.Get("turning energy");
+			double cost = attributes.Get(TURNING_ENERGY);
 			if(energy < cost * fabs(commands.Turn()))
 				commands.SetTurn(commands.Turn() * energy / (cost * fabs(commands.Turn())));
 			
@@ -1731,7 +1861,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				// of the turning energy and produce a fraction of the heat.
 				double scale = fabs(commands.Turn());
 				energy -= scale * cost;
-				heat += scale * attributes.Get("turning heat");
+				heat += scale * attributes.Get(TURNING_HEAT);
 				angle += commands.Turn() * TurnRate() * slowMultiplier;
 			}
 		}
@@ -1750,7 +1880,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				// If a reverse thrust is commanded and the capability does not
 				// exist, ignore it (do not even slow under drag).
 				isThrusting = (thrustCommand > 0.);
-				isReversing = !isThrusting && attributes.Get("reverse thrust");
+				isReversing = !isThrusting && attributes.Get(REVERSE_THRUST);
 				thrust = attributes.Get(isThrusting ? "thrust" : "reverse thrust");
 				if(thrust)
 				{
@@ -1765,12 +1895,12 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				&& !CannotAct();
 		if(applyAfterburner)
 		{
-			thrust = attributes.Get("afterburner thrust");
-			double fuelCost = attributes.Get("afterburner fuel");
-			double energyCost = attributes.Get("afterburner energy");
+			thrust = attributes.Get(AFTERBURNER_THRUST);
+			double fuelCost = attributes.Get(AFTERBURNER_FUEL);
+			double energyCost = attributes.Get(AFTERBURNER_ENERGY);
 			if(thrust && fuel >= fuelCost && energy >= energyCost)
 			{
-				heat += attributes.Get("afterburner heat");
+				heat += attributes.Get(AFTERBURNER_HEAT);
 				fuel -= fuelCost;
 				energy -= energyCost;
 				acceleration += angle.Unit() * thrust / mass;
@@ -1783,7 +1913,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 	if(acceleration)
 	{
 		acceleration *= slowMultiplier;
-		Point dragAcceleration = acceleration - velocity * (attributes.Get("drag") / mass);
+		Point dragAcceleration = acceleration - velocity * (attributes.Get(DRAG) / mass);
 		// Make sure dragAcceleration has nonzero length, to avoid divide by zero.
 		if(dragAcceleration)
 		{
@@ -1886,7 +2016,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 	// Finally, move the ship and create any movement visuals.
 	position += velocity;
 	if(isUsingAfterburner && !Attributes().AfterburnerEffects().empty())
-		for(const EnginePoint &point : enginePoints)
+		for(const EnginePoint &point : chassis->enginePoints)
 		{
 			Point pos = angle.Rotate(point) * Zoom() + position;
 			// Stream the afterburner effects outward in the direction the engines are facing.
@@ -1899,17 +2029,28 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 
 
 
-// Generate energy, heat, etc. (This is called by Move().)
+// Generate energy, heat, etc. (This is called by PrepareMove().)
 void Ship::DoGeneration()
 {
 	// First, allow any carried ships to do their own generation.
+	bool isCarrying = false;
 	for(const Bay &bay : bays)
 		if(bay.ship)
+		{
 			bay.ship->DoGeneration();
+			isCarrying = true;
+		}
+	
+	// A ship that is fully repaired, is not waiting to start repairs, and is not
+	// carrying any ships that may need repairs or energy has nothing to do here,
+	// so most ships skip this part most of the time.
+	const double maxShields = attributes.Get(SHIELDS);
+	const double maxHull = attributes.Get(HULL);
+	const bool needsRepair = isCarrying || hullDelay || shieldDelay || hull < maxHull || shields < maxShields;
 	
 	// Shield and hull recharge. This uses whatever energy is left over from the
 	// previous frame, so that it will not steal energy from movement, etc.
-	if(!isDisabled)
+	if(!isDisabled && needsRepair)
 	{
 		// Priority of repairs:
 		// 1. Ship's own hull
@@ -1918,21 +2059,21 @@ void Ship::DoGeneration()
 		// 4. Shields of carried fighters
 		// 5. Transfer of excess energy and fuel to carried fighters.
 		
-		const double hullAvailable = attributes.Get("hull repair rate") * (1. + attributes.Get("hull repair multiplier"));
-		const double hullEnergy = (attributes.Get("hull energy") * (1. + attributes.Get("hull energy multiplier"))) / hullAvailable;
-		const double hullFuel = (attributes.Get("hull fuel") * (1. + attributes.Get("hull fuel multiplier"))) / hullAvailable;
-		const double hullHeat = (attributes.Get("hull heat") * (1. + attributes.Get("hull heat multiplier"))) / hullAvailable;
+		const double hullAvailable = attributes.Get(HULL_REPAIR_RATE) * (1. + attributes.Get(HULL_REPAIR_MULTIPLIER));
+		const double hullEnergy = (attributes.Get(HULL_ENERGY) * (1. + attributes.Get(HULL_ENERGY_MULTIPLIER))) / hullAvailable;
+		const double hullFuel = (attributes.Get(HULL_FUEL) * (1. + attributes.Get(HULL_FUEL_MULTIPLIER))) / hullAvailable;
+		const double hullHeat = (attributes.Get(HULL_HEAT) * (1. + attributes.Get(HULL_HEAT_MULTIPLIER))) / hullAvailable;
 		double hullRemaining = hullAvailable;
 		if(!hullDelay)
-			DoRepair(hull, hullRemaining, attributes.Get("hull"), energy, hullEnergy, fuel, hullFuel, heat, hullHeat);
+			DoRepair(hull, hullRemaining, maxHull, energy, hullEnergy, fuel, hullFuel, heat, hullHeat);
 		
-		const double shieldsAvailable = attributes.Get("shield generation") * (1. + attributes.Get("shield generation multiplier"));
-		const double shieldsEnergy = (attributes.Get("shield energy") * (1. + attributes.Get("shield energy multiplier"))) / shieldsAvailable;
-		const double shieldsFuel = (attributes.Get("shield fuel") * (1. + attributes.Get("shield fuel multiplier"))) / shieldsAvailable;
-		const double shieldsHeat = (attributes.Get("shield heat") * (1. + attributes.Get("shield heat multiplier"))) / shieldsAvailable;
+		const double shieldsAvailable = attributes.Get(SHIELD_GENERATION) * (1. + attributes.Get(SHIELD_GENERATION_MULTIPLIER));
+		const double shieldsEnergy = (attributes.Get(SHIELD_ENERGY) * (1. + attributes.Get(SHIELD_ENERGY_MULTIPLIER))) / shieldsAvailable;
+		const double shieldsFuel = (attributes.Get(SHIELD_FUEL) * (1. + attributes.Get(SHIELD_FUEL_MULTIPLIER))) / shieldsAvailable;
+		const double shieldsHeat = (attributes.Get(SHIELD_HEAT) * (1. + attributes.Get(SHIELD_HEAT_MULTIPLIER))) / shieldsAvailable;
 		double shieldsRemaining = shieldsAvailable;
 		if(!shieldDelay)
-			DoRepair(shields, shieldsRemaining, attributes.Get("shields"), energy, shieldsEnergy, fuel, shieldsFuel, heat, shieldsHeat);
+			DoRepair(shields, shieldsRemaining, maxShields, energy, shieldsEnergy, fuel, shieldsFuel, heat, shieldsHeat);
 		
 		if(!bays.empty())
 		{
@@ -1963,8 +2104,8 @@ void Ship::DoGeneration()
 			
 			// Now that there is no more need to use energy for hull and shield
 			// repair, if there is still excess energy, transfer it.
-			double energyRemaining = min(0., energy - attributes.Get("energy capacity"));
-			double fuelRemaining = min(0., fuel - attributes.Get("fuel capacity"));
+			double energyRemaining = min(0., energy - attributes.Get(ENERGY_CAPACITY));
+			double fuelRemaining = min(0., fuel - attributes.Get(FUEL_CAPACITY));
 			for(const pair<double, Ship *> &it : carried)
 			{
 				Ship &ship = *it.second;
@@ -1982,28 +2123,28 @@ void Ship::DoGeneration()
 	// TODO: Mothership gives status resistance to carried ships?
 	if(ionization)
 	{
-		double ionResistance = attributes.Get("ion resistance");
-		double ionEnergy = attributes.Get("ion resistance energy") / ionResistance;
-		double ionFuel = attributes.Get("ion resistance fuel") / ionResistance;
-		double ionHeat = attributes.Get("ion resistance heat") / ionResistance;
+		double ionResistance = attributes.Get(ION_RESISTANCE);
+		double ionEnergy = attributes.Get(ION_RESISTANCE_ENERGY) / ionResistance;
+		double ionFuel = attributes.Get(ION_RESISTANCE_FUEL) / ionResistance;
+		double ionHeat = attributes.Get(ION_RESISTANCE_HEAT) / ionResistance;
 		DoStatusEffect(isDisabled, ionization, ionResistance, energy, ionEnergy, fuel, ionFuel, heat, ionHeat);
 	}
 	
 	if(disruption)
 	{
-		double disruptionResistance = attributes.Get("disruption resistance");
-		double disruptionEnergy = attributes.Get("disruption resistance energy") / disruptionResistance;
-		double disruptionFuel = attributes.Get("disruption resistance fuel") / disruptionResistance;
-		double disruptionHeat = attributes.Get("disruption resistance heat") / disruptionResistance;
+		double disruptionResistance = attributes.Get(DISRUPTION_RESISTANCE);
+		double disruptionEnergy = attributes.Get(DISRUPTION_RESISTANCE_ENERGY) / disruptionResistance;
+		double disruptionFuel = attributes.Get(DISRUPTION_RESISTANCE_FUEL) / disruptionResistance;
+		double disruptionHeat = attributes.Get(DISRUPTION_RESISTANCE_HEAT) / disruptionResistance;
 		DoStatusEffect(isDisabled, disruption, disruptionResistance, energy, disruptionEnergy, fuel, disruptionFuel, heat, disruptionHeat);
 	}
 	
 	if(slowness)
 	{
-		double slowingResistance = attributes.Get("slowing resistance");
-		double slowingEnergy = attributes.Get("slowing resistance energy") / slowingResistance;
-		double slowingFuel = attributes.Get("slowing resistance fuel") / slowingResistance;
-		double slowingHeat = attributes.Get("slowing resistance heat") / slowingResistance;
+		double slowingResistance = attributes.Get(SLOWING_RESISTANCE);
+		double slowingEnergy = attributes.Get(SLOWING_RESISTANCE_ENERGY) / slowingResistance;
+		double slowingFuel = attributes.Get(SLOWING_RESISTANCE_FUEL) / slowingResistance;
+		double slowingHeat = attributes.Get(SLOWING_RESISTANCE_HEAT) / slowingResistance;
 		DoStatusEffect(isDisabled, slowness, slowingResistance, energy, slowingEnergy, fuel, slowingFuel, heat, slowingHeat);
 	}
 	
@@ -2011,8 +2152,8 @@ void Ship::DoGeneration()
 	// maximum capacity for the rest of the turn, but must be clamped to the
 	// maximum here before they gain more. This is so that, for example, a ship
 	// with no batteries but a good generator can still move.
-	energy = min(energy, attributes.Get("energy capacity"));
-	fuel = min(fuel, attributes.Get("fuel capacity"));
+	energy = min(energy, attributes.Get(ENERGY_CAPACITY));
+	fuel = min(fuel, attributes.Get(FUEL_CAPACITY));
 	
 	heat -= heat * HeatDissipation();
 	if(heat > MaximumHeat())
@@ -2020,9 +2161,7 @@ void Ship::DoGeneration()
 	else if(heat < .9 * MaximumHeat())
 		isOverheated = false;
 	
-	double maxShields = attributes.Get("shields");
 	shields = min(shields, maxShields);
-	double maxHull = attributes.Get("hull");
 	hull = min(hull, maxHull);
 	
 	isDisabled = isOverheated || hull < MinimumHull() || (!crew && RequiredCrew());
@@ -2048,35 +2187,35 @@ void Ship::DoGeneration()
 		if(currentSystem)
 		{
 			double scale = .2 + 1.8 / (.001 * position.Length() + 1);
-			fuel += currentSystem->SolarWind() * .03 * scale * (sqrt(attributes.Get("ramscoop")) + .05 * scale);
+			fuel += currentSystem->SolarWind() * .03 * scale * (sqrt(attributes.Get(RAMSCOOP)) + .05 * scale);
 			
 			double solarScaling = currentSystem->SolarPower() * scale;
-			energy += solarScaling * attributes.Get("solar collection");
-			heat += solarScaling * attributes.Get("solar heat");
+			energy += solarScaling * attributes.Get(SOLAR_COLLECTION);
+			heat += solarScaling * attributes.Get(SOLAR_HEAT);
 		}
 		
 		double coolingEfficiency = CoolingEfficiency();
-		energy += attributes.Get("energy generation") - attributes.Get("energy consumption");
-		fuel += attributes.Get("fuel generation");
-		heat += attributes.Get("heat generation");
-		heat -= coolingEfficiency * attributes.Get("cooling");
+		energy += attributes.Get(ENERGY_GENERATION) - attributes.Get(ENERGY_CONSUMPTION);
+		fuel += attributes.Get(FUEL_GENERATION);
+		heat += attributes.Get(HEAT_GENERATION);
+		heat -= coolingEfficiency * attributes.Get(COOLING);
 		
 		// Convert fuel into energy and heat only when the required amount of fuel is available.
-		if(attributes.Get("fuel consumption") <= fuel)
+		if(attributes.Get(FUEL_CONSUMPTION) <= fuel)
 		{	
-			fuel -= attributes.Get("fuel consumption");
-			energy += attributes.Get("fuel energy");
-			heat += attributes.Get("fuel heat");
+			fuel -= attributes.Get(FUEL_CONSUMPTION);
+			energy += attributes.Get(FUEL_ENERGY);
+			heat += attributes.Get(FUEL_HEAT);
 		}
 		
 		// Apply active cooling. The fraction of full cooling to apply equals
 		// your ship's current fraction of its maximum temperature.
-		double activeCooling = coolingEfficiency * attributes.Get("active cooling");
+		double activeCooling = coolingEfficiency * attributes.Get(ACTIVE_COOLING);
 		if(activeCooling > 0. && heat > 0. && energy >= 0.)
 		{
 			// Although it's a misuse of this feature, handle the case where
 			// "active cooling" does not require any energy.
-			double coolingEnergy = attributes.Get("cooling energy");
+			double coolingEnergy = attributes.Get(COOLING_ENERGY);
 			if(coolingEnergy)
 			{
 				double spentEnergy = min(energy, coolingEnergy * min(1., Heat()));
@@ -2147,6 +2286,7 @@ void Ship::Launch(list<shared_ptr<Ship>> &ships, vector<Visual> &visuals)
 			bay.ship->UnmarkForRemoval();
 			// Update the cached sum of carried ship masses.
 			carriedMass -= bay.ship->Mass();
+			--bayCounts[bay.category].used;
 			// Create the desired launch effects.
 			for(const Effect *effect : bay.launchEffects)
 				visuals.emplace_back(*effect, exitPoint, velocity, launchAngle);
@@ -2376,6 +2516,15 @@ bool Ship::FireAntiMissile(const Projectile &projectile, vector<Visual> &visuals
 
 
 
+// Get the farthest that any of the anti-missiles that were ready to fire in
+// this step can reach.
+double Ship::AntiMissileRange() const
+{
+	return antiMissileRange;
+}
+
+
+
 const System *Ship::GetSystem() const
 {
 	return currentSystem;
@@ -2505,8 +2654,8 @@ bool Ship::IsReadyToJump(bool waitingIsReady) const
 		return false;
 	
 	Point direction = targetSystem->Position() - currentSystem->Position();
-	bool isJump = !attributes.Get("hyperdrive") || !currentSystem->Links().count(targetSystem);
-	double scramThreshold = attributes.Get("scram drive");
+	bool isJump = !attributes.Get(HYPERDRIVE) || !currentSystem->Links().count(targetSystem);
+	double scramThreshold = attributes.Get(SCRAM_DRIVE);
 	
 	// The ship can only enter hyperspace if it is traveling slowly enough
 	// and pointed in the right direction.
@@ -2516,7 +2665,7 @@ bool Ship::IsReadyToJump(bool waitingIsReady) const
 		if(deviation > scramThreshold)
 			return false;
 	}
-	else if(velocity.Length() > attributes.Get("jump speed"))
+	else if(velocity.Length() > attributes.Get(JUMP_SPEED))
 		return false;
 	
 	if(!isJump)
@@ -2574,21 +2723,21 @@ double Ship::SteeringDirection() const
 // Get the points from which engine flares should be drawn.
 const vector<Ship::EnginePoint> &Ship::EnginePoints() const
 {
-	return enginePoints;
+	return chassis->enginePoints;
 }
 
 
 
 const vector<Ship::EnginePoint> &Ship::ReverseEnginePoints() const
 {
-	return reverseEnginePoints;
+	return chassis->reverseEnginePoints;
 }
 
 
 
 const vector<Ship::EnginePoint> &Ship::SteeringEnginePoints() const
 {
-	return steeringEnginePoints;
+	return chassis->steeringEnginePoints;
 }
 
 
@@ -2754,7 +2903,7 @@ void Ship::WasCaptured(const shared_ptr<Ship> &capturer)
 // Get characteristics of this ship, as a fraction between 0 and 1.
 double Ship::Shields() const
 {
-	double maximum = attributes.Get("shields");
+	double maximum = attributes.Get(SHIELDS);
 	return maximum ? min(1., shields / maximum) : 0.;
 }
 
@@ -2762,7 +2911,7 @@ double Ship::Shields() const
 
 double Ship::Hull() const
 {
-	double maximum = attributes.Get("hull");
+	double maximum = attributes.Get(HULL);
 	return maximum ? min(1., hull / maximum) : 1.;
 }
 
@@ -2770,7 +2919,7 @@ double Ship::Hull() const
 
 double Ship::Fuel() const
 {
-	double maximum = attributes.Get("fuel capacity");
+	double maximum = attributes.Get(FUEL_CAPACITY);
 	return maximum ? min(1., fuel / maximum) : 0.;
 }
 
@@ -2778,7 +2927,7 @@ double Ship::Fuel() const
 
 double Ship::Energy() const
 {
-	double maximum = attributes.Get("energy capacity");
+	double maximum = attributes.Get(ENERGY_CAPACITY);
 	return maximum ? min(1., energy / maximum) : (hull > 0.) ? 1. : 0.;
 }
 
@@ -2798,8 +2947,8 @@ double Ship::Heat() const
 double Ship::Health() const
 {
 	double minimumHull = MinimumHull();
-	double hullDivisor = attributes.Get("hull") - minimumHull;
-	double divisor = attributes.Get("shields") + hullDivisor;
+	double hullDivisor = attributes.Get(HULL) - minimumHull;
+	double divisor = attributes.Get(SHIELDS) + hullDivisor;
 	// This should not happen, but just in case.
 	if(divisor <= 0. || hullDivisor <= 0.)
 		return 0.;
@@ -2814,7 +2963,7 @@ double Ship::Health() const
 // Get the hull fraction at which this ship is disabled.
 double Ship::DisabledHull() const
 {
-	double hull = attributes.Get("hull");
+	double hull = attributes.Get(HULL);
 	double minimumHull = MinimumHull();
 	
 	return (hull > 0. ? minimumHull / hull : 0.);
@@ -2854,10 +3003,10 @@ double Ship::JumpFuel(const System *destination) const
 	
 	bool linked = currentSystem->Links().count(destination);
 	// Figure out what sort of jump we're making.
-	if(attributes.Get("hyperdrive") && linked)
+	if(attributes.Get(HYPERDRIVE) && linked)
 		return HyperdriveFuel();
 	
-	if(attributes.Get("jump drive") && currentSystem->JumpNeighbors(JumpRange()).count(destination))
+	if(attributes.Get(JUMP_DRIVE) && currentSystem->JumpNeighbors(JumpRange()).count(destination))
 		return JumpDriveFuel((linked || currentSystem->JumpRange()) ? 0. : currentSystem->Position().Distance(destination->Position()));
 	
 	// If the given system is not a possible destination, return 0.
@@ -2872,15 +3021,15 @@ double Ship::JumpRange(bool getCached) const
 		return jumpRange;
 	
 	// Ships without a jump drive have no jump range.
-	if(!attributes.Get("jump drive"))
+	if(!attributes.Get(JUMP_DRIVE))
 		return 0.;
 	
 	// Find the outfit that provides the farthest jump range.
 	double best = 0.;
 	// Make it possible for the jump range to be integrated into a ship.
-	if(baseAttributes.Get("jump drive"))
+	if(chassis->baseAttributes.Get("jump drive"))
 	{
-		best = baseAttributes.Get("jump range");
+		best = chassis->baseAttributes.Get("jump range");
 		if(!best)
 			best = System::DEFAULT_NEIGHBOR_DISTANCE;
 	}
@@ -2903,10 +3052,10 @@ double Ship::JumpRange(bool getCached) const
 double Ship::HyperdriveFuel() const
 {
 	// Don't bother searching through the outfits if there is no hyperdrive.
-	if(!attributes.Get("hyperdrive"))
+	if(!attributes.Get(HYPERDRIVE))
 		return JumpDriveFuel();
 	
-	if(attributes.Get("scram drive"))
+	if(attributes.Get(SCRAM_DRIVE))
 		return BestFuel("hyperdrive", "scram drive", 150.);
 	
 	return BestFuel("hyperdrive", "", 100.);
@@ -2917,7 +3066,7 @@ double Ship::HyperdriveFuel() const
 double Ship::JumpDriveFuel(double jumpDistance) const
 {
 	// Don't bother searching through the outfits if there is no jump drive.
-	if(!attributes.Get("jump drive"))
+	if(!attributes.Get(JUMP_DRIVE))
 		return 0.;
 	
 	return BestFuel("jump drive", "", 200., jumpDistance);
@@ -2930,7 +3079,7 @@ double Ship::JumpFuelMissing() const
 	// Used for smart refueling: transfer only as much as really needed
 	// includes checking if fuel cap is high enough at all
 	double jumpFuel = JumpFuel(targetSystem);
-	if(!jumpFuel || fuel > jumpFuel || jumpFuel > attributes.Get("fuel capacity"))
+	if(!jumpFuel || fuel > jumpFuel || jumpFuel > attributes.Get(FUEL_CAPACITY))
 		return 0.;
 	
 	return jumpFuel - fuel;
@@ -2943,14 +3092,14 @@ double Ship::IdleHeat() const
 {
 	// This ship's cooling ability:
 	double coolingEfficiency = CoolingEfficiency();
-	double cooling = coolingEfficiency * attributes.Get("cooling");
-	double activeCooling = coolingEfficiency * attributes.Get("active cooling");
+	double cooling = coolingEfficiency * attributes.Get(COOLING);
+	double activeCooling = coolingEfficiency * attributes.Get(ACTIVE_COOLING);
 	
 	// Idle heat is the heat level where:
 	// heat = heat * diss + heatGen - cool - activeCool * heat / (100 * mass)
 	// heat = heat * (diss - activeCool / (100 * mass)) + (heatGen - cool)
 	// heat * (1 - diss + activeCool / (100 * mass)) = (heatGen - cool)
-	double production = max(0., attributes.Get("heat generation") - cooling);
+	double production = max(0., attributes.Get(HEAT_GENERATION) - cooling);
 	double dissipation = HeatDissipation() + activeCooling / MaximumHeat();
 	if(!dissipation) return production ? numeric_limits<double>::max() : 0;
 	return production / dissipation;
@@ -2961,7 +3110,7 @@ double Ship::IdleHeat() const
 // Get the heat dissipation, in heat units per heat unit per frame.
 double Ship::HeatDissipation() const
 {
-	return .001 * attributes.Get("heat dissipation");
+	return .001 * attributes.Get(HEAT_DISSIPATION);
 }
 
 
@@ -2977,11 +3126,7 @@ double Ship::MaximumHeat() const
 // Calculate the multiplier for cooling efficiency.
 double Ship::CoolingEfficiency() const
 {
-	// This is an S-curve where the efficiency is 100% if you have no outfits
-	// that create "cooling inefficiency", and as that value increases the
-	// efficiency stays high for a while, then drops off, then approaches 0.
-	double x = attributes.Get("cooling inefficiency");
-	return 2. + 2. / (1. + exp(x / -2.)) - 4. / (1. + exp(x / -4.));
+	return coolingEfficiency;
 }
 
 
@@ -2995,11 +3140,11 @@ int Ship::Crew() const
 
 int Ship::RequiredCrew() const
 {
-	if(attributes.Get("automaton"))
+	if(attributes.Get(AUTOMATON))
 		return 0;
 	
 	// Drones do not need crew, but all other ships need at least one.
-	return max<int>(1, attributes.Get("required crew"));
+	return max<int>(1, attributes.Get(REQUIRED_CREW));
 }
 
 
@@ -3028,33 +3173,29 @@ double Ship::Mass() const
 
 double Ship::TurnRate() const
 {
-	return attributes.Get("turn") / Mass();
+	return attributes.Get(TURN) / Mass();
 }
 
 
 
 double Ship::Acceleration() const
 {
-	double thrust = attributes.Get("thrust");
-	return (thrust ? thrust : attributes.Get("afterburner thrust")) / Mass();
+	double thrust = attributes.Get(THRUST);
+	return (thrust ? thrust : attributes.Get(AFTERBURNER_THRUST)) / Mass();
 }
 
 
 
 double Ship::MaxVelocity() const
 {
-	// v * drag / mass == thrust / mass
-	// v * drag == thrust
-	// v = thrust / drag
-	double thrust = attributes.Get("thrust");
-	return (thrust ? thrust : attributes.Get("afterburner thrust")) / attributes.Get("drag");
+	return maxVelocity;
 }
 
 
 
 double Ship::MaxReverseVelocity() const
 {
-	return attributes.Get("reverse thrust") / attributes.Get("drag");
+	return maxReverseVelocity;
 }
 
 
@@ -3065,7 +3206,8 @@ int Ship::TakeDamage(const Projectile &projectile, bool isBlast)
 {
 	int type = 0;
 	const Weapon &weapon = projectile.GetWeapon();
-	type |= TakeDamage(weapon, 1., projectile.DistanceTraveled(), projectile.Position(), isBlast);
+	double damageScaling = isBlast ? BlastDamageScaling(weapon, projectile.Position()) : 1.;
+	type |= TakeDamage(weapon, damageScaling, projectile.DistanceTraveled(), projectile.Position());
 	
 	// If this ship was hit directly and did not consider itself an enemy of the
 	// ship that hit it, it is now "provoked" against that government.
@@ -3079,6 +3221,38 @@ int Ship::TakeDamage(const Projectile &projectile, bool isBlast)
 
 
 
+// Find how much a blast at the given position is scaled by the time it reaches
+// this ship.
+double Ship::BlastDamageScaling(const Weapon &weapon, const Point &blastPosition) const
+{
+	if(!weapon.IsDamageScaled())
+		return 1.;
+	
+	// Scale blast damage based on the distance from the blast
+	// origin and if the projectile uses a trigger radius. The
+	// point of contact must be measured on the sprite outline.
+	// scale = (1 + (tr / (2 * br))^2) / (1 + r^4)^2
+	double blastRadius = max(1., weapon.BlastRadius());
+	double radiusRatio = weapon.TriggerRadius() / blastRadius;
+	double k = !radiusRatio ? 1. : (1. + .25 * radiusRatio * radiusRatio);
+	// Rather than exactly compute the distance between the explosion and
+	// the closest point on the ship, estimate it using the mask's Radius.
+	double d = max(0., (blastPosition - position).Length() - GetMask().Radius());
+	double rSquared = d * d / (blastRadius * blastRadius);
+	return k / ((1. + rSquared * rSquared) * (1. + rSquared * rSquared));
+}
+
+
+
+// Take damage from the blast of the given projectile, which has already been
+// scaled by the given amount.
+int Ship::TakeBlastDamage(const Projectile &projectile, double damageScaling)
+{
+	return TakeDamage(projectile.GetWeapon(), damageScaling, projectile.DistanceTraveled(), projectile.Position());
+}
+
+
+
 // This ship just got hit by the given hazard. Take damage according to what
 // sort of weapon the hazard has, and create any hit effects as sparks.
 void Ship::TakeHazardDamage(vector<Visual> &visuals, const Hazard *hazard, double strength)
@@ -3086,7 +3260,10 @@ void Ship::TakeHazardDamage(vector<Visual> &visuals, const Hazard *hazard, doubl
 	// Rather than exactly compute the distance between the hazard origin and
 	// the closest point on the ship, estimate it using the mask's Radius.
 	double distanceTraveled = position.Length() - GetMask().Radius();
-	TakeDamage(*hazard, strength, distanceTraveled, Point(), hazard->BlastRadius() > 0.);
+	double damageScaling = strength;
+	if(hazard->BlastRadius() > 0.)
+		damageScaling *= BlastDamageScaling(*hazard, Point());
+	TakeDamage(*hazard, damageScaling, distanceTraveled, Point());
 	for(const auto &effect : hazard->HitEffects())
 		CreateSparks(visuals, effect.first, effect.second * strength);
 }
@@ -3129,10 +3306,8 @@ bool Ship::HasBays() const
 // one of your escorts plans to use that bay.
 int Ship::BaysFree(const string &category) const
 {
-	int count = 0;
-	for(const Bay &bay : bays)
-		count += (bay.category == category) && !bay.ship;
-	return count;
+	auto it = bayCounts.find(category);
+	return (it == bayCounts.end() ? 0 : it->second.total - it->second.used);
 }
 
 
@@ -3140,10 +3315,8 @@ int Ship::BaysFree(const string &category) const
 // Check how many bays this ship has of a given category.
 int Ship::BaysTotal(const string &category) const
 {
-	int count = 0;
-	for(const Bay &bay : bays)
-		count += (bay.category == category);
-	return count;
+	auto it = bayCounts.find(category);
+	return (it == bayCounts.end() ? 0 : it->second.total);
 }
 
 
@@ -3193,6 +3366,8 @@ bool Ship::Carry(const shared_ptr<Ship> &ship)
 	
 	// Check only for the category that we are interested in.
 	const string &category = ship->attributes.Category();
+	if(!BaysFree(category))
+		return false;
 	
 	for(Bay &bay : bays)
 		if((bay.category == category) && !bay.ship)
@@ -3216,6 +3391,7 @@ bool Ship::Carry(const shared_ptr<Ship> &ship)
 			
 			// Update the cached mass of the mothership.
 			carriedMass += ship->Mass();
+			++bayCounts[category].used;
 			return true;
 		}
 	return false;
@@ -3229,6 +3405,7 @@ void Ship::UnloadBays()
 		if(bay.ship)
 		{
 			carriedMass -= bay.ship->Mass();
+			--bayCounts[bay.category].used;
 			bay.ship->SetSystem(currentSystem);
 			bay.ship->SetPlanet(landingPlanet);
 			bay.ship.reset();
@@ -3287,7 +3464,7 @@ void Ship::Jettison(const string &commodity, int tons)
 	heat -= tons * MAXIMUM_TEMPERATURE * Heat();
 	
 	for( ; tons > 0; tons -= Flotsam::TONS_PER_BOX)
-		jettisoned.emplace_back(new Flotsam(commodity, (Flotsam::TONS_PER_BOX < tons) ? Flotsam::TONS_PER_BOX : tons));
+		jettisoned.emplace_back(Flotsam::Create(commodity, (Flotsam::TONS_PER_BOX < tons) ? Flotsam::TONS_PER_BOX : tons));
 }
 
 
@@ -3307,7 +3484,7 @@ void Ship::Jettison(const Outfit *outfit, int count)
 	const int perBox = (mass <= 0.) ? count : (mass > Flotsam::TONS_PER_BOX) ? 1 : static_cast<int>(Flotsam::TONS_PER_BOX / mass);
 	while(count > 0)
 	{
-		jettisoned.emplace_back(new Flotsam(outfit, (perBox < count) ? perBox : count));
+		jettisoned.emplace_back(Flotsam::Create(outfit, (perBox < count) ? perBox : count));
 		count -= perBox;
 	}
 }
@@ -3323,7 +3500,7 @@ const Outfit &Ship::Attributes() const
 
 const Outfit &Ship::BaseAttributes() const
 {
-	return baseAttributes;
+	return chassis->baseAttributes;
 }
 
 
@@ -3359,6 +3536,7 @@ void Ship::AddOutfit(const Outfit *outfit, int count)
 				outfits.erase(it);
 		}
 		attributes.Add(*outfit, count);
+		UpdateDerivedAttributes();
 		if(outfit->IsWeapon())
 			armament.Add(outfit, count);
 		
@@ -3404,13 +3582,13 @@ bool Ship::CanFire(const Weapon *weapon) const
 			return false;
 	}
 	
-	if(energy < weapon->FiringEnergy() + weapon->RelativeFiringEnergy() * attributes.Get("energy capacity"))
+	if(energy < weapon->FiringEnergy() + weapon->RelativeFiringEnergy() * attributes.Get(ENERGY_CAPACITY))
 		return false;
-	if(fuel < weapon->FiringFuel() + weapon->RelativeFiringFuel() * attributes.Get("fuel capacity"))
+	if(fuel < weapon->FiringFuel() + weapon->RelativeFiringFuel() * attributes.Get(FUEL_CAPACITY))
 		return false;
 	// We do check hull, but we don't check shields. Ships can survive with all shields depleted.
 	// Ships should not disable themselves, so we check if we stay above minimumHull.
-	if(hull - MinimumHull() < weapon->FiringHull() + weapon->RelativeFiringHull() * attributes.Get("hull"))
+	if(hull - MinimumHull() < weapon->FiringHull() + weapon->RelativeFiringHull() * attributes.Get(HULL))
 		return false;
 
 	// If a weapon requires heat to fire, (rather than generating heat), we must
@@ -3440,13 +3618,13 @@ void Ship::ExpendAmmo(const Weapon *weapon)
 	if(weapon->Ammo())
 		AddOutfit(weapon->Ammo(), -weapon->AmmoUsage());
 	
-	energy -= weapon->FiringEnergy() + weapon->RelativeFiringEnergy() * attributes.Get("energy capacity");
-	fuel -= weapon->FiringFuel() + weapon->RelativeFiringFuel() * attributes.Get("fuel capacity");
+	energy -= weapon->FiringEnergy() + weapon->RelativeFiringEnergy() * attributes.Get(ENERGY_CAPACITY);
+	fuel -= weapon->FiringFuel() + weapon->RelativeFiringFuel() * attributes.Get(FUEL_CAPACITY);
 	heat += weapon->FiringHeat() + weapon->RelativeFiringHeat() * MaximumHeat();
 	// Weapons fire from within shields, so hull damage goes directly into the hull, while shield damage
 	// only affects shields.
-	hull -= weapon->FiringHull() + weapon->RelativeFiringHull() * attributes.Get("hull");
-	shields -= weapon->FiringShields() + weapon->RelativeFiringShields() * attributes.Get("shields");
+	hull -= weapon->FiringHull() + weapon->RelativeFiringHull() * attributes.Get(HULL);
+	shields -= weapon->FiringShields() + weapon->RelativeFiringShields() * attributes.Get(SHIELDS);
 	
 	// Those values are usually reduced by active shields, but weapons fire from within the shields, so
 	// it seems more appropriate to apply those damages with a factor 1 directly.
@@ -3581,6 +3759,70 @@ const vector<weak_ptr<Ship>> &Ship::GetEscorts() const
 
 
 
+// Get this ship's chassis for modifying it, first making a copy of it if
+// any other ship shares it.
+Ship::Chassis &Ship::EditChassis()
+{
+	if(chassis.use_count() > 1)
+		chassis = make_shared<Chassis>(*chassis);
+	return *chassis;
+}
+
+
+
+// Recalculate the values that are derived only from this ship's attributes.
+void Ship::UpdateDerivedAttributes()
+{
+	// Any flight check results from before the attributes changed are stale.
+	hasFlightChecks = false;
+	
+	// This is an S-curve where the efficiency is 100% if you have no outfits
+	// that create "cooling inefficiency", and as that value increases the
+	// efficiency stays high for a while, then drops off, then approaches 0.
+	double x = attributes.Get(COOLING_INEFFICIENCY);
+	coolingEfficiency = 2. + 2. / (1. + exp(x / -2.)) - 4. / (1. + exp(x / -4.));
+	
+	// v * drag / mass == thrust / mass
+	// v * drag == thrust
+	// v = thrust / drag
+	double thrust = attributes.Get(THRUST);
+	maxVelocity = (thrust ? thrust : attributes.Get(AFTERBURNER_THRUST)) / attributes.Get(DRAG);
+	maxReverseVelocity = attributes.Get(REVERSE_THRUST) / attributes.Get(DRAG);
+	
+	// Find the hull amount at which this ship is disabled.
+	double maximumHull = attributes.Get(HULL);
+	double absoluteThreshold = attributes.Get(ABSOLUTE_THRESHOLD);
+	double thresholdPercent = attributes.Get(THRESHOLD_PERCENTAGE);
+	if(neverDisabled)
+		minimumHull = 0.;
+	else if(absoluteThreshold > 0.)
+		minimumHull = absoluteThreshold;
+	else
+	{
+		double threshold = maximumHull * (thresholdPercent > 0. ? min(thresholdPercent, 1.) : max(.15, min(.45, 10. / sqrt(maximumHull))));
+		minimumHull = max(0., floor(threshold + attributes.Get(HULL_THRESHOLD)));
+	}
+	
+	// Find the protection against each type of weapon damage. Relative damage
+	// is reduced by the same protection as the corresponding absolute damage.
+	damageFactor[Weapon::HIT_FORCE] = 1. / (1. + attributes.Get(FORCE_PROTECTION));
+	damageFactor[Weapon::SHIELD_DAMAGE] = 1. / (1. + attributes.Get(SHIELD_PROTECTION));
+	damageFactor[Weapon::HULL_DAMAGE] = 1. / (1. + attributes.Get(HULL_PROTECTION));
+	damageFactor[Weapon::FUEL_DAMAGE] = 1. / (1. + attributes.Get(FUEL_PROTECTION));
+	damageFactor[Weapon::HEAT_DAMAGE] = 1. / (1. + attributes.Get(HEAT_PROTECTION));
+	damageFactor[Weapon::ENERGY_DAMAGE] = 1. / (1. + attributes.Get(ENERGY_PROTECTION));
+	damageFactor[Weapon::ION_DAMAGE] = 1. / (1. + attributes.Get(ION_PROTECTION));
+	damageFactor[Weapon::DISRUPTION_DAMAGE] = 1. / (1. + attributes.Get(DISRUPTION_PROTECTION));
+	damageFactor[Weapon::SLOWING_DAMAGE] = 1. / (1. + attributes.Get(SLOWING_PROTECTION));
+	damageFactor[Weapon::RELATIVE_SHIELD_DAMAGE] = damageFactor[Weapon::SHIELD_DAMAGE];
+	damageFactor[Weapon::RELATIVE_HULL_DAMAGE] = damageFactor[Weapon::HULL_DAMAGE];
+	damageFactor[Weapon::RELATIVE_FUEL_DAMAGE] = damageFactor[Weapon::FUEL_DAMAGE];
+	damageFactor[Weapon::RELATIVE_HEAT_DAMAGE] = damageFactor[Weapon::HEAT_DAMAGE];
+	damageFactor[Weapon::RELATIVE_ENERGY_DAMAGE] = damageFactor[Weapon::ENERGY_DAMAGE];
+}
+
+
+
 // Add escorts to this ship. Escorts look to the parent ship for movement
 // cues and try to stay with it when it lands or goes into hyperspace.
 void Ship::AddEscort(Ship &ship)
@@ -3605,18 +3847,7 @@ void Ship::RemoveEscort(const Ship &ship)
 
 double Ship::MinimumHull() const
 {
-	if(neverDisabled)
-		return 0.;
-	
-	double maximumHull = attributes.Get("hull");
-	double absoluteThreshold = attributes.Get("absolute threshold");
-	if(absoluteThreshold > 0.)
-		return absoluteThreshold;
-	
-	double thresholdPercent = attributes.Get("threshold percentage");
-	double minimumHull = maximumHull * (thresholdPercent > 0. ? min(thresholdPercent, 1.) : max(.15, min(.45, 10. / sqrt(maximumHull))));
-
-	return max(0., floor(minimumHull + attributes.Get("hull threshold")));
+	return minimumHull;
 }
 
 
@@ -3627,14 +3858,14 @@ double Ship::BestFuel(const string &type, const string &subtype, double defaultF
 	// Find the outfit that provides the least costly hyperjump.
 	double best = 0.;
 	// Make it possible for a hyperdrive to be integrated into a ship.
-	if(baseAttributes.Get(type) && (subtype.empty() || baseAttributes.Get(subtype)))
+	if(chassis->baseAttributes.Get(type) && (subtype.empty() || chassis->baseAttributes.Get(subtype)))
 	{
 		// If a distance was given, then we know that we are making a jump.
 		// Only use the fuel from a jump drive if it is capable of making
 		// the given jump. We can guarantee that at least one jump drive
 		// is capable of making the given jump, as the destination must
 		// be among the neighbors of the current system.
-		double jumpRange = baseAttributes.Get("jump range");
+		double jumpRange = chassis->baseAttributes.Get("jump range");
 		if(!jumpRange)
 			jumpRange = System::DEFAULT_NEIGHBOR_DISTANCE;
 		// If no distance was given then we're either using a hyperdrive
@@ -3642,7 +3873,7 @@ double Ship::BestFuel(const string &type, const string &subtype, double defaultF
 		// always pass.
 		if(jumpRange >= jumpDistance)
 		{
-			best = baseAttributes.Get("jump fuel");
+			best = chassis->baseAttributes.Get("jump fuel");
 			if(!best)
 				best = defaultFuel;
 		}
@@ -3670,7 +3901,7 @@ double Ship::BestFuel(const string &type, const string &subtype, double defaultF
 
 void Ship::CreateExplosion(vector<Visual> &visuals, bool spread)
 {
-	if(!HasSprite() || !GetMask().IsLoaded() || explosionEffects.empty())
+	if(!HasSprite() || !GetMask().IsLoaded() || chassis->explosionEffects.empty())
 		return;
 	
 	// Bail out if this loops enough times, just in case.
@@ -3682,8 +3913,8 @@ void Ship::CreateExplosion(vector<Visual> &visuals, bool spread)
 		{
 			// Pick an explosion.
 			int type = Random::Int(explosionTotal);
-			auto it = explosionEffects.begin();
-			for( ; it != explosionEffects.end(); ++it)
+			auto it = chassis->explosionEffects.begin();
+			for( ; it != chassis->explosionEffects.end(); ++it)
 			{
 				type -= it->second;
 				if(type < 0)
@@ -3738,44 +3969,30 @@ void Ship::CreateSparks(vector<Visual> &visuals, const Effect *effect, double am
 
 
 // A helper method for taking damage from either a projectile or a hazard.
-int Ship::TakeDamage(const Weapon &weapon, double damageScaling, double distanceTraveled, const Point &damagePosition, bool isBlast)
-{
-	if(isBlast && weapon.IsDamageScaled())
-	{
-		// Scale blast damage based on the distance from the blast
-		// origin and if the projectile uses a trigger radius. The
-		// point of contact must be measured on the sprite outline.
-		// scale = (1 + (tr / (2 * br))^2) / (1 + r^4)^2
-		double blastRadius = max(1., weapon.BlastRadius());
-		double radiusRatio = weapon.TriggerRadius() / blastRadius;
-		double k = !radiusRatio ? 1. : (1. + .25 * radiusRatio * radiusRatio);
-		// Rather than exactly compute the distance between the explosion and
-		// the closest point on the ship, estimate it using the mask's Radius.
-		double d = max(0., (damagePosition - position).Length() - GetMask().Radius());
-		double rSquared = d * d / (blastRadius * blastRadius);
-		damageScaling *= k / ((1. + rSquared * rSquared) * (1. + rSquared * rSquared));
-	}
+int Ship::TakeDamage(const Weapon &weapon, double damageScaling, double distanceTraveled, const Point &damagePosition)
+{
 	if(weapon.HasDamageDropoff())
 		damageScaling *= weapon.DamageDropoff(distanceTraveled);
 	
-	double shieldDamage = (weapon.ShieldDamage() + weapon.RelativeShieldDamage() * attributes.Get("shields"))
-		* damageScaling / (1. + attributes.Get("shield protection"));
-	double hullDamage = (weapon.HullDamage() + weapon.RelativeHullDamage() * attributes.Get("hull"))
-		* damageScaling / (1. + attributes.Get("hull protection"));
-	double energyDamage = (weapon.EnergyDamage() + weapon.RelativeEnergyDamage() * attributes.Get("energy capacity"))
-		* damageScaling / (1. + attributes.Get("energy protection"));
-	double fuelDamage = (weapon.FuelDamage() + weapon.RelativeFuelDamage() * attributes.Get("fuel capacity"))
-		* damageScaling / (1. + attributes.Get("fuel protection"));
-	double heatDamage = (weapon.HeatDamage() + weapon.RelativeHeatDamage() * MaximumHeat())
-		* damageScaling / (1. + attributes.Get("heat protection"));
-	double ionDamage = weapon.IonDamage() * damageScaling / (1. + attributes.Get("ion protection"));
-	double disruptionDamage = weapon.DisruptionDamage() * damageScaling / (1. + attributes.Get("disruption protection"));
-	double slowingDamage = weapon.SlowingDamage() * damageScaling / (1. + attributes.Get("slowing protection"));
-	double hitForce = weapon.HitForce() * damageScaling / (1. + attributes.Get("force protection"));
+	// Scale every type of damage by this ship's protection against it, all at
+	// once, then add the relative damage to the absolute damage.
+	const double *weaponDamage = weapon.Damage();
+	double damage[Weapon::DAMAGE_TYPES];
+	for(int i = 0; i < Weapon::DAMAGE_TYPES; ++i)
+		damage[i] = weaponDamage[i] * damageFactor[i] * damageScaling;
+	double shieldDamage = damage[Weapon::SHIELD_DAMAGE] + damage[Weapon::RELATIVE_SHIELD_DAMAGE] * attributes.Get(SHIELDS);
+	double hullDamage = damage[Weapon::HULL_DAMAGE] + damage[Weapon::RELATIVE_HULL_DAMAGE] * attributes.Get(HULL);
+	double energyDamage = damage[Weapon::ENERGY_DAMAGE] + damage[Weapon::RELATIVE_ENERGY_DAMAGE] * attributes.Get(ENERGY_CAPACITY);
+	double fuelDamage = damage[Weapon::FUEL_DAMAGE] + damage[Weapon::RELATIVE_FUEL_DAMAGE] * attributes.Get(FUEL_CAPACITY);
+	double heatDamage = damage[Weapon::HEAT_DAMAGE] + damage[Weapon::RELATIVE_HEAT_DAMAGE] * MaximumHeat();
+	double ionDamage = damage[Weapon::ION_DAMAGE];
+	double disruptionDamage = damage[Weapon::DISRUPTION_DAMAGE];
+	double slowingDamage = damage[Weapon::SLOWING_DAMAGE];
+	double hitForce = damage[Weapon::HIT_FORCE];
 	bool wasDisabled = IsDisabled();
 	bool wasDestroyed = IsDestroyed();
 	
-	double shieldFraction = 1. - max(0., min(1., weapon.Piercing() / (1. + attributes.Get("piercing protection")) - attributes.Get("piercing resistance")));
+	double shieldFraction = 1. - max(0., min(1., weapon.Piercing() / (1. + attributes.Get(PIERCING_PROTECTION)) - attributes.Get(PIERCING_RESISTANCE)));
 	shieldFraction *= 1. / (1. + disruption * .01);
 	if(shields <= 0.)
 		shieldFraction = 0.;
@@ -3784,12 +4001,12 @@ int Ship::TakeDamage(const Weapon &weapon, double damageScaling, double distance
 	shields -= shieldDamage * shieldFraction;
 	if(shieldDamage && !isDisabled)
 	{
-		int disabledDelay = static_cast<int>(attributes.Get("depleted shield delay"));
-		shieldDelay = max(shieldDelay, (shields <= 0. && disabledDelay) ? disabledDelay : static_cast<int>(attributes.Get("shield delay")));
+		int disabledDelay = static_cast<int>(attributes.Get(DEPLETED_SHIELD_DELAY));
+		shieldDelay = max(shieldDelay, (shields <= 0. && disabledDelay) ? disabledDelay : static_cast<int>(attributes.Get(SHIELD_DELAY)));
 	}
 	hull -= hullDamage * (1. - shieldFraction);
 	if(hullDamage && !isDisabled)
-		hullDelay = max(hullDelay, static_cast<int>(attributes.Get("repair delay")));
+		hullDelay = max(hullDelay, static_cast<int>(attributes.Get(REPAIR_DELAY)));
 	// For the following damage types, the total effect depends on how much is
 	// "leaking" through the shields.
 	double leakage = (1. - .5 * shieldFraction);
@@ -3819,7 +4036,7 @@ int Ship::TakeDamage(const Weapon &weapon, double damageScaling, double distance
 	if(!wasDisabled && isDisabled)
 	{
 		type |= ShipEvent::DISABLE;
-		hullDelay = max(hullDelay, static_cast<int>(attributes.Get("disabled repair delay")));
+		hullDelay = max(hullDelay, static_cast<int>(attributes.Get(DISABLED_REPAIR_DELAY)));
 	}
 	if(!wasDestroyed && IsDestroyed())
 		type |= ShipEvent::DESTROY;
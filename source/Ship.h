@@ -19,6 +19,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Armament.h"
 #include "CargoHold.h"
 #include "Command.h"
+#include "FlatMap.h"
 #include "Outfit.h"
 #include "Personality.h"
 #include "Point.h"
@@ -155,8 +156,9 @@ public:
 	int64_t ChassisCost() const;
 
 	// Check if this ship is configured in such a way that it would be difficult
-	// or impossible to fly.
-	std::vector<std::string> FlightCheck() const;
+	// or impossible to fly. The result is remembered until something that it
+	// depends on changes, because the shop panels check every frame.
+	const std::vector<std::string> &FlightCheck() const;
 	
 	void SetPosition(Point position);
 	// When creating a new ship, you must set the following:
@@ -189,10 +191,16 @@ public:
 	// Set the commands for this ship to follow this timestep.
 	void SetCommands(const Command &command);
 	const Command &Commands() const;
+	// Update the parts of this ship's state that do not depend on any other
+	// ship: energy and heat generation, cloaking, and turret aim. This only
+	// modifies this ship and the ships it is carrying, and it does not draw
+	// any random numbers, so it can be run for many ships in parallel. It must
+	// be called once per step, before Move().
+	void PrepareMove();
 	// Move this ship. A ship may create effects as it moves, in particular if
 	// it is in the process of blowing up.
 	void Move(std::vector<Visual> &visuals, std::list<std::shared_ptr<Flotsam>> &flotsam);
-	// Generate energy, heat, etc. (This is called by Move().)
+	// Generate energy, heat, etc. (This is called by PrepareMove().)
 	void DoGeneration();
 	// Launch any ships that are ready to launch.
 	void Launch(std::list<std::shared_ptr<Ship>> &ships, std::vector<Visual> &visuals);
@@ -213,6 +221,9 @@ public:
 	bool Fire(std::vector<Projectile> &projectiles, std::vector<Visual> &visuals);
 	// Fire an anti-missile. Returns true if the missile was killed.
 	bool FireAntiMissile(const Projectile &projectile, std::vector<Visual> &visuals);
+	// Get the farthest that any of the anti-missiles that were ready to fire in
+	// this step can reach.
+	double AntiMissileRange() const;
 	
 	// Get the system this ship is in.
 	const System *GetSystem() const;
@@ -328,6 +339,13 @@ public:
 	// not necessarily its primary target.
 	// Blast damage is dependent on the distance to the damage source.
 	int TakeDamage(const Projectile &projectile, bool isBlast = false);
+	// Find how much a blast at the given position is scaled by the time it
+	// reaches this ship. This does not modify the ship, so it is safe to check
+	// many ships at once from different threads.
+	double BlastDamageScaling(const Weapon &weapon, const Point &blastPosition) const;
+	// Take damage from the blast of the given projectile, which has already
+	// been scaled by the given amount.
+	int TakeBlastDamage(const Projectile &projectile, double damageScaling);
 	// This ship just got hit by the given hazard. Take damage according to what
 	// sort of weapon the hazard has, and create any hit effects as sparks.
 	void TakeHazardDamage(std::vector<Visual> &visuals, const Hazard *hazard, double strength);
@@ -416,8 +434,65 @@ public:
 	std::shared_ptr<Ship> GetParent() const;
 	const std::vector<std::weak_ptr<Ship>> &GetEscorts() const;
 	
+	// The index of this ship's record in the AI's table of per-ship state.
+	// The AI checks that the record really belongs to this ship before using
+	// it, so a stale index (e.g. in a copy of this ship) is harmless.
+	size_t AISlot() const { return aiSlot; }
+	void SetAISlot(size_t slot) const { aiSlot = slot; }
+	
 	
 private:
+	// The hull may spring a "leak" (venting atmosphere, flames, blood, etc.)
+	// when the ship is dying.
+	class Leak {
+	public:
+		Leak(const Effect *effect = nullptr) : effect(effect) {}
+		
+		const Effect *effect = nullptr;
+		Point location;
+		Angle angle;
+		int openPeriod = 60;
+		int closePeriod = 60;
+	};
+	
+	// The parts of a ship's definition that are set when it is loaded and
+	// are the same for every copy of it, such as the ships that a fleet
+	// spawns. The copies all share one instance of this, and a ship only
+	// makes its own copy if it needs to modify it.
+	class Chassis {
+	public:
+		Outfit baseAttributes;
+		std::vector<EnginePoint> enginePoints;
+		std::vector<EnginePoint> reverseEnginePoints;
+		std::vector<EnginePoint> steeringEnginePoints;
+		std::vector<Leak> leaks;
+		std::map<const Effect *, int> explosionEffects;
+		std::map<const Effect *, int> finalExplosions;
+		std::string description;
+	};
+	
+	// How many bays of one category a ship has, and how many of them have a
+	// ship in them. Like a Bay, a copy of this has no ships in it.
+	class BayCount {
+	public:
+		BayCount() = default;
+		BayCount(BayCount &&) = default;
+		BayCount &operator=(BayCount &&) = default;
+		BayCount(const BayCount &other) : total(other.total) {}
+		BayCount &operator=(const BayCount &other) { return *this = BayCount(other); }
+		
+		int total = 0;
+		int used = 0;
+	};
+	
+	
+private:
+	// Get this ship's chassis for modifying it, first making a copy of it if
+	// any other ship shares it.
+	Chassis &EditChassis();
+	// Recalculate the values that are derived only from this ship's attributes.
+	// This must be done whenever the attributes change.
+	void UpdateDerivedAttributes();
 	// Add or remove a ship from this ship's list of escorts.
 	void AddEscort(Ship &ship);
 	void RemoveEscort(const Ship &ship);
@@ -432,7 +507,7 @@ private:
 	void CreateSparks(std::vector<Visual> &visuals, const std::string &name, double amount);
 	void CreateSparks(std::vector<Visual> &visuals, const Effect *effect, double amount);
 	// A helper method for taking damage from either a projectile or a hazard.
-	int TakeDamage(const Weapon &weapon, double damageScaling, double distanceTraveled, const Point &damagePosition, bool isBlast);
+	int TakeDamage(const Weapon &weapon, double damageScaling, double distanceTraveled, const Point &damagePosition);
 	
 	
 private:
@@ -452,8 +527,8 @@ private:
 	std::string pluralModelName;
 	std::string variantName;
 	std::string noun;
-	std::string description;
 	const Sprite *thumbnail = nullptr;
+	std::shared_ptr<Chassis> chassis = std::make_shared<Chassis>();
 	// Characteristics of this particular ship:
 	std::string name;
 	bool canBeCarried = false;
@@ -494,7 +569,6 @@ private:
 	
 	// Installed outfits, cargo, etc.:
 	Outfit attributes;
-	Outfit baseAttributes;
 	bool addAttributes = false;
 	const Outfit *explosionWeapon = nullptr;
 	std::map<const Outfit *, int> outfits;
@@ -502,12 +576,12 @@ private:
 	std::list<std::shared_ptr<Flotsam>> jettisoned;
 	
 	std::vector<Bay> bays;
+	// The bays of each category, so that carried ships can check if there is
+	// room for them without searching through all the bays.
+	FlatMap<std::string, BayCount> bayCounts;
 	// Cache the mass of carried ships to avoid repeatedly recomputing it.
 	double carriedMass = 0.;
 	
-	std::vector<EnginePoint> enginePoints;
-	std::vector<EnginePoint> reverseEnginePoints;
-	std::vector<EnginePoint> steeringEnginePoints;
 	Armament armament;
 	// While loading, keep track of which outfits already have been equipped.
 	// (That is, they were specified as linked to a given gun or turret point.)
@@ -545,28 +619,30 @@ private:
 	Point hyperspaceOffset;
 	
 	double jumpRange = 0.;
-	
-	// The hull may spring a "leak" (venting atmosphere, flames, blood, etc.)
-	// when the ship is dying.
-	class Leak {
-	public:
-		Leak(const Effect *effect = nullptr) : effect(effect) {}
-		
-		const Effect *effect = nullptr;
-		Point location;
-		Angle angle;
-		int openPeriod = 60;
-		int closePeriod = 60;
-	};
-	std::vector<Leak> leaks;
+	// Values that are derived from the attributes, which only change when an
+	// outfit is added or removed. They are asked for many times each frame.
+	double coolingEfficiency = 1.;
+	double maxVelocity = 0.;
+	double maxReverseVelocity = 0.;
+	double minimumHull = 0.;
+	// The fraction of each type of weapon damage that this ship takes, given
+	// its protection against that type.
+	double damageFactor[Weapon::DAMAGE_TYPES] = {};
+	// The most recent flight check results, and the state that they depend on
+	// other than the attributes and outfits.
+	mutable std::vector<std::string> flightChecks;
+	mutable bool hasFlightChecks = false;
+	mutable int flightCheckCargo = 0;
+	mutable bool flightCheckCarried = false;
+	mutable bool flightCheckInSystem = false;
+	
+	// The hull may spring a "leak" when the ship is dying.
 	std::vector<Leak> activeLeaks;
 	
 	// Explosions that happen when the ship is dying:
-	std::map<const Effect *, int> explosionEffects;
 	unsigned explosionRate = 0;
 	unsigned explosionCount = 0;
 	unsigned explosionTotal = 0;
-	std::map<const Effect *, int> finalExplosions;
 	
 	// Target ships, planets, systems, etc.
 	std::weak_ptr<Ship> targetShip;
@@ -579,6 +655,8 @@ private:
 	// Links between escorts and parents.
 	std::vector<std::weak_ptr<Ship>> escorts;
 	std::weak_ptr<Ship> parent;
+	
+	mutable size_t aiSlot = -1;
 };
 
 
@@ -29,6 +29,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+	// The stats shown for a stock ship model.
+	class ModelStats {
+	public:
+		vector<string> labels;
+		vector<string> values;
+		int height = 0;
+		vector<string> tableLabels;
+		vector<string> energyTable;
+		vector<string> heatTable;
+	};
+}
+
 
 
 ShipInfoDisplay::ShipInfoDisplay(const Ship &ship, const Depreciation &depreciation, int day)
@@ -115,14 +128,10 @@ void ShipInfoDisplay::DrawSale(const Point &topLeft) const
 
 void ShipInfoDisplay::UpdateAttributes(const Ship &ship, const Depreciation &depreciation, int day)
 {
-	bool isGeneric = ship.Name().empty() || ship.GetPlanet();
-	
 	attributeLabels.clear();
 	attributeValues.clear();
 	attributesHeight = 20;
 	
-	const Outfit &attributes = ship.Attributes();
-	
 	int64_t fullCost = ship.Cost();
 	int64_t depreciated = depreciation.Value(ship, day);
 	if(depreciated == fullCost)
@@ -136,6 +145,52 @@ void ShipInfoDisplay::UpdateAttributes(const Ship &ship, const Depreciation &dep
 	attributeValues.push_back(Format::Credits(depreciated));
 	attributesHeight += 20;
 	
+	// Everything other than the cost only depends on the ship's attributes.
+	// Stock ship models do not change unless the game data does, so their
+	// stats are only calculated the first time they are shown.
+	static map<const Ship *, ModelStats> modelStats;
+	static uint64_t modelStatsRevision = 0;
+	if(modelStatsRevision != GameData::Revision())
+	{
+		modelStats.clear();
+		modelStatsRevision = GameData::Revision();
+	}
+	bool isModel = (GameData::Ships().Find(ship.VariantName()) == &ship);
+	auto it = isModel ? modelStats.find(&ship) : modelStats.end();
+	if(it != modelStats.end())
+	{
+		const ModelStats &stats = it->second;
+		attributeLabels.insert(attributeLabels.end(), stats.labels.begin(), stats.labels.end());
+		attributeValues.insert(attributeValues.end(), stats.values.begin(), stats.values.end());
+		attributesHeight += stats.height;
+		tableLabels = stats.tableLabels;
+		energyTable = stats.energyTable;
+		heatTable = stats.heatTable;
+		return;
+	}
+	
+	size_t first = attributeLabels.size();
+	int firstHeight = attributesHeight;
+	UpdateStats(ship);
+	if(isModel)
+	{
+		ModelStats &stats = modelStats[&ship];
+		stats.labels.assign(attributeLabels.begin() + first, attributeLabels.end());
+		stats.values.assign(attributeValues.begin() + first, attributeValues.end());
+		stats.height = attributesHeight - firstHeight;
+		stats.tableLabels = tableLabels;
+		stats.energyTable = energyTable;
+		stats.heatTable = heatTable;
+	}
+}
+
+
+
+void ShipInfoDisplay::UpdateStats(const Ship &ship)
+{
+	bool isGeneric = ship.Name().empty() || ship.GetPlanet();
+	const Outfit &attributes = ship.Attributes();
+	
 	attributeLabels.push_back(string());
 	attributeValues.push_back(string());
 	attributesHeight += 10;
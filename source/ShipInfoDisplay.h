@@ -53,6 +53,7 @@ public:
 	
 private:
 	void UpdateAttributes(const Ship &ship, const Depreciation &depreciation, int day);
+	void UpdateStats(const Ship &ship);
 	void UpdateOutfits(const Ship &ship, const Depreciation &depreciation, int day);
 	
 	
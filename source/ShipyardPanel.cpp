@@ -100,11 +100,15 @@ int ShipyardPanel::TileSize() const
 
 int ShipyardPanel::DrawPlayerShipInfo(const Point &point)
 {
-	shipInfo.Update(*playerShip, player.FleetDepreciation(), player.GetDate().DaysSinceEpoch());
-	shipInfo.DrawSale(point);
-	shipInfo.DrawAttributes(point + Point(0, shipInfo.SaleHeight()));
+	if(playerShipInfoShip != playerShip)
+	{
+		playerShipInfo.Update(*playerShip, player.FleetDepreciation(), player.GetDate().DaysSinceEpoch());
+		playerShipInfoShip = playerShip;
+	}
+	playerShipInfo.DrawSale(point);
+	playerShipInfo.DrawAttributes(point + Point(0, playerShipInfo.SaleHeight()));
 	
-	return shipInfo.SaleHeight() + shipInfo.AttributesHeight();
+	return playerShipInfo.SaleHeight() + playerShipInfo.AttributesHeight();
 }
 
 
@@ -155,7 +159,11 @@ int ShipyardPanel::DrawDetails(const Point &center)
 	
 	if(selectedShip)
 	{
-		shipInfo.Update(*selectedShip, player.StockDepreciation(), player.GetDate().DaysSinceEpoch());
+		if(shipInfoShip != selectedShip)
+		{
+			shipInfo.Update(*selectedShip, player.StockDepreciation(), player.GetDate().DaysSinceEpoch());
+			shipInfoShip = selectedShip;
+		}
 		selectedItem = selectedShip->ModelName();
 		
 		const Sprite *background = SpriteSet::Get("ui/shipyard selected");
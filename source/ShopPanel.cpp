@@ -44,7 +44,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
-	const string SHIP_OUTLINES = "Ship outlines in shops";
+	const Preferences::Setting SHIP_OUTLINES("Ship outlines in shops");
 	
 	constexpr int ICON_TILE = 62;
 	constexpr int ICON_COLS = 4;
@@ -78,6 +78,10 @@ void ShopPanel::Step()
 	// them how to reorder the ships in their fleet.
 	if(player.Ships().size() > 1)
 		DoHelp("multiple ships");
+	// While a dialog is open on top of this panel, it may buy or sell things,
+	// so the catalog must be checked again once it closes.
+	if(!GetUI()->IsTop(this))
+		Invalidate();
 	// Perform autoscroll to bring item details into view.
 	if(scrollDetailsIntoView && mainDetailHeight > 0)
 	{
@@ -104,6 +108,9 @@ void ShopPanel::Draw()
 	
 	glClear(GL_COLOR_BUFFER_BIT);
 	
+	if(!isCatalogValid)
+		UpdateCatalog();
+	
 	// Clear the list of clickable zones.
 	zones.clear();
 	categoryZones.clear();
@@ -116,6 +123,7 @@ void ShopPanel::Draw()
 	
 	shipInfo.DrawTooltips();
 	outfitInfo.DrawTooltips();
+	playerShipInfo.DrawTooltips();
 	
 	if(!warningType.empty())
 	{
@@ -140,11 +148,11 @@ void ShopPanel::Draw()
 	{
 		const Sprite *sprite = dragShip->GetSprite();
 		float scale = ICON_SIZE / max(sprite->Width(), sprite->Height());
-		if(Preferences::Has(SHIP_OUTLINES))
+		if(SHIP_OUTLINES.Has())
 		{
 			static const Color selected(.8f, 1.f);
 			Point size(sprite->Width() * scale, sprite->Height() * scale);
-			OutlineShader::Draw(sprite, dragPoint, size, selected);
+			OutlineShader::DrawCached(sprite, dragPoint, size, selected);
 		}
 		else
 		{
@@ -233,10 +241,10 @@ void ShopPanel::DrawShipsSidebar()
 		if(sprite)
 		{
 			float scale = ICON_SIZE / max(sprite->Width(), sprite->Height());
-			if(Preferences::Has(SHIP_OUTLINES))
+			if(SHIP_OUTLINES.Has())
 			{
 				Point size(sprite->Width() * scale, sprite->Height() * scale);
-				OutlineShader::Draw(sprite, point, size, isSelected ? selected : unselected);
+				OutlineShader::DrawCached(sprite, point, size, isSelected ? selected : unselected);
 			}
 			else
 			{
@@ -413,8 +421,8 @@ void ShopPanel::DrawMain()
 	int scrollY = 0;
 	for(const string &category : categories)
 	{
-		map<string, set<string>>::const_iterator it = catalog.find(category);
-		if(it == catalog.end())
+		auto it = catalogItems.find(category);
+		if(it == catalogItems.end())
 			continue;
 		
 		// This should never happen, but bail out if we don't know what planet
@@ -428,21 +436,21 @@ void ShopPanel::DrawMain()
 		
 		bool isCollapsed = collapsed.count(category);
 		bool isEmpty = true;
-		for(const string &name : it->second)
+		for(const CatalogItem &item : it->second)
 		{
-			bool isSelected = (selectedShip && GameData::Ships().Get(name) == selectedShip)
-				|| (selectedOutfit && GameData::Outfits().Get(name) == selectedOutfit);
+			bool isSelected = (selectedShip && item.ship == selectedShip)
+				|| (selectedOutfit && item.outfit == selectedOutfit);
 			
 			if(isSelected)
 				selectedTopY = point.Y() - TILE_SIZE / 2;
 			
-			if(!HasItem(name))
+			if(!item.isShown)
 				continue;
 			isEmpty = false;
 			if(isCollapsed)
 				break;
 			
-			DrawItem(name, point, scrollY);
+			DrawItem(item.name, point, scrollY);
 			
 			point.X() += columnWidth;
 			if(point.X() >= endX)
@@ -578,6 +586,7 @@ void ShopPanel::ToggleCargo()
 // Only override the ones you need; the default action is to return false.
 bool ShopPanel::KeyDown(SDL_Keycode key, Uint16 mod, const Command &command, bool isNewPress)
 {
+	Invalidate();
 	scrollDetailsIntoView = false;
 	bool toStorage = selectedOutfit && (key == 'r' || key == 'u');
 	if(key == 'l' || key == 'd' || key == SDLK_ESCAPE
@@ -695,6 +704,7 @@ bool ShopPanel::KeyDown(SDL_Keycode key, Uint16 mod, const Command &command, boo
 
 bool ShopPanel::Click(int x, int y, int /* clicks */)
 {
+	Invalidate();
 	dragShip = nullptr;
 	// Handle clicks on the buttons.
 	char button = CheckButton(x, y);
@@ -796,11 +806,13 @@ bool ShopPanel::Hover(int x, int y)
 	{
 		shipInfo.ClearHover();
 		outfitInfo.ClearHover();
+		playerShipInfo.ClearHover();
 	}
 	else
 	{
 		shipInfo.Hover(point);
 		outfitInfo.Hover(point);
+		playerShipInfo.Hover(point);
 	}
 	
 	activePane = ShopPane::Main;
@@ -890,6 +902,18 @@ int64_t ShopPanel::LicenseCost(const Outfit *outfit) const
 
 
 
+// Mark the items shown in the catalog, and the information shown about the
+// selected items, as needing to be recalculated.
+void ShopPanel::Invalidate()
+{
+	isCatalogValid = false;
+	playerShipInfoShip = nullptr;
+	shipInfoShip = nullptr;
+	outfitInfoOutfit = nullptr;
+}
+
+
+
 ShopPanel::Zone::Zone(Point center, Point size, const Ship *ship, double scrollY)
 	: ClickZone(center, size, ship), scrollY(scrollY)
 {
@@ -925,6 +949,29 @@ double ShopPanel::Zone::ScrollY() const
 
 
 
+// Check which items of the catalog should be shown.
+void ShopPanel::UpdateCatalog()
+{
+	catalogItems.clear();
+	for(const auto &it : catalog)
+	{
+		vector<CatalogItem> &items = catalogItems[it.first];
+		items.reserve(it.second.size());
+		for(const string &name : it.second)
+		{
+			items.emplace_back();
+			CatalogItem &item = items.back();
+			item.name = name;
+			item.ship = GameData::Ships().Find(name);
+			item.outfit = GameData::Outfits().Find(name);
+			item.isShown = HasItem(name);
+		}
+	}
+	isCatalogValid = true;
+}
+
+
+
 bool ShopPanel::DoScroll(double dy)
 {
 	double *scroll = &mainScroll;
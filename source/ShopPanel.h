@@ -80,6 +80,12 @@ protected:
 	
 	int64_t LicenseCost(const Outfit *outfit) const;
 	
+	// Mark the items shown in the catalog, and the information shown about the
+	// selected items, as needing to be recalculated. This must be done after
+	// anything happens that might change which items are shown or what is
+	// shown about them, e.g. buying or selling something.
+	void Invalidate();
+	
 	
 protected:
 	class Zone : public ClickZone<const Ship *> {
@@ -97,6 +103,15 @@ protected:
 		const Outfit *outfit = nullptr;
 	};
 	
+	// An item in the catalog, and whether it is currently shown.
+	class CatalogItem {
+	public:
+		std::string name;
+		const Ship *ship = nullptr;
+		const Outfit *outfit = nullptr;
+		bool isShown = false;
+	};
+	
 	enum class ShopPane : int {
 		Main,
 		Sidebar,
@@ -155,14 +170,27 @@ protected:
 	const std::vector<std::string> &categories;
 	std::set<std::string> &collapsed;
 	
+	// The items of each category of the catalog. Checking whether every item
+	// should be shown is expensive, so that is only done after Invalidate().
+	std::map<std::string, std::vector<CatalogItem>> catalogItems;
+	bool isCatalogValid = false;
+	
 	ShipInfoDisplay shipInfo;
 	OutfitInfoDisplay outfitInfo;
+	// The info for the player's ship is shown in its own display, so that the
+	// displays do not have to be updated every time they are drawn. These are
+	// the items that they were last updated for.
+	ShipInfoDisplay playerShipInfo;
+	const Ship *playerShipInfoShip = nullptr;
+	const Ship *shipInfoShip = nullptr;
+	const Outfit *outfitInfoOutfit = nullptr;
 	
 	mutable Point warningPoint;
 	mutable std::string warningType;
 	
 	
 private:
+	void UpdateCatalog();
 	bool DoScroll(double dy);
 	void SideSelect(int count);
 	void SideSelect(Ship *ship);
@@ -0,0 +1,182 @@
+/* SnapshotStore.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SnapshotStore.h"
+
+#include "BinaryData.h"
+#include "File.h"
+#include "Files.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+	// A snapshot begins with this line, which no saved game ever does.
+	const string HEADER = "snapshot\n";
+	
+	// Get the directory the sections are stored in.
+	string Folder()
+	{
+		return Files::Saves() + "snapshots/";
+	}
+	
+	// Get the name of the file that a section with the given contents is
+	// stored in.
+	string Name(const string &section)
+	{
+		char buffer[17];
+		snprintf(buffer, sizeof(buffer), "%016" PRIx64, BinaryData::Hash(section));
+		return buffer;
+	}
+	
+	// Get the names of all the sections in the given snapshot.
+	vector<string> Sections(const string &contents)
+	{
+		vector<string> names;
+		istringstream in(contents.substr(HEADER.length()));
+		string name;
+		while(in >> name)
+			names.push_back(name);
+		return names;
+	}
+}
+
+
+
+// Save the given text as a snapshot at the given path.
+void SnapshotStore::Write(const string &path, const string &text)
+{
+	string folder = Folder();
+	Files::CreateFolder(folder);
+	if(!Files::Exists(folder))
+	{
+		Files::Write(path, text);
+		return;
+	}
+	
+	string contents = HEADER;
+	for(const string &section : Split(text))
+	{
+		// Only sections that have not been stored before need to be written.
+		// That is most of what makes creating a snapshot so quick.
+		string name = Name(section);
+		string sectionPath = folder + name;
+		if(!Files::Exists(sectionPath))
+			Files::Write(sectionPath, section);
+		contents += '\t' + name + '\n';
+	}
+	Files::Write(path, contents);
+}
+
+
+
+// Check whether the given file contents are a snapshot's list of sections.
+bool SnapshotStore::IsSnapshot(const string &contents)
+{
+	return !contents.compare(0, HEADER.length(), HEADER);
+}
+
+
+
+// Put the sections of the given snapshot back together.
+string SnapshotStore::Reconstruct(const string &contents)
+{
+	string folder = Folder();
+	string text;
+	for(const string &name : Sections(contents))
+	{
+		string section = Files::Read(folder + name);
+		if(Name(section) != name)
+		{
+			Files::LogError("Error: snapshot section \"" + name + "\" is missing or damaged.");
+			return string();
+		}
+		text += section;
+	}
+	return text;
+}
+
+
+
+// Delete any stored sections that are no longer part of any snapshot.
+void SnapshotStore::CollectGarbage()
+{
+	string folder = Folder();
+	if(!Files::Exists(folder))
+		return;
+	
+	set<string> used;
+	for(const string &path : Files::List(Files::Saves()))
+	{
+		// Most of the files are full saves, which are much bigger than the
+		// snapshots are, so only read the start of each one to check.
+		string start(HEADER.length(), '\0');
+		{
+			File file(path);
+			if(!file)
+				continue;
+			start.resize(fread(&start[0], 1, start.size(), file));
+		}
+		if(!IsSnapshot(start))
+			continue;
+		
+		for(const string &name : Sections(Files::Read(path)))
+			used.insert(name);
+	}
+	
+	for(const string &path : Files::List(folder))
+		if(!used.count(Files::Name(path)))
+			Files::Delete(path);
+}
+
+
+
+// Split a saved game into sections. Each top-level node that has children,
+// such as a ship or a mission, is a section of its own, and so is each run of
+// top-level lines that have no children and all begin with the same token,
+// such as the "visited" systems.
+vector<string> SnapshotStore::Split(const string &text)
+{
+	vector<string> sections;
+	size_t start = 0;
+	// The first token of the last top-level line, if that line had no children.
+	string run;
+	size_t line = 0;
+	while(line < text.size())
+	{
+		size_t end = text.find('\n', line);
+		end = (end == string::npos) ? text.size() : end + 1;
+		
+		if(text[line] != '\t')
+		{
+			bool hasChildren = (end < text.size() && text[end] == '\t');
+			size_t tokenEnd = min(end, text.find_first_of(" \n", line));
+			string token = text.substr(line, tokenEnd - line);
+			if(line > start && (hasChildren || run.empty() || token != run))
+			{
+				sections.push_back(text.substr(start, line - start));
+				start = line;
+			}
+			run = hasChildren ? string() : token;
+		}
+		line = end;
+	}
+	if(start < text.size())
+		sections.push_back(text.substr(start));
+	
+	return sections;
+}
@@ -0,0 +1,50 @@
+/* SnapshotStore.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SNAPSHOT_STORE_H_
+#define SNAPSHOT_STORE_H_
+
+#include <string>
+#include <vector>
+
+
+
+// Class for storing snapshots and backups of saved games without keeping a
+// full copy of each one. Snapshots of the same pilot are mostly identical, so
+// each one is split into sections (a ship, a mission, the conditions, a run of
+// "visited" lines, and so on), and each section is stored in a file named
+// after the hash of its contents. The snapshot itself is then just a short
+// list of those names, and any section that is the same in several snapshots
+// is only stored once.
+class SnapshotStore {
+public:
+	// Save the given text as a snapshot at the given path. If the sections
+	// cannot be stored, the full text is written there instead.
+	static void Write(const std::string &path, const std::string &text);
+	// Check whether the given file contents are a snapshot's list of sections,
+	// rather than a saved game.
+	static bool IsSnapshot(const std::string &contents);
+	// Put the sections of the given snapshot back together. If any of them
+	// are missing or damaged, this returns an empty string.
+	static std::string Reconstruct(const std::string &contents);
+	// Delete any stored sections that are no longer part of any snapshot.
+	static void CollectGarbage();
+	
+	
+private:
+	// Split a saved game into the sections that are stored separately.
+	static std::vector<std::string> Split(const std::string &text);
+};
+
+
+
+#endif
@@ -12,8 +12,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Sound.h"
 
-#include "File.h"
-#include "Files.h"
+#include "MappedFile.h"
+#include "MemoryStats.h"
 
 #ifndef __APPLE__
 #include <AL/al.h>
@@ -21,45 +21,83 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <OpenAL/al.h>
 #endif
 
+#include <vorbis/vorbisfile.h>
+
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <vector>
 
 using namespace std;
 
 namespace {
+	// The contents of a sound file, and how much of them has been read so far.
+	class Input {
+	public:
+		explicit Input(const MappedFile &file);
+		
+		// Copy the given number of bytes, or return false if there are not
+		// that many left.
+		bool Read(void *out, size_t bytes);
+		// Skip ahead, but not past the end of the file.
+		void Skip(size_t bytes);
+		size_t Remaining() const;
+		
+	public:
+		const char *data;
+		size_t size;
+		size_t pos = 0;
+	};
+	
 	// Read a WAV header, and return the size of the data, in bytes. If the file
 	// is an unsupported format (anything but little-endian 16-bit PCM at 44100 HZ),
 	// this will return 0.
-	uint32_t ReadHeader(File &in, uint32_t &frequency);
-	uint32_t Read4(File &in);
-	uint16_t Read2(File &in);
+	uint32_t ReadHeader(Input &in, uint32_t &frequency);
+	uint32_t Read4(Input &in);
+	uint16_t Read2(Input &in);
+	
+	// Read a WAV file, which must be 16-bit mono PCM.
+	bool ReadWav(Input &in, vector<char> &data, uint32_t &frequency);
+	// Decode an Ogg Vorbis file. Stereo files are mixed down to mono, because
+	// OpenAL only positions mono sounds.
+	bool ReadOgg(Input &in, vector<char> &data, uint32_t &frequency);
+	// Let libvorbisfile read an Ogg Vorbis file from memory.
+	size_t ReadOggData(void *out, size_t size, size_t count, void *source);
+	int SeekOggData(void *source, ogg_int64_t offset, int whence);
+	long TellOggData(void *source);
 }
 
 
 
 bool Sound::Load(const string &path, const string &name)
 {
-	if(path.length() < 5 || path.compare(path.length() - 4, 4, ".wav"))
+	if(path.length() < 5)
+		return false;
+	bool isWav = !path.compare(path.length() - 4, 4, ".wav");
+	bool isOgg = !path.compare(path.length() - 4, 4, ".ogg");
+	if(!isWav && !isOgg)
 		return false;
 	this->name = name;
 	
 	isLooped = path[path.length() - 5] == '~';
 	
-	File in(path);
-	if(!in)
+	// Decode the sound straight from the mapped file.
+	MappedFile file(path);
+	if(file.IsEmpty())
 		return false;
+	Input in(file);
+	vector<char> data;
 	uint32_t frequency = 0;
-	uint32_t bytes = ReadHeader(in, frequency);
-	if(!bytes)
-		return false;
-	
-	vector<char> data(bytes);
-	if(fread(&data[0], 1, bytes, in) != bytes)
+	if(!(isWav ? ReadWav(in, data, frequency) : ReadOgg(in, data, frequency)))
 		return false;
 	
-	if(!buffer)
-		alGenBuffers(1, &buffer);
-	alBufferData(buffer, AL_FORMAT_MONO16, &data.front(), bytes, frequency);
+	ALuint id = buffer.load(memory_order_acquire);
+	if(!id)
+		alGenBuffers(1, &id);
+	alBufferData(id, AL_FORMAT_MONO16, &data.front(), data.size(), frequency);
+	buffer.store(id, memory_order_release);
+	MemoryStats::Add(MemoryStats::SOUNDS, static_cast<int64_t>(data.size()) - size);
+	size = data.size();
 	
 	return true;
 }
@@ -75,7 +113,7 @@ const string &Sound::Name() const
 
 unsigned Sound::Buffer() const
 {
-	return buffer;
+	return buffer.load(memory_order_acquire);
 }
 
 
@@ -88,10 +126,43 @@ bool Sound::IsLooping() const
 
 
 namespace {
+	Input::Input(const MappedFile &file)
+		: data(file.Data()), size(file.Size())
+	{
+	}
+	
+	
+	
+	bool Input::Read(void *out, size_t bytes)
+	{
+		if(bytes > Remaining())
+			return false;
+		
+		memcpy(out, data + pos, bytes);
+		pos += bytes;
+		return true;
+	}
+	
+	
+	
+	void Input::Skip(size_t bytes)
+	{
+		pos += min(bytes, Remaining());
+	}
+	
+	
+	
+	size_t Input::Remaining() const
+	{
+		return size - pos;
+	}
+	
+	
+	
 	// Read a WAV header, and return the size of the data, in bytes. If the file
 	// is an unsupported format (anything but little-endian 16-bit PCM at 44100 HZ),
 	// this will return 0.
-	uint32_t ReadHeader(File &in, uint32_t &frequency)
+	uint32_t ReadHeader(Input &in, uint32_t &frequency)
 	{
 		uint32_t chunkID = Read4(in);
 		if(chunkID != 0x46464952) // "RIFF" in big endian.
@@ -106,6 +177,10 @@ namespace {
 		bool foundHeader = false;
 		while(true)
 		{
+			// Give up if the file ends before the data does.
+			if(in.Remaining() < 8)
+				return 0;
+			
 			uint32_t subchunkID = Read4(in);
 			uint32_t subchunkSize = Read4(in);
 			
@@ -124,7 +199,7 @@ namespace {
 				
 				// Skip any further bytes in this chunk.
 				if(subchunkSize > 16)
-					fseek(in, subchunkSize - 16, SEEK_CUR);
+					in.Skip(subchunkSize - 16);
 				
 				if(audioFormat != 1)
 					return 0;
@@ -144,16 +219,120 @@ namespace {
 				return subchunkSize;
 			}
 			else
-				fseek(in, subchunkSize, SEEK_CUR);
+				in.Skip(subchunkSize);
 		}
 	}
 	
 	
 	
-	uint32_t Read4(File &in)
+	// Read a WAV file, which must be 16-bit mono PCM.
+	bool ReadWav(Input &in, vector<char> &data, uint32_t &frequency)
+	{
+		uint32_t bytes = ReadHeader(in, frequency);
+		if(!bytes)
+			return false;
+		
+		data.resize(bytes);
+		return in.Read(&data[0], bytes);
+	}
+	
+	
+	
+	// Decode an Ogg Vorbis file. Stereo files are mixed down to mono, because
+	// OpenAL only positions mono sounds.
+	bool ReadOgg(Input &in, vector<char> &data, uint32_t &frequency)
+	{
+		// The file's contents are owned by the caller, so there is nothing to
+		// do when libvorbisfile closes it.
+		ov_callbacks callbacks = {ReadOggData, SeekOggData, nullptr, TellOggData};
+		OggVorbis_File vorbis;
+		if(ov_open_callbacks(&in, &vorbis, nullptr, 0, callbacks))
+			return false;
+		
+		const vorbis_info *info = ov_info(&vorbis, -1);
+		int channels = info ? info->channels : 0;
+		if(channels != 1 && channels != 2)
+		{
+			ov_clear(&vorbis);
+			return false;
+		}
+		frequency = info->rate;
+		
+		vector<int16_t> samples;
+		ogg_int64_t length = ov_pcm_total(&vorbis, -1);
+		if(length > 0)
+			samples.reserve(length * channels);
+		
+		// Decode little-endian, signed 16-bit samples.
+		char chunk[4096];
+		int bitstream = 0;
+		while(true)
+		{
+			long bytes = ov_read(&vorbis, chunk, sizeof(chunk), 0, 2, 1, &bitstream);
+			// Give up on the whole file if it is corrupted.
+			if(bytes < 0)
+			{
+				ov_clear(&vorbis);
+				return false;
+			}
+			if(!bytes)
+				break;
+			const int16_t *begin = reinterpret_cast<const int16_t *>(chunk);
+			samples.insert(samples.end(), begin, begin + bytes / 2);
+		}
+		ov_clear(&vorbis);
+		
+		if(channels == 2)
+		{
+			for(size_t i = 0; i + 1 < samples.size(); i += 2)
+				samples[i / 2] = (samples[i] + samples[i + 1]) / 2;
+			samples.resize(samples.size() / 2);
+		}
+		if(samples.empty())
+			return false;
+		
+		const char *begin = reinterpret_cast<const char *>(samples.data());
+		data.assign(begin, begin + 2 * samples.size());
+		return true;
+	}
+	
+	
+	
+	size_t ReadOggData(void *out, size_t size, size_t count, void *source)
+	{
+		Input &in = *static_cast<Input *>(source);
+		if(size)
+			count = min(count, in.Remaining() / size);
+		in.Read(out, size * count);
+		return count;
+	}
+	
+	
+	
+	int SeekOggData(void *source, ogg_int64_t offset, int whence)
+	{
+		Input &in = *static_cast<Input *>(source);
+		ogg_int64_t base = (whence == SEEK_CUR) ? in.pos : (whence == SEEK_END) ? in.size : 0;
+		if(base + offset < 0 || base + offset > static_cast<ogg_int64_t>(in.size))
+			return -1;
+		
+		in.pos = base + offset;
+		return 0;
+	}
+	
+	
+	
+	long TellOggData(void *source)
+	{
+		return static_cast<Input *>(source)->pos;
+	}
+	
+	
+	
+	uint32_t Read4(Input &in)
 	{
 		unsigned char data[4];
-		if(fread(data, 1, 4, in) != 4)
+		if(!in.Read(data, 4))
 			return 0;
 		uint32_t result = 0;
 		for(int i = 0; i < 4; ++i)
@@ -163,10 +342,10 @@ namespace {
 	
 	
 	
-	uint16_t Read2(File &in)
+	uint16_t Read2(Input &in)
 	{
 		unsigned char data[2];
-		if(fread(data, 1, 2, in) != 2)
+		if(!in.Read(data, 2))
 			return 0;
 		uint16_t result = 0;
 		for(int i = 0; i < 2; ++i)
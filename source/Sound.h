@@ -13,6 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SOUND_H_
 #define SOUND_H_
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 
@@ -31,7 +33,12 @@ public:
 	
 private:
 	std::string name;
-	unsigned buffer = 0;
+	// The OpenAL buffer ID. Until it is nonzero, the sound is not loaded. It is
+	// only stored once the buffer is filled, because other threads check it to
+	// see whether they can play this sound.
+	std::atomic<unsigned> buffer{0};
+	// The size of the sound data in the buffer, in bytes.
+	int64_t size = 0;
 	bool isLooped = false;
 };
 
@@ -24,8 +24,38 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Random.h"
 #include "UI.h"
 
+#include <cstdint>
+#include <map>
+
 using namespace std;
 
+namespace {
+	// The news items that can be shown on each planet, not counting their
+	// conditions, are only found the first time the player lands there, and
+	// are kept until the universe changes.
+	uint64_t newsRevision = 0;
+	map<const Planet *, vector<const News *>> newsByPlanet;
+	
+	const vector<const News *> &NewsAt(const Planet *planet)
+	{
+		if(newsRevision != GameData::Revision())
+		{
+			newsRevision = GameData::Revision();
+			newsByPlanet.clear();
+		}
+		
+		auto it = newsByPlanet.find(planet);
+		if(it == newsByPlanet.end())
+		{
+			it = newsByPlanet.emplace(planet, vector<const News *>()).first;
+			for(const auto &nit : GameData::SpaceportNews())
+				if(!nit.second.IsEmpty() && nit.second.MatchesLocation(planet))
+					it->second.push_back(&nit.second);
+		}
+		return it->second;
+	}
+}
+
 
 
 SpaceportPanel::SpaceportPanel(PlayerInfo &player)
@@ -111,11 +141,10 @@ void SpaceportPanel::Draw()
 const News *SpaceportPanel::PickNews() const
 {
 	vector<const News *> matches;
-	const Planet *planet = player.GetPlanet();
-	const map<string, int64_t> &conditions = player.Conditions();
-	for(const auto &it : GameData::SpaceportNews())
-		if(!it.second.IsEmpty() && it.second.Matches(planet, conditions))
-			matches.push_back(&it.second);
+	const ConditionsStore &conditions = player.Conditions();
+	for(const News *news : NewsAt(player.GetPlanet()))
+		if(news->MatchesConditions(conditions))
+			matches.push_back(news);
 	
 	return matches.empty() ? nullptr : matches[Random::Int(matches.size())];
 }
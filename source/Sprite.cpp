@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Sprite.h"
 
 #include "ImageBuffer.h"
+#include "MemoryStats.h"
 #include "Preferences.h"
 #include "Screen.h"
 
@@ -20,9 +21,153 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <SDL2/SDL.h>
 
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
+namespace {
+	// Sprites no bigger than this in either dimension can share a texture with
+	// other sprites of the same size.
+	const int MAX_SHARED_SIZE = 256;
+	// Each shared texture has room for twice as many layers as the one before
+	// it for the same size of sprite, up to the number of layers that every
+	// OpenGL 3 implementation supports.
+	const int FIRST_PAGE_LAYERS = 8;
+	const int MAX_PAGE_LAYERS = 256;
+	
+	// An array texture that is shared by several sprites.
+	class Page {
+	public:
+		uint32_t texture = 0;
+		int capacity = 0;
+		int used = 0;
+		// The number of sprites that have not been unloaded yet.
+		int sprites = 0;
+	};
+	// The pages for each sprite size.
+	map<pair<int, int>, vector<Page>> pages;
+	
+	// The number of frames that have been drawn.
+	atomic<int> drawClock(1);
+	
+	// Get how many mipmap levels a texture of the given size should have. Each
+	// level is half the size of the one before it, down to a few pixels.
+	int MipLevels(int width, int height)
+	{
+		int levels = 1;
+		while(width >= 8 && height >= 8)
+		{
+			width /= 2;
+			height /= 2;
+			++levels;
+		}
+		return levels;
+	}
+	
+	// Estimate how much video memory a texture of the given size uses. All the
+	// mipmap levels add up to about a third of the size of the full image.
+	int64_t TextureBytes(int width, int height, int layers)
+	{
+		return (4 * 4 * static_cast<int64_t>(width) * height * layers) / 3;
+	}
+	
+	// Get how much memory the outlines of the given masks use.
+	int64_t MaskBytes(const vector<Mask> &masks)
+	{
+		int64_t bytes = 0;
+		for(const Mask &mask : masks)
+			bytes += mask.Points().capacity() * sizeof(Float2);
+		return bytes;
+	}
+	
+	// Create an empty array texture of the given size, with room for all its
+	// mipmap levels. If the player has chosen to, let the driver store the
+	// texture in whatever compressed format it supports, which uses a quarter
+	// of the memory or less.
+	uint32_t CreateTexture(int width, int height, int layers)
+	{
+		GLint format = Preferences::Has("Compress textures") ? GL_COMPRESSED_RGBA : GL_RGBA8;
+		int levels = MipLevels(width, height);
+		uint32_t texture = 0;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		
+		// Use linear interpolation between the two mipmap levels closest to the
+		// size the sprite is drawn at, and no wrapping.
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		
+		// Allocate every level. The image data is filled in later.
+		for(int level = 0; level < levels; ++level)
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, // target, mipmap level, internal format,
+				width, height, layers, // width, height, depth,
+				0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr); // border, input format, data type, data.
+			width /= 2;
+			height /= 2;
+		}
+		return texture;
+	}
+	
+	// Upload the given frames to the bound texture, starting at the given
+	// layer, and then shrink them to fill in each of the mipmap levels. The
+	// buffer's contents are no longer needed after this, so it is shrunk in
+	// place.
+	void Upload(ImageBuffer &buffer, int firstLayer)
+	{
+		int levels = MipLevels(buffer.Width(), buffer.Height());
+		for(int level = 0; level < levels; ++level)
+		{
+			if(level)
+				buffer.ShrinkToHalfSize();
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, firstLayer,
+				buffer.Width(), buffer.Height(), buffer.Frames(), GL_BGRA, GL_UNSIGNED_BYTE, buffer.Pixels());
+		}
+	}
+	
+	// Find a shared page with room for the given number of frames of the given
+	// size, creating one if necessary.
+	Page &FindPage(int width, int height, int frames)
+	{
+		vector<Page> &list = pages[make_pair(width, height)];
+		for(Page &page : list)
+			if(page.capacity - page.used >= frames)
+				return page;
+		
+		Page page;
+		page.capacity = max(frames, min(MAX_PAGE_LAYERS, FIRST_PAGE_LAYERS << min<size_t>(list.size(), 8)));
+		page.texture = CreateTexture(width, height, page.capacity);
+		MemoryStats::Add(MemoryStats::TEXTURES, TextureBytes(width, height, page.capacity));
+		list.push_back(page);
+		return list.back();
+	}
+	
+	// Free a sprite's place in a shared page. The texture is only deleted
+	// once none of the sprites in it are still loaded.
+	void ReleasePage(uint32_t texture)
+	{
+		for(auto &it : pages)
+			for(auto pit = it.second.begin(); pit != it.second.end(); ++pit)
+				if(pit->texture == texture)
+				{
+					if(!--pit->sprites)
+					{
+						glDeleteTextures(1, &pit->texture);
+						MemoryStats::Add(MemoryStats::TEXTURES,
+							-TextureBytes(it.first.first, it.first.second, pit->capacity));
+						it.second.erase(pit);
+					}
+					return;
+				}
+	}
+}
+
 
 
 Sprite::Sprite(const string &name)
@@ -40,7 +185,7 @@ const string &Sprite::Name() const
 
 
 // Upload the given frames. The given buffer will be cleared afterwards.
-void Sprite::AddFrames(ImageBuffer &buffer, bool is2x)
+void Sprite::AddFrames(ImageBuffer &buffer, bool is2x, bool uploadTexture)
 {
 	// Do nothing if the buffer is empty.
 	if(!buffer.Pixels())
@@ -53,25 +198,42 @@ void Sprite::AddFrames(ImageBuffer &buffer, bool is2x)
 		height = buffer.Height();
 		frames = buffer.Frames();
 	}
+	if(!uploadTexture)
+	{
+		buffer.Clear();
+		return;
+	}
 	
 	// Check whether this sprite is large enough to require size reduction.
 	if(Preferences::Has("Reduce large graphics") && buffer.Width() * buffer.Height() >= 1000000)
 		buffer.ShrinkToHalfSize();
 	
-	// Upload the images as a single array texture.
-	glGenTextures(1, &texture[is2x]);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, texture[is2x]);
-	
-	// Use linear interpolation and no wrapping.
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	// If this sprite was already loaded, replace its old texture.
+	Release(is2x);
 	
-	// Upload the image data.
-	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, // target, mipmap level, internal format,
-		buffer.Width(), buffer.Height(), buffer.Frames(), // width, height, depth,
-		0, GL_BGRA, GL_UNSIGNED_BYTE, buffer.Pixels()); // border, input format, data type, data.
+	// Small sprites are added to a texture shared with other sprites of the
+	// same size. Larger ones get a texture of their own.
+	int frameCount = buffer.Frames();
+	isShared[is2x] = (buffer.Width() <= MAX_SHARED_SIZE && buffer.Height() <= MAX_SHARED_SIZE
+		&& frameCount <= MAX_PAGE_LAYERS);
+	if(isShared[is2x])
+	{
+		Page &page = FindPage(buffer.Width(), buffer.Height(), frameCount);
+		texture[is2x] = page.texture;
+		firstLayer[is2x] = page.used;
+		page.used += frameCount;
+		++page.sprites;
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture[is2x]);
+	}
+	else
+	{
+		// Upload the images as a single array texture.
+		texture[is2x] = CreateTexture(buffer.Width(), buffer.Height(), frameCount);
+		firstLayer[is2x] = 0;
+		memory[is2x] = TextureBytes(buffer.Width(), buffer.Height(), frameCount);
+		MemoryStats::Add(MemoryStats::TEXTURES, memory[is2x]);
+	}
+	Upload(buffer, firstLayer[is2x]);
 	
 	// Unbind the texture.
 	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
@@ -82,10 +244,23 @@ void Sprite::AddFrames(ImageBuffer &buffer, bool is2x)
 
 
 
+// Upload a low resolution version of this sprite's image. Its size is the
+// preview's size times the given scale, which may be off by a few pixels
+// until the full sprite is loaded.
+void Sprite::AddPreview(ImageBuffer &buffer, int scale)
+{
+	AddFrames(buffer, false);
+	width *= scale;
+	height *= scale;
+}
+
+
+
 // Move the given masks into this sprite's internal storage. The given
 // vector will be cleared.
 void Sprite::AddMasks(vector<Mask> &masks)
 {
+	MemoryStats::Add(MemoryStats::MASKS, MaskBytes(masks) - MaskBytes(this->masks));
 	this->masks.swap(masks);
 	masks.clear();
 }
@@ -95,9 +270,10 @@ void Sprite::AddMasks(vector<Mask> &masks)
 // Free up all textures loaded for this sprite.
 void Sprite::Unload()
 {
-	glDeleteTextures(2, texture);
-	texture[0] = texture[1] = 0;
+	Release(false);
+	Release(true);
 	
+	MemoryStats::Add(MemoryStats::MASKS, -MaskBytes(masks));
 	masks.clear();
 	width = 0.f;
 	height = 0.f;
@@ -106,6 +282,76 @@ void Sprite::Unload()
 
 
 
+// Free the texture for just one resolution.
+void Sprite::UnloadTexture(bool is2x)
+{
+	Release(is2x);
+}
+
+
+
+// Check whether a texture for the given resolution has been uploaded.
+bool Sprite::HasTexture(bool is2x) const
+{
+	return texture[is2x];
+}
+
+
+
+// Free the textures that are not shared with other sprites. The sprite can
+// still be drawn afterwards, but nothing will show until it is loaded again.
+bool Sprite::UnloadTextures()
+{
+	bool isUnloaded = false;
+	for(int i = 0; i < 2; ++i)
+		if(texture[i] && !isShared[i])
+		{
+			Release(i);
+			isUnloaded = true;
+		}
+	return isUnloaded;
+}
+
+
+
+// Get how many bytes of video memory this sprite's own textures use.
+size_t Sprite::TextureMemory() const
+{
+	return memory[0] + memory[1];
+}
+
+
+
+// Advance the clock that is used to track when each sprite was last drawn.
+void Sprite::AdvanceDrawClock()
+{
+	++drawClock;
+}
+
+
+
+int Sprite::DrawClock()
+{
+	return drawClock;
+}
+
+
+
+int Sprite::LastDrawn() const
+{
+	return lastDrawn;
+}
+
+
+
+// Mark this sprite as being in use in the current frame.
+void Sprite::MarkInUse() const
+{
+	lastDrawn.store(drawClock.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+
+
 // Get the width, in pixels, of the 1x image.
 float Sprite::Width() const
 {
@@ -150,7 +396,26 @@ uint32_t Sprite::Texture() const
 // Get the index of the texture for the given high DPI mode.
 uint32_t Sprite::Texture(bool isHighDPI) const
 {
-	return (isHighDPI && texture[1]) ? texture[1] : texture[0];
+	MarkInUse();
+	return ((isHighDPI || !texture[0]) && texture[1]) ? texture[1] : texture[0];
+}
+
+
+
+// Get the layer of the texture that this sprite's first frame is in, based on
+// whether the screen is high DPI or not.
+float Sprite::FirstLayer() const
+{
+	return FirstLayer(Screen::IsHighResolution());
+}
+
+
+
+// Get the layer of the texture that this sprite's first frame is in, for the
+// given high DPI mode.
+float Sprite::FirstLayer(bool isHighDPI) const
+{
+	return ((isHighDPI || !texture[0]) && texture[1]) ? firstLayer[1] : firstLayer[0];
 }
 
 
@@ -165,3 +430,21 @@ const Mask &Sprite::GetMask(int frame) const
 	// Assume that if a masks array exists, it has the right number of frames.
 	return masks[frame % masks.size()];
 }
+
+
+
+// Free the texture for the given resolution.
+void Sprite::Release(bool is2x)
+{
+	if(isShared[is2x])
+		ReleasePage(texture[is2x]);
+	else if(texture[is2x])
+	{
+		glDeleteTextures(1, &texture[is2x]);
+		MemoryStats::Add(MemoryStats::TEXTURES, -static_cast<int64_t>(memory[is2x]));
+	}
+	texture[is2x] = 0;
+	firstLayer[is2x] = 0;
+	isShared[is2x] = false;
+	memory[is2x] = 0;
+}
@@ -16,6 +16,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Mask.h"
 #include "Point.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -26,10 +28,10 @@ class ImageBuffer;
 
 // Class representing a drawable sprite. A sprite can have multiple frames, for
 // animation. Certain sprites will also include a "mask" that can be used to
-// check whether something has collided with them. Each frame is stored in a
-// separate OpenGL texture object. This may not be as efficient as sprite
-// sheets, but with modern graphics cards it will not matter much and it makes
-// working with the graphics a lot simpler.
+// check whether something has collided with them. The frames are stored as
+// consecutive layers of an OpenGL array texture. Small sprites that have the
+// same dimensions share an array texture, so that they can be drawn together
+// without having to switch textures.
 class Sprite {
 public:
 	explicit Sprite(const std::string &name = "");
@@ -37,12 +39,37 @@ public:
 	const std::string &Name() const;
 	
 	// Upload the given frames. The given buffer will be cleared afterwards.
-	void AddFrames(ImageBuffer &buffer, bool is2x);
+	// If there is no OpenGL context, only the sprite's size is recorded.
+	void AddFrames(ImageBuffer &buffer, bool is2x, bool uploadTexture = true);
+	// Upload a low resolution version of this sprite's image, which is drawn
+	// at the given scale until the full sprite is loaded.
+	void AddPreview(ImageBuffer &buffer, int scale);
 	// Move the given masks into this sprite's internal storage. The given
 	// vector will be cleared.
 	void AddMasks(std::vector<Mask> &masks);
 	// Free up all textures loaded for this sprite.
 	void Unload();
+	// Free the texture for just one resolution, because the screen is using
+	// the other one.
+	void UnloadTexture(bool is2x);
+	// Check whether a texture for the given resolution has been uploaded.
+	bool HasTexture(bool is2x) const;
+	// Free only the textures that this sprite does not share with any others,
+	// but keep its size and masks, so that it can still be used for collisions
+	// until it is loaded again. Return true if anything was freed.
+	bool UnloadTextures();
+	// Get how many bytes of video memory the textures that UnloadTextures()
+	// would free are using.
+	size_t TextureMemory() const;
+	
+	// Sprites keep track of the last time they were drawn, as counted by the
+	// number of times the draw clock has been advanced (once per frame).
+	static void AdvanceDrawClock();
+	static int DrawClock();
+	int LastDrawn() const;
+	// Mark this sprite as being in use in the current frame, so that it will be
+	// loaded if it is not already. Drawing a sprite does this automatically.
+	void MarkInUse() const;
 	
 	// Image dimensions, in pixels.
 	float Width() const;
@@ -56,18 +83,34 @@ public:
 	Point Center() const;
 	
 	// Get the texture index, either looking it up based on the Screen's HighDPI
-	// setting or specifying it manually.
+	// setting or specifying it manually. If only the other resolution has been
+	// uploaded, that texture is used instead. This also marks the sprite as
+	// being drawn in the current frame.
 	uint32_t Texture() const;
 	uint32_t Texture(bool isHighDPI) const;
+	// Get the layer of the texture that this sprite's first frame is in.
+	float FirstLayer() const;
+	float FirstLayer(bool isHighDPI) const;
 	// Get the collision mask for the given frame of the animation.
 	const Mask &GetMask(int frame = 0) const;
 	
 	
+private:
+	// Free the texture for the given resolution.
+	void Release(bool is2x);
+	
+	
 private:
 	std::string name;
 	
 	uint32_t texture[2] = {0, 0};
+	int firstLayer[2] = {0, 0};
+	bool isShared[2] = {false, false};
+	size_t memory[2] = {0, 0};
 	std::vector<Mask> masks;
+	// Sprites are drawn from both the main thread and the game's calculation
+	// thread.
+	mutable std::atomic<int> lastDrawn{0};
 	
 	float width = 0.f;
 	float height = 0.f;
@@ -15,36 +15,72 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ImageBuffer.h"
 #include "ImageSet.h"
 #include "Mask.h"
+#include "MaskCache.h"
+#include "Preferences.h"
+#include "Profiler.h"
+#include "Screen.h"
 #include "Sprite.h"
 #include "SpriteSet.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
-#include <functional>
+#include <chrono>
+#include <vector>
 
 using namespace std;
 
+namespace {
+	// Sprites are only unloaded if they have not been drawn for this many
+	// frames, and the sprites are only checked this often.
+	const int MIN_IDLE_FRAMES = 600;
+	const int EVICTION_INTERVAL = 60;
+	// When sprites are loaded while the game is running, only spend about half
+	// of each frame uploading them, so that the game stays responsive.
+	const chrono::milliseconds UPLOAD_TIME(8);
+}
+
 
 
-// Constructor, which allocates worker threads.
+// Constructor. Getting the shared worker threads here makes sure that they are
+// created before this object, and so are not destroyed until after it.
 SpriteQueue::SpriteQueue()
+	: workers(ThreadPool::Shared())
 {
-	threads.resize(max(4u, thread::hardware_concurrency()));
-	for(thread &t : threads)
-		t = thread(ref(*this));
 }
 
 
 
-// Destructor, which waits for all worker threads to wrap up.
+// Destructor, which waits for all the read tasks to wrap up.
 SpriteQueue::~SpriteQueue()
+{
+	unique_lock<mutex> lock(readMutex);
+	added = -1;
+	while(running)
+		readCondition.wait(lock);
+}
+
+
+
+// Use the given cache file for the collision masks.
+void SpriteQueue::CacheMasks(const string &path)
+{
+	lock_guard<mutex> lock(readMutex);
+	maskCache.reset(new MaskCache(path));
+}
+
+
+
+// Only read the sprites' sizes and collision masks, without uploading any
+// textures. This is for running the game without a window.
+void SpriteQueue::SkipTextures()
 {
 	{
-		lock_guard<mutex> lock(readMutex);
-		added = -1;
+		lock_guard<mutex> lock(loadMutex);
+		skipTextures = true;
 	}
-	readCondition.notify_all();
-	for(thread &t : threads)
-		t.join();
+	// Without textures, only the 1x images are needed.
+	lock_guard<mutex> lock(readMutex);
+	read2x = false;
 }
 
 
@@ -58,10 +94,27 @@ void SpriteQueue::Add(const shared_ptr<ImageSet> &images)
 		if(added < 0)
 			return;
 		
-		toRead.push(images);
+		toRead.emplace(images);
 		++added;
+		++running;
+	}
+	workers.Run([this]() { ReadNext(); });
+}
+
+
+
+// Upload a low resolution version of a sprite that has not been loaded yet.
+// This must be called in the main thread.
+void SpriteQueue::Preview(const shared_ptr<ImageSet> &images)
+{
+	{
+		lock_guard<mutex> lock(loadMutex);
+		if(skipTextures)
+			return;
 	}
-	readCondition.notify_one();
+	Sprite *sprite = SpriteSet::Modify(images->Name());
+	if(!sprite->HasTexture(false) && !sprite->HasTexture(true))
+		images->UploadPreview(sprite);
 }
 
 
@@ -79,7 +132,9 @@ void SpriteQueue::Unload(const string &name)
 double SpriteQueue::Progress()
 {
 	unique_lock<mutex> lock(loadMutex);
-	return DoLoad(lock);
+	Sprite::AdvanceDrawClock();
+	Evict();
+	return DoLoad(lock, true);
 }
 
 
@@ -104,53 +159,110 @@ void SpriteQueue::Finish()
 
 
 
-// Thread entry point.
-void SpriteQueue::operator()()
+// Read the next item in the queue.
+void SpriteQueue::ReadNext()
 {
-	while(true)
+	unique_lock<mutex> lock(readMutex);
+	// To signal that it is time to quit, "added" is set to -1. Any tasks that
+	// have not started by then do nothing.
+	if(added >= 0 && (!toRead.empty() || !toReadFrames.empty()))
 	{
-		unique_lock<mutex> lock(readMutex);
-		while(true)
-		{
-			// To signal this thread that it is time for it to quit, we set
-			// "added" to -1.
-			if(added < 0)
-				return;
-			if(toRead.empty())
-				break;
-			
-			// Extract the one item we should work on reading right now.
-			shared_ptr<ImageSet> imageSet = toRead.front();
+		// Extract the one item we should work on reading right now.
+		bool isFrame = !toReadFrames.empty();
+		Item item = isFrame ? toReadFrames.front() : toRead.front();
+		if(isFrame)
+			toReadFrames.pop();
+		else
 			toRead.pop();
+		
+		// The mask cache may only be replaced while the lock is held.
+		MaskCache *cache = maskCache.get();
+		bool read2x = this->read2x;
+		
+		// It's now safe to add to the lists.
+		lock.unlock();
+		
+		// Load this part of the sprite. If the sprite is complete, it is
+		// ready to be uploaded.
+		if(Read(item, cache, read2x, lock))
+		{
+			// Shrinking the images for each of the textures' mipmap levels does
+			// not need OpenGL, so do it here rather than in the main thread.
+			unique_lock<mutex> loadLock(loadMutex);
+			bool prepareMipmaps = !skipTextures;
+			loadLock.unlock();
+			if(prepareMipmaps)
+				item.images->PrepareMipmaps();
 			
-			// It's now safe to add to the lists.
-			lock.unlock();
-			
-			// Load the sprite.
-			imageSet->Load();
-			
-			{
-				// The texture must be uploaded to OpenGL in the main thread.
-				unique_lock<mutex> lock(loadMutex);
-				toLoad.push(imageSet);
-			}
-			loadCondition.notify_one();
-			
-			lock.lock();
+			// The texture must be uploaded to OpenGL in the main thread.
+			loadLock.lock();
+			toLoad.push(item.images);
 		}
+		loadCondition.notify_one();
 		
-		readCondition.wait(lock);
+		lock.lock();
 	}
+	if(!--running)
+		readCondition.notify_all();
 }
 
 
 
-double SpriteQueue::DoLoad(unique_lock<mutex> &lock)
+// Read the given part of an image set. The given lock is for the read mutex,
+// and is not held at the start.
+bool SpriteQueue::Read(const Item &item, MaskCache *cache, bool read2x, unique_lock<mutex> &lock)
 {
+	Profiler::Scope profile("Decode image");
+	ImageSet &images = *item.images;
+	if(item.frame)
+	{
+		images.LoadFrame(item.frame, cache);
+		
+		lock.lock();
+		auto it = remaining.find(&images);
+		bool isDone = !--it->second;
+		if(isDone)
+			remaining.erase(it);
+		lock.unlock();
+		return isDone;
+	}
+	
+	// Read the first frame. If there are more, queue them up so that other
+	// threads can help to read them.
+	size_t frames = images.Frames();
+	if(!images.LoadFirst(cache, read2x) || frames < 2)
+	{
+		for(size_t i = 1; i < frames; ++i)
+			images.LoadFrame(i, cache);
+		return true;
+	}
+	
+	lock.lock();
+	remaining[&images] = frames - 1;
+	for(size_t i = 1; i < frames; ++i)
+		toReadFrames.emplace(item.images, i);
+	running += frames - 1;
+	lock.unlock();
+	for(size_t i = 1; i < frames; ++i)
+		workers.Run([this]() { ReadNext(); });
+	return false;
+}
+
+
+
+// Upload the sprites that have been read. If the time is limited, stop once
+// enough time has been spent that the frame rate would suffer.
+double SpriteQueue::DoLoad(unique_lock<mutex> &lock, bool isTimeLimited)
+{
+	auto start = chrono::steady_clock::now();
+	if(!skipTextures)
+		UpdateResolution();
+	
 	while(!toUnload.empty())
 	{
 		Sprite *sprite = SpriteSet::Modify(toUnload.front());
 		toUnload.pop();
+		Forget(sprite);
 		
 		lock.unlock();
 		sprite->Unload();
@@ -162,14 +274,23 @@ double SpriteQueue::DoLoad(unique_lock<mutex> &lock)
 		// Extract the one item we should work on uploading right now.
 		shared_ptr<ImageSet> imageSet = toLoad.front();
 		toLoad.pop();
+		bool uploadTextures = !skipTextures;
 		
 		// It's now safe to modify the lists.
 		lock.unlock();
 		
-		imageSet->Upload(SpriteSet::Modify(imageSet->Name()));
+		Sprite *sprite = SpriteSet::Modify(imageSet->Name());
+		{
+			Profiler::Scope profile("Upload sprite");
+			imageSet->Upload(sprite, uploadTextures, isHighResolution);
+		}
 		
 		lock.lock();
+		Track(sprite, imageSet);
 		++completed;
+		
+		if(isTimeLimited && chrono::steady_clock::now() - start > UPLOAD_TIME)
+			break;
 	}
 	
 	// Wait until we have completed loading of as many sprites as we have added.
@@ -177,6 +298,127 @@ double SpriteQueue::DoLoad(unique_lock<mutex> &lock)
 	unique_lock<mutex> readLock(readMutex);
 	// Special cases: we're bailing out, or we are done.
 	if(added <= 0 || added == completed)
+	{
+		// Nothing is being read now, so the mask cache is no longer in use.
+		if(maskCache)
+		{
+			maskCache->Save();
+			maskCache.reset();
+		}
 		return 1.;
+	}
 	return static_cast<double>(completed) / static_cast<double>(added);
 }
+
+
+
+// Check whether the screen's resolution has changed since the sprites were
+// uploaded. This is only called in the main thread, once the window exists.
+void SpriteQueue::UpdateResolution()
+{
+	bool isHigh = Screen::IsHighResolution();
+	if(isResolutionKnown && isHigh == isHighResolution)
+		return;
+	
+	bool isChanged = isResolutionKnown;
+	isResolutionKnown = true;
+	isHighResolution = isHigh;
+	{
+		lock_guard<mutex> readLock(readMutex);
+		read2x = isHigh;
+	}
+	if(!isChanged)
+		return;
+	
+	// Reload any sprite that does not have a texture for the new resolution,
+	// except for the evicted ones, which will be reloaded when they are drawn.
+	// They stop being tracked until they are uploaded again, so that they will
+	// not be added to the queue twice.
+	for(auto it = loaded.begin(); it != loaded.end(); )
+	{
+		if(!evicted.count(it->first) && !it->first->HasTexture(isHigh && it->second->Has2x()))
+		{
+			it->second->SkipMasks();
+			Add(it->second);
+			it = loaded.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+
+
+// Start keeping track of a sprite that was just uploaded.
+void SpriteQueue::Track(Sprite *sprite, const shared_ptr<ImageSet> &images)
+{
+	Forget(sprite);
+	loaded[sprite] = images;
+	size_t memory = sprite->TextureMemory();
+	if(!memory)
+		return;
+	
+	resident[sprite] = make_pair(images, memory);
+	residentMemory += memory;
+}
+
+
+
+// Stop keeping track of a sprite, because it has been unloaded or replaced.
+void SpriteQueue::Forget(Sprite *sprite)
+{
+	loaded.erase(sprite);
+	evicted.erase(sprite);
+	auto it = resident.find(sprite);
+	if(it != resident.end())
+	{
+		residentMemory -= it->second.second;
+		resident.erase(it);
+	}
+}
+
+
+
+// Reload any unloaded sprites that are being drawn again, and if the sprites
+// are using more memory than the limit, unload the ones that have gone the
+// longest without being drawn.
+void SpriteQueue::Evict()
+{
+	int now = Sprite::DrawClock();
+	for(auto it = evicted.begin(); it != evicted.end(); )
+	{
+		if(it->first->LastDrawn() >= it->second.second)
+		{
+			it->second.first->SkipMasks();
+			Add(it->second.first);
+			loaded.erase(it->first);
+			it = evicted.erase(it);
+		}
+		else
+			++it;
+	}
+	
+	size_t limit = static_cast<size_t>(Preferences::TextureMemory()) << 20;
+	if(!limit || residentMemory <= limit || now - lastEviction < EVICTION_INTERVAL)
+		return;
+	lastEviction = now;
+	
+	vector<pair<int, Sprite *>> idle;
+	for(const auto &it : resident)
+		if(now - it.first->LastDrawn() >= MIN_IDLE_FRAMES)
+			idle.emplace_back(it.first->LastDrawn(), it.first);
+	sort(idle.begin(), idle.end());
+	
+	for(const pair<int, Sprite *> &it : idle)
+	{
+		if(residentMemory <= limit)
+			break;
+		
+		Sprite *sprite = it.second;
+		auto rit = resident.find(sprite);
+		residentMemory -= rit->second.second;
+		evicted[sprite] = make_pair(rit->second.first, now);
+		resident.erase(rit);
+		sprite->UnloadTextures();
+	}
+}
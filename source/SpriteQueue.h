@@ -19,18 +19,21 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <mutex>
 #include <queue>
 #include <string>
-#include <thread>
+#include <utility>
 #include <vector>
 
 class ImageBuffer;
 class ImageSet;
 class Mask;
+class MaskCache;
 class Sprite;
+class ThreadPool;
 
 
 
-// Class for queuing up a list of sprites to be loaded from the disk, with a set of
-// worker threads that begins loading them as soon as they are added.
+// Class for queuing up a list of sprites to be loaded from the disk. Each one is
+// read by a background task on the shared worker threads, which begins as soon
+// as it is added.
 class SpriteQueue {
 public:
 	SpriteQueue();
@@ -42,8 +45,18 @@ public:
 	SpriteQueue &operator=(const SpriteQueue &other) = delete;
 	SpriteQueue &operator=(SpriteQueue &&other) = delete;
 	
+	// Use the cache file at the given path for the collision masks of the
+	// sprites that are added after this. Once they have all been loaded, the
+	// cache is saved and no longer used.
+	void CacheMasks(const std::string &path);
+	// Only read the sprites' sizes and collision masks, without uploading any
+	// textures. This is for running the game without a window.
+	void SkipTextures();
 	// Add a sprite to load.
 	void Add(const std::shared_ptr<ImageSet> &images);
+	// If the given image set's sprite has not been loaded yet, upload a low
+	// resolution version of it right away, to draw until it is loaded.
+	void Preview(const std::shared_ptr<ImageSet> &images);
 	// Unload the texture for the given sprite (to free up memory).
 	void Unload(const std::string &name);
 	// Upload more images and find out our percent completion.
@@ -52,32 +65,86 @@ public:
 	// Finish loading.
 	void Finish();
 	
-	// Thread entry point.
-	void operator()();
+	
+private:
+	// A piece of work for the worker threads: either starting to read an image
+	// set, or reading one of its frames after the first.
+	class Item {
+	public:
+		Item(const std::shared_ptr<ImageSet> &images, size_t frame = 0) : images(images), frame(frame) {}
+		
+		std::shared_ptr<ImageSet> images;
+		// If this is zero, read the first frame and then queue up the others.
+		size_t frame;
+	};
 	
 	
 private:
-	double DoLoad(std::unique_lock<std::mutex> &lock);
+	// Task that reads the next item in the queue. One is started for each
+	// item that is added to the queue.
+	void ReadNext();
+	// Upload the sprites that have been read. If the time is limited, stop
+	// once enough time has been spent that the frame rate would suffer.
+	double DoLoad(std::unique_lock<std::mutex> &lock, bool isTimeLimited = false);
+	// Check whether the screen's resolution has changed, and if so, reload
+	// the sprites that do not have a texture for the new resolution.
+	void UpdateResolution();
+	// Keep track of how much memory the uploaded sprites are using, unloading
+	// the ones that have not been drawn recently if that is over the limit
+	// and reloading any of those that have been drawn since then.
+	void Track(Sprite *sprite, const std::shared_ptr<ImageSet> &images);
+	void Forget(Sprite *sprite);
+	void Evict();
+	// Read the given item, and return true if that was the last part of its
+	// image set that needed to be read.
+	bool Read(const Item &item, MaskCache *cache, bool read2x, std::unique_lock<std::mutex> &lock);
 	
 	
 private:
-	// These are the image sets that need to be loaded from disk.
-	std::queue<std::shared_ptr<ImageSet>> toRead;
+	// These are the image sets that need to be loaded from disk. Frames of
+	// image sets that are already being read are kept in a separate queue,
+	// so that they will be finished before any new sets are started.
+	std::queue<Item> toRead;
+	std::queue<Item> toReadFrames;
+	// How many frames are left to read for each image set that was split up.
+	std::map<const ImageSet *, size_t> remaining;
 	std::mutex readMutex;
 	std::condition_variable readCondition;
 	int added = 0;
+	// How many read tasks have been started but not finished.
+	int running = 0;
+	std::unique_ptr<MaskCache> maskCache;
+	// Whether to read the @2x images. Until the screen's resolution is known,
+	// both resolutions are read.
+	bool read2x = true;
 	
 	// These image sets have been loaded from disk but have not been uplodaed.
 	std::queue<std::shared_ptr<ImageSet>> toLoad;
 	std::mutex loadMutex;
 	std::condition_variable loadCondition;
 	int completed = 0;
+	bool skipTextures = false;
+	// The screen resolution that textures are being uploaded for.
+	bool isResolutionKnown = false;
+	bool isHighResolution = false;
 	
 	// These sprites must be unloaded to reclaim GPU memory.
 	std::queue<std::string> toUnload;
 	
-	// Worker threads for loading sprites from disk.
-	std::vector<std::thread> threads;
+	// Every sprite that has been uploaded, and the images it was loaded from,
+	// in case it must be loaded again in a different resolution.
+	std::map<Sprite *, std::shared_ptr<ImageSet>> loaded;
+	// These sprites have textures of their own that can be unloaded if the
+	// texture memory limit is reached, and how much memory each of them uses.
+	std::map<Sprite *, std::pair<std::shared_ptr<ImageSet>, size_t>> resident;
+	size_t residentMemory = 0;
+	// These sprites have had their textures unloaded, and the draw clock
+	// value at the time that happened.
+	std::map<Sprite *, std::pair<std::shared_ptr<ImageSet>, int>> evicted;
+	int lastEviction = 0;
+	
+	// The worker threads that run the read tasks.
+	ThreadPool &workers;
 };
 
 #endif
@@ -12,92 +12,121 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "SpriteShader.h"
 
+#include "GpuProfiler.h"
 #include "Point.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Shader.h"
 #include "Sprite.h"
 
 #include <vector>
-#include <sstream>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint frameI;
-	GLint frameCountI;
-	GLint positionI;
-	GLint transformI;
-	GLint blurI;
-	GLint clipI;
-	GLint alphaI;
-	GLint swizzlerI;
 	
 	GLuint vao;
 	GLuint vbo;
-
-	const vector<vector<GLint>> SWIZZLE = {
-		{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}, // red + yellow markings (republic)
-		{GL_RED, GL_BLUE, GL_GREEN, GL_ALPHA}, // red + magenta markings
-		{GL_GREEN, GL_RED, GL_BLUE, GL_ALPHA}, // green + yellow (freeholders)
-		{GL_BLUE, GL_RED, GL_GREEN, GL_ALPHA}, // green + cyan
-		{GL_GREEN, GL_BLUE, GL_RED, GL_ALPHA}, // blue + magenta (syndicate)
-		{GL_BLUE, GL_GREEN, GL_RED, GL_ALPHA}, // blue + cyan (merchant)
-		{GL_GREEN, GL_BLUE, GL_BLUE, GL_ALPHA}, // red and black (pirate)
-		{GL_BLUE, GL_ZERO, GL_ZERO, GL_ALPHA},  // red only (cloaked)
-		{GL_ZERO, GL_ZERO, GL_ZERO, GL_ALPHA}  // black only (outline)
+	
+	// Each vertex has its corner (x, y), and then a copy of the data for the
+	// sprite that it is part of: the position (2 floats), the transform (4),
+	// the blur (2), and the clip, alpha, frame, frame count, the layer of the
+	// texture that the sprite's first frame is in, and the color swizzle.
+	constexpr int FLOATS_PER_VERTEX = 16;
+	// Each sprite is drawn as two triangles.
+	const float CORNERS[] = {
+		-.5f, -.5f,
+		-.5f,  .5f,
+		 .5f, -.5f,
+		-.5f,  .5f,
+		 .5f, -.5f,
+		 .5f,  .5f
 	};
+	
+	// Consecutive sprites that use the same texture are collected here, so they
+	// can all be drawn with a single draw call. Small sprites of the same size
+	// share a texture, so they can be batched together even if they are
+	// different sprites.
+	vector<float> vertices;
+	uint32_t batchTexture = 0;
+	
+	// The number of different color swizzles. The shader maps each one to a
+	// different arrangement of the color channels:
+	// 0: red + yellow markings (republic)
+	// 1: red + magenta markings
+	// 2: green + yellow (freeholders)
+	// 3: green + cyan
+	// 4: blue + magenta (syndicate)
+	// 5: blue + cyan (merchant)
+	// 6: red and black (pirate)
+	// 7: red only (cloaked)
+	// 8: black only (outline)
+	const uint32_t SWIZZLES = 9;
 }
 
-bool SpriteShader::useShaderSwizzle = false;
+
 
 // Initialize the shaders.
-void SpriteShader::Init(bool useShaderSwizzle)
+void SpriteShader::Init()
 {
-	SpriteShader::useShaderSwizzle = useShaderSwizzle;
-	
 	static const char *vertexCode =
 		"// vertex sprite shader\n"
 		"uniform vec2 scale;\n"
-		"uniform vec2 position;\n"
-		"uniform mat2 transform;\n"
-		"uniform vec2 blur;\n"
-		"uniform float clip;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 position;\n"
+		"in vec4 transform;\n"
+		"in vec2 blur;\n"
+		"in float clip;\n"
+		"in float alpha;\n"
+		"in float frame;\n"
+		"in float frameCount;\n"
+		"in float firstLayer;\n"
+		"in float swizzle;\n"
 		"out vec2 fragTexCoord;\n"
+		"out vec2 fragBlur;\n"
+		"out float fragAlpha;\n"
+		"out float fragFrame;\n"
+		"out float fragFrameCount;\n"
+		"out float fragFirstLayer;\n"
+		"flat out int fragSwizzle;\n"
 		
 		"void main() {\n"
 		"  vec2 blurOff = 2 * vec2(vert.x * abs(blur.x), vert.y * abs(blur.y));\n"
-		"  gl_Position = vec4((transform * (vert + blurOff) + position) * scale, 0, 1);\n"
+		"  gl_Position = vec4((mat2(transform.xy, transform.zw) * (vert + blurOff) + position) * scale, 0, 1);\n"
 		"  vec2 texCoord = vert + vec2(.5, .5);\n"
 		"  fragTexCoord = vec2(texCoord.x, max(clip, texCoord.y)) + blurOff;\n"
+		"  fragBlur = blur;\n"
+		"  fragAlpha = alpha;\n"
+		"  fragFrame = frame;\n"
+		"  fragFrameCount = frameCount;\n"
+		"  fragFirstLayer = firstLayer;\n"
+		"  fragSwizzle = int(swizzle);\n"
 		"}\n";
 	
-	ostringstream fragmentCodeStream;
-	fragmentCodeStream <<
+	static const char *fragmentCode =
 		"// fragment sprite shader\n"
 		"uniform sampler2DArray tex;\n"
-		"uniform float frame;\n"
-		"uniform float frameCount;\n"
-		"uniform vec2 blur;\n";
-	if(useShaderSwizzle) fragmentCodeStream <<
-		"uniform int swizzler;\n";
-	fragmentCodeStream <<
-		"uniform float alpha;\n"
 		"const int range = 5;\n"
 		
 		"in vec2 fragTexCoord;\n"
+		"in vec2 fragBlur;\n"
+		"in float fragAlpha;\n"
+		"in float fragFrame;\n"
+		"in float fragFrameCount;\n"
+		"in float fragFirstLayer;\n"
+		"flat in int fragSwizzle;\n"
 		
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  float first = floor(frame);\n"
-		"  float second = mod(ceil(frame), frameCount);\n"
-		"  float fade = frame - first;\n"
+		"  float fade = fragFrame - floor(fragFrame);\n"
+		"  float first = floor(fragFrame) + fragFirstLayer;\n"
+		"  float second = mod(ceil(fragFrame), fragFrameCount) + fragFirstLayer;\n"
 		"  vec4 color;\n"
-		"  if(blur.x == 0 && blur.y == 0)\n"
+		"  if(fragBlur.x == 0 && fragBlur.y == 0)\n"
 		"  {\n"
 		"    if(fade != 0)\n"
 		"      color = mix(\n"
@@ -113,7 +142,7 @@ void SpriteShader::Init(bool useShaderSwizzle)
 		"    for(int i = -range; i <= range; ++i)\n"
 		"    {\n"
 		"      float scale = (range + 1 - abs(i)) / divisor;\n"
-		"      vec2 coord = fragTexCoord + (blur * i) / range;\n"
+		"      vec2 coord = fragTexCoord + (fragBlur * i) / range;\n"
 		"      if(fade != 0)\n"
 		"        color += scale * mix(\n"
 		"          texture(tex, vec3(coord, first)),\n"
@@ -121,13 +150,9 @@ void SpriteShader::Init(bool useShaderSwizzle)
 		"      else\n"
 		"        color += scale * texture(tex, vec3(coord, first));\n"
 		"    }\n"
-		"  }\n";
-	
-	// Only included when hardware swizzle not supported, GL <3.3 and GLES
-	if(useShaderSwizzle)
-	{
-		fragmentCodeStream <<
-		"  switch (swizzler) {\n"
+		"  }\n"
+		
+		"  switch (fragSwizzle) {\n"
 		"    case 0:\n"
 		"      color = color.rgba;\n"
 		"      break;\n"
@@ -155,48 +180,38 @@ void SpriteShader::Init(bool useShaderSwizzle)
 		"    case 8:\n"
 		"      color = vec4(0.f, 0.f, 0.f, color.a);\n"
 		"      break;\n"
-		"  }\n";
-	}
-	fragmentCodeStream <<
-		"  finalColor = color * alpha;\n"
+		"  }\n"
+		"  finalColor = color * fragAlpha;\n"
 		"}\n";
 	
-	static const string fragmentCodeString = fragmentCodeStream.str();
-	static const char *fragmentCode = fragmentCodeString.c_str();
-	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	frameI = shader.Uniform("frame");
-	frameCountI = shader.Uniform("frameCount");
-	positionI = shader.Uniform("position");
-	transformI = shader.Uniform("transform");
-	blurI = shader.Uniform("blur");
-	clipI = shader.Uniform("clip");
-	alphaI = shader.Uniform("alpha");
-	if(useShaderSwizzle)
-		swizzlerI = shader.Uniform("swizzler");
 	
 	glUseProgram(shader.Object());
 	glUniform1i(shader.Uniform("tex"), 0);
 	glUseProgram(0);
 	
-	// Generate the vertex data for drawing sprites.
+	// Generate the buffer for uploading the batched vertex data.
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		-.5f, -.5f,
-		-.5f,  .5f,
-		 .5f, -.5f,
-		 .5f,  .5f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	// Enable each of the vertex attributes, at its offset within the vertex.
+	struct Attribute { const char *name; int size; };
+	static const Attribute ATTRIBUTES[] = {
+		{"vert", 2}, {"position", 2}, {"transform", 4}, {"blur", 2}, {"clip", 1}, {"alpha", 1}, {"frame", 1},
+		{"frameCount", 1}, {"firstLayer", 1}, {"swizzle", 1}};
+	int offset = 0;
+	for(const Attribute &attribute : ATTRIBUTES)
+	{
+		GLint index = shader.Attrib(attribute.name);
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, attribute.size, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(GLfloat),
+			reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+		offset += attribute.size;
+	}
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -214,6 +229,7 @@ void SpriteShader::Draw(const Sprite *sprite, const Point &position, float zoom,
 	item.texture = sprite->Texture();
 	item.frame = frame;
 	item.frameCount = sprite->Frames();
+	item.firstLayer = sprite->FirstLayer();
 	// Position.
 	item.position[0] = static_cast<float>(position.X());
 	item.position[1] = static_cast<float>(position.Y());
@@ -232,6 +248,7 @@ void SpriteShader::Draw(const Sprite *sprite, const Point &position, float zoom,
 
 void SpriteShader::Bind()
 {
+	RenderQueue::Flush();
 	glUseProgram(shader.Object());
 	glBindVertexArray(vao);
 	
@@ -243,40 +260,63 @@ void SpriteShader::Bind()
 
 void SpriteShader::Add(const Item &item, bool withBlur)
 {
-	glBindTexture(GL_TEXTURE_2D_ARRAY, item.texture);
-
-	glUniform1f(frameI, item.frame);
-	glUniform1f(frameCountI, item.frameCount);
-	glUniform2fv(positionI, 1, item.position);
-	glUniformMatrix2fv(transformI, 1, false, item.transform);
-	// Special case: check if the blur should be applied or not.
-	static const float UNBLURRED[2] = {0.f, 0.f};
-	glUniform2fv(blurI, 1, withBlur ? item.blur : UNBLURRED);
-	// Clipping has the opposite sense in the shader.
-	glUniform1f(clipI, 1.f - item.clip);
-	glUniform1f(alphaI, item.alpha);
+	// Sprites whose textures have been unloaded are not drawn until they are
+	// loaded again.
+	if(!item.texture)
+		return;
 	
 	// Bounds check for the swizzle value:
-	int swizzle = (static_cast<size_t>(item.swizzle) >= SWIZZLE.size() ? 0 : item.swizzle);
-	// Set the color swizzle.
-	if(SpriteShader::useShaderSwizzle)
-		glUniform1i(swizzlerI, swizzle);
-	else
-		glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, SWIZZLE[swizzle].data());
+	float swizzle = (item.swizzle >= SWIZZLES ? 0.f : item.swizzle);
+	// Sprites can only be drawn together if they use the same texture.
+	if(!vertices.empty() && item.texture != batchTexture)
+		Flush();
+	batchTexture = item.texture;
 	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	// Special case: check if the blur should be applied or not.
+	static const float UNBLURRED[2] = {0.f, 0.f};
+	const float *blur = withBlur ? item.blur : UNBLURRED;
+	for(int i = 0; i < 12; i += 2)
+	{
+		vertices.insert(vertices.end(), CORNERS + i, CORNERS + i + 2);
+		vertices.insert(vertices.end(), item.position, item.position + 2);
+		vertices.insert(vertices.end(), item.transform, item.transform + 4);
+		vertices.insert(vertices.end(), blur, blur + 2);
+		// Clipping has the opposite sense in the shader.
+		vertices.push_back(1.f - item.clip);
+		vertices.push_back(item.alpha);
+		vertices.push_back(item.frame);
+		vertices.push_back(item.frameCount);
+		vertices.push_back(item.firstLayer);
+		vertices.push_back(swizzle);
+	}
 }
 
 
 
 void SpriteShader::Unbind()
 {
+	Flush();
+	
 	glBindVertexArray(0);
 	glUseProgram(0);
+}
+
+
+
+// Draw all the sprites that have been added since the last time.
+void SpriteShader::Flush()
+{
+	if(vertices.empty())
+		return;
+	
+	glBindTexture(GL_TEXTURE_2D_ARRAY, batchTexture);
+	GpuProfiler::CountBind();
 	
-	// Reset the swizzle.
-	if(SpriteShader::useShaderSwizzle)
-		glUniform1i(swizzlerI, 0);
-	else
-		glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, SWIZZLE[0].data());
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+	GpuProfiler::CountUpload();
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+	GpuProfiler::CountDraw();
+	vertices.clear();
 }
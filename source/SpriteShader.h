@@ -33,6 +33,8 @@ public:
 		uint32_t swizzle = 0;
 		float frame = 0.f;
 		float frameCount = 1.f;
+		// The layer of the texture that the sprite's first frame is in.
+		float firstLayer = 0.f;
 		float position[2] = {0.f, 0.f};
 		float transform[4] = {0.f, 0.f, 0.f, 0.f};
 		float blur[2] = {0.f, 0.f};
@@ -43,18 +45,23 @@ public:
 	
 public:
 	// Initialize the shaders.
-	static void Init(bool useShaderSwizzle);
+	static void Init();
 	
 	// Draw a sprite.
 	static void Draw(const Sprite *sprite, const Point &position, float zoom = 1.f, int swizzle = 0, float frame = 0.f);
 	
+	// Sprites that are added one after another with the same texture are drawn
+	// together, with a single draw call, when a different one is added or when
+	// the shader is unbound. Each sprite's swizzle is applied by the shader, so
+	// sprites with different swizzles can still be drawn together.
 	static void Bind();
 	static void Add(const Item &item, bool withBlur = false);
 	static void Unbind();
 	
 	
 private:
-	static bool useShaderSwizzle;
+	// Draw all the sprites that have been added but not drawn yet.
+	static void Flush();
 };
 
 
@@ -19,6 +19,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 #include "Preferences.h"
 #include "Random.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 #include "Sprite.h"
 #include "SpriteSet.h"
@@ -31,6 +32,9 @@ using namespace std;
 
 namespace {
 	const int TILE_SIZE = 256;
+	const Preferences::Setting DRAW_STARFIELD("Draw starfield");
+	const Preferences::Setting DRAW_HAZE("Draw background haze");
+	
 	// The star field tiles in 4000 pixel increments. Have the tiling of the haze
 	// field be as different from that as possible. (Note: this may need adjusting
 	// in the future if monitors larger than this width ever become commonplace.)
@@ -91,8 +95,9 @@ void StarField::SetHaze(const Sprite *sprite)
 void StarField::Draw(const Point &pos, const Point &vel, double zoom) const
 {
 	// Draw the starfield unless it is disabled in the preferences.
-	if(Preferences::Has("Draw starfield"))
+	if(DRAW_STARFIELD.Has())
 	{
+		RenderQueue::Flush();
 		glUseProgram(shader.Object());
 		glBindVertexArray(vao);
 	
@@ -125,21 +130,43 @@ void StarField::Draw(const Point &pos, const Point &vel, double zoom) const
 		// Round down to the start of the nearest tile.
 		minX &= ~(TILE_SIZE - 1l);
 		minY &= ~(TILE_SIZE - 1l);
-	
-		for(int gy = minY; gy < maxY; gy += TILE_SIZE)
-			for(int gx = minX; gx < maxX; gx += TILE_SIZE)
+		
+		// The stars are stored at their positions within the whole repeating
+		// pattern, and each row of tiles is contiguous in the buffer. So, every
+		// copy of the pattern that is on screen can be drawn with one call, with
+		// one range of stars for each row of tiles it has on screen.
+		const int width = widthMod + 1;
+		for(int py = minY & ~widthMod; py < maxY; py += width)
+			for(int px = minX & ~widthMod; px < maxX; px += width)
 			{
-				Point off = Point(gx, gy) - pos;
+				// Find which columns and rows of this copy are on screen.
+				int firstCol = (max(minX, px) - px) / TILE_SIZE;
+				int lastCol = (min(maxX, px + width) - px + TILE_SIZE - 1) / TILE_SIZE;
+				int firstRow = (max(minY, py) - py) / TILE_SIZE;
+				int lastRow = (min(maxY, py + width) - py + TILE_SIZE - 1) / TILE_SIZE;
+				
+				first.clear();
+				count.clear();
+				for(int row = firstRow; row < lastRow; ++row)
+				{
+					int start = 6 * tileIndex[firstCol + row * tileCols];
+					int end = 6 * tileIndex[lastCol + row * tileCols];
+					if(end > start)
+					{
+						first.push_back(start);
+						count.push_back(end - start);
+					}
+				}
+				if(first.empty())
+					continue;
+				
+				Point off = Point(px, py) - pos;
 				GLfloat translate[2] = {
 					static_cast<float>(off.X()),
 					static_cast<float>(off.Y())
 				};
 				glUniform2fv(translateI, 1, translate);
-				
-				int index = (gx & widthMod) / TILE_SIZE + ((gy & widthMod) / TILE_SIZE) * tileCols;
-				int first = 6 * tileIndex[index];
-				int count = 6 * tileIndex[index + 1] - first;
-				glDrawArrays(GL_TRIANGLES, first, count);
+				glMultiDrawArrays(GL_TRIANGLES, first.data(), count.data(), first.size());
 			}
 	
 		glBindVertexArray(0);
@@ -147,7 +174,7 @@ void StarField::Draw(const Point &pos, const Point &vel, double zoom) const
 	}
 	
 	// Draw the background haze unless it is disabled in the preferences.
-	if(!Preferences::Has("Draw background haze"))
+	if(!DRAW_HAZE.Has())
 		return;
 	
 	DrawList drawList;
@@ -303,8 +330,8 @@ void StarField::MakeStars(int stars, int width)
 		
 		// Randomize its sub-pixel position and its size / brightness.
 		int random = Random::Int(4096);
-		float fx = (x & (TILE_SIZE - 1)) + (random & 15) * 0.0625f;
-		float fy = (y & (TILE_SIZE - 1)) + (random >> 8) * 0.0625f;
+		float fx = x + (random & 15) * 0.0625f;
+		float fy = y + (random >> 8) * 0.0625f;
 		float size = (((random >> 4) & 15) + 20) * 0.0625f;
 		
 		// Fill in the data array.
@@ -48,6 +48,10 @@ private:
 	int widthMod;
 	int tileCols;
 	std::vector<int> tileIndex;
+	// The ranges of the vertex buffer that are drawn for each copy of the
+	// repeating pattern that is on screen.
+	mutable std::vector<GLint> first;
+	mutable std::vector<GLsizei> count;
 	
 	std::vector<Body> haze;
 	
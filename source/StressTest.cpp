@@ -0,0 +1,189 @@
+/* StressTest.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "StressTest.h"
+
+#include "DataFile.h"
+#include "DataNode.h"
+#include "Engine.h"
+#include "Files.h"
+#include "Fleet.h"
+#include "GameData.h"
+#include "GameWindow.h"
+#include "GpuProfiler.h"
+#include "Outfit.h"
+#include "PlayerInfo.h"
+#include "Profiler.h"
+#include "Ship.h"
+#include "ShipEvent.h"
+#include "StartConditions.h"
+#include "System.h"
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+
+using namespace std;
+
+namespace {
+	// Replace all the given ship's weapons with as many of the given one as
+	// its hardpoints have room for.
+	void Rearm(Ship &ship, const Outfit *weapon)
+	{
+		map<const Outfit *, int> weapons;
+		for(const auto &it : ship.Outfits())
+			if(it.first->IsWeapon())
+				weapons.insert(it);
+		for(const auto &it : weapons)
+			ship.AddOutfit(it.first, -it.second);
+		
+		const char *slot = weapon->Get("turret mounts") ? "turret mounts" : "gun ports";
+		ship.AddOutfit(weapon, max(0., ship.Attributes().Get(slot)));
+	}
+}
+
+
+
+// Load a scenario from the given file.
+bool StressTest::Load(const string &path)
+{
+	DataFile file(path);
+	for(const DataNode &node : file)
+	{
+		if(node.Token(0) != "stress")
+		{
+			node.PrintTrace("Skipping unrecognized root object:");
+			continue;
+		}
+		name = (node.Size() >= 2) ? node.Token(1) : Files::Name(path);
+		
+		for(const DataNode &child : node)
+		{
+			const string &key = child.Token(0);
+			bool hasValue = (child.Size() >= 2);
+			if(key == "system" && hasValue)
+			{
+				system = GameData::Systems().Find(child.Token(1));
+				if(!system)
+					child.PrintTrace("Error: unknown system:");
+			}
+			else if(key == "fleet" && hasValue)
+			{
+				const Fleet *fleet = GameData::Fleets().Find(child.Token(1));
+				if(fleet)
+					fleets.emplace_back(fleet, (child.Size() >= 3) ? child.Value(2) : 1);
+				else
+					child.PrintTrace("Error: unknown fleet:");
+			}
+			else if(key == "asteroids" && child.Size() >= 3)
+				asteroids.emplace_back(child.Token(1), child.Value(2));
+			else if(key == "weapon" && hasValue)
+			{
+				weapon = GameData::Outfits().Find(child.Token(1));
+				if(!weapon || !weapon->IsWeapon())
+				{
+					child.PrintTrace("Error: unknown weapon:");
+					weapon = nullptr;
+				}
+			}
+			else if(key == "steps" && hasValue)
+				steps = max(1., child.Value(1));
+			else if(key == "waves" && hasValue)
+				waves = max(1., child.Value(1));
+			else
+				child.PrintTrace("Skipping unrecognized attribute:");
+		}
+		// Only the first scenario in the file is used.
+		break;
+	}
+	return system;
+}
+
+
+
+// Run the scenario, and write a summary of the timings.
+bool StressTest::Run(PlayerInfo &player, bool isHeadless) const
+{
+	if(GameData::StartOptions().empty())
+		return false;
+	
+	// Put a new pilot in the middle of the system, in flight. Nothing in this
+	// system has any reason to leave them alone, which is part of the test.
+	player.New(GameData::StartOptions().front());
+	player.SetSystem(*system);
+	player.SetPlanet(nullptr);
+	for(const shared_ptr<Ship> &ship : player.Ships())
+	{
+		ship->SetSystem(system);
+		ship->SetPlanet(nullptr);
+	}
+	
+	Profiler::Reset();
+	Profiler::SetEnabled(true);
+	
+	Engine engine(player);
+	engine.Place();
+	for(const auto &it : asteroids)
+		engine.AddAsteroids(it.first, it.second);
+	
+	cout << "Running stress test \"" << name << "\" in " << system->Name() << "." << endl;
+	for(int wave = 0; wave < waves; ++wave)
+	{
+		Spawn(engine);
+		for(int i = 0; i < steps; ++i)
+		{
+			engine.SetNextStepDrawn(!isHeadless);
+			engine.Go();
+			engine.Wait();
+			engine.Step(false);
+			engine.Events().clear();
+			GameData::Progress();
+			
+			if(!isHeadless)
+			{
+				engine.Draw();
+				GpuProfiler::EndFrame();
+				GameWindow::Step();
+			}
+		}
+		
+		// Report how long each part of a step took near the end of this wave.
+		int shipCount = 0;
+		for(const auto &it : Profiler::Counters())
+			if(it.first == "Ships")
+				shipCount = it.second;
+		cout << "Wave " << (wave + 1) << " (" << shipCount << " ships):" << endl;
+		for(const auto &it : Profiler::Averages())
+			cout << "    " << it.first << ": " << it.second << " ms" << endl;
+	}
+	
+	Profiler::WriteSummary(Files::Config() + "stress.json", name);
+	return true;
+}
+
+
+
+// Add each of the fleets to the engine.
+void StressTest::Spawn(Engine &engine) const
+{
+	list<shared_ptr<Ship>> added;
+	for(const auto &it : fleets)
+		for(int i = 0; i < it.second; ++i)
+			it.first->Place(*system, added);
+	
+	if(weapon)
+		for(const shared_ptr<Ship> &ship : added)
+			Rearm(*ship, weapon);
+	engine.Add(added);
+}
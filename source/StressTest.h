@@ -0,0 +1,75 @@
+/* StressTest.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef STRESS_TEST_H_
+#define STRESS_TEST_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class Engine;
+class Fleet;
+class Outfit;
+class PlayerInfo;
+class System;
+
+
+
+// Class for finding out how big a fight the game can handle on a particular
+// computer. A stress test scenario is read from a file in the same format as
+// the game data, like this:
+//     stress "Big fight"
+//         system "Sol"
+//         fleet "Large Southern Pirates" 5
+//         fleet "Large Republic" 5
+//         asteroids "medium rock" 200
+//         weapon "Heavy Laser"
+//         steps 1800
+//         waves 4
+// The given number of each fleet (whose ships fight for that fleet's
+// government) are placed in the system, along with the asteroids. If a weapon
+// is given, every ship has its weapons replaced with as many of that one as
+// will fit in its hardpoints. The game then runs for the given number of steps
+// with the profiler on. If there is more than one wave, the fleets are added
+// again at the start of each wave, and the average time each part of a step
+// took is printed at the end of each one, along with the number of ships.
+class StressTest {
+public:
+	// Load a scenario from the given file. If it has no valid system, this
+	// returns false.
+	bool Load(const std::string &path);
+	// Run the scenario, with a new pilot's ships watching from the middle of
+	// the system, and write a summary of the timings to stress.json in the
+	// config directory. If there is no starting scenario to make that pilot
+	// from, this returns false.
+	bool Run(PlayerInfo &player, bool isHeadless) const;
+	
+	
+private:
+	// Add each of the fleets to the engine.
+	void Spawn(Engine &engine) const;
+	
+	
+private:
+	std::string name;
+	const System *system = nullptr;
+	std::vector<std::pair<const Fleet *, int>> fleets;
+	std::vector<std::pair<std::string, int>> asteroids;
+	const Outfit *weapon = nullptr;
+	int steps = 3600;
+	int waves = 1;
+};
+
+
+
+#endif
@@ -25,6 +25,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteSet.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 
 using namespace std;
@@ -128,6 +129,48 @@ int System::HazardProbability::Period() const
 
 
 
+System::Grid::Grid(const Set<System> &systems)
+{
+	for(const auto &it : systems)
+	{
+		// Skip systems that have no name.
+		if(it.first.empty() || it.second.Name().empty())
+			continue;
+		cells[Cell(it.second.Position())].push_back(&it.second);
+	}
+}
+
+
+
+// Add every system within the given distance of the given point.
+void System::Grid::Find(const Point &center, double distance, FlatSet<const System *> &result) const
+{
+	pair<int, int> first = Cell(center - Point(distance, distance));
+	pair<int, int> last = Cell(center + Point(distance, distance));
+	for(int row = first.first; row <= last.first; ++row)
+	{
+		// The cells are sorted by row and then by column, so the cells in each
+		// row that overlap the range can be found with one search.
+		auto it = cells.lower_bound(make_pair(row, first.second));
+		for( ; it != cells.end() && it->first.first == row && it->first.second <= last.second; ++it)
+			for(const System *system : it->second)
+				if(system->Position().Distance(center) <= distance)
+					result.insert(system);
+	}
+}
+
+
+
+// Get the row and column of the cell that the given point is in. The cells are
+// as wide as the distance that systems can be seen from.
+pair<int, int> System::Grid::Cell(const Point &point) const
+{
+	return make_pair(static_cast<int>(floor(point.Y() / DEFAULT_NEIGHBOR_DISTANCE)),
+		static_cast<int>(floor(point.X() / DEFAULT_NEIGHBOR_DISTANCE)));
+}
+
+
+
 // Load a system's description.
 void System::Load(const DataNode &node, Set<Planet> &planets)
 {
@@ -392,7 +435,7 @@ void System::Load(const DataNode &node, Set<Planet> &planets)
 // Update any information about the system that may have changed due to events,
 // or because the game was started, e.g. neighbors, solar wind and power, or
 // if the system is inhabited.
-void System::UpdateSystem(const Set<System> &systems, const set<double> &neighborDistances)
+void System::UpdateSystem(const Grid &grid, const set<double> &neighborDistances)
 {
 	neighbors.clear();
 	// Neighbors are cached for each system for the purpose of quicker
@@ -402,15 +445,15 @@ void System::UpdateSystem(const Set<System> &systems, const set<double> &neighbo
 	// jump range that can be encountered.
 	if(jumpRange)
 	{
-		UpdateNeighbors(systems, jumpRange);
+		UpdateNeighbors(grid, jumpRange);
 		// Systems with a static jump range must also create a set for
 		// the DEFAULT_NEIGHBOR_DISTANCE to be returned for those systems
 		// which are visible from it.
-		UpdateNeighbors(systems, DEFAULT_NEIGHBOR_DISTANCE);
+		UpdateNeighbors(grid, DEFAULT_NEIGHBOR_DISTANCE);
 	}
 	else
 		for(const double distance : neighborDistances)
-			UpdateNeighbors(systems, distance);
+			UpdateNeighbors(grid, distance);
 	
 	// Calculate the solar power and solar wind.
 	solarPower = 0.;
@@ -456,6 +499,13 @@ bool System::IsValid() const
 
 
 
+size_t System::Index() const
+{
+	return index;
+}
+
+
+
 // Get this system's name.
 const string &System::Name() const
 {
@@ -506,7 +556,7 @@ const set<string> &System::Attributes() const
 
 
 // Get a list of systems you can travel to through hyperspace from here.
-const set<const System *> &System::Links() const
+const FlatSet<const System *> &System::Links() const
 {
 	return links;
 }
@@ -517,9 +567,9 @@ const set<const System *> &System::Links() const
 // jump distance, whether or not there is a direct hyperspace link to them.
 // If this system has its own jump range, then it will always return the
 // systems within that jump range instead of the jump range given.
-const set<const System *> &System::JumpNeighbors(double neighborDistance) const
+const FlatSet<const System *> &System::JumpNeighbors(double neighborDistance) const
 {
-	static const set<const System *> EMPTY;
+	static const FlatSet<const System *> EMPTY;
 	const auto it = neighbors.find(jumpRange ? jumpRange : neighborDistance);
 	return it == neighbors.end() ? EMPTY : it->second;
 }
@@ -552,9 +602,9 @@ double System::ExtraJumpArrivalDistance() const
 
 // Get a list of systems you can "see" from here, whether or not there is a
 // direct hyperspace link to them.
-const set<const System *> &System::VisibleNeighbors() const
+const FlatSet<const System *> &System::VisibleNeighbors() const
 {
-	static const set<const System *> EMPTY;
+	static const FlatSet<const System *> EMPTY;
 	const auto it = neighbors.find(DEFAULT_NEIGHBOR_DISTANCE);
 	return it == neighbors.end() ? EMPTY : it->second;
 }
@@ -848,26 +898,18 @@ void System::LoadObject(const DataNode &node, Set<Planet> &planets, int parent)
 // Once the star map is fully loaded or an event has changed systems
 // or links, figure out which stars are "neighbors" of this one, i.e.
 // close enough to see or to reach via jump drive.
-void System::UpdateNeighbors(const Set<System> &systems, double distance)
+void System::UpdateNeighbors(const Grid &grid, double distance)
 {
-	set<const System *> &neighborSet = neighbors[distance];
+	FlatSet<const System *> &neighborSet = neighbors[distance];
+	
+	// Any other star system that is within the neighbor distance is a neighbor.
+	grid.Find(position, distance, neighborSet);
+	neighborSet.erase(this);
 	
 	// Every star system that is linked to this one is automatically a neighbor,
 	// even if it is farther away than the maximum distance.
 	for(const System *system : links)
 		neighborSet.insert(system);
-	
-	// Any other star system that is within the neighbor distance is also a
-	// neighbor.
-	for(const auto &it : systems)
-	{
-		// Skip systems that have no name.
-		if(it.first.empty() || it.second.Name().empty())
-			continue;
-
-		if(&it.second != this && it.second.Position().Distance(position) <= distance)
-			neighborSet.insert(&it.second);
-	}
 }
 
 
@@ -884,3 +926,12 @@ void System::Price::Update()
 {
 	price = base + static_cast<int>(-100. * erf(supply / LIMIT));
 }
+
+
+
+// Systems may be created while the data files are being loaded in parallel.
+size_t System::NextIndex()
+{
+	static atomic<size_t> count(0);
+	return count++;
+}
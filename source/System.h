@@ -13,12 +13,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SYSTEM_H_
 #define SYSTEM_H_
 
+#include "FlatSet.h"
 #include "Point.h"
 #include "Set.h"
 #include "StellarObject.h"
 
+#include <cstddef>
+#include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 class DataNode;
@@ -83,19 +87,38 @@ public:
 		int period;
 	};
 	
+	// A uniform grid over the positions of the named systems, for finding the
+	// ones within some distance of a point without checking all of them.
+	class Grid {
+	public:
+		explicit Grid(const Set<System> &systems);
+		
+		// Add every system within the given distance of the given point.
+		void Find(const Point &center, double distance, FlatSet<const System *> &result) const;
+		
+	private:
+		std::pair<int, int> Cell(const Point &point) const;
+		
+	private:
+		std::map<std::pair<int, int>, std::vector<const System *>> cells;
+	};
+	
 	
 public:
 	// Load a system's description.
 	void Load(const DataNode &node, Set<Planet> &planets);
 	// Update any information about the system that may have changed due to events,
 	// e.g. neighbors, solar wind and power, or if the system is inhabited.
-	void UpdateSystem(const Set<System> &systems, const std::set<double> &neighborDistances);
+	void UpdateSystem(const Grid &grid, const std::set<double> &neighborDistances);
 	
 	// Modify a system's links.
 	void Link(System *other);
 	void Unlink(System *other);
 	
 	bool IsValid() const;
+	// Get a number that is unique to this system, and small enough to be used
+	// as an index into per-system tables. A copy of a system has its index.
+	size_t Index() const;
 	// Get this system's name and position (in the star map).
 	const std::string &Name() const;
 	void SetName(const std::string &name);
@@ -109,12 +132,12 @@ public:
 	const std::set<std::string> &Attributes() const;
 	
 	// Get a list of systems you can travel to through hyperspace from here.
-	const std::set<const System *> &Links() const;
+	const FlatSet<const System *> &Links() const;
 	// Get a list of systems that can be jumped to from here with the given
 	// jump distance, whether or not there is a direct hyperspace link to them.
 	// If this system has its own jump range, then it will always return the
 	// systems within that jump range instead of the jump range given.
-	const std::set<const System *> &JumpNeighbors(double neighborDistance) const;
+	const FlatSet<const System *> &JumpNeighbors(double neighborDistance) const;
 	// Whether this system can be seen when not linked.
 	bool Hidden() const;
 	// Additional travel distance to target for ships entering through hyperspace.
@@ -123,7 +146,7 @@ public:
 	double ExtraJumpArrivalDistance() const;
 	// Get a list of systems you can "see" from here, whether or not there is a
 	// direct hyperspace link to them.
-	const std::set<const System *> &VisibleNeighbors() const;
+	const FlatSet<const System *> &VisibleNeighbors() const;
 	
 	// Move the stellar objects to their positions on the given date.
 	void SetDate(const Date &date);
@@ -177,7 +200,9 @@ private:
 	// Once the star map is fully loaded or an event has changed systems
 	// or links, figure out which stars are "neighbors" of this one, i.e.
 	// close enough to see or to reach via jump drive.
-	void UpdateNeighbors(const Set<System> &systems, double distance);
+	void UpdateNeighbors(const Grid &grid, double distance);
+	// Get the index for a newly created system.
+	static size_t NextIndex();
 	
 	
 private:
@@ -194,6 +219,7 @@ private:
 	
 	
 private:
+	size_t index = NextIndex();
 	bool isDefined = false;
 	bool hasPosition = false;
 	// Name and position (within the star map) of this system.
@@ -203,8 +229,8 @@ private:
 	std::string music;
 	
 	// Hyperspace links to other systems.
-	std::set<const System *> links;
-	std::map<double, std::set<const System *>> neighbors;
+	FlatSet<const System *> links;
+	std::map<double, FlatSet<const System *>> neighbors;
 	
 	// Defines whether this system can be seen when not linked.
 	bool hidden = false;
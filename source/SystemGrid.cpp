@@ -0,0 +1,129 @@
+/* SystemGrid.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SystemGrid.h"
+
+#include "GameData.h"
+#include "Point.h"
+#include "System.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+namespace {
+	// The size of each grid cell, in map units. Systems are usually around
+	// 50 to 100 units apart, so this puts only a few systems in each cell.
+	const double CELL_SIZE = 100.;
+	
+	uint64_t gridRevision = 0;
+	// The position of the top left corner of the grid.
+	double left = 0.;
+	double top = 0.;
+	int columns = 0;
+	int rows = 0;
+	vector<vector<const System *>> cells;
+	
+	// Get the column or row that the given coordinate falls in, clamped to the
+	// edges of the grid.
+	int Cell(double value, double origin, int count)
+	{
+		return max(0, min(count - 1, static_cast<int>(floor((value - origin) / CELL_SIZE))));
+	}
+	
+	// Make sure the grid matches the current universe.
+	void Update()
+	{
+		if(gridRevision == GameData::Revision())
+			return;
+		gridRevision = GameData::Revision();
+		
+		vector<const System *> systems;
+		for(const auto &it : GameData::Systems())
+			if(it.second.IsValid())
+				systems.push_back(&it.second);
+		
+		double right = 0.;
+		double bottom = 0.;
+		left = top = 0.;
+		if(!systems.empty())
+		{
+			left = right = systems.front()->Position().X();
+			top = bottom = systems.front()->Position().Y();
+		}
+		for(const System *system : systems)
+		{
+			const Point &pos = system->Position();
+			left = min(left, pos.X());
+			right = max(right, pos.X());
+			top = min(top, pos.Y());
+			bottom = max(bottom, pos.Y());
+		}
+		columns = static_cast<int>((right - left) / CELL_SIZE) + 1;
+		rows = static_cast<int>((bottom - top) / CELL_SIZE) + 1;
+		
+		cells.clear();
+		cells.resize(columns * rows);
+		for(const System *system : systems)
+		{
+			const Point &pos = system->Position();
+			cells[Cell(pos.Y(), top, rows) * columns + Cell(pos.X(), left, columns)].push_back(system);
+		}
+	}
+}
+
+
+
+// Get all the systems that are inside the given rectangle.
+vector<const System *> SystemGrid::InRect(const Point &topLeft, const Point &bottomRight)
+{
+	Update();
+	
+	vector<const System *> result;
+	if(cells.empty())
+		return result;
+	
+	int firstColumn = Cell(topLeft.X(), left, columns);
+	int lastColumn = Cell(bottomRight.X(), left, columns);
+	int firstRow = Cell(topLeft.Y(), top, rows);
+	int lastRow = Cell(bottomRight.Y(), top, rows);
+	for(int row = firstRow; row <= lastRow; ++row)
+		for(int column = firstColumn; column <= lastColumn; ++column)
+			for(const System *system : cells[row * columns + column])
+			{
+				const Point &pos = system->Position();
+				if(pos.X() >= topLeft.X() && pos.X() <= bottomRight.X()
+						&& pos.Y() >= topLeft.Y() && pos.Y() <= bottomRight.Y())
+					result.push_back(system);
+			}
+	return result;
+}
+
+
+
+// Get all the systems within the given distance of the given point.
+vector<const System *> SystemGrid::Near(const Point &point, double distance)
+{
+	Point corner(distance, distance);
+	vector<const System *> result = InRect(point - corner, point + corner);
+	result.erase(remove_if(result.begin(), result.end(),
+		[&point, distance](const System *system) { return point.Distance(system->Position()) >= distance; }),
+		result.end());
+	sort(result.begin(), result.end(),
+		[&point](const System *a, const System *b)
+		{
+			return point.DistanceSquared(a->Position()) < point.DistanceSquared(b->Position());
+		});
+	return result;
+}
@@ -0,0 +1,39 @@
+/* SystemGrid.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SYSTEM_GRID_H_
+#define SYSTEM_GRID_H_
+
+#include <vector>
+
+class Point;
+class System;
+
+
+
+// A grid of all the valid systems, bucketed by their position on the map, so
+// that finding the systems near a point or inside the visible part of the map
+// does not require checking every system in the galaxy. The grid is built the
+// first time it is needed, and is rebuilt whenever the universe changes.
+class SystemGrid {
+public:
+	// Get all the systems that are inside the given rectangle, given by its
+	// top left and bottom right corners in map coordinates.
+	static std::vector<const System *> InRect(const Point &topLeft, const Point &bottomRight);
+	// Get all the systems within the given distance of the given point, with
+	// the closest ones first.
+	static std::vector<const System *> Near(const Point &point, double distance);
+};
+
+
+
+#endif
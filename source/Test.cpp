@@ -20,6 +20,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Planet.h"
 #include "PlanetPanel.h"
 #include "PlayerInfo.h"
+#include "Profiler.h"
+#include "Random.h"
 #include "Ship.h"
 #include "System.h"
 #include "TestData.h"
@@ -47,10 +49,12 @@ namespace{
 	const map<Test::TestStep::Type, const string> STEPTYPE_TO_TEXT = {
 		{Test::TestStep::Type::APPLY, "apply"},
 		{Test::TestStep::Type::ASSERT, "assert"},
+		{Test::TestStep::Type::BENCHMARK, "benchmark"},
 		{Test::TestStep::Type::BRANCH, "branch"},
 		{Test::TestStep::Type::INJECT, "inject"},
 		{Test::TestStep::Type::INPUT, "input"},
 		{Test::TestStep::Type::LABEL, "label"},
+		{Test::TestStep::Type::LOAD, "load"},
 		{Test::TestStep::Type::NAVIGATE, "navigate"},
 		{Test::TestStep::Type::WATCHDOG, "watchdog"},
 	};
@@ -137,6 +141,32 @@ void Test::LoadSequence(const DataNode &node)
 				}
 				else
 					step.nameOrLabel = child.Token(1);
+				break;
+			case TestStep::Type::LOAD:
+				if(child.Size() < 2)
+				{
+					status = Status::BROKEN;
+					child.PrintTrace("Error: Invalid use of \"load\" without saved game name:");
+					return;
+				}
+				step.nameOrLabel = child.Token(1);
+				break;
+			case TestStep::Type::BENCHMARK:
+				if(child.Size() < 2 || child.Value(1) < 1.)
+				{
+					status = Status::BROKEN;
+					child.PrintTrace("Error: Invalid use of \"benchmark\" without a number of frames:");
+					return;
+				}
+				step.benchmarkFrames = child.Value(1);
+				for(const DataNode &grand : child)
+				{
+					if(grand.Token(0) == "seed" && grand.Size() >= 2)
+						step.seed = grand.Value(1);
+					else
+						grand.PrintTrace("Skipping unrecognized attribute:");
+				}
+				break;
 			case TestStep::Type::INPUT:
 				child.PrintTrace("Error: Not yet implemented step type input");
 				status = Status::BROKEN;
@@ -341,6 +371,47 @@ void Test::Step(Context &context, UI &menuPanels, UI &gamePanels, PlayerInfo &pl
 			case TestStep::Type::LABEL:
 				++(context.stepToRun);
 				break;
+			case TestStep::Type::LOAD:
+				{
+					// Load the saved game the same way the load panel does, and
+					// close the menu so that the game starts right away.
+					string path = Files::Saves() + stepToRun.nameOrLabel + ".txt";
+					if(!Files::Exists(path))
+						Fail(context, player, "saved game \"" + stepToRun.nameOrLabel + "\" not found");
+					gamePanels.Reset();
+					gamePanels.CanSave(true);
+					player.Load(path);
+					
+					menuPanels.Pop(menuPanels.Top().get());
+					menuPanels.Pop(menuPanels.Root().get());
+					gamePanels.Push(new MainPanel(player));
+					gamePanels.StepAll();
+					gamePanels.StepAll();
+				}
+				++(context.stepToRun);
+				continueGameLoop = true;
+				break;
+			case TestStep::Type::BENCHMARK:
+				if(!context.isBenchmarking)
+				{
+					// Start from the same state every time, and record only the
+					// timings from this benchmark.
+					Random::Seed(stepToRun.seed);
+					Profiler::Reset();
+					Profiler::SetEnabled(true);
+					context.isBenchmarking = true;
+					context.benchmarkFramesLeft = stepToRun.benchmarkFrames;
+				}
+				if(context.benchmarkFramesLeft)
+				{
+					--(context.benchmarkFramesLeft);
+					continueGameLoop = true;
+					break;
+				}
+				Profiler::WriteSummary(Files::Config() + "benchmark.json", name);
+				context.isBenchmarking = false;
+				++(context.stepToRun);
+				break;
 			case TestStep::Type::NAVIGATE:
 				player.TravelPlan().clear();
 				player.TravelPlan() = stepToRun.travelPlan;
@@ -382,9 +453,8 @@ void Test::Fail(const Context &context, const PlayerInfo &player, const string &
 	// Future versions of the test-framework could also print all conditions that are used in the test.
 	string conditions = "";
 	const string TEST_PREFIX = "test: ";
-	auto it = player.Conditions().lower_bound(TEST_PREFIX);
-	for( ; it != player.Conditions().end() && !it->first.compare(0, TEST_PREFIX.length(), TEST_PREFIX); ++it)
-		conditions += "Condition: \"" + it->first + "\" = " + to_string(it->second) + "\n";
+	for(const auto &it : player.Conditions().WithPrefix(TEST_PREFIX))
+		conditions += "Condition: \"" + it.first + "\" = " + to_string(it.second) + "\n";
 	
 	if(!conditions.empty())
 		Files::LogError(conditions);
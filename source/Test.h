@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Command.h"
 #include "ConditionSet.h"
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <string>
@@ -46,6 +47,10 @@ public:
 			APPLY,
 			// Step that verifies if a certain condition is true. Does not cause the game to step.
 			ASSERT,
+			// Step that runs the game for a fixed number of frames, starting from
+			// a fixed random seed, and writes out how long each part of each
+			// frame took. Does cause the game to step.
+			BENCHMARK,
 			// Branch with a label to jump to when the condition in child is true.
 			// When a second label is given, then the second is to jump to on false.
 			// Does not cause the game to step, except when no step was done since last BRANCH or GOTO.
@@ -56,6 +61,9 @@ public:
 			INPUT,
 			// Label to jump to (similar as is done in conversations). Does not cause the game to step.
 			LABEL,
+			// Step that loads a saved game (e.g. one that was injected) and starts
+			// flying. Does cause the game to step.
+			LOAD,
 			// Instructs the game to set navigation / travel plan to a target system
 			NAVIGATE,
 			// Sets the watchdog timer. No value or zero disables the watchdog. Non-zero gives
@@ -86,6 +94,10 @@ public:
 		std::string jumpOnFalseTarget;
 		
 		unsigned int watchdog = 0;
+		
+		// Variables for benchmark steps.
+		unsigned int benchmarkFrames = 0;
+		uint64_t seed = 0;
 	};
 	
 	class Context {
@@ -100,6 +112,9 @@ public:
 		unsigned int stepToRun = 0;
 		unsigned int watchdog = 0;
 		std::set<unsigned int> branchesSinceGameStep;
+		// How many more frames the current benchmark step should run for.
+		bool isBenchmarking = false;
+		unsigned int benchmarkFramesLeft = 0;
 	};
 	
 	
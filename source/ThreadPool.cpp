@@ -0,0 +1,184 @@
+/* ThreadPool.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+
+
+// Constructor, which allocates one worker for each extra hardware thread.
+ThreadPool::ThreadPool()
+	: ThreadPool(thread::hardware_concurrency() > 1 ? thread::hardware_concurrency() - 1 : 0)
+{
+}
+
+
+
+ThreadPool::ThreadPool(unsigned workerCount)
+{
+	threads.resize(workerCount);
+	for(thread &t : threads)
+		t = thread(&ThreadPool::Work, this);
+}
+
+
+
+// Destructor, which waits for all worker threads to wrap up.
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<std::mutex> lock(mutex);
+		terminate = true;
+	}
+	workCondition.notify_all();
+	for(thread &t : threads)
+		t.join();
+}
+
+
+
+// Get the pool that is shared by the whole game.
+ThreadPool &ThreadPool::Shared()
+{
+	static ThreadPool shared(max(2u, thread::hardware_concurrency()) - 1);
+	return shared;
+}
+
+
+
+// Call the given function once for each index in [0, count), and wait for all
+// of those calls to finish.
+void ThreadPool::ForEach(size_t count, const function<void(size_t)> &job, Priority priority)
+{
+	// If there is no one to share the work with, or nothing worth sharing,
+	// don't bother waking up the workers.
+	if(threads.empty() || count < 2)
+	{
+		for(size_t i = 0; i < count; ++i)
+			job(i);
+		return;
+	}
+	
+	shared_ptr<Batch> batch = make_shared<Batch>(&job, count, priority);
+	Enqueue(batch);
+	
+	// This thread helps out, instead of waiting idly.
+	RunJobs(*batch);
+	
+	// Every job has been started by now. If none of the workers got to this
+	// batch, it is still in the queue. Otherwise, wait for any jobs that the
+	// workers are in the middle of.
+	unique_lock<std::mutex> lock(mutex);
+	auto it = find(queue.begin(), queue.end(), batch);
+	if(it != queue.end())
+		queue.erase(it);
+	while(batch->busy)
+		doneCondition.wait(lock);
+}
+
+
+
+// Run the given task on one of the worker threads, without waiting for it.
+void ThreadPool::Run(function<void()> task, Priority priority)
+{
+	if(threads.empty())
+	{
+		task();
+		return;
+	}
+	
+	shared_ptr<Batch> batch = make_shared<Batch>(nullptr, 1, priority);
+	batch->task = [task](size_t) { task(); };
+	batch->job = &batch->task;
+	Enqueue(batch);
+}
+
+
+
+// Get the number of threads (including the caller) that run jobs.
+size_t ThreadPool::Concurrency() const
+{
+	return threads.size() + 1;
+}
+
+
+
+ThreadPool::Batch::Batch(const function<void(size_t)> *job, size_t count, Priority priority)
+	: job(job), count(count), priority(priority), next(0)
+{
+}
+
+
+
+// Thread entry point.
+void ThreadPool::Work()
+{
+	while(true)
+	{
+		shared_ptr<Batch> batch;
+		{
+			unique_lock<std::mutex> lock(mutex);
+			while(queue.empty() && !terminate)
+				workCondition.wait(lock);
+			
+			if(terminate)
+				break;
+			batch = queue.front();
+			++batch->busy;
+		}
+		
+		RunJobs(*batch);
+		
+		{
+			// All of this batch's jobs have been started, so no other thread
+			// needs to find it in the queue any more.
+			lock_guard<std::mutex> lock(mutex);
+			--batch->busy;
+			auto it = find(queue.begin(), queue.end(), batch);
+			if(it != queue.end())
+				queue.erase(it);
+		}
+		doneCondition.notify_all();
+	}
+}
+
+
+
+// Add a batch to the queue, ahead of any with a lower priority.
+void ThreadPool::Enqueue(const shared_ptr<Batch> &batch)
+{
+	{
+		lock_guard<std::mutex> lock(mutex);
+		auto it = queue.begin();
+		while(it != queue.end() && (*it)->priority >= batch->priority)
+			++it;
+		queue.insert(it, batch);
+	}
+	workCondition.notify_all();
+}
+
+
+
+// Claim jobs one at a time from the given batch until all have been claimed.
+void ThreadPool::RunJobs(Batch &batch)
+{
+	while(true)
+	{
+		size_t index = batch.next++;
+		if(index >= batch.count)
+			break;
+		(*batch.job)(index);
+	}
+}
@@ -0,0 +1,113 @@
+/* ThreadPool.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// Class representing a set of worker threads that can be used to spread work
+// over all the available processor cores. A batch of independent jobs can be
+// submitted by any thread, which then takes part in running that batch and
+// does not return until every job in it is done. Single tasks can also be run
+// in the background. The game shares one pool between everything that needs
+// worker threads, so that they do not compete with each other for the cores.
+class ThreadPool {
+public:
+	// Batches are started in order of priority, and then in the order that they
+	// were submitted. Work that a thread is waiting for should come before work
+	// that is being done in the background.
+	enum class Priority {LOW, HIGH};
+	
+	
+public:
+	// Create a pool with one worker thread for each hardware thread beyond
+	// the one that will be submitting the jobs.
+	ThreadPool();
+	explicit ThreadPool(unsigned workerCount);
+	~ThreadPool();
+	
+	// No moving or copying this class.
+	ThreadPool(const ThreadPool &other) = delete;
+	ThreadPool(ThreadPool &&other) = delete;
+	ThreadPool &operator=(const ThreadPool &other) = delete;
+	ThreadPool &operator=(ThreadPool &&other) = delete;
+	
+	// Get the pool that is shared by the whole game. It always has at least
+	// one worker thread, so background tasks never run on the calling thread.
+	static ThreadPool &Shared();
+	
+	// Call the given function once for each index in [0, count). The calls
+	// may happen in any order and on any thread, so the function must not
+	// modify any state that is shared between jobs.
+	void ForEach(size_t count, const std::function<void(size_t)> &job, Priority priority = Priority::HIGH);
+	// Run the given task on one of the worker threads, without waiting for it.
+	// Anything the task refers to must outlive it. If the pool is destroyed
+	// first, tasks that have not started yet are never run.
+	void Run(std::function<void()> task, Priority priority = Priority::LOW);
+	
+	// Get the number of threads (including the caller) that run jobs.
+	size_t Concurrency() const;
+	
+	
+private:
+	class Batch {
+	public:
+		Batch(const std::function<void(size_t)> *job, size_t count, Priority priority);
+		
+		// The function to call for each index. For a batch that some thread is
+		// waiting on, that thread owns the function. A background task's
+		// function is kept here instead.
+		const std::function<void(size_t)> *job;
+		std::function<void(size_t)> task;
+		size_t count;
+		Priority priority;
+		std::atomic<size_t> next;
+		// How many worker threads are running jobs from this batch.
+		unsigned busy = 0;
+	};
+	
+	
+private:
+	// Thread entry point.
+	void Work();
+	// Add a batch to the queue, ahead of any with a lower priority.
+	void Enqueue(const std::shared_ptr<Batch> &batch);
+	// Run jobs from the given batch until none are left.
+	static void RunJobs(Batch &batch);
+	
+	
+private:
+	std::vector<std::thread> threads;
+	
+	std::mutex mutex;
+	std::condition_variable workCondition;
+	std::condition_variable doneCondition;
+	
+	// The batches that still have jobs that no thread has started on.
+	std::deque<std::shared_ptr<Batch>> queue;
+	bool terminate = false;
+};
+
+
+
+#endif
@@ -25,6 +25,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Messages.h"
 #include "Outfit.h"
 #include "PlayerInfo.h"
+#include "PriceTable.h"
 #include "System.h"
 #include "UI.h"
 
@@ -156,7 +157,7 @@ void TradingPanel::Draw()
 	for(const Trade::Commodity &commodity : GameData::Commodities())
 	{
 		y += 20;
-		int price = system.Trade(commodity.name);
+		int price = PriceTable::Price(system, i);
 		int hold = player.Cargo().Get(commodity.name);
 		
 		bool isSelected = (i++ == selectedRow);
@@ -234,7 +235,7 @@ bool TradingPanel::KeyDown(SDL_Keycode key, Uint16 mod, const Command &command,
 		for(const auto &it : GameData::Commodities())
 		{
 			int64_t amount = player.Cargo().Get(it.name);
-			int64_t price = system.Trade(it.name);
+			int64_t price = PriceTable::Price(system, it.name);
 			if(!price || !amount)
 				continue;
 			
@@ -299,7 +300,7 @@ void TradingPanel::Buy(int64_t amount)
 	
 	amount *= Modifier();
 	const string &type = GameData::Commodities()[selectedRow].name;
-	int64_t price = system.Trade(type);
+	int64_t price = PriceTable::Price(system, selectedRow);
 	if(!price)
 		return;
 	
@@ -14,6 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Command.h"
 #include "Panel.h"
+#include "RenderQueue.h"
 #include "Screen.h"
 
 #include <SDL2/SDL.h>
@@ -117,8 +118,13 @@ void UI::DrawAll()
 		if((*--it)->IsFullScreen())
 			break;
 	
+	// Each panel's rectangles and lines must be drawn before the next panel
+	// draws, because it may start by clearing the screen.
 	for( ; it != stack.end(); ++it)
+	{
 		(*it)->Draw();
+		RenderQueue::Flush();
+	}
 }
 
 
@@ -257,6 +257,11 @@ void Weapon::LoadWeapon(const DataNode &node)
 			++it;
 		}
 	}
+	
+	// Most projectiles are plain bolts that never turn or accelerate and have
+	// no effects or submunitions until they die. Remember which weapons those
+	// are, so that moving their projectiles can skip all the other checks.
+	movesStraight = !homing && !turn && !acceleration && !splitRange && liveEffects.empty();
 }
 
 
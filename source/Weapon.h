@@ -120,6 +120,34 @@ public:
 	// Gravitational weapons deal the same amount of hit force to a ship regardless
 	// of its mass.
 	bool IsGravitational() const;
+	// Check if this weapon's projectiles fly in a straight line at a constant
+	// speed, with nothing happening along the way, so moving them is trivial.
+	bool MovesStraight() const;
+	
+	// The index of each type of damage, including the hit force, in the array
+	// of all damage values.
+	static const int DAMAGE_TYPES = 14;
+	static const int HIT_FORCE = 0;
+	// Normal damage types:
+	static const int SHIELD_DAMAGE = 1;
+	static const int HULL_DAMAGE = 2;
+	static const int FUEL_DAMAGE = 3;
+	static const int HEAT_DAMAGE = 4;
+	static const int ENERGY_DAMAGE = 5;
+	// Status effects:
+	static const int ION_DAMAGE = 6;
+	static const int DISRUPTION_DAMAGE = 7;
+	static const int SLOWING_DAMAGE = 8;
+	// Relative damage types:
+	static const int RELATIVE_SHIELD_DAMAGE = 9;
+	static const int RELATIVE_HULL_DAMAGE = 10;
+	static const int RELATIVE_FUEL_DAMAGE = 11;
+	static const int RELATIVE_HEAT_DAMAGE = 12;
+	static const int RELATIVE_ENERGY_DAMAGE = 13;
+	
+	// Get all the damage values at once, indexed by the types above, so that
+	// they can all be applied to a ship in a single loop.
+	const double *Damage() const;
 	
 	// These values include all submunitions:
 	// Normal damage types:
@@ -189,6 +217,7 @@ private:
 	bool isPhasing = false;
 	bool isDamageScaled = true;
 	bool isGravitational = false;
+	bool movesStraight = false;
 	// Guns and missiles are by default aimed a converged point at the
 	// maximum weapons range in front of the ship. When either the installed
 	// weapon or the gun-port (or both) have the isParallel attribute set
@@ -242,24 +271,6 @@ private:
 	double triggerRadius = 0.;
 	double blastRadius = 0.;
 	
-	static const int DAMAGE_TYPES = 14;
-	static const int HIT_FORCE = 0;
-	// Normal damage types:
-	static const int SHIELD_DAMAGE = 1;
-	static const int HULL_DAMAGE = 2;
-	static const int FUEL_DAMAGE = 3;
-	static const int HEAT_DAMAGE = 4;
-	static const int ENERGY_DAMAGE = 5;
-	// Status effects:
-	static const int ION_DAMAGE = 6;
-	static const int DISRUPTION_DAMAGE = 7;
-	static const int SLOWING_DAMAGE = 8;
-	// Relative damage types:
-	static const int RELATIVE_SHIELD_DAMAGE = 9;
-	static const int RELATIVE_HULL_DAMAGE = 10;
-	static const int RELATIVE_FUEL_DAMAGE = 11;
-	static const int RELATIVE_HEAT_DAMAGE = 12;
-	static const int RELATIVE_ENERGY_DAMAGE = 13;
 	mutable double damage[DAMAGE_TYPES] = {};
 	
 	double piercing = 0.;
@@ -334,6 +345,7 @@ inline bool Weapon::IsSafe() const { return isSafe; }
 inline bool Weapon::IsPhasing() const { return isPhasing; }
 inline bool Weapon::IsDamageScaled() const { return isDamageScaled; }
 inline bool Weapon::IsGravitational() const { return isGravitational; }
+inline bool Weapon::MovesStraight() const { return movesStraight; }
 
 inline double Weapon::ShieldDamage() const { return TotalDamage(SHIELD_DAMAGE); }
 inline double Weapon::HullDamage() const { return TotalDamage(HULL_DAMAGE); }
@@ -351,6 +363,8 @@ inline double Weapon::RelativeFuelDamage() const { return TotalDamage(RELATIVE_F
 inline double Weapon::RelativeHeatDamage() const { return TotalDamage(RELATIVE_HEAT_DAMAGE); }
 inline double Weapon::RelativeEnergyDamage() const { return TotalDamage(RELATIVE_ENERGY_DAMAGE); }
 
+inline const double *Weapon::Damage() const { if(!calculatedDamage) TotalDamage(0); return damage; }
+
 inline bool Weapon::DoesDamage() const { if(!calculatedDamage) TotalDamage(0); return doesDamage; }
 
 inline bool Weapon::HasDamageDropoff() const { return hasDamageDropoff; }
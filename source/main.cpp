@@ -12,6 +12,7 @@ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
 PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 */
 
+#include "Archive.h"
 #include "Audio.h"
 #include "Command.h"
 #include "Conversation.h"
@@ -24,22 +25,34 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "FrameTimer.h"
 #include "GameData.h"
 #include "GameWindow.h"
+#include "GpuProfiler.h"
+#include "MainPanel.h"
 #include "MenuPanel.h"
+#include "Named.h"
+#include "Outfit.h"
 #include "Panel.h"
 #include "PlayerInfo.h"
 #include "Preferences.h"
+#include "Profiler.h"
+#include "Replay.h"
 #include "Screen.h"
+#include "Ship.h"
 #include "SpriteSet.h"
 #include "SpriteShader.h"
+#include "StressTest.h"
 #include "Test.h"
 #include "UI.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <map>
 
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -47,9 +60,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+	const Named<Sprite> FAST_FORWARD("ui/fast forward");
+}
+
 void PrintHelp();
 void PrintVersion();
-void GameLoop(PlayerInfo &player, const Conversation &conversation, const string &testToRun, bool debugMode);
+void GameLoop(PlayerInfo &player, const Conversation &conversation, const string &testToRun, bool debugMode, bool isHeadless);
+int RunTests(const string &resultsPath, int shard, int shardCount, bool debugMode, bool isHeadless);
+int RunReplay(const string &path, PlayerInfo &player, bool isHeadless);
+void PrefetchSounds(const PlayerInfo &player);
 Conversation LoadConversation();
 #ifdef _WIN32
 void InitConsole();
@@ -68,7 +88,20 @@ int main(int argc, char *argv[])
 	Conversation conversation;
 	bool debugMode = false;
 	bool loadOnly = false;
+	bool isHeadless = false;
+	int returnCode = 0;
 	string testToRunName = "";
+	// Instead of a single test, all the active tests can be run one after
+	// another, optionally only every "count"th one starting from "shard".
+	string testResultsPath;
+	int shard = 0;
+	int shardCount = 1;
+	// The player's inputs in flight can be recorded, or a recording of them
+	// can be played back (instead of playing the game normally).
+	string recordPath;
+	string replayPath;
+	// A stress test scenario can also be run instead.
+	string stressPath;
 
 	for(const char *const *it = argv + 1; *it; ++it)
 	{
@@ -91,9 +124,39 @@ int main(int argc, char *argv[])
 			loadOnly = true;
 		else if(arg == "--test" && *++it)
 			testToRunName = *it;
+		else if(arg == "--test-all" && *++it)
+			testResultsPath = *it;
+		else if(arg == "--test-shard" && *++it)
+		{
+			// The shard is given as "<index>/<count>".
+			string value = *it;
+			size_t slash = value.find('/');
+			shard = max(0, atoi(value.c_str()));
+			if(slash != string::npos)
+				shardCount = max(1, atoi(value.c_str() + slash + 1));
+		}
+		else if(arg == "--headless")
+			isHeadless = true;
+		else if(arg == "--record" && *++it)
+			recordPath = *it;
+		else if(arg == "--replay" && *++it)
+			replayPath = *it;
+		else if(arg == "--stress" && *++it)
+			stressPath = *it;
+		else if(arg == "--pack" && *++it)
+		{
+			if(Archive::Write(*it))
+				return 0;
+			cerr << "Unable to pack the resources in \"" << *it << "\"." << endl;
+			return 1;
+		}
 	}
 	
 	try {
+		// In debug mode, keep track of how long each part of loading and of the
+		// game loop takes.
+		Profiler::SetEnabled(debugMode);
+		
 		// Begin loading the game data. Exit early if we are not using the UI.
 		if(!GameData::BeginLoad(argv))
 			return 0;
@@ -103,6 +166,20 @@ int main(int argc, char *argv[])
 			Files::LogError("Test \"" + testToRunName + "\" not found.");
 			return 1;
 		}
+		// Without a window there is no way for anyone to control the game, so
+		// headless mode is only for running tests, playing back recordings, and
+		// running stress tests.
+		if(isHeadless && testToRunName.empty() && testResultsPath.empty() && replayPath.empty() && stressPath.empty())
+		{
+			Files::LogError("Headless mode can only be used to run a test, stress test, or recording.");
+			return 1;
+		}
+		StressTest stressTest;
+		if(!stressPath.empty() && !stressTest.Load(stressPath))
+		{
+			Files::LogError("Unable to load the stress test \"" + stressPath + "\".");
+			return 1;
+		}
 		
 		// Load player data, including reference-checking.
 		PlayerInfo player;
@@ -123,40 +200,64 @@ int main(int argc, char *argv[])
 		
 		Preferences::Load();
 		
-		if(!GameWindow::Init())
-			return 1;
-		
-		GameData::LoadShaders(!GameWindow::HasSwizzle());
-		
-		// Show something other than a blank window.
-		GameWindow::Step();
-		
-		Audio::Init(GameData::Sources());
+		// In headless mode, there is no window, no OpenGL context, and no sound.
+		if(!isHeadless)
+		{
+			if(!GameWindow::Init())
+				return 1;
+			
+			GameData::LoadShaders();
+			GpuProfiler::Init();
+			
+			// Show something other than a blank window.
+			GameWindow::Step();
+			
+			Audio::Init(GameData::Sources());
+			PrefetchSounds(player);
+		}
 		
 		// This is the main loop where all the action begins.
-		GameLoop(player, conversation, testToRunName, debugMode);
+		if(!testResultsPath.empty())
+			returnCode = RunTests(testResultsPath, shard, shardCount, debugMode, isHeadless);
+		else if(!replayPath.empty())
+			returnCode = RunReplay(replayPath, player, isHeadless);
+		else if(!stressPath.empty())
+			returnCode = !stressTest.Run(player, isHeadless);
+		else
+		{
+			if(!recordPath.empty())
+				Replay::Record(recordPath);
+			GameLoop(player, conversation, testToRunName, debugMode, isHeadless);
+		}
+		
+		// Save the most recent timings, for viewing in a trace viewer.
+		if(debugMode)
+			Profiler::WriteTrace(Files::Config() + "profile.json");
 	}
 	catch(const runtime_error &error)
 	{
 		Audio::Quit();
-		bool doPopUp = testToRunName.empty();
+		bool doPopUp = testToRunName.empty() && testResultsPath.empty();
 		GameWindow::ExitWithError(error.what(), doPopUp);
 		return 1;
 	}
 	
 	// Remember the window state and preferences if quitting normally.
-	Preferences::Set("maximized", GameWindow::IsMaximized());
-	Preferences::Set("fullscreen", GameWindow::IsFullscreen());
-	Screen::SetRaw(GameWindow::Width(), GameWindow::Height());
+	if(!isHeadless)
+	{
+		Preferences::Set("maximized", GameWindow::IsMaximized());
+		Preferences::Set("fullscreen", GameWindow::IsFullscreen());
+		Screen::SetRaw(GameWindow::Width(), GameWindow::Height());
+	}
 	Preferences::Save();
 	
 	Audio::Quit();
 	GameWindow::Quit();
 	
-	return 0;
+	return returnCode;
 }
 
-void GameLoop(PlayerInfo &player, const Conversation &conversation, const string &testToRunName, bool debugMode)
+void GameLoop(PlayerInfo &player, const Conversation &conversation, const string &testToRunName, bool debugMode, bool isHeadless)
 {
 	// gamePanels is used for the main panel where you fly your spaceship.
 	// All other game content related dialogs are placed on top of the gamePanels.
@@ -175,6 +276,7 @@ void GameLoop(PlayerInfo &player, const Conversation &conversation, const string
 	
 	bool showCursor = true;
 	int cursorTime = 0;
+	int reloadTime = 0;
 	int frameRate = 60;
 	FrameTimer timer(frameRate);
 	bool isPaused = false;
@@ -183,6 +285,13 @@ void GameLoop(PlayerInfo &player, const Conversation &conversation, const string
 	// If fast forwarding, keep track of whether the current frame should be drawn.
 	int skipFrame = 0;
 	
+	// If frames are being interpolated, the game state advances at a fixed rate
+	// no matter how often frames are drawn. Keep track of when the next step
+	// is due, and limit how many steps can be done to catch up in one frame.
+	const chrono::steady_clock::duration STEP_TIME = chrono::nanoseconds(1000000000 / 60);
+	const int MAX_STEPS = 4;
+	chrono::steady_clock::time_point nextStep = chrono::steady_clock::now();
+	
 	// Limit how quickly full-screen mode can be toggled.
 	int toggleTimeout = 0;
 	
@@ -198,9 +307,10 @@ void GameLoop(PlayerInfo &player, const Conversation &conversation, const string
 			--toggleTimeout;
 		chrono::steady_clock::time_point start = chrono::steady_clock::now();
 		
-		// Handle any events that occurred in this frame.
+		// Handle any events that occurred in this frame. Without a window,
+		// there are none.
 		SDL_Event event;
-		while(SDL_PollEvent(&event))
+		while(!isHeadless && SDL_PollEvent(&event))
 		{
 			UI &activeUI = (menuPanels.IsEmpty() ? gamePanels : menuPanels);
 			
@@ -254,8 +364,18 @@ void GameLoop(PlayerInfo &player, const Conversation &conversation, const string
 		// but only if the player is flying around in the main view.
 		bool inFlight = (menuPanels.IsEmpty() && gamePanels.Root() == gamePanels.Top());
 		++cursorTime;
+		
+		// In debug mode, check once a second for data files or images that have
+		// changed. The game data must not change while the engine is calculating
+		// a step, so only check after the player has been out of flight for a while.
+		reloadTime = inFlight ? 0 : reloadTime + 1;
+		if(debugMode && reloadTime >= 60)
+		{
+			reloadTime = 0;
+			GameData::ReloadChanged();
+		}
 		bool shouldShowCursor = (!GameWindow::IsFullscreen() || cursorTime < 600 || !inFlight);
-		if(shouldShowCursor != showCursor)
+		if(!isHeadless && shouldShowCursor != showCursor)
 		{
 			showCursor = shouldShowCursor;
 			SDL_ShowCursor(showCursor);
@@ -268,12 +388,61 @@ void GameLoop(PlayerInfo &player, const Conversation &conversation, const string
 		if(Preferences::Has("Interrupt fast-forward") && !inFlight && isFastForward && !allowFastForward)
 			isFastForward = false;
 		
-		// Tell all the panels to step forward, then draw them.
-		((!isPaused && menuPanels.IsEmpty()) ? gamePanels : menuPanels).StepAll();
+		// Normally the game takes one step per frame. If frames are interpolated
+		// while in flight, it instead takes however many steps have come due
+		// since the last frame (possibly none), and the frame rate is limited
+		// only by the display's refresh rate.
+		bool isInterpolating = !isHeadless && !testContext.testToRun && inFlight && !isPaused
+			&& !isFastForward && frameRate == 60 && Preferences::Has("Interpolate frames");
+		int steps = 1;
+		if(isInterpolating)
+		{
+			steps = 0;
+			for( ; steps < MAX_STEPS && nextStep <= start; ++steps)
+				nextStep += STEP_TIME;
+			// If this frame is too far behind, give up on catching up.
+			if(nextStep <= start)
+				nextStep = start + STEP_TIME;
+			// If the previous step is still being calculated, draw the last step
+			// that finished again rather than waiting for it, and take this step
+			// in a later frame. If several steps are due, this frame is already
+			// behind, so wait for them instead of falling further behind.
+			else if(steps == 1 && !gamePanels.Top()->IsReadyToStep())
+			{
+				steps = 0;
+				nextStep -= STEP_TIME;
+			}
+		}
+		else
+			nextStep = start + STEP_TIME;
+		
+		// The step that the engine begins calculating this frame is drawn in the
+		// next frame. When fast-forwarding, only every third frame is drawn, and
+		// in headless mode nothing is, so the other steps can skip building the
+		// lists of things to draw.
+		bool isSkipping = isFastForward && inFlight && !((mod & KMOD_CAPS) && debugMode);
+		if(!gamePanels.IsEmpty())
+			gamePanels.Top()->SetNextStepDrawn(!isHeadless && (!isSkipping || (skipFrame + 2) % 3 == 0));
 		
-		// All manual events and processing done. Handle any test inputs and events if we have any.
-		if(testContext.testToRun)
-			testContext.testToRun->Step(testContext, menuPanels, gamePanels, player);
+		for(int i = 0; i < steps; ++i)
+		{
+			// Tell all the panels to step forward, then draw them.
+			((!isPaused && menuPanels.IsEmpty()) ? gamePanels : menuPanels).StepAll();
+			
+			// All manual events and processing done. Handle any test inputs and events if we have any.
+			if(testContext.testToRun)
+				testContext.testToRun->Step(testContext, menuPanels, gamePanels, player);
+		}
+		
+		// In headless mode, nothing is drawn and the game runs as fast as it
+		// can. Sprites still need to be read, for their collision masks.
+		if(isHeadless)
+		{
+			GameData::Progress();
+			if(menuPanels.IsEmpty())
+				player.AddPlayTime(chrono::steady_clock::now() - start);
+			continue;
+		}
 		
 		// Caps lock slows the frame rate in debug mode.
 		// Slowing eases in and out over a couple of frames.
@@ -307,11 +476,22 @@ void GameLoop(PlayerInfo &player, const Conversation &conversation, const string
 		// we should draw the game panels instead:
 		(menuPanels.IsEmpty() ? gamePanels : menuPanels).DrawAll();
 		if(isFastForward)
-			SpriteShader::Draw(SpriteSet::Get("ui/fast forward"), Screen::TopLeft() + Point(10., 10.));
+			SpriteShader::Draw(FAST_FORWARD, Screen::TopLeft() + Point(10., 10.));
 		
+		// Upload any preloaded sprites that are now available, so that the
+		// entire backlog does not have to be uploaded when landing on a planet.
+		// This also keeps track of which sprites are in use, so that the ones
+		// that are not can be unloaded if the texture memory limit is reached.
+		GameData::Progress();
+		
+		GpuProfiler::EndFrame();
 		GameWindow::Step();
 		
-		timer.Wait();
+		if(!isInterpolating)
+		{
+			timer.Wait(GameWindow::SwapTime(), GameWindow::RefreshRate());
+			Profiler::SetCounter("Missed frames", timer.MissedFrames());
+		}
 		
 		// If the player ended this frame in-game, count the elapsed time as played time.
 		if(menuPanels.IsEmpty())
@@ -320,7 +500,166 @@ void GameLoop(PlayerInfo &player, const Conversation &conversation, const string
 	
 	// If player quit while landed on a planet, save the game if there are changes.
 	if(player.GetPlanet() && gamePanels.CanSave())
-		player.Save();
+		player.Save(true);
+	Files::FinishWriting();
+}
+
+
+
+// Run every active test (or every one in the given shard) in this process,
+// so that the game data only has to be loaded once. The game is reset to its
+// original state before each test. The results are written to the given file
+// in JUnit's XML format, and the return value is the program's exit code.
+int RunTests(const string &resultsPath, int shard, int shardCount, bool debugMode, bool isHeadless)
+{
+	// Escape a string for use in an XML attribute.
+	auto escape = [](const string &text) -> string
+	{
+		string result;
+		for(char c : text)
+		{
+			if(c == '&')
+				result += "&amp;";
+			else if(c == '<')
+				result += "&lt;";
+			else if(c == '>')
+				result += "&gt;";
+			else if(c == '"')
+				result += "&quot;";
+			else
+				result += c;
+		}
+		return result;
+	};
+	
+	vector<const Test *> tests;
+	int index = 0;
+	for(const auto &it : GameData::Tests())
+		if(it.second.StatusText() == "active" && index++ % shardCount == shard)
+			tests.push_back(&it.second);
+	
+	string cases;
+	int failures = 0;
+	chrono::steady_clock::time_point suiteStart = chrono::steady_clock::now();
+	for(const Test *test : tests)
+	{
+		cout << "Running test \"" << test->Name() << "\"" << endl;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		string failure;
+		{
+			// Each test starts from a new pilot and the game's original state.
+			GameData::Revert();
+			PlayerInfo player;
+			try {
+				GameLoop(player, Conversation(), test->Name(), debugMode, isHeadless);
+			}
+			catch(const runtime_error &error)
+			{
+				failure = error.what();
+			}
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		
+		cases += "\t<testcase name=\"" + escape(test->Name()) + "\" time=\"" + to_string(seconds) + "\"";
+		if(failure.empty())
+			cases += "/>\n";
+		else
+		{
+			++failures;
+			cout << failure << endl;
+			cases += ">\n\t\t<failure message=\"" + escape(failure) + "\"/>\n\t</testcase>\n";
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - suiteStart).count();
+	
+	ofstream out(resultsPath);
+	out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	out << "<testsuite name=\"endless-sky\" tests=\"" << tests.size() << "\" failures=\"" << failures
+		<< "\" time=\"" << to_string(seconds) << "\">\n";
+	out << cases;
+	out << "</testsuite>\n";
+	
+	cout << tests.size() - failures << " of " << tests.size() << " tests passed." << endl;
+	return failures ? 1 : 0;
+}
+
+
+
+// Play back a recording of the player's inputs in flight, as fast as possible
+// and with the profiler on, and write a summary of how long each part of the
+// game loop took to replay.json in the config directory.
+int RunReplay(const string &path, PlayerInfo &player, bool isHeadless)
+{
+	if(!Replay::Play(path, player))
+	{
+		Files::LogError("Unable to play back the recording \"" + path + "\".");
+		return 1;
+	}
+	
+	Profiler::Reset();
+	Profiler::SetEnabled(true);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	int steps = 0;
+	{
+		UI gamePanels;
+		MainPanel *panel = new MainPanel(player);
+		gamePanels.Push(panel);
+		// The recording began as the player took off, so take off the same way
+		// the planet panel does when it closes. This seeds the random numbers,
+		// places the ships, and leaves the planet, so no planet panel is shown.
+		panel->OnCallback();
+		while(!Replay::IsDone())
+		{
+			// Nothing can give the inputs that any other panel would need, so
+			// the playback has to stop if one appears.
+			if(!gamePanels.IsEmpty())
+			{
+				if(gamePanels.Top() != gamePanels.Root())
+					break;
+				gamePanels.Top()->SetNextStepDrawn(!isHeadless);
+			}
+			
+			gamePanels.StepAll();
+			GameData::Progress();
+			++steps;
+			
+			if(!isHeadless)
+			{
+				gamePanels.DrawAll();
+				GpuProfiler::EndFrame();
+				GameWindow::Step();
+			}
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	Profiler::WriteSummary(Files::Config() + "replay.json", Files::Name(path));
+	
+	cout << "Played back " << steps << " steps in " << seconds << " seconds." << endl;
+	if(!Replay::IsDone())
+	{
+		cout << "The playback stopped early, because the game needed other inputs." << endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+
+// Load the sounds that the player's fleet makes before any others.
+void PrefetchSounds(const PlayerInfo &player)
+{
+	for(const shared_ptr<Ship> &ship : player.Ships())
+		for(const auto &it : ship->Outfits())
+		{
+			const Outfit &outfit = *it.first;
+			Audio::Prefetch(outfit.WeaponSound());
+			for(const auto *sounds : {&outfit.FlareSounds(), &outfit.ReverseFlareSounds(),
+					&outfit.SteeringFlareSounds(), &outfit.HyperSounds(), &outfit.HyperInSounds(),
+					&outfit.HyperOutSounds(), &outfit.JumpSounds(), &outfit.JumpInSounds(),
+					&outfit.JumpOutSounds()})
+				for(const auto &sound : *sounds)
+					Audio::Prefetch(sound.first);
+		}
 }
 
 
@@ -337,9 +676,27 @@ void PrintHelp()
 	cerr << "    -r, --resources <path>: load resources from given directory." << endl;
 	cerr << "    -c, --config <path>: save user's files to given directory." << endl;
 	cerr << "    -d, --debug: turn on debugging features (e.g. Caps Lock slows down instead of speeds up)." << endl;
+	cerr << "        This also shows how long each part of the game loop takes, and saves a" << endl;
+	cerr << "        trace of the last few seconds to profile.json in the config directory." << endl;
+	cerr << "        A trace of the game's startup is saved to startup.json when loading finishes." << endl;
 	cerr << "    -p, --parse-save: load the most recent saved game and inspect it for content errors" << endl;
 	cerr << "    --tests: print table of available tests, then exit." << endl;
 	cerr << "    --test <name>: run given test from resources directory" << endl;
+	cerr << "    --test-all <path>: run every active test, loading the game data only once, and" << endl;
+	cerr << "        write the results to the given file in JUnit's XML format." << endl;
+	cerr << "    --test-shard <index>/<count>: with --test-all, only run every <count>th test," << endl;
+	cerr << "        starting from the given index, so that several processes can share the tests." << endl;
+	cerr << "    --headless: run the test without a window, drawing, sound, or frame rate limit." << endl;
+	cerr << "    --record <path>: record the commands given in flight to the given file, along with" << endl;
+	cerr << "        the saved game and random seed they began with." << endl;
+	cerr << "    --replay <path>: play back a recording made with --record, as fast as possible, and" << endl;
+	cerr << "        save how long each part of each step took to replay.json in the config directory." << endl;
+	cerr << "    --stress <path>: run the stress test scenario in the given file (see StressTest.h)," << endl;
+	cerr << "        print how long each part of a step took, and save a summary to stress.json." << endl;
+	cerr << "    --memory-report: once the game has finished loading, print how much memory" << endl;
+	cerr << "        each part of it is using." << endl;
+	cerr << "    --pack <path>: pack the data, images, and sounds in the given resource or plugin" << endl;
+	cerr << "        directory into one archive file, which the game reads instead of the separate files." << endl;
 	cerr << endl;
 	cerr << "Report bugs to: <https://github.com/endless-sky/endless-sky/issues>" << endl;
 	cerr << "Home page: <https://endless-sky.github.io>" << endl;
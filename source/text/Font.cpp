@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DisplayText.h"
 #include "../ImageBuffer.h"
 #include "../Point.h"
+#include "../RenderQueue.h"
 #include "../Screen.h"
 #include "truncate.hpp"
 
@@ -34,24 +35,18 @@ namespace {
 		"// vertex font shader\n"
 		// "scale" maps pixel coordinates to GL coordinates (-1 to 1).
 		"uniform vec2 scale;\n"
-		// The (x, y) coordinates of the top left corner of the glyph.
-		"uniform vec2 position;\n"
-		// The glyph to draw. (ASCII value - 32).
-		"uniform int glyph;\n"
-		// Aspect ratio of rendered glyph (unity by default).
-		"uniform float aspect = 1.f;\n"
 		
-		// Inputs from the VBO.
+		// Inputs from the VBO: the position of each corner of a glyph, in
+		// pixels, and the point in the texture that it corresponds to.
 		"in vec2 vert;\n"
 		"in vec2 corner;\n"
 		
 		// Output to the fragment shader.
 		"out vec2 texCoord;\n"
 		
-		// Pick the proper glyph out of the texture.
 		"void main() {\n"
-		"  texCoord = vec2((glyph + corner.x) / 98.f, corner.y);\n"
-		"  gl_Position = vec4((aspect * vert.x + position.x) * scale.x, (vert.y + position.y) * scale.y, 0, 1);\n"
+		"  texCoord = corner;\n"
+		"  gl_Position = vec4(vert * scale, 0, 1);\n"
 		"}\n";
 	
 	const char *fragmentCode =
@@ -72,6 +67,34 @@ namespace {
 		"}\n";
 	
 	const int KERN = 2;
+	
+	// Each glyph is drawn as two triangles, with six vertices of four floats.
+	const int FLOATS_PER_VERTEX = 4;
+	const int FLOATS_PER_GLYPH = 6 * FLOATS_PER_VERTEX;
+	
+	// Binary search for the largest number of characters, less than the full
+	// length of the string, whose measured width fits within the given limit.
+	// The width of the characters that were kept is stored in fitWidth.
+	template <class Measure>
+	size_t FitLength(size_t length, int limit, int &fitWidth, Measure measure)
+	{
+		size_t low = 0;
+		size_t high = length ? length - 1 : 0;
+		fitWidth = measure(low);
+		while(low < high)
+		{
+			size_t middle = (low + high + 1) / 2;
+			int middleWidth = measure(middle);
+			if(middleWidth <= limit)
+			{
+				low = middle;
+				fitWidth = middleWidth;
+			}
+			else
+				high = middle - 1;
+		}
+		return low;
+	}
 }
 
 
@@ -131,21 +154,9 @@ void Font::Draw(const string &str, const Point &point, const Color &color) const
 
 void Font::DrawAliased(const string &str, double x, double y, const Color &color) const
 {
-	glUseProgram(shader.Object());
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glBindVertexArray(vao);
-	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	// Update the scale, only if the screen size has changed.
-	if(Screen::Width() != screenWidth || Screen::Height() != screenHeight)
-	{
-		screenWidth = Screen::Width();
-		screenHeight = Screen::Height();
-		GLfloat scale[2] = {2.f / screenWidth, -2.f / screenHeight};
-		glUniform2fv(scaleI, 1, scale);
-	}
-	
+	// Lay out all the glyphs in the string first, so that they can all be
+	// drawn at once.
+	vertices.clear();
 	GLfloat textPos[2] = {
 		static_cast<float>(x - 1.),
 		static_cast<float>(y)};
@@ -171,29 +182,44 @@ void Font::DrawAliased(const string &str, double x, double y, const Color &color
 			continue;
 		}
 		
-		glUniform1i(glyphI, glyph);
-		glUniform1f(aspectI, 1.f);
-		
 		textPos[0] += advance[previous * GLYPHS + glyph] + KERN;
-		glUniform2fv(positionI, 1, textPos);
-		
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		AddGlyph(glyph, textPos[0], textPos[1], 1.f);
 		
 		if(underlineChar)
 		{
-			glUniform1i(glyphI, underscoreGlyph);
-			glUniform1f(aspectI, static_cast<float>(advance[glyph * GLYPHS] + KERN)
+			AddGlyph(underscoreGlyph, textPos[0], textPos[1], static_cast<float>(advance[glyph * GLYPHS] + KERN)
 				/ (advance[underscoreGlyph * GLYPHS] + KERN));
-			
-			glUniform2fv(positionI, 1, textPos);
-			
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 			underlineChar = false;
 		}
 		
 		previous = glyph;
 	}
+	if(vertices.empty())
+		return;
+	
+	RenderQueue::Flush();
+	glUseProgram(shader.Object());
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindVertexArray(vao);
+	
+	glUniform4fv(colorI, 1, color.Get());
+	
+	// Update the scale, only if the screen size has changed.
+	if(Screen::Width() != screenWidth || Screen::Height() != screenHeight)
+	{
+		screenWidth = Screen::Width();
+		screenHeight = Screen::Height();
+		GLfloat scale[2] = {2.f / screenWidth, -2.f / screenHeight};
+		glUniform2fv(scaleI, 1, scale);
+	}
 	
+	// Replace the buffer's contents rather than updating them, so the driver
+	// does not have to wait for the previous string to be drawn.
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+	glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
@@ -328,10 +354,30 @@ void Font::CalculateAdvances(ImageBuffer &image)
 
 
 
+// Add the two triangles for drawing the given glyph, with its top left corner
+// at the given position, and stretched horizontally by the given factor.
+void Font::AddGlyph(int glyph, float x, float y, float aspect) const
+{
+	float left = static_cast<float>(glyph) / GLYPHS;
+	float right = static_cast<float>(glyph + 1) / GLYPHS;
+	float width = aspect * glyphWidth;
+	const GLfloat corners[FLOATS_PER_GLYPH] = {
+		x, y, left, 0.f,
+		x, y + glyphHeight, left, 1.f,
+		x + width, y, right, 0.f,
+		x + width, y, right, 0.f,
+		x, y + glyphHeight, left, 1.f,
+		x + width, y + glyphHeight, right, 1.f
+	};
+	vertices.insert(vertices.end(), corners, corners + FLOATS_PER_GLYPH);
+}
+
+
+
 void Font::SetUpShader(float glyphW, float glyphH)
 {
-	glyphW *= .5f;
-	glyphH *= .5f;
+	glyphWidth = glyphW * .5f;
+	glyphHeight = glyphH * .5f;
 	
 	shader = Shader(vertexCode, fragmentCode);
 	glUseProgram(shader.Object());
@@ -342,19 +388,12 @@ void Font::SetUpShader(float glyphW, float glyphH)
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	
+	// The buffer is filled with each string's glyphs as it is drawn.
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertices[] = {
-		   0.f,    0.f, 0.f, 0.f,
-		   0.f, glyphH, 0.f, 1.f,
-		glyphW,    0.f, 1.f, 0.f,
-		glyphW, glyphH, 1.f, 1.f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	
 	// Connect the xy to the "vert" attribute of the vertex shader.
-	constexpr auto stride = 4 * sizeof(GLfloat);
+	constexpr auto stride = FLOATS_PER_VERTEX * sizeof(GLfloat);
 	glEnableVertexAttribArray(shader.Attrib("vert"));
 	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, stride, nullptr);
 	
@@ -371,9 +410,6 @@ void Font::SetUpShader(float glyphW, float glyphH)
 	
 	colorI = shader.Uniform("color");
 	scaleI = shader.Uniform("scale");
-	glyphI = shader.Uniform("glyph");
-	aspectI = shader.Uniform("aspect");
-	positionI = shader.Uniform("position");
 }
 
 
@@ -442,44 +478,12 @@ string Font::TruncateBack(const string &str, int &width) const
 		return str;
 	}
 	
-	int prevChars = str.size();
-	int prevWidth = firstWidth;
-	
-	width -= widthEllipses;
-	// As a safety against infinite loops (even though they won't be possible if
-	// this implementation is correct) limit the number of loops to the number
-	// of characters in the string.
-	for(size_t i = 0; i < str.length(); ++i)
+	int chars = FitLength(str.size(), width - widthEllipses, width, [this, &str](size_t count)
 	{
-		// Loop until the previous width we tried was too long and this one is
-		// too short, or vice versa. Each time, the next string length we try is
-		// interpolated from the previous width.
-		int nextChars = (prevChars * width) / prevWidth;
-		bool isSame = (nextChars == prevChars);
-		bool prevWorks = (prevWidth <= width);
-		nextChars += (prevWorks ? isSame : -isSame);
-		
-		int nextWidth = WidthRawString(str.substr(0, nextChars).c_str(), '.');
-		bool nextWorks = (nextWidth <= width);
-		if(prevWorks != nextWorks && abs(nextChars - prevChars) == 1)
-		{
-			if(prevWorks)
-			{
-				width = prevWidth + widthEllipses;
-				return str.substr(0, prevChars) + "...";
-			}
-			else
-			{
-				width = nextWidth + widthEllipses;
-				return str.substr(0, nextChars) + "...";
-			}
-		}
-		
-		prevChars = nextChars;
-		prevWidth = nextWidth;
-	}
-	width = firstWidth;
-	return str;
+		return WidthRawString(str.substr(0, count).c_str(), '.');
+	});
+	width += widthEllipses;
+	return str.substr(0, chars) + "...";
 }
 
 
@@ -493,44 +497,12 @@ string Font::TruncateFront(const string &str, int &width) const
 		return str;
 	}
 	
-	int prevChars = str.size();
-	int prevWidth = firstWidth;
-	
-	width -= widthEllipses;
-	// As a safety against infinite loops (even though they won't be possible if
-	// this implementation is correct) limit the number of loops to the number
-	// of characters in the string.
-	for(size_t i = 0; i < str.length(); ++i)
+	int chars = FitLength(str.size(), width - widthEllipses, width, [this, &str](size_t count)
 	{
-		// Loop until the previous width we tried was too long and this one is
-		// too short, or vice versa. Each time, the next string length we try is
-		// interpolated from the previous width.
-		int nextChars = (prevChars * width) / prevWidth;
-		bool isSame = (nextChars == prevChars);
-		bool prevWorks = (prevWidth <= width);
-		nextChars += (prevWorks ? isSame : -isSame);
-		
-		int nextWidth = WidthRawString(str.substr(str.size() - nextChars).c_str());
-		bool nextWorks = (nextWidth <= width);
-		if(prevWorks != nextWorks && abs(nextChars - prevChars) == 1)
-		{
-			if(prevWorks)
-			{
-				width = prevWidth + widthEllipses;
-				return "..." + str.substr(str.size() - prevChars);
-			}
-			else
-			{
-				width = nextWidth + widthEllipses;
-				return "..." + str.substr(str.size() - nextChars);
-			}
-		}
-		
-		prevChars = nextChars;
-		prevWidth = nextWidth;
-	}
-	width = firstWidth;
-	return str;
+		return WidthRawString(str.substr(str.size() - count).c_str());
+	});
+	width += widthEllipses;
+	return "..." + str.substr(str.size() - chars);
 }
 
 
@@ -544,43 +516,14 @@ string Font::TruncateMiddle(const string &str, int &width) const
 		return str;
 	}
 	
-	int prevChars = str.size();
-	int prevWidth = firstWidth;
-	
-	width -= widthEllipses;
-	// As a safety against infinite loops (even though they won't be possible if
-	// this implementation is correct), limit the number of loops to the number
-	// of characters in the string.
-	for(size_t i = 0; i < str.length(); ++i)
+	int chars = FitLength(str.size(), width - widthEllipses, width, [this, &str](size_t count)
 	{
-		// Loop until the previous width we tried was too long and this one is
-		// too short, or vice versa. Each time, the next string length we try is
-		// interpolated from the previous width.
-		int nextChars = (prevChars * width) / prevWidth;
-		bool isSame = (nextChars == prevChars);
-		bool prevWorks = (prevWidth <= width);
-		nextChars += (prevWorks ? isSame : -isSame);
-		
-		int leftChars = nextChars / 2;
-		int rightChars = nextChars - leftChars;
-		int nextWidth = WidthRawString((str.substr(0, leftChars) + str.substr(str.size() - rightChars)).c_str(), '.');
-		bool nextWorks = (nextWidth <= width);
-		if(prevWorks != nextWorks && abs(nextChars - prevChars) == 1)
-		{
-			if(prevWorks)
-			{
-				leftChars = prevChars / 2;
-				rightChars = prevChars - leftChars;
-				width = prevWidth + widthEllipses;
-			}
-			else
-				width = nextWidth + widthEllipses;
-			return str.substr(0, leftChars) + "..." + str.substr(str.size() - rightChars);
-		}
-		
-		prevChars = nextChars;
-		prevWidth = nextWidth;
-	}
-	width = firstWidth;
-	return str;
+		size_t leftChars = count / 2;
+		size_t rightChars = count - leftChars;
+		return WidthRawString((str.substr(0, leftChars) + str.substr(str.size() - rightChars)).c_str(), '.');
+	});
+	width += widthEllipses;
+	int leftChars = chars / 2;
+	int rightChars = chars - leftChars;
+	return str.substr(0, leftChars) + "..." + str.substr(str.size() - rightChars);
 }
@@ -18,6 +18,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "../gl_header.h"
 
 #include <string>
+#include <vector>
 
 class Color;
 class DisplayText;
@@ -61,6 +62,7 @@ private:
 	void LoadTexture(ImageBuffer &image);
 	void CalculateAdvances(ImageBuffer &image);
 	void SetUpShader(float glyphW, float glyphH);
+	void AddGlyph(int glyph, float x, float y, float aspect) const;
 	
 	int WidthRawString(const char *str, char after = ' ') const noexcept;
 	
@@ -78,9 +80,12 @@ private:
 	
 	GLint colorI = 0;
 	GLint scaleI = 0;
-	GLint glyphI = 0;
-	GLint aspectI = 0;
-	GLint positionI = 0;
+	
+	// The size of each glyph on screen, and the vertices for the glyphs of
+	// the string that is being drawn.
+	float glyphWidth = 0.f;
+	float glyphHeight = 0.f;
+	mutable std::vector<GLfloat> vertices;
 	
 	int height = 0;
 	int space = 0;
@@ -221,11 +221,12 @@ double Format::Parse(const string &str)
 
 
 
-string Format::Replace(const string &source, const map<string, string> keys)
+string Format::Replace(const string &source, const map<string, string> &keys)
 {
 	string result;
 	result.reserve(source.length());
 	
+	string key;
 	size_t start = 0;
 	size_t search = start;
 	while(search < source.length())
@@ -238,21 +239,17 @@ string Format::Replace(const string &source, const map<string, string> keys)
 		if(right == string::npos)
 			break;
 		
-		bool matched = false;
 		++right;
-		size_t length = right - left;
-		for(const auto &it : keys)
-			if(!source.compare(left, length, it.first))
-			{
-				result.append(source, start, left - start);
-				result.append(it.second);
-				start = right;
-				search = start;
-				matched = true;
-				break;
-			}
-		
-		if(!matched)
+		key.assign(source, left, right - left);
+		auto it = keys.find(key);
+		if(it != keys.end())
+		{
+			result.append(source, start, left - start);
+			result.append(it->second);
+			start = right;
+			search = start;
+		}
+		else
 			search = left + 1;
 	}
 	
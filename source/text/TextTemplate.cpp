@@ -0,0 +1,83 @@
+/* TextTemplate.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "TextTemplate.h"
+
+using namespace std;
+
+
+
+TextTemplate::TextTemplate(const string &text)
+	: text(text)
+{
+	// Every '<' that has a '>' somewhere after it begins a possible key. Once
+	// there is no '>' left, none of the remaining text can contain a key.
+	size_t right = string::npos;
+	for(size_t left = text.find('<'); left != string::npos; left = text.find('<', left + 1))
+	{
+		if(right == string::npos || right < left)
+		{
+			right = text.find('>', left);
+			if(right == string::npos)
+				break;
+		}
+		segments.emplace_back(left, right + 1 - left);
+	}
+}
+
+
+
+const string &TextTemplate::Text() const
+{
+	return text;
+}
+
+
+
+bool TextTemplate::IsEmpty() const
+{
+	return text.empty();
+}
+
+
+
+string TextTemplate::Replace(const map<string, string> &keys) const
+{
+	if(segments.empty())
+		return text;
+	
+	string result;
+	result.reserve(text.length());
+	
+	// The key is copied into the same string each time, so that looking it up
+	// does not need to allocate any memory unless it is a very long key.
+	string key;
+	size_t start = 0;
+	for(const pair<size_t, size_t> &segment : segments)
+	{
+		// Anything inside a key that was already replaced is not searched.
+		if(segment.first < start)
+			continue;
+		
+		key.assign(text, segment.first, segment.second);
+		auto it = keys.find(key);
+		if(it == keys.end())
+			continue;
+		
+		result.append(text, start, segment.first - start);
+		result.append(it->second);
+		start = segment.first + segment.second;
+	}
+	
+	result.append(text, start, text.length() - start);
+	return result;
+}
@@ -0,0 +1,50 @@
+/* TextTemplate.h
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ES_TEXT_TEXT_TEMPLATE_H_
+#define ES_TEXT_TEXT_TEMPLATE_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+// Text containing "keys" in the form "<name>" that are to be replaced with
+// other strings. The text is searched for anything that might be a key once,
+// when the template is created, so that filling it in many times (e.g. for
+// every mission that is offered) only has to look up those keys.
+class TextTemplate {
+public:
+	TextTemplate() = default;
+	explicit TextTemplate(const std::string &text);
+	
+	const std::string &Text() const;
+	bool IsEmpty() const;
+	
+	// Replace each key with its value in the given map, and return the result.
+	// This gives exactly the same result as Format::Replace().
+	std::string Replace(const std::map<std::string, std::string> &keys) const;
+	
+	
+private:
+	std::string text;
+	// The start and length of each part of the text that might be a key: a '<'
+	// and the first '>' after it. These may overlap, e.g. in "<a <b>".
+	std::vector<std::pair<std::size_t, std::size_t>> segments;
+};
+
+
+
+#endif
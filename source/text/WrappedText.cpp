@@ -16,9 +16,39 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Font.h"
 
 #include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 using namespace std;
 
+namespace {
+	// Identify a layout by a hash of its text and every setting that affects
+	// where the words are placed.
+	class LayoutKey {
+	public:
+		size_t textHash;
+		const Font *font;
+		int wrapWidth;
+		int tabWidth;
+		int lineHeight;
+		int paragraphBreak;
+		Alignment alignment;
+		
+		bool operator<(const LayoutKey &other) const
+		{
+			return tie(textHash, font, wrapWidth, tabWidth, lineHeight, paragraphBreak, alignment)
+				< tie(other.textHash, other.font, other.wrapWidth, other.tabWidth, other.lineHeight,
+					other.paragraphBreak, other.alignment);
+		}
+	};
+	
+	// Once this many layouts are cached, start over with an empty cache, so
+	// that text that is no longer shown does not accumulate forever.
+	const size_t MAX_CACHED_LAYOUTS = 1000;
+}
+
 
 
 WrappedText::WrappedText(const Font &font)
@@ -205,6 +235,37 @@ void WrappedText::Wrap()
 	if(text.empty() || !font)
 		return;
 	
+	// Many panels re-wrap the same text every frame, so if this exact text has
+	// been wrapped with the same settings before, reuse that layout instead of
+	// measuring every word again.
+	static mutex cacheMutex;
+	static map<LayoutKey, CachedLayout> cache;
+	
+	LayoutKey key = {hash<string>()(text), font, wrapWidth, tabWidth, lineHeight, paragraphBreak, alignment};
+	lock_guard<mutex> lock(cacheMutex);
+	auto it = cache.find(key);
+	if(it != cache.end() && it->second.source == text)
+	{
+		text = it->second.text;
+		words = it->second.words;
+		height = it->second.height;
+		return;
+	}
+	
+	if(cache.size() >= MAX_CACHED_LAYOUTS)
+		cache.clear();
+	CachedLayout &layout = cache[key];
+	layout.source = text;
+	DoWrap();
+	layout.text = text;
+	layout.words = words;
+	layout.height = height;
+}
+
+
+
+void WrappedText::DoWrap()
+{
 	// Do this as a finite state machine.
 	Word word;
 	bool hasWord = false;
@@ -75,6 +75,7 @@ public:
 private:
 	void SetText(const char *it, size_t length);
 	void Wrap();
+	void DoWrap();
 	void AdjustLine(size_t &lineBegin, int &lineWidth, bool isEnd);
 	int Space(char c) const;
 	
@@ -96,6 +97,16 @@ private:
 		friend class WrappedText;
 	};
 	
+	// A previously calculated layout, for reuse whenever the same text is
+	// wrapped again with the same settings.
+	class CachedLayout {
+	public:
+		std::string source;
+		std::string text;
+		std::vector<Word> words;
+		int height = 0;
+	};
+	
 	
 private:
 	const Font *font = nullptr;
@@ -0,0 +1,61 @@
+#!/bin/bash
+# Run all the active tests, split between several game processes that run at
+# the same time. Each process loads the game data once and then runs its share
+# of the tests one after another (see the --test-all option). The results of
+# each process are written in JUnit's XML format.
+
+# Retrieve parameters that give the executable and datafile-paths.
+if [ -z "$1" ] || [ -z "$2" ]; then
+  echo "You must supply a path to the binary as an argument,"
+  echo "and you must supply a path to the ES resources (data-files), e.g."
+  echo "~$ ./tests/run_tests_parallel.sh ./endless-sky ./ [results-directory] [processes]"
+  exit 1
+fi
+
+ES_EXEC_PATH="$1"
+RESOURCES="$2"
+RESULTS_PATH="${3:-.}"
+JOBS="${4:-$(nproc)}"
+ES_CONFIG_TEMPLATE_PATH="${RESOURCES}/tests/config"
+
+if [ ! -x "${ES_EXEC_PATH}" ]
+then
+	echo "Endless sky executable not found or not executable."
+	exit 1
+fi
+mkdir -p "${RESULTS_PATH}"
+
+# Each process gets a config directory of its own, so that the saved games
+# that the tests inject do not interfere with each other.
+PIDS=()
+CONFIGS=()
+for (( SHARD=0; SHARD<JOBS; SHARD++ ))
+do
+	ES_CONFIG_PATH=$(mktemp --directory)
+	mkdir -p "${ES_CONFIG_PATH}/saves"
+	cp ${ES_CONFIG_TEMPLATE_PATH}/* "${ES_CONFIG_PATH}"
+	CONFIGS+=("${ES_CONFIG_PATH}")
+	
+	"${ES_EXEC_PATH}" --resources "${RESOURCES}" --config "${ES_CONFIG_PATH}" --headless \
+		--test-all "${RESULTS_PATH}/results-${SHARD}.xml" --test-shard "${SHARD}/${JOBS}" 2>&1 |\
+		sed -e "/^ALSA lib.*$/d" -e "/^AL lib.*$/d" | sed "s/^/[${SHARD}] /" &
+	PIDS+=($!)
+done
+
+# Wait for every process, and check whether any of them had failures.
+FAILED=0
+for (( SHARD=0; SHARD<JOBS; SHARD++ ))
+do
+	wait ${PIDS[${SHARD}]}
+	if ! grep -q 'failures="0"' "${RESULTS_PATH}/results-${SHARD}.xml" 2>/dev/null
+	then
+		echo "# Tests in shard ${SHARD} failed; temporary directory: ${CONFIGS[${SHARD}]}"
+		if [ -f "${CONFIGS[${SHARD}]}/errors.txt" ]
+		then
+			echo "#   errors.txt content:"
+			sed "s/^/#     /" "${CONFIGS[${SHARD}]}/errors.txt"
+		fi
+		FAILED=1
+	fi
+done
+exit ${FAILED}
@@ -0,0 +1,92 @@
+/* test_angle.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/Angle.h"
+
+// ... and any system includes needed for the test file.
+#include <cmath>
+#include <vector>
+
+namespace { // test namespace
+
+// #region mock data
+const double PI = 3.14159265358979323846;
+// #endregion mock data
+
+
+
+// #region unit tests
+SCENARIO( "Converting an angle to a unit vector", "[angle]" ) {
+	GIVEN( "any of the possible angles" ) {
+		THEN( "the unit vector matches the sine and cosine of that angle" ) {
+			double maxError = 0.;
+			for(int i = 0; i < 0x10000; ++i)
+			{
+				Angle angle(i * (360. / 0x10000));
+				Point unit = angle.Unit();
+				double radians = i * (PI / 0x8000);
+				maxError = std::max(maxError, std::fabs(unit.X() - std::sin(radians)));
+				maxError = std::max(maxError, std::fabs(unit.Y() + std::cos(radians)));
+			}
+			CHECK( maxError < 1e-14 );
+		}
+	}
+	GIVEN( "an angle of 90 degrees" ) {
+		Angle angle(90.);
+		THEN( "its unit vector points to the right" ) {
+			CHECK( angle.Unit().X() == Approx(1.) );
+			CHECK( angle.Unit().Y() == Approx(0.).margin(1e-15) );
+		}
+	}
+}
+
+SCENARIO( "Rotating many points at once", "[angle]" ) {
+	GIVEN( "a list of points and an angle" ) {
+		std::vector<Point> points = {Point(1., 2.), Point(-3., 4.), Point(0., -5.)};
+		Angle angle(37.);
+		WHEN( "they are all rotated together" ) {
+			std::vector<Point> result(points.size());
+			angle.Rotate(points.begin(), points.end(), result.begin());
+			THEN( "each one is rotated the same as it would be on its own" ) {
+				for(size_t i = 0; i < points.size(); ++i)
+				{
+					CHECK( result[i].X() == angle.Rotate(points[i]).X() );
+					CHECK( result[i].Y() == angle.Rotate(points[i]).Y() );
+				}
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark Angle::Unit", "[!benchmark][angle]" ) {
+	std::vector<Angle> angles;
+	for(int i = 0; i < 4096; ++i)
+		angles.push_back(Angle::Random());
+	BENCHMARK( "Angle::Unit()" ) {
+		Point sum;
+		for(const Angle &angle : angles)
+			sum += angle.Unit();
+		return sum;
+	};
+}
+#endif
+// #endregion benchmarks
+
+
+
+} // test namespace
@@ -0,0 +1,171 @@
+/* test_collisionSet.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/CollisionSet.h"
+
+// ... and any system includes needed for the test file.
+#include "../../source/Body.h"
+#include "../../source/Point.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace { // test namespace
+// #region mock data
+// Bodies without sprites have no extent, so they only touch a query ring if
+// their center is within it.
+std::vector<Body> MakeBodies()
+{
+	std::vector<Body> bodies;
+	for(int i = -5; i <= 5; ++i)
+		bodies.emplace_back(nullptr, Point(100. * i, 50. * i));
+	// One body that is far away, but would share a grid cell with the origin
+	// if the grid coordinates wrap around.
+	bodies.emplace_back(nullptr, Point(256. * 32., 0.));
+	return bodies;
+}
+
+bool Contains(const std::vector<Body *> &result, const Body &body)
+{
+	return std::find(result.begin(), result.end(), &body) != result.end();
+}
+// #endregion mock data
+
+
+
+// #region unit tests
+SCENARIO( "A CollisionSet finds the objects near a point", "[CollisionSet]" ) {
+	auto index = GENERATE(CollisionSet::Index::GRID, CollisionSet::Index::SWEEP_AND_PRUNE);
+	GIVEN( "a collision set filled with some objects" ) {
+		std::vector<Body> bodies = MakeBodies();
+		CollisionSet set(256u, 32u, index);
+		set.Clear(0);
+		for(Body &body : bodies)
+			set.Add(body);
+		set.Finish();
+		
+		WHEN( "a circle is queried" ) {
+			const std::vector<Body *> &result = set.Circle(Point(), 120.);
+			THEN( "only the objects within that radius are found" ) {
+				CHECK( result.size() == 3 );
+				CHECK( Contains(result, bodies[4]) );
+				CHECK( Contains(result, bodies[5]) );
+				CHECK( Contains(result, bodies[6]) );
+				CHECK_FALSE( Contains(result, bodies.back()) );
+			}
+		}
+		WHEN( "a ring is queried" ) {
+			const std::vector<Body *> &result = set.Ring(Point(), 200., 400.);
+			THEN( "only the objects between the two radii are found" ) {
+				CHECK( result.size() == 4 );
+				CHECK( Contains(result, bodies[2]) );
+				CHECK( Contains(result, bodies[3]) );
+				CHECK_FALSE( Contains(result, bodies[4]) );
+				CHECK_FALSE( Contains(result, bodies[5]) );
+				CHECK( Contains(result, bodies[7]) );
+				CHECK( Contains(result, bodies[8]) );
+			}
+		}
+		WHEN( "a rectangle is queried" ) {
+			std::vector<Body *> result;
+			set.Rect(Point(-10., -10.), Point(10., 10.), result);
+			THEN( "the objects in it are found, but not distant ones" ) {
+				CHECK( Contains(result, bodies[5]) );
+				CHECK_FALSE( Contains(result, bodies[0]) );
+				CHECK_FALSE( Contains(result, bodies[10]) );
+				CHECK_FALSE( Contains(result, bodies.back()) );
+			}
+		}
+		WHEN( "a query stores its results in a given vector" ) {
+			std::vector<Body *> result(1, nullptr);
+			set.Circle(Point(), 120., result);
+			THEN( "the vector holds the same objects as the set's own result" ) {
+				const std::vector<Body *> &expected = set.Circle(Point(), 120.);
+				CHECK( result == expected );
+			}
+		}
+		WHEN( "the set is cleared" ) {
+			set.Clear(1);
+			set.Finish();
+			THEN( "nothing is found" ) {
+				CHECK( set.Circle(Point(), 1000.).empty() );
+			}
+		}
+		WHEN( "the same objects are added again without moving" ) {
+			set.Clear(1);
+			for(Body &body : bodies)
+				set.Add(body);
+			set.Finish();
+			THEN( "the same objects are found" ) {
+				CHECK( set.Circle(Point(), 120.).size() == 3 );
+			}
+		}
+		WHEN( "one of the objects moves to a different cell" ) {
+			bodies[5] = Body(nullptr, Point(1000., 1000.));
+			set.Clear(1);
+			for(Body &body : bodies)
+				set.Add(body);
+			set.Finish();
+			THEN( "it is only found in its new location" ) {
+				CHECK_FALSE( Contains(set.Circle(Point(), 120.), bodies[5]) );
+				CHECK( Contains(set.Circle(Point(1000., 1000.), 10.), bodies[5]) );
+			}
+		}
+		WHEN( "the set is cleared twice before being filled again" ) {
+			set.Clear(1);
+			set.Clear(2);
+			set.Finish();
+			THEN( "nothing is found" ) {
+				CHECK( set.Circle(Point(), 1000.).empty() );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark CollisionSet", "[!benchmark][CollisionSet]" ) {
+	auto index = GENERATE(CollisionSet::Index::GRID, CollisionSet::Index::SWEEP_AND_PRUNE);
+	// About as many ships, asteroids, or projectiles as there are in a big
+	// battle, scattered over a few screens.
+	std::vector<Body> bodies;
+	for(int i = 0; i < 1000; ++i)
+		bodies.emplace_back(nullptr, Point((i * 7919) % 8000 - 4000., (i * 104729) % 8000 - 4000.));
+	CollisionSet set(256u, 32u, index);
+	std::string name = (index == CollisionSet::Index::GRID ? "grid" : "sweep and prune");
+	BENCHMARK( "CollisionSet fill, 1000 bodies (" + name + ")" ) {
+		set.Clear(0);
+		for(Body &body : bodies)
+			set.Add(body);
+		set.Finish();
+	};
+	std::vector<Body *> result;
+	BENCHMARK( "CollisionSet::Circle (" + name + ")" ) {
+		set.Circle(Point(100., -200.), 600., result);
+		return result.size();
+	};
+	BENCHMARK( "CollisionSet::Ring (" + name + ")" ) {
+		set.Ring(Point(100., -200.), 400., 1200., result);
+		return result.size();
+	};
+}
+#endif
+// #endregion benchmarks
+
+
+
+} // test namespace
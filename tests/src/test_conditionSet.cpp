@@ -20,7 +20,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "../../source/DataNode.h"
 
 // ... and any system includes needed for the test file.
-#include <map>
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -126,9 +126,35 @@ SCENARIO( "Determining if condition requirements are met", "[ConditionSet][Usage
 	}
 }
 
+SCENARIO( "Finding the conditions a ConditionSet reads", "[ConditionSet][Usage]" ) {
+	GIVEN( "a ConditionSet with comparisons and assignments" ) {
+		const auto conditionSet = ConditionSet{AsDataNode("and\n"
+			"\tcount = year * 2\n"
+			"\tcount > months\n"
+			"\tor\n"
+			"\t\thas \"event: war begins\"")};
+		std::vector<unsigned> ids;
+		const bool isDeterministic = conditionSet.ReferencedConditions(ids);
+		THEN( "every condition that is read is listed" ) {
+			CHECK( isDeterministic );
+			CHECK( std::count(ids.begin(), ids.end(), ConditionsStore::Intern("year")) == 1 );
+			CHECK( std::count(ids.begin(), ids.end(), ConditionsStore::Intern("count")) == 1 );
+			CHECK( std::count(ids.begin(), ids.end(), ConditionsStore::Intern("months")) == 1 );
+			CHECK( std::count(ids.begin(), ids.end(), ConditionsStore::Intern("event: war begins")) == 1 );
+		}
+	}
+	GIVEN( "a ConditionSet that uses random numbers" ) {
+		const auto randomSet = ConditionSet{AsDataNode("and\n\tc >= random")};
+		std::vector<unsigned> ids;
+		THEN( "its result cannot be assumed to stay the same" ) {
+			CHECK_FALSE( randomSet.ReferencedConditions(ids) );
+		}
+	}
+}
+
 SCENARIO( "Applying changes to conditions", "[ConditionSet][Usage]" ) {
 	auto mutableList = ConditionSet::Conditions{};
-	REQUIRE( mutableList.empty() );
+	REQUIRE( mutableList.IsEmpty() );
 	
 	GIVEN( "an empty ConditionSet" ) {
 		const auto emptySet = ConditionSet{};
@@ -136,12 +162,12 @@ SCENARIO( "Applying changes to conditions", "[ConditionSet][Usage]" ) {
 		
 		THEN( "no conditions are added via Apply" ) {
 			emptySet.Apply(mutableList);
-			REQUIRE( mutableList.empty() );
+			REQUIRE( mutableList.IsEmpty() );
 			
-			mutableList.emplace("event: war begins", 1);
-			REQUIRE( mutableList.size() == 1 );
+			mutableList.Set("event: war begins", 1);
+			REQUIRE( mutableList.Size() == 1 );
 			emptySet.Apply(mutableList);
-			REQUIRE( mutableList.size() == 1 );
+			REQUIRE( mutableList.Size() == 1 );
 		}
 	}
 	GIVEN( "a ConditionSet with only comparison expressions" ) {
@@ -154,12 +180,12 @@ SCENARIO( "Applying changes to conditions", "[ConditionSet][Usage]" ) {
 		
 		THEN( "no conditions are added via Apply" ) {
 			compareSet.Apply(mutableList);
-			REQUIRE( mutableList.empty() );
+			REQUIRE( mutableList.IsEmpty() );
 			
-			mutableList.emplace("event: war begins", 1);
-			REQUIRE( mutableList.size() == 1 );
+			mutableList.Set("event: war begins", 1);
+			REQUIRE( mutableList.Size() == 1 );
 			compareSet.Apply(mutableList);
-			REQUIRE( mutableList.size() == 1 );
+			REQUIRE( mutableList.Size() == 1 );
 		}
 	}
 	GIVEN( "a ConditionSet with an assignable expression" ) {
@@ -168,16 +194,60 @@ SCENARIO( "Applying changes to conditions", "[ConditionSet][Usage]" ) {
 		
 		THEN( "the condition list is updated via Apply" ) {
 			applySet.Apply(mutableList);
-			REQUIRE_FALSE( mutableList.empty() );
+			REQUIRE_FALSE( mutableList.IsEmpty() );
 			
-			const auto &inserted = mutableList.find("year");
-			REQUIRE( inserted != mutableList.end() );
-			CHECK( inserted->second == 3013 );
+			const int64_t *inserted = mutableList.Find("year");
+			REQUIRE( inserted );
+			CHECK( *inserted == 3013 );
+		}
+	}
+	GIVEN( "a ConditionSet with complex expressions" ) {
+		const auto complexSet = ConditionSet{AsDataNode("and\n"
+			"\tyear = ( year + 2 ) * 3 - 1\n"
+			"\tcount += year % 7 + -2\n"
+			"\tlocal = count * ( 1 + ( 2 * months ) )")};
+		REQUIRE_FALSE( complexSet.IsEmpty() );
+		
+		THEN( "each expression uses the values assigned by the previous ones" ) {
+			mutableList.Set("year", 4);
+			mutableList.Set("months", 3);
+			// Evaluating a copy must give the same results as the original.
+			const auto copiedSet = complexSet;
+			copiedSet.Apply(mutableList);
+			CHECK( mutableList.Get("year") == 17 );
+			CHECK( mutableList.Get("count") == 1 );
+			CHECK( mutableList.Get("local") == 7 );
+			CHECK( complexSet.Test(mutableList) );
 		}
 	}
 }
 // #endregion unit tests
 
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark ConditionSet::Test", "[!benchmark][ConditionSet]" ) {
+	// A mission offer condition of the usual sort, tested against a list of
+	// conditions that is about as long as a typical player's.
+	const auto set = ConditionSet{AsDataNode("and\n"
+		"\thas \"event: war begins\"\n"
+		"\tnot \"chosen sides\"\n"
+		"\t\"combat rating\" >= 1000\n"
+		"\tor\n"
+		"\t\tyear > 3013\n"
+		"\t\tmonth + day * 2 == 40\n")};
+	auto conditions = ConditionSet::Conditions{};
+	for(int i = 0; i < 1000; ++i)
+		conditions.Set("condition " + std::to_string(i), i);
+	conditions.Set("event: war begins", 1);
+	conditions.Set("combat rating", 4000);
+	conditions.Set("year", 3014);
+	BENCHMARK( "ConditionSet::Test" ) {
+		return set.Test(conditions);
+	};
+}
+#endif
+// #endregion benchmarks
+
 
 
 } // test namespace
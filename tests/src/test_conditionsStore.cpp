@@ -0,0 +1,175 @@
+/* test_conditionsStore.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/ConditionsStore.h"
+
+// ... and any system includes needed for the test file.
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace { // test namespace
+
+// #region mock data
+// #endregion mock data
+
+
+
+// #region unit tests
+SCENARIO( "Interning condition names", "[ConditionsStore]" ) {
+	GIVEN( "a condition name" ) {
+		const unsigned id = ConditionsStore::Intern("test: interned");
+		THEN( "it always has the same nonzero id" ) {
+			CHECK( id != 0 );
+			CHECK( ConditionsStore::Intern("test: interned") == id );
+			CHECK( ConditionsStore::Name(id) == "test: interned" );
+		}
+		THEN( "other names have other ids" ) {
+			CHECK( ConditionsStore::Intern("test: other") != id );
+		}
+	}
+}
+
+SCENARIO( "Storing conditions", "[ConditionsStore]" ) {
+	GIVEN( "an empty store" ) {
+		ConditionsStore store;
+		REQUIRE( store.IsEmpty() );
+		
+		THEN( "missing conditions have a value of zero" ) {
+			CHECK( store.Get("test: missing") == 0 );
+			CHECK_FALSE( store.Find("test: missing") );
+			CHECK_FALSE( store.Has("test: missing") );
+		}
+		WHEN( "many conditions are set" ) {
+			for(int i = 0; i < 1000; ++i)
+				store.Set("test: " + std::to_string(i), i);
+			THEN( "they can all be found again" ) {
+				CHECK( store.Size() == 1000 );
+				bool allFound = true;
+				for(int i = 0; i < 1000; ++i)
+					allFound &= (store.Get("test: " + std::to_string(i)) == i);
+				CHECK( allFound );
+			}
+			THEN( "a condition set to zero is still in the store" ) {
+				CHECK( store.Has("test: 0") );
+			}
+		}
+		WHEN( "conditions are removed" ) {
+			store.Set("test: a", 1);
+			store.Set("test: prefix: b", 2);
+			store.Set("test: prefix: c", 3);
+			store.Erase("test: a");
+			store.EraseWithPrefix("test: prefix: ");
+			THEN( "they are no longer in the store" ) {
+				CHECK( store.IsEmpty() );
+				CHECK_FALSE( store.Has("test: a") );
+				CHECK_FALSE( store.Has("test: prefix: c") );
+			}
+		}
+	}
+	GIVEN( "a store with several conditions" ) {
+		const ConditionsStore store = {{"test: z", 1}, {"test: b", 2}, {"other", 3}, {"test: a", 4}};
+		THEN( "conditions with a prefix are listed in sorted order" ) {
+			const std::vector<std::pair<std::string, int64_t>> expected = {{"test: a", 4}, {"test: b", 2}, {"test: z", 1}};
+			CHECK( store.WithPrefix("test: ") == expected );
+			CHECK( store.WithPrefix().size() == 4 );
+		}
+	}
+}
+
+SCENARIO( "Tracking changes to conditions", "[ConditionsStore]" ) {
+	GIVEN( "a store with one condition" ) {
+		ConditionsStore store;
+		const unsigned id = ConditionsStore::Intern("test: tracked");
+		store.Set(id, 5);
+		const uint64_t revision = store.Revision();
+		REQUIRE( store.Revision(id) == revision );
+		
+		WHEN( "it is set to the same value" ) {
+			store.Set(id, 5);
+			THEN( "it has not changed" ) {
+				CHECK( store.Revision() == revision );
+			}
+		}
+		WHEN( "it is set to a different value" ) {
+			store.Set(id, 6);
+			THEN( "it has changed" ) {
+				CHECK( store.Revision() > revision );
+				CHECK( store.Revision(id) == store.Revision() );
+			}
+		}
+		WHEN( "a different condition changes" ) {
+			store.Set("test: untracked", 1);
+			THEN( "only the store's revision changes" ) {
+				CHECK( store.Revision() > revision );
+				CHECK( store.Revision(id) == revision );
+			}
+		}
+		WHEN( "it is removed" ) {
+			store.Erase("test: tracked");
+			THEN( "it has changed" ) {
+				CHECK( store.Revision(id) > revision );
+			}
+		}
+	}
+}
+
+SCENARIO( "Deriving conditions from other state", "[ConditionsStore]" ) {
+	GIVEN( "a store with providers" ) {
+		ConditionsStore store = {{"test: stored", 1}, {"test: derived", 2}};
+		const unsigned id = ConditionsStore::Intern("test: derived");
+		int64_t value = 5;
+		int calls = 0;
+		store.SetProvider(id, [&value, &calls]() { ++calls; return value; });
+		std::map<std::string, int64_t> values = {{"a", 3}, {"b", 4}};
+		store.SetPrefixProvider("test: family: ", [&values]() { return values; });
+		
+		THEN( "the provider is not called until the condition is read" ) {
+			CHECK( calls == 0 );
+			CHECK( store.Get(id) == 5 );
+			CHECK( store.Get("test: derived") == 5 );
+			CHECK( calls == 1 );
+		}
+		THEN( "conditions with a prefix are derived" ) {
+			CHECK( store.Get("test: family: a") == 3 );
+			CHECK( store.Has("test: family: b") );
+			CHECK_FALSE( store.Has("test: family: c") );
+		}
+		THEN( "derived conditions are listed along with stored ones" ) {
+			const std::vector<std::pair<std::string, int64_t>> expected = {
+				{"test: derived", 5}, {"test: family: a", 3}, {"test: family: b", 4}, {"test: stored", 1}};
+			CHECK( store.WithPrefix("test: ") == expected );
+		}
+		WHEN( "the state changes" ) {
+			CHECK( store.Get(id) == 5 );
+			value = 6;
+			THEN( "the cached value is read until the provider is replaced" ) {
+				CHECK( store.Get(id) == 5 );
+				CHECK( calls == 1 );
+				const uint64_t revision = store.Revision();
+				store.SetProvider(id, [&value]() { return value; });
+				CHECK( store.Get(id) == 6 );
+				CHECK( store.Revision(id) > revision );
+				CHECK( store.ChangedSince(revision) == std::vector<unsigned>{id} );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
@@ -16,14 +16,33 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "../../source/DataNode.h"
 
 // ... and any system includes needed for the test file.
+#include "../../source/DataFile.h"
+
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace { // test namespace
 // #region mock data
 
-// Insert file-local data here, e.g. classes, structs, or fixtures that will be useful
-// to help test this class/method.
+// A small tree of nodes, with several children so that the vector holding them
+// has to grow while the file is being loaded.
+DataNode MakeTree()
+{
+	std::istringstream in(
+		"ship Test\n"
+		"\tattributes\n"
+		"\t\tmass 10\n"
+		"\t\tdrag 1\n"
+		"\tgun 1 2\n"
+		"\tgun 3 4\n"
+		"\tgun 5 6\n"
+		"\tgun 7 8\n"
+		"\tgun 9 10\n");
+	DataFile file(in);
+	return *file.begin();
+}
 
 // #endregion mock data
 
@@ -77,8 +96,97 @@ SCENARIO( "Determining if a token is numeric", "[IsNumber][Parsing][DataNode]" )
 		}
 	}
 }
+
+SCENARIO( "Reading the numbers in a loaded DataNode", "[Value][Parsing][DataNode]" ) {
+	GIVEN( "A node with a mix of numeric and text tokens" ) {
+		std::istringstream in("attribute 1.5e2 \"12 gauge\" -3 .\n");
+		DataFile file(in);
+		const DataNode &node = *file.begin();
+		THEN( "the numbers are recognized" ) {
+			CHECK( node.IsNumber(1) );
+			CHECK( node.IsNumber(3) );
+			CHECK( node.Value(1) == 150. );
+			CHECK( node.Value(3) == -3. );
+		}
+		THEN( "text tokens are not numbers" ) {
+			CHECK_FALSE( node.IsNumber(0) );
+			CHECK_FALSE( node.IsNumber(2) );
+			CHECK( node.Value(2) == 0. );
+		}
+		THEN( "tokens that do not exist are not numbers" ) {
+			CHECK_FALSE( node.IsNumber(5) );
+			CHECK( node.Value(5) == 0. );
+		}
+		THEN( "a copy has the same values" ) {
+			const DataNode copy = node;
+			CHECK( copy.IsNumber(1) );
+			CHECK( copy.Value(1) == 150. );
+		}
+	}
+}
+
+SCENARIO( "Copying and moving a DataNode", "[DataNode]" ) {
+	GIVEN( "A node with children and grandchildren" ) {
+		const DataNode node = MakeTree();
+		THEN( "the children are in the original order" ) {
+			REQUIRE( node.HasChildren() );
+			std::vector<std::string> keys;
+			for(const DataNode &child : node)
+				keys.push_back(child.Token(0) + (child.Size() > 1 ? child.Token(1) : ""));
+			CHECK( keys == std::vector<std::string>{"attributes", "gun1", "gun3", "gun5", "gun7", "gun9"} );
+			CHECK( node.begin()->begin()->Value(1) == 10. );
+		}
+		WHEN( "it is copied" ) {
+			const DataNode copy = node;
+			THEN( "every child traces back to the copy" ) {
+				REQUIRE( copy.HasChildren() );
+				CHECK( copy.begin()->begin()->PrintTrace() == 4 );
+				CHECK( (copy.end() - 1)->PrintTrace() == 2 );
+			}
+		}
+		WHEN( "it is moved" ) {
+			DataNode original = node;
+			const DataNode moved = std::move(original);
+			THEN( "every child traces back to the new node" ) {
+				REQUIRE( moved.HasChildren() );
+				CHECK( moved.begin()->begin()->PrintTrace() == 4 );
+				CHECK( (moved.end() - 1)->Value(2) == 10. );
+			}
+		}
+	}
+}
 // #endregion unit tests
 
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark DataFile parsing", "[!benchmark][DataFile]" ) {
+	// A block of text resembling a ship definition.
+	std::string text;
+	for(int i = 0; i < 100; ++i)
+		text += "ship \"Model " + std::to_string(i) + "\"\n"
+			"\tsprite \"ship/model\"\n"
+			"\tattributes\n"
+			"\t\tcategory \"Medium Warship\"\n"
+			"\t\t\"cost\" 1500000\n"
+			"\t\t\"shields\" 6400\n"
+			"\t\t\"hull\" 2100\n"
+			"\toutfits\n"
+			"\t\t\"Heavy Laser\" 4\n"
+			"\t\t\"Ion Engines\"\n"
+			"\tengine -12 88\n"
+			"\tengine 12 88\n"
+			"\tgun -20 -40\n"
+			"\tgun 20 -40\n"
+			"\t# Comment\n"
+			"\tdescription \"A ship used to measure how fast data files are parsed.\"\n";
+	BENCHMARK( "DataFile(std::istream &), 100 ship definitions" ) {
+		std::istringstream in(text);
+		return DataFile(in);
+	};
+}
+#endif
+// #endregion benchmarks
+
 
 
 } // test namespace
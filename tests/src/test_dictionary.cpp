@@ -0,0 +1,153 @@
+/* test_dictionary.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/Dictionary.h"
+
+// ... and any system includes needed for the test file.
+#include <string>
+#include <vector>
+
+namespace { // test namespace
+// #region mock data
+const Dictionary::Key MASS("mass");
+const Dictionary::Key DRAG("drag");
+// #endregion mock data
+
+
+
+// #region unit tests
+SCENARIO( "Looking up values in a Dictionary", "[Dictionary]" ) {
+	GIVEN( "a dictionary with some values" ) {
+		Dictionary dictionary;
+		dictionary["thrust"] = 3.;
+		dictionary["mass"] = 10.;
+		dictionary["cargo space"] = 5.;
+		
+		THEN( "values can be found by name or by key" ) {
+			CHECK( dictionary.Get("mass") == 10. );
+			CHECK( dictionary.Get(std::string("thrust")) == 3. );
+			CHECK( dictionary.Get(MASS) == 10. );
+		}
+		THEN( "missing values are zero" ) {
+			CHECK( dictionary.Get("hull") == 0. );
+			CHECK( dictionary.Get(DRAG) == 0. );
+		}
+		WHEN( "more values are inserted before the registered ones" ) {
+			dictionary["automaton"] = 1.;
+			dictionary["drag"] = 2.;
+			dictionary["bunks"] = 4.;
+			THEN( "the registered keys still find the right values" ) {
+				CHECK( dictionary.Get(MASS) == 10. );
+				CHECK( dictionary.Get(DRAG) == 2. );
+			}
+			THEN( "a copy finds the same values" ) {
+				const Dictionary copy = dictionary;
+				CHECK( copy.Get(MASS) == 10. );
+				CHECK( copy.Get(DRAG) == 2. );
+			}
+		}
+		WHEN( "a key is registered after the values were added" ) {
+			const Dictionary::Key thrust("thrust");
+			THEN( "its value is still found" ) {
+				CHECK( dictionary.Get(thrust) == 3. );
+			}
+			AND_WHEN( "another value is added" ) {
+				dictionary["afterburner thrust"] = 7.;
+				THEN( "both values are found" ) {
+					CHECK( dictionary.Get(thrust) == 3. );
+					CHECK( dictionary.Get("afterburner thrust") == 7. );
+				}
+			}
+		}
+	}
+}
+
+SCENARIO( "Adding one Dictionary to another", "[Dictionary]" ) {
+	GIVEN( "a dictionary with some values" ) {
+		Dictionary dictionary;
+		dictionary["mass"] = 10.;
+		dictionary["thrust"] = 3.;
+		
+		WHEN( "a dictionary with only the same keys is added" ) {
+			Dictionary other;
+			other["thrust"] = 2.;
+			dictionary.Add(other, 3.);
+			THEN( "the scaled values are added and the others are unchanged" ) {
+				CHECK( dictionary.Get("thrust") == 9. );
+				CHECK( dictionary.Get(MASS) == 10. );
+			}
+		}
+		WHEN( "a dictionary with new keys before, between and after them is added" ) {
+			Dictionary other;
+			other["automaton"] = 1.;
+			other["drag"] = 2.;
+			other["mass"] = -4.;
+			other["turn"] = 5.;
+			dictionary.Add(other, 2.);
+			THEN( "every value is found by name and by key" ) {
+				CHECK( dictionary.Get("automaton") == 2. );
+				CHECK( dictionary.Get(DRAG) == 4. );
+				CHECK( dictionary.Get(MASS) == 2. );
+				CHECK( dictionary.Get("thrust") == 3. );
+				CHECK( dictionary.Get("turn") == 10. );
+			}
+			THEN( "the keys are still in sorted order" ) {
+				std::vector<std::string> names;
+				for(const auto &it : dictionary)
+					names.push_back(it.first);
+				CHECK( names == std::vector<std::string>{"automaton", "drag", "mass", "thrust", "turn"} );
+			}
+		}
+		WHEN( "it is added to an empty dictionary" ) {
+			Dictionary other;
+			other.Add(dictionary);
+			THEN( "the values are copied" ) {
+				CHECK( other.Get(MASS) == 10. );
+				CHECK( other.Get("thrust") == 3. );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark Dictionary::Get", "[!benchmark][dictionary]" ) {
+	// A dictionary about the size of a typical ship's attributes.
+	Dictionary dictionary;
+	std::vector<std::string> names;
+	for(int i = 0; i < 64; ++i)
+		names.push_back("attribute " + std::to_string(i));
+	for(const std::string &name : names)
+		dictionary[name] = 1.;
+	const std::string &name = names[37];
+	const char *literal = "attribute 37";
+	const Dictionary::Key key("attribute 37");
+	BENCHMARK( "Dictionary::Get(const std::string &)" ) {
+		return dictionary.Get(name);
+	};
+	BENCHMARK( "Dictionary::Get(const char *)" ) {
+		return dictionary.Get(literal);
+	};
+	BENCHMARK( "Dictionary::Get(const Key &)" ) {
+		return dictionary.Get(key);
+	};
+}
+#endif
+// #endregion benchmarks
+
+
+
+} // test namespace
@@ -0,0 +1,65 @@
+/* test_distanceMap.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/DistanceMap.h"
+
+// ... and any system includes needed for the test file.
+#include "../../source/System.h"
+
+#include <vector>
+
+namespace { // test namespace
+// DistanceMap refers to GameData, which the unit tests are not linked with, so
+// it can only be used in the benchmark program.
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+// #region mock data
+// A square grid of systems, each linked to its neighbors, with about as many
+// systems as the real map.
+std::vector<System> MakeGrid(int size)
+{
+	std::vector<System> systems(size * size);
+	for(int y = 0; y < size; ++y)
+		for(int x = 0; x < size; ++x)
+		{
+			System *system = &systems[x + y * size];
+			if(x)
+				system->Link(system - 1);
+			if(y)
+				system->Link(system - size);
+		}
+	return systems;
+}
+// #endregion mock data
+
+
+
+// #region benchmarks
+TEST_CASE( "Benchmark DistanceMap", "[!benchmark][DistanceMap]" ) {
+	std::vector<System> systems = MakeGrid(24);
+	const System *center = &systems[systems.size() / 2];
+	int count = systems.size();
+	BENCHMARK( "DistanceMap(const System *), 576 systems" ) {
+		return DistanceMap(center, count).Systems().size();
+	};
+	BENCHMARK( "DistanceMap(const System *), within 5 jumps" ) {
+		return DistanceMap(center, count, 5).Systems().size();
+	};
+}
+// #endregion benchmarks
+#endif
+
+
+
+} // test namespace
@@ -0,0 +1,93 @@
+/* test_flatMap.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/FlatMap.h"
+
+// ... and any system includes needed for the test file.
+#include <utility>
+#include <vector>
+
+namespace { // test namespace
+
+// #region unit tests
+SCENARIO( "A FlatMap keeps its entries sorted by key", "[FlatMap]" ) {
+	GIVEN( "an empty FlatMap" ) {
+		auto m = FlatMap<int, int>{};
+		REQUIRE( m.empty() );
+		REQUIRE( m.size() == 0 );
+		
+		WHEN( "values are added out of order" ) {
+			m[3] = 30;
+			m[1] = 10;
+			m[2] = 20;
+			THEN( "iterating gives them in order of their keys" ) {
+				auto expected = std::vector<std::pair<int, int>>{{1, 10}, {2, 20}, {3, 30}};
+				CHECK( std::vector<std::pair<int, int>>(m.begin(), m.end()) == expected );
+			}
+			THEN( "each of them can be found" ) {
+				CHECK( m.count(2) == 1 );
+				CHECK( m.find(3)->second == 30 );
+			}
+			THEN( "keys that were not added cannot be found" ) {
+				CHECK( m.count(4) == 0 );
+				CHECK( m.find(0) == m.end() );
+			}
+		}
+		
+		WHEN( "the same key is used twice" ) {
+			++m[5];
+			++m[5];
+			THEN( "it is only stored once" ) {
+				CHECK( m.size() == 1 );
+				CHECK( m.find(5)->second == 2 );
+			}
+		}
+	}
+	
+	GIVEN( "a FlatMap with entries in it" ) {
+		auto m = FlatMap<int, int>{};
+		m[1] = 10;
+		m[2] = 20;
+		m[3] = 30;
+		
+		WHEN( "a key in it is erased" ) {
+			CHECK( m.erase(2) == 1 );
+			THEN( "the other entries are still there, in order" ) {
+				auto expected = std::vector<std::pair<int, int>>{{1, 10}, {3, 30}};
+				CHECK( std::vector<std::pair<int, int>>(m.begin(), m.end()) == expected );
+			}
+		}
+		
+		WHEN( "a key that is not in it is erased" ) {
+			CHECK( m.erase(4) == 0 );
+			THEN( "nothing changes" ) {
+				CHECK( m.size() == 3 );
+			}
+		}
+		
+		WHEN( "it is cleared" ) {
+			m.clear();
+			THEN( "it is empty" ) {
+				CHECK( m.empty() );
+				CHECK( m.begin() == m.end() );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
@@ -0,0 +1,89 @@
+/* test_flatSet.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/FlatSet.h"
+
+// ... and any system includes needed for the test file.
+#include <vector>
+
+namespace { // test namespace
+
+// #region unit tests
+SCENARIO( "A FlatSet keeps its values sorted and unique", "[FlatSet]" ) {
+	GIVEN( "an empty FlatSet" ) {
+		auto s = FlatSet<int>{};
+		REQUIRE( s.empty() );
+		REQUIRE( s.size() == 0 );
+		
+		WHEN( "values are inserted out of order" ) {
+			CHECK( s.insert(3) );
+			CHECK( s.insert(1) );
+			CHECK( s.insert(2) );
+			THEN( "iterating gives them in sorted order" ) {
+				CHECK( std::vector<int>(s.begin(), s.end()) == std::vector<int>{1, 2, 3} );
+			}
+			THEN( "each of them can be found" ) {
+				CHECK( s.count(2) == 1 );
+				CHECK( *s.find(3) == 3 );
+			}
+			THEN( "values that were not inserted cannot be found" ) {
+				CHECK( s.count(4) == 0 );
+				CHECK( s.find(0) == s.end() );
+			}
+		}
+		
+		WHEN( "the same value is inserted twice" ) {
+			CHECK( s.insert(5) );
+			CHECK_FALSE( s.insert(5) );
+			THEN( "it is only stored once" ) {
+				CHECK( s.size() == 1 );
+			}
+		}
+	}
+	
+	GIVEN( "a FlatSet with values in it" ) {
+		auto s = FlatSet<int>{};
+		s.insert(1);
+		s.insert(2);
+		s.insert(3);
+		
+		WHEN( "a value in it is erased" ) {
+			CHECK( s.erase(2) == 1 );
+			THEN( "the other values are still there, in order" ) {
+				CHECK( std::vector<int>(s.begin(), s.end()) == std::vector<int>{1, 3} );
+			}
+		}
+		
+		WHEN( "a value that is not in it is erased" ) {
+			CHECK( s.erase(4) == 0 );
+			THEN( "nothing changes" ) {
+				CHECK( s.size() == 3 );
+			}
+		}
+		
+		WHEN( "it is cleared" ) {
+			s.clear();
+			THEN( "it is empty" ) {
+				CHECK( s.empty() );
+				CHECK( s.begin() == s.end() );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
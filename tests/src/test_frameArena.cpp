@@ -0,0 +1,101 @@
+/* test_frameArena.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/FrameArena.h"
+
+// ... and any system includes needed for the test file.
+#include <cstdint>
+
+namespace { // test namespace
+
+// #region unit tests
+SCENARIO( "A FrameArena hands out aligned memory and reuses it", "[FrameArena]" ) {
+	GIVEN( "a new arena" ) {
+		FrameArena arena;
+		REQUIRE( arena.Allocations() == 0 );
+		
+		WHEN( "memory is allocated with different alignments" ) {
+			char *a = static_cast<char *>(arena.Allocate(1, 1));
+			void *b = arena.Allocate(8, 8);
+			void *c = arena.Allocate(32, 16);
+			THEN( "each allocation is aligned and they do not overlap" ) {
+				CHECK( reinterpret_cast<uintptr_t>(b) % 8 == 0 );
+				CHECK( reinterpret_cast<uintptr_t>(c) % 16 == 0 );
+				CHECK( static_cast<char *>(b) > a );
+				CHECK( static_cast<char *>(c) >= static_cast<char *>(b) + 8 );
+			}
+			THEN( "only one block was needed" ) {
+				CHECK( arena.Allocations() == 1 );
+			}
+		}
+		
+		WHEN( "it is reset" ) {
+			void *first = arena.Allocate(100, 8);
+			arena.Reset();
+			THEN( "the same memory is handed out again" ) {
+				CHECK( arena.Allocate(100, 8) == first );
+				CHECK( arena.Allocations() == 1 );
+			}
+		}
+		
+		WHEN( "more memory is needed than one block holds" ) {
+			for(int i = 0; i < 100; ++i)
+				arena.Allocate(4096, 8);
+			size_t grown = arena.Allocations();
+			REQUIRE( grown > 1 );
+			arena.Reset();
+			THEN( "after a reset, the same amount fits without allocating again" ) {
+				size_t merged = arena.Allocations();
+				for(int i = 0; i < 100; ++i)
+					arena.Allocate(4096, 8);
+				CHECK( arena.Allocations() == merged );
+				arena.Reset();
+				CHECK( arena.Allocations() == merged );
+			}
+		}
+	}
+}
+
+#ifdef __linux__
+SCENARIO( "Containers using a FrameAllocator stop allocating once warmed up", "[FrameArena]" ) {
+	GIVEN( "vectors that are rebuilt every step" ) {
+		auto step = []() {
+			FrameArena::NextStep();
+			FrameVector<int> ints;
+			FrameVector<double> doubles(300);
+			for(int i = 0; i < 5000; ++i)
+				ints.push_back(i);
+			return ints.size() + doubles.size();
+		};
+		// Warm up the arena, so it grows to whatever size the step needs.
+		for(int i = 0; i < 3; ++i)
+			step();
+		size_t warm = FrameArena::Local().Allocations();
+		
+		WHEN( "many more steps are taken" ) {
+			for(int i = 0; i < 100; ++i)
+				REQUIRE( step() == 5300 );
+			THEN( "no more memory is allocated from the heap" ) {
+				CHECK( FrameArena::Local().Allocations() == warm );
+			}
+		}
+	}
+}
+#endif
+// #endregion unit tests
+
+
+
+} // test namespace
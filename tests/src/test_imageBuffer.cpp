@@ -0,0 +1,170 @@
+/* test_imageBuffer.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/ImageBuffer.h"
+
+// ... and any system includes needed for the test file.
+#include <cstdint>
+
+namespace { // test namespace
+// #region mock data
+// Fill every pixel of each frame with the frame's index in all four channels,
+// so that averaging pixels from different frames would give a wrong value.
+void FillFrames(ImageBuffer &buffer)
+{
+	for(int frame = 0; frame < buffer.Frames(); ++frame)
+		for(int y = 0; y < buffer.Height(); ++y)
+		{
+			uint32_t *it = buffer.Begin(y, frame);
+			for(int x = 0; x < buffer.Width(); ++x)
+				it[x] = 0x01010101u * (40u * frame);
+		}
+}
+
+// Fill a buffer with pixels that cover many combinations of channel values.
+void FillPattern(ImageBuffer &buffer)
+{
+	uint32_t seed = 12345u;
+	for(int frame = 0; frame < buffer.Frames(); ++frame)
+		for(int y = 0; y < buffer.Height(); ++y)
+			for(int x = 0; x < buffer.Width(); ++x)
+			{
+				seed = seed * 1103515245u + 12345u;
+				buffer.Begin(y, frame)[x] = seed ^ (seed >> 16);
+			}
+}
+
+uint32_t Channel(uint32_t pixel, int channel)
+{
+	return (pixel >> (8 * channel)) & 0xFFu;
+}
+// #endregion mock data
+
+
+
+// #region unit tests
+SCENARIO( "Shrinking an ImageBuffer to half size", "[ImageBuffer]" ) {
+	GIVEN( "a buffer with several frames of an odd size" ) {
+		ImageBuffer buffer(3);
+		buffer.Allocate(7, 5);
+		FillFrames(buffer);
+		
+		WHEN( "it is shrunk" ) {
+			buffer.ShrinkToHalfSize();
+			THEN( "each dimension is rounded down" ) {
+				CHECK( buffer.Width() == 3 );
+				CHECK( buffer.Height() == 2 );
+				CHECK( buffer.Frames() == 3 );
+			}
+			THEN( "each frame only contains its own pixels" ) {
+				for(int frame = 0; frame < 3; ++frame)
+					for(int y = 0; y < buffer.Height(); ++y)
+						for(int x = 0; x < buffer.Width(); ++x)
+							CHECK( buffer.Begin(y, frame)[x] == 0x01010101u * (40u * frame) );
+			}
+		}
+	}
+	GIVEN( "a buffer whose mipmaps were prepared ahead of time" ) {
+		ImageBuffer prepared(2);
+		prepared.Allocate(37, 20);
+		ImageBuffer direct(2);
+		direct.Allocate(37, 20);
+		for(int frame = 0; frame < 2; ++frame)
+			for(int y = 0; y < 20; ++y)
+				for(int x = 0; x < 37; ++x)
+				{
+					uint32_t value = 0x01030507u * static_cast<uint32_t>(x + 3 * y + 11 * frame);
+					prepared.Begin(y, frame)[x] = value;
+					direct.Begin(y, frame)[x] = value;
+				}
+		prepared.PrepareMipmaps();
+		
+		WHEN( "it is shrunk to each mipmap level" ) {
+			THEN( "each level is the same as if it were shrunk directly" ) {
+				while(direct.Width() >= 8 && direct.Height() >= 8)
+				{
+					prepared.ShrinkToHalfSize();
+					direct.ShrinkToHalfSize();
+					REQUIRE( prepared.Width() == direct.Width() );
+					REQUIRE( prepared.Height() == direct.Height() );
+					for(int frame = 0; frame < 2; ++frame)
+						for(int y = 0; y < direct.Height(); ++y)
+							for(int x = 0; x < direct.Width(); ++x)
+								CHECK( prepared.Begin(y, frame)[x] == direct.Begin(y, frame)[x] );
+				}
+			}
+		}
+	}
+}
+
+SCENARIO( "Converting and shrinking an ImageBuffer gives the same result as doing it one pixel at a time", "[ImageBuffer]" ) {
+	GIVEN( "a buffer whose lines are not a multiple of the vector width" ) {
+		ImageBuffer original(2);
+		original.Allocate(37, 6);
+		FillPattern(original);
+		
+		WHEN( "it is converted to premultiplied alpha" ) {
+			for(int additive = 0; additive <= 2; ++additive)
+			{
+				ImageBuffer buffer(2);
+				buffer.Allocate(37, 6);
+				FillPattern(buffer);
+				buffer.Premultiply(0, additive);
+				buffer.Premultiply(1, additive);
+				
+				THEN( "each color channel is multiplied by the alpha and rounded down" ) {
+					for(int frame = 0; frame < 2; ++frame)
+						for(int y = 0; y < 6; ++y)
+							for(int x = 0; x < 37; ++x)
+							{
+								uint32_t in = original.Begin(y, frame)[x];
+								uint32_t out = buffer.Begin(y, frame)[x];
+								uint32_t alpha = Channel(in, 3);
+								for(int channel = 0; channel < 3; ++channel)
+									CHECK( Channel(out, channel) == Channel(in, channel) * alpha / 255u );
+								CHECK( Channel(out, 3) == (additive == 2 ? 0u : additive == 1 ? alpha / 4u : alpha) );
+							}
+				}
+			}
+		}
+		
+		WHEN( "it is shrunk" ) {
+			ImageBuffer buffer(2);
+			buffer.Allocate(37, 6);
+			FillPattern(buffer);
+			buffer.ShrinkToHalfSize();
+			
+			THEN( "each channel is the rounded average of a 2x2 block" ) {
+				REQUIRE( buffer.Width() == 18 );
+				for(int frame = 0; frame < 2; ++frame)
+					for(int y = 0; y < 3; ++y)
+						for(int x = 0; x < 18; ++x)
+							for(int channel = 0; channel < 4; ++channel)
+							{
+								const uint32_t *a = original.Begin(2 * y, frame) + 2 * x;
+								const uint32_t *b = original.Begin(2 * y + 1, frame) + 2 * x;
+								uint32_t sum = Channel(a[0], channel) + Channel(a[1], channel)
+									+ Channel(b[0], channel) + Channel(b[1], channel);
+								CHECK( Channel(buffer.Begin(y, frame)[x], channel) == (sum + 2) / 4 );
+							}
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
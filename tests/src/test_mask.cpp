@@ -0,0 +1,131 @@
+/* test_mask.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/Mask.h"
+
+// ... and any system includes needed for the test file.
+#include "../../source/Angle.h"
+#include "../../source/Point.h"
+
+#include <cmath>
+#include <vector>
+
+namespace { // test namespace
+// #region mock data
+// An outline with about as many points as a typical ship's, roughly circular
+// with the given radius.
+std::vector<Point> MakeOutline(double radius, int points = 48)
+{
+	std::vector<Point> outline;
+	for(int i = 0; i < points; ++i)
+	{
+		double angle = 2. * M_PI * i / points;
+		outline.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+	}
+	return outline;
+}
+
+// A "C" shaped outline, open toward positive x, whose convex hull is a square
+// from -50 to 50 that also covers the gap.
+std::vector<Point> MakeConcaveOutline()
+{
+	return {
+		Point(-50., -50.), Point(50., -50.), Point(50., -30.), Point(-30., -30.),
+		Point(-30., 30.), Point(50., 30.), Point(50., 50.), Point(-50., 50.)};
+}
+// #endregion mock data
+
+
+
+// #region unit tests
+SCENARIO( "A Mask detects collisions with line segments", "[Mask]" ) {
+	GIVEN( "a mask with a round outline" ) {
+		Mask mask;
+		mask.Create(MakeOutline(50.));
+		REQUIRE( mask.IsLoaded() );
+		
+		WHEN( "a segment starts inside the mask" ) {
+			THEN( "the collision is at its start" ) {
+				CHECK( mask.Collide(Point(10., 0.), Point(100., 0.), Angle(30.)) == 0. );
+			}
+		}
+		WHEN( "a segment passes through the mask" ) {
+			double hit = mask.Collide(Point(-100., 0.), Point(200., 0.), Angle(30.));
+			THEN( "the collision is where it crosses the outline" ) {
+				CHECK( hit == Approx(.25).margin(.01) );
+			}
+		}
+		WHEN( "a segment misses the mask" ) {
+			THEN( "there is no collision" ) {
+				CHECK( mask.Collide(Point(-100., 60.), Point(200., 0.), Angle(30.)) == 1. );
+				CHECK( mask.Collide(Point(-1000., 0.), Point(200., 0.), Angle(30.)) == 1. );
+			}
+		}
+	}
+	GIVEN( "a mask with a concave outline" ) {
+		Mask mask;
+		mask.Create(MakeConcaveOutline());
+		REQUIRE( mask.IsLoaded() );
+		
+		WHEN( "a segment passes through the gap in the outline" ) {
+			THEN( "there is no collision" ) {
+				CHECK( mask.Collide(Point(100., 0.), Point(-110., 0.), Angle()) == 1. );
+				CHECK_FALSE( mask.Contains(Point(10., 0.), Angle()) );
+			}
+		}
+		WHEN( "a segment reaches the far side of the gap" ) {
+			double hit = mask.Collide(Point(100., 0.), Point(-200., 0.), Angle());
+			THEN( "the collision is at the inside edge of the outline" ) {
+				CHECK( hit == Approx(.65).margin(.01) );
+			}
+		}
+		WHEN( "a segment passes by just outside the outline" ) {
+			THEN( "there is no collision" ) {
+				CHECK( mask.Collide(Point(-60., -100.), Point(0., 200.), Angle()) == 1. );
+				CHECK( mask.Collide(Point(-100., 60.), Point(200., 0.), Angle()) == 1. );
+			}
+		}
+		WHEN( "a point is inside one of the arms" ) {
+			THEN( "the mask contains it" ) {
+				CHECK( mask.Contains(Point(0., 40.), Angle()) );
+				CHECK( mask.Contains(Point(-40., 0.), Angle()) );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark Mask::Collide", "[!benchmark][Mask]" ) {
+	Mask mask;
+	mask.Create(MakeOutline(50.));
+	Angle facing(30.);
+	Point start(-100., 10.);
+	Point hit(200., 0.);
+	Point miss(200., 80.);
+	BENCHMARK( "Mask::Collide (hit)" ) {
+		return mask.Collide(start, hit, facing);
+	};
+	BENCHMARK( "Mask::Collide (near miss)" ) {
+		return mask.Collide(start, miss, facing);
+	};
+}
+#endif
+// #endregion benchmarks
+
+
+
+} // test namespace
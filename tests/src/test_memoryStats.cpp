@@ -0,0 +1,73 @@
+/* test_memoryStats.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/MemoryStats.h"
+
+// ... and any system includes needed for the test file.
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace { // test namespace
+// #region mock data
+int64_t Total(MemoryStats::Category category)
+{
+	return MemoryStats::Totals()[category].second;
+}
+// #endregion mock data
+
+
+
+// #region unit tests
+SCENARIO( "Keeping track of memory use", "[MemoryStats]" ) {
+	GIVEN( "a category whose total is known" ) {
+		MemoryStats::Set(MemoryStats::SOUNDS, 1000);
+		REQUIRE( Total(MemoryStats::SOUNDS) == 1000 );
+		
+		WHEN( "memory is allocated and freed" ) {
+			MemoryStats::Add(MemoryStats::SOUNDS, 500);
+			MemoryStats::Add(MemoryStats::SOUNDS, -200);
+			THEN( "the total includes both changes" ) {
+				CHECK( Total(MemoryStats::SOUNDS) == 1300 );
+			}
+			THEN( "the other categories are unaffected" ) {
+				MemoryStats::Set(MemoryStats::MASKS, 0);
+				MemoryStats::Add(MemoryStats::SOUNDS, 1);
+				CHECK( Total(MemoryStats::MASKS) == 0 );
+			}
+		}
+		WHEN( "the total is replaced" ) {
+			MemoryStats::Set(MemoryStats::SOUNDS, 64);
+			THEN( "the earlier changes are forgotten" ) {
+				CHECK( Total(MemoryStats::SOUNDS) == 64 );
+			}
+		}
+	}
+	GIVEN( "the totals are printed" ) {
+		MemoryStats::Set(MemoryStats::GAME_DATA, 3 * 1048576);
+		std::ostringstream out;
+		MemoryStats::Print(out);
+		THEN( "every category is listed in megabytes" ) {
+			CHECK( out.str().find("Game data\t3") != std::string::npos );
+			CHECK( out.str().find("Total\t") != std::string::npos );
+			CHECK( MemoryStats::Totals().size() == MemoryStats::CATEGORIES );
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
@@ -67,8 +67,60 @@ SCENARIO( "A position or other geometric vector must be expressed", "[Point]" )
 		}
 	}
 }
+
+SCENARIO( "A point is converted to single precision for drawing", "[Point][Float2]" ) {
+	GIVEN( "a point" ) {
+		Point a(1.5, -2.25);
+		WHEN( "it is converted" ) {
+			Float2 b(a);
+			THEN( "both coordinates are kept" ) {
+				CHECK( b.X() == 1.5f );
+				CHECK( b.Y() == -2.25f );
+			}
+			THEN( "they can be stored into an array" ) {
+				float out[3] = {0.f, 0.f, 7.f};
+				b.Store(out);
+				CHECK( out[0] == 1.5f );
+				CHECK( out[1] == -2.25f );
+				CHECK( out[2] == 7.f );
+			}
+		}
+	}
+	GIVEN( "a default single precision point" ) {
+		Float2 b;
+		THEN( "it is the origin" ) {
+			CHECK( b.X() == 0.f );
+			CHECK( b.Y() == 0.f );
+		}
+	}
+}
 // #endregion unit tests
 
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark Point arithmetic", "[!benchmark][point]" ) {
+	Point a(3., 4.);
+	Point b(-1.5, 2.5);
+	double scale = 1.25;
+	BENCHMARK( "Point::operator+" ) {
+		return a + b;
+	};
+	BENCHMARK( "Point::operator*(double)" ) {
+		return a * scale;
+	};
+	BENCHMARK( "Point::Dot" ) {
+		return a.Dot(b);
+	};
+	BENCHMARK( "Point::Length" ) {
+		return a.Length();
+	};
+	BENCHMARK( "Point::Unit" ) {
+		return a.Unit();
+	};
+}
+#endif
+// #endregion benchmarks
+
 
 
 } // test namespace
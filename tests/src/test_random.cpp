@@ -16,6 +16,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "../../source/Random.h"
 
 // ... and any system includes needed for the test file.
+#include <cstdint>
+#include <thread>
+#include <vector>
 
 namespace { // test namespace
 
@@ -28,6 +31,96 @@ namespace { // test namespace
 TEST_CASE( "Random::Int", "[random]") {
 	REQUIRE( Random::Int(1) == 0 );
 }
+
+SCENARIO( "Drawing the time until a random event", "[random][geometric]" ) {
+	GIVEN( "an event that happens with a probability of one in ten" ) {
+		Random::Seed(12345);
+		THEN( "a certain event never has to wait" ) {
+			CHECK( Random::Geometric(1.) == 0 );
+		}
+		THEN( "the average wait matches rolling for it once per step" ) {
+			const int COUNT = 100000;
+			double total = 0.;
+			for(int i = 0; i < COUNT; ++i)
+				total += Random::Geometric(.1);
+			// With failures before each success, the mean is (1 - p) / p.
+			CHECK( total / COUNT == Approx(9.).epsilon(.02) );
+		}
+	}
+}
+
+SCENARIO( "Seeding the generator", "[random][seed]" ) {
+	GIVEN( "the same seed given twice" ) {
+		Random::Seed(12345);
+		auto first = std::vector<uint32_t>{Random::Int(), Random::Int(), Random::Int()};
+		Random::Seed(12345);
+		auto second = std::vector<uint32_t>{Random::Int(), Random::Int(), Random::Int()};
+		THEN( "the seeding thread draws the same numbers both times" ) {
+			CHECK( first == second );
+		}
+		WHEN( "another thread draws numbers after the seed" ) {
+			auto other = std::vector<uint32_t>(3);
+			std::thread([&other]() { for(uint32_t &value : other) value = Random::Int(); }).join();
+			THEN( "it draws different numbers than the seeding thread" ) {
+				CHECK( other != first );
+			}
+		}
+	}
+}
+
+SCENARIO( "Drawing numbers from a random stream", "[random][stream]" ) {
+	GIVEN( "two streams with the same key" ) {
+		Random::Seed(12345);
+		Random::Stream first(7);
+		Random::Stream second(7);
+		THEN( "they produce the same numbers" ) {
+			for(int i = 0; i < 100; ++i)
+				CHECK( first.Int() == second.Int() );
+		}
+		WHEN( "one of them skips back to an earlier position" ) {
+			first.Int();
+			uint32_t value = first.Int();
+			first.SetCounter(1);
+			THEN( "it repeats the numbers from that position" ) {
+				CHECK( first.Int() == value );
+			}
+		}
+	}
+	GIVEN( "two streams with different keys" ) {
+		Random::Stream first(1);
+		Random::Stream second(2);
+		THEN( "they produce different numbers" ) {
+			int same = 0;
+			for(int i = 0; i < 100; ++i)
+				same += (first.Int() == second.Int());
+			CHECK( same < 5 );
+		}
+	}
+	GIVEN( "a stream created after a different seed" ) {
+		Random::Seed(1);
+		Random::Stream first(7);
+		Random::Seed(2);
+		Random::Stream second(7);
+		THEN( "it produces different numbers" ) {
+			CHECK( first.Int() != second.Int() );
+		}
+	}
+	GIVEN( "any stream" ) {
+		Random::Stream stream(99);
+		THEN( "real numbers are in [0, 1)" ) {
+			for(int i = 0; i < 1000; ++i)
+			{
+				double value = stream.Real();
+				CHECK( value >= 0. );
+				CHECK( value < 1. );
+			}
+		}
+		THEN( "integers are less than the modulus" ) {
+			for(int i = 0; i < 1000; ++i)
+				CHECK( stream.Int(60) < 60 );
+		}
+	}
+}
 // Test code goes here. Preferably, use scenario-driven language making use of the SCENARIO, GIVEN,
 // WHEN, and THEN macros. (There will be cases where the more traditional TEST_CASE and SECTION macros
 // are better suited to declaration of the public API.)
@@ -54,6 +147,12 @@ TEST_CASE( "Benchmark Random::Int", "[!benchmark][random]" ) {
 		return Random::Int(10000);
 	};
 }
+TEST_CASE( "Benchmark Random::Stream::Int", "[!benchmark][random][stream]" ) {
+	Random::Stream stream(1);
+	BENCHMARK( "Random::Stream::Int()" ) {
+		return stream.Int();
+	};
+}
 TEST_CASE( "Benchmark Random::Real", "[!benchmark][random]" ) {
 	BENCHMARK( "Random::Real" ) {
 		return Random::Real();
@@ -0,0 +1,143 @@
+/* test_replay.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/Replay.h"
+
+// ... and any system includes needed for the test file.
+#include "../../source/Command.h"
+#include "../../source/DataFile.h"
+#include "../../source/Files.h"
+#include "../../source/PlayerInfo.h"
+#include "../../source/Random.h"
+#include "../../source/Ship.h"
+#include "../../source/StartConditions.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace { // test namespace
+
+// #region code
+const std::string PATH = "replay-test.dat";
+
+// Make a new pilot, landed on a planet.
+void MakePilot(PlayerInfo &player)
+{
+	std::stringstream in;
+	in.str("start\n\tsystem Sol\n\tplanet Earth\n");
+	const auto file = DataFile{in};
+	player.New(StartConditions(*file.begin()));
+	player.SetName("Test", "Pilot");
+}
+
+// What the engine would see in one step: the inputs, and a random number
+// drawn after them, standing in for everything the step calculates.
+struct Result {
+	std::string command;
+	bool isClick = false;
+	double x = 0.;
+	uint32_t random = 0;
+};
+
+// Give the given inputs to the replay for this step, and get what the engine
+// would see afterwards.
+Result Step(Replay::Input input)
+{
+	Replay::Step(input);
+
+	Result result;
+	input.command.Write(result.command);
+	result.isClick = input.isClick;
+	result.x = input.clickPoint.X();
+	result.random = Random::Int();
+	return result;
+}
+// #endregion code
+
+
+
+// #region unit tests
+SCENARIO( "Playing back a recording of the player's inputs", "[Replay]" ) {
+	GIVEN( "a recording that began at takeoff" ) {
+		PlayerInfo player;
+		MakePilot(player);
+
+		Replay::Record(PATH);
+		// Nothing is recorded until the player takes off.
+		Replay::Input ignored;
+		ignored.command = Command::LAND;
+		Replay::Step(ignored);
+		Replay::TakeOff(player);
+
+		auto recorded = std::vector<Result>{};
+		for(int i = 0; i < 20; ++i)
+		{
+			Replay::Input input;
+			if(i % 3 == 0)
+				input.command = Command::FORWARD | Command::LEFT;
+			if(i == 7)
+			{
+				input.isClick = true;
+				input.clickPoint = Point(100., -50.);
+			}
+			recorded.push_back(Step(input));
+		}
+		Replay::Finish();
+
+		WHEN( "it is played back with different inputs" ) {
+			PlayerInfo loaded;
+			REQUIRE( Replay::Play(PATH, loaded) );
+			// Draw some numbers that the recording did not, as loading the game
+			// data and setting up the engine would.
+			Random::Seed(12345);
+			Random::Int();
+			Replay::TakeOff(loaded);
+
+			auto played = std::vector<Result>{};
+			while(!Replay::IsDone() && played.size() < 2 * recorded.size())
+			{
+				Replay::Input input;
+				input.command = Command::BACK;
+				played.push_back(Step(input));
+			}
+			Files::Delete(PATH);
+
+			THEN( "the saved game is the one from takeoff" ) {
+				CHECK( loaded.FirstName() == "Test" );
+			}
+			THEN( "every step sees the recorded inputs and random numbers" ) {
+				REQUIRE( played.size() >= recorded.size() );
+				for(size_t i = 0; i < recorded.size(); ++i)
+				{
+					CHECK( played[i].command == recorded[i].command );
+					CHECK( played[i].isClick == recorded[i].isClick );
+					CHECK( played[i].x == recorded[i].x );
+					CHECK( played[i].random == recorded[i].random );
+				}
+			}
+			THEN( "the playback ends where the recording did" ) {
+				CHECK( Replay::IsDone() );
+				CHECK( played.size() == recorded.size() + 1 );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
@@ -0,0 +1,114 @@
+/* test_saveJournal.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/SaveJournal.h"
+
+// ... and any system includes needed for the test file.
+#include <string>
+
+namespace { // test namespace
+
+// #region code
+// Make something that looks like a saved game, with a big "conditions" node.
+std::string MakeSave(int changed = -1)
+{
+	std::string text = "pilot Test Pilot\ndate 1 2 3000\n";
+	for(int i = 0; i < 20; ++i)
+		text += "ship Shuttle\n\tname \"Ship " + std::to_string(i) + "\"\n\tcrew 1\n";
+	text += "conditions\n";
+	for(int i = 0; i < 2000; ++i)
+		text += "\t\"condition " + std::to_string(i) + "\" " + std::to_string(i == changed ? -i : i) + "\n";
+	text += "visited Sol\nvisited \"Alpha Centauri\"\n";
+	return text;
+}
+// #endregion code
+
+
+
+// #region unit tests
+SCENARIO( "A SaveJournal records only what changed since the full save", "[SaveJournal]" ) {
+	GIVEN( "a journal with a full save" ) {
+		auto base = MakeSave();
+		auto journal = SaveJournal{};
+		journal.SetBase("save.txt", base);
+
+		WHEN( "one line in the middle changes" ) {
+			auto text = MakeSave(1000);
+			auto record = journal.Changes(text);
+			THEN( "the record is much smaller than the save" ) {
+				CHECK( record.size() * 20 < text.size() );
+			}
+			THEN( "applying it gives back the new text" ) {
+				auto result = std::string{};
+				REQUIRE( SaveJournal::Apply(base, record, result) );
+				CHECK( result == text );
+			}
+		}
+
+		WHEN( "lines are added and removed" ) {
+			auto text = "pilot Other Pilot\n" + base.substr(base.find('\n') + 1) + "visited Rigel\n";
+			text.erase(text.find("ship Shuttle"), text.find("ship Shuttle", 100) - text.find("ship Shuttle"));
+			auto result = std::string{};
+			REQUIRE( SaveJournal::Apply(base, journal.Changes(text), result) );
+			THEN( "applying the record gives back the new text" ) {
+				CHECK( result == text );
+			}
+		}
+
+		WHEN( "several records are appended" ) {
+			auto first = MakeSave(5);
+			auto second = MakeSave(1500);
+			auto records = journal.Changes(first) + journal.Changes(second);
+			THEN( "the last one is the one that applies" ) {
+				auto result = std::string{};
+				REQUIRE( SaveJournal::Apply(base, records, result) );
+				CHECK( result == second );
+			}
+			THEN( "a last record that was cut short is ignored" ) {
+				records += journal.Changes(MakeSave(7)).substr(0, 20);
+				auto result = std::string{};
+				REQUIRE( SaveJournal::Apply(base, records, result) );
+				CHECK( result == second );
+			}
+		}
+
+		WHEN( "the full save has changed since the record was made" ) {
+			auto record = journal.Changes(MakeSave(3));
+			auto result = std::string{};
+			THEN( "the record does not apply to it" ) {
+				CHECK_FALSE( SaveJournal::Apply(MakeSave(4), record, result) );
+			}
+		}
+	}
+
+	GIVEN( "a journal with no full save recorded" ) {
+		auto journal = SaveJournal{};
+		THEN( "the next save must be a full one" ) {
+			CHECK( journal.NeedsFullSave("save.txt") );
+		}
+		WHEN( "a full save is recorded" ) {
+			journal.SetBase("save.txt", MakeSave());
+			THEN( "only saves to the same file can be journaled" ) {
+				CHECK_FALSE( journal.NeedsFullSave("save.txt") );
+				CHECK( journal.NeedsFullSave("save~autosave.txt") );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 // ... and any system includes needed for the test file.
 #include <string>
+#include <vector>
 
 namespace { // test namespace
 // #region mock data
@@ -136,12 +137,134 @@ SCENARIO( "A Set can be reverted to an earlier state", "[Set]" ) {
 					CHECK( instance.Find("A")->a == original.Find("A")->a );
 					CHECK( instance.Find("A") != original.Find("A") );
 				}
+				THEN( "removed keys can be added again" ) {
+					CHECK( instance.Find("D") == nullptr );
+					CHECK( instance.Get("D")->a == 1 );
+					CHECK( instance.size() == original.size() + 1 );
+				}
+			}
+		}
+	}
+}
+
+SCENARIO( "A Set can undo the changes made since it started tracking them", "[Set]" ) {
+	GIVEN( "a Set<T> that is tracking changes" ) {
+		auto instance = Set<T>{};
+		instance.Get("A")->a = 0;
+		instance.Get("B")->a = 0;
+		const T *a = instance.Find("A");
+		instance.TrackChanges();
+		
+		WHEN( "an object is changed and Revert is called" ) {
+			instance.Get("A")->a = 2;
+			instance.Revert();
+			THEN( "the object has its original value" ) {
+				CHECK( instance.Find("A")->a == 0 );
+			}
+			THEN( "the object has not moved" ) {
+				CHECK( instance.Find("A") == a );
+			}
+		}
+		
+		WHEN( "an object is changed several times and Revert is called" ) {
+			instance.Get("A")->a = 2;
+			instance.Get("A")->a = 3;
+			instance.Revert();
+			THEN( "the object has the value it had before the first change" ) {
+				CHECK( instance.Find("A")->a == 0 );
+			}
+		}
+		
+		WHEN( "objects are added and Revert is called" ) {
+			instance.Get("C")->a = 3;
+			static_cast<const Set<T> &>(instance).Get("D");
+			REQUIRE( instance.size() == 4 );
+			instance.Revert();
+			THEN( "the added objects are removed" ) {
+				CHECK( instance.size() == 2 );
+				CHECK_FALSE( instance.Has("C") );
+				CHECK_FALSE( instance.Has("D") );
+			}
+		}
+		
+		WHEN( "every object is modified by iterating over the Set" ) {
+			for(auto &it : instance)
+				it.second.a = 5;
+			instance.Revert();
+			THEN( "every object has its original value" ) {
+				CHECK( instance.Find("A")->a == 0 );
+				CHECK( instance.Find("B")->a == 0 );
+			}
+		}
+		
+		WHEN( "Revert is called twice" ) {
+			instance.Get("A")->a = 2;
+			instance.Revert();
+			instance.Get("B")->a = 4;
+			instance.Revert();
+			THEN( "changes are still tracked after the first revert" ) {
+				CHECK( instance.Find("A")->a == 0 );
+				CHECK( instance.Find("B")->a == 0 );
+			}
+		}
+		
+		WHEN( "a changed object is redefined and Revert is called" ) {
+			instance.Get("A")->a = 2;
+			instance.Redefine("A", [](T &t) { t.a += 10; });
+			REQUIRE( instance.Find("A")->a == 12 );
+			instance.Revert();
+			THEN( "the object reverts to its new definition" ) {
+				CHECK( instance.Find("A")->a == 10 );
+			}
+		}
+		
+		WHEN( "an object is added by redefining it and Revert is called" ) {
+			instance.Redefine("C", [](T &t) { t.a = 3; });
+			instance.Get("C")->a = 4;
+			instance.Revert();
+			THEN( "the object is kept with its definition" ) {
+				REQUIRE( instance.Has("C") );
+				CHECK( instance.Find("C")->a == 3 );
+			}
+		}
+		
+		WHEN( "every object has been modified and one is added by redefining it" ) {
+			for(auto &it : instance)
+				it.second.a = 5;
+			instance.Redefine("C", [](T &t) { t.a = 3; });
+			instance.Get("C")->a = 4;
+			instance.Revert();
+			THEN( "the object is kept with its definition" ) {
+				REQUIRE( instance.Has("C") );
+				CHECK( instance.Find("C")->a == 3 );
+				CHECK( instance.Find("A")->a == 0 );
 			}
 		}
 	}
 }
 // #endregion unit tests
 
+// #region benchmarks
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE( "Benchmark Set::Get", "[!benchmark][set]" ) {
+	// A set about the size of the list of outfits.
+	auto s = Set<T>{};
+	std::vector<std::string> keys;
+	for(int i = 0; i < 1000; ++i)
+		keys.push_back("outfit " + std::to_string(i));
+	for(const std::string &key : keys)
+		s.Get(key);
+	const std::string &key = keys[613];
+	BENCHMARK( "Set::Get" ) {
+		return s.Get(key);
+	};
+	BENCHMARK( "Set::Find" ) {
+		return s.Find(key);
+	};
+}
+#endif
+// #endregion benchmarks
+
 
 
 } // test namespace
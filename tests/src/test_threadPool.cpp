@@ -0,0 +1,105 @@
+/* test_threadPool.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../source/ThreadPool.h"
+
+// ... and any system includes needed for the test file.
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace { // test namespace
+
+// #region unit tests
+SCENARIO( "A ThreadPool runs every job in a batch", "[ThreadPool]" ) {
+	GIVEN( "a pool with some worker threads" ) {
+		ThreadPool pool(3);
+		REQUIRE( pool.Concurrency() == 4 );
+		
+		WHEN( "a batch is run" ) {
+			std::vector<int> calls(1000, 0);
+			pool.ForEach(calls.size(), [&calls](size_t i) { ++calls[i]; });
+			THEN( "each job is run exactly once" ) {
+				CHECK( std::count(calls.begin(), calls.end(), 1) == 1000 );
+			}
+		}
+		WHEN( "two threads run batches at the same time" ) {
+			std::vector<int> first(500, 0);
+			std::vector<int> second(500, 0);
+			std::thread other([&pool, &second]()
+			{
+				pool.ForEach(second.size(), [&second](size_t i) { ++second[i]; });
+			});
+			pool.ForEach(first.size(), [&first](size_t i) { ++first[i]; });
+			other.join();
+			THEN( "both batches are completed" ) {
+				CHECK( std::count(first.begin(), first.end(), 1) == 500 );
+				CHECK( std::count(second.begin(), second.end(), 1) == 500 );
+			}
+		}
+		WHEN( "a job runs a batch of its own" ) {
+			std::atomic<int> total(0);
+			pool.ForEach(8, [&pool, &total](size_t)
+			{
+				pool.ForEach(8, [&total](size_t) { ++total; });
+			});
+			THEN( "all the inner jobs are run" ) {
+				CHECK( total == 64 );
+			}
+		}
+	}
+	GIVEN( "a pool with no worker threads" ) {
+		ThreadPool pool(0);
+		WHEN( "a batch is run" ) {
+			std::vector<size_t> order;
+			pool.ForEach(4, [&order](size_t i) { order.push_back(i); });
+			THEN( "the calling thread runs the jobs in order" ) {
+				CHECK( order == std::vector<size_t>{0, 1, 2, 3} );
+			}
+		}
+	}
+}
+
+SCENARIO( "A ThreadPool runs tasks in the background", "[ThreadPool]" ) {
+	GIVEN( "a pool with a worker thread" ) {
+		ThreadPool pool(1);
+		std::mutex mutex;
+		std::condition_variable condition;
+		int done = 0;
+		WHEN( "some tasks are started" ) {
+			for(int i = 0; i < 10; ++i)
+				pool.Run([&mutex, &condition, &done]()
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					++done;
+					condition.notify_one();
+				});
+			THEN( "they are all run" ) {
+				std::unique_lock<std::mutex> lock(mutex);
+				while(done < 10)
+					condition.wait(lock);
+				CHECK( done == 10 );
+			}
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace
@@ -0,0 +1,76 @@
+/* test_texttemplate.cpp
+Copyright (c) 2021 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "es-test.hpp"
+
+// Include only the tested class's header.
+#include "../../../source/text/TextTemplate.h"
+
+// ... and any system includes needed for the test file.
+#include "../../../source/text/Format.h"
+
+#include <map>
+#include <string>
+
+namespace { // test namespace
+// #region mock data
+const std::map<std::string, std::string> keys = {
+	{"<first>", "Jane"},
+	{"<last>", "Doe"},
+	{"<planet>", "Earth"},
+	{"<a <b>", "nested"},
+	{"<>", "empty"},
+};
+// #endregion mock data
+
+
+// #region unit tests
+SCENARIO( "A TextTemplate fills in keys", "[TextTemplate]" ) {
+	GIVEN( "text without any keys" ) {
+		const auto text = TextTemplate("Nothing to see here.");
+		THEN( "the text is unchanged" ) {
+			CHECK( text.Replace(keys) == "Nothing to see here." );
+		}
+	}
+	GIVEN( "text with keys" ) {
+		const auto text = TextTemplate("Welcome to <planet>, <first> <last>!");
+		THEN( "each key is replaced with its value" ) {
+			CHECK( text.Replace(keys) == "Welcome to Earth, Jane Doe!" );
+		}
+		THEN( "the same template can be filled in with other values" ) {
+			auto other = keys;
+			other["<planet>"] = "Mars";
+			CHECK( text.Replace(other) == "Welcome to Mars, Jane Doe!" );
+		}
+	}
+	GIVEN( "text with unknown or unusual keys" ) {
+		const auto samples = {
+			"<unknown> <first>",
+			"<<first>>",
+			"<a <b> <b>",
+			"<first",
+			"first>",
+			"<> <<> >",
+			"<planet><planet><",
+			"",
+		};
+		THEN( "the result is the same as from Format::Replace" ) {
+			for(const std::string sample : samples)
+				CHECK( TextTemplate(sample).Replace(keys) == Format::Replace(sample, keys) );
+		}
+	}
+}
+// #endregion unit tests
+
+
+
+} // test namespace